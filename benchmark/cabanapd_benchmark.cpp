@@ -0,0 +1,338 @@
+/****************************************************************************
+ * Copyright (c) 2022 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of CabanaPD. CabanaPD is distributed under a           *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mpi.h"
+
+#include <Kokkos_Core.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <CabanaPD.hpp>
+
+namespace Benchmark
+{
+// Settings of a single point in the benchmark sweep.
+struct Case
+{
+    std::string backend;
+    int num_cells;
+    int m;
+    int num_ranks;
+    int repetitions;
+};
+
+// Time a kernel after one warm up call. Each repetition is synchronized
+// across ranks; the fastest repetition (slowest rank) is reported together
+// with the per-call time averaged over repetitions (min/avg/max over ranks).
+template <class KernelType>
+void timeKernel( nlohmann::json& results, const Case& c,
+                 const std::string& name, const std::size_t num_global,
+                 KernelType&& kernel )
+{
+    kernel();
+    Kokkos::fence();
+
+    CabanaPD::Timer timer;
+    double best = std::numeric_limits<double>::max();
+    for ( int r = 0; r < c.repetitions; r++ )
+    {
+        MPI_Barrier( MPI_COMM_WORLD );
+        timer.start();
+        kernel();
+        Kokkos::fence();
+        timer.stop();
+        best = std::min( best, timer.lastTime() );
+    }
+    MPI_Allreduce( MPI_IN_PLACE, &best, 1, MPI_DOUBLE, MPI_MAX,
+                   MPI_COMM_WORLD );
+    timer.reduceMPI();
+
+    int rank;
+    MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+    if ( rank != 0 )
+        return;
+
+    const double reps = c.repetitions;
+    nlohmann::json entry;
+    entry["kernel"] = name;
+    entry["backend"] = c.backend;
+    entry["ranks"] = c.num_ranks;
+    entry["num_cells"] = c.num_cells;
+    entry["m"] = c.m;
+    entry["particles"] = num_global;
+    entry["repetitions"] = c.repetitions;
+    entry["best"] = best;
+    entry["min"] = timer.minTime() / reps;
+    entry["avg"] = timer.avgTime() / reps;
+    entry["max"] = timer.maxTime() / reps;
+    entry["particles_per_second"] = best > 0.0 ? num_global / best : 0.0;
+    results.push_back( entry );
+    std::cout << name << " " << c.backend << " np=" << c.num_ranks
+              << " cells=" << c.num_cells << " m=" << c.m << " " << best
+              << " s" << std::endl;
+}
+
+// Cubic domain with m cells per horizon.
+template <class ParticleType, class ExecSpace>
+auto createParticles( const ExecSpace& exec_space, const Case& c )
+{
+    std::array<double, 3> low_corner = { -0.5, -0.5, -0.5 };
+    std::array<double, 3> high_corner = { 0.5, 0.5, 0.5 };
+    std::array<int, 3> num_cells = { c.num_cells, c.num_cells, c.num_cells };
+    auto particles = std::make_shared<ParticleType>(
+        exec_space, low_corner, high_corner, num_cells, c.m + 1 );
+
+    // Small uniform strain such that bonds are stretched but not broken.
+    auto x = particles->sliceReferencePosition();
+    auto u = particles->sliceDisplacement();
+    auto init_functor = KOKKOS_LAMBDA( const int pid )
+    {
+        for ( int d = 0; d < 3; d++ )
+            u( pid, d ) = 1e-6 * x( pid, d );
+    };
+    particles->updateParticles( exec_space, init_functor );
+    return particles;
+}
+
+// Horizon just larger than m cells for the unit cube.
+double horizon( const Case& c ) { return ( c.m + 0.1 ) / c.num_cells; }
+
+// Force (including LPS weighted volume with fracture and dilatation), ghost
+// displacement gather, and prenotch creation for a particle and model type.
+template <class ExecSpace, class ParticleType, class ModelType>
+void benchmarkForce( nlohmann::json& results, const Case& c,
+                     const std::string& name, ModelType model )
+{
+    using memory_space = typename ParticleType::memory_space;
+    auto particles = createParticles<ParticleType>( ExecSpace{}, c );
+
+    using comm_type =
+        CabanaPD::Comm<ParticleType, typename ModelType::base_model,
+                       typename ParticleType::thermal_type>;
+    comm_type comm( *particles, model.delta * ( 1.0 + 1e-8 ) );
+    if constexpr ( CabanaPD::is_temperature_dependent<
+                       typename ModelType::thermal_type>::value )
+        model.update( particles->sliceTemperature() );
+
+    CabanaPD::Force<memory_space, ModelType> force( false, *particles, model );
+    force.computeWeightedVolume( *particles, Cabana::SerialOpTag{} );
+    comm.gatherWeightedVolume();
+
+    constexpr bool is_fracture =
+        CabanaPD::is_fracture<typename ModelType::fracture_type>::value;
+    const auto num_global = particles->numGlobal();
+    timeKernel( results, c, name + "::Force", num_global,
+                [&]()
+                {
+                    if constexpr ( is_fracture )
+                    {
+                        force.computeWeightedVolume( *particles,
+                                                     Cabana::SerialOpTag{} );
+                        comm.gatherWeightedVolume();
+                    }
+                    force.computeDilatation( *particles,
+                                             Cabana::SerialOpTag{} );
+                    comm.gatherDilatation();
+                    CabanaPD::computeForce( force, *particles,
+                                            Cabana::SerialOpTag{} );
+                } );
+    timeKernel( results, c, name + "::Comm::gatherDisplacement", num_global,
+                [&]() { comm.gatherDisplacement(); } );
+
+    if constexpr ( is_fracture )
+    {
+        // Notch through the center of the domain, across half the width.
+        Kokkos::Array<double, 3> v1 = { 0.0, 0.5, 0.0 };
+        Kokkos::Array<double, 3> v2 = { 0.0, 0.0, 1.0 };
+        Kokkos::Array<Kokkos::Array<double, 3>, 1> p0 = { { 0.0, -0.5,
+                                                             -0.5 } };
+        CabanaPD::Prenotch<1> prenotch( v1, v2, p0 );
+        timeKernel( results, c, name + "::Prenotch::create", num_global,
+                    [&]()
+                    { force.prenotch( ExecSpace{}, *particles, prenotch ); } );
+    }
+}
+
+// Velocity Verlet and Yoshida stages.
+template <class ExecSpace, class ParticleType>
+void benchmarkIntegrator( nlohmann::json& results, const Case& c )
+{
+    auto particles = createParticles<ParticleType>( ExecSpace{}, c );
+    const auto num_global = particles->numGlobal();
+
+    CabanaPD::Integrator<ExecSpace> integrator( 1e-8 );
+    timeKernel( results, c, "Integrator::initialHalfStep", num_global,
+                [&]() { integrator.initialHalfStep( *particles ); } );
+    timeKernel( results, c, "Integrator::finalHalfStep", num_global,
+                [&]() { integrator.finalHalfStep( *particles ); } );
+
+    CabanaPD::Yoshida<ExecSpace> yoshida( 1e-8 );
+    timeKernel( results, c, "Yoshida::stageDisplacement", num_global,
+                [&]() { yoshida.stageDisplacement( *particles, 0 ); } );
+    timeKernel( results, c, "Yoshida::stageVelocity", num_global,
+                [&]() { yoshida.stageVelocity( *particles, 0 ); } );
+}
+
+template <class ExecSpace, class MemorySpace>
+void benchmarkBackend( nlohmann::json& results, const std::string& backend,
+                       const std::vector<int>& cells,
+                       const std::vector<int>& horizons, const int repetitions )
+{
+    int num_ranks;
+    MPI_Comm_size( MPI_COMM_WORLD, &num_ranks );
+
+    using pmb_particles =
+        CabanaPD::Particles<MemorySpace, CabanaPD::PMB,
+                            CabanaPD::TemperatureIndependent>;
+    using pmb_mixed_particles =
+        CabanaPD::Particles<MemorySpace, CabanaPD::PMB,
+                            CabanaPD::TemperatureIndependent,
+                            CabanaPD::BaseOutput, 3,
+                            CabanaPD::DefaultVectorLength<MemorySpace>::value,
+                            CabanaPD::MixedPrecision>;
+    using lps_particles =
+        CabanaPD::Particles<MemorySpace, CabanaPD::LPS,
+                            CabanaPD::TemperatureIndependent>;
+    using thermal_particles =
+        CabanaPD::Particles<MemorySpace, CabanaPD::PMB,
+                            CabanaPD::TemperatureDependent>;
+    using temp_type = decltype( std::declval<thermal_particles>()
+                                    .sliceTemperature() );
+
+    const double K = 1.0;
+    const double G = 0.5;
+    const double G0 = 1.0;
+    const double alpha = 1e-5;
+    for ( auto num_cells : cells )
+        for ( auto m : horizons )
+        {
+            Case c{ backend, num_cells, m, num_ranks, repetitions };
+            const double delta = horizon( c );
+
+            benchmarkForce<ExecSpace, pmb_particles>(
+                results, c, "PMB::Elastic",
+                CabanaPD::ForceModel<CabanaPD::PMB, CabanaPD::Elastic,
+                                     CabanaPD::NoFracture>( delta, K ) );
+            benchmarkForce<ExecSpace, pmb_particles>(
+                results, c, "PMB::Fracture",
+                CabanaPD::ForceModel<CabanaPD::PMB>( delta, K, G0 ) );
+            benchmarkForce<ExecSpace, pmb_mixed_particles>(
+                results, c, "PMB::Elastic::MixedPrecision",
+                CabanaPD::ForceModel<CabanaPD::PMB, CabanaPD::Elastic,
+                                     CabanaPD::NoFracture>( delta, K ) );
+            benchmarkForce<ExecSpace, lps_particles>(
+                results, c, "LPS::Elastic",
+                CabanaPD::ForceModel<CabanaPD::LPS, CabanaPD::Elastic,
+                                     CabanaPD::NoFracture>( delta, K, G ) );
+            benchmarkForce<ExecSpace, lps_particles>(
+                results, c, "LPS::Fracture",
+                CabanaPD::ForceModel<CabanaPD::LPS>( delta, K, G, G0, 1 ) );
+
+            // The temperature slice is replaced once ghosts exist.
+            temp_type temp;
+            benchmarkForce<ExecSpace, thermal_particles>(
+                results, c, "PMB::Elastic::Thermal",
+                CabanaPD::ForceModel<CabanaPD::PMB, CabanaPD::Elastic,
+                                     CabanaPD::NoFracture,
+                                     CabanaPD::TemperatureDependent,
+                                     temp_type>( delta, K, temp, alpha ) );
+            benchmarkForce<ExecSpace, thermal_particles>(
+                results, c, "PMB::Fracture::Thermal",
+                CabanaPD::ForceModel<CabanaPD::PMB, CabanaPD::Elastic,
+                                     CabanaPD::Fracture,
+                                     CabanaPD::TemperatureDependent,
+                                     temp_type>( delta, K, G0, temp, alpha ) );
+
+            benchmarkIntegrator<ExecSpace, pmb_particles>( results, c );
+        }
+}
+
+// Comma separated list of integers.
+std::vector<int> parseList( const std::string& arg )
+{
+    std::vector<int> values;
+    std::stringstream stream( arg );
+    std::string value;
+    while ( std::getline( stream, value, ',' ) )
+        values.push_back( std::stoi( value ) );
+    return values;
+}
+
+} // namespace Benchmark
+
+// Usage: CabanaPDBenchmark [--cells 16,32] [--horizons 3] [--repetitions 10]
+//                          [--output cabanaPD_benchmark.json]
+// Run with mpirun to sweep over rank counts; every enabled Kokkos backend is
+// benchmarked.
+int main( int argc, char* argv[] )
+{
+    MPI_Init( &argc, &argv );
+    Kokkos::initialize( argc, argv );
+    {
+        std::vector<int> cells = { 16, 32 };
+        std::vector<int> horizons = { 3 };
+        int repetitions = 10;
+        std::string output = "cabanaPD_benchmark.json";
+        for ( int i = 1; i + 1 < argc; i += 2 )
+        {
+            const std::string arg = argv[i];
+            if ( arg == "--cells" )
+                cells = Benchmark::parseList( argv[i + 1] );
+            else if ( arg == "--horizons" )
+                horizons = Benchmark::parseList( argv[i + 1] );
+            else if ( arg == "--repetitions" )
+                repetitions = std::stoi( argv[i + 1] );
+            else if ( arg == "--output" )
+                output = argv[i + 1];
+            else
+                throw std::runtime_error( "Unknown benchmark argument: " +
+                                          arg );
+        }
+
+        nlohmann::json results = nlohmann::json::array();
+#ifdef KOKKOS_ENABLE_SERIAL
+        Benchmark::benchmarkBackend<Kokkos::Serial, Kokkos::HostSpace>(
+            results, "serial", cells, horizons, repetitions );
+#endif
+#ifdef KOKKOS_ENABLE_OPENMP
+        Benchmark::benchmarkBackend<Kokkos::OpenMP, Kokkos::HostSpace>(
+            results, "openmp", cells, horizons, repetitions );
+#endif
+#ifdef KOKKOS_ENABLE_CUDA
+        Benchmark::benchmarkBackend<Kokkos::Cuda, Kokkos::CudaSpace>(
+            results, "cuda", cells, horizons, repetitions );
+#endif
+#ifdef KOKKOS_ENABLE_HIP
+        Benchmark::benchmarkBackend<Kokkos::HIP, Kokkos::HIPSpace>(
+            results, "hip", cells, horizons, repetitions );
+#endif
+
+        int rank;
+        MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+        if ( rank == 0 )
+        {
+            std::ofstream out( output );
+            out << results.dump( 2 ) << std::endl;
+        }
+    }
+    Kokkos::finalize();
+    MPI_Finalize();
+}
@@ -11,6 +11,7 @@
 
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 #include "mpi.h"
 
@@ -53,16 +54,16 @@ void randomCracksExample( const std::string filename )
     //                    Pre-notches
     // ====================================================
     // Number of pre-notches
-    constexpr int Npn = 200;
+    int Npn = inputs["num_prenotches"];
 
     double minl = inputs["minimum_prenotch_length"];
     double maxl = inputs["maximum_prenotch_length"];
     double thickness = high_corner[2] - low_corner[2];
 
     // Initialize pre-notch arrays
-    Kokkos::Array<Kokkos::Array<double, 3>, Npn> notch_positions;
-    Kokkos::Array<Kokkos::Array<double, 3>, Npn> notch_v1;
-    Kokkos::Array<Kokkos::Array<double, 3>, Npn> notch_v2;
+    std::vector<Kokkos::Array<double, 3>> notch_positions( Npn );
+    std::vector<Kokkos::Array<double, 3>> notch_v1( Npn );
+    std::vector<Kokkos::Array<double, 3>> notch_v2( Npn );
 
     // Changing this seed will re-randomize the cracks.
     std::size_t seed = 44758454;
@@ -113,7 +114,8 @@ void randomCracksExample( const std::string filename )
         notch_v2[n] = v2;
     }
 
-    CabanaPD::Prenotch<Npn> prenotch( notch_v1, notch_v2, notch_positions );
+    CabanaPD::PrenotchList<memory_space> prenotch( notch_v1, notch_v2,
+                                                   notch_positions );
 
     // ====================================================
     //                    Force model
@@ -14,19 +14,28 @@
 
 #include <CabanaPD_BodyTerm.hpp>
 #include <CabanaPD_Boundary.hpp>
+#include <CabanaPD_Checkpoint.hpp>
 #include <CabanaPD_Comm.hpp>
 #include <CabanaPD_Constants.hpp>
+#include <CabanaPD_Diagnostics.hpp>
 #include <CabanaPD_DisplacementProfile.hpp>
+#include <CabanaPD_Ensemble.hpp>
 #include <CabanaPD_Fields.hpp>
 #include <CabanaPD_Force.hpp>
 #include <CabanaPD_ForceModels.hpp>
+#include <CabanaPD_Geometry.hpp>
 #include <CabanaPD_Input.hpp>
 #include <CabanaPD_Integrate.hpp>
+#include <CabanaPD_Memory.hpp>
 #include <CabanaPD_Output.hpp>
+#include <CabanaPD_ParticleOutput.hpp>
 #include <CabanaPD_Particles.hpp>
 #include <CabanaPD_Prenotch.hpp>
+#include <CabanaPD_SpatialIndex.hpp>
+#include <CabanaPD_TimeStep.hpp>
 //#include <CabanaPD_Solver.hpp>
 
+#include <CabanaPD_Solver_DynamicRelaxation.hpp>
 #include <CabanaPD_Solver_Yoshida.hpp>
 
 #include <CabanaPD_Types.hpp>
@@ -39,6 +48,8 @@
 #include <force/CabanaPD_Force_HertzianContact.hpp>
 #include <force/CabanaPD_Force_LPS.hpp>
 #include <force/CabanaPD_Force_PMB.hpp>
+#include <force/CabanaPD_Force_SIMD.hpp>
+#include <force/CabanaPD_Force_Stiffness.hpp>
 #include <force/CabanaPD_HertzianContact.hpp>
 
 #endif
@@ -16,6 +16,7 @@
 
 #include <Cabana_Core.hpp>
 
+#include <CabanaPD_Boundary.hpp>
 #include <CabanaPD_Timer.hpp>
 
 namespace CabanaPD
@@ -47,17 +48,48 @@ struct BodyTerm
         if ( _update_frozen )
             start = 0;
         Kokkos::RangePolicy<ExecSpace> policy( start, particles.localOffset() );
-        auto user = _user_functor;
+        auto op = getOp( particles, time );
         Kokkos::parallel_for(
             "CabanaPD::BodyTerm::apply", policy,
-            KOKKOS_LAMBDA( const int p ) { user( p, time ); } );
+            KOKKOS_LAMBDA( const int p ) { op( p ); } );
+        // The user functor may write any field.
+        particles.markModified();
         _timer.stop();
     }
 
+    template <class ParticleType>
+    auto getOp( ParticleType&, const double time ) const
+    {
+        return BoundaryFunctorOp<UserFunctor>{ _user_functor, time };
+    }
+
+    // Flag all particles for fused application with boundary conditions.
+    template <class ExecSpace, class ParticleType, class MaskViewType>
+    void mark( ExecSpace, ParticleType& particles, const MaskViewType& mask,
+               const BoundaryMaskType bit ) const
+    {
+        std::size_t start = particles.frozenOffset();
+        if ( _update_frozen )
+            start = 0;
+        Kokkos::RangePolicy<ExecSpace> policy( start, particles.localOffset() );
+        Kokkos::parallel_for(
+            "CabanaPD::BodyTerm::mark", policy,
+            KOKKOS_LAMBDA( const int p ) { mask( p ) |= bit; } );
+    }
+
     auto forceUpdate() { return _force_update; }
 
     auto time() { return _timer.time(); };
     auto timeInit() { return 0.0; };
+
+    void profile( TimerRegistry& timers ) const
+    {
+        timers.add( "BodyTerm", _timer );
+    }
+
+    // No particle index storage.
+    double bytes() const { return 0.0; }
+    void memory( MemoryRegistry& ) const {}
 };
 
 template <class UserFunctor>
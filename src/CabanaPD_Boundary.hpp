@@ -12,10 +12,19 @@
 #ifndef BOUNDARYCONDITION_H
 #define BOUNDARYCONDITION_H
 
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 #include <Kokkos_Core.hpp>
 
 #include <Cabana_Core.hpp>
 
+#include <CabanaPD_Fields.hpp>
+#include <CabanaPD_Memory.hpp>
 #include <CabanaPD_Timer.hpp>
 
 namespace CabanaPD
@@ -76,9 +85,13 @@ struct RegionBoundary<RectangularPrism>
     KOKKOS_INLINE_FUNCTION bool inside( const PositionType& x,
                                         const int pid ) const
     {
+        // The z bounds are ignored in 2d.
+        const bool inside_z =
+            vector_dim<PositionType>::value == 2 ||
+            ( component<2>( x, pid ) >= low_z &&
+              component<2>( x, pid ) <= high_z );
         return ( x( pid, 0 ) >= low_x && x( pid, 0 ) <= high_x &&
-                 x( pid, 1 ) >= low_y && x( pid, 1 ) <= high_y &&
-                 x( pid, 2 ) >= low_z && x( pid, 2 ) <= high_z );
+                 x( pid, 1 ) >= low_y && x( pid, 1 ) <= high_y && inside_z );
     }
 };
 
@@ -109,9 +122,13 @@ struct RegionBoundary<Cylinder>
     {
         double rsq = ( x( pid, 0 ) - x_center ) * ( x( pid, 0 ) - x_center ) +
                      ( x( pid, 1 ) - y_center ) * ( x( pid, 1 ) - y_center );
+        // The z bounds are ignored in 2d (an annulus).
+        const bool inside_z =
+            vector_dim<PositionType>::value == 2 ||
+            ( component<2>( x, pid ) >= low_z &&
+              component<2>( x, pid ) <= high_z );
         return ( rsq >= radius_in * radius_in &&
-                 rsq <= radius_out * radius_out && x( pid, 2 ) >= low_z &&
-                 x( pid, 2 ) <= high_z );
+                 rsq <= radius_out * radius_out && inside_z );
     }
 };
 
@@ -235,6 +252,61 @@ struct ForceUpdateBCTag
 {
 };
 
+// Per-particle operations of each boundary condition, used both for
+// individual and fused application.
+template <class UserFunctor>
+struct BoundaryFunctorOp
+{
+    UserFunctor user;
+    double time;
+
+    KOKKOS_INLINE_FUNCTION void operator()( const std::size_t pid ) const
+    {
+        user( pid, time );
+    }
+};
+
+template <class SliceType>
+struct ForceValueOp
+{
+    SliceType f;
+    double value;
+
+    KOKKOS_INLINE_FUNCTION void operator()( const std::size_t pid ) const
+    {
+        for ( int d = 0; d < vector_dim<SliceType>::value; d++ )
+            f( pid, d ) = value;
+    }
+};
+
+template <class SliceType>
+struct ForceUpdateOp
+{
+    SliceType f;
+    double value;
+
+    KOKKOS_INLINE_FUNCTION void operator()( const std::size_t pid ) const
+    {
+        for ( int d = 0; d < vector_dim<SliceType>::value; d++ )
+            f( pid, d ) += value;
+    }
+};
+
+// Bit flag per boundary condition for the particles it applies to.
+using BoundaryMaskType = std::uint64_t;
+
+// Flag every particle of an index space (which may contain duplicates).
+template <class ExecSpace, class IndexViewType, class MaskViewType>
+void markBoundaryIndices( ExecSpace, const IndexViewType& index_space,
+                          const MaskViewType& mask, const BoundaryMaskType bit )
+{
+    Kokkos::RangePolicy<ExecSpace> policy( 0, index_space.size() );
+    Kokkos::parallel_for(
+        "CabanaPD::BC::mark", policy, KOKKOS_LAMBDA( const int b ) {
+            Kokkos::atomic_or( &mask( index_space( b ) ), bit );
+        } );
+}
+
 // Custom boundary condition.
 template <class BCIndexSpace, class UserFunctor>
 struct BoundaryCondition
@@ -243,7 +315,7 @@ struct BoundaryCondition
     UserFunctor _user_functor;
     bool _force_update;
 
-    Timer _timer;
+    Timer _timer = Timer( "BoundaryCondition" );
 
     BoundaryCondition( BCIndexSpace bc_index_space, UserFunctor user,
                        const bool force )
@@ -260,24 +332,49 @@ struct BoundaryCondition
     }
 
     template <class ExecSpace, class ParticleType>
-    void apply( ExecSpace, ParticleType&, double time )
+    void apply( ExecSpace, ParticleType& particles, double time )
     {
         _timer.start();
-        auto user = _user_functor;
+        auto op = getOp( particles, time );
         auto index_space = _index_space._view;
         Kokkos::RangePolicy<ExecSpace> policy( 0, index_space.size() );
         Kokkos::parallel_for(
-            "CabanaPD::BC::apply", policy, KOKKOS_LAMBDA( const int b ) {
-                auto pid = index_space( b );
-                user( pid, time );
-            } );
+            "CabanaPD::BC::apply", policy,
+            KOKKOS_LAMBDA( const int b ) { op( index_space( b ) ); } );
+        // The user functor may write any field.
+        particles.markModified();
         _timer.stop();
     }
 
+    template <class ParticleType>
+    auto getOp( ParticleType&, const double time ) const
+    {
+        return BoundaryFunctorOp<UserFunctor>{ _user_functor, time };
+    }
+
+    template <class ExecSpace, class ParticleType, class MaskViewType>
+    void mark( ExecSpace exec_space, ParticleType&, const MaskViewType& mask,
+               const BoundaryMaskType bit ) const
+    {
+        markBoundaryIndices( exec_space, _index_space._view, mask, bit );
+    }
+
     auto forceUpdate() { return _force_update; }
 
     auto time() { return _timer.time(); };
     auto timeInit() { return _index_space.time(); };
+
+    void profile( TimerRegistry& timers ) const
+    {
+        timers.add( "BoundaryCondition", _timer );
+    }
+
+    double bytes() const { return viewBytes( _index_space._view ); }
+
+    void memory( MemoryRegistry& registry ) const
+    {
+        registry.add( "BoundaryCondition", bytes() );
+    }
 };
 
 template <class BCIndexSpace>
@@ -287,7 +384,7 @@ struct BoundaryCondition<BCIndexSpace, ForceValueBCTag>
     BCIndexSpace _index_space;
     const bool _force_update = true;
 
-    Timer _timer;
+    Timer _timer = Timer( "BoundaryCondition" );
 
     BoundaryCondition( const double value, BCIndexSpace bc_index_space )
         : _value( value )
@@ -302,26 +399,48 @@ struct BoundaryCondition<BCIndexSpace, ForceValueBCTag>
     }
 
     template <class ExecSpace, class ParticleType>
-    void apply( ExecSpace, ParticleType& particles, double )
+    void apply( ExecSpace, ParticleType& particles, double time )
     {
         _timer.start();
-        auto f = particles.sliceForce();
+        auto op = getOp( particles, time );
         auto index_space = _index_space._view;
         Kokkos::RangePolicy<ExecSpace> policy( 0, index_space.size() );
-        auto value = _value;
         Kokkos::parallel_for(
-            "CabanaPD::BC::apply", policy, KOKKOS_LAMBDA( const int b ) {
-                auto pid = index_space( b );
-                for ( int d = 0; d < 3; d++ )
-                    f( pid, d ) = value;
-            } );
+            "CabanaPD::BC::apply", policy,
+            KOKKOS_LAMBDA( const int b ) { op( index_space( b ) ); } );
         _timer.stop();
     }
 
+    template <class ParticleType>
+    auto getOp( ParticleType& particles, const double ) const
+    {
+        auto f = particles.sliceForce();
+        return ForceValueOp<decltype( f )>{ f, _value };
+    }
+
+    template <class ExecSpace, class ParticleType, class MaskViewType>
+    void mark( ExecSpace exec_space, ParticleType&, const MaskViewType& mask,
+               const BoundaryMaskType bit ) const
+    {
+        markBoundaryIndices( exec_space, _index_space._view, mask, bit );
+    }
+
     auto forceUpdate() { return _force_update; }
 
     auto time() { return _timer.time(); };
     auto timeInit() { return _index_space.time(); };
+
+    void profile( TimerRegistry& timers ) const
+    {
+        timers.add( "BoundaryCondition", _timer );
+    }
+
+    double bytes() const { return viewBytes( _index_space._view ); }
+
+    void memory( MemoryRegistry& registry ) const
+    {
+        registry.add( "BoundaryCondition", bytes() );
+    }
 };
 
 template <class BCIndexSpace>
@@ -331,7 +450,7 @@ struct BoundaryCondition<BCIndexSpace, ForceUpdateBCTag>
     BCIndexSpace _index_space;
     const bool _force_update = true;
 
-    Timer _timer;
+    Timer _timer = Timer( "BoundaryCondition" );
 
     BoundaryCondition( const double value, BCIndexSpace bc_index_space )
         : _value( value )
@@ -346,30 +465,333 @@ struct BoundaryCondition<BCIndexSpace, ForceUpdateBCTag>
     }
 
     template <class ExecSpace, class ParticleType>
-    void apply( ExecSpace, ParticleType& particles, double )
+    void apply( ExecSpace, ParticleType& particles, double time )
     {
         _timer.start();
-
-        auto f = particles.sliceForce();
+        auto op = getOp( particles, time );
         auto index_space = _index_space._view;
         Kokkos::RangePolicy<ExecSpace> policy( 0, index_space.size() );
-        auto value = _value;
         Kokkos::parallel_for(
-            "CabanaPD::BC::apply", policy, KOKKOS_LAMBDA( const int b ) {
-                auto pid = index_space( b );
-                for ( int d = 0; d < 3; d++ )
-                    f( pid, d ) += value;
-            } );
-
+            "CabanaPD::BC::apply", policy,
+            KOKKOS_LAMBDA( const int b ) { op( index_space( b ) ); } );
         _timer.stop();
     }
 
+    template <class ParticleType>
+    auto getOp( ParticleType& particles, const double ) const
+    {
+        auto f = particles.sliceForce();
+        return ForceUpdateOp<decltype( f )>{ f, _value };
+    }
+
+    template <class ExecSpace, class ParticleType, class MaskViewType>
+    void mark( ExecSpace exec_space, ParticleType&, const MaskViewType& mask,
+               const BoundaryMaskType bit ) const
+    {
+        markBoundaryIndices( exec_space, _index_space._view, mask, bit );
+    }
+
     auto forceUpdate() { return _force_update; }
 
     auto time() { return _timer.time(); };
     auto timeInit() { return _index_space.time(); };
+
+    void profile( TimerRegistry& timers ) const
+    {
+        timers.add( "BoundaryCondition", _timer );
+    }
+
+    double bytes() const { return viewBytes( _index_space._view ); }
+
+    void memory( MemoryRegistry& registry ) const
+    {
+        registry.add( "BoundaryCondition", bytes() );
+    }
+};
+
+// Empty boundary condition for solvers run without one.
+struct NoBoundaryCondition
+{
+    template <class ExecSpace, class ParticleType>
+    void apply( ExecSpace, ParticleType&, double )
+    {
+    }
+
+    auto forceUpdate() { return false; }
+
+    auto time() { return 0.0; };
+    auto timeInit() { return 0.0; };
+
+    void profile( TimerRegistry& ) const {}
+    void memory( MemoryRegistry& ) const {}
+};
+
+// Per-particle operations of all members of a boundary condition set,
+// applied in order for the members flagged in the mask.
+template <class... OpTypes>
+struct BoundaryOpList;
+
+template <>
+struct BoundaryOpList<>
+{
+    KOKKOS_INLINE_FUNCTION void operator()( const BoundaryMaskType,
+                                            const std::size_t ) const
+    {
+    }
+};
+
+template <class OpType, class... OpTypes>
+struct BoundaryOpList<OpType, OpTypes...>
+{
+    OpType op;
+    BoundaryOpList<OpTypes...> rest;
+
+    KOKKOS_INLINE_FUNCTION void operator()( const BoundaryMaskType mask,
+                                            const std::size_t pid ) const
+    {
+        if ( mask & 1 )
+            op( pid );
+        rest( mask >> 1, pid );
+    }
+};
+
+inline BoundaryOpList<> makeBoundaryOpList() { return {}; }
+
+template <class OpType, class... OpTypes>
+auto makeBoundaryOpList( OpType op, OpTypes... ops )
+{
+    return BoundaryOpList<OpType, OpTypes...>{ op,
+                                               makeBoundaryOpList( ops... ) };
+}
+
+// Boundary condition operations indexed by particle rather than by the
+// compacted index space, for fusing into other per-particle kernels.
+template <class MaskViewType, class OpListType>
+struct BoundaryMaskOp
+{
+    MaskViewType mask;
+    BoundaryMaskType bits;
+    OpListType ops;
+
+    KOKKOS_INLINE_FUNCTION void operator()( const std::size_t pid ) const
+    {
+        auto m = mask( pid ) & bits;
+        if ( m )
+            ops( m, pid );
+    }
+};
+
+/******************************************************************************
+  Set of boundary conditions and body terms applied together.
+
+  The particles of all members are merged into one compacted index space for
+  each solver phase (before and after the force update), with a flag for each
+  member which applies. Each phase is a single kernel applying the members in
+  order for each particle, at most once per member.
+******************************************************************************/
+// Whether applying a boundary condition may write ghosted particle fields
+// (always assumed for user functors).
+template <class BCType>
+struct writes_particle_fields : public std::true_type
+{
+};
+template <class BCIndexSpace>
+struct writes_particle_fields<BoundaryCondition<BCIndexSpace, ForceValueBCTag>>
+    : public std::false_type
+{
+};
+template <class BCIndexSpace>
+struct writes_particle_fields<
+    BoundaryCondition<BCIndexSpace, ForceUpdateBCTag>> : public std::false_type
+{
+};
+
+template <class MemorySpace, class... BCTypes>
+class BoundaryConditionSet
+{
+    static_assert( sizeof...( BCTypes ) <= 64,
+                   "Boundary condition sets are limited to 64 members." );
+
+  public:
+    using memory_space = MemorySpace;
+    using index_view_type = Kokkos::View<std::size_t*, memory_space>;
+    using mask_view_type = Kokkos::View<BoundaryMaskType*, memory_space>;
+
+    template <class ExecSpace, class ParticleType>
+    BoundaryConditionSet( ExecSpace exec_space, ParticleType& particles,
+                          BCTypes... bcs )
+        : _bcs( bcs... )
+    {
+        build( exec_space, particles );
+    }
+
+    // Merge the member index spaces; must be called again if any member is
+    // updated or the particles change.
+    template <class ExecSpace, class ParticleType>
+    void build( ExecSpace exec_space, ParticleType& particles )
+    {
+        _init_timer.start();
+        mask_view_type mask( "boundary_mask", particles.localOffset() );
+        markMembers( exec_space, particles, mask,
+                     std::index_sequence_for<BCTypes...>{} );
+        compact( exec_space, mask, ~_force_bits, 0 );
+        compact( exec_space, mask, _force_bits, 1 );
+        _particle_mask = mask;
+        _init_timer.stop();
+    }
+
+    // Apply all members of one phase: before the force update or after it.
+    template <class ExecSpace, class ParticleType>
+    void apply( ExecSpace, ParticleType& particles, const double time,
+                const bool force_update )
+    {
+        const int phase = force_update ? 1 : 0;
+        auto indices = _indices[phase];
+        auto masks = _masks[phase];
+        if ( indices.size() == 0 )
+            return;
+
+        _timer.start();
+        auto ops = std::apply(
+            [&]( auto&... bc )
+            { return makeBoundaryOpList( bc.getOp( particles, time )... ); },
+            _bcs );
+        Kokkos::RangePolicy<ExecSpace> policy( 0, indices.size() );
+        Kokkos::parallel_for(
+            "CabanaPD::BCSet::apply", policy, KOKKOS_LAMBDA( const int b ) {
+                ops( masks( b ), indices( b ) );
+            } );
+        if constexpr ( writes_fields )
+            particles.markModified();
+        _timer.stop();
+    }
+
+    // Per-particle operation of the members applied before the force update,
+    // for fusing into a kernel over all owned particles (e.g. the integrator)
+    // in place of apply(). Fields must then be marked as modified by the
+    // caller if writes_fields.
+    template <class ParticleType>
+    auto getFusedOp( ParticleType& particles, const double time ) const
+    {
+        auto ops = std::apply(
+            [&]( auto&... bc )
+            { return makeBoundaryOpList( bc.getOp( particles, time )... ); },
+            _bcs );
+        return BoundaryMaskOp<mask_view_type, decltype( ops )>{
+            _particle_mask, ~_force_bits, ops };
+    }
+
+    static constexpr bool writes_fields =
+        ( writes_particle_fields<BCTypes>::value || ... );
+
+    auto forceUpdate() { return _force_bits != 0; }
+
+    auto time() { return _timer.time(); };
+    auto timeInit()
+    {
+        return _init_timer.time() +
+               std::apply( []( auto&... bc )
+                           { return ( 0.0 + ... + bc.timeInit() ); },
+                           _bcs );
+    };
+
+    void profile( TimerRegistry& timers ) const
+    {
+        timers.add( "BoundaryCondition", _timer );
+    }
+
+    // Merged index spaces and masks, plus the member index spaces.
+    void memory( MemoryRegistry& registry ) const
+    {
+        double bytes = viewBytes( _particle_mask );
+        for ( int phase = 0; phase < 2; phase++ )
+            bytes += viewBytes( _indices[phase] ) + viewBytes( _masks[phase] );
+        bytes += std::apply( []( auto&... bc )
+                             { return ( 0.0 + ... + bc.bytes() ); },
+                             _bcs );
+        registry.add( "BoundaryCondition", bytes );
+    }
+
+  protected:
+    template <class ExecSpace, class ParticleType, std::size_t... I>
+    void markMembers( ExecSpace exec_space, ParticleType& particles,
+                      const mask_view_type& mask, std::index_sequence<I...> )
+    {
+        ( std::get<I>( _bcs ).mark( exec_space, particles, mask,
+                                    BoundaryMaskType{ 1 } << I ),
+          ... );
+        _force_bits = ( BoundaryMaskType{ 0 } | ... |
+                        ( std::get<I>( _bcs ).forceUpdate()
+                              ? BoundaryMaskType{ 1 } << I
+                              : BoundaryMaskType{ 0 } ) );
+    }
+
+    // Only the size of each compacted index space is copied to the host.
+    template <class ExecSpace>
+    void compact( ExecSpace, const mask_view_type& mask,
+                  const BoundaryMaskType bits, const int phase )
+    {
+        index_view_type indices( "boundary_indices", mask.size() );
+        mask_view_type masks( "boundary_masks", mask.size() );
+        std::size_t count = 0;
+        Kokkos::RangePolicy<ExecSpace> policy( 0, mask.size() );
+        Kokkos::parallel_scan(
+            "CabanaPD::BCSet::compact", policy,
+            KOKKOS_LAMBDA( const int pid, std::size_t& offset,
+                           const bool final ) {
+                auto m = mask( pid ) & bits;
+                if ( m )
+                {
+                    if ( final )
+                    {
+                        indices( offset ) = pid;
+                        masks( offset ) = m;
+                    }
+                    offset++;
+                }
+            },
+            count );
+        Kokkos::resize( indices, count );
+        Kokkos::resize( masks, count );
+        _indices[phase] = indices;
+        _masks[phase] = masks;
+    }
+
+    std::tuple<BCTypes...> _bcs;
+    BoundaryMaskType _force_bits = 0;
+    index_view_type _indices[2];
+    mask_view_type _masks[2];
+    // Members flagged for each owned particle.
+    mask_view_type _particle_mask;
+
+    Timer _init_timer = Timer( "BoundaryCondition::Init" );
+    Timer _timer = Timer( "BoundaryCondition" );
 };
 
+template <class BoundaryType>
+struct is_boundary_condition_set : public std::false_type
+{
+};
+
+template <class MemorySpace, class... BCTypes>
+struct is_boundary_condition_set<BoundaryConditionSet<MemorySpace, BCTypes...>>
+    : public std::true_type
+{
+};
+
+// Apply the boundary conditions of one solver phase: before the force update
+// or after it.
+template <class BoundaryType, class ExecSpace, class ParticleType>
+void applyBoundaryCondition( BoundaryType& boundary_condition,
+                             ExecSpace exec_space, ParticleType& particles,
+                             const double time, const bool force_update )
+{
+    if constexpr ( is_boundary_condition_set<BoundaryType>::value )
+        boundary_condition.apply( exec_space, particles, time, force_update );
+    else if ( boundary_condition.forceUpdate() == force_update )
+        boundary_condition.apply( exec_space, particles, time );
+}
+
 // FIXME: relatively large initial guess for allocation.
 template <class BoundaryType, class BCTag, class ExecSpace, class Particles>
 auto createBoundaryCondition( BCTag, const double value, ExecSpace exec_space,
@@ -448,6 +870,16 @@ auto createBoundaryCondition( UserFunctor user_functor, ExecSpace exec_space,
                                     plane_vec, force_update, initial_guess );
 }
 
+// Merge boundary conditions and body terms into a single set.
+template <class ExecSpace, class ParticleType, class... BCTypes>
+auto createBoundaryConditionSet( ExecSpace exec_space, ParticleType& particles,
+                                 BCTypes... bcs )
+{
+    using memory_space = typename ParticleType::memory_space;
+    return BoundaryConditionSet<memory_space, BCTypes...>( exec_space,
+                                                           particles, bcs... );
+}
+
 } // namespace CabanaPD
 
 #endif
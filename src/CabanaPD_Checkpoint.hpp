@@ -0,0 +1,392 @@
+/****************************************************************************
+ * Copyright (c) 2022 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of CabanaPD. CabanaPD is distributed under a           *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "mpi.h"
+
+#include <Kokkos_Core.hpp>
+
+#include <CabanaPD_Timer.hpp>
+#include <CabanaPD_Types.hpp>
+
+namespace CabanaPD
+{
+/******************************************************************************
+  Checkpoint and restart of the full simulation state.
+
+  Each group of consecutive ranks shares one file, written with collective
+  MPI-IO. The file starts with a header (step, time, and rank counts) and the
+  offset and size of the state of each rank in the group. Each rank's state
+  follows as fields in a fixed order, each prefixed by its size in bytes: the
+  number of local particles, displacement, velocity, force, temperature (if
+  temperature dependent), dilatation and weighted volume (LPS), and broken
+  bonds (fracture).
+
+  Restarting requires the same number of ranks, ranks per file, and particle
+  creation as the run which wrote the checkpoint.
+******************************************************************************/
+class Checkpoint
+{
+    // magic, version, step, time, number of ranks, ranks in this file.
+    static constexpr int header_size = 6;
+    static constexpr std::uint64_t magic = 0x4350444348454b50;
+    static constexpr std::uint64_t version = 1;
+
+    std::string _prefix;
+    int _ranks_per_file;
+
+    // Host staging of the local state; kept alive until the write completes.
+    std::vector<char> _buffer;
+    std::size_t _read_offset = 0;
+    std::vector<std::uint64_t> _header;
+
+    // Pending asynchronous write.
+    bool _pending = false;
+    MPI_Comm _group_comm = MPI_COMM_NULL;
+    MPI_File _file;
+    MPI_Request _requests[2];
+
+    Timer _timer = Timer( "Checkpoint" );
+
+  public:
+    // All ranks share a single file without a positive number of ranks per
+    // file.
+    Checkpoint( const std::string& prefix, const int ranks_per_file = 0 )
+        : _prefix( prefix )
+        , _ranks_per_file( ranks_per_file )
+    {
+    }
+
+    // Name of the checkpoint for a given step, without the file suffix.
+    std::string name( const int step ) const
+    {
+        return _prefix + "_" + std::to_string( step );
+    }
+
+    // Stage the state on the host and start writing it. The write completes
+    // during the following steps, at the latest at the next checkpoint or
+    // finish().
+    template <class ModelType, class ParticleType, class... BondType>
+    void write( const int step, const double time, ModelType,
+                ParticleType& particles, const BondType&... mu )
+    {
+        finish();
+
+        _timer.start();
+        _buffer.clear();
+        pack( ModelType{}, particles, mu... );
+
+        int group_rank, group_size;
+        openGroup( name( step ), group_rank, group_size,
+                   MPI_MODE_CREATE | MPI_MODE_WRONLY );
+        MPI_File_set_size( _file, 0 );
+
+        // Offsets follow the header in rank order within the file.
+        std::uint64_t bytes = _buffer.size();
+        if ( bytes > static_cast<std::uint64_t>( INT_MAX ) )
+            throw std::runtime_error( "Checkpoint state per rank exceeds the "
+                                      "maximum MPI-IO write size." );
+        std::uint64_t offset = 0;
+        MPI_Exscan( &bytes, &offset, 1, MPI_UINT64_T, MPI_SUM, _group_comm );
+        if ( group_rank == 0 )
+            offset = 0;
+        offset += sizeof( std::uint64_t ) * ( header_size + 2 * group_size );
+
+        _header.assign( header_size + 2 * group_size, 0 );
+        std::uint64_t entry[2] = { offset, bytes };
+        MPI_Gather( entry, 2, MPI_UINT64_T, _header.data() + header_size, 2,
+                    MPI_UINT64_T, 0, _group_comm );
+        int num_ranks;
+        MPI_Comm_size( MPI_COMM_WORLD, &num_ranks );
+        _header[0] = magic;
+        _header[1] = version;
+        _header[2] = step;
+        std::memcpy( &_header[3], &time, sizeof( double ) );
+        _header[4] = num_ranks;
+        _header[5] = group_size;
+
+        // Only the first rank of each file writes the header.
+        const int header_count = group_rank == 0 ? _header.size() : 0;
+        MPI_File_iwrite_at( _file, 0, _header.data(), header_count,
+                            MPI_UINT64_T, &_requests[0] );
+        MPI_File_iwrite_at_all( _file, offset, _buffer.data(),
+                                static_cast<int>( bytes ), MPI_BYTE,
+                                &_requests[1] );
+        _pending = true;
+        _timer.stop();
+    }
+
+    // Let a pending write progress without blocking.
+    void progress()
+    {
+        if ( !_pending )
+            return;
+        int done;
+        MPI_Testall( 2, _requests, &done, MPI_STATUSES_IGNORE );
+    }
+
+    // Complete a pending write (collective).
+    void finish()
+    {
+        if ( !_pending )
+            return;
+
+        _timer.start();
+        MPI_Waitall( 2, _requests, MPI_STATUSES_IGNORE );
+        MPI_File_close( &_file );
+        MPI_Comm_free( &_group_comm );
+        _pending = false;
+        _timer.stop();
+    }
+
+    // Read the state written by write() for the checkpoint with the given
+    // name (see name()).
+    template <class ModelType, class ParticleType, class... BondType>
+    void read( const std::string& checkpoint_name, int& step, double& time,
+               ModelType, ParticleType& particles, BondType&... mu )
+    {
+        finish();
+
+        _timer.start();
+        int group_rank, group_size;
+        const auto file_name = openGroup( checkpoint_name, group_rank,
+                                          group_size, MPI_MODE_RDONLY );
+
+        _header.resize( header_size );
+        MPI_File_read_at_all( _file, 0, _header.data(), header_size,
+                              MPI_UINT64_T, MPI_STATUS_IGNORE );
+        int num_ranks;
+        MPI_Comm_size( MPI_COMM_WORLD, &num_ranks );
+        if ( _header[0] != magic || _header[1] != version )
+            throw std::runtime_error( file_name +
+                                      " is not a CabanaPD checkpoint." );
+        if ( _header[4] != static_cast<std::uint64_t>( num_ranks ) ||
+             _header[5] != static_cast<std::uint64_t>( group_size ) )
+            throw std::runtime_error( "Restart requires the same number of "
+                                      "ranks (and ranks per file) as the "
+                                      "checkpoint." );
+
+        std::uint64_t entry[2];
+        MPI_File_read_at_all(
+            _file, sizeof( std::uint64_t ) * ( header_size + 2 * group_rank ),
+            entry, 2, MPI_UINT64_T, MPI_STATUS_IGNORE );
+        _buffer.resize( entry[1] );
+        MPI_File_read_at_all( _file, entry[0], _buffer.data(),
+                              static_cast<int>( entry[1] ), MPI_BYTE,
+                              MPI_STATUS_IGNORE );
+        MPI_File_close( &_file );
+        MPI_Comm_free( &_group_comm );
+
+        _read_offset = 0;
+        unpack( ModelType{}, particles, mu... );
+        step = static_cast<int>( _header[2] );
+        std::memcpy( &time, &_header[3], sizeof( double ) );
+        _timer.stop();
+    }
+
+    auto time() const { return _timer.time(); }
+
+    void profile( TimerRegistry& timers ) const
+    {
+        timers.add( "Checkpoint", _timer );
+    }
+
+  protected:
+    // Open the file for this rank's group, splitting ranks into files.
+    std::string openGroup( const std::string& checkpoint_name, int& group_rank,
+                           int& group_size, const int mode )
+    {
+        int rank, size;
+        MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+        MPI_Comm_size( MPI_COMM_WORLD, &size );
+        const int per_file = _ranks_per_file > 0 ? _ranks_per_file : size;
+        const int group = rank / per_file;
+        MPI_Comm_split( MPI_COMM_WORLD, group, rank, &_group_comm );
+        MPI_Comm_rank( _group_comm, &group_rank );
+        MPI_Comm_size( _group_comm, &group_size );
+
+        const auto file_name =
+            checkpoint_name + "_" + std::to_string( group ) + ".bin";
+        int error = MPI_File_open( _group_comm, file_name.c_str(), mode,
+                                   MPI_INFO_NULL, &_file );
+        if ( error != MPI_SUCCESS )
+            throw std::runtime_error( "Could not open checkpoint " +
+                                      file_name );
+        return file_name;
+    }
+
+    template <class ModelType, class ParticleType, class... BondType>
+    void pack( ModelType, ParticleType& particles, const BondType&... mu )
+    {
+        const std::uint64_t n = particles.localOffset();
+        append( &n, sizeof( n ) );
+        packSlice( particles.sliceDisplacement(), n );
+        packSlice( particles.sliceVelocity(), n );
+        packSlice( particles.sliceForce(), n );
+        if constexpr ( is_temperature_dependent<
+                           typename ParticleType::thermal_type>::value )
+            packSlice( particles.sliceTemperature(), n );
+        if constexpr ( std::is_same<ModelType, LPS>::value )
+        {
+            packSlice( particles.sliceDilatation(), n );
+            packSlice( particles.sliceWeightedVolume(), n );
+        }
+        ( packView( mu.view() ), ... );
+    }
+
+    template <class ModelType, class ParticleType, class... BondType>
+    void unpack( ModelType, ParticleType& particles, BondType&... mu )
+    {
+        std::uint64_t n;
+        extract( &n, sizeof( n ) );
+        if ( n != particles.localOffset() )
+            throw std::runtime_error( "Restart particle count does not match "
+                                      "the checkpoint." );
+        unpackSlice( particles.sliceDisplacement(), n );
+        unpackSlice( particles.sliceVelocity(), n );
+        unpackSlice( particles.sliceForce(), n );
+        if constexpr ( is_temperature_dependent<
+                           typename ParticleType::thermal_type>::value )
+            unpackSlice( particles.sliceTemperature(), n );
+        if constexpr ( std::is_same<ModelType, LPS>::value )
+        {
+            unpackSlice( particles.sliceDilatation(), n );
+            unpackSlice( particles.sliceWeightedVolume(), n );
+        }
+        ( unpackView( mu.view() ), ... );
+        particles.markModified();
+    }
+
+    void append( const void* data, const std::size_t bytes )
+    {
+        const auto* begin = static_cast<const char*>( data );
+        _buffer.insert( _buffer.end(), begin, begin + bytes );
+    }
+
+    void extract( void* data, const std::size_t bytes )
+    {
+        if ( _read_offset + bytes > _buffer.size() )
+            throw std::runtime_error( "Checkpoint state is truncated." );
+        std::memcpy( data, _buffer.data() + _read_offset, bytes );
+        _read_offset += bytes;
+    }
+
+    // Contiguous (particle, component) copy of the first n slice entries.
+    template <class SliceType>
+    static auto fieldView( const SliceType& slice, const std::size_t n )
+    {
+        using value_type = std::remove_const_t<typename SliceType::value_type>;
+        using memory_space = typename SliceType::memory_space;
+        const std::size_t num_comp =
+            SliceType::viewRank() == 3 ? slice.extent( 2 ) : 1;
+        return Kokkos::View<value_type**, Kokkos::LayoutRight, memory_space>(
+            Kokkos::ViewAllocateWithoutInitializing( "checkpoint_field" ), n,
+            num_comp );
+    }
+
+    template <class SliceType>
+    void packSlice( const SliceType& slice, const std::size_t n )
+    {
+        auto field = fieldView( slice, n );
+        using exec_space = typename SliceType::memory_space::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( 0, n );
+        Kokkos::parallel_for(
+            "CabanaPD::Checkpoint::pack", policy, KOKKOS_LAMBDA( const int p ) {
+                if constexpr ( SliceType::viewRank() == 3 )
+                    for ( std::size_t d = 0; d < field.extent( 1 ); d++ )
+                        field( p, d ) = slice( p, d );
+                else
+                    field( p, 0 ) = slice( p );
+            } );
+        packView( field );
+    }
+
+    template <class SliceType>
+    void unpackSlice( SliceType slice, const std::size_t n )
+    {
+        auto field = fieldView( slice, n );
+        unpackView( field );
+        using exec_space = typename SliceType::memory_space::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( 0, n );
+        Kokkos::parallel_for(
+            "CabanaPD::Checkpoint::unpack", policy,
+            KOKKOS_LAMBDA( const int p ) {
+                if constexpr ( SliceType::viewRank() == 3 )
+                    for ( std::size_t d = 0; d < field.extent( 1 ); d++ )
+                        slice( p, d ) = field( p, d );
+                else
+                    slice( p ) = field( p, 0 );
+            } );
+        Kokkos::fence();
+    }
+
+    // Rank-2 views are stored row major independent of the device layout.
+    // Rank-1 views (e.g. CSR broken bonds) are stored as is.
+    template <class ViewType>
+    static auto hostView( const ViewType& view )
+    {
+        using value_type = typename ViewType::non_const_value_type;
+        static_assert( ViewType::rank == 1 || ViewType::rank == 2,
+                       "Checkpoint views must be rank 1 or 2." );
+        if constexpr ( ViewType::rank == 1 )
+            return Kokkos::View<value_type*, Kokkos::HostSpace>(
+                "checkpoint_host", view.extent( 0 ) );
+        else
+            return Kokkos::View<value_type**, Kokkos::LayoutRight,
+                                Kokkos::HostSpace>(
+                "checkpoint_host", view.extent( 0 ), view.extent( 1 ) );
+    }
+
+    template <class ViewType>
+    void packView( const ViewType& view )
+    {
+        using value_type = typename ViewType::non_const_value_type;
+        auto mirror =
+            Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace(), view );
+        auto host = hostView( view );
+        Kokkos::deep_copy( host, mirror );
+
+        const std::uint64_t bytes = host.size() * sizeof( value_type );
+        append( &bytes, sizeof( bytes ) );
+        append( host.data(), bytes );
+    }
+
+    template <class ViewType>
+    void unpackView( const ViewType& view )
+    {
+        using value_type = typename ViewType::non_const_value_type;
+        auto host = hostView( view );
+        std::uint64_t bytes;
+        extract( &bytes, sizeof( bytes ) );
+        if ( bytes != host.size() * sizeof( value_type ) )
+            throw std::runtime_error(
+                "Checkpoint field size does not match the restarted system." );
+        extract( host.data(), bytes );
+
+        auto mirror = Kokkos::create_mirror_view( view );
+        Kokkos::deep_copy( mirror, host );
+        Kokkos::deep_copy( view, mirror );
+    }
+};
+
+} // namespace CabanaPD
+
+#endif
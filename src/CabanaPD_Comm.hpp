@@ -12,17 +12,38 @@
 #ifndef COMM_H
 #define COMM_H
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "mpi.h"
 
 #include <Cabana_Grid.hpp>
 
+#include <CabanaPD_Memory.hpp>
 #include <CabanaPD_Timer.hpp>
 #include <CabanaPD_Types.hpp>
 
 namespace CabanaPD
 {
+// Neighbor rank in the given direction (the last offset is ignored in 2d).
+template <class LocalGridType>
+int gridNeighborRank( const LocalGridType& local_grid, const int offset[3] )
+{
+    if constexpr ( LocalGridType::num_space_dim == 3 )
+        return local_grid.neighborRank( offset[0], offset[1], offset[2] );
+    else
+        return local_grid.neighborRank( offset[0], offset[1] );
+}
+
 template <std::size_t Size, class Scalar>
 auto vectorToArray( std::vector<Scalar> vector )
 {
@@ -37,16 +58,16 @@ template <class MemorySpace, class LocalGridType>
 struct HaloIds
 {
     static constexpr std::size_t num_space_dim = LocalGridType::num_space_dim;
-    // FIXME: 2d
-    static constexpr int topology_size = 26;
+    // All cells surrounding (and including) the local domain.
+    static constexpr int topology_size = num_space_dim == 3 ? 27 : 9;
 
     using memory_space = MemorySpace;
 
-    int _min_halo;
+    double _cutoff;
 
     using coord_type = Kokkos::Array<double, num_space_dim>;
-    Kokkos::Array<coord_type, topology_size> _min_coord;
-    Kokkos::Array<coord_type, topology_size> _max_coord;
+    coord_type _local_low;
+    coord_type _local_high;
 
     Kokkos::Array<int, topology_size> _device_topology;
 
@@ -58,140 +79,133 @@ struct HaloIds
     DestinationRankView _destinations;
     DestinationRankView _ids;
 
+    // Particles are only ghosted to neighbor ranks owning space within the
+    // cutoff distance (typically the horizon).
     template <class PositionSliceType>
     HaloIds( const LocalGridType& local_grid,
-             const PositionSliceType& positions, const int minimum_halo_width,
-             const int max_export_guess )
+             const PositionSliceType& positions, const double cutoff )
+        : _cutoff( cutoff )
     {
-        _destinations = DestinationRankView(
-            Kokkos::ViewAllocateWithoutInitializing( "destinations" ),
-            max_export_guess );
-        _ids = DestinationRankView(
-            Kokkos::ViewAllocateWithoutInitializing( "ids" ),
-            max_export_guess );
         _send_count = CountView( "halo_send_count" );
 
-        // Check within the halo width, within the local domain.
-        _min_halo = minimum_halo_width;
-
-        auto topology = Cabana::Grid::getTopology( local_grid );
-        _device_topology = vectorToArray<topology_size>( topology );
-
-        // Get the neighboring mesh bounds (only needed once unless load
-        // balancing).
-        neighborBounds( local_grid );
+        // Get the local mesh bounds and neighbor ranks (only needed once
+        // unless load balancing).
+        localBounds( local_grid );
 
         build( positions );
     }
 
-    // Find the bounds of each neighbor rank and store for determining which
-    // ghost particles to communicate.
-    void neighborBounds( const LocalGridType& local_grid )
+    // Store the owned local mesh bounds and the neighbor rank in each of the
+    // 26 (8 in 2d) directions (invalid for the local domain itself).
+    void localBounds( const LocalGridType& local_grid )
     {
         const auto& local_mesh =
             Cabana::Grid::createLocalMesh<Kokkos::HostSpace>( local_grid );
+        for ( std::size_t d = 0; d < num_space_dim; ++d )
+        {
+            _local_low[d] = local_mesh.lowCorner( Cabana::Grid::Own(), d );
+            _local_high[d] = local_mesh.highCorner( Cabana::Grid::Own(), d );
+        }
 
-        Kokkos::Array<Cabana::Grid::IndexSpace<4>, topology_size> index_spaces;
-
-        // Store all neighboring shared index space mesh bounds so we only have
-        // to launch one kernel during the actual ghost search.
         int n = 0;
-        for ( int k = -1; k < 2; ++k )
-        {
+        const int k_max = num_space_dim == 3 ? 1 : 0;
+        for ( int k = -k_max; k <= k_max; ++k )
             for ( int j = -1; j < 2; ++j )
-            {
                 for ( int i = -1; i < 2; ++i, ++n )
                 {
-                    if ( i != 0 || j != 0 || k != 0 )
-                    {
-                        int neighbor_rank = local_grid.neighborRank( i, j, k );
-                        // Potentially invalid neighbor ranks (non-periodic
-                        // global boundary)
-                        if ( neighbor_rank != -1 )
-                        {
-                            auto sis = local_grid.sharedIndexSpace(
-                                Cabana::Grid::Own(), Cabana::Grid::Cell(), i, j,
-                                k, _min_halo );
-                            auto min_ind = sis.min();
-                            auto max_ind = sis.max();
-                            local_mesh.coordinates( Cabana::Grid::Node(),
-                                                    min_ind.data(),
-                                                    _min_coord[n].data() );
-                            local_mesh.coordinates( Cabana::Grid::Node(),
-                                                    max_ind.data(),
-                                                    _max_coord[n].data() );
-                        }
-                    }
+                    // Potentially invalid neighbor ranks (non-periodic global
+                    // boundary).
+                    const int offset[3] = { i, j, k };
+                    _device_topology[n] =
+                        ( i == 0 && j == 0 && k == 0 )
+                            ? -1
+                            : gridNeighborRank( local_grid, offset );
                 }
-            }
-        }
     }
 
     //---------------------------------------------------------------------------//
-    // Locate particles within the local grid and determine if any from this
-    // rank need to be ghosted to one (or more) of the 26 neighbor ranks,
-    // keeping track of destination rank and index.
+    // Locate particles within the cutoff distance of any of the 26 neighbor
+    // ranks, keeping track of destination rank and index. Sends are counted
+    // first so that they can be allocated exactly.
     template <class PositionSliceType, class UserFunctor>
     void build( const PositionSliceType& positions, UserFunctor user_functor )
     {
         using execution_space = typename PositionSliceType::execution_space;
 
         // Local copies of member variables for lambda capture.
+        auto device_topology = _device_topology;
+        auto low = _local_low;
+        auto high = _local_high;
+        auto cutoff = _cutoff;
+
+        // Check whether the region owned by neighbor n is within the cutoff
+        // (bonds can cross to that rank).
+        auto within_cutoff = KOKKOS_LAMBDA( const int p, const int n )
+        {
+            if ( device_topology[n] == -1 )
+                return false;
+
+            const int offset[3] = { n % 3 - 1, ( n / 3 ) % 3 - 1, n / 9 - 1 };
+            double dist_sq = 0.0;
+            for ( std::size_t d = 0; d < num_space_dim; ++d )
+            {
+                double dist = 0.0;
+                if ( offset[d] < 0 )
+                    dist = positions( p, d ) - low[d];
+                else if ( offset[d] > 0 )
+                    dist = high[d] - positions( p, d );
+                if ( dist > cutoff )
+                    return false;
+                if ( dist > 0.0 )
+                    dist_sq += dist * dist;
+            }
+            if ( dist_sq > cutoff * cutoff )
+                return false;
+
+            double px[3] = { 0.0, 0.0, 0.0 };
+            for ( std::size_t d = 0; d < num_space_dim; ++d )
+                px[d] = positions( p, d );
+            // Let the user restrict to a subset of the boundary.
+            return static_cast<bool>( user_functor( p, px ) );
+        };
+
+        auto policy =
+            Kokkos::RangePolicy<execution_space>( 0, positions.size() );
+
+        int num_send = 0;
+        Kokkos::parallel_reduce(
+            "CabanaPD::Comm::GhostCount", policy,
+            KOKKOS_LAMBDA( const int p, int& count ) {
+                for ( int n = 0; n < topology_size; n++ )
+                    if ( within_cutoff( p, n ) )
+                        count++;
+            },
+            num_send );
+
+        _destinations = DestinationRankView(
+            Kokkos::ViewAllocateWithoutInitializing( "destinations" ),
+            num_send );
+        _ids = DestinationRankView(
+            Kokkos::ViewAllocateWithoutInitializing( "ids" ), num_send );
+        Kokkos::deep_copy( _send_count, 0 );
+
         auto send_count = _send_count;
         auto destinations = _destinations;
         auto ids = _ids;
-        auto device_topology = _device_topology;
-        auto min_coord = _min_coord;
-        auto max_coord = _max_coord;
-
-        // Look for ghosts within the halo width of the local mesh boundary,
-        // potentially for each of the 26 neighbors cells.
-        // Do this one neighbor rank at a time so that sends are contiguous.
         auto ghost_search = KOKKOS_LAMBDA( const int p )
         {
-            for ( std::size_t n = 0; n < topology_size; n++ )
+            for ( int n = 0; n < topology_size; n++ )
             {
-                // Potentially invalid neighbor ranks (non-periodic global
-                // boundary)
-                if ( device_topology[n] != -1 )
+                if ( within_cutoff( p, n ) )
                 {
-                    // Check the if particle is both in the owned
-                    // space and the ghosted space of this neighbor
-                    // (ignore the current cell).
-                    bool within_halo = false;
-                    if ( positions( p, 0 ) > min_coord[n][0] &&
-                         positions( p, 0 ) < max_coord[n][0] &&
-                         positions( p, 1 ) > min_coord[n][1] &&
-                         positions( p, 1 ) < max_coord[n][1] &&
-                         positions( p, 2 ) > min_coord[n][2] &&
-                         positions( p, 2 ) < max_coord[n][2] )
-                        within_halo = true;
-                    if ( within_halo )
-                    {
-                        double px[3] = { positions( p, 0 ), positions( p, 1 ),
-                                         positions( p, 2 ) };
-                        // Let the user restrict to a subset of the boundary.
-                        bool create_ghost = user_functor( p, px );
-                        if ( create_ghost )
-                        {
-                            const std::size_t sc = send_count()++;
-                            // If the size of the arrays is exceeded,
-                            // keep counting to resize and fill next.
-                            if ( sc < destinations.extent( 0 ) )
-                            {
-                                // Keep the destination MPI rank.
-                                destinations( sc ) = device_topology[n];
-                                // Keep the particle ID.
-                                ids( sc ) = p;
-                            }
-                        }
-                    }
+                    const int sc = send_count()++;
+                    // Keep the destination MPI rank.
+                    destinations( sc ) = device_topology[n];
+                    // Keep the particle ID.
+                    ids( sc ) = p;
                 }
             }
         };
-
-        auto policy =
-            Kokkos::RangePolicy<execution_space>( 0, positions.size() );
         Kokkos::parallel_for( "CabanaPD::Comm::GhostSearch", policy,
                               ghost_search );
         Kokkos::fence();
@@ -206,28 +220,711 @@ struct HaloIds
         };
         build( positions, empty_functor );
     }
+};
 
-    template <class PositionSliceType>
-    void rebuild( const PositionSliceType& positions )
+// Version of each ghosted field, bumped by every kernel which writes the
+// owned values. Shared by all copies of the particles and by Comm such that
+// gathers of unchanged fields can be skipped.
+struct FieldVersions
+{
+    static constexpr int num_fields = 4;
+    // Starts above zero, which Comm uses for "never gathered".
+    std::array<std::size_t, num_fields> versions = { 1, 1, 1, 1 };
+    // Displacement versions for which current positions were last updated
+    // for owned and for all particles (zero if never).
+    std::size_t local_positions = 0;
+    std::size_t positions = 0;
+
+    template <class FieldTag>
+    void bump( FieldTag )
+    {
+        versions[FieldTag::index]++;
+    }
+    // Any field may have been written (e.g. by user functors).
+    void bumpAll()
+    {
+        for ( auto& v : versions )
+            v++;
+    }
+    template <class FieldTag>
+    std::size_t operator()( FieldTag ) const
+    {
+        return versions[FieldTag::index];
+    }
+};
+
+/******************************************************************************
+  Halo exchange options.
+******************************************************************************/
+struct HaloOptions
+{
+    // Pass device buffers directly to MPI (GPU-aware MPI) rather than staging
+    // through host copies. Ignored for host memory spaces.
+    bool gpu_aware_mpi = true;
+    // Create the MPI requests once per buffer layout (MPI_Send_init and
+    // MPI_Recv_init) and restart them for every exchange.
+    bool persistent_requests = false;
+    // Copy directly into the receive buffers of ranks on the same node
+    // through an MPI-3 shared memory window, using MPI only for zero-byte
+    // notifications. Requires buffers accessible from host kernels (host
+    // execution spaces) or host staging.
+    bool node_shared = false;
+};
+
+// Messages of one halo exchange where each particle occupies "stride" entries
+// of the send and receive buffers, which are owned here (device resident
+// unless staged through the host). Self-communication (periodic) is a direct
+// copy, ranks on the same node optionally write into the receive buffer
+// (window) of each other, and all other neighbors use MPI.
+template <class HaloType, class ValueType>
+class HaloMessages
+{
+  public:
+    using memory_space = typename HaloType::memory_space;
+    using execution_space = typename HaloType::execution_space;
+    using buffer_type = Kokkos::View<ValueType*, memory_space>;
+    using host_buffer_type = Kokkos::View<ValueType*, Kokkos::HostSpace>;
+
+    // MPI can read and write the buffers without GPU-aware MPI.
+    static constexpr bool host_memory =
+        Kokkos::SpaceAccessibility<Kokkos::HostSpace,
+                                   memory_space>::accessible;
+    // Pack and unpack kernels can read host (shared window) memory.
+    static constexpr bool host_execution =
+        Kokkos::SpaceAccessibility<execution_space,
+                                   Kokkos::HostSpace>::accessible;
+
+    // The node-shared window is only created if allowed and requires a fixed
+    // stride, given here.
+    HaloMessages( const HaloType& halo, const int mpi_tag,
+                  const HaloOptions& options, const std::size_t stride = 0,
+                  const bool allow_shared = false )
+        : _halo( halo )
+        , _mpi_tag( mpi_tag )
+        , _options( options )
+        , _staged( !host_memory && !options.gpu_aware_mpi )
+        , _shared( options.node_shared && allow_shared )
     {
-        // Resize views to actual send sizes.
-        int dest_size = _destinations.extent( 0 );
-        int dest_count = 0;
-        Kokkos::deep_copy( dest_count, _send_count );
-        if ( dest_count != dest_size )
+        if ( _shared && !host_execution && !_staged )
+            throw std::runtime_error(
+                "Node-shared halo exchange requires host execution or host "
+                "staging (halo_gpu_aware_mpi false)." );
+        if ( _shared && stride == 0 )
+            throw std::runtime_error(
+                "Node-shared halo exchange requires a fixed stride." );
+
+        MPI_Comm_rank( _halo.comm(), &_my_rank );
+        const int num_n = _halo.numNeighbor();
+        _on_node.assign( num_n, false );
+        _free_recv.assign( num_n, MPI_REQUEST_NULL );
+        if ( _shared )
+            createNodeComm();
+        if ( stride > 0 )
+            resize( stride );
+    }
+
+    HaloMessages( const HaloMessages& ) = delete;
+    HaloMessages& operator=( const HaloMessages& ) = delete;
+
+    ~HaloMessages()
+    {
+        int finalized = 0;
+        MPI_Finalized( &finalized );
+        if ( finalized )
+            return;
+        freeRequests();
+        if ( _shared )
         {
-            Kokkos::resize( _destinations, dest_count );
-            Kokkos::resize( _ids, dest_count );
+            MPI_Waitall( _free_recv.size(), _free_recv.data(),
+                         MPI_STATUSES_IGNORE );
+            waitAll( _free_send );
+            if ( _win != MPI_WIN_NULL )
+            {
+                MPI_Win_unlock_all( _win );
+                MPI_Win_free( &_win );
+            }
+            MPI_Comm_free( &_node_comm );
         }
+    }
+
+    // Size the buffers for the given stride (grown only). Persistent requests
+    // are recreated on the next exchange.
+    void resize( const std::size_t stride )
+    {
+        if ( stride == _stride )
+            return;
+        if ( _shared && _stride > 0 )
+            throw std::runtime_error(
+                "Node-shared halo exchange requires a fixed stride." );
+        freeRequests();
+        _stride = stride;
+
+        const std::size_t send_size = _halo.totalNumExport() * stride;
+        const std::size_t recv_size = _halo.totalNumImport() * stride;
+        if ( _send.extent( 0 ) < send_size )
+            _send = buffer_type(
+                Kokkos::ViewAllocateWithoutInitializing( "halo_send_buffer" ),
+                send_size );
+        if ( _staged && _send_host.extent( 0 ) < send_size )
+            _send_host = host_buffer_type(
+                Kokkos::ViewAllocateWithoutInitializing( "halo_send_host" ),
+                send_size );
 
-        // If original view sizes were exceeded, only counting was done so
-        // we need to rerun.
-        if ( dest_count > dest_size )
+        // The receive buffer (host copy if staged) is the shared window.
+        if ( _shared )
         {
-            Kokkos::deep_copy( _send_count, 0 );
-            build( positions );
+            ValueType* base = createWindow( recv_size );
+            if ( _staged )
+                _recv_host = host_buffer_type( base, recv_size );
+            else
+                _recv = buffer_type( base, recv_size );
         }
+        else if ( _staged && _recv_host.extent( 0 ) < recv_size )
+            _recv_host = host_buffer_type(
+                Kokkos::ViewAllocateWithoutInitializing( "halo_recv_host" ),
+                recv_size );
+        if ( ( !_shared || _staged ) && _recv.extent( 0 ) < recv_size )
+            _recv = buffer_type(
+                Kokkos::ViewAllocateWithoutInitializing( "halo_recv_buffer" ),
+                recv_size );
     }
+
+    // Buffers to pack into and unpack from.
+    const buffer_type& sendBuffer() const { return _send; }
+    const buffer_type& recvBuffer() const { return _recv; }
+
+    // Post all messages: the send buffer must be packed and complete.
+    void start()
+    {
+        const std::size_t send_size = _halo.totalNumExport() * _stride;
+        if ( _staged )
+            Kokkos::deep_copy( subBuffer( _send_host, 0, send_size ),
+                               subBuffer( _send, 0, send_size ) );
+        ValueType* send_ptr = _staged ? _send_host.data() : _send.data();
+        ValueType* recv_ptr = _staged ? _recv_host.data() : _recv.data();
+
+        if ( _options.persistent_requests )
+        {
+            if ( !_persistent )
+                createRequests( send_ptr, recv_ptr );
+            MPI_Startall( _requests.size(), _requests.data() );
+        }
+        else
+        {
+            postRequests( send_ptr, recv_ptr );
+        }
+
+        if ( _shared )
+        {
+            // The previous notifications must complete before the neighbors'
+            // receive buffers are overwritten.
+            waitAll( _free_send );
+            MPI_Waitall( _free_recv.size(), _free_recv.data(),
+                         MPI_STATUSES_IGNORE );
+        }
+
+        std::size_t recv_offset = 0;
+        std::size_t send_offset = 0;
+        for ( int n = 0; n < _halo.numNeighbor(); ++n )
+        {
+            const std::size_t num_import = _halo.numImport( n ) * _stride;
+            const std::size_t num_export = _halo.numExport( n ) * _stride;
+            if ( _halo.neighborRank( n ) == _my_rank )
+            {
+                if ( _staged )
+                    Kokkos::deep_copy(
+                        subBuffer( _recv_host, recv_offset, num_import ),
+                        subBuffer( _send_host, send_offset, num_export ) );
+                else
+                    Kokkos::deep_copy(
+                        subBuffer( _recv, recv_offset, num_import ),
+                        subBuffer( _send, send_offset, num_export ) );
+            }
+            else if ( _on_node[n] && num_export > 0 )
+            {
+                std::memcpy( _remote[n], send_ptr + send_offset,
+                             num_export * sizeof( ValueType ) );
+            }
+            recv_offset += num_import;
+            send_offset += num_export;
+        }
+
+        if ( _shared )
+            notifyNodeNeighbors();
+    }
+
+    // Wait for all messages: the receive buffer is then complete.
+    void finish()
+    {
+        MPI_Waitall( _requests.size(), _requests.data(), MPI_STATUSES_IGNORE );
+        if ( !_options.persistent_requests )
+            _requests.clear();
+        if ( _shared )
+        {
+            waitAll( _notify );
+            MPI_Win_sync( _win );
+        }
+        if ( _staged )
+        {
+            const std::size_t recv_size = _halo.totalNumImport() * _stride;
+            Kokkos::deep_copy( subBuffer( _recv, 0, recv_size ),
+                               subBuffer( _recv_host, 0, recv_size ) );
+        }
+    }
+
+    // Allow on-node neighbors to overwrite the receive buffer once it has
+    // been unpacked.
+    void release()
+    {
+        if ( !_shared )
+            return;
+        if ( !_staged )
+            execution_space().fence();
+        for ( int n = 0; n < _halo.numNeighbor(); ++n )
+        {
+            if ( _on_node[n] && _halo.numImport( n ) > 0 )
+            {
+                _free_send.push_back( MPI_Request() );
+                MPI_Isend( nullptr, 0, MPI_BYTE, _halo.neighborRank( n ),
+                           freeTag(), _halo.comm(), &_free_send.back() );
+            }
+        }
+    }
+
+    double bytes() const
+    {
+        double bytes = viewBytes( _send ) + viewBytes( _send_host );
+        // Window memory is not owned by the views.
+        if ( _shared )
+            bytes += _halo.totalNumImport() * _stride * sizeof( ValueType );
+        if ( !_shared || _staged )
+            bytes += viewBytes( _recv );
+        if ( !_shared && _staged )
+            bytes += viewBytes( _recv_host );
+        return bytes;
+    }
+
+  protected:
+    template <class ViewType>
+    static auto subBuffer( const ViewType& view, const std::size_t offset,
+                           const std::size_t size )
+    {
+        return Kokkos::subview( view,
+                                Kokkos::make_pair( offset, offset + size ) );
+    }
+
+    static void waitAll( std::vector<MPI_Request>& requests )
+    {
+        MPI_Waitall( requests.size(), requests.data(), MPI_STATUSES_IGNORE );
+        requests.clear();
+    }
+
+    int freeTag() const { return _mpi_tag + free_tag_offset; }
+
+    // MPI messages for all neighbors other than this rank and those on the
+    // same node.
+    template <class InitRecv, class InitSend>
+    void forEachMessage( ValueType* send_ptr, ValueType* recv_ptr,
+                         InitRecv&& init_recv, InitSend&& init_send )
+    {
+        std::size_t recv_offset = 0;
+        std::size_t send_offset = 0;
+        for ( int n = 0; n < _halo.numNeighbor(); ++n )
+        {
+            const std::size_t num_import = _halo.numImport( n ) * _stride;
+            const std::size_t num_export = _halo.numExport( n ) * _stride;
+            const int rank = _halo.neighborRank( n );
+            if ( rank != _my_rank && !_on_node[n] )
+            {
+                if ( num_import > 0 )
+                {
+                    _requests.push_back( MPI_Request() );
+                    init_recv( recv_ptr + recv_offset,
+                               num_import * sizeof( ValueType ), rank,
+                               &_requests.back() );
+                }
+                if ( num_export > 0 )
+                {
+                    _requests.push_back( MPI_Request() );
+                    init_send( send_ptr + send_offset,
+                               num_export * sizeof( ValueType ), rank,
+                               &_requests.back() );
+                }
+            }
+            recv_offset += num_import;
+            send_offset += num_export;
+        }
+    }
+
+    void postRequests( ValueType* send_ptr, ValueType* recv_ptr )
+    {
+        _requests.clear();
+        auto comm = _halo.comm();
+        const int tag = _mpi_tag;
+        forEachMessage(
+            send_ptr, recv_ptr,
+            [=]( ValueType* ptr, std::size_t bytes, int rank, MPI_Request* r )
+            { MPI_Irecv( ptr, bytes, MPI_BYTE, rank, tag, comm, r ); },
+            [=]( ValueType* ptr, std::size_t bytes, int rank, MPI_Request* r )
+            { MPI_Isend( ptr, bytes, MPI_BYTE, rank, tag, comm, r ); } );
+    }
+
+    void createRequests( ValueType* send_ptr, ValueType* recv_ptr )
+    {
+        _requests.clear();
+        auto comm = _halo.comm();
+        const int tag = _mpi_tag;
+        forEachMessage(
+            send_ptr, recv_ptr,
+            [=]( ValueType* ptr, std::size_t bytes, int rank, MPI_Request* r )
+            { MPI_Recv_init( ptr, bytes, MPI_BYTE, rank, tag, comm, r ); },
+            [=]( ValueType* ptr, std::size_t bytes, int rank, MPI_Request* r )
+            { MPI_Send_init( ptr, bytes, MPI_BYTE, rank, tag, comm, r ); } );
+        _persistent = true;
+    }
+
+    void freeRequests()
+    {
+        if ( _persistent )
+        {
+            for ( auto& request : _requests )
+                MPI_Request_free( &request );
+            _requests.clear();
+            _persistent = false;
+        }
+    }
+
+    // Neighbors sharing this node (other than this rank).
+    void createNodeComm()
+    {
+        MPI_Comm_split_type( _halo.comm(), MPI_COMM_TYPE_SHARED, _my_rank,
+                             MPI_INFO_NULL, &_node_comm );
+        MPI_Group group;
+        MPI_Group node_group;
+        MPI_Comm_group( _halo.comm(), &group );
+        MPI_Comm_group( _node_comm, &node_group );
+        const int num_n = _halo.numNeighbor();
+        std::vector<int> ranks( num_n );
+        for ( int n = 0; n < num_n; ++n )
+            ranks[n] = _halo.neighborRank( n );
+        _node_rank.resize( num_n );
+        MPI_Group_translate_ranks( group, num_n, ranks.data(), node_group,
+                                   _node_rank.data() );
+        MPI_Group_free( &group );
+        MPI_Group_free( &node_group );
+        for ( int n = 0; n < num_n; ++n )
+            _on_node[n] =
+                ranks[n] != _my_rank && _node_rank[n] != MPI_UNDEFINED;
+    }
+
+    // Allocate the receive window (collective over the node) and locate the
+    // segment of each on-node neighbor's window which this rank writes.
+    ValueType* createWindow( const std::size_t recv_size )
+    {
+        ValueType* base = nullptr;
+        MPI_Win_allocate_shared( recv_size * sizeof( ValueType ),
+                                 sizeof( ValueType ), MPI_INFO_NULL,
+                                 _node_comm, &base, &_win );
+        MPI_Win_lock_all( MPI_MODE_NOCHECK, _win );
+
+        const int num_n = _halo.numNeighbor();
+        std::vector<unsigned long long> local_offset( num_n, 0 );
+        std::vector<unsigned long long> remote_offset( num_n, 0 );
+        std::size_t recv_offset = 0;
+        for ( int n = 0; n < num_n; ++n )
+        {
+            local_offset[n] = recv_offset;
+            recv_offset += _halo.numImport( n ) * _stride;
+        }
+        std::vector<MPI_Request> requests;
+        for ( int n = 0; n < num_n; ++n )
+        {
+            if ( !_on_node[n] )
+                continue;
+            requests.push_back( MPI_Request() );
+            MPI_Irecv( &remote_offset[n], 1, MPI_UNSIGNED_LONG_LONG,
+                       _halo.neighborRank( n ), _mpi_tag, _halo.comm(),
+                       &requests.back() );
+            requests.push_back( MPI_Request() );
+            MPI_Isend( &local_offset[n], 1, MPI_UNSIGNED_LONG_LONG,
+                       _halo.neighborRank( n ), _mpi_tag, _halo.comm(),
+                       &requests.back() );
+        }
+        waitAll( requests );
+
+        _remote.assign( num_n, nullptr );
+        for ( int n = 0; n < num_n; ++n )
+        {
+            if ( !_on_node[n] )
+                continue;
+            MPI_Aint size;
+            int disp_unit;
+            ValueType* remote_base = nullptr;
+            MPI_Win_shared_query( _win, _node_rank[n], &size, &disp_unit,
+                                  &remote_base );
+            _remote[n] = remote_base + remote_offset[n];
+        }
+        return base;
+    }
+
+    // Make the direct writes visible and notify the receiving neighbors, then
+    // expect the data of the sending neighbors and (for the next exchange)
+    // notice that the receiving neighbors have unpacked.
+    void notifyNodeNeighbors()
+    {
+        MPI_Win_sync( _win );
+        auto comm = _halo.comm();
+        for ( int n = 0; n < _halo.numNeighbor(); ++n )
+        {
+            if ( !_on_node[n] )
+                continue;
+            const int rank = _halo.neighborRank( n );
+            if ( _halo.numExport( n ) > 0 )
+            {
+                _notify.push_back( MPI_Request() );
+                MPI_Isend( nullptr, 0, MPI_BYTE, rank, _mpi_tag, comm,
+                           &_notify.back() );
+                MPI_Irecv( nullptr, 0, MPI_BYTE, rank, freeTag(), comm,
+                           &_free_recv[n] );
+            }
+            if ( _halo.numImport( n ) > 0 )
+            {
+                _notify.push_back( MPI_Request() );
+                MPI_Irecv( nullptr, 0, MPI_BYTE, rank, _mpi_tag, comm,
+                           &_notify.back() );
+            }
+        }
+    }
+
+    // Distinct from all gather tags.
+    static constexpr int free_tag_offset = 1000;
+
+    HaloType _halo;
+    int _mpi_tag;
+    HaloOptions _options;
+    bool _staged;
+    bool _shared;
+    int _my_rank = -1;
+    std::size_t _stride = 0;
+
+    buffer_type _send;
+    buffer_type _recv;
+    host_buffer_type _send_host;
+    host_buffer_type _recv_host;
+
+    // MPI data messages, persistent if _persistent.
+    std::vector<MPI_Request> _requests;
+    bool _persistent = false;
+
+    // Node-shared window state, per neighbor.
+    MPI_Comm _node_comm = MPI_COMM_NULL;
+    MPI_Win _win = MPI_WIN_NULL;
+    std::vector<bool> _on_node;
+    std::vector<int> _node_rank;
+    std::vector<ValueType*> _remote;
+    std::vector<MPI_Request> _notify;
+    std::vector<MPI_Request> _free_send;
+    std::vector<MPI_Request> _free_recv;
+};
+
+// Halo gather split into start (pack and post messages) and finish (wait and
+// unpack into ghosts) so that work not depending on ghost data can be done
+// while messages are in flight. Follows the Cabana::Gather buffer layout.
+template <class HaloType, class AoSoAType>
+class HaloGather
+{
+  public:
+    using memory_space = typename HaloType::memory_space;
+    using execution_space = typename HaloType::execution_space;
+    using tuple_type = typename AoSoAType::tuple_type;
+    using messages_type = HaloMessages<HaloType, tuple_type>;
+
+    // Size of one particle in a fused (double word) buffer.
+    static constexpr std::size_t num_words =
+        ( sizeof( tuple_type ) + sizeof( double ) - 1 ) / sizeof( double );
+
+    HaloGather( const HaloType& halo, AoSoAType& aosoa, const int mpi_tag,
+                const HaloOptions& options = HaloOptions{} )
+        : _halo( halo )
+        , _aosoa( aosoa )
+        , _messages( halo, mpi_tag, options, 1, true )
+    {
+    }
+
+    // Pack owned data and post all sends and receives.
+    void start()
+    {
+        auto send_buffer = _messages.sendBuffer();
+        auto aosoa = _aosoa;
+        auto steering = _halo.getExportSteering();
+        Kokkos::RangePolicy<execution_space> policy( 0,
+                                                     _halo.totalNumExport() );
+        Kokkos::parallel_for(
+            "CabanaPD::HaloGather::pack", policy, KOKKOS_LAMBDA( const int i ) {
+                send_buffer( i ) = aosoa.getTuple( steering( i ) );
+            } );
+        // Only the pack must be complete: kernels on other instances (e.g.
+        // heat transfer) are not waited on.
+        execution_space().fence();
+
+        _messages.start();
+    }
+
+    // Wait for all messages and unpack into the ghost particles.
+    void finish()
+    {
+        _messages.finish();
+
+        auto recv_buffer = _messages.recvBuffer();
+        auto aosoa = _aosoa;
+        const std::size_t num_local = _halo.numLocal();
+        Kokkos::RangePolicy<execution_space> policy( 0,
+                                                     _halo.totalNumImport() );
+        Kokkos::parallel_for(
+            "CabanaPD::HaloGather::unpack", policy,
+            KOKKOS_LAMBDA( const int i ) {
+                aosoa.setTuple( num_local + i, recv_buffer( i ) );
+            } );
+        _messages.release();
+    }
+
+    void apply()
+    {
+        start();
+        finish();
+    }
+
+    // Pack owned data into a fused buffer with the given particle stride and
+    // offset (in words).
+    template <class FusedBufferType>
+    void pack( const FusedBufferType& buffer, const std::size_t stride,
+               const std::size_t offset ) const
+    {
+        auto aosoa = _aosoa;
+        auto steering = _halo.getExportSteering();
+        Kokkos::RangePolicy<execution_space> policy( 0,
+                                                     _halo.totalNumExport() );
+        Kokkos::parallel_for(
+            "CabanaPD::HaloGather::packFused", policy,
+            KOKKOS_LAMBDA( const int i ) {
+                *reinterpret_cast<tuple_type*>(
+                    &buffer( i * stride + offset ) ) =
+                    aosoa.getTuple( steering( i ) );
+            } );
+    }
+
+    // Unpack ghost data from a fused buffer.
+    template <class FusedBufferType>
+    void unpack( const FusedBufferType& buffer, const std::size_t stride,
+                 const std::size_t offset ) const
+    {
+        auto aosoa = _aosoa;
+        const std::size_t num_local = _halo.numLocal();
+        Kokkos::RangePolicy<execution_space> policy( 0,
+                                                     _halo.totalNumImport() );
+        Kokkos::parallel_for(
+            "CabanaPD::HaloGather::unpackFused", policy,
+            KOKKOS_LAMBDA( const int i ) {
+                aosoa.setTuple( num_local + i,
+                                *reinterpret_cast<const tuple_type*>(
+                                    &buffer( i * stride + offset ) ) );
+            } );
+    }
+
+    // Bytes sent from this rank for each gather.
+    double sendBytes() const
+    {
+        return static_cast<double>( _halo.totalNumExport() *
+                                    sizeof( tuple_type ) );
+    }
+
+    // Allocated send and receive buffer bytes.
+    double bufferBytes() const { return _messages.bytes(); }
+
+  protected:
+    HaloType _halo;
+    AoSoAType _aosoa;
+    messages_type _messages;
+};
+
+// Gather several fields in a single message per neighbor rank: each particle
+// holds the tuples of all added gathers back to back. The stride changes with
+// the fields, so ranks on the same node use MPI rather than a shared window.
+template <class HaloType>
+class FusedHaloGather
+{
+  public:
+    using memory_space = typename HaloType::memory_space;
+    using execution_space = typename HaloType::execution_space;
+    using messages_type = HaloMessages<HaloType, double>;
+    using buffer_type = typename messages_type::buffer_type;
+
+    FusedHaloGather( const HaloType& halo, const int mpi_tag,
+                     const HaloOptions& options = HaloOptions{} )
+        : _halo( halo )
+        , _messages( halo, mpi_tag, options )
+    {
+    }
+
+    void clear()
+    {
+        _pack.clear();
+        _unpack.clear();
+        _stride = 0;
+    }
+
+    template <class GatherType>
+    void add( const GatherType& gather )
+    {
+        const std::size_t offset = _stride;
+        _pack.push_back(
+            [&gather, offset]( const buffer_type& buffer,
+                               const std::size_t stride )
+            { gather.pack( buffer, stride, offset ); } );
+        _unpack.push_back(
+            [&gather, offset]( const buffer_type& buffer,
+                               const std::size_t stride )
+            { gather.unpack( buffer, stride, offset ); } );
+        _stride += GatherType::num_words;
+    }
+
+    bool empty() const { return _stride == 0; }
+
+    void apply()
+    {
+        if ( empty() )
+            return;
+
+        _messages.resize( _stride );
+        for ( auto& pack : _pack )
+            pack( _messages.sendBuffer(), _stride );
+        execution_space().fence();
+
+        _messages.start();
+        _messages.finish();
+
+        for ( auto& unpack : _unpack )
+            unpack( _messages.recvBuffer(), _stride );
+    }
+
+    // Bytes sent from this rank for the current set of fields.
+    double sendBytes() const
+    {
+        return static_cast<double>( _halo.totalNumExport() * _stride *
+                                    sizeof( double ) );
+    }
+
+    // Allocated send and receive buffer bytes (grown on first use).
+    double bufferBytes() const { return _messages.bytes(); }
+
+  protected:
+    HaloType _halo;
+    std::size_t _stride = 0;
+    messages_type _messages;
+    std::vector<std::function<void( const buffer_type&, const std::size_t )>>
+        _pack;
+    std::vector<std::function<void( const buffer_type&, const std::size_t )>>
+        _unpack;
 };
 
 template <class ParticleType, class ModelType, class ThermalType>
@@ -240,17 +937,27 @@ class Comm<ParticleType, PMB, TemperatureIndependent>
   public:
     int mpi_size = -1;
     int mpi_rank = -1;
-    int max_export;
 
     using memory_space = typename ParticleType::memory_space;
+    static constexpr int dim = ParticleType::dim;
     using halo_type = Cabana::Halo<memory_space>;
     using gather_u_type =
-        Cabana::Gather<halo_type, typename ParticleType::aosoa_u_type>;
+        HaloGather<halo_type, typename ParticleType::aosoa_u_type>;
+    using force_slice_type =
+        decltype( std::declval<ParticleType&>().sliceForce() );
+    using scatter_f_type = Cabana::Scatter<halo_type, force_slice_type>;
+    using fused_gather_type = FusedHaloGather<halo_type>;
     std::shared_ptr<gather_u_type> gather_u;
+    std::shared_ptr<scatter_f_type> scatter_f;
+    std::shared_ptr<fused_gather_type> gather_fused;
     std::shared_ptr<halo_type> halo;
 
-    Comm( ParticleType& particles, int max_export_guess = 100 )
-        : max_export( max_export_guess )
+    // Particles are ghosted to ranks owning space within the cutoff distance,
+    // defaulting to the full halo region of the grid.
+    Comm( ParticleType& particles, double cutoff = 0.0,
+          const HaloOptions& options = HaloOptions{} )
+        : _versions( particles.fieldVersions() )
+        , _halo_options( options )
     {
         _init_timer.start();
         auto local_grid = particles.local_grid;
@@ -258,31 +965,24 @@ class Comm<ParticleType, PMB, TemperatureIndependent>
         MPI_Comm_rank( local_grid->globalGrid().comm(), &mpi_rank );
 
         auto positions = particles.sliceReferencePosition();
-        // Get all 26 neighbor ranks.
-        auto halo_width = local_grid->haloCellWidth();
+        // Get all neighbor ranks.
         auto topology = Cabana::Grid::getTopology( *local_grid );
 
+        if ( cutoff <= 0.0 )
+        {
+            auto halo_width = local_grid->haloCellWidth();
+            for ( int d = 0; d < dim; d++ )
+                cutoff = std::max( cutoff, halo_width * particles.dx[d] );
+        }
+
         // Determine which particles need to be ghosted to neighbors.
-        // FIXME: set halo width based on cutoff distance.
-        auto halo_ids =
-            createHaloIds( *local_grid, positions, halo_width, max_export );
-        // Rebuild if needed.
-        halo_ids.rebuild( positions );
+        auto halo_ids = createHaloIds( *local_grid, positions, cutoff );
 
         // Create the Cabana Halo.
         halo = std::make_shared<halo_type>(
             local_grid->globalGrid().comm(), particles.localOffset(),
             halo_ids._ids, halo_ids._destinations, topology );
-
-        particles.resize( halo->numLocal(), halo->numGhost() );
-
-        // Only use this interface because we don't need to recommunicate
-        // positions, volumes, or no-fail region.
-        Cabana::gather( *halo, particles.getReferencePosition().aosoa() );
-        Cabana::gather( *halo, particles._aosoa_vol );
-
-        gather_u = std::make_shared<gather_u_type>( *halo, particles._aosoa_u );
-        gather_u->apply();
+        setupHalo( particles );
 
         _init_timer.stop();
     }
@@ -290,35 +990,664 @@ class Comm<ParticleType, PMB, TemperatureIndependent>
     auto size() { return mpi_size; }
     auto rank() { return mpi_rank; }
 
-    // Determine which particles should be ghosted, reallocating and recounting
-    // if needed.
+    // Owning rank of each local particle from its current position: particles
+    // outside the owned box move to the adjacent rank in that direction (or
+    // stay at a non-periodic domain boundary).
+    auto createDistributor( ParticleType& particles )
+    {
+        _timer.start();
+        auto local_grid = particles.local_grid;
+        Kokkos::Array<int, 27> neighbors;
+        Kokkos::Array<double, 3> low;
+        Kokkos::Array<double, 3> high;
+        const int k_max = dim == 3 ? 1 : 0;
+        for ( int k = -k_max; k <= k_max; k++ )
+            for ( int j = -1; j < 2; j++ )
+                for ( int i = -1; i < 2; i++ )
+                {
+                    const int n = ( i + 1 ) + 3 * ( j + 1 ) + 9 * ( k + k_max );
+                    const int offset[3] = { i, j, k };
+                    neighbors[n] = gridNeighborRank( *local_grid, offset );
+                    if ( neighbors[n] < 0 )
+                        neighbors[n] = mpi_rank;
+                }
+        for ( int d = 0; d < dim; d++ )
+        {
+            low[d] = particles.local_mesh_lo[d];
+            high[d] = particles.local_mesh_hi[d];
+        }
+
+        auto y = particles.sliceCurrentPosition();
+        Kokkos::View<int*, memory_space> destinations(
+            Kokkos::ViewAllocateWithoutInitializing( "migrate_destinations" ),
+            particles.localOffset() );
+        using exec_space = typename memory_space::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( 0, particles.localOffset() );
+        Kokkos::parallel_for(
+            "CabanaPD::Comm::migrateDestinations", policy,
+            KOKKOS_LAMBDA( const int p ) {
+                int n = 0;
+                int stride = 1;
+                for ( int d = 0; d < dim; d++ )
+                {
+                    int offset = 1;
+                    if ( y( p, d ) < low[d] )
+                        offset = 0;
+                    else if ( y( p, d ) >= high[d] )
+                        offset = 2;
+                    n += offset * stride;
+                    stride *= 3;
+                }
+                destinations( p ) = neighbors[n];
+            } );
+        Kokkos::fence();
+
+        Cabana::Distributor<memory_space> distributor(
+            local_grid->globalGrid().comm(), destinations,
+            Cabana::Grid::getTopology( *local_grid ) );
+        _timer.stop();
+        return distributor;
+    }
+
+    // Owning rank of each local particle from its current position after the
+    // domain has been repartitioned: particles may move to any rank.
+    auto createRebalanceDistributor( ParticleType& particles )
+    {
+        _timer.start();
+        const auto& global_grid = particles.local_grid->globalGrid();
+        Kokkos::Array<int, 3> num_blocks = { 1, 1, 1 };
+        int max_blocks = 0;
+        for ( int d = 0; d < dim; d++ )
+        {
+            num_blocks[d] = global_grid.dimNumBlock( d );
+            max_blocks = std::max( max_blocks, num_blocks[d] );
+        }
+        Kokkos::View<double**, Kokkos::HostSpace> bounds_host(
+            "rebalance_bounds", 3, max_blocks + 1 );
+        for ( int d = 0; d < dim; d++ )
+            for ( int b = 0; b <= num_blocks[d]; b++ )
+                bounds_host( d, b ) = particles.block_bounds[d][b];
+        Kokkos::View<int***, Kokkos::HostSpace> ranks_host(
+            "rebalance_ranks", num_blocks[0], num_blocks[1], num_blocks[2] );
+        for ( int i = 0; i < num_blocks[0]; i++ )
+            for ( int j = 0; j < num_blocks[1]; j++ )
+                for ( int k = 0; k < num_blocks[2]; k++ )
+                {
+                    if constexpr ( dim == 3 )
+                        ranks_host( i, j, k ) =
+                            global_grid.blockRank( i, j, k );
+                    else
+                        ranks_host( i, j, k ) = global_grid.blockRank( i, j );
+                }
+        auto bounds =
+            Kokkos::create_mirror_view_and_copy( memory_space(), bounds_host );
+        auto ranks =
+            Kokkos::create_mirror_view_and_copy( memory_space(), ranks_host );
+
+        auto y = particles.sliceCurrentPosition();
+        Kokkos::View<int*, memory_space> destinations(
+            Kokkos::ViewAllocateWithoutInitializing( "rebalance_destinations" ),
+            particles.localOffset() );
+        using exec_space = typename memory_space::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( 0, particles.localOffset() );
+        Kokkos::parallel_for(
+            "CabanaPD::Comm::rebalanceDestinations", policy,
+            KOKKOS_LAMBDA( const int p ) {
+                int block[3] = { 0, 0, 0 };
+                for ( int d = 0; d < dim; d++ )
+                {
+                    block[d] = 0;
+                    while ( block[d] < num_blocks[d] - 1 &&
+                            y( p, d ) >= bounds( d, block[d] + 1 ) )
+                        block[d]++;
+                }
+                destinations( p ) = ranks( block[0], block[1], block[2] );
+            } );
+        Kokkos::fence();
+
+        Cabana::Distributor<memory_space> distributor( global_grid.comm(),
+                                                       destinations );
+        _timer.stop();
+        return distributor;
+    }
+
+    // Migrate per-particle rows of a 2D view (e.g. broken bonds) with the same
+    // plan used for the particles. Rows are padded to the widest on any rank.
+    template <class DistributorType, class ViewType>
+    auto migrateRows( const DistributorType& distributor, const ViewType& rows )
+    {
+        _timer.start();
+        using value_type = typename ViewType::non_const_value_type;
+        using buffer_type =
+            Kokkos::View<value_type**, Kokkos::LayoutRight, memory_space>;
+        using exec_space = typename memory_space::execution_space;
+
+        int num_cols = rows.extent( 1 );
+        MPI_Allreduce( MPI_IN_PLACE, &num_cols, 1, MPI_INT, MPI_MAX,
+                       distributor.comm() );
+        const int old_cols = rows.extent( 1 );
+
+        buffer_type send_buffer( "migrate_send_buffer",
+                                 distributor.totalNumExport(), num_cols );
+        buffer_type recv_buffer(
+            Kokkos::ViewAllocateWithoutInitializing( "migrate_recv_buffer" ),
+            distributor.totalNumImport(), num_cols );
+        auto steering = distributor.getExportSteering();
+        Kokkos::RangePolicy<exec_space> policy( 0,
+                                                send_buffer.extent( 0 ) );
+        Kokkos::parallel_for(
+            "CabanaPD::Comm::migrateRows::pack", policy,
+            KOKKOS_LAMBDA( const int i ) {
+                for ( int c = 0; c < old_cols; c++ )
+                    send_buffer( i, c ) = rows( steering( i ), c );
+            } );
+        Kokkos::fence();
+
+        // Same buffer layout as Cabana::migrate: contiguous per neighbor.
+        std::vector<MPI_Request> requests;
+        requests.reserve( 2 * distributor.numNeighbor() );
+        const std::size_t row_bytes = num_cols * sizeof( value_type );
+        std::size_t recv_offset = 0;
+        std::size_t send_offset = 0;
+        for ( int n = 0; n < distributor.numNeighbor(); ++n )
+        {
+            const std::size_t num_import = distributor.numImport( n );
+            const std::size_t num_export = distributor.numExport( n );
+            const int rank = distributor.neighborRank( n );
+            if ( rank == mpi_rank )
+            {
+                Kokkos::deep_copy(
+                    Kokkos::subview( recv_buffer,
+                                     Kokkos::make_pair(
+                                         recv_offset,
+                                         recv_offset + num_import ),
+                                     Kokkos::ALL() ),
+                    Kokkos::subview( send_buffer,
+                                     Kokkos::make_pair(
+                                         send_offset,
+                                         send_offset + num_export ),
+                                     Kokkos::ALL() ) );
+            }
+            else
+            {
+                if ( num_import > 0 )
+                {
+                    requests.push_back( MPI_Request() );
+                    MPI_Irecv( recv_buffer.data() + recv_offset * num_cols,
+                               num_import * row_bytes, MPI_BYTE, rank,
+                               migrate_tag, distributor.comm(),
+                               &requests.back() );
+                }
+                if ( num_export > 0 )
+                {
+                    requests.push_back( MPI_Request() );
+                    MPI_Isend( send_buffer.data() + send_offset * num_cols,
+                               num_export * row_bytes, MPI_BYTE, rank,
+                               migrate_tag, distributor.comm(),
+                               &requests.back() );
+                }
+            }
+            recv_offset += num_import;
+            send_offset += num_export;
+        }
+        MPI_Waitall( requests.size(), requests.data(), MPI_STATUSES_IGNORE );
+
+        Kokkos::View<value_type**, memory_space> migrated(
+            Kokkos::ViewAllocateWithoutInitializing( rows.label() ),
+            distributor.totalNumImport(), num_cols );
+        Kokkos::deep_copy( migrated, recv_buffer );
+        _timer.stop();
+        return migrated;
+    }
+
+    // Rebuild ghosts after migration. Without the fixed grid topology, each
+    // rank exports to every rank whose local particle bounds (reference
+    // positions padded by the bond cutoff, current positions padded by the
+    // contact cutoff) contain the particle.
+    void rebuildHalo( ParticleType& particles, const double reference_cutoff,
+                      const double current_cutoff = 0.0 )
+    {
+        _timer.start();
+        using exec_space = typename memory_space::execution_space;
+        auto x = particles.sliceReferencePosition();
+        auto y = particles.sliceCurrentPosition();
+        const std::size_t num_local = particles.localOffset();
+        Kokkos::RangePolicy<exec_space> policy( 0, num_local );
+
+        // Low and high corners of reference, then current, positions.
+        constexpr int box_size = 12;
+        std::vector<double> box( box_size, 0.0 );
+        for ( int d = 0; d < dim; d++ )
+        {
+            Kokkos::MinMaxScalar<double> x_bounds;
+            Kokkos::parallel_reduce(
+                "CabanaPD::Comm::referenceBounds", policy,
+                KOKKOS_LAMBDA( const int p,
+                               Kokkos::MinMaxScalar<double>& b ) {
+                    if ( x( p, d ) < b.min_val )
+                        b.min_val = x( p, d );
+                    if ( x( p, d ) > b.max_val )
+                        b.max_val = x( p, d );
+                },
+                Kokkos::MinMax<double>( x_bounds ) );
+            Kokkos::MinMaxScalar<double> y_bounds;
+            Kokkos::parallel_reduce(
+                "CabanaPD::Comm::currentBounds", policy,
+                KOKKOS_LAMBDA( const int p,
+                               Kokkos::MinMaxScalar<double>& b ) {
+                    if ( y( p, d ) < b.min_val )
+                        b.min_val = y( p, d );
+                    if ( y( p, d ) > b.max_val )
+                        b.max_val = y( p, d );
+                },
+                Kokkos::MinMax<double>( y_bounds ) );
+            box[d] = x_bounds.min_val - reference_cutoff;
+            box[d + 3] = x_bounds.max_val + reference_cutoff;
+            // A non-positive cutoff disables ghosting by current position.
+            const bool use_current = current_cutoff > 0.0;
+            box[d + 6] = use_current ? y_bounds.min_val - current_cutoff : 1.0;
+            box[d + 9] = use_current ? y_bounds.max_val + current_cutoff : -1.0;
+        }
+        std::vector<double> all_boxes( box_size * mpi_size );
+        MPI_Allgather( box.data(), box_size, MPI_DOUBLE, all_boxes.data(),
+                       box_size, MPI_DOUBLE,
+                       particles.local_grid->globalGrid().comm() );
+        Kokkos::View<double**, Kokkos::HostSpace,
+                     Kokkos::MemoryTraits<Kokkos::Unmanaged>>
+            boxes_host( all_boxes.data(), mpi_size, box_size );
+        auto boxes = Kokkos::create_mirror_view_and_copy( memory_space(),
+                                                          boxes_host );
+
+        const int num_ranks = mpi_size;
+        const int my_rank = mpi_rank;
+        auto export_to = KOKKOS_LAMBDA( const int p, const int r )
+        {
+            if ( r == my_rank )
+                return false;
+            bool in_reference = true;
+            bool in_current = true;
+            for ( int d = 0; d < dim; d++ )
+            {
+                in_reference = in_reference && x( p, d ) >= boxes( r, d ) &&
+                               x( p, d ) <= boxes( r, d + 3 );
+                in_current = in_current && y( p, d ) >= boxes( r, d + 6 ) &&
+                             y( p, d ) <= boxes( r, d + 9 );
+            }
+            return in_reference || in_current;
+        };
+
+        // Count exports first to allocate exactly.
+        std::size_t num_export = 0;
+        Kokkos::parallel_reduce(
+            "CabanaPD::Comm::countGhosts", policy,
+            KOKKOS_LAMBDA( const int p, std::size_t& count ) {
+                for ( int r = 0; r < num_ranks; r++ )
+                    if ( export_to( p, r ) )
+                        count++;
+            },
+            num_export );
+        Kokkos::View<int*, memory_space> ids(
+            Kokkos::ViewAllocateWithoutInitializing( "halo_ids" ),
+            num_export );
+        Kokkos::View<int*, memory_space> destinations(
+            Kokkos::ViewAllocateWithoutInitializing( "halo_destinations" ),
+            num_export );
+        Kokkos::View<int, memory_space> counter( "halo_count" );
+        Kokkos::parallel_for(
+            "CabanaPD::Comm::fillGhosts", policy,
+            KOKKOS_LAMBDA( const int p ) {
+                for ( int r = 0; r < num_ranks; r++ )
+                    if ( export_to( p, r ) )
+                    {
+                        const int c = Kokkos::atomic_fetch_add( &counter(), 1 );
+                        ids( c ) = p;
+                        destinations( c ) = r;
+                    }
+            } );
+        Kokkos::fence();
+
+        halo = std::make_shared<halo_type>(
+            particles.local_grid->globalGrid().comm(), num_local, ids,
+            destinations );
+        setupHalo( particles );
+        _timer.stop();
+    }
+
+    // Store displacements of the local particles at the last migration.
+    void resetMigrationReference( ParticleType& particles )
+    {
+        auto u = particles.sliceDisplacement();
+        _u_ref = Kokkos::View<double* [3], memory_space>(
+            Kokkos::ViewAllocateWithoutInitializing( "migration_reference" ),
+            particles.localOffset() );
+        auto u_ref = _u_ref;
+        using exec_space = typename memory_space::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( 0, particles.localOffset() );
+        Kokkos::parallel_for(
+            "CabanaPD::Comm::migrationReference", policy,
+            KOKKOS_LAMBDA( const int p ) {
+                for ( int d = 0; d < dim; d++ )
+                    u_ref( p, d ) = u( p, d );
+            } );
+        Kokkos::fence();
+    }
+
+    // Largest displacement on any rank since the last migration.
+    double maxDisplacementSinceMigration( ParticleType& particles )
+    {
+        _timer.start();
+        auto u = particles.sliceDisplacement();
+        auto u_ref = _u_ref;
+        double max_du2 = 0.0;
+        using exec_space = typename memory_space::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( 0, particles.localOffset() );
+        Kokkos::parallel_reduce(
+            "CabanaPD::Comm::migrationDisplacement", policy,
+            KOKKOS_LAMBDA( const int p, double& max_val ) {
+                double du2 = 0.0;
+                for ( int d = 0; d < dim; d++ )
+                {
+                    const double du = u( p, d ) - u_ref( p, d );
+                    du2 += du * du;
+                }
+                if ( du2 > max_val )
+                    max_val = du2;
+            },
+            Kokkos::Max<double>( max_du2 ) );
+        MPI_Allreduce( MPI_IN_PLACE, &max_du2, 1, MPI_DOUBLE, MPI_MAX,
+                       particles.local_grid->globalGrid().comm() );
+        _timer.stop();
+        return std::sqrt( max_du2 );
+    }
+
+    // Determine which particles should be ghosted.
     template <class LocalGridType, class PositionSliceType>
     auto createHaloIds( const LocalGridType& local_grid,
                         const PositionSliceType& positions,
-                        const int min_halo_width, const int max_export )
+                        const double cutoff )
     {
         return HaloIds<typename PositionSliceType::memory_space, LocalGridType>(
-            local_grid, positions, min_halo_width, max_export );
+            local_grid, positions, cutoff );
     }
 
     // We assume here that the particle count has not changed and no resize
-    // is necessary.
+    // is necessary. Gathers are skipped if the owned values have not changed
+    // since the last gather.
     void gatherDisplacement()
     {
-        _timer.start();
+        if ( skipGather( DisplacementField{} ) )
+            return;
+        _gather_u_timer.start();
         gather_u->apply();
-        _timer.stop();
+        _gather_u_timer.addBytes( gather_u->sendBytes() );
+        _gather_u_timer.stop();
     }
+    // Split gather: post messages, then later wait and update ghosts.
+    void startGatherDisplacement()
+    {
+        if ( !startGather( DisplacementField{} ) )
+            return;
+        _gather_u_timer.start();
+        gather_u->start();
+        _gather_u_timer.addBytes( gather_u->sendBytes() );
+        _gather_u_timer.stop();
+    }
+    void finishGatherDisplacement()
+    {
+        if ( !finishGather( DisplacementField{} ) )
+            return;
+        _gather_u_timer.start();
+        gather_u->finish();
+        _gather_u_timer.stop();
+    }
+
+    // Gather all of the given fields which changed since their last gather in
+    // a single message per neighbor rank. Fields without ghosts for this
+    // model (e.g. dilatation for PMB) are ignored.
+    template <class... FieldTags>
+    void gatherFields( FieldTags... tags )
+    {
+        gather_fused->clear();
+        ( addFusedGather( tags ), ... );
+        if ( gather_fused->empty() )
+            return;
+        _gather_fused_timer.start();
+        gather_fused->apply();
+        _gather_fused_timer.addBytes( gather_fused->sendBytes() );
+        _gather_fused_timer.stop();
+    }
+
+    // Number of gathers skipped because the field had not changed.
+    auto numSkippedGathers() const { return _num_skipped_gathers; }
     // No-op to make solvers simpler.
     void gatherDilatation() {}
     void gatherWeightedVolume() {}
+    void startGatherDilatation() {}
+    void finishGatherDilatation() {}
+    void startGatherWeightedVolume() {}
+    void finishGatherWeightedVolume() {}
+
+    // Sum ghost force contributions into the owning ranks (only needed for
+    // half neighbor lists).
+    void scatterForce()
+    {
+        _scatter_timer.start();
+        scatter_f->apply();
+        _scatter_timer.addBytes( ghostBytes<force_slice_type>( dim ) );
+        _scatter_timer.stop();
+    }
+
+    // Sum ghost energy and damage contributions into the owning ranks (only
+    // needed for half neighbor lists). Only called on output steps.
+    void scatterEnergy( ParticleType& particles )
+    {
+        if constexpr ( is_energy_output<
+                           typename ParticleType::output_type>::value )
+        {
+            _scatter_timer.start();
+            auto W = particles.sliceStrainEnergy();
+            Cabana::scatter( *halo, W );
+            auto phi = particles.sliceDamage();
+            Cabana::scatter( *halo, phi );
+            auto vol_H = particles.sliceNeighborVolume();
+            Cabana::scatter( *halo, vol_H );
+            _scatter_timer.addBytes( ghostBytes<decltype( W )>( 1 ) +
+                                     ghostBytes<decltype( phi )>( 1 ) +
+                                     ghostBytes<decltype( vol_H )>( 1 ) );
+            _scatter_timer.stop();
+        }
+    }
 
     auto timeInit() { return _init_timer.time(); };
-    auto time() { return _timer.time(); };
+    auto time()
+    {
+        return _timer.time() + _gather_u_timer.time() +
+               _gather_m_timer.time() + _gather_theta_timer.time() +
+               _gather_temp_timer.time() + _gather_fused_timer.time() +
+               _scatter_timer.time();
+    };
+
+    void profile( TimerRegistry& timers ) const
+    {
+        timers.add( "Comm::Init", _init_timer );
+        timers.add( "Comm::Migrate", _timer );
+        timers.add( "Comm::GatherDisplacement", _gather_u_timer );
+        timers.add( "Comm::GatherFused", _gather_fused_timer );
+        timers.add( "Comm::Scatter", _scatter_timer );
+    }
+
+    // Collective: halo exchange options and the maximum number of neighbor
+    // ranks on the same node and on other nodes. Written from rank 0.
+    template <class StreamType>
+    void haloReport( StreamType& out ) const
+    {
+        auto comm = halo->comm();
+        MPI_Comm node_comm;
+        MPI_Comm_split_type( comm, MPI_COMM_TYPE_SHARED, mpi_rank,
+                             MPI_INFO_NULL, &node_comm );
+        MPI_Group group;
+        MPI_Group node_group;
+        MPI_Comm_group( comm, &group );
+        MPI_Comm_group( node_comm, &node_group );
+        const int num_n = halo->numNeighbor();
+        std::vector<int> ranks( num_n );
+        std::vector<int> node_ranks( num_n );
+        for ( int n = 0; n < num_n; ++n )
+            ranks[n] = halo->neighborRank( n );
+        MPI_Group_translate_ranks( group, num_n, ranks.data(), node_group,
+                                   node_ranks.data() );
+        MPI_Group_free( &group );
+        MPI_Group_free( &node_group );
+        MPI_Comm_free( &node_comm );
+
+        int counts[2] = { 0, 0 };
+        for ( int n = 0; n < num_n; ++n )
+        {
+            if ( ranks[n] == mpi_rank )
+                continue;
+            if ( node_ranks[n] != MPI_UNDEFINED )
+                counts[0]++;
+            else
+                counts[1]++;
+        }
+        int max_counts[2] = { 0, 0 };
+        MPI_Reduce( counts, max_counts, 2, MPI_INT, MPI_MAX, 0, comm );
+
+        std::string mode = "host";
+        if ( !gather_u_type::messages_type::host_memory )
+            mode = _halo_options.gpu_aware_mpi ? "gpu-aware" : "host-staged";
+        log( out, "Halo-Exchange: ", mode, ", Persistent-Requests: ",
+             _halo_options.persistent_requests,
+             ", Node-Shared: ", _halo_options.node_shared,
+             ", Max-On-Node-Neighbors: ", max_counts[0],
+             ", Max-Off-Node-Neighbors: ", max_counts[1] );
+    }
+
+    // Halo steering and communication buffers. The scatter buffers are
+    // internal to Cabana and estimated from the import and export counts.
+    void memory( MemoryRegistry& registry ) const
+    {
+        registry.add( "Comm::HaloSteering",
+                      viewBytes( halo->getExportSteering() ) );
+        registry.add( "Comm::GatherDisplacement", gather_u->bufferBytes() );
+        registry.add( "Comm::GatherFused", gather_fused->bufferBytes() );
+        registry.add( "Comm::Scatter",
+                      static_cast<double>( halo->totalNumImport() +
+                                           halo->totalNumExport() ) *
+                          dim * sizeof( double ) );
+    }
 
   protected:
-    Timer _init_timer;
-    Timer _timer;
+    // Bytes sent back to the owning ranks for the ghost values of one slice.
+    template <class SliceType>
+    double ghostBytes( const int num_components ) const
+    {
+        return static_cast<double>( halo->totalNumImport() * num_components *
+                                    sizeof( typename SliceType::value_type ) );
+    }
+
+    // Whether a gather can be skipped because the owned values have not
+    // changed since the last one. Otherwise the field is marked as gathered.
+    template <class FieldTag>
+    bool skipGather( FieldTag tag )
+    {
+        const auto version = ( *_versions )( tag );
+        if ( _gathered[FieldTag::index] == version )
+        {
+            _num_skipped_gathers++;
+            return true;
+        }
+        _gathered[FieldTag::index] = version;
+        return false;
+    }
+    // Whether a split gather is posted (and therefore must be finished).
+    template <class FieldTag>
+    bool startGather( FieldTag tag )
+    {
+        _in_flight[FieldTag::index] = !skipGather( tag );
+        return _in_flight[FieldTag::index];
+    }
+    template <class FieldTag>
+    bool finishGather( FieldTag )
+    {
+        const bool in_flight = _in_flight[FieldTag::index];
+        _in_flight[FieldTag::index] = false;
+        return in_flight;
+    }
+    template <class FieldTag>
+    void markGathered( FieldTag tag )
+    {
+        _gathered[FieldTag::index] = ( *_versions )( tag );
+    }
+
+    template <class FieldTag>
+    void addFusedGather( FieldTag tag )
+    {
+        auto& add = _add_fused[FieldTag::index];
+        if ( add && !skipGather( tag ) )
+            add( *gather_fused );
+    }
+
+    // Size particles for the current halo, communicate the fixed ghost data,
+    // and create the persistent gathers.
+    void setupHalo( ParticleType& particles )
+    {
+        particles.resize( halo->numLocal(), halo->numGhost() );
+        // All ghosts are new.
+        _gathered.fill( 0 );
+        _in_flight.fill( false );
+
+        // Only use this interface because we don't need to recommunicate
+        // positions, volumes, or no-fail region.
+        Cabana::gather( *halo, particles.getReferencePosition().aosoa() );
+        Cabana::gather( *halo, particles._aosoa_vol );
+
+        gather_u = std::make_shared<gather_u_type>(
+            *halo, particles._aosoa_u, gather_u_tag, _halo_options );
+        gather_u->apply();
+        markGathered( DisplacementField{} );
+        gather_fused = std::make_shared<fused_gather_type>(
+            *halo, gather_fused_tag, _halo_options );
+        _add_fused[DisplacementField::index] =
+            [this]( fused_gather_type& fused ) { fused.add( *gather_u ); };
+
+        // Ghost forces only exist with half neighbor lists.
+        if ( particles.halfNeighbors() )
+            scatter_f = std::make_shared<scatter_f_type>(
+                *halo, particles.sliceForce() );
+        else
+            scatter_f.reset();
+    }
+
+    // Distinct tags so that split gathers can be in flight at the same time.
+    static constexpr int gather_u_tag = 2401;
+    static constexpr int gather_m_tag = 2402;
+    static constexpr int gather_theta_tag = 2403;
+    static constexpr int migrate_tag = 2404;
+    static constexpr int gather_temp_tag = 2405;
+    static constexpr int gather_fused_tag = 2406;
+
+    // Versions of the owned fields (shared with the particles) and of the
+    // ghosts as last gathered.
+    std::shared_ptr<FieldVersions> _versions;
+    std::array<std::size_t, FieldVersions::num_fields> _gathered = {};
+    std::array<bool, FieldVersions::num_fields> _in_flight = {};
+    std::array<std::function<void( fused_gather_type& )>,
+               FieldVersions::num_fields>
+        _add_fused;
+    std::size_t _num_skipped_gathers = 0;
+    HaloOptions _halo_options;
+
+    Kokkos::View<double* [3], memory_space> _u_ref;
+
+    Timer _init_timer = Timer( "Comm::Init" );
+    Timer _timer = Timer( "Comm::Migrate" );
+    Timer _gather_u_timer = Timer( "Comm::GatherDisplacement" );
+    Timer _gather_m_timer = Timer( "Comm::GatherWeightedVolume" );
+    Timer _gather_theta_timer = Timer( "Comm::GatherDilatation" );
+    Timer _gather_temp_timer = Timer( "Comm::GatherTemperature" );
+    Timer _gather_fused_timer = Timer( "Comm::GatherFused" );
+    Timer _scatter_timer = Timer( "Comm::Scatter" );
 };
 
 template <class ParticleType>
@@ -332,41 +1661,123 @@ class Comm<ParticleType, LPS, TemperatureIndependent>
     using base_type::gather_u;
     using base_type::halo;
 
+    using base_type::_add_fused;
+    using base_type::_gather_m_timer;
+    using base_type::_halo_options;
+    using base_type::_gather_theta_timer;
     using base_type::_init_timer;
-    using base_type::_timer;
+    using base_type::finishGather;
+    using base_type::gather_m_tag;
+    using base_type::gather_theta_tag;
+    using base_type::skipGather;
+    using base_type::startGather;
+    using fused_gather_type = typename base_type::fused_gather_type;
 
     using gather_m_type =
-        Cabana::Gather<halo_type, typename ParticleType::aosoa_m_type>;
+        HaloGather<halo_type, typename ParticleType::aosoa_m_type>;
     using gather_theta_type =
-        Cabana::Gather<halo_type, typename ParticleType::aosoa_theta_type>;
+        HaloGather<halo_type, typename ParticleType::aosoa_theta_type>;
     std::shared_ptr<gather_m_type> gather_m;
     std::shared_ptr<gather_theta_type> gather_theta;
 
-    Comm( ParticleType& particles, int max_export_guess = 100 )
-        : base_type( particles, max_export_guess )
+    Comm( ParticleType& particles, const double cutoff = 0.0,
+          const HaloOptions& options = HaloOptions{} )
+        : base_type( particles, cutoff, options )
     {
         _init_timer.start();
 
-        gather_m = std::make_shared<gather_m_type>( *halo, particles._aosoa_m );
-        gather_theta = std::make_shared<gather_theta_type>(
-            *halo, particles._aosoa_theta );
+        createGathers( particles );
 
         particles.resize( halo->numLocal(), halo->numGhost() );
         _init_timer.stop();
     }
     ~Comm() {}
 
+    void rebuildHalo( ParticleType& particles, const double reference_cutoff,
+                      const double current_cutoff = 0.0 )
+    {
+        base_type::rebuildHalo( particles, reference_cutoff, current_cutoff );
+        createGathers( particles );
+    }
+
+    void profile( TimerRegistry& timers ) const
+    {
+        base_type::profile( timers );
+        timers.add( "Comm::GatherWeightedVolume", _gather_m_timer );
+        timers.add( "Comm::GatherDilatation", _gather_theta_timer );
+    }
+
+    void memory( MemoryRegistry& registry ) const
+    {
+        base_type::memory( registry );
+        registry.add( "Comm::GatherWeightedVolume", gather_m->bufferBytes() );
+        registry.add( "Comm::GatherDilatation", gather_theta->bufferBytes() );
+    }
+
     void gatherDilatation()
     {
-        _timer.start();
+        if ( skipGather( DilatationField{} ) )
+            return;
+        _gather_theta_timer.start();
         gather_theta->apply();
-        _timer.stop();
+        _gather_theta_timer.addBytes( gather_theta->sendBytes() );
+        _gather_theta_timer.stop();
     }
     void gatherWeightedVolume()
     {
-        _timer.start();
+        if ( skipGather( WeightedVolumeField{} ) )
+            return;
+        _gather_m_timer.start();
         gather_m->apply();
-        _timer.stop();
+        _gather_m_timer.addBytes( gather_m->sendBytes() );
+        _gather_m_timer.stop();
+    }
+    void startGatherDilatation()
+    {
+        if ( !startGather( DilatationField{} ) )
+            return;
+        _gather_theta_timer.start();
+        gather_theta->start();
+        _gather_theta_timer.addBytes( gather_theta->sendBytes() );
+        _gather_theta_timer.stop();
+    }
+    void finishGatherDilatation()
+    {
+        if ( !finishGather( DilatationField{} ) )
+            return;
+        _gather_theta_timer.start();
+        gather_theta->finish();
+        _gather_theta_timer.stop();
+    }
+    void startGatherWeightedVolume()
+    {
+        if ( !startGather( WeightedVolumeField{} ) )
+            return;
+        _gather_m_timer.start();
+        gather_m->start();
+        _gather_m_timer.addBytes( gather_m->sendBytes() );
+        _gather_m_timer.stop();
+    }
+    void finishGatherWeightedVolume()
+    {
+        if ( !finishGather( WeightedVolumeField{} ) )
+            return;
+        _gather_m_timer.start();
+        gather_m->finish();
+        _gather_m_timer.stop();
+    }
+
+  protected:
+    void createGathers( ParticleType& particles )
+    {
+        gather_m = std::make_shared<gather_m_type>(
+            *halo, particles._aosoa_m, gather_m_tag, _halo_options );
+        gather_theta = std::make_shared<gather_theta_type>(
+            *halo, particles._aosoa_theta, gather_theta_tag, _halo_options );
+        _add_fused[WeightedVolumeField::index] =
+            [this]( fused_gather_type& fused ) { fused.add( *gather_m ); };
+        _add_fused[DilatationField::index] = [this]( fused_gather_type& fused )
+        { fused.add( *gather_theta ); };
     }
 };
 
@@ -378,21 +1789,66 @@ class Comm<ParticleType, PMB, TemperatureDependent>
     using base_type = Comm<ParticleType, PMB, TemperatureIndependent>;
     using memory_space = typename base_type::memory_space;
     using halo_type = typename base_type::halo_type;
+    using base_type::_add_fused;
+    using base_type::_gather_temp_timer;
+    using base_type::_halo_options;
+    using base_type::gather_temp_tag;
     using base_type::halo;
+    using base_type::markGathered;
+    using base_type::skipGather;
+    using fused_gather_type = typename base_type::fused_gather_type;
 
     using gather_temp_type =
-        Cabana::Gather<halo_type, typename ParticleType::aosoa_temp_type>;
+        HaloGather<halo_type, typename ParticleType::aosoa_temp_type>;
     std::shared_ptr<gather_temp_type> gather_temp;
 
-    Comm( ParticleType& particles, int max_export_guess = 100 )
-        : base_type( particles, max_export_guess )
+    Comm( ParticleType& particles, const double cutoff = 0.0,
+          const HaloOptions& options = HaloOptions{} )
+        : base_type( particles, cutoff, options )
     {
-        gather_temp =
-            std::make_shared<gather_temp_type>( *halo, particles._aosoa_temp );
+        createGathers( particles );
         particles.resize( halo->numLocal(), halo->numGhost() );
     }
 
-    void gatherTemperature() { gather_temp->apply(); }
+    void rebuildHalo( ParticleType& particles, const double reference_cutoff,
+                      const double current_cutoff = 0.0 )
+    {
+        base_type::rebuildHalo( particles, reference_cutoff, current_cutoff );
+        createGathers( particles );
+        gather_temp->apply();
+        markGathered( TemperatureField{} );
+    }
+
+    void gatherTemperature()
+    {
+        if ( skipGather( TemperatureField{} ) )
+            return;
+        _gather_temp_timer.start();
+        gather_temp->apply();
+        _gather_temp_timer.addBytes( gather_temp->sendBytes() );
+        _gather_temp_timer.stop();
+    }
+
+    void profile( TimerRegistry& timers ) const
+    {
+        base_type::profile( timers );
+        timers.add( "Comm::GatherTemperature", _gather_temp_timer );
+    }
+
+    void memory( MemoryRegistry& registry ) const
+    {
+        base_type::memory( registry );
+        registry.add( "Comm::GatherTemperature", gather_temp->bufferBytes() );
+    }
+
+  protected:
+    void createGathers( ParticleType& particles )
+    {
+        gather_temp = std::make_shared<gather_temp_type>(
+            *halo, particles._aosoa_temp, gather_temp_tag, _halo_options );
+        _add_fused[TemperatureField::index] =
+            [this]( fused_gather_type& fused ) { fused.add( *gather_temp ); };
+    }
 };
 
 } // namespace CabanaPD
@@ -0,0 +1,633 @@
+/****************************************************************************
+ * Copyright (c) 2022 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of CabanaPD. CabanaPD is distributed under a           *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <array>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <mpi.h>
+
+#include <Kokkos_Core.hpp>
+
+#include <Cabana_Core.hpp>
+
+#include <CabanaPD_Boundary.hpp>
+#include <CabanaPD_Fields.hpp>
+#include <CabanaPD_Timer.hpp>
+#include <CabanaPD_Types.hpp>
+
+namespace CabanaPD
+{
+/******************************************************************************
+  In-situ diagnostics.
+
+  Profiles are binned on device into fixed cells and reduced to rank 0, and
+  global monitors are reduced in a single kernel and a single reduction per
+  operation, such that only rank 0 touches the file system.
+******************************************************************************/
+
+// Given a dimension, returns the other two (the other one twice in 2d)
+inline auto getDim( const int dim, const int num_space_dim = 3 )
+{
+    Kokkos::Array<int, 2> orthogonal;
+    orthogonal[0] = ( dim + 1 ) % num_space_dim;
+    orthogonal[1] = ( dim + num_space_dim - 1 ) % num_space_dim;
+    return orthogonal;
+}
+
+// Average of a profile value within one bin.
+struct ProfileBin
+{
+    double center;
+    double value;
+    int count;
+};
+
+// Bin a per-particle value along one dimension over the particles on the
+// line through the origin (within half a cell in the other dimensions).
+// Bins evenly divide the global domain. The result is only valid on rank 0,
+// where empty bins are included with zero count.
+template <typename ParticleType, typename UserFunctor>
+std::vector<ProfileBin>
+binProfile( MPI_Comm comm, const int num_bins, const int profile_dim,
+            const ParticleType& particles, UserFunctor user,
+            const bool include_frozen = true )
+{
+    using memory_space = typename ParticleType::memory_space;
+    using exec_space = typename memory_space::execution_space;
+
+    // Bin sums and counts in one View such that one reduction suffices. The
+    // layout is fixed such that the sum and count of each bin are adjacent on
+    // every memory space.
+    Kokkos::View<double* [2], Kokkos::LayoutRight, memory_space> bins(
+        "profile_bins", num_bins );
+
+    auto orthogonal = getDim( profile_dim, ParticleType::dim );
+    const double dx1 = particles.dx[orthogonal[0]];
+    const double dx2 = particles.dx[orthogonal[1]];
+    const double low =
+        particles.local_grid->globalGrid().globalMesh().lowCorner(
+            profile_dim );
+    const double bin_width = particles.global_mesh_ext[profile_dim] / num_bins;
+
+    auto x = particles.sliceReferencePosition();
+    auto bin_profile = KOKKOS_LAMBDA( const int pid )
+    {
+        if ( x( pid, orthogonal[0] ) < dx1 / 2.0 &&
+             x( pid, orthogonal[0] ) > -dx1 / 2.0 &&
+             x( pid, orthogonal[1] ) < dx2 / 2.0 &&
+             x( pid, orthogonal[1] ) > -dx2 / 2.0 )
+        {
+            const int b = static_cast<int>(
+                Kokkos::floor( ( x( pid, profile_dim ) - low ) / bin_width ) );
+            if ( b < 0 || b >= num_bins )
+                return;
+            Kokkos::atomic_add( &bins( b, 0 ), user( pid ) );
+            Kokkos::atomic_add( &bins( b, 1 ), 1.0 );
+        }
+    };
+    const std::size_t begin = include_frozen ? 0 : particles.frozenOffset();
+    Kokkos::RangePolicy<exec_space> policy( begin, particles.localOffset() );
+    Kokkos::parallel_for( "CabanaPD::Diagnostics::binProfile", policy,
+                          bin_profile );
+
+    auto bins_host =
+        Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace{}, bins );
+    std::vector<double> local( bins_host.data(),
+                               bins_host.data() + 2 * num_bins );
+    std::vector<double> global( 2 * num_bins );
+    MPI_Reduce( local.data(), global.data(), 2 * num_bins, MPI_DOUBLE,
+                MPI_SUM, 0, comm );
+
+    int mpi_rank;
+    MPI_Comm_rank( comm, &mpi_rank );
+    std::vector<ProfileBin> profile;
+    if ( mpi_rank > 0 )
+        return profile;
+
+    // Sums and counts are interleaved (LayoutRight).
+    profile.resize( num_bins );
+    for ( int b = 0; b < num_bins; b++ )
+    {
+        const double count = global[2 * b + 1];
+        profile[b].center = low + ( b + 0.5 ) * bin_width;
+        profile[b].value = count > 0.0 ? global[2 * b] / count : 0.0;
+        profile[b].count = static_cast<int>( count );
+    }
+    return profile;
+}
+
+// Placeholder for particles without damage output.
+struct NoMonitorDamage
+{
+};
+
+// Global monitor values of the owned particles, reduced in one kernel: the
+// leading maxima (damage and crack tip position) followed by the sums
+// (kinetic energy and reaction force components for each region).
+template <class PositionType, class DisplacementType, class VelocityType,
+          class ForceType, class DensityType, class VolumeType,
+          class DamageType, class RegionViewType>
+struct GlobalMonitorReduce
+{
+    using value_type = double[];
+    using size_type = std::size_t;
+
+    static constexpr int num_max = 2;
+    static constexpr bool has_damage =
+        !std::is_same<DamageType, NoMonitorDamage>::value;
+    static constexpr int dim = vector_dim<PositionType>::value;
+
+    size_type value_count;
+
+    PositionType x;
+    DisplacementType u;
+    VelocityType v;
+    ForceType f;
+    DensityType rho;
+    VolumeType vol;
+    DamageType phi;
+    // Rectangular region bounds: low then high for each dimension.
+    RegionViewType regions;
+    int crack_axis;
+    double crack_damage;
+
+    GlobalMonitorReduce( const PositionType& _x, const DisplacementType& _u,
+                         const VelocityType& _v, const ForceType& _f,
+                         const DensityType& _rho, const VolumeType& _vol,
+                         const DamageType& _phi, const RegionViewType& _regions,
+                         const int _crack_axis, const double _crack_damage )
+        : value_count( num_max + 1 + 3 * _regions.extent( 0 ) )
+        , x( _x )
+        , u( _u )
+        , v( _v )
+        , f( _f )
+        , rho( _rho )
+        , vol( _vol )
+        , phi( _phi )
+        , regions( _regions )
+        , crack_axis( _crack_axis )
+        , crack_damage( _crack_damage )
+    {
+    }
+
+    KOKKOS_INLINE_FUNCTION void operator()( const int i,
+                                            value_type values ) const
+    {
+        if constexpr ( has_damage )
+        {
+            values[0] = Kokkos::max( values[0], double( phi( i ) ) );
+            if ( phi( i ) >= crack_damage )
+                values[1] = Kokkos::max(
+                    values[1], x( i, crack_axis ) + u( i, crack_axis ) );
+        }
+
+        double v2 = 0.0;
+        for ( int d = 0; d < dim; d++ )
+            v2 += v( i, d ) * v( i, d );
+        values[num_max] += 0.5 * rho( i ) * vol( i ) * v2;
+
+        for ( size_type r = 0; r < regions.extent( 0 ); r++ )
+        {
+            bool inside = true;
+            for ( int d = 0; d < dim; d++ )
+                inside = inside && x( i, d ) >= regions( r, 2 * d ) &&
+                         x( i, d ) <= regions( r, 2 * d + 1 );
+            if ( inside )
+            {
+                values[num_max + 1 + 3 * r] += f( i, 0 );
+                values[num_max + 2 + 3 * r] += f( i, 1 );
+                values[num_max + 3 + 3 * r] += component<2>( f, i );
+            }
+        }
+    }
+
+    KOKKOS_INLINE_FUNCTION void join( value_type dst,
+                                      const value_type src ) const
+    {
+        for ( int n = 0; n < num_max; n++ )
+            dst[n] = Kokkos::max( dst[n], src[n] );
+        for ( size_type n = num_max; n < value_count; n++ )
+            dst[n] += src[n];
+    }
+
+    KOKKOS_INLINE_FUNCTION void init( value_type values ) const
+    {
+        for ( int n = 0; n < num_max; n++ )
+            values[n] = Kokkos::reduction_identity<double>::max();
+        for ( size_type n = num_max; n < value_count; n++ )
+            values[n] = 0.0;
+    }
+};
+
+/******************************************************************************
+  Global monitors: maximum damage, crack tip position (furthest current
+  position along an axis of particles with at least the given damage),
+  kinetic energy, and reaction forces (total internal force) within
+  rectangular regions, typically those with applied boundary conditions.
+
+  Damage is only updated with the strain energy (output steps) and is only
+  available with energy output particles. Values are only valid on rank 0.
+******************************************************************************/
+template <class MemorySpace>
+class GlobalMonitors
+{
+  public:
+    using memory_space = MemorySpace;
+    using region_view_type = Kokkos::View<double* [6], memory_space>;
+
+    GlobalMonitors( const std::string file_name, const int crack_axis = 0,
+                    const double crack_damage = 0.5 )
+        : _file_name( file_name )
+        , _crack_axis( crack_axis )
+        , _crack_damage( crack_damage )
+        , _regions( "monitor_regions", 0 )
+    {
+        MPI_Comm_rank( MPI_COMM_WORLD, &_mpi_rank );
+    }
+
+    // Monitor the reaction force within a region.
+    void addReactionRegion( const RegionBoundary<RectangularPrism>& region )
+    {
+        _host_regions.push_back( { region.low_x, region.high_x, region.low_y,
+                                   region.high_y, region.low_z,
+                                   region.high_z } );
+        Kokkos::resize( _regions, _host_regions.size() );
+        auto regions_host = Kokkos::create_mirror_view( _regions );
+        for ( std::size_t r = 0; r < _host_regions.size(); r++ )
+            for ( int n = 0; n < 6; n++ )
+                regions_host( r, n ) = _host_regions[r][n];
+        Kokkos::deep_copy( _regions, regions_host );
+    }
+
+    std::size_t numReactionRegions() const { return _host_regions.size(); }
+
+    // Reduce all monitors over the owned particles (collective).
+    template <class ExecSpace, class ParticleType>
+    void compute( const ExecSpace&, ParticleType& particles )
+    {
+        _timer.start();
+        auto x = particles.sliceReferencePosition();
+        auto u = particles.sliceDisplacement();
+        auto v = particles.sliceVelocity();
+        auto f = particles.sliceForce();
+        auto rho = particles.sliceDensity();
+        auto vol = particles.sliceVolume();
+        auto reduce = [&]( const auto& phi )
+        {
+            using damage_type = std::decay_t<decltype( phi )>;
+            GlobalMonitorReduce<decltype( x ), decltype( u ), decltype( v ),
+                                decltype( f ), decltype( rho ),
+                                decltype( vol ), damage_type, region_view_type>
+                functor( x, u, v, f, rho, vol, phi, _regions, _crack_axis,
+                         _crack_damage );
+            std::vector<double> local( functor.value_count );
+            Kokkos::RangePolicy<ExecSpace> policy( particles.frozenOffset(),
+                                                   particles.localOffset() );
+            Kokkos::parallel_reduce( "CabanaPD::Diagnostics::monitors",
+                                     policy, functor, local.data() );
+            return local;
+        };
+        std::vector<double> local;
+        if constexpr ( is_energy_output<
+                           typename ParticleType::output_type>::value )
+            local = reduce( particles.sliceDamage() );
+        else
+            local = reduce( NoMonitorDamage{} );
+
+        // One reduction for each operation.
+        constexpr int num_max = 2;
+        const int num_sum = local.size() - num_max;
+        _values.resize( local.size() );
+        MPI_Reduce( local.data(), _values.data(), num_max, MPI_DOUBLE, MPI_MAX,
+                    0, MPI_COMM_WORLD );
+        MPI_Reduce( local.data() + num_max, _values.data() + num_max, num_sum,
+                    MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD );
+        _timer.stop();
+    }
+
+    double maxDamage() const { return valid( _values[0] ); }
+    // NaN if no particle has the crack damage.
+    double crackTip() const { return valid( _values[1] ); }
+    double kineticEnergy() const { return _values[2]; }
+    std::array<double, 3> reactionForce( const std::size_t r ) const
+    {
+        return { _values[3 + 3 * r], _values[4 + 3 * r], _values[5 + 3 * r] };
+    }
+
+    // Append the most recent values (rank 0 only).
+    void write( const int step, const double time )
+    {
+        if ( _mpi_rank > 0 )
+            return;
+
+        std::ofstream out( _file_name, std::ofstream::app );
+        if ( !_header_written )
+        {
+            out << "#Step Time Max-damage Crack-tip Kinetic-energy";
+            for ( std::size_t r = 0; r < numReactionRegions(); r++ )
+                out << " Reaction-" << r << "-x Reaction-" << r
+                    << "-y Reaction-" << r << "-z";
+            out << "\n";
+            _header_written = true;
+        }
+        out << step << " " << std::scientific << time << " " << maxDamage()
+            << " " << crackTip() << " " << kineticEnergy();
+        for ( std::size_t r = 0; r < numReactionRegions(); r++ )
+        {
+            auto reaction = reactionForce( r );
+            out << " " << reaction[0] << " " << reaction[1] << " "
+                << reaction[2];
+        }
+        out << "\n";
+    }
+
+    auto time() { return _timer.time(); };
+    void profile( TimerRegistry& timers ) const
+    {
+        timers.add( "Diagnostics::Monitors", _timer );
+    }
+
+  protected:
+    // Maxima without any contributing particle are reported as NaN.
+    static double valid( const double value )
+    {
+        if ( value == Kokkos::reduction_identity<double>::max() )
+            return std::numeric_limits<double>::quiet_NaN();
+        return value;
+    }
+
+    std::string _file_name;
+    int _crack_axis;
+    double _crack_damage;
+    int _mpi_rank = 0;
+    bool _header_written = false;
+    std::vector<std::array<double, 6>> _host_regions;
+    region_view_type _regions;
+    std::vector<double> _values = std::vector<double>( 3, 0.0 );
+    Timer _timer = Timer( "Diagnostics::Monitors" );
+};
+
+// Global energy and damage of the owned particles, reduced in one kernel:
+// maximum damage followed by the sums (strain energy, kinetic energy, and
+// damaged volume).
+template <class EnergyType, class VelocityType, class DensityType,
+          class VolumeType, class DamageType>
+struct GlobalDiagnosticsReduce
+{
+    using value_type = double[];
+    using size_type = std::size_t;
+
+    static constexpr int num_max = 1;
+    static constexpr bool has_damage =
+        !std::is_same<DamageType, NoMonitorDamage>::value;
+    static constexpr int dim = vector_dim<VelocityType>::value;
+
+    size_type value_count = 4;
+
+    EnergyType W;
+    VelocityType v;
+    DensityType rho;
+    VolumeType vol;
+    DamageType phi;
+    double damage_threshold;
+
+    GlobalDiagnosticsReduce( const EnergyType& _W, const VelocityType& _v,
+                             const DensityType& _rho, const VolumeType& _vol,
+                             const DamageType& _phi,
+                             const double _damage_threshold )
+        : W( _W )
+        , v( _v )
+        , rho( _rho )
+        , vol( _vol )
+        , phi( _phi )
+        , damage_threshold( _damage_threshold )
+    {
+    }
+
+    KOKKOS_INLINE_FUNCTION void operator()( const int i,
+                                            value_type values ) const
+    {
+        if constexpr ( has_damage )
+        {
+            values[0] = Kokkos::max( values[0], double( phi( i ) ) );
+            values[1] += W( i ) * vol( i );
+            if ( phi( i ) >= damage_threshold )
+                values[3] += vol( i );
+        }
+
+        double v2 = 0.0;
+        for ( int d = 0; d < dim; d++ )
+            v2 += v( i, d ) * v( i, d );
+        values[2] += 0.5 * rho( i ) * vol( i ) * v2;
+    }
+
+    KOKKOS_INLINE_FUNCTION void join( value_type dst,
+                                      const value_type src ) const
+    {
+        dst[0] = Kokkos::max( dst[0], src[0] );
+        for ( size_type n = num_max; n < value_count; n++ )
+            dst[n] += src[n];
+    }
+
+    KOKKOS_INLINE_FUNCTION void init( value_type values ) const
+    {
+        values[0] = Kokkos::reduction_identity<double>::max();
+        for ( size_type n = num_max; n < value_count; n++ )
+            values[n] = 0.0;
+    }
+};
+
+/******************************************************************************
+  Global diagnostics: total strain energy, kinetic energy, damaged volume
+  (particles with at least the given damage), and maximum damage.
+
+  The rank-local values are reduced on device into a resident View, and the
+  global reduction is posted with MPI_Iallreduce such that it completes in
+  the background of the following steps. Values are therefore those of the
+  previous start() (NaN before the first completes) and are valid on all
+  ranks. Strain energy and damage are only available with energy output
+  particles and are only current on output steps.
+******************************************************************************/
+template <class MemorySpace>
+class GlobalDiagnostics
+{
+  public:
+    using memory_space = MemorySpace;
+    using view_type = Kokkos::View<double*, memory_space>;
+    using host_view_type = Kokkos::View<double*, Kokkos::HostSpace>;
+
+    static constexpr int num_values = 4;
+
+    GlobalDiagnostics( const std::string file_name,
+                       const double damage_threshold = 0.5,
+                       const bool write_file = false )
+        : _file_name( file_name )
+        , _damage_threshold( damage_threshold )
+        , _write_file( write_file )
+        , _local( "diagnostics_local", num_values )
+        , _send( "diagnostics_send", num_values )
+        , _recv( "diagnostics_recv", num_values )
+    {
+        MPI_Comm_rank( MPI_COMM_WORLD, &_mpi_rank );
+        _values.fill( std::numeric_limits<double>::quiet_NaN() );
+    }
+
+    ~GlobalDiagnostics()
+    {
+        int finalized;
+        MPI_Finalized( &finalized );
+        if ( !finalized )
+            finish();
+    }
+
+    // Reduce the owned particles and post the global reduction, completing
+    // the previous one first (collective).
+    template <class ExecSpace, class ParticleType>
+    void start( const ExecSpace& exec_space, ParticleType& particles,
+                const int step, const double time )
+    {
+        finish();
+
+        _timer.start();
+        auto v = particles.sliceVelocity();
+        auto rho = particles.sliceDensity();
+        auto vol = particles.sliceVolume();
+        auto reduce = [&]( const auto& W, const auto& phi )
+        {
+            GlobalDiagnosticsReduce<std::decay_t<decltype( W )>,
+                                    decltype( v ), decltype( rho ),
+                                    decltype( vol ),
+                                    std::decay_t<decltype( phi )>>
+                functor( W, v, rho, vol, phi, _damage_threshold );
+            Kokkos::RangePolicy<ExecSpace> policy( exec_space,
+                                                   particles.frozenOffset(),
+                                                   particles.localOffset() );
+            Kokkos::parallel_reduce( "CabanaPD::Diagnostics::global", policy,
+                                     functor, _local );
+        };
+        if constexpr ( is_energy_output<
+                           typename ParticleType::output_type>::value )
+            reduce( particles.sliceStrainEnergy(), particles.sliceDamage() );
+        else
+            reduce( NoMonitorDamage{}, NoMonitorDamage{} );
+
+        // Only the few values are copied (and waited for) before posting,
+        // leaving the global reduction to overlap with the following steps.
+        Kokkos::deep_copy( exec_space, _send, _local );
+        exec_space.fence();
+        MPI_Iallreduce( _send.data(), _recv.data(), 1, MPI_DOUBLE, MPI_MAX,
+                        MPI_COMM_WORLD, &_requests[0] );
+        MPI_Iallreduce( _send.data() + 1, _recv.data() + 1, num_values - 1,
+                        MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, &_requests[1] );
+        _pending = true;
+        _pending_step = step;
+        _pending_time = time;
+        _timer.stop();
+    }
+
+    // Progress the posted reduction without blocking, returning whether the
+    // values are complete. This is cheap enough to call every step.
+    bool test()
+    {
+        if ( !_pending )
+            return true;
+        int complete;
+        MPI_Testall( 2, _requests, &complete, MPI_STATUSES_IGNORE );
+        if ( complete )
+            update();
+        return complete;
+    }
+
+    // Wait for the posted reduction (collective).
+    void finish()
+    {
+        if ( !_pending )
+            return;
+        _timer.start();
+        MPI_Waitall( 2, _requests, MPI_STATUSES_IGNORE );
+        update();
+        _timer.stop();
+    }
+
+    double maxDamage() const { return _values[0]; }
+    double strainEnergy() const { return _values[1]; }
+    double kineticEnergy() const { return _values[2]; }
+    double damagedVolume() const { return _values[3]; }
+    // Step and time of the completed values (step is negative before the
+    // first reduction completes).
+    int step() const { return _step; }
+    double stepTime() const { return _step_time; }
+
+    auto time() { return _timer.time(); };
+    void profile( TimerRegistry& timers ) const
+    {
+        timers.add( "Diagnostics::Global", _timer );
+    }
+
+  protected:
+    // Store the completed values and append them to the file (rank 0 only).
+    void update()
+    {
+        _pending = false;
+        _values[0] = _recv( 0 ) == Kokkos::reduction_identity<double>::max()
+                         ? std::numeric_limits<double>::quiet_NaN()
+                         : _recv( 0 );
+        for ( int n = 1; n < num_values; n++ )
+            _values[n] = _recv( n );
+        _step = _pending_step;
+        _step_time = _pending_time;
+
+        if ( !_write_file || _mpi_rank > 0 )
+            return;
+        std::ofstream out( _file_name, std::ofstream::app );
+        if ( !_header_written )
+        {
+            out << "#Step Time Strain-energy Kinetic-energy Damaged-volume "
+                   "Max-damage\n";
+            _header_written = true;
+        }
+        out << _step << " " << std::scientific << _step_time << " "
+            << strainEnergy() << " " << kineticEnergy() << " "
+            << damagedVolume() << " " << maxDamage() << "\n";
+    }
+
+    std::string _file_name;
+    double _damage_threshold;
+    bool _write_file;
+    int _mpi_rank = 0;
+    bool _header_written = false;
+
+    view_type _local;
+    // Buffers must not be touched until the reduction completes.
+    host_view_type _send;
+    host_view_type _recv;
+    MPI_Request _requests[2];
+    bool _pending = false;
+    int _pending_step = 0;
+    double _pending_time = 0.0;
+
+    std::array<double, num_values> _values;
+    // Negative until the first reduction completes.
+    int _step = -1;
+    double _step_time = 0.0;
+    Timer _timer = Timer( "Diagnostics::Global" );
+};
+
+} // namespace CabanaPD
+
+#endif
@@ -0,0 +1,180 @@
+/****************************************************************************
+ * Copyright (c) 2022 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of CabanaPD. CabanaPD is distributed under a           *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include <mpi.h>
+
+#include <Kokkos_Core.hpp>
+
+namespace CabanaPD
+{
+/******************************************************************************
+  Ensembles of independent systems in one set of particles.
+
+  Members are copies of the same box concatenated along one dimension,
+  separated by empty cells wider than the horizon so that members never share
+  bonds. Each particle stores its member in the particle type, which selects
+  the member parameters of an ensemble force model (see
+  createEnsembleForceModel). All members are then advanced by the same
+  kernels.
+******************************************************************************/
+template <std::size_t Dim>
+struct EnsembleLayout
+{
+    int num_members;
+    int axis;
+    double low;
+    // Member extent and member extent plus gap along the axis.
+    double length;
+    double period;
+
+    std::array<double, Dim> low_corner;
+    std::array<double, Dim> high_corner;
+    std::array<int, Dim> num_cells;
+
+    EnsembleLayout( const std::array<double, Dim> member_low,
+                    const std::array<double, Dim> member_high,
+                    const std::array<int, Dim> member_cells,
+                    const int _num_members, const double delta,
+                    const int _axis = 0 )
+        : num_members( _num_members )
+        , axis( _axis )
+        , low( member_low[_axis] )
+        , low_corner( member_low )
+        , high_corner( member_high )
+        , num_cells( member_cells )
+    {
+        if ( num_members < 1 )
+            throw std::runtime_error( "Ensemble requires at least 1 member." );
+
+        // Keep the same cell size and whole cells in the gap so that every
+        // member has identical particles.
+        length = member_high[axis] - member_low[axis];
+        const double dx = length / member_cells[axis];
+        const int gap_cells = static_cast<int>( std::ceil( delta / dx ) ) + 1;
+        period = length + gap_cells * dx;
+
+        num_cells[axis] =
+            num_members * member_cells[axis] + ( num_members - 1 ) * gap_cells;
+        high_corner[axis] = low + num_cells[axis] * dx;
+    }
+
+    // Member containing the position, or -1 within a gap.
+    KOKKOS_INLINE_FUNCTION
+    int member( const double x[Dim] ) const
+    {
+        const double offset = x[axis] - low;
+        const int k = static_cast<int>( Kokkos::floor( offset / period ) );
+        if ( k < 0 || k >= num_members || offset - k * period >= length )
+            return -1;
+        return k;
+    }
+
+    // Particle creation functor: only create particles within members.
+    KOKKOS_INLINE_FUNCTION
+    bool operator()( const int, const double x[Dim] ) const
+    {
+        return member( x ) >= 0;
+    }
+
+    // Offset of a member from the first member along the axis.
+    double offset( const int k ) const { return k * period; }
+};
+
+// Store the ensemble member of each particle in the particle type.
+template <class ExecSpace, class ParticleType, std::size_t Dim>
+void assignEnsembleMembers( const ExecSpace&, ParticleType& particles,
+                            const EnsembleLayout<Dim> layout )
+{
+    auto x = particles.sliceReferencePosition();
+    auto type = particles.sliceType();
+    auto member_func = KOKKOS_LAMBDA( const int pid )
+    {
+        double px[Dim];
+        for ( std::size_t d = 0; d < Dim; d++ )
+            px[d] = x( pid, d );
+        type( pid ) = Kokkos::max( layout.member( px ), 0 );
+    };
+    Kokkos::RangePolicy<ExecSpace> policy( 0, particles.localOffset() );
+    Kokkos::parallel_for( "CabanaPD::Ensemble::assignMembers", policy,
+                          member_func );
+}
+
+// Global sum of a per-particle value for each member in one kernel.
+template <class ExecSpace, class ParticleType, class ValueFunctor>
+std::vector<double> sumByMember( const ExecSpace&,
+                                 const ParticleType& particles,
+                                 const int num_members,
+                                 const ValueFunctor& value )
+{
+    using memory_space = typename ParticleType::memory_space;
+    Kokkos::View<double*, memory_space> sums( "ensemble_sums", num_members );
+    auto type = particles.sliceType();
+    Kokkos::RangePolicy<ExecSpace> policy( particles.frozenOffset(),
+                                           particles.localOffset() );
+    auto sum_func = KOKKOS_LAMBDA( const int p )
+    {
+        Kokkos::atomic_add( &sums( type( p ) ), value( p ) );
+    };
+    Kokkos::parallel_for( "CabanaPD::Ensemble::sumByMember", policy,
+                          sum_func );
+    auto sums_host =
+        Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace(), sums );
+    std::vector<double> result( sums_host.data(),
+                                sums_host.data() + num_members );
+    MPI_Allreduce( MPI_IN_PLACE, result.data(), num_members, MPI_DOUBLE,
+                   MPI_SUM, MPI_COMM_WORLD );
+    return result;
+}
+
+// Total strain energy of each member (requires energy output particles).
+template <class ExecSpace, class ParticleType>
+auto memberStrainEnergy( const ExecSpace& exec_space,
+                         const ParticleType& particles, const int num_members )
+{
+    auto W = particles.sliceStrainEnergy();
+    auto vol = particles.sliceVolume();
+    return sumByMember( exec_space, particles, num_members,
+                        KOKKOS_LAMBDA( const int p ) {
+                            return W( p ) * vol( p );
+                        } );
+}
+
+// Volume-weighted average damage of each member (requires energy output
+// particles).
+template <class ExecSpace, class ParticleType>
+auto memberDamage( const ExecSpace& exec_space, const ParticleType& particles,
+                   const int num_members )
+{
+    auto phi = particles.sliceDamage();
+    auto vol = particles.sliceVolume();
+    auto damage = sumByMember( exec_space, particles, num_members,
+                               KOKKOS_LAMBDA( const int p ) {
+                                   return phi( p ) * vol( p );
+                               } );
+    auto volume =
+        sumByMember( exec_space, particles, num_members,
+                     KOKKOS_LAMBDA( const int p ) { return vol( p ); } );
+    for ( int k = 0; k < num_members; k++ )
+        damage[k] = volume[k] > 0.0 ? damage[k] / volume[k] : 0.0;
+    return damage;
+}
+
+} // namespace CabanaPD
+
+#endif
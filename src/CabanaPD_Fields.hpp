@@ -12,7 +12,10 @@
 #ifndef FIELDS_HPP
 #define FIELDS_HPP
 
+#include <type_traits>
+
 #include <Cabana_Core.hpp>
+#include <Kokkos_Core.hpp>
 
 namespace CabanaPD
 {
@@ -22,12 +25,15 @@ namespace CabanaPD
 namespace Field
 {
 
-struct ReferencePosition : Cabana::Field::Position<3>
+template <int Dim = 3>
+struct ReferencePosition : Cabana::Field::Position<Dim>
 {
     static std::string label() { return "reference_positions"; }
 };
 
-struct Force : Cabana::Field::Vector<double, 3>
+// Force stored in the particle state precision.
+template <class ScalarType = double, int Dim = 3>
+struct Force : Cabana::Field::Vector<ScalarType, Dim>
 {
     static std::string label() { return "forces"; }
 };
@@ -38,6 +44,56 @@ struct NoFail : Cabana::Field::Scalar<int>
 };
 
 } // namespace Field
+
+//---------------------------------------------------------------------------//
+// Number of components of a vector slice or view (positions, forces, etc.),
+// fixing the system dimension for kernels at compile time. Anything without a
+// static extent of 2 is treated as 3d.
+//---------------------------------------------------------------------------//
+template <class VectorType, class = void>
+struct vector_dim
+{
+    static constexpr int value = 3;
+};
+
+template <class DataType, class MemorySpace, class AccessType, int VectorLength,
+          int Stride>
+struct vector_dim<
+    Cabana::Slice<DataType, MemorySpace, AccessType, VectorLength, Stride>>
+{
+    static constexpr int value = std::extent<DataType, 0>::value == 2 ? 2 : 3;
+};
+
+template <class ViewType>
+struct vector_dim<ViewType,
+                  std::enable_if_t<Kokkos::is_view<ViewType>::value>>
+{
+    static constexpr int value = ViewType::static_extent( 1 ) == 2 ? 2 : 3;
+};
+
+// Vector component of a particle, zero beyond the system dimension (the z
+// component in 2d).
+template <int Component, class VectorType>
+KOKKOS_INLINE_FUNCTION double component( const VectorType& v, const int i )
+{
+    if constexpr ( Component < vector_dim<VectorType>::value )
+        return v( i, Component );
+    else
+        return 0.0;
+}
+
+// Add a vector to a particle, ignoring the z component in 2d.
+template <class VectorType>
+KOKKOS_INLINE_FUNCTION void addVector( const VectorType& v, const int i,
+                                       const double vx, const double vy,
+                                       const double vz )
+{
+    v( i, 0 ) += vx;
+    v( i, 1 ) += vy;
+    if constexpr ( vector_dim<VectorType>::value == 3 )
+        v( i, 2 ) += vz;
+}
+
 } // namespace CabanaPD
 
 #endif
@@ -60,19 +60,30 @@
 #ifndef FORCE_H
 #define FORCE_H
 
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
 #include <Kokkos_Core.hpp>
 
+#include <CabanaPD_Fields.hpp>
 #include <CabanaPD_ForceModels.hpp>
+#include <CabanaPD_Memory.hpp>
 #include <CabanaPD_Particles.hpp>
+#include <CabanaPD_SpatialIndex.hpp>
+#include <CabanaPD_Timer.hpp>
 
 namespace CabanaPD
 {
 /******************************************************************************
   Force helper functions.
 ******************************************************************************/
-template <class PosType>
+template <class PosType, class DispType>
 KOKKOS_INLINE_FUNCTION void
-getDistanceComponents( const PosType& x, const PosType& u, const int i,
+getDistanceComponents( const PosType& x, const DispType& u, const int i,
                        const int j, double& xi, double& r, double& s,
                        double& rx, double& ry, double& rz )
 {
@@ -81,8 +92,8 @@ getDistanceComponents( const PosType& x, const PosType& u, const int i,
     const double eta_u = u( j, 0 ) - u( i, 0 );
     const double xi_y = x( j, 1 ) - x( i, 1 );
     const double eta_v = u( j, 1 ) - u( i, 1 );
-    const double xi_z = x( j, 2 ) - x( i, 2 );
-    const double eta_w = u( j, 2 ) - u( i, 2 );
+    const double xi_z = component<2>( x, j ) - component<2>( x, i );
+    const double eta_w = component<2>( u, j ) - component<2>( u, i );
     rx = xi_x + eta_u;
     ry = xi_y + eta_v;
     rz = xi_z + eta_w;
@@ -91,8 +102,8 @@ getDistanceComponents( const PosType& x, const PosType& u, const int i,
     s = ( r - xi ) / xi;
 }
 
-template <class PosType>
-KOKKOS_INLINE_FUNCTION void getDistance( const PosType& x, const PosType& u,
+template <class PosType, class DispType>
+KOKKOS_INLINE_FUNCTION void getDistance( const PosType& x, const DispType& u,
                                          const int i, const int j, double& xi,
                                          double& r, double& s )
 {
@@ -101,8 +112,18 @@ KOKKOS_INLINE_FUNCTION void getDistance( const PosType& x, const PosType& u,
 }
 
 template <class PosType>
+KOKKOS_INLINE_FUNCTION double getReferenceDistance( const PosType& x,
+                                                    const int i, const int j )
+{
+    const double xi_x = x( j, 0 ) - x( i, 0 );
+    const double xi_y = x( j, 1 ) - x( i, 1 );
+    const double xi_z = component<2>( x, j ) - component<2>( x, i );
+    return Kokkos::sqrt( xi_x * xi_x + xi_y * xi_y + xi_z * xi_z );
+}
+
+template <class PosType, class DispType>
 KOKKOS_INLINE_FUNCTION void getLinearizedDistanceComponents(
-    const PosType& x, const PosType& u, const int i, const int j, double& xi,
+    const PosType& x, const DispType& u, const int i, const int j, double& xi,
     double& s, double& xi_x, double& xi_y, double& xi_z )
 {
     // Get the reference positions and displacements.
@@ -110,39 +131,424 @@ KOKKOS_INLINE_FUNCTION void getLinearizedDistanceComponents(
     const double eta_u = u( j, 0 ) - u( i, 0 );
     xi_y = x( j, 1 ) - x( i, 1 );
     const double eta_v = u( j, 1 ) - u( i, 1 );
-    xi_z = x( j, 2 ) - x( i, 2 );
-    const double eta_w = u( j, 2 ) - u( i, 2 );
+    xi_z = component<2>( x, j ) - component<2>( x, i );
+    const double eta_w = component<2>( u, j ) - component<2>( u, i );
     xi = Kokkos::sqrt( xi_x * xi_x + xi_y * xi_y + xi_z * xi_z );
     s = ( xi_x * eta_u + xi_y * eta_v + xi_z * eta_w ) / ( xi * xi );
 }
 
-template <class PosType>
+template <class PosType, class DispType>
 KOKKOS_INLINE_FUNCTION void
-getLinearizedDistance( const PosType& x, const PosType& u, const int i,
+getLinearizedDistance( const PosType& x, const DispType& u, const int i,
                        const int j, double& xi, double& s )
 {
     double xi_x, xi_y, xi_z;
     getLinearizedDistanceComponents( x, u, i, j, xi, s, xi_x, xi_y, xi_z );
 }
 
+// Lexicographic order of reference positions, which is the same on every
+// rank (and for periodic images) regardless of particle storage order.
+template <class PosType>
+KOKKOS_INLINE_FUNCTION bool referenceBefore( const PosType& x, const int a,
+                                             const int b )
+{
+    for ( int d = 0; d < vector_dim<PosType>::value; d++ )
+    {
+        if ( x( a, d ) < x( b, d ) )
+            return true;
+        if ( x( a, d ) > x( b, d ) )
+            return false;
+    }
+    return false;
+}
+
+/******************************************************************************
+  Per-bond kernels (with the neighbor index needed for bond state).
+******************************************************************************/
+// Fixed size per-particle sum over bonds.
+template <int Size>
+struct BondSum
+{
+    double value[Size];
+
+    KOKKOS_INLINE_FUNCTION BondSum()
+    {
+        for ( int v = 0; v < Size; v++ )
+            value[v] = 0.0;
+    }
+    KOKKOS_INLINE_FUNCTION double& operator[]( const int v )
+    {
+        return value[v];
+    }
+    KOKKOS_INLINE_FUNCTION const double& operator[]( const int v ) const
+    {
+        return value[v];
+    }
+    KOKKOS_INLINE_FUNCTION BondSum& operator+=( const BondSum& other )
+    {
+        for ( int v = 0; v < Size; v++ )
+            value[v] += other.value[v];
+        return *this;
+    }
+};
+} // namespace CabanaPD
+
+namespace Kokkos
+{
+template <int Size>
+struct reduction_identity<CabanaPD::BondSum<Size>>
+{
+    KOKKOS_FORCEINLINE_FUNCTION static CabanaPD::BondSum<Size> sum()
+    {
+        return CabanaPD::BondSum<Size>();
+    }
+};
+} // namespace Kokkos
+
+namespace CabanaPD
+{
+// Whether neighbor kernels use team threading (and therefore atomics for any
+// per-particle value written from a neighbor).
+template <class ParallelType>
+struct is_team_op
+    : public std::is_same<std::remove_cv_t<ParallelType>, Cabana::TeamOpTag>
+{
+};
+
+template <class ParallelType, class SliceType>
+auto neighborSlice( SliceType slice )
+{
+    if constexpr ( is_team_op<ParallelType>::value )
+    {
+        typename SliceType::atomic_access_slice slice_a = slice;
+        return slice_a;
+    }
+    else
+    {
+        return slice;
+    }
+}
+
+// Loop over the bonds of each particle in [begin, end): bond_functor( i, j,
+// n, sum ) accumulates into the per-particle sum, which is then passed to
+// particle_functor( i, sum ). One thread per particle.
+template <class SumType, class ExecSpace, class NeighborListType,
+          class BondFunctor, class ParticleFunctor>
+void bondParallelFor( const std::string& label, ExecSpace,
+                      const std::size_t begin, const std::size_t end,
+                      const NeighborListType& neigh_list,
+                      const BondFunctor& bond_functor,
+                      const ParticleFunctor& particle_functor,
+                      Cabana::SerialOpTag )
+{
+    auto kernel = KOKKOS_LAMBDA( const int i )
+    {
+        std::size_t num_neighbors =
+            Cabana::NeighborList<NeighborListType>::numNeighbor( neigh_list,
+                                                                 i );
+        SumType sum;
+        for ( std::size_t n = 0; n < num_neighbors; n++ )
+        {
+            std::size_t j = Cabana::NeighborList<NeighborListType>::getNeighbor(
+                neigh_list, i, n );
+            bond_functor( i, j, n, sum );
+        }
+        particle_functor( i, sum );
+    };
+    Kokkos::RangePolicy<ExecSpace> policy( begin, end );
+    Kokkos::parallel_for( label, policy, kernel );
+}
+
+// One team per particle with a hierarchical reduction over bonds.
+template <class SumType, class ExecSpace, class NeighborListType,
+          class BondFunctor, class ParticleFunctor>
+void bondParallelFor( const std::string& label, ExecSpace,
+                      const std::size_t begin, const std::size_t end,
+                      const NeighborListType& neigh_list,
+                      const BondFunctor& bond_functor,
+                      const ParticleFunctor& particle_functor,
+                      Cabana::TeamOpTag )
+{
+    using policy_type = Kokkos::TeamPolicy<ExecSpace>;
+    using member_type = typename policy_type::member_type;
+    auto kernel = KOKKOS_LAMBDA( const member_type& team )
+    {
+        const int i = begin + team.league_rank();
+        std::size_t num_neighbors =
+            Cabana::NeighborList<NeighborListType>::numNeighbor( neigh_list,
+                                                                 i );
+        SumType sum;
+        Kokkos::parallel_reduce(
+            Kokkos::TeamThreadRange( team, num_neighbors ),
+            [&]( const std::size_t n, SumType& thread_sum )
+            {
+                std::size_t j =
+                    Cabana::NeighborList<NeighborListType>::getNeighbor(
+                        neigh_list, i, n );
+                bond_functor( i, j, n, thread_sum );
+            },
+            sum );
+        Kokkos::single( Kokkos::PerTeam( team ),
+                        [&]() { particle_functor( i, sum ); } );
+    };
+    policy_type policy( end - begin, Kokkos::AUTO );
+    Kokkos::parallel_for( label, policy, kernel );
+}
+
+// As above, with particle_functor( i, sum, result ) also contributing to a
+// global sum.
+template <class SumType, class ExecSpace, class NeighborListType,
+          class BondFunctor, class ParticleFunctor>
+void bondParallelReduce( const std::string& label, ExecSpace,
+                         const std::size_t begin, const std::size_t end,
+                         const NeighborListType& neigh_list,
+                         const BondFunctor& bond_functor,
+                         const ParticleFunctor& particle_functor,
+                         double& result, Cabana::SerialOpTag )
+{
+    auto kernel = KOKKOS_LAMBDA( const int i, double& global_sum )
+    {
+        std::size_t num_neighbors =
+            Cabana::NeighborList<NeighborListType>::numNeighbor( neigh_list,
+                                                                 i );
+        SumType sum;
+        for ( std::size_t n = 0; n < num_neighbors; n++ )
+        {
+            std::size_t j = Cabana::NeighborList<NeighborListType>::getNeighbor(
+                neigh_list, i, n );
+            bond_functor( i, j, n, sum );
+        }
+        particle_functor( i, sum, global_sum );
+    };
+    Kokkos::RangePolicy<ExecSpace> policy( begin, end );
+    Kokkos::parallel_reduce( label, policy, kernel, result );
+}
+
+template <class SumType, class ExecSpace, class NeighborListType,
+          class BondFunctor, class ParticleFunctor>
+void bondParallelReduce( const std::string& label, ExecSpace,
+                         const std::size_t begin, const std::size_t end,
+                         const NeighborListType& neigh_list,
+                         const BondFunctor& bond_functor,
+                         const ParticleFunctor& particle_functor,
+                         double& result, Cabana::TeamOpTag )
+{
+    using policy_type = Kokkos::TeamPolicy<ExecSpace>;
+    using member_type = typename policy_type::member_type;
+    auto kernel = KOKKOS_LAMBDA( const member_type& team, double& global_sum )
+    {
+        const int i = begin + team.league_rank();
+        std::size_t num_neighbors =
+            Cabana::NeighborList<NeighborListType>::numNeighbor( neigh_list,
+                                                                 i );
+        SumType sum;
+        Kokkos::parallel_reduce(
+            Kokkos::TeamThreadRange( team, num_neighbors ),
+            [&]( const std::size_t n, SumType& thread_sum )
+            {
+                std::size_t j =
+                    Cabana::NeighborList<NeighborListType>::getNeighbor(
+                        neigh_list, i, n );
+                bond_functor( i, j, n, thread_sum );
+            },
+            sum );
+        // Only one contribution per particle to the global sum.
+        Kokkos::single( Kokkos::PerTeam( team ),
+                        [&]() { particle_functor( i, sum, global_sum ); } );
+    };
+    policy_type policy( end - begin, Kokkos::AUTO );
+    Kokkos::parallel_reduce( label, policy, kernel, result );
+}
+
+// Two passes over the bonds of each particle, for kernels where every bond
+// depends on a per-particle sum over all bonds: first_functor( i, j, n,
+// first ) completes before bond_functor( i, j, n, first, sum ).
+template <class FirstSumType, class SumType, class ExecSpace,
+          class NeighborListType, class FirstFunctor, class BondFunctor,
+          class ParticleFunctor>
+void twoPassBondParallelReduce( const std::string& label, ExecSpace,
+                                const std::size_t begin, const std::size_t end,
+                                const NeighborListType& neigh_list,
+                                const FirstFunctor& first_functor,
+                                const BondFunctor& bond_functor,
+                                const ParticleFunctor& particle_functor,
+                                double& result, Cabana::SerialOpTag )
+{
+    auto kernel = KOKKOS_LAMBDA( const int i, double& global_sum )
+    {
+        std::size_t num_neighbors =
+            Cabana::NeighborList<NeighborListType>::numNeighbor( neigh_list,
+                                                                 i );
+        FirstSumType first;
+        for ( std::size_t n = 0; n < num_neighbors; n++ )
+        {
+            std::size_t j = Cabana::NeighborList<NeighborListType>::getNeighbor(
+                neigh_list, i, n );
+            first_functor( i, j, n, first );
+        }
+        SumType sum;
+        for ( std::size_t n = 0; n < num_neighbors; n++ )
+        {
+            std::size_t j = Cabana::NeighborList<NeighborListType>::getNeighbor(
+                neigh_list, i, n );
+            bond_functor( i, j, n, first, sum );
+        }
+        particle_functor( i, first, sum, global_sum );
+    };
+    Kokkos::RangePolicy<ExecSpace> policy( begin, end );
+    Kokkos::parallel_reduce( label, policy, kernel, result );
+}
+
+template <class FirstSumType, class SumType, class ExecSpace,
+          class NeighborListType, class FirstFunctor, class BondFunctor,
+          class ParticleFunctor>
+void twoPassBondParallelReduce( const std::string& label, ExecSpace,
+                                const std::size_t begin, const std::size_t end,
+                                const NeighborListType& neigh_list,
+                                const FirstFunctor& first_functor,
+                                const BondFunctor& bond_functor,
+                                const ParticleFunctor& particle_functor,
+                                double& result, Cabana::TeamOpTag )
+{
+    using policy_type = Kokkos::TeamPolicy<ExecSpace>;
+    using member_type = typename policy_type::member_type;
+    auto kernel = KOKKOS_LAMBDA( const member_type& team, double& global_sum )
+    {
+        const int i = begin + team.league_rank();
+        std::size_t num_neighbors =
+            Cabana::NeighborList<NeighborListType>::numNeighbor( neigh_list,
+                                                                 i );
+        FirstSumType first;
+        Kokkos::parallel_reduce(
+            Kokkos::TeamThreadRange( team, num_neighbors ),
+            [&]( const std::size_t n, FirstSumType& thread_first )
+            {
+                std::size_t j =
+                    Cabana::NeighborList<NeighborListType>::getNeighbor(
+                        neigh_list, i, n );
+                first_functor( i, j, n, thread_first );
+            },
+            first );
+        SumType sum;
+        Kokkos::parallel_reduce(
+            Kokkos::TeamThreadRange( team, num_neighbors ),
+            [&]( const std::size_t n, SumType& thread_sum )
+            {
+                std::size_t j =
+                    Cabana::NeighborList<NeighborListType>::getNeighbor(
+                        neigh_list, i, n );
+                bond_functor( i, j, n, first, thread_sum );
+            },
+            sum );
+        Kokkos::single(
+            Kokkos::PerTeam( team ),
+            [&]() { particle_functor( i, first, sum, global_sum ); } );
+    };
+    policy_type policy( end - begin, Kokkos::AUTO );
+    Kokkos::parallel_reduce( label, policy, kernel, result );
+}
+
+/******************************************************************************
+  Neighbor list layouts.
+
+  Neighbors are stored in padded rows (VerletLayout2D) by default, or
+  compressed rows (VerletLayout1D) with CSR bond storage.
+******************************************************************************/
+template <class BondStorageType>
+struct NeighborLayout
+{
+    using type = Cabana::VerletLayout2D;
+};
+template <>
+struct NeighborLayout<CSRBondStorage>
+{
+    using type = Cabana::VerletLayout1D;
+};
+
+// Writable access to neighbor n of particle i for either layout, for kernels
+// which reorder or remove neighbors in place. CSR rows keep their offsets, so
+// removed neighbors leave unused entries at the end of the row.
+template <class NeighborListType>
+struct NeighborRows
+{
+    using counts_type =
+        decltype( std::declval<NeighborListType>()._data.counts );
+    using neighbors_type =
+        decltype( std::declval<NeighborListType>()._data.neighbors );
+    static constexpr bool is_csr = neighbors_type::rank == 1;
+
+    counts_type counts;
+    neighbors_type neighbors;
+    counts_type offsets;
+
+    NeighborRows( const NeighborListType& neigh_list )
+        : counts( neigh_list._data.counts )
+        , neighbors( neigh_list._data.neighbors )
+    {
+        if constexpr ( is_csr )
+            offsets = neigh_list._data.offsets;
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    auto& operator()( const int i, const int n ) const
+    {
+        if constexpr ( is_csr )
+            return neighbors( offsets( i ) + n );
+        else
+            return neighbors( i, n );
+    }
+};
+
 // Forward declaration.
-template <class MemorySpace, class ForceType>
+template <class MemorySpace, class ForceType,
+          class BondStorageType = BitBondStorage,
+          class BondCacheType = NoBondCache>
 class Force;
 
-template <class MemorySpace>
-class Force<MemorySpace, BaseForceModel>
+template <class MemorySpace, class BondStorageType>
+class Force<MemorySpace, BaseForceModel, BondStorageType>
 {
   public:
+    using neighbor_layout_type =
+        typename NeighborLayout<BondStorageType>::type;
     using neighbor_list_type =
         Cabana::VerletList<MemorySpace, Cabana::FullNeighborTag,
-                           Cabana::VerletLayout2D, Cabana::TeamOpTag>;
+                           neighbor_layout_type, Cabana::TeamOpTag>;
+    // Each bond is stored once; ownership across MPI ranks is decided by
+    // reference position so that ghost contributions can be scattered back.
+    using half_neighbor_list_type =
+        Cabana::VerletList<MemorySpace, Cabana::HalfNeighborTag,
+                           neighbor_layout_type, Cabana::TeamOpTag>;
+
+    // Whether force, energy, and damage can be computed in a single pass.
+    static constexpr bool has_fused_energy = false;
+    // Whether the force kernel can skip bond breaking checks.
+    static constexpr bool has_bond_breaking = false;
+    // Whether forces can use an assembled (linearized) stiffness operator.
+    static constexpr bool has_stiffness_operator = false;
+    // Whether bonds can be checked for breaking for an active set only.
+    static constexpr bool has_active_bond_breaking = false;
+    // Whether the force kernel can also compute bond heat conduction.
+    static constexpr bool has_fused_conduction = false;
 
   protected:
     bool _half_neigh;
+    double _cutoff = 0.0;
     neighbor_list_type _neigh_list;
+    half_neighbor_list_type _half_neigh_list;
+    // Particle cell list shared with other full neighbor lists.
+    std::shared_ptr<SpatialIndex<MemorySpace>> _spatial_index;
 
-    Timer _timer;
-    Timer _energy_timer;
+    Timer _timer = Timer( "Force" );
+    Timer _energy_timer = Timer( "Energy" );
+    // LPS stages (included in the force time).
+    Timer _weighted_volume_timer = Timer( "WeightedVolume" );
+    Timer _dilatation_timer = Timer( "Dilatation" );
+
+    // Optional subset of owned particles for the force kernels.
+    bool _use_particle_range = false;
+    std::size_t _range_begin = 0;
+    std::size_t _range_end = 0;
 
   public:
     // Primary constructor: use positions and construct neighbors.
@@ -150,25 +556,39 @@ class Force<MemorySpace, BaseForceModel>
     Force( const bool half_neigh, const double delta,
            const ParticleType& particles, const double tol = 1e-14 )
         : _half_neigh( half_neigh )
-        , _neigh_list( neighbor_list_type(
-              particles.sliceReferencePosition(), particles.frozenOffset(),
-              particles.localOffset(), delta + tol, 1.0,
-              particles.ghost_mesh_lo, particles.ghost_mesh_hi ) )
+        , _cutoff( delta + tol )
+        , _spatial_index( particles.spatialIndex() )
     {
+        if ( half_neigh && !particles.halfNeighbors() )
+            throw std::runtime_error( "Half neighbor lists require particles "
+                                      "sized for ghost forces." );
+        build( particles.sliceReferencePosition(), particles.frozenOffset(),
+               particles.localOffset(), delta + tol, particles.ghost_mesh_lo,
+               particles.ghost_mesh_hi );
+        // Refined particles only bond within their (smaller) bond horizon.
+        if ( particles.variableResolution() )
+            restrictNeighbors( particles.sliceReferencePosition(),
+                               BondHorizon( delta, particles.referenceVolume(),
+                                            particles.sliceVolume() ),
+                               particles.frozenOffset(),
+                               particles.localOffset(), tol );
     }
 
     // General constructor (necessary for contact, but could be used by any
-    // force routine).
+    // force routine), optionally sharing the particle cell list.
     template <class PositionType>
     Force( const bool half_neigh, const double delta,
            const PositionType& positions, const std::size_t frozen_offset,
            const std::size_t local_offset, const double mesh_min[3],
-           const double mesh_max[3], const double tol = 1e-14 )
+           const double mesh_max[3], const double tol = 1e-14,
+           const std::shared_ptr<SpatialIndex<MemorySpace>>& spatial_index =
+               nullptr )
         : _half_neigh( half_neigh )
-        , _neigh_list( neighbor_list_type( positions, frozen_offset,
-                                           local_offset, delta + tol, 1.0,
-                                           mesh_min, mesh_max ) )
+        , _cutoff( delta + tol )
+        , _spatial_index( spatial_index )
     {
+        build( positions, frozen_offset, local_offset, delta + tol, mesh_min,
+               mesh_max );
     }
 
     // Constructor which stores existing neighbors.
@@ -179,14 +599,255 @@ class Force<MemorySpace, BaseForceModel>
     {
     }
 
+    template <class PositionType, class MeshType>
+    void build( const PositionType& positions, const std::size_t frozen_offset,
+                const std::size_t local_offset, const double cutoff,
+                const MeshType& mesh_min, const MeshType& mesh_max )
+    {
+        // Frozen particles are included in the half list because they may
+        // own bonds with non-frozen particles.
+        if ( _half_neigh )
+        {
+            _half_neigh_list.build( positions, 0, local_offset, cutoff, 1.0,
+                                    mesh_min, mesh_max );
+            ownGhostBonds( positions, local_offset );
+        }
+        else
+            buildFull( _neigh_list, positions, frozen_offset, local_offset,
+                       cutoff, mesh_min, mesh_max, _spatial_index );
+    }
+
+    // Full neighbors from the shared cell list where available (3d, padded
+    // rows).
+    template <class NeighborListType, class PositionType, class MeshType>
+    static void
+    buildFull( NeighborListType& neigh_list, const PositionType& positions,
+               const std::size_t begin, const std::size_t end,
+               const double cutoff, const MeshType& mesh_min,
+               const MeshType& mesh_max,
+               const std::shared_ptr<SpatialIndex<MemorySpace>>& index )
+    {
+        if constexpr ( vector_dim<PositionType>::value == 3 &&
+                       !NeighborRows<NeighborListType>::is_csr )
+        {
+            if ( index )
+            {
+                const double low[3] = { mesh_min[0], mesh_min[1],
+                                        mesh_min[2] };
+                const double high[3] = { mesh_max[0], mesh_max[1],
+                                         mesh_max[2] };
+                index->neighbors( neigh_list, positions, begin, end, cutoff,
+                                  low, high );
+                return;
+            }
+        }
+        neigh_list.build( positions, begin, end, cutoff, 1.0, mesh_min,
+                          mesh_max );
+    }
+
+    // Bonds with ghosts appear in the half list on both ranks (or for both
+    // periodic images): only keep those where the local particle comes first
+    // by reference position, such that each bond is owned exactly once.
+    template <class PositionType>
+    void ownGhostBonds( const PositionType& x, const std::size_t local_offset )
+    {
+        NeighborRows<half_neighbor_list_type> neighbors( _half_neigh_list );
+        auto counts = neighbors.counts;
+        auto own_row = KOKKOS_LAMBDA( const int i )
+        {
+            int num_kept = 0;
+            for ( int n = 0; n < static_cast<int>( counts( i ) ); n++ )
+            {
+                const int j = neighbors( i, n );
+                if ( j < static_cast<int>( local_offset ) ||
+                     referenceBefore( x, i, j ) )
+                    neighbors( i, num_kept++ ) = j;
+            }
+            counts( i ) = num_kept;
+        };
+        using exec_space = typename MemorySpace::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( 0, local_offset );
+        Kokkos::parallel_for( "CabanaPD::Force::ownGhostBonds", policy,
+                              own_row );
+        Kokkos::fence();
+    }
+
+    // Remove neighbors beyond the horizon of each bond, keeping the neighbor
+    // order.
+    template <class PositionType, class HorizonType>
+    void restrictNeighbors( const PositionType& x, const HorizonType& horizon,
+                            const std::size_t frozen_offset,
+                            const std::size_t local_offset, const double tol )
+    {
+        if ( _half_neigh )
+            restrictNeighbors( _half_neigh_list, x, horizon, 0, local_offset,
+                               tol );
+        else
+            restrictNeighbors( _neigh_list, x, horizon, frozen_offset,
+                               local_offset, tol );
+    }
+
+    template <class NeighborListType, class PositionType, class HorizonType>
+    void restrictNeighbors( NeighborListType& neigh_list, const PositionType& x,
+                            const HorizonType& horizon,
+                            const std::size_t begin, const std::size_t end,
+                            const double tol )
+    {
+        NeighborRows<NeighborListType> neighbors( neigh_list );
+        auto counts = neighbors.counts;
+        auto restrict_row = KOKKOS_LAMBDA( const int i )
+        {
+            int num_kept = 0;
+            for ( int n = 0; n < static_cast<int>( counts( i ) ); n++ )
+            {
+                const int j = neighbors( i, n );
+                double xi2 = 0.0;
+                for ( int d = 0; d < vector_dim<PositionType>::value; d++ )
+                {
+                    const double xi_d = x( j, d ) - x( i, d );
+                    xi2 += xi_d * xi_d;
+                }
+                const double cutoff = horizon( i, j ) + tol;
+                if ( xi2 <= cutoff * cutoff )
+                    neighbors( i, num_kept++ ) = j;
+            }
+            counts( i ) = num_kept;
+        };
+        using exec_space = typename MemorySpace::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( begin, end );
+        Kokkos::parallel_for( "CabanaPD::Force::restrictNeighbors", policy,
+                              restrict_row );
+        Kokkos::fence();
+    }
+
+    // Rebuild neighbors after particles have moved between ranks. The binning
+    // bounds come from the local and ghost reference positions, which are no
+    // longer contained within the ghosted local grid.
+    template <class ParticleType>
+    void rebuildNeighbors( const ParticleType& particles )
+    {
+        if ( _half_neigh )
+            throw std::runtime_error( "Rebuilding neighbors is not supported "
+                                      "with half neighbor lists." );
+
+        auto x = particles.sliceReferencePosition();
+        double mesh_min[3] = { 0.0, 0.0, 0.0 };
+        double mesh_max[3] = { 0.0, 0.0, 0.0 };
+        using exec_space = typename MemorySpace::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( 0,
+                                                particles.referenceOffset() );
+        for ( int d = 0; d < ParticleType::dim; d++ )
+        {
+            if ( particles.referenceOffset() == 0 )
+            {
+                mesh_min[d] = particles.local_mesh_lo[d];
+                mesh_max[d] = particles.local_mesh_hi[d];
+                continue;
+            }
+            Kokkos::MinMaxScalar<double> bounds;
+            Kokkos::parallel_reduce(
+                "CabanaPD::Force::neighborBounds", policy,
+                KOKKOS_LAMBDA( const int p,
+                               Kokkos::MinMaxScalar<double>& b ) {
+                    if ( x( p, d ) < b.min_val )
+                        b.min_val = x( p, d );
+                    if ( x( p, d ) > b.max_val )
+                        b.max_val = x( p, d );
+                },
+                Kokkos::MinMax<double>( bounds ) );
+            mesh_min[d] = bounds.min_val - _cutoff;
+            mesh_max[d] = bounds.max_val + _cutoff;
+        }
+        build( x, particles.frozenOffset(), particles.localOffset(), _cutoff,
+               mesh_min, mesh_max );
+        sortNeighbors( x, particles.frozenOffset(), particles.localOffset() );
+    }
+
+    // Order each neighbor row by reference position so that bond indices
+    // (and therefore broken bond storage) do not depend on how particles are
+    // distributed across ranks.
+    template <class PositionType>
+    void sortNeighbors( const PositionType& x, const std::size_t begin,
+                        const std::size_t end )
+    {
+        NeighborRows<neighbor_list_type> neighbors( _neigh_list );
+        auto counts = neighbors.counts;
+        auto sort_row = KOKKOS_LAMBDA( const int i )
+        {
+            // Insertion sort: rows are short.
+            for ( int n = 1; n < static_cast<int>( counts( i ) ); n++ )
+            {
+                int j = neighbors( i, n );
+                int m = n - 1;
+                while ( m >= 0 && referenceBefore( x, j, neighbors( i, m ) ) )
+                {
+                    neighbors( i, m + 1 ) = neighbors( i, m );
+                    m--;
+                }
+                neighbors( i, m + 1 ) = j;
+            }
+        };
+        using exec_space = typename MemorySpace::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( begin, end );
+        Kokkos::parallel_for( "CabanaPD::Force::sortNeighbors", policy,
+                              sort_row );
+        Kokkos::fence();
+    }
+
     unsigned getMaxLocalNeighbors()
     {
+        if ( _half_neigh )
+            return getMaxLocalNeighbors( _half_neigh_list );
+        else
+            return getMaxLocalNeighbors( _neigh_list );
+    }
+
+    void getNeighborStatistics( unsigned& max_neighbors,
+                                unsigned long long& total_neighbors )
+    {
+        if ( _half_neigh )
+            getNeighborStatistics( _half_neigh_list, max_neighbors,
+                                   total_neighbors );
+        else
+            getNeighborStatistics( _neigh_list, max_neighbors,
+                                   total_neighbors );
+    }
+
+    // Cost estimate per local particle for load balancing: one plus the
+    // number of bonds, including broken bonds since they are still traversed.
+    template <class ParticleType>
+    auto getLoadWeights( const ParticleType& particles ) const
+    {
+        if ( _half_neigh )
+            throw std::runtime_error( "Load weights are not supported with "
+                                      "half neighbor lists." );
+
+        Kokkos::View<double*, MemorySpace> weights( "load_weights",
+                                                    particles.localOffset() );
         auto neigh = _neigh_list;
+        using exec_space = typename MemorySpace::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
+                                                particles.localOffset() );
+        Kokkos::parallel_for(
+            "CabanaPD::Force::loadWeights", policy,
+            KOKKOS_LAMBDA( const int p ) {
+                weights( p ) =
+                    1.0 +
+                    Cabana::NeighborList<neighbor_list_type>::numNeighbor(
+                        neigh, p );
+            } );
+        Kokkos::fence();
+        return weights;
+    }
+
+    template <class NeighborListType>
+    unsigned getMaxLocalNeighbors( const NeighborListType& neigh )
+    {
         unsigned local_max_neighbors;
         auto neigh_max = KOKKOS_LAMBDA( const int, unsigned& max_n )
         {
             max_n =
-                Cabana::NeighborList<neighbor_list_type>::maxNeighbor( neigh );
+                Cabana::NeighborList<NeighborListType>::maxNeighbor( neigh );
         };
         using exec_space = typename MemorySpace::execution_space;
         Kokkos::RangePolicy<exec_space> policy( 0, 1 );
@@ -195,19 +856,20 @@ class Force<MemorySpace, BaseForceModel>
         return local_max_neighbors;
     }
 
-    void getNeighborStatistics( unsigned& max_neighbors,
+    template <class NeighborListType>
+    void getNeighborStatistics( const NeighborListType& neigh,
+                                unsigned& max_neighbors,
                                 unsigned long long& total_neighbors )
     {
-        auto neigh = _neigh_list;
         unsigned local_max_neighbors;
         unsigned long long local_total_neighbors;
         auto neigh_stats = KOKKOS_LAMBDA( const int, unsigned& max_n,
                                           unsigned long long& total_n )
         {
             max_n =
-                Cabana::NeighborList<neighbor_list_type>::maxNeighbor( neigh );
-            total_n = Cabana::NeighborList<neighbor_list_type>::totalNeighbor(
-                neigh );
+                Cabana::NeighborList<NeighborListType>::maxNeighbor( neigh );
+            total_n =
+                Cabana::NeighborList<NeighborListType>::totalNeighbor( neigh );
         };
         using exec_space = typename MemorySpace::execution_space;
         Kokkos::RangePolicy<exec_space> policy( 0, 1 );
@@ -220,6 +882,66 @@ class Force<MemorySpace, BaseForceModel>
                     MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD );
     }
 
+    bool halfNeighbor() const { return _half_neigh; }
+
+    // Neighbor list storage, including the padding of each row to the
+    // maximum number of neighbors.
+    void neighborMemory( MemoryRegistry& registry ) const
+    {
+        if ( _half_neigh )
+            registry.add( "Force::Neighbors",
+                          neighborListBytes( _half_neigh_list ) );
+        else
+            registry.add( "Force::Neighbors",
+                          neighborListBytes( _neigh_list ) );
+    }
+
+    // Restrict full neighbor list force and dilatation kernels to owned
+    // particles [begin, end), e.g. to compute particles without ghost
+    // neighbors while ghost communication is in flight.
+    void setParticleRange( const std::size_t begin, const std::size_t end )
+    {
+        _use_particle_range = true;
+        _range_begin = begin;
+        _range_end = end;
+    }
+    void resetParticleRange() { _use_particle_range = false; }
+
+    template <class ParticleType>
+    std::size_t particleBegin( const ParticleType& particles ) const
+    {
+        return _use_particle_range ? _range_begin : particles.frozenOffset();
+    }
+    template <class ParticleType>
+    std::size_t particleEnd( const ParticleType& particles ) const
+    {
+        return _use_particle_range ? _range_end : particles.localOffset();
+    }
+
+    // Default to unsupported for models without a half list implementation.
+    template <class ForceType, class PosType, class DispType,
+              class ParticleType, class ParallelType>
+    void computeForceHalf( ForceType&, const PosType&, const DispType&,
+                           const ParticleType&, ParallelType& )
+    {
+        throw std::runtime_error(
+            "Half neighbor lists are not supported for this force model." );
+    }
+    template <class WType, class PosType, class DispType, class ParticleType,
+              class ParallelType>
+    double computeEnergyHalf( WType&, const PosType&, const DispType&,
+                              ParticleType&, ParallelType& )
+    {
+        throw std::runtime_error(
+            "Half neighbor lists are not supported for this force model." );
+        return 0.0;
+    }
+    // No-op without fracture.
+    template <class ParticleType>
+    void computeDamageHalf( ParticleType& )
+    {
+    }
+
     // Default to no-op for pair models.
     template <class ParticleType, class ParallelType>
     void computeWeightedVolume( ParticleType&, const ParallelType ) const
@@ -231,33 +953,845 @@ class Force<MemorySpace, BaseForceModel>
     }
 
     auto getNeighbors() const { return _neigh_list; }
+    auto getHalfNeighbors() const { return _half_neigh_list; }
 
-    auto time() { return _timer.time(); };
+    auto time()
+    {
+        return _timer.time() + _weighted_volume_timer.time() +
+               _dilatation_timer.time();
+    };
     auto timeEnergy() { return _energy_timer.time(); };
+
+    void profile( TimerRegistry& timers,
+                  const std::string& name = "Force" ) const
+    {
+        timers.add( name, _timer );
+        timers.add( name + "::Energy", _energy_timer );
+        timers.add( name + "::WeightedVolume", _weighted_volume_timer );
+        timers.add( name + "::Dilatation", _dilatation_timer );
+    }
+};
+
+/******************************************************************************
+  Broken bond storage.
+******************************************************************************/
+template <class MemorySpace, class StorageType>
+class BrokenBonds;
+
+// One bit per bond, with each particle row padded to a whole number of words.
+// Rows are only stored for particles [first_row, local_particles), such that
+// frozen particles (which own no bonds) need no storage.
+template <class MemorySpace>
+class BrokenBonds<MemorySpace, BitBondStorage>
+{
+  public:
+    using memory_space = MemorySpace;
+    using word_type = unsigned int;
+    static constexpr int bits_per_word = 8 * sizeof( word_type );
+
+  protected:
+    Kokkos::View<word_type**, memory_space> _bits;
+    int _first_row = 0;
+
+  public:
+    BrokenBonds() = default;
+
+    BrokenBonds( const int local_particles, const int max_neighbors,
+                 const int first_row = 0 )
+        : _bits( Kokkos::ViewAllocateWithoutInitializing( "broken_bonds" ),
+                 local_particles - first_row,
+                 ( max_neighbors + bits_per_word - 1 ) / bits_per_word )
+        , _first_row( first_row )
+    {
+        // All bonds start intact.
+        Kokkos::deep_copy( _bits, ~word_type( 0 ) );
+    }
+
+    // Rows sized from the neighbor list maximum.
+    template <class NeighborListType>
+    BrokenBonds( const NeighborListType&, const int local_particles,
+                 const int max_neighbors, const int first_row )
+        : BrokenBonds( local_particles, max_neighbors, first_row )
+    {
+    }
+
+    // Wrap existing storage (e.g. after particle migration).
+    explicit BrokenBonds( const Kokkos::View<word_type**, memory_space>& bits,
+                          const int first_row = 0 )
+        : _bits( bits )
+        , _first_row( first_row )
+    {
+    }
+
+    // Returns 1 for an intact bond and 0 for a broken bond.
+    KOKKOS_INLINE_FUNCTION
+    int operator()( const int i, const int n ) const
+    {
+        return ( _bits( i - _first_row, n / bits_per_word ) >>
+                 ( n % bits_per_word ) ) &
+               1u;
+    }
+
+    // Atomic since neighboring bonds of a particle share the same word.
+    KOKKOS_INLINE_FUNCTION
+    void breakBond( const int i, const int n ) const
+    {
+        Kokkos::atomic_and( &_bits( i - _first_row, n / bits_per_word ),
+                            ~( word_type( 1 ) << ( n % bits_per_word ) ) );
+    }
+
+    // Rows extend to the last particle index (not the number stored).
+    std::size_t extent( const int dim ) const
+    {
+        return dim == 1 ? _bits.extent( 1 ) * bits_per_word
+                        : _bits.extent( dim ) + _first_row;
+    }
+    auto firstRow() const { return _first_row; }
+    auto view() const { return _bits; }
+    double bytes() const { return viewBytes( _bits ); }
+
+    // Number of set bits, including row padding (which never changes), such
+    // that any newly broken bond decreases the count.
+    std::size_t numIntact() const
+    {
+        auto bits = _bits;
+        const int num_words = _bits.extent( 1 );
+        std::size_t count = 0;
+        using exec_space = typename memory_space::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( 0, _bits.extent( 0 ) );
+        Kokkos::parallel_reduce(
+            "CabanaPD::BrokenBonds::numIntact", policy,
+            KOKKOS_LAMBDA( const int i, std::size_t& sum ) {
+                for ( int w = 0; w < num_words; w++ )
+                    for ( word_type b = bits( i, w ); b; b &= b - 1 )
+                        sum++;
+            },
+            count );
+        return count;
+    }
+};
+
+// One byte per bond, without atomics.
+template <class MemorySpace>
+class BrokenBonds<MemorySpace, ByteBondStorage>
+{
+  public:
+    using memory_space = MemorySpace;
+
+  protected:
+    Kokkos::View<std::uint8_t**, memory_space> _mask;
+    int _first_row = 0;
+
+  public:
+    BrokenBonds() = default;
+
+    BrokenBonds( const int local_particles, const int max_neighbors,
+                 const int first_row = 0 )
+        : _mask( Kokkos::ViewAllocateWithoutInitializing( "broken_bonds" ),
+                 local_particles - first_row, max_neighbors )
+        , _first_row( first_row )
+    {
+        Kokkos::deep_copy( _mask, 1 );
+    }
+
+    template <class NeighborListType>
+    BrokenBonds( const NeighborListType&, const int local_particles,
+                 const int max_neighbors, const int first_row )
+        : BrokenBonds( local_particles, max_neighbors, first_row )
+    {
+    }
+
+    explicit BrokenBonds(
+        const Kokkos::View<std::uint8_t**, memory_space>& mask,
+        const int first_row = 0 )
+        : _mask( mask )
+        , _first_row( first_row )
+    {
+    }
+
+    // Returns 1 for an intact bond and 0 for a broken bond.
+    KOKKOS_INLINE_FUNCTION
+    int operator()( const int i, const int n ) const
+    {
+        return _mask( i - _first_row, n );
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    void breakBond( const int i, const int n ) const
+    {
+        _mask( i - _first_row, n ) = 0;
+    }
+
+    std::size_t extent( const int dim ) const
+    {
+        return dim == 1 ? _mask.extent( 1 ) : _mask.extent( 0 ) + _first_row;
+    }
+    auto firstRow() const { return _first_row; }
+    auto view() const { return _mask; }
+    double bytes() const { return viewBytes( _mask ); }
+
+    // Number of set entries, including row padding.
+    std::size_t numIntact() const
+    {
+        auto mask = _mask;
+        const int num_cols = _mask.extent( 1 );
+        std::size_t count = 0;
+        using exec_space = typename memory_space::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( 0, _mask.extent( 0 ) );
+        Kokkos::parallel_reduce(
+            "CabanaPD::BrokenBonds::numIntact", policy,
+            KOKKOS_LAMBDA( const int i, std::size_t& sum ) {
+                for ( int n = 0; n < num_cols; n++ )
+                    sum += mask( i, n );
+            },
+            count );
+        return count;
+    }
 };
 
+// One byte per bond at the row offsets of a CSR neighbor list (shared with
+// the list), such that no storage is padded to the maximum number of
+// neighbors.
 template <class MemorySpace>
+class BrokenBonds<MemorySpace, CSRBondStorage>
+{
+  public:
+    using memory_space = MemorySpace;
+
+  protected:
+    Kokkos::View<std::uint8_t*, memory_space> _mask;
+    Kokkos::View<int*, memory_space> _offsets;
+    std::size_t _max_neighbors = 0;
+    int _first_row = 0;
+
+  public:
+    BrokenBonds() = default;
+
+    template <class NeighborListType>
+    BrokenBonds( const NeighborListType& neigh_list, const int,
+                 const int max_neighbors, const int first_row )
+        : _mask( Kokkos::ViewAllocateWithoutInitializing( "broken_bonds" ),
+                 neigh_list._data.neighbors.size() )
+        , _offsets( neigh_list._data.offsets )
+        , _max_neighbors( max_neighbors )
+        , _first_row( first_row )
+    {
+        static_assert(
+            NeighborRows<NeighborListType>::is_csr,
+            "CSR bond storage requires a VerletLayout1D neighbor list." );
+        Kokkos::deep_copy( _mask, 1 );
+    }
+
+    // Returns 1 for an intact bond and 0 for a broken bond.
+    KOKKOS_INLINE_FUNCTION
+    int operator()( const int i, const int n ) const
+    {
+        return _mask( _offsets( i ) + n );
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    void breakBond( const int i, const int n ) const
+    {
+        _mask( _offsets( i ) + n ) = 0;
+    }
+
+    // Rows extend to the last particle in the neighbor list.
+    std::size_t extent( const int dim ) const
+    {
+        return dim == 1 ? _max_neighbors : _offsets.extent( 0 );
+    }
+    auto firstRow() const { return _first_row; }
+    auto view() const { return _mask; }
+    double bytes() const { return viewBytes( _mask ); }
+
+    // Number of set entries, including entries left at the end of rows by
+    // neighbor removal.
+    std::size_t numIntact() const
+    {
+        auto mask = _mask;
+        std::size_t count = 0;
+        using exec_space = typename memory_space::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( 0, _mask.extent( 0 ) );
+        Kokkos::parallel_reduce(
+            "CabanaPD::BrokenBonds::numIntact", policy,
+            KOKKOS_LAMBDA( const int b, std::size_t& sum ) {
+                sum += mask( b );
+            },
+            count );
+        return count;
+    }
+};
+
+/******************************************************************************
+  Bond reference geometry cache.
+******************************************************************************/
+
+// Storage location of bond n of particle i: padded rows for particles
+// [begin, end), or one row per bond at the CSR row offset.
+template <class MemorySpace, class BondStorageType>
+struct BondIndex
+{
+    std::size_t first_row = 0;
+
+    BondIndex() = default;
+
+    template <class NeighborListType>
+    BondIndex( const NeighborListType&, const std::size_t begin )
+        : first_row( begin )
+    {
+    }
+
+    template <class NeighborListType>
+    static std::size_t rows( const NeighborListType&, const std::size_t begin,
+                             const std::size_t end )
+    {
+        return end - begin;
+    }
+    static std::size_t columns( const int max_neighbors )
+    {
+        return max_neighbors;
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    std::size_t row( const int i, const int ) const { return i - first_row; }
+    KOKKOS_INLINE_FUNCTION
+    int column( const int n ) const { return n; }
+};
+
+template <class MemorySpace>
+struct BondIndex<MemorySpace, CSRBondStorage>
+{
+    Kokkos::View<int*, MemorySpace> offsets;
+
+    BondIndex() = default;
+
+    template <class NeighborListType>
+    BondIndex( const NeighborListType& neigh_list, const std::size_t )
+        : offsets( neigh_list._data.offsets )
+    {
+    }
+
+    template <class NeighborListType>
+    static std::size_t rows( const NeighborListType& neigh_list,
+                             const std::size_t, const std::size_t )
+    {
+        return neigh_list._data.neighbors.size();
+    }
+    static std::size_t columns( const int ) { return 1; }
+
+    KOKKOS_INLINE_FUNCTION
+    std::size_t row( const int i, const int n ) const
+    {
+        return offsets( i ) + n;
+    }
+    KOKKOS_INLINE_FUNCTION
+    int column( const int ) const { return 0; }
+};
+
+template <class MemorySpace, class CacheType,
+          class BondStorageType = BitBondStorage>
+class BondCache;
+
+// Recompute the reference geometry for every bond.
+template <class MemorySpace, class BondStorageType>
+class BondCache<MemorySpace, NoBondCache, BondStorageType>
+{
+  public:
+    using memory_space = MemorySpace;
+
+    BondCache() = default;
+
+    template <class NeighborListType, class PosType, class VolType>
+    BondCache( const NeighborListType&, const PosType&, const VolType&,
+               const std::size_t, const std::size_t, const int )
+    {
+    }
+
+    template <class PosType, class DispType>
+    KOKKOS_INLINE_FUNCTION void
+    getDistanceComponents( const PosType& x, const DispType& u, const int i,
+                           const int j, const int, double& xi, double& r,
+                           double& s, double& rx, double& ry, double& rz ) const
+    {
+        CabanaPD::getDistanceComponents( x, u, i, j, xi, r, s, rx, ry, rz );
+    }
+
+    template <class PosType, class DispType>
+    KOKKOS_INLINE_FUNCTION void
+    getDistance( const PosType& x, const DispType& u, const int i, const int j,
+                 const int, double& xi, double& r, double& s ) const
+    {
+        CabanaPD::getDistance( x, u, i, j, xi, r, s );
+    }
+
+    template <class PosType>
+    KOKKOS_INLINE_FUNCTION double
+    getReferenceDistance( const PosType& x, const int i, const int j,
+                          const int ) const
+    {
+        return CabanaPD::getReferenceDistance( x, i, j );
+    }
+
+    template <class VolType>
+    KOKKOS_INLINE_FUNCTION double volume( const VolType& vol, const int,
+                                          const int j, const int ) const
+    {
+        return vol( j );
+    }
+
+    double bytes() const { return 0.0; }
+
+    // The influence function is evaluated for every bond.
+    template <class InfluenceType>
+    void buildInfluence( const InfluenceType&, const std::size_t,
+                         const std::size_t )
+    {
+    }
+
+    template <class InfluenceType>
+    KOKKOS_INLINE_FUNCTION double influence( const InfluenceType& omega,
+                                             const double xi, const int,
+                                             const int ) const
+    {
+        return omega( xi );
+    }
+};
+
+// Store the reference bond length to avoid one square root per bond.
+template <class MemorySpace, class BondStorageType>
+class BondCache<MemorySpace, BondLengthCache, BondStorageType>
+{
+  public:
+    using memory_space = MemorySpace;
+    using exec_space = typename memory_space::execution_space;
+
+  protected:
+    // Rows are stored for particles [begin, end) only.
+    BondIndex<MemorySpace, BondStorageType> _index;
+    Kokkos::View<double**, memory_space> _xi;
+
+  public:
+    BondCache() = default;
+
+    template <class NeighborListType, class PosType, class VolType>
+    BondCache( const NeighborListType& neigh_list, const PosType& x,
+               const VolType&, const std::size_t begin, const std::size_t end,
+               const int max_neighbors )
+        : _index( neigh_list, begin )
+        , _xi( Kokkos::ViewAllocateWithoutInitializing( "bond_xi" ),
+               _index.rows( neigh_list, begin, end ),
+               _index.columns( max_neighbors ) )
+    {
+        auto xi_cache = _xi;
+        auto index = _index;
+        auto build_func = KOKKOS_LAMBDA( const int i )
+        {
+            std::size_t num_neighbors =
+                Cabana::NeighborList<NeighborListType>::numNeighbor(
+                    neigh_list, i );
+            for ( std::size_t n = 0; n < num_neighbors; n++ )
+            {
+                std::size_t j =
+                    Cabana::NeighborList<NeighborListType>::getNeighbor(
+                        neigh_list, i, n );
+                const double xi_x = x( j, 0 ) - x( i, 0 );
+                const double xi_y = x( j, 1 ) - x( i, 1 );
+                const double xi_z = component<2>( x, j ) - component<2>( x, i );
+                xi_cache( index.row( i, n ), index.column( n ) ) =
+                    Kokkos::sqrt( xi_x * xi_x + xi_y * xi_y + xi_z * xi_z );
+            }
+        };
+        Kokkos::RangePolicy<exec_space> policy( begin, end );
+        Kokkos::parallel_for( "CabanaPD::BondLengthCache::build", policy,
+                              build_func );
+    }
+
+    template <class PosType, class DispType>
+    KOKKOS_INLINE_FUNCTION void
+    getDistanceComponents( const PosType& x, const DispType& u, const int i,
+                           const int j, const int n, double& xi, double& r,
+                           double& s, double& rx, double& ry, double& rz ) const
+    {
+        rx = x( j, 0 ) - x( i, 0 ) + u( j, 0 ) - u( i, 0 );
+        ry = x( j, 1 ) - x( i, 1 ) + u( j, 1 ) - u( i, 1 );
+        rz = component<2>( x, j ) - component<2>( x, i ) +
+             component<2>( u, j ) - component<2>( u, i );
+        r = Kokkos::sqrt( rx * rx + ry * ry + rz * rz );
+        xi = _xi( _index.row( i, n ), _index.column( n ) );
+        s = ( r - xi ) / xi;
+    }
+
+    template <class PosType, class DispType>
+    KOKKOS_INLINE_FUNCTION void
+    getDistance( const PosType& x, const DispType& u, const int i, const int j,
+                 const int n, double& xi, double& r, double& s ) const
+    {
+        double rx, ry, rz;
+        getDistanceComponents( x, u, i, j, n, xi, r, s, rx, ry, rz );
+    }
+
+    template <class PosType>
+    KOKKOS_INLINE_FUNCTION double getReferenceDistance( const PosType&,
+                                                        const int i, const int,
+                                                        const int n ) const
+    {
+        return _xi( _index.row( i, n ), _index.column( n ) );
+    }
+
+    template <class VolType>
+    KOKKOS_INLINE_FUNCTION double volume( const VolType& vol, const int,
+                                          const int j, const int ) const
+    {
+        return vol( j );
+    }
+
+    double bytes() const { return viewBytes( _xi ); }
+
+    // The influence function is evaluated for every bond.
+    template <class InfluenceType>
+    void buildInfluence( const InfluenceType&, const std::size_t,
+                         const std::size_t )
+    {
+    }
+
+    template <class InfluenceType>
+    KOKKOS_INLINE_FUNCTION double influence( const InfluenceType& omega,
+                                             const double xi, const int,
+                                             const int ) const
+    {
+        return omega( xi );
+    }
+};
+
+// Store the reference bond length, direction, and neighbor volume so that
+// reference positions and volumes of neighbors are never read.
+template <class MemorySpace, class BondStorageType>
+class BondCache<MemorySpace, BondGeometryCache, BondStorageType>
+{
+  public:
+    using memory_space = MemorySpace;
+    using exec_space = typename memory_space::execution_space;
+
+  protected:
+    // Rows are stored for particles [begin, end) only.
+    BondIndex<MemorySpace, BondStorageType> _index;
+    Kokkos::View<double**, memory_space> _xi;
+    Kokkos::View<double** [3], memory_space> _e;
+    Kokkos::View<double**, memory_space> _vol;
+
+  public:
+    BondCache() = default;
+
+    template <class NeighborListType, class PosType, class VolType>
+    BondCache( const NeighborListType& neigh_list, const PosType& x,
+               const VolType& vol, const std::size_t begin,
+               const std::size_t end, const int max_neighbors )
+        : _index( neigh_list, begin )
+        , _xi( Kokkos::ViewAllocateWithoutInitializing( "bond_xi" ),
+               _index.rows( neigh_list, begin, end ),
+               _index.columns( max_neighbors ) )
+        , _e( Kokkos::ViewAllocateWithoutInitializing( "bond_direction" ),
+              _index.rows( neigh_list, begin, end ),
+              _index.columns( max_neighbors ) )
+        , _vol( Kokkos::ViewAllocateWithoutInitializing( "bond_volume" ),
+                _index.rows( neigh_list, begin, end ),
+                _index.columns( max_neighbors ) )
+    {
+        auto xi_cache = _xi;
+        auto e_cache = _e;
+        auto vol_cache = _vol;
+        auto index = _index;
+        auto build_func = KOKKOS_LAMBDA( const int i )
+        {
+            std::size_t num_neighbors =
+                Cabana::NeighborList<NeighborListType>::numNeighbor(
+                    neigh_list, i );
+            for ( std::size_t n = 0; n < num_neighbors; n++ )
+            {
+                std::size_t j =
+                    Cabana::NeighborList<NeighborListType>::getNeighbor(
+                        neigh_list, i, n );
+                const double xi_x = x( j, 0 ) - x( i, 0 );
+                const double xi_y = x( j, 1 ) - x( i, 1 );
+                const double xi_z = component<2>( x, j ) - component<2>( x, i );
+                const double xi =
+                    Kokkos::sqrt( xi_x * xi_x + xi_y * xi_y + xi_z * xi_z );
+                const std::size_t b = index.row( i, n );
+                const int c = index.column( n );
+                xi_cache( b, c ) = xi;
+                e_cache( b, c, 0 ) = xi_x / xi;
+                e_cache( b, c, 1 ) = xi_y / xi;
+                e_cache( b, c, 2 ) = xi_z / xi;
+                vol_cache( b, c ) = vol( j );
+            }
+        };
+        Kokkos::RangePolicy<exec_space> policy( begin, end );
+        Kokkos::parallel_for( "CabanaPD::BondGeometryCache::build", policy,
+                              build_func );
+    }
+
+    template <class PosType, class DispType>
+    KOKKOS_INLINE_FUNCTION void
+    getDistanceComponents( const PosType&, const DispType& u, const int i,
+                           const int j, const int n, double& xi, double& r,
+                           double& s, double& rx, double& ry, double& rz ) const
+    {
+        const std::size_t b = _index.row( i, n );
+        const int c = _index.column( n );
+        xi = _xi( b, c );
+        rx = xi * _e( b, c, 0 ) + u( j, 0 ) - u( i, 0 );
+        ry = xi * _e( b, c, 1 ) + u( j, 1 ) - u( i, 1 );
+        rz = xi * _e( b, c, 2 ) + component<2>( u, j ) - component<2>( u, i );
+        r = Kokkos::sqrt( rx * rx + ry * ry + rz * rz );
+        s = ( r - xi ) / xi;
+    }
+
+    template <class PosType, class DispType>
+    KOKKOS_INLINE_FUNCTION void
+    getDistance( const PosType& x, const DispType& u, const int i, const int j,
+                 const int n, double& xi, double& r, double& s ) const
+    {
+        double rx, ry, rz;
+        getDistanceComponents( x, u, i, j, n, xi, r, s, rx, ry, rz );
+    }
+
+    template <class PosType>
+    KOKKOS_INLINE_FUNCTION double getReferenceDistance( const PosType&,
+                                                        const int i, const int,
+                                                        const int n ) const
+    {
+        return _xi( _index.row( i, n ), _index.column( n ) );
+    }
+
+    template <class VolType>
+    KOKKOS_INLINE_FUNCTION double volume( const VolType&, const int i,
+                                          const int, const int n ) const
+    {
+        return _vol( _index.row( i, n ), _index.column( n ) );
+    }
+
+    double bytes() const
+    {
+        return viewBytes( _xi ) + viewBytes( _e ) + viewBytes( _vol );
+    }
+
+    // The influence function is evaluated for every bond.
+    template <class InfluenceType>
+    void buildInfluence( const InfluenceType&, const std::size_t,
+                         const std::size_t )
+    {
+    }
+
+    template <class InfluenceType>
+    KOKKOS_INLINE_FUNCTION double influence( const InfluenceType& omega,
+                                             const double xi, const int,
+                                             const int ) const
+    {
+        return omega( xi );
+    }
+};
+
+// Additionally tabulate the influence function value of every bond once the
+// force model (and therefore the influence function) is known.
+template <class MemorySpace, class BondStorageType>
+class BondCache<MemorySpace, BondInfluenceCache, BondStorageType>
+    : public BondCache<MemorySpace, BondGeometryCache, BondStorageType>
+{
+  public:
+    using base_type =
+        BondCache<MemorySpace, BondGeometryCache, BondStorageType>;
+    using memory_space = typename base_type::memory_space;
+    using exec_space = typename base_type::exec_space;
+
+  protected:
+    using base_type::_index;
+    using base_type::_xi;
+    Kokkos::View<double**, memory_space> _omega;
+
+  public:
+    BondCache() = default;
+
+    template <class NeighborListType, class PosType, class VolType>
+    BondCache( const NeighborListType& neigh_list, const PosType& x,
+               const VolType& vol, const std::size_t begin,
+               const std::size_t end, const int max_neighbors )
+        : base_type( neigh_list, x, vol, begin, end, max_neighbors )
+        , _omega( "bond_influence", _index.rows( neigh_list, begin, end ),
+                  _index.columns( max_neighbors ) )
+    {
+    }
+
+    // All stored entries are computed (rows are stored for [begin, end) only);
+    // entries beyond the neighbor count of each particle are never read.
+    template <class InfluenceType>
+    void buildInfluence( const InfluenceType& omega, const std::size_t,
+                         const std::size_t )
+    {
+        auto xi_cache = _xi;
+        auto omega_cache = _omega;
+        const std::size_t num_columns = _omega.extent( 1 );
+        auto build_func = KOKKOS_LAMBDA( const int b )
+        {
+            for ( std::size_t c = 0; c < num_columns; c++ )
+                omega_cache( b, c ) = omega( xi_cache( b, c ) );
+        };
+        Kokkos::RangePolicy<exec_space> policy( 0, _omega.extent( 0 ) );
+        Kokkos::parallel_for( "CabanaPD::BondInfluenceCache::build", policy,
+                              build_func );
+    }
+
+    template <class InfluenceType>
+    KOKKOS_INLINE_FUNCTION double influence( const InfluenceType&,
+                                             const double, const int i,
+                                             const int n ) const
+    {
+        return _omega( _index.row( i, n ), _index.column( n ) );
+    }
+
+    double bytes() const { return base_type::bytes() + viewBytes( _omega ); }
+};
+
+template <class MemorySpace, class BondStorageType = BitBondStorage,
+          class BondCacheType = NoBondCache>
 class BaseFracture
 {
   protected:
     using memory_space = MemorySpace;
-    using NeighborView = typename Kokkos::View<int**, memory_space>;
+    using bond_storage_type = BondStorageType;
+    using bond_cache_type = BondCacheType;
+    using NeighborView = BrokenBonds<memory_space, bond_storage_type>;
+    using BondCacheView =
+        BondCache<memory_space, bond_cache_type, bond_storage_type>;
     NeighborView _mu;
+    BondCacheView _bond_cache;
+    // Volume of the bonds removed by compaction for each particle, such that
+    // damage remains relative to the original bonds.
+    Kokkos::View<double*, memory_space> _removed_volume;
 
   public:
-    BaseFracture( const int local_particles, const int max_neighbors )
+    // Frozen particles own no bonds in the full neighbor list, so broken bond
+    // rows start at the first non-frozen particle.
+    BaseFracture( const int local_particles, const int max_neighbors,
+                  const int first_row = 0 )
+        : _mu( local_particles, max_neighbors, first_row )
+        , _removed_volume( "removed_bond_volume", local_particles )
+    {
+    }
+
+    // Storage matching the given neighbor list (required for CSR storage).
+    template <class NeighborListType>
+    BaseFracture( const NeighborListType& neigh_list, const int local_particles,
+                  const int max_neighbors, const int first_row )
+        : _mu( neigh_list, local_particles, max_neighbors, first_row )
+        , _removed_volume( "removed_bond_volume", local_particles )
     {
-        // Create View to track broken bonds.
-        // TODO: this could be optimized to ignore frozen particle bonds.
-        _mu = NeighborView(
-            Kokkos::ViewAllocateWithoutInitializing( "broken_bonds" ),
-            local_particles, max_neighbors );
-        Kokkos::deep_copy( _mu, 1 );
     }
 
-    BaseFracture( NeighborView mu )
+    BaseFracture( NeighborView mu, BondCacheView bond_cache = BondCacheView() )
         : _mu( mu )
+        , _bond_cache( bond_cache )
+        , _removed_volume( "removed_bond_volume", mu.extent( 0 ) )
+    {
+    }
+
+    // Reference positions never change, so this is only done once after the
+    // neighbor list is built.
+    template <class NeighborListType, class PosType, class VolType>
+    void buildBondCache( const NeighborListType& neigh_list, const PosType& x,
+                         const VolType& vol, const std::size_t begin,
+                         const std::size_t end, const int max_neighbors )
+    {
+        _bond_cache =
+            BondCacheView( neigh_list, x, vol, begin, end, max_neighbors );
+    }
+
+    // Tabulate the influence function per bond (only stored by the influence
+    // cache). This must follow each bond cache (re)build.
+    template <class InfluenceType>
+    void buildBondInfluence( const InfluenceType& influence,
+                             const std::size_t begin, const std::size_t end )
+    {
+        _bond_cache.buildInfluence( influence, begin, end );
+    }
+
+    // Replace the broken bonds after particle migration (rows matching the
+    // rebuilt neighbor list) and rebuild the bond cache.
+    template <class NeighborListType, class PosType, class VolType>
+    void rebuildFracture( const NeighborView& mu,
+                          const NeighborListType& neigh_list, const PosType& x,
+                          const VolType& vol, const std::size_t begin,
+                          const std::size_t end, const int max_neighbors )
     {
+        if ( mu.extent( 0 ) < end ||
+             mu.extent( 1 ) < static_cast<std::size_t>( max_neighbors ) )
+            throw std::runtime_error(
+                "Broken bond storage does not match the rebuilt neighbors." );
+        _mu = mu;
+        _removed_volume =
+            Kokkos::View<double*, memory_space>( "removed_bond_volume", end );
+        buildBondCache( neigh_list, x, vol, begin, end, max_neighbors );
+    }
+
+    // Fraction of the bonds in the neighbor list which are broken.
+    template <class NeighborListType>
+    double brokenBondFraction( const NeighborListType& neigh_list,
+                               const std::size_t begin,
+                               const std::size_t end ) const
+    {
+        auto mu = _mu;
+        using exec_space = typename memory_space::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( begin, end );
+        // Total and broken bonds.
+        BondSum<2> sum;
+        Kokkos::parallel_reduce(
+            "CabanaPD::Fracture::brokenFraction", policy,
+            KOKKOS_LAMBDA( const int i, BondSum<2>& s ) {
+                std::size_t num_neighbors =
+                    Cabana::NeighborList<NeighborListType>::numNeighbor(
+                        neigh_list, i );
+                for ( std::size_t n = 0; n < num_neighbors; n++ )
+                    s[1] += 1 - mu( i, n );
+                s[0] += num_neighbors;
+            },
+            Kokkos::Sum<BondSum<2>>( sum ) );
+        return sum[0] > 0.0 ? sum[1] / sum[0] : 0.0;
+    }
+
+    // Remove broken bonds from the neighbor rows and reset the broken bond
+    // storage and bond cache to match.
+    template <class NeighborListType, class PosType, class VolType>
+    void compactBonds( NeighborListType& neigh_list, const PosType& x,
+                       const VolType& vol, const std::size_t begin,
+                       const std::size_t end, const int max_neighbors )
+    {
+        auto mu = _mu;
+        auto bond_cache = _bond_cache;
+        auto removed_volume = _removed_volume;
+        NeighborRows<NeighborListType> neighbors( neigh_list );
+        auto counts = neighbors.counts;
+        auto compact_row = KOKKOS_LAMBDA( const int i )
+        {
+            const int num_neighbors = counts( i );
+            int kept = 0;
+            for ( int n = 0; n < num_neighbors; n++ )
+            {
+                const int j = neighbors( i, n );
+                if ( mu( i, n ) > 0 )
+                    neighbors( i, kept++ ) = j;
+                else
+                    removed_volume( i ) += bond_cache.volume( vol, i, j, n );
+            }
+            counts( i ) = kept;
+        };
+        using exec_space = typename memory_space::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( begin, end );
+        Kokkos::parallel_for( "CabanaPD::Fracture::compactBonds", policy,
+                              compact_row );
+
+        // All remaining bonds are intact.
+        _mu = NeighborView( neigh_list, _mu.extent( 0 ), _mu.extent( 1 ),
+                            _mu.firstRow() );
+        buildBondCache( neigh_list, x, vol, begin, end, max_neighbors );
     }
 
     template <class ExecSpace, class ParticleType, class PrenotchType,
@@ -269,10 +1803,24 @@ class BaseFracture
     }
 
     auto getBrokenBonds() const { return _mu; }
+    auto getBondCache() const { return _bond_cache; }
+    auto getRemovedVolume() const { return _removed_volume; }
+
+    // Broken bond storage (_mu) and the bond cache.
+    void bondMemory( MemoryRegistry& registry ) const
+    {
+        registry.add( "Force::BrokenBonds",
+                      _mu.bytes() + viewBytes( _removed_volume ) );
+        registry.add( "Force::BondCache", _bond_cache.bytes() );
+    }
 };
 
 /******************************************************************************
   Force free functions.
+
+  Kernels are only ordered on the default execution space instance: there is
+  no host fence after launching forces, so the host only synchronizes for
+  reductions, communication, and output.
 ******************************************************************************/
 template <class ForceType, class ParticleType, class ParallelType>
 void computeForce( ForceType& force, ParticleType& particles,
@@ -287,17 +1835,93 @@ void computeForce( ForceType& force, ParticleType& particles,
     if ( reset )
         Cabana::deep_copy( f, 0.0 );
 
-    // if ( half_neigh )
-    // Forces must be atomic for half list
-    // computeForce_half( f_a, x, u,
-    //                    neigh_op_tag );
-
+    // Forces must be atomic for half list. Ghost forces must then be
+    // scattered back to the owning ranks.
+    if ( force.halfNeighbor() )
+        force.computeForceHalf( f_a, x, u, particles, neigh_op_tag );
     // Forces only atomic if using team threading.
-    if ( std::is_same<decltype( neigh_op_tag ), Cabana::TeamOpTag>::value )
+    else if ( is_team_op<ParallelType>::value )
         force.computeForceFull( f_a, x, u, particles, neigh_op_tag );
     else
         force.computeForceFull( f, x, u, particles, neigh_op_tag );
-    Kokkos::fence();
+}
+
+// Compute forces for owned particles [begin, end) only.
+template <class ForceType, class ParticleType, class ParallelType>
+void computeForce( ForceType& force, ParticleType& particles,
+                   const ParallelType& neigh_op_tag, const std::size_t begin,
+                   const std::size_t end, const bool reset )
+{
+    if ( force.halfNeighbor() )
+        throw std::runtime_error(
+            "Force subsets are not supported with half neighbor lists." );
+
+    force.setParticleRange( begin, end );
+    computeForce( force, particles, neigh_op_tag, reset );
+    force.resetParticleRange();
+}
+
+// Compute forces with the current bonds, without checking for new broken
+// bonds. Falls back to the standard kernel for models without fracture and
+// for half neighbor lists.
+template <class ForceType, class ParticleType, class ParallelType>
+void computeForceNoBreaking( ForceType& force, ParticleType& particles,
+                             const ParallelType& neigh_op_tag,
+                             const bool reset = true )
+{
+    if constexpr ( ForceType::has_bond_breaking )
+    {
+        if ( !force.halfNeighbor() )
+        {
+            auto x = particles.sliceReferencePosition();
+            auto u = particles.sliceDisplacement();
+            auto f = particles.sliceForce();
+            auto f_a = particles.sliceForceAtomic();
+
+            if ( reset )
+                Cabana::deep_copy( f, 0.0 );
+            if ( is_team_op<ParallelType>::value )
+                force.computeForceFull( f_a, x, u, particles, neigh_op_tag,
+                                        NoBondBreaking{} );
+            else
+                force.computeForceFull( f, x, u, particles, neigh_op_tag,
+                                        NoBondBreaking{} );
+            return;
+        }
+    }
+    computeForce( force, particles, neigh_op_tag, reset );
+}
+
+// Compute forces, only checking bonds for breaking for the particles in the
+// active set (see updateActiveBonds). Falls back to the standard kernel for
+// models without an active set, before it is built, and for half neighbor
+// lists.
+template <class ForceType, class ParticleType, class ParallelType>
+void computeForceActiveBreaking( ForceType& force, ParticleType& particles,
+                                 const ParallelType& neigh_op_tag,
+                                 const bool reset = true )
+{
+    if constexpr ( ForceType::has_active_bond_breaking )
+    {
+        if ( !force.halfNeighbor() && force.activeBondBreaking() )
+        {
+            auto x = particles.sliceReferencePosition();
+            auto u = particles.sliceDisplacement();
+            auto f = particles.sliceForce();
+            auto f_a = particles.sliceForceAtomic();
+
+            if ( reset )
+                Cabana::deep_copy( f, 0.0 );
+            if ( is_team_op<ParallelType>::value )
+                force.computeForceFull( f_a, x, u, particles, neigh_op_tag,
+                                        ActiveBondBreaking{} );
+            else
+                force.computeForceFull( f, x, u, particles, neigh_op_tag,
+                                        ActiveBondBreaking{} );
+            return;
+        }
+    }
+    computeForce( force, particles, neigh_op_tag, reset );
 }
 
 template <class ForceType, class ParticleType, class ParallelType>
@@ -316,16 +1940,127 @@ double computeEnergy( ForceType& force, ParticleType& particles,
         // Reset energy.
         Cabana::deep_copy( W, 0.0 );
 
-        // if ( _half_neigh )
-        //    energy = computeEnergy_half( force, x, u,
-        //                                   neigh_op_tag );
-        // else
-        energy = force.computeEnergyFull( W, x, u, particles, neigh_op_tag );
+        // Ghost energy and damage must be scattered back to the owning ranks
+        // and damage finalized with computeDamage for half lists.
+        if ( force.halfNeighbor() )
+        {
+            auto W_a = particles.sliceStrainEnergyAtomic();
+            energy = force.computeEnergyHalf( W_a, x, u, particles,
+                                              neigh_op_tag );
+        }
+        // Energy only atomic if using team threading.
+        else if ( is_team_op<ParallelType>::value )
+        {
+            auto W_a = particles.sliceStrainEnergyAtomic();
+            energy =
+                force.computeEnergyFull( W_a, x, u, particles, neigh_op_tag );
+        }
+        else
+            energy =
+                force.computeEnergyFull( W, x, u, particles, neigh_op_tag );
         Kokkos::fence();
     }
     return energy;
 }
 
+// Compute forces together with energy and damage (used on output steps). This
+// falls back to separate passes without a fused kernel or for half lists.
+template <class ForceType, class ParticleType, class ParallelType>
+double computeForceAndEnergy( ForceType& force, ParticleType& particles,
+                              const ParallelType& neigh_op_tag )
+{
+    if constexpr (
+        is_energy_output<typename ParticleType::output_type>::value &&
+        ForceType::has_fused_energy )
+    {
+        if ( !force.halfNeighbor() )
+        {
+            auto x = particles.sliceReferencePosition();
+            auto u = particles.sliceDisplacement();
+            auto f = particles.sliceForce();
+            auto f_a = particles.sliceForceAtomic();
+            auto W = particles.sliceStrainEnergy();
+            auto W_a = particles.sliceStrainEnergyAtomic();
+
+            // Reset force and energy.
+            Cabana::deep_copy( f, 0.0 );
+            Cabana::deep_copy( W, 0.0 );
+
+            double energy;
+            // Only atomic if using team threading.
+            if ( is_team_op<ParallelType>::value )
+                energy = force.computeForceEnergyFull(
+                    f_a, W_a, x, u, particles, neigh_op_tag );
+            else
+                energy = force.computeForceEnergyFull( f, W, x, u, particles,
+                                                       neigh_op_tag );
+            Kokkos::fence();
+            return energy;
+        }
+    }
+    computeForce( force, particles, neigh_op_tag );
+    return computeEnergy( force, particles, neigh_op_tag );
+}
+
+// Compute forces together with energy and damage with the current bonds,
+// without checking for new broken bonds (used for output between breaking
+// passes). Falls back to separate passes as in computeForceAndEnergy.
+template <class ForceType, class ParticleType, class ParallelType>
+double computeForceAndEnergyNoBreaking( ForceType& force,
+                                        ParticleType& particles,
+                                        const ParallelType& neigh_op_tag )
+{
+    if constexpr ( ForceType::has_bond_breaking )
+    {
+        if constexpr (
+            is_energy_output<typename ParticleType::output_type>::value &&
+            ForceType::has_fused_energy )
+        {
+            if ( !force.halfNeighbor() )
+            {
+                auto x = particles.sliceReferencePosition();
+                auto u = particles.sliceDisplacement();
+                auto f = particles.sliceForce();
+                auto f_a = particles.sliceForceAtomic();
+                auto W = particles.sliceStrainEnergy();
+                auto W_a = particles.sliceStrainEnergyAtomic();
+
+                // Reset force and energy.
+                Cabana::deep_copy( f, 0.0 );
+                Cabana::deep_copy( W, 0.0 );
+
+                double energy;
+                // Only atomic if using team threading.
+                if ( is_team_op<ParallelType>::value )
+                    energy = force.computeForceEnergyFull(
+                        f_a, W_a, x, u, particles, neigh_op_tag,
+                        NoBondBreaking{} );
+                else
+                    energy = force.computeForceEnergyFull(
+                        f, W, x, u, particles, neigh_op_tag,
+                        NoBondBreaking{} );
+                Kokkos::fence();
+                return energy;
+            }
+        }
+        computeForceNoBreaking( force, particles, neigh_op_tag );
+        return computeEnergy( force, particles, neigh_op_tag );
+    }
+    return computeForceAndEnergy( force, particles, neigh_op_tag );
+}
+
+// Normalize damage after ghost contributions have been scattered (only needed
+// for half neighbor lists).
+template <class ForceType, class ParticleType>
+void computeDamage( ForceType& force, ParticleType& particles )
+{
+    if constexpr ( is_energy_output<typename ParticleType::output_type>::value )
+    {
+        if ( force.halfNeighbor() )
+            force.computeDamageHalf( particles );
+    }
+}
+
 } // namespace CabanaPD
 
 #endif
@@ -12,6 +12,10 @@
 #ifndef FORCE_MODELS_H
 #define FORCE_MODELS_H
 
+#include <stdexcept>
+
+#include <Kokkos_Core.hpp>
+
 #include <CabanaPD_Constants.hpp>
 #include <CabanaPD_Types.hpp>
 
@@ -20,15 +24,127 @@ namespace CabanaPD
 struct BaseForceModel
 {
     double delta;
+    // System dimension the model parameters are derived for (2d is per unit
+    // thickness).
+    int dim;
 
-    BaseForceModel( const double _delta )
-        : delta( _delta ){};
+    BaseForceModel( const double _delta, const int _dim = 3 )
+        : delta( _delta )
+        , dim( _dim )
+    {
+        if ( dim != 2 && dim != 3 )
+            throw std::runtime_error( "Force models require 2d or 3d." );
+    };
 
     // No-op for temperature.
     KOKKOS_INLINE_FUNCTION
     void thermalStretch( double&, const int, const int ) const {}
 };
 
+/******************************************************************************
+  Influence functions.
+
+  Passing one of these (or any copyable functor with a device callable
+  double operator()( double xi )) as a force model template parameter fixes
+  the influence function at compile time.
+******************************************************************************/
+struct ConstantInfluence
+{
+    ConstantInfluence() = default;
+    ConstantInfluence( const double ) {}
+
+    KOKKOS_INLINE_FUNCTION double operator()( const double ) const
+    {
+        return 1.0;
+    }
+};
+
+struct InverseInfluence
+{
+    InverseInfluence() = default;
+    InverseInfluence( const double ) {}
+
+    KOKKOS_INLINE_FUNCTION double operator()( const double xi ) const
+    {
+        return 1.0 / xi;
+    }
+};
+
+struct GaussianInfluence
+{
+    double inv_length2;
+
+    GaussianInfluence( const double length )
+        : inv_length2( 1.0 / ( length * length ) )
+    {
+    }
+
+    KOKKOS_INLINE_FUNCTION double operator()( const double xi ) const
+    {
+        return Kokkos::exp( -xi * xi * inv_length2 );
+    }
+};
+
+// Influence function chosen at runtime (0: constant, 1: 1/xi).
+struct RuntimeInfluence
+{
+    int type;
+
+    RuntimeInfluence( const int _type = 0 )
+        : type( _type )
+    {
+    }
+
+    KOKKOS_INLINE_FUNCTION double operator()( const double xi ) const
+    {
+        if ( type == 1 )
+            return 1.0 / xi;
+        else
+            return 1.0;
+    }
+};
+
+/******************************************************************************
+  Bond horizon for variable resolution.
+
+  The horizon of each particle scales with its spacing relative to the
+  reference (unrefined) particle volume, for which the model horizon applies.
+  Each bond uses the larger horizon of its two particles such that bonds stay
+  symmetric. Without a reference volume the model horizon is used throughout.
+******************************************************************************/
+template <class VolumeType>
+struct BondHorizon
+{
+    double delta;
+    double inv_reference_volume;
+    VolumeType vol;
+
+    BondHorizon( const double _delta, const double reference_volume,
+                 const VolumeType& _vol )
+        : delta( _delta )
+        , inv_reference_volume( reference_volume > 0.0 ? 1.0 / reference_volume
+                                                       : 0.0 )
+        , vol( _vol )
+    {
+    }
+
+    void update( const VolumeType& _vol ) { vol = _vol; }
+
+    // Bond horizon relative to the model horizon.
+    KOKKOS_INLINE_FUNCTION double ratio( const int i, const int j ) const
+    {
+        if ( inv_reference_volume == 0.0 )
+            return 1.0;
+        return Kokkos::cbrt( Kokkos::max( vol( i ), vol( j ) ) *
+                             inv_reference_volume );
+    }
+
+    KOKKOS_INLINE_FUNCTION double operator()( const int i, const int j ) const
+    {
+        return delta * ratio( i, j );
+    }
+};
+
 template <typename TemperatureType>
 struct BaseTemperatureModel
 {
@@ -0,0 +1,432 @@
+/****************************************************************************
+ * Copyright (c) 2022 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of CabanaPD. CabanaPD is distributed under a           *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mpi.h"
+
+#include <Kokkos_Core.hpp>
+
+namespace CabanaPD
+{
+/******************************************************************************
+  Parallel geometry import.
+
+  Geometry files store particles grouped into spatial chunks. The file starts
+  with a header (magic, version, number of chunks, number of particles) and a
+  chunk table (bounding box, first particle, and particle count of each
+  chunk), followed by the particle records. Each rank reads the table once
+  (from rank 0) and then only streams the chunks overlapping its owned domain,
+  in batches of bounded size, such that memory per rank does not grow with
+  the geometry size. Files are created with writeGeometry.
+
+  Voxel files store a regular grid of particle types after a header (magic,
+  version, number of voxels, low corner, and voxel size). Voxels are stored
+  with x fastest, zero for empty and otherwise one more than the particle
+  type. Each rank reads only the block of voxels within its owned domain with
+  a single collective read. Files are created with writeVoxels.
+
+  Positions are always stored in 3d (z is ignored in 2d).
+******************************************************************************/
+
+// One particle in a geometry file.
+struct GeometryRecord
+{
+    double x[3];
+    double vol;
+    std::int32_t type;
+    std::int32_t nofail;
+};
+static_assert( sizeof( GeometryRecord ) == 40,
+               "Geometry records must not be padded." );
+
+// One spatial chunk of particles in a geometry file.
+struct GeometryChunk
+{
+    double low[3];
+    double high[3];
+    std::uint64_t first;
+    std::uint64_t count;
+};
+static_assert( sizeof( GeometryChunk ) == 64,
+               "Geometry chunks must not be padded." );
+
+// Open a file on all ranks with MPI-IO.
+inline MPI_File openGeometryFile( const std::string& file_name,
+                                  const int mode )
+{
+    MPI_File file;
+    int error = MPI_File_open( MPI_COMM_WORLD, file_name.c_str(), mode,
+                               MPI_INFO_NULL, &file );
+    if ( error != MPI_SUCCESS )
+        throw std::runtime_error( "Could not open geometry file " +
+                                  file_name );
+    return file;
+}
+
+class GeometryReader
+{
+  public:
+    // magic, version, number of chunks, number of particles.
+    static constexpr int header_size = 4;
+    static constexpr std::uint64_t magic = 0x43504447454f4d31;
+    static constexpr std::uint64_t version = 1;
+
+    // Read the chunk table (collective).
+    GeometryReader( const std::string& file_name,
+                    const std::size_t batch_size = 1 << 20 )
+        : _file_name( file_name )
+        , _batch_size( std::max( batch_size, std::size_t( 1 ) ) )
+    {
+        int rank;
+        MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+        std::uint64_t header[header_size] = { 0, 0, 0, 0 };
+        MPI_File file = openGeometryFile( _file_name, MPI_MODE_RDONLY );
+        if ( rank == 0 )
+            MPI_File_read_at( file, 0, header, header_size, MPI_UINT64_T,
+                              MPI_STATUS_IGNORE );
+        MPI_Bcast( header, header_size, MPI_UINT64_T, 0, MPI_COMM_WORLD );
+        if ( header[0] != magic || header[1] != version )
+        {
+            MPI_File_close( &file );
+            throw std::runtime_error( _file_name +
+                                      " is not a CabanaPD geometry file." );
+        }
+        _num_particles = header[3];
+
+        _chunks.resize( header[2] );
+        const std::uint64_t table_bytes =
+            _chunks.size() * sizeof( GeometryChunk );
+        if ( table_bytes > static_cast<std::uint64_t>( INT_MAX ) )
+            throw std::runtime_error( "Geometry chunk table exceeds the "
+                                      "maximum MPI-IO read size." );
+        if ( rank == 0 )
+            MPI_File_read_at( file, sizeof( header ), _chunks.data(),
+                              static_cast<int>( table_bytes ), MPI_BYTE,
+                              MPI_STATUS_IGNORE );
+        MPI_Bcast( _chunks.data(), static_cast<int>( table_bytes ), MPI_BYTE, 0,
+                   MPI_COMM_WORLD );
+        MPI_File_close( &file );
+        _data_offset = sizeof( header ) + table_bytes;
+    }
+
+    std::size_t numParticles() const { return _num_particles; }
+    std::size_t numChunks() const { return _chunks.size(); }
+
+    // Chunks overlapping a box.
+    template <class ArrayType>
+    std::vector<std::size_t> overlapping( const ArrayType& low,
+                                          const ArrayType& high ) const
+    {
+        std::vector<std::size_t> chunks;
+        for ( std::size_t c = 0; c < _chunks.size(); c++ )
+        {
+            bool overlap = _chunks[c].count > 0;
+            for ( std::size_t d = 0; d < low.size(); d++ )
+                overlap = overlap && _chunks[c].low[d] <= high[d] &&
+                          _chunks[c].high[d] >= low[d];
+            if ( overlap )
+                chunks.push_back( c );
+        }
+        return chunks;
+    }
+
+    // Total number of particles in the given chunks.
+    std::size_t count( const std::vector<std::size_t>& chunks ) const
+    {
+        std::size_t num = 0;
+        for ( auto c : chunks )
+            num += _chunks[c].count;
+        return num;
+    }
+
+    // Stream the given chunks in batches (collective open and close), calling
+    // append( records, num_records ) with each batch in device memory.
+    template <class MemorySpace, class AppendFunctor>
+    void read( const std::vector<std::size_t>& chunks,
+               AppendFunctor append ) const
+    {
+        Kokkos::View<GeometryRecord*, MemorySpace> records(
+            Kokkos::ViewAllocateWithoutInitializing( "geometry_records" ),
+            std::min<std::size_t>( _batch_size,
+                                   std::max<std::size_t>( count( chunks ),
+                                                          1 ) ) );
+        auto records_host = Kokkos::create_mirror_view( records );
+
+        MPI_File file = openGeometryFile( _file_name, MPI_MODE_RDONLY );
+        for ( auto c : chunks )
+        {
+            for ( std::uint64_t begin = 0; begin < _chunks[c].count;
+                  begin += records.size() )
+            {
+                const std::size_t num = std::min<std::uint64_t>(
+                    records.size(), _chunks[c].count - begin );
+                const MPI_Offset offset =
+                    _data_offset +
+                    ( _chunks[c].first + begin ) * sizeof( GeometryRecord );
+                MPI_File_read_at( file, offset, records_host.data(),
+                                  static_cast<int>(
+                                      num * sizeof( GeometryRecord ) ),
+                                  MPI_BYTE, MPI_STATUS_IGNORE );
+                Kokkos::deep_copy( records, records_host );
+                append( records, num );
+            }
+        }
+        MPI_File_close( &file );
+    }
+
+  protected:
+    std::string _file_name;
+    std::size_t _batch_size;
+    std::size_t _num_particles = 0;
+    std::uint64_t _data_offset = 0;
+    std::vector<GeometryChunk> _chunks;
+};
+
+// Write particles to a geometry file, grouped into a regular grid of chunks
+// over their bounding box (from a single rank).
+inline void writeGeometry( const std::string& file_name,
+                           const std::vector<GeometryRecord>& particles,
+                           const std::array<int, 3> num_chunks )
+{
+    std::array<double, 3> low;
+    std::array<double, 3> high;
+    low.fill( std::numeric_limits<double>::max() );
+    high.fill( std::numeric_limits<double>::lowest() );
+    for ( const auto& p : particles )
+        for ( int d = 0; d < 3; d++ )
+        {
+            low[d] = std::min( low[d], p.x[d] );
+            high[d] = std::max( high[d], p.x[d] );
+        }
+
+    // Sort the particles by chunk.
+    const std::size_t total_chunks =
+        static_cast<std::size_t>( num_chunks[0] ) * num_chunks[1] *
+        num_chunks[2];
+    auto chunk_index = [&]( const GeometryRecord& p )
+    {
+        std::size_t index = 0;
+        for ( int d = 2; d >= 0; d-- )
+        {
+            const double width = ( high[d] - low[d] ) / num_chunks[d];
+            int i = width > 0.0 ? static_cast<int>( ( p.x[d] - low[d] ) / width )
+                                : 0;
+            i = std::min( std::max( i, 0 ), num_chunks[d] - 1 );
+            index = index * num_chunks[d] + i;
+        }
+        return index;
+    };
+    std::vector<GeometryChunk> chunks( total_chunks );
+    for ( auto& chunk : chunks )
+    {
+        chunk.count = 0;
+        for ( int d = 0; d < 3; d++ )
+        {
+            chunk.low[d] = std::numeric_limits<double>::max();
+            chunk.high[d] = std::numeric_limits<double>::lowest();
+        }
+    }
+    for ( const auto& p : particles )
+    {
+        auto& chunk = chunks[chunk_index( p )];
+        chunk.count++;
+        for ( int d = 0; d < 3; d++ )
+        {
+            chunk.low[d] = std::min( chunk.low[d], p.x[d] );
+            chunk.high[d] = std::max( chunk.high[d], p.x[d] );
+        }
+    }
+    std::uint64_t first = 0;
+    for ( auto& chunk : chunks )
+    {
+        chunk.first = first;
+        first += chunk.count;
+    }
+    std::vector<GeometryRecord> sorted( particles.size() );
+    std::vector<std::uint64_t> next( total_chunks );
+    for ( std::size_t c = 0; c < total_chunks; c++ )
+        next[c] = chunks[c].first;
+    for ( const auto& p : particles )
+        sorted[next[chunk_index( p )]++] = p;
+
+    std::ofstream out( file_name, std::ios::binary );
+    if ( !out )
+        throw std::runtime_error( "Could not open geometry file " +
+                                  file_name );
+    const std::uint64_t header[GeometryReader::header_size] = {
+        GeometryReader::magic, GeometryReader::version, total_chunks,
+        particles.size() };
+    out.write( reinterpret_cast<const char*>( header ), sizeof( header ) );
+    out.write( reinterpret_cast<const char*>( chunks.data() ),
+               chunks.size() * sizeof( GeometryChunk ) );
+    out.write( reinterpret_cast<const char*>( sorted.data() ),
+               sorted.size() * sizeof( GeometryRecord ) );
+}
+
+class VoxelReader
+{
+  public:
+    // magic, version, number of voxels in each dimension.
+    static constexpr int header_size = 5;
+    static constexpr std::uint64_t magic = 0x435044564f58454c;
+    static constexpr std::uint64_t version = 1;
+    static constexpr MPI_Offset data_offset =
+        header_size * sizeof( std::uint64_t ) + 6 * sizeof( double );
+
+    // Read the header (collective).
+    VoxelReader( const std::string& file_name )
+        : _file_name( file_name )
+    {
+        int rank;
+        MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+        std::uint64_t header[header_size] = { 0, 0, 0, 0, 0 };
+        double geometry[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+        MPI_File file = openGeometryFile( _file_name, MPI_MODE_RDONLY );
+        if ( rank == 0 )
+        {
+            MPI_File_read_at( file, 0, header, header_size, MPI_UINT64_T,
+                              MPI_STATUS_IGNORE );
+            MPI_File_read_at( file, sizeof( header ), geometry, 6, MPI_DOUBLE,
+                              MPI_STATUS_IGNORE );
+        }
+        MPI_File_close( &file );
+        MPI_Bcast( header, header_size, MPI_UINT64_T, 0, MPI_COMM_WORLD );
+        MPI_Bcast( geometry, 6, MPI_DOUBLE, 0, MPI_COMM_WORLD );
+        if ( header[0] != magic || header[1] != version )
+            throw std::runtime_error( _file_name +
+                                      " is not a CabanaPD voxel file." );
+        for ( int d = 0; d < 3; d++ )
+        {
+            _num_voxels[d] = static_cast<int>( header[2 + d] );
+            _low[d] = geometry[d];
+            _spacing[d] = geometry[3 + d];
+        }
+    }
+
+    auto numVoxels() const { return _num_voxels; }
+    auto lowCorner() const { return _low; }
+    auto spacing() const { return _spacing; }
+    double voxelVolume() const
+    {
+        return _spacing[0] * _spacing[1] * _spacing[2];
+    }
+
+    // Read the voxels with centers in the box [low, high), or up to and
+    // including high where include_high is set (collective). Returns the
+    // voxels (x fastest) in device memory and the first index and number
+    // of voxels of the block in each dimension.
+    template <class MemorySpace>
+    auto read( const std::array<double, 3> low,
+               const std::array<double, 3> high,
+               const std::array<bool, 3> include_high,
+               std::array<int, 3>& begin, std::array<int, 3>& extent ) const
+    {
+        for ( int d = 0; d < 3; d++ )
+        {
+            // Voxel i is centered at low + ( i + 0.5 ) spacing.
+            auto first_index = [&]( const double x, const bool inclusive )
+            {
+                const double i = ( x - _low[d] ) / _spacing[d] - 0.5;
+                const int index = inclusive
+                                      ? static_cast<int>( std::floor( i ) ) + 1
+                                      : static_cast<int>( std::ceil( i ) );
+                return std::min( std::max( index, 0 ), _num_voxels[d] );
+            };
+            begin[d] = first_index( low[d], false );
+            extent[d] =
+                std::max( first_index( high[d], include_high[d] ) - begin[d],
+                          0 );
+        }
+        const std::size_t num =
+            static_cast<std::size_t>( extent[0] ) * extent[1] * extent[2];
+        if ( num > static_cast<std::size_t>( INT_MAX ) )
+            throw std::runtime_error( "Voxel block per rank exceeds the "
+                                      "maximum MPI-IO read size." );
+        std::vector<std::uint8_t> block( num );
+
+        // One collective read of the block (stored with z slowest).
+        MPI_File file = openGeometryFile( _file_name, MPI_MODE_RDONLY );
+        MPI_Datatype block_type = MPI_BYTE;
+        if ( num > 0 )
+        {
+            int sizes[3] = { _num_voxels[2], _num_voxels[1], _num_voxels[0] };
+            int subsizes[3] = { extent[2], extent[1], extent[0] };
+            int starts[3] = { begin[2], begin[1], begin[0] };
+            MPI_Type_create_subarray( 3, sizes, subsizes, starts, MPI_ORDER_C,
+                                      MPI_BYTE, &block_type );
+            MPI_Type_commit( &block_type );
+        }
+        MPI_File_set_view( file, data_offset, MPI_BYTE, block_type, "native",
+                           MPI_INFO_NULL );
+        MPI_File_read_all( file, block.data(), static_cast<int>( num ),
+                           MPI_BYTE, MPI_STATUS_IGNORE );
+        MPI_File_close( &file );
+        if ( num > 0 )
+            MPI_Type_free( &block_type );
+
+        Kokkos::View<std::uint8_t*, MemorySpace> voxels(
+            Kokkos::ViewAllocateWithoutInitializing( "voxels" ), num );
+        Kokkos::View<std::uint8_t*, Kokkos::HostSpace,
+                     Kokkos::MemoryTraits<Kokkos::Unmanaged>>
+            block_host( block.data(), num );
+        Kokkos::deep_copy( voxels, block_host );
+        return voxels;
+    }
+
+  protected:
+    std::string _file_name;
+    std::array<int, 3> _num_voxels;
+    std::array<double, 3> _low;
+    std::array<double, 3> _spacing;
+};
+
+// Write a voxel file (from a single rank), with voxels stored x fastest.
+inline void writeVoxels( const std::string& file_name,
+                         const std::array<int, 3> num_voxels,
+                         const std::array<double, 3> low,
+                         const std::array<double, 3> spacing,
+                         const std::vector<std::uint8_t>& voxels )
+{
+    if ( voxels.size() != static_cast<std::size_t>( num_voxels[0] ) *
+                              num_voxels[1] * num_voxels[2] )
+        throw std::runtime_error( "Voxel count does not match the grid." );
+
+    std::ofstream out( file_name, std::ios::binary );
+    if ( !out )
+        throw std::runtime_error( "Could not open voxel file " + file_name );
+    const std::uint64_t header[VoxelReader::header_size] = {
+        VoxelReader::magic, VoxelReader::version,
+        static_cast<std::uint64_t>( num_voxels[0] ),
+        static_cast<std::uint64_t>( num_voxels[1] ),
+        static_cast<std::uint64_t>( num_voxels[2] ) };
+    const double geometry[6] = { low[0],     low[1],     low[2],
+                                 spacing[0], spacing[1], spacing[2] };
+    out.write( reinterpret_cast<const char*>( header ), sizeof( header ) );
+    out.write( reinterpret_cast<const char*>( geometry ), sizeof( geometry ) );
+    out.write( reinterpret_cast<const char*>( voxels.data() ), voxels.size() );
+}
+
+} // namespace CabanaPD
+
+#endif
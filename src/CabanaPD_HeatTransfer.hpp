@@ -19,11 +19,14 @@
 namespace CabanaPD
 {
 
-template <class MemorySpace, class ModelType>
+template <class MemorySpace, class ModelType,
+          class BondStorageType = BitBondStorage,
+          class BondCacheType = NoBondCache>
 class HeatTransfer;
 
-// Peridynamic heat transfer with forward-Euler time integration.
-// Inherits only because this is a similar neighbor-based kernel.
+// Peridynamic heat transfer with forward-Euler or RKL2 super-time-stepping
+// time integration. Inherits only because this is a similar neighbor-based
+// kernel.
 template <class MemorySpace, class MechanicsType, class... ModelParams>
 class HeatTransfer<MemorySpace, ForceModel<PMB, MechanicsType, NoFracture,
                                            DynamicTemperature, ModelParams...>>
@@ -41,8 +44,19 @@ class HeatTransfer<MemorySpace, ForceModel<PMB, MechanicsType, NoFracture,
     using base_type::_half_neigh;
     using base_type::_neigh_list;
     using base_type::_timer;
-    Timer _euler_timer = base_type::_energy_timer;
+    Timer _euler_timer = Timer( "HeatTransfer::Euler" );
+    Timer _rkl_timer = Timer( "HeatTransfer::RKL2" );
     model_type _model;
+    // Execution space instance for all heat transfer kernels, separate from
+    // the mechanics if set.
+    exec_space _space;
+
+    // Super-time-stepping state: initial temperature, the stage before the
+    // previous one, and the initial temperature rate.
+    using view_type = Kokkos::View<double*, MemorySpace>;
+    view_type _temp0;
+    view_type _temp_prev;
+    view_type _rate0;
 
   public:
     // Running with mechanics as well; no reason to rebuild neighbors.
@@ -52,36 +66,61 @@ class HeatTransfer<MemorySpace, ForceModel<PMB, MechanicsType, NoFracture,
         : base_type( half_neigh, force.getNeighbors() )
         , _model( model )
     {
+        _timer = Timer( "HeatTransfer" );
     }
 
+    void profile( TimerRegistry& timers,
+                  const std::string& name = "HeatTransfer" ) const
+    {
+        timers.add( name, _timer );
+        timers.add( name + "::Euler", _euler_timer );
+        timers.add( name + "::RKL2", _rkl_timer );
+    }
+
+    // Launch on the given instance (e.g. a separate stream). Kernels are then
+    // asynchronous with respect to the mechanics: the caller must fence the
+    // instance before temperature or conduction is used elsewhere.
+    void setExecutionSpace( const exec_space& space ) { _space = space; }
+    auto executionSpace() const { return _space; }
+
+    // Conduction only depends on the reference geometry and the temperature,
+    // such that it may run concurrently with the displacement update.
     template <class TemperatureType, class PosType, class ParticleType,
               class ParallelType>
     void computeHeatTransferFull( TemperatureType& conduction, const PosType& x,
-                                  const PosType& u,
-                                  const ParticleType& particles,
-                                  ParallelType& neigh_op_tag )
+                                  const ParticleType& particles, ParallelType& )
     {
         _timer.start();
 
         auto model = _model;
+        const auto neigh_list = _neigh_list;
         const auto vol = particles.sliceVolume();
         const auto temp = particles.sliceTemperature();
 
-        auto temp_func = KOKKOS_LAMBDA( const int i, const int j )
+        auto temp_func = KOKKOS_LAMBDA( const int i )
         {
-            double xi, r, s;
-            getDistance( x, u, i, j, xi, r, s );
+            std::size_t num_neighbors =
+                Cabana::NeighborList<neighbor_list_type>::numNeighbor(
+                    neigh_list, i );
+            for ( std::size_t n = 0; n < num_neighbors; n++ )
+            {
+                std::size_t j =
+                    Cabana::NeighborList<neighbor_list_type>::getNeighbor(
+                        neigh_list, i, n );
+                const double xi = getReferenceDistance( x, i, j );
 
-            const double coeff = model.microconductivity_function( xi );
-            conduction( i ) +=
-                coeff * ( temp( j ) - temp( i ) ) / xi / xi * vol( j );
+                const double coeff = model.microconductivity_function( xi );
+                conduction( i ) +=
+                    coeff * ( temp( j ) - temp( i ) ) / xi / xi * vol( j );
+            }
         };
 
-        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
-                                                particles.localOffset() );
-        Cabana::neighbor_parallel_for(
-            policy, temp_func, _neigh_list, Cabana::FirstNeighborsTag(),
-            neigh_op_tag, "CabanaPD::HeatTransfer::computeFull" );
+        // Explicit per-particle loop (rather than neighbor_parallel_for) such
+        // that the kernel launches on the heat transfer instance.
+        Kokkos::RangePolicy<exec_space> policy(
+            _space, particles.frozenOffset(), particles.localOffset() );
+        Kokkos::parallel_for( "CabanaPD::HeatTransfer::computeFull", policy,
+                              temp_func );
 
         _timer.stop();
     }
@@ -98,21 +137,118 @@ class HeatTransfer<MemorySpace, ForceModel<PMB, MechanicsType, NoFracture,
         {
             temp( i ) += dt / rho( i ) / model.cp * conduction( i );
         };
-        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
-                                                particles.localOffset() );
+        Kokkos::RangePolicy<exec_space> policy(
+            _space, particles.frozenOffset(), particles.localOffset() );
         Kokkos::parallel_for( "CabanaPD::HeatTransfer::forwardEuler", policy,
                               euler_func );
+        particles.markModified( TemperatureField{} );
         _euler_timer.stop();
     }
+
+    // First stage of an RKL2 super-step of length dt with num_stages stages
+    // (Meyer, Balsara, and Aslam, J. Comput. Phys. 2014). Conduction must be
+    // computed from the current temperature.
+    template <class ParticleType>
+    void superStepFirstStage( const ParticleType& particles, const double dt,
+                              const int num_stages )
+    {
+        _rkl_timer.start();
+        const std::size_t num_local = particles.localOffset();
+        if ( _temp0.extent( 0 ) < num_local )
+        {
+            Kokkos::realloc( Kokkos::WithoutInitializing, _temp0, num_local );
+            Kokkos::realloc( Kokkos::WithoutInitializing, _temp_prev,
+                             num_local );
+            Kokkos::realloc( Kokkos::WithoutInitializing, _rate0, num_local );
+        }
+
+        const double s = num_stages;
+        const double w1 = 4.0 / ( s * s + s - 2.0 );
+        const double mu_tilde = rklB( 1 ) * w1 * dt;
+
+        auto model = _model;
+        const auto rho = particles.sliceDensity();
+        const auto conduction = particles.sliceTemperatureConduction();
+        auto temp = particles.sliceTemperature();
+        auto temp0 = _temp0;
+        auto temp_prev = _temp_prev;
+        auto rate0 = _rate0;
+        auto stage_func = KOKKOS_LAMBDA( const int i )
+        {
+            const double rate = conduction( i ) / rho( i ) / model.cp;
+            temp0( i ) = temp( i );
+            temp_prev( i ) = temp( i );
+            rate0( i ) = rate;
+            temp( i ) += mu_tilde * rate;
+        };
+        Kokkos::RangePolicy<exec_space> policy(
+            _space, particles.frozenOffset(), particles.localOffset() );
+        Kokkos::parallel_for( "CabanaPD::HeatTransfer::RKL2First", policy,
+                              stage_func );
+        particles.markModified( TemperatureField{} );
+        _rkl_timer.stop();
+    }
+
+    // Stage j (2 <= j <= num_stages) of an RKL2 super-step. Conduction must
+    // be computed from the temperature of stage j - 1.
+    template <class ParticleType>
+    void superStepStage( const ParticleType& particles, const double dt,
+                         const int num_stages, const int j )
+    {
+        _rkl_timer.start();
+        const double s = num_stages;
+        const double w1 = 4.0 / ( s * s + s - 2.0 );
+        const double b_j = rklB( j );
+        const double mu = ( 2.0 * j - 1.0 ) / j * b_j / rklB( j - 1 );
+        const double nu = -( j - 1.0 ) / j * b_j / rklB( j - 2 );
+        const double mu_tilde = mu * w1 * dt;
+        const double gamma_tilde = -( 1.0 - rklB( j - 1 ) ) * mu_tilde;
+
+        auto model = _model;
+        const auto rho = particles.sliceDensity();
+        const auto conduction = particles.sliceTemperatureConduction();
+        auto temp = particles.sliceTemperature();
+        auto temp0 = _temp0;
+        auto temp_prev = _temp_prev;
+        auto rate0 = _rate0;
+        auto stage_func = KOKKOS_LAMBDA( const int i )
+        {
+            const double rate = conduction( i ) / rho( i ) / model.cp;
+            const double temp_j = mu * temp( i ) + nu * temp_prev( i ) +
+                                  ( 1.0 - mu - nu ) * temp0( i ) +
+                                  mu_tilde * rate + gamma_tilde * rate0( i );
+            temp_prev( i ) = temp( i );
+            temp( i ) = temp_j;
+        };
+        Kokkos::RangePolicy<exec_space> policy(
+            _space, particles.frozenOffset(), particles.localOffset() );
+        Kokkos::parallel_for( "CabanaPD::HeatTransfer::RKL2Stage", policy,
+                              stage_func );
+        particles.markModified( TemperatureField{} );
+        _rkl_timer.stop();
+    }
+
+  protected:
+    // RKL2 coefficients b_0 = b_1 = b_2 = 1/3, b_j = (j^2 + j - 2) / (2j(j+1)).
+    static double rklB( const int j )
+    {
+        if ( j < 2 )
+            return 1.0 / 3.0;
+        return ( j * j + j - 2.0 ) / ( 2.0 * j * ( j + 1.0 ) );
+    }
 };
 
-template <class MemorySpace, class MechanicsType, class... ModelParams>
-class HeatTransfer<MemorySpace, ForceModel<PMB, MechanicsType, Fracture,
-                                           DynamicTemperature, ModelParams...>>
+// Bond storage and reference geometry cache must match the mechanics Force.
+template <class MemorySpace, class MechanicsType, class BondStorageType,
+          class BondCacheType, class... ModelParams>
+class HeatTransfer<MemorySpace,
+                   ForceModel<PMB, MechanicsType, Fracture, DynamicTemperature,
+                              ModelParams...>,
+                   BondStorageType, BondCacheType>
     : public HeatTransfer<MemorySpace,
                           ForceModel<PMB, MechanicsType, NoFracture,
                                      DynamicTemperature, ModelParams...>>,
-      BaseFracture<MemorySpace>
+      BaseFracture<MemorySpace, BondStorageType, BondCacheType>
 
 {
   public:
@@ -130,11 +266,16 @@ class HeatTransfer<MemorySpace, ForceModel<PMB, MechanicsType, Fracture,
     using base_type::_euler_timer;
     using base_type::_half_neigh;
     using base_type::_neigh_list;
+    using base_type::_space;
     using base_type::_timer;
     model_type _model;
 
-    using fracture_type = BaseFracture<MemorySpace>;
+    using fracture_type =
+        BaseFracture<MemorySpace, BondStorageType, BondCacheType>;
+    using fracture_type::_bond_cache;
     using fracture_type::_mu;
+    static_assert( !is_csr_storage<BondStorageType>::value,
+                   "Heat transfer requires padded (2D) neighbor rows." );
 
   public:
     // Explicit base model construction is necessary because of the indirect
@@ -147,7 +288,7 @@ class HeatTransfer<MemorySpace, ForceModel<PMB, MechanicsType, Fracture,
                          model.delta, model.K, model.temperature, model.kappa,
                          model.cp, model.alpha, model.temp0,
                          model.constant_microconductivity ) )
-        , fracture_type( force.getBrokenBonds() )
+        , fracture_type( force.getBrokenBonds(), force.getBondCache() )
         , _model( model )
     {
     }
@@ -155,7 +296,6 @@ class HeatTransfer<MemorySpace, ForceModel<PMB, MechanicsType, Fracture,
     template <class TemperatureType, class PosType, class ParticleType,
               class ParallelType>
     void computeHeatTransferFull( TemperatureType& conduction, const PosType& x,
-                                  const PosType& u,
                                   const ParticleType& particles, ParallelType& )
     {
         _timer.start();
@@ -165,6 +305,7 @@ class HeatTransfer<MemorySpace, ForceModel<PMB, MechanicsType, Fracture,
         const auto vol = particles.sliceVolume();
         const auto temp = particles.sliceTemperature();
         const auto mu = _mu;
+        const auto bond_cache = _bond_cache;
 
         auto temp_func = KOKKOS_LAMBDA( const int i )
         {
@@ -177,24 +318,20 @@ class HeatTransfer<MemorySpace, ForceModel<PMB, MechanicsType, Fracture,
                     Cabana::NeighborList<neighbor_list_type>::getNeighbor(
                         neigh_list, i, n );
 
-                // Get the reference positions and displacements.
-                double xi, r, s;
-                getDistance( x, u, i, j, xi, r, s );
-
-                model.thermalStretch( s, i, j );
-
                 // Only include unbroken bonds.
                 if ( mu( i, n ) > 0 )
                 {
+                    const double xi =
+                        bond_cache.getReferenceDistance( x, i, j, n );
                     const double coeff = model.microconductivity_function( xi );
-                    conduction( i ) +=
-                        coeff * ( temp( j ) - temp( i ) ) / xi / xi * vol( j );
+                    conduction( i ) += coeff * ( temp( j ) - temp( i ) ) / xi /
+                                       xi * bond_cache.volume( vol, i, j, n );
                 }
             }
         };
 
-        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
-                                                particles.localOffset() );
+        Kokkos::RangePolicy<exec_space> policy(
+            _space, particles.frozenOffset(), particles.localOffset() );
         Kokkos::parallel_for( "CabanaPD::HeatTransfer::computeFull", policy,
                               temp_func );
         _timer.stop();
@@ -203,29 +340,101 @@ class HeatTransfer<MemorySpace, ForceModel<PMB, MechanicsType, Fracture,
 
 // Heat transfer free functions.
 template <class HeatTransferType, class ParticleType, class ParallelType>
-void computeHeatTransfer( HeatTransferType& heat_transfer,
-                          ParticleType& particles,
-                          const ParallelType& neigh_op_tag, const double dt )
+void computeConduction( HeatTransferType& heat_transfer,
+                        ParticleType& particles,
+                        const ParallelType& neigh_op_tag )
 {
+    using exec_space = typename HeatTransferType::exec_space;
     auto x = particles.sliceReferencePosition();
-    auto u = particles.sliceDisplacement();
     auto conduction = particles.sliceTemperatureConduction();
-    auto conduction_a = particles.sliceTemperatureConductionAtomic();
 
-    // Reset temperature conduction.
-    Cabana::deep_copy( conduction, 0.0 );
+    // Reset temperature conduction on the heat transfer instance. Each
+    // particle sums its own conduction, so no atomics are needed.
+    Kokkos::RangePolicy<exec_space> policy( heat_transfer.executionSpace(), 0,
+                                            conduction.size() );
+    Kokkos::parallel_for(
+        "CabanaPD::HeatTransfer::resetConduction", policy,
+        KOKKOS_LAMBDA( const int i ) { conduction( i ) = 0.0; } );
+
+    heat_transfer.computeHeatTransferFull( conduction, x, particles,
+                                           neigh_op_tag );
+}
 
-    // Temperature only needs to be atomic if using team threading.
-    if ( std::is_same<decltype( neigh_op_tag ), Cabana::TeamOpTag>::value )
-        heat_transfer.computeHeatTransferFull( conduction_a, x, u, particles,
-                                               neigh_op_tag );
-    else
-        heat_transfer.computeHeatTransferFull( conduction, x, u, particles,
-                                               neigh_op_tag );
-    Kokkos::fence();
+template <class HeatTransferType, class ParticleType, class ParallelType>
+void computeHeatTransfer( HeatTransferType& heat_transfer,
+                          ParticleType& particles,
+                          const ParallelType& neigh_op_tag, const double dt )
+{
+    computeConduction( heat_transfer, particles, neigh_op_tag );
 
     heat_transfer.forwardEuler( particles, dt );
-    Kokkos::fence();
+}
+
+// Compute forces (with bond breaking) together with conduction from the
+// current temperature in a single traversal of the bonds, on the mechanics
+// execution space instance. This falls back to separate kernels without a
+// fused kernel or for half lists.
+template <class ForceType, class HeatTransferType, class ParticleType,
+          class ParallelType>
+void computeForceAndConduction( ForceType& force,
+                                HeatTransferType& heat_transfer,
+                                ParticleType& particles,
+                                const ParallelType& neigh_op_tag,
+                                const bool reset = true )
+{
+    if constexpr ( ForceType::has_fused_conduction )
+    {
+        if ( !force.halfNeighbor() )
+        {
+            auto x = particles.sliceReferencePosition();
+            auto u = particles.sliceDisplacement();
+            auto f = particles.sliceForce();
+            auto f_a = particles.sliceForceAtomic();
+            auto conduction = particles.sliceTemperatureConduction();
+
+            if ( reset )
+                Cabana::deep_copy( f, 0.0 );
+            // Only atomic if using team threading (conduction is written
+            // once per particle).
+            if ( is_team_op<ParallelType>::value )
+                force.computeForceConductionFull( f_a, conduction, x, u,
+                                                  particles, neigh_op_tag );
+            else
+                force.computeForceConductionFull( f, conduction, x, u,
+                                                  particles, neigh_op_tag );
+            return;
+        }
+    }
+    computeForce( force, particles, neigh_op_tag, reset );
+    computeConduction( heat_transfer, particles, neigh_op_tag );
+}
+
+// RKL2 super-time-stepping: one thermal step of length dt using num_stages
+// conduction evaluations, stable for dt up to (s^2 + s - 2) / 4 times the
+// explicit limit. Ghost temperatures must be current on entry and are
+// updated between stages with the given gather (after the stage completes on
+// the heat transfer execution space instance).
+template <class HeatTransferType, class ParticleType, class ParallelType,
+          class GatherType>
+void computeHeatTransferRKL2( HeatTransferType& heat_transfer,
+                              ParticleType& particles,
+                              const ParallelType& neigh_op_tag,
+                              const double dt, const int num_stages,
+                              GatherType&& gather_temperature )
+{
+    if ( num_stages < 2 )
+        throw std::runtime_error(
+            "RKL2 super-time-stepping requires at least 2 stages." );
+
+    computeConduction( heat_transfer, particles, neigh_op_tag );
+    heat_transfer.superStepFirstStage( particles, dt, num_stages );
+    for ( int j = 2; j <= num_stages; ++j )
+    {
+        heat_transfer.executionSpace().fence();
+        gather_temperature();
+        computeConduction( heat_transfer, particles, neigh_op_tag );
+        heat_transfer.superStepStage( particles, dt, num_stages, j );
+    }
 }
 
 } // namespace CabanaPD
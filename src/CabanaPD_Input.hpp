@@ -12,14 +12,24 @@
 #ifndef INPUTS_H
 #define INPUTS_H
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
 #include <string>
+#include <vector>
+
+#include <mpi.h>
 
 #include <nlohmann/json.hpp>
 
 #include <CabanaPD_Constants.hpp>
 #include <CabanaPD_Output.hpp>
+#include <CabanaPD_Timer.hpp>
+#include <CabanaPD_Types.hpp>
 
 namespace CabanaPD
 {
@@ -28,7 +38,8 @@ class Inputs
   public:
     Inputs( const std::string filename )
     {
-        // Get user inputs.
+        _timer.start();
+        // Get user inputs (read on rank 0 and broadcast).
         inputs = parse( filename );
 
         // Add additional derived inputs to json. System size.
@@ -67,18 +78,218 @@ class Inputs
             inputs["error_file"]["value"] = "cabanaPD.err";
         inputs["input_file"]["value"] = filename;
 
-        // Save inputs (including derived) to new file.
+        // Save inputs (including derived) to new file (once).
         std::string input_file = "cabanaPD.in.json";
         if ( !inputs.contains( "exported_input_file" ) )
             inputs["exported_input_file"]["value"] = input_file;
-        std::ofstream in( input_file );
-        in << inputs;
+        if ( print_rank() )
+        {
+            std::ofstream in( input_file );
+            in << inputs;
+        }
 
         if ( !inputs.contains( "output_reference" ) )
             inputs["output_reference"]["value"] = true;
 
-        // Not yet a user option.
-        inputs["half_neigh"]["value"] = false;
+        // Particle output includes all fields of all particles, in double
+        // precision and written synchronously, unless set.
+        if ( !inputs.contains( "output_fields" ) )
+            inputs["output_fields"]["value"] = nlohmann::json::array();
+        if ( !inputs.contains( "output_stride" ) )
+            inputs["output_stride"]["value"] = 1;
+        if ( !inputs.contains( "output_region_low" ) )
+            inputs["output_region_low"]["value"] =
+                std::vector<double>( 3, std::numeric_limits<double>::lowest() );
+        if ( !inputs.contains( "output_region_high" ) )
+            inputs["output_region_high"]["value"] =
+                std::vector<double>( 3, std::numeric_limits<double>::max() );
+        if ( !inputs.contains( "output_single_precision" ) )
+            inputs["output_single_precision"]["value"] = false;
+        if ( !inputs.contains( "output_async" ) )
+            inputs["output_async"]["value"] = false;
+        if ( !inputs.contains( "output_frozen" ) )
+            inputs["output_frozen"]["value"] = true;
+
+        // Half neighbor lists are currently only supported for PMB models.
+        if ( !inputs.contains( "half_neigh" ) )
+            inputs["half_neigh"]["value"] = false;
+
+        // Sorting particles for memory locality is opt-in.
+        if ( !inputs.contains( "reorder_particles" ) )
+            inputs["reorder_particles"]["value"] = false;
+
+        // Overlapping ghost communication with interior forces is opt-in.
+        if ( !inputs.contains( "overlap_communication" ) )
+            inputs["overlap_communication"]["value"] = false;
+
+        // Halo exchange: device buffers are passed directly to MPI (GPU-aware)
+        // by default, optionally with persistent requests and direct copies
+        // between ranks on the same node.
+        if ( !inputs.contains( "halo_gpu_aware_mpi" ) )
+            inputs["halo_gpu_aware_mpi"]["value"] = true;
+        if ( !inputs.contains( "halo_persistent_requests" ) )
+            inputs["halo_persistent_requests"]["value"] = false;
+        if ( !inputs.contains( "halo_node_shared" ) )
+            inputs["halo_node_shared"]["value"] = false;
+
+        // Fusing the force reset, boundary conditions, and current positions
+        // into the integrator is opt-in.
+        if ( !inputs.contains( "fused_integration" ) )
+            inputs["fused_integration"]["value"] = false;
+
+        // Assembling the stiffness of linearized models once (forces are then
+        // a sparse matrix-vector product) is opt-in.
+        if ( !inputs.contains( "assembled_stiffness" ) )
+            inputs["assembled_stiffness"]["value"] = false;
+
+        // Quasi-static dynamic relaxation: load increments up to final_time,
+        // the residual norm tolerance (relative to the largest initial
+        // residual of an increment), the iteration limit per increment, and
+        // the scale of the fictitious density.
+        if ( !inputs.contains( "relaxation_load_steps" ) )
+            inputs["relaxation_load_steps"]["value"] = 10;
+        if ( !inputs.contains( "relaxation_tolerance" ) )
+            inputs["relaxation_tolerance"]["value"] = 1e-5;
+        if ( !inputs.contains( "relaxation_max_iterations" ) )
+            inputs["relaxation_max_iterations"]["value"] = 20000;
+        if ( !inputs.contains( "relaxation_density_scale" ) )
+            inputs["relaxation_density_scale"]["value"] = 1.0;
+
+        // Particle migration is disabled without a positive skin distance.
+        if ( !inputs.contains( "migration_distance" ) )
+            inputs["migration_distance"]["value"] = 0.0;
+
+        // Domain rebalancing by bonds per rank is disabled by default.
+        if ( !inputs.contains( "rebalance_frequency" ) )
+            inputs["rebalance_frequency"]["value"] = 0;
+
+        // Contact neighbors are rebuilt every step without a skin distance.
+        if ( !inputs.contains( "contact_skin" ) )
+            inputs["contact_skin"]["value"] = 0.0;
+
+        // Contact forces use the PD timestep unless subcycled (r-RESPA) with
+        // contact_substeps velocity Verlet substeps per drift.
+        if ( !inputs.contains( "contact_substeps" ) )
+            inputs["contact_substeps"]["value"] = 1;
+
+        // Contact between bonded particles is included by default.
+        if ( !inputs.contains( "contact_exclude_bonds" ) )
+            inputs["contact_exclude_bonds"]["value"] = false;
+
+        // Broken bonds are only removed from the neighbor list if set.
+        if ( !inputs.contains( "bond_compaction_threshold" ) )
+            inputs["bond_compaction_threshold"]["value"] = 0.0;
+
+        // Bonds are checked for breaking for all particles unless set. The
+        // active set (particles with a bond beyond active_bond_threshold of
+        // its critical stretch) is otherwise rebuilt every
+        // active_bond_frequency bond breaking force evaluations.
+        if ( !inputs.contains( "active_bond_frequency" ) )
+            inputs["active_bond_frequency"]["value"] = 0;
+        if ( !inputs.contains( "active_bond_threshold" ) )
+            inputs["active_bond_threshold"]["value"] = 0.5;
+
+        // Heat transfer uses forward Euler unless set to RKL2
+        // super-time-stepping ("rkl2"), where the number of stages is
+        // derived from the stable timestep if not set.
+        if ( !inputs.contains( "thermal_integrator" ) )
+            inputs["thermal_integrator"]["value"] = "forward_euler";
+        std::string thermal_integrator = inputs["thermal_integrator"]["value"];
+        if ( thermal_integrator != "forward_euler" &&
+             thermal_integrator != "rkl2" )
+            throw std::runtime_error( "Unknown thermal_integrator: " +
+                                      thermal_integrator );
+
+        // Heat transfer may be launched on a separate execution space
+        // instance, overlapping the mechanics drift and ghost update (only
+        // the last stage for RKL2, since stages are separated by gathers).
+        if ( !inputs.contains( "concurrent_heat_transfer" ) )
+            inputs["concurrent_heat_transfer"]["value"] = false;
+
+        // Forward-Euler conduction may be computed within the force kernel
+        // preceding each thermal step, in a single traversal of the bonds.
+        if ( !inputs.contains( "fused_conduction" ) )
+            inputs["fused_conduction"]["value"] = false;
+        bool fused_conduction = inputs["fused_conduction"]["value"];
+        if ( fused_conduction && thermal_integrator != "forward_euler" )
+            throw std::runtime_error(
+                "fused_conduction requires forward_euler." );
+
+        // Adaptive timestep control is opt-in: the stable timestep is
+        // re-estimated every adaptive_timestep_frequency steps and the
+        // timestep adjusted within [timestep_min, timestep_max], growing by
+        // at most adaptive_timestep_growth each time and moving particles at
+        // most adaptive_timestep_distance (relative to dx) per step. Output
+        // is then scheduled every output_time_interval of simulation time.
+        if ( !inputs.contains( "adaptive_timestep" ) )
+            inputs["adaptive_timestep"]["value"] = false;
+        bool adaptive_timestep = inputs["adaptive_timestep"]["value"];
+        if ( adaptive_timestep )
+        {
+            if ( !inputs.contains( "adaptive_timestep_frequency" ) )
+                inputs["adaptive_timestep_frequency"]["value"] = 10;
+            if ( !inputs.contains( "timestep_min" ) )
+                inputs["timestep_min"]["value"] = 0.01 * dt;
+            if ( !inputs.contains( "timestep_max" ) )
+                inputs["timestep_max"]["value"] = 100.0 * dt;
+            if ( !inputs.contains( "adaptive_timestep_growth" ) )
+                inputs["adaptive_timestep_growth"]["value"] = 1.1;
+            if ( !inputs.contains( "adaptive_timestep_distance" ) )
+                inputs["adaptive_timestep_distance"]["value"] = 0.1;
+            if ( !inputs.contains( "output_time_interval" ) )
+            {
+                int output_frequency = inputs["output_frequency"]["value"];
+                inputs["output_time_interval"]["value"] =
+                    output_frequency * dt;
+            }
+        }
+
+        // Checkpoints are written every checkpoint_frequency steps (disabled
+        // by default), with all ranks in one file unless set.
+        if ( !inputs.contains( "checkpoint_frequency" ) )
+            inputs["checkpoint_frequency"]["value"] = 0;
+        if ( !inputs.contains( "checkpoint_file" ) )
+            inputs["checkpoint_file"]["value"] = "cabanaPD.checkpoint";
+        if ( !inputs.contains( "checkpoint_ranks_per_file" ) )
+            inputs["checkpoint_ranks_per_file"]["value"] = 0;
+        // Restart from a checkpoint name (prefix and step), if given.
+        if ( !inputs.contains( "restart_file" ) )
+            inputs["restart_file"]["value"] = "";
+
+        // Global monitors (damage, crack tip, kinetic energy, reaction
+        // forces) are written every monitor_frequency steps (disabled by
+        // default), with the crack tip the furthest damaged particle along
+        // monitor_crack_axis.
+        if ( !inputs.contains( "monitor_frequency" ) )
+            inputs["monitor_frequency"]["value"] = 0;
+        if ( !inputs.contains( "monitor_file" ) )
+            inputs["monitor_file"]["value"] = "cabanaPD.monitor";
+        if ( !inputs.contains( "monitor_crack_axis" ) )
+            inputs["monitor_crack_axis"]["value"] = 0;
+        if ( !inputs.contains( "monitor_crack_damage" ) )
+            inputs["monitor_crack_damage"]["value"] = 0.5;
+        // Globally reduced energy and damage are always computed on output
+        // steps (and logged one output later), optionally also written to
+        // diagnostics_file, with the damaged volume counting particles with
+        // at least diagnostics_damage.
+        if ( !inputs.contains( "diagnostics_output" ) )
+            inputs["diagnostics_output"]["value"] = false;
+        if ( !inputs.contains( "diagnostics_file" ) )
+            inputs["diagnostics_file"]["value"] = "cabanaPD.diagnostics";
+        if ( !inputs.contains( "diagnostics_damage" ) )
+            inputs["diagnostics_damage"]["value"] = 0.5;
+
+        // Per-region timing report across ranks (JSON and CSV) is opt-in.
+        if ( !inputs.contains( "profile_output" ) )
+            inputs["profile_output"]["value"] = false;
+        if ( !inputs.contains( "profile_file" ) )
+            inputs["profile_file"]["value"] = "cabanaPD.profile";
+
+        // Memory per device (GB) for the projected problem size in the memory
+        // report, detected from the memory space if not set.
+        if ( !inputs.contains( "device_memory" ) )
+            inputs["device_memory"]["value"] = 0.0;
+        _timer.stop();
     }
 
     void setupSize()
@@ -86,8 +297,9 @@ class Inputs
         if ( inputs.contains( "system_size" ) )
         {
             auto system_size = inputs["system_size"]["value"];
-            if ( system_size.size() != 3 )
-                log_err( std::cout, "CabanaPD requires 3d (system_size)." );
+            if ( system_size.size() != 2 && system_size.size() != 3 )
+                log_err( std::cout,
+                         "CabanaPD requires 2d or 3d (system_size)." );
 
             for ( std::size_t d = 0; d < system_size.size(); d++ )
             {
@@ -106,10 +318,12 @@ class Inputs
         {
             auto low_corner = inputs["low_corner"]["value"];
             auto high_corner = inputs["high_corner"]["value"];
-            if ( low_corner.size() != 3 )
-                log_err( std::cout, "CabanaPD requires 3d (low_corner)." );
-            if ( high_corner.size() != 3 )
-                log_err( std::cout, "CabanaPD requires 3d (high_corner)." );
+            if ( low_corner.size() != 2 && low_corner.size() != 3 )
+                log_err( std::cout,
+                         "CabanaPD requires 2d or 3d (low_corner)." );
+            if ( high_corner.size() != 2 && high_corner.size() != 3 )
+                log_err( std::cout,
+                         "CabanaPD requires 2d or 3d (high_corner)." );
 
             for ( std::size_t d = 0; d < low_corner.size(); d++ )
             {
@@ -129,8 +343,8 @@ class Inputs
         if ( inputs.contains( "dx" ) )
         {
             auto dx = inputs["dx"]["value"];
-            if ( dx.size() != 3 )
-                log_err( std::cout, "CabanaPD requires 3d (dx)." );
+            if ( dx.size() != 2 && dx.size() != 3 )
+                log_err( std::cout, "CabanaPD requires 2d or 3d (dx)." );
 
             for ( std::size_t d = 0; d < dx.size(); d++ )
             {
@@ -143,8 +357,8 @@ class Inputs
         else if ( inputs.contains( "num_cells" ) )
         {
             auto nc = inputs["num_cells"]["value"];
-            if ( nc.size() != 3 )
-                log_err( std::cout, "CabanaPD requires 3d (num_cells)." );
+            if ( nc.size() != 2 && nc.size() != 3 )
+                log_err( std::cout, "CabanaPD requires 2d or 3d (num_cells)." );
 
             for ( std::size_t d = 0; d < nc.size(); d++ )
             {
@@ -166,44 +380,43 @@ class Inputs
                      "Units for low_corner and high_corner do not match." );
         if ( inputs["dx"]["unit"] != inputs["high_corner"]["unit"] )
             log_err( std::cout, "Units for dx do not match system units." );
+
+        // Error for inconsistent dimensions.
+        if ( inputs["low_corner"]["value"].size() !=
+                 inputs["high_corner"]["value"].size() ||
+             inputs["dx"]["value"].size() !=
+                 inputs["low_corner"]["value"].size() )
+            log_err( std::cout, "Dimensions of the system inputs do not "
+                                "match." );
     }
 
+    // System dimension (2 or 3) from the grid inputs.
+    int dimension() { return inputs["dx"]["value"].size(); }
+
     template <class ForceModel>
     void computeCriticalTimeStep( [[maybe_unused]] const ForceModel model )
     {
         // Reference: Silling & Askari, Computers & Structures 83(17–18) (2005):
         // 1526-1535.
 
-        // Compute particle volume.
+        // Compute particle volume (per unit thickness in 2d).
+        const int dim = dimension();
         double dx = inputs["dx"]["value"][0];
         double dy = inputs["dx"]["value"][1];
-        double dz = inputs["dx"]["value"][2];
-        double v_p = dx * dy * dz;
+        double dz = dim == 3 ? double( inputs["dx"]["value"][2] ) : 0.0;
+        double v_p = dim == 3 ? dx * dy * dz : dx * dy;
 
         // Initialize denominator's summation.
         double sum = 0;
         double sum_ht = 0;
 
-        // Estimate the bulk modulus if needed.
-        double K;
-        if ( inputs.contains( "bulk_modulus" ) )
-        {
-            K = inputs["bulk_modulus"]["value"];
-        }
-        else
-        {
-            double E = inputs["elastic_modulus"]["value"];
-            // This is only exact for bond-based (PMB).
-            double nu = 0.25;
-            K = E / ( 3 * ( 1 - 2 * nu ) );
-        }
-
         // Run over the neighborhood of a point in the bulk of a body (at the
         // origin).
         int m = inputs["m"]["value"];
         double delta = inputs["horizon"]["value"];
-        // FIXME: this is copied from the forces
-        double c = 18.0 * K / ( pi * delta * delta * delta * delta );
+        double c = micromodulus( model );
+        // Only the k = 0 plane in 2d.
+        const int k_max = dim == 3 ? m + 1 : 0;
 
         for ( int i = -( m + 1 ); i < m + 2; i++ )
         {
@@ -215,7 +428,7 @@ class Inputs
                 // y-component of bond.
                 double xi_2 = j * dy;
 
-                for ( int k = -( m + 1 ); k < m + 2; k++ )
+                for ( int k = -k_max; k <= k_max; k++ )
                 {
                     // z-component of bond.
                     double xi_3 = k * dz;
@@ -263,17 +476,101 @@ class Inputs
 
             double cp = inputs["specific_heat_capacity"]["value"];
             double dt_ht_crit = rho * cp / sum_ht;
+
+            // RKL2 with s stages is stable up to (s^2 + s - 2) / 4 explicit
+            // steps: use the fewest stages needed for the thermal step.
+            std::string thermal_integrator =
+                inputs["thermal_integrator"]["value"];
+            if ( thermal_integrator == "rkl2" )
+            {
+                if ( !inputs.contains( "thermal_stages" ) )
+                {
+                    double safety_factor =
+                        inputs["timestep_safety_factor"]["value"];
+                    double ratio = dt_ht / ( safety_factor * dt_ht_crit );
+                    int stages = std::ceil(
+                        0.5 * ( std::sqrt( 9.0 + 16.0 * ratio ) - 1.0 ) );
+                    inputs["thermal_stages"]["value"] = std::max( stages, 2 );
+                }
+                int s = inputs["thermal_stages"]["value"];
+                dt_ht_crit *= ( s * s + s - 2.0 ) / 4.0;
+            }
             compareCriticalTimeStep( "heat_transfer", dt_ht, dt_ht_crit );
         }
     }
 
-    // Parse JSON file.
+    // Bond micromodulus used for stable timestep estimates.
+    double micromodulus()
+    {
+        // Estimate the bulk modulus if needed.
+        const int dim = dimension();
+        double K;
+        if ( inputs.contains( "bulk_modulus" ) )
+        {
+            K = inputs["bulk_modulus"]["value"];
+        }
+        else if ( dim == 2 )
+        {
+            double E = inputs["elastic_modulus"]["value"];
+            // This is only exact for bond-based (PMB), plane stress.
+            double nu = 1.0 / 3.0;
+            K = E / ( 2 * ( 1 - nu ) );
+        }
+        else
+        {
+            double E = inputs["elastic_modulus"]["value"];
+            // This is only exact for bond-based (PMB).
+            double nu = 0.25;
+            K = E / ( 3 * ( 1 - 2 * nu ) );
+        }
+        double delta = inputs["horizon"]["value"];
+        // FIXME: this is copied from the forces
+        if ( dim == 2 )
+            return 12.0 * K / ( pi * delta * delta * delta );
+        return 18.0 * K / ( pi * delta * delta * delta * delta );
+    }
+
+    // Micromodulus of the stiffest bonds of a model: ensembles are limited
+    // by their stiffest member rather than the input parameters.
+    template <class ForceModel>
+    double micromodulus( [[maybe_unused]] const ForceModel& model )
+    {
+        if constexpr ( is_ensemble<ForceModel>::value )
+            return std::max( micromodulus(), model.maxMemberC() );
+        else
+            return micromodulus();
+    }
+
+    // Parse JSON file on rank 0 and broadcast it to all ranks, such that
+    // only one rank touches the file system.
     inline nlohmann::json parse( const std::string& filename )
     {
-        std::ifstream stream( filename );
-        return nlohmann::json::parse( stream );
+        std::string contents;
+        int opened = 1;
+        if ( print_rank() )
+        {
+            std::ifstream stream( filename );
+            if ( stream )
+                contents.assign( std::istreambuf_iterator<char>( stream ),
+                                 std::istreambuf_iterator<char>() );
+            else
+                opened = 0;
+        }
+        // All ranks must fail together rather than wait on the contents.
+        MPI_Bcast( &opened, 1, MPI_INT, 0, MPI_COMM_WORLD );
+        if ( !opened )
+            throw std::runtime_error( "Could not open input file " + filename +
+                                      "." );
+        unsigned long size = contents.size();
+        MPI_Bcast( &size, 1, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD );
+        contents.resize( size );
+        MPI_Bcast( contents.data(), size, MPI_CHAR, 0, MPI_COMM_WORLD );
+        return nlohmann::json::parse( contents );
     }
 
+    // Time to read and set up the inputs.
+    auto timeInit() { return _timer.time(); };
+
     // Get a single input.
     auto operator[]( std::string label ) { return inputs[label]["value"]; }
 
@@ -307,6 +604,7 @@ class Inputs
     }
 
     nlohmann::json inputs;
+    Timer _timer = Timer( "Inputs" );
 };
 
 } // namespace CabanaPD
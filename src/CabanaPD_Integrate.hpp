@@ -60,6 +60,11 @@
 #ifndef INTEGRATOR_H
 #define INTEGRATOR_H
 
+#include <cmath>
+#include <stdexcept>
+
+#include <mpi.h>
+
 #include <Kokkos_Core.hpp>
 
 #include <CabanaPD_Particles.hpp>
@@ -67,13 +72,64 @@
 
 namespace CabanaPD
 {
+/******************************************************************************
+  Per-particle work fused into the integrator drift kernels, replacing
+  separate full passes over the particles.
+******************************************************************************/
+struct NoFusedOp
+{
+    KOKKOS_INLINE_FUNCTION void operator()( const int ) const {}
+};
+
+// Applied after the drift of each owned particle, in order: zero the force
+// for the next force computation, apply boundary conditions, and update the
+// current position. Forces may only be reset here if no later kernel reads
+// this step's force before the next force computation.
+template <int Dim, class ForceType, class BoundaryOpType,
+          class RefPositionType, class DisplacementType, class PositionType>
+struct FusedDriftOp
+{
+    bool reset_force;
+    ForceType f;
+    BoundaryOpType boundary_op;
+    bool update_position;
+    RefPositionType x;
+    DisplacementType u;
+    PositionType y;
+
+    KOKKOS_INLINE_FUNCTION void operator()( const int i ) const
+    {
+        if ( reset_force )
+            for ( int d = 0; d < Dim; d++ )
+                f( i, d ) = 0.0;
+        boundary_op( i );
+        if ( update_position )
+            for ( int d = 0; d < Dim; d++ )
+                y( i, d ) = x( i, d ) + u( i, d );
+    }
+};
+
+template <class ParticleType, class BoundaryOpType>
+auto createFusedDriftOp( ParticleType& particles, const bool reset_force,
+                         const BoundaryOpType boundary_op,
+                         const bool update_position )
+{
+    auto f = particles.sliceForce();
+    auto x = particles.sliceReferencePosition();
+    auto u = particles.sliceDisplacement();
+    auto y = particles.sliceCurrentPositionNoUpdate();
+    return FusedDriftOp<ParticleType::dim, decltype( f ), BoundaryOpType,
+                        decltype( x ), decltype( u ), decltype( y )>{
+        reset_force, f, boundary_op, update_position, x, u, y };
+}
+
 template <class ExecutionSpace>
 class Integrator
 {
     using exec_space = ExecutionSpace;
 
     double _dt, _half_dt;
-    Timer _timer;
+    Timer _timer = Timer( "Integrate" );
 
   public:
     Integrator( double dt )
@@ -84,8 +140,19 @@ class Integrator
 
     ~Integrator() {}
 
-    template <class ParticlesType>
-    void initialHalfStep( ParticlesType& p )
+    // Change the timestep between steps (e.g. adaptive timesteps).
+    void setTimeStep( const double dt )
+    {
+        _dt = dt;
+        _half_dt = 0.5 * dt;
+    }
+    double timeStep() const { return _dt; }
+
+    // Velocity Verlet first half: kick and drift, then any fused
+    // per-particle work.
+    template <class ParticlesType, class FusedOpType = NoFusedOp>
+    void initialHalfStep( ParticlesType& p,
+                          const FusedOpType fused_op = FusedOpType{} )
     {
         _timer.start();
 
@@ -99,17 +166,18 @@ class Integrator
         auto init_func = KOKKOS_LAMBDA( const int i )
         {
             const double half_dt_m = half_dt / rho( i );
-            v( i, 0 ) += half_dt_m * f( i, 0 );
-            v( i, 1 ) += half_dt_m * f( i, 1 );
-            v( i, 2 ) += half_dt_m * f( i, 2 );
-            u( i, 0 ) += dt * v( i, 0 );
-            u( i, 1 ) += dt * v( i, 1 );
-            u( i, 2 ) += dt * v( i, 2 );
+            for ( int d = 0; d < ParticlesType::dim; d++ )
+            {
+                v( i, d ) += half_dt_m * f( i, d );
+                u( i, d ) += dt * v( i, d );
+            }
+            fused_op( i );
         };
         Kokkos::RangePolicy<exec_space> policy( p.frozenOffset(),
                                                 p.localOffset() );
         Kokkos::parallel_for( "CabanaPD::Integrator::Initial", policy,
                               init_func );
+        p.markModified( DisplacementField{} );
 
         _timer.stop();
     }
@@ -127,9 +195,8 @@ class Integrator
         auto final_func = KOKKOS_LAMBDA( const int i )
         {
             const double half_dt_m = half_dt / rho( i );
-            v( i, 0 ) += half_dt_m * f( i, 0 );
-            v( i, 1 ) += half_dt_m * f( i, 1 );
-            v( i, 2 ) += half_dt_m * f( i, 2 );
+            for ( int d = 0; d < ParticlesType::dim; d++ )
+                v( i, d ) += half_dt_m * f( i, d );
         };
         Kokkos::RangePolicy<exec_space> policy( p.frozenOffset(),
                                                 p.localOffset() );
@@ -141,303 +208,454 @@ class Integrator
 
     double timeInit() { return 0.0; };
     auto time() { return _timer.time(); };
-};
 
+    void profile( TimerRegistry& timers ) const
+    {
+        timers.add( "Integrate", _timer );
+    }
+};
 
+/*!
+  Fourth-order Yoshida (forward Forest-Ruth) symplectic integrator.
 
+  Each step is a sequence of drift-kick stages driven by the coefficient
+  tables: stage s drifts displacements by c[s] * dt * v, then (after the
+  solver updates forces) kicks velocities by d[s] * dt * f / rho. The final
+  kick coefficient is zero, so only num_stages - 1 force evaluations are
+  needed per step.
+*/
 template <class ExecutionSpace>
 class Yoshida
 {
     using exec_space = ExecutionSpace;
 
-    double _dt, c1, c2, c3, c4, d1, d2, d3;
-    Timer _timer;
+  public:
+    static constexpr int num_stages = 4;
+
+  protected:
+    double _dt;
+    Kokkos::Array<double, num_stages> _c;
+    Kokkos::Array<double, num_stages> _d;
+    Timer _timer = Timer( "Integrate" );
 
   public:
     Yoshida( double dt )
         : _dt( dt )
     {
-        c1 = 0.6756;
-	c2 = -0.1756;
-	c3 = -0.1756;
-	c4 = 0.6756;
-	d1 = c1*2;
-	d2 = 2*c3 - 2*c1;
-	d3 = d1;
+        const double cbrt2 = std::cbrt( 2.0 );
+        const double w1 = 1.0 / ( 2.0 - cbrt2 );
+        const double w0 = -cbrt2 * w1;
+
+        _c[0] = 0.5 * w1;
+        _c[1] = 0.5 * ( w0 + w1 );
+        _c[2] = _c[1];
+        _c[3] = _c[0];
+
+        _d[0] = w1;
+        _d[1] = w0;
+        _d[2] = w1;
+        _d[3] = 0.0;
     }
 
     ~Yoshida() {}
 
-// Update stage 1 displacements
-    template <class ParticlesType>
-    void stageOneDisplacement( ParticlesType& p )
+    // Change the timestep between steps (e.g. adaptive timesteps).
+    void setTimeStep( const double dt ) { _dt = dt; }
+    double timeStep() const { return _dt; }
+
+    // Drift coefficient for a given stage.
+    double driftCoefficient( const int stage ) const { return _c[stage]; }
+    // Kick coefficient for a given stage (zero if no force is needed).
+    double kickCoefficient( const int stage ) const { return _d[stage]; }
+    // Whether a stage uses the force evaluated at its drifted positions.
+    bool stageNeedsForce( const int stage ) const
+    {
+        return _d[stage] != 0.0;
+    }
+    // Last stage which requires a force evaluation.
+    int lastForceStage() const
+    {
+        int last = 0;
+        for ( int s = 0; s < num_stages; ++s )
+            if ( stageNeedsForce( s ) )
+                last = s;
+        return last;
+    }
+
+    // Drift, then any fused per-particle work.
+    template <class ParticlesType, class FusedOpType = NoFusedOp>
+    void stageDisplacement( ParticlesType& p, const int stage,
+                            const FusedOpType fused_op = FusedOpType{} )
     {
         _timer.start();
 
-        auto u = p.sliceDisplacement();  // displacement
-        auto v = p.sliceVelocity();	// velcoity
-        auto f = p.sliceForce();	// force
-        auto rho = p.sliceDensity();	// rho
+        auto u = p.sliceDisplacement();
+        auto v = p.sliceVelocity();
 
-        auto dt = _dt;
-        auto init_func = KOKKOS_LAMBDA( const int i )
+        const double c_dt = _c[stage] * _dt;
+        auto drift_func = KOKKOS_LAMBDA( const int i )
         {
-	
-	// Update displacements for stage 1
-	u( i, 0 ) = u( i, 0 ) + c1 * v( i, 0) * dt;
-	u( i, 1 ) = u( i, 1 ) + c1 * v( i, 1) * dt;
- 	u( i, 2 ) = u( i, 2 ) + c1 * v( i, 2) * dt;
-
-	
+            for ( int d = 0; d < ParticlesType::dim; d++ )
+                u( i, d ) += c_dt * v( i, d );
+            fused_op( i );
         };
         Kokkos::RangePolicy<exec_space> policy( p.frozenOffset(),
                                                 p.localOffset() );
-        Kokkos::parallel_for( "CabanaPD::Yoshida::stageOne", policy,
-                              init_func );
+        Kokkos::parallel_for( "CabanaPD::Yoshida::Displacement", policy,
+                              drift_func );
+        p.markModified( DisplacementField{} );
 
         _timer.stop();
     }
 
-
-//Update force via solver 
-
-
-// Update stage 1 velcoity
+    // Kick, optionally zeroing the force for the next force computation.
     template <class ParticlesType>
-    void stageOneVel( ParticlesType& p )
+    void stageVelocity( ParticlesType& p, const int stage,
+                        const bool reset_force = false )
     {
+        if ( !stageNeedsForce( stage ) )
+            return;
+
         _timer.start();
 
-        auto u = p.sliceDisplacement();  // displacement
-        auto v = p.sliceVelocity();	// velcoity
-        auto f = p.sliceForce();	// force
-        auto rho = p.sliceDensity();	// rho
+        auto v = p.sliceVelocity();
+        auto f = p.sliceForce();
+        auto rho = p.sliceDensity();
 
-        auto dt = _dt;
-        auto init_func = KOKKOS_LAMBDA( const int i )
+        const double d_dt = _d[stage] * _dt;
+        auto kick_func = KOKKOS_LAMBDA( const int i )
         {
-
-	    // Update stage 1 velcoity
-            v( i, 0 ) =  v( i, 0 ) + d1 * dt * f( i, 0 ) / rho( i );
-            v( i, 1 ) =  v( i, 1 ) + d1 * dt * f( i, 1 ) / rho( i );
-            v( i, 2 ) =  v( i, 2 ) + d1 * dt * f( i, 2 ) / rho( i );
-          
-	
+            const double d_dt_m = d_dt / rho( i );
+            for ( int d = 0; d < ParticlesType::dim; d++ )
+            {
+                v( i, d ) += d_dt_m * f( i, d );
+                if ( reset_force )
+                    f( i, d ) = 0.0;
+            }
         };
         Kokkos::RangePolicy<exec_space> policy( p.frozenOffset(),
                                                 p.localOffset() );
-        Kokkos::parallel_for( "CabanaPD::Yoshida::stageOne", policy,
-                              init_func );
+        Kokkos::parallel_for( "CabanaPD::Yoshida::Velocity", policy,
+                              kick_func );
 
         _timer.stop();
     }
 
+    double timeInit() { return 0.0; };
+    auto time() { return _timer.time(); };
 
+    void profile( TimerRegistry& timers ) const
+    {
+        timers.add( "Integrate", _timer );
+    }
+};
 
+/******************************************************************************
+  Multirate (r-RESPA) subcycling of contact forces.
+
+  The outer integrator only kicks with the PD (and boundary condition)
+  forces. Each outer drift of length tau is replaced by num_substeps velocity
+  Verlet substeps of length tau / num_substeps with the contact forces,
+  which are stored separately and updated by the solver between the drift
+  and the second kick of each substep. Negative drifts (Yoshida) use negative
+  substeps. With no contact neighbors, the contact force is zero and the
+  substeps reduce to the outer drift.
+******************************************************************************/
+template <class ExecutionSpace>
+class ContactSubcycle
+{
+    using exec_space = ExecutionSpace;
+    using memory_space = typename exec_space::memory_space;
+    using force_view_type = Kokkos::View<double* [3], memory_space>;
 
+    int _num_substeps;
+    force_view_type _fc;
+    Timer _timer = Timer( "Integrate::ContactSubcycle" );
 
-// Update stage 2 displacements
+  public:
+    ContactSubcycle( const int num_substeps )
+        : _num_substeps( num_substeps )
+    {
+        if ( num_substeps < 1 )
+            throw std::runtime_error(
+                "Contact subcycling requires at least one substep." );
+    }
+
+    int numSubsteps() const { return _num_substeps; }
+
+    // Zeroed contact force for the owned particles, to be summed by the
+    // contact kernel (atomic for team threading).
     template <class ParticlesType>
-    void stageTwoDisplacement( ParticlesType& p )
+    auto resetContactForce( const ParticlesType& p )
     {
-        _timer.start();
+        if ( _fc.extent( 0 ) != p.localOffset() )
+            _fc = force_view_type( "contact_force", p.localOffset() );
+        else
+            Kokkos::deep_copy( _fc, 0.0 );
+        return _fc;
+    }
 
-        auto u = p.sliceDisplacement();  // displacement
-        auto v = p.sliceVelocity();	// velcoity
-        auto f = p.sliceForce();	// force
-        auto rho = p.sliceDensity();	// rho
+    // Substep kick with the contact force.
+    template <class ParticlesType>
+    void kick( ParticlesType& p, const double half_h )
+    {
+        // No contact force before the first evaluation.
+        if ( _fc.extent( 0 ) != p.localOffset() )
+            return;
 
-        auto dt = _dt;
-        auto init_func = KOKKOS_LAMBDA( const int i )
+        _timer.start();
+        auto v = p.sliceVelocity();
+        auto rho = p.sliceDensity();
+        auto fc = _fc;
+        auto kick_func = KOKKOS_LAMBDA( const int i )
         {
-	
-	// Update displacements for stage 2
-	u( i, 0 ) = u( i, 0 ) + c2 * v( i, 0) * dt;
-	u( i, 1 ) = u( i, 1 ) + c2 * v( i, 1) * dt;
- 	u( i, 2 ) = u( i, 2 ) + c2 * v( i, 2) * dt;
-
-	
+            const double half_h_m = half_h / rho( i );
+            for ( int d = 0; d < ParticlesType::dim; d++ )
+                v( i, d ) += half_h_m * fc( i, d );
         };
         Kokkos::RangePolicy<exec_space> policy( p.frozenOffset(),
                                                 p.localOffset() );
-        Kokkos::parallel_for( "CabanaPD::Yoshida::stageOne", policy,
-                              init_func );
-
+        Kokkos::parallel_for( "CabanaPD::ContactSubcycle::Kick", policy,
+                              kick_func );
         _timer.stop();
     }
 
-
-//Update force via solver 
-
-
-// Update stage 2 velcoity
+    // Substep drift of all owned particles, such that ghost and contact
+    // neighbor positions remain consistent between substeps.
     template <class ParticlesType>
-    void stageTwoVel( ParticlesType& p )
+    void drift( ParticlesType& p, const double h )
     {
         _timer.start();
-
-        auto u = p.sliceDisplacement();  // displacement
-        auto v = p.sliceVelocity();	// velcoity
-        auto f = p.sliceForce();	// force
-        auto rho = p.sliceDensity();	// rho
-
-        auto dt = _dt;
-        auto init_func = KOKKOS_LAMBDA( const int i )
+        auto u = p.sliceDisplacement();
+        auto v = p.sliceVelocity();
+        auto drift_func = KOKKOS_LAMBDA( const int i )
         {
-
-	    // Update stage 2 velcoity
-            v( i, 0 ) =  v( i, 0 ) + d2 * dt * f( i, 0 ) / rho( i );
-            v( i, 1 ) =  v( i, 1 ) + d2 * dt * f( i, 1 ) / rho( i );
-            v( i, 2 ) =  v( i, 2 ) + d2 * dt * f( i, 2 ) / rho( i );
-          
-	
+            for ( int d = 0; d < ParticlesType::dim; d++ )
+                u( i, d ) += h * v( i, d );
         };
         Kokkos::RangePolicy<exec_space> policy( p.frozenOffset(),
                                                 p.localOffset() );
-        Kokkos::parallel_for( "CabanaPD::Yoshida::stageOne", policy,
-                              init_func );
-
+        Kokkos::parallel_for( "CabanaPD::ContactSubcycle::Drift", policy,
+                              drift_func );
+        p.markModified( DisplacementField{} );
         _timer.stop();
     }
 
-
-
-
-// Update stage 3 displacements
-    template <class ParticlesType>
-    void stageThreeDisplacement( ParticlesType& p )
+    // Stable timestep scale of the contact stiffness: the outer step may be
+    // num_substeps times the contact limit.
+    double stiffnessScale() const
     {
-        _timer.start();
+        return 1.0 / ( static_cast<double>( _num_substeps ) * _num_substeps );
+    }
 
-        auto u = p.sliceDisplacement();  // displacement
-        auto v = p.sliceVelocity();	// velcoity
-        auto f = p.sliceForce();	// force
-        auto rho = p.sliceDensity();	// rho
+    auto time() { return _timer.time(); };
 
-        auto dt = _dt;
-        auto init_func = KOKKOS_LAMBDA( const int i )
-        {
-	
-	// Update displacements for stage 3
-	u( i, 0 ) = u( i, 0 ) + c3 * v( i, 0) * dt;
-	u( i, 1 ) = u( i, 1 ) + c3 * v( i, 1) * dt;
- 	u( i, 2 ) = u( i, 2 ) + c3 * v( i, 2) * dt;
+    void profile( TimerRegistry& timers ) const
+    {
+        timers.add( "Integrate::ContactSubcycle", _timer );
+    }
+};
 
-	
-        };
-        Kokkos::RangePolicy<exec_space> policy( p.frozenOffset(),
-                                                p.localOffset() );
-        Kokkos::parallel_for( "CabanaPD::Yoshida::stageOne", policy,
-                              init_func );
+/******************************************************************************
+  Adaptive dynamic relaxation (Underwood; Kilic and Madenci 2010).
 
-        _timer.stop();
-    }
+  Central differences with a unit fictitious timestep, a fictitious density
+  from the bond stiffness of each particle, and a global damping coefficient
+  chosen every iteration from Rayleigh's quotient of the local diagonal
+  stiffness. Only the equilibrium state is meaningful.
 
+  Each iteration the solver computes forces (plus any external forces) and the
+  residual, then steps the displacements. Particles whose displacement was
+  overwritten since the last step (e.g. prescribed by a boundary condition)
+  are flagged as constrained and excluded from the residual and damping.
+******************************************************************************/
+template <class ExecutionSpace>
+class DynamicRelaxation
+{
+    using exec_space = ExecutionSpace;
+    using memory_space = typename exec_space::memory_space;
 
-//Update force via solver 
+    Kokkos::View<double*, memory_space> _lambda;
+    Kokkos::View<double* [3], memory_space> _f_old;
+    Kokkos::View<double* [3], memory_space> _u_step;
+    Kokkos::View<int*, memory_space> _constrained;
+    double _damping = 0.0;
+    bool _first = true;
+    Timer _timer = Timer( "Integrate" );
 
+  public:
+    DynamicRelaxation() {}
+
+    // Fictitious density lambda = scale k from the bond stiffness sum of each
+    // owned particle, k = sum_j c vol_j / xi. This satisfies the stability
+    // limit lambda >= 1/4 sum_j |K_ij| for a unit timestep, since the full
+    // stiffness row sum (including the diagonal) is at most 2 sqrt(3) k.
+    template <class ParticlesType, class StiffnessType>
+    void setDensity( ParticlesType& p, const StiffnessType& k,
+                     const double scale = 1.0 )
+    {
+        const std::size_t num_local = p.localOffset();
+        Kokkos::realloc( _lambda, num_local );
+        Kokkos::realloc( _f_old, num_local );
+        Kokkos::realloc( _u_step, num_local );
+        Kokkos::realloc( _constrained, num_local );
+
+        auto lambda = _lambda;
+        Kokkos::RangePolicy<exec_space> policy( 0, num_local );
+        Kokkos::parallel_for(
+            "CabanaPD::DynamicRelaxation::density", policy,
+            KOKKOS_LAMBDA( const int i ) {
+                // Particles without bonds have no force.
+                lambda( i ) = k( i ) > 0.0 ? scale * k( i ) : 1.0;
+            } );
+        restart( p );
+    }
 
-// Update stage 3 velcoity
+    // Start relaxing from rest, e.g. for a new load increment.
     template <class ParticlesType>
-    void stageThreeVel( ParticlesType& p )
+    void restart( ParticlesType& p )
     {
-        _timer.start();
-
-        auto u = p.sliceDisplacement();  // displacement
-        auto v = p.sliceVelocity();	// velcoity
-        auto f = p.sliceForce();	// force
-        auto rho = p.sliceDensity();	// rho
-
-        auto dt = _dt;
-        auto init_func = KOKKOS_LAMBDA( const int i )
-        {
-
-	    // Update stage 3 velcoity
-            v( i, 0 ) =  v( i, 0 ) + d3 * dt * f( i, 0 ) / rho( i );
-            v( i, 1 ) =  v( i, 1 ) + d3 * dt * f( i, 1 ) / rho( i );
-            v( i, 2 ) =  v( i, 2 ) + d3 * dt * f( i, 2 ) / rho( i );
-          
-	
-        };
+        auto u = p.sliceDisplacement();
+        auto v = p.sliceVelocity();
+        auto u_step = _u_step;
         Kokkos::RangePolicy<exec_space> policy( p.frozenOffset(),
                                                 p.localOffset() );
-        Kokkos::parallel_for( "CabanaPD::Yoshida::stageOne", policy,
-                              init_func );
-
-        _timer.stop();
+        Kokkos::parallel_for(
+            "CabanaPD::DynamicRelaxation::restart", policy,
+            KOKKOS_LAMBDA( const int i ) {
+                for ( int d = 0; d < ParticlesType::dim; d++ )
+                {
+                    v( i, d ) = 0.0;
+                    u_step( i, d ) = u( i, d );
+                }
+            } );
+        _first = true;
+        _damping = 0.0;
     }
 
-
-
-// Update stage 4 displacements
+    // Global residual norm of the free owned particles, also updating the
+    // damping coefficient for the next step (collective).
     template <class ParticlesType>
-    void stageFourDisplacement( ParticlesType& p )
+    double residual( ParticlesType& p, MPI_Comm comm = MPI_COMM_WORLD )
     {
         _timer.start();
 
-        auto u = p.sliceDisplacement();  // displacement
-        auto v = p.sliceVelocity();	// velcoity
-        auto f = p.sliceForce();	// force
-        auto rho = p.sliceDensity();	// rho
-
-        auto dt = _dt;
-        auto init_func = KOKKOS_LAMBDA( const int i )
+        auto u = p.sliceDisplacement();
+        auto v = p.sliceVelocity();
+        auto f = p.sliceForce();
+        auto lambda = _lambda;
+        auto f_old = _f_old;
+        auto u_step = _u_step;
+        auto constrained = _constrained;
+        const bool first = _first;
+
+        auto residual_func =
+            KOKKOS_LAMBDA( const int i, double& r2, double& uku, double& uu )
         {
-	
-	// Update displacements for stage 4
-	u( i, 0 ) = u( i, 0 ) + c4 * v( i, 0) * dt;
-	u( i, 1 ) = u( i, 1 ) + c4 * v( i, 1) * dt;
- 	u( i, 2 ) = u( i, 2 ) + c4 * v( i, 2) * dt;
-
-	
+            for ( int d = 0; d < ParticlesType::dim; d++ )
+                if ( u( i, d ) != u_step( i, d ) )
+                    constrained( i ) = 1;
+            if ( constrained( i ) )
+                return;
+
+            for ( int d = 0; d < ParticlesType::dim; d++ )
+            {
+                r2 += f( i, d ) * f( i, d );
+                // Local diagonal stiffness from the change in force.
+                if ( !first && v( i, d ) != 0.0 )
+                {
+                    const double k_ii = -( f( i, d ) - f_old( i, d ) ) /
+                                        lambda( i ) / v( i, d );
+                    uku += u( i, d ) * k_ii * u( i, d );
+                }
+                uu += u( i, d ) * u( i, d );
+            }
         };
+        double local[3] = { 0.0, 0.0, 0.0 };
         Kokkos::RangePolicy<exec_space> policy( p.frozenOffset(),
                                                 p.localOffset() );
-        Kokkos::parallel_for( "CabanaPD::Yoshida::stageOne", policy,
-                              init_func );
+        Kokkos::parallel_reduce( "CabanaPD::DynamicRelaxation::residual",
+                                 policy, residual_func, local[0], local[1],
+                                 local[2] );
+        double global[3];
+        MPI_Allreduce( local, global, 3, MPI_DOUBLE, MPI_SUM, comm );
+
+        _damping = 0.0;
+        if ( global[1] > 0.0 && global[2] > 0.0 )
+            _damping = 2.0 * Kokkos::sqrt( global[1] / global[2] );
 
         _timer.stop();
+        return Kokkos::sqrt( global[0] );
     }
 
-
-//Update force via solver -- break bonds
-
-
-// Update stage 4 velcoity
+    // Velocity and displacement update with the current forces.
     template <class ParticlesType>
-    void stageFourVel( ParticlesType& p )
+    void step( ParticlesType& p )
     {
         _timer.start();
 
-        auto u = p.sliceDisplacement();  // displacement
-        auto v = p.sliceVelocity();	// velcoity
-        auto f = p.sliceForce();	// force
-        auto rho = p.sliceDensity();	// rho
+        auto u = p.sliceDisplacement();
+        auto v = p.sliceVelocity();
+        auto f = p.sliceForce();
+        auto lambda = _lambda;
+        auto f_old = _f_old;
+        auto u_step = _u_step;
+        const bool first = _first;
+        const double c = _damping;
 
-        auto dt = _dt;
-        auto init_func = KOKKOS_LAMBDA( const int i )
+        auto step_func = KOKKOS_LAMBDA( const int i )
         {
-
-	    // Update stage 4 velcoity
-            v( i, 0 ) =  v( i, 0 );
-            v( i, 1 ) =  v( i, 1 );
-            v( i, 2 ) =  v( i, 2 );
-          
-	
+            for ( int d = 0; d < ParticlesType::dim; d++ )
+            {
+                const double a = f( i, d ) / lambda( i );
+                if ( first )
+                    v( i, d ) = 0.5 * a;
+                else
+                    v( i, d ) =
+                        ( ( 2.0 - c ) * v( i, d ) + 2.0 * a ) / ( 2.0 + c );
+                u( i, d ) += v( i, d );
+                f_old( i, d ) = f( i, d );
+                u_step( i, d ) = u( i, d );
+            }
         };
         Kokkos::RangePolicy<exec_space> policy( p.frozenOffset(),
                                                 p.localOffset() );
-        Kokkos::parallel_for( "CabanaPD::Yoshida::stageOne", policy,
-                              init_func );
+        Kokkos::parallel_for( "CabanaPD::DynamicRelaxation::step", policy,
+                              step_func );
+        p.markModified( DisplacementField{} );
+        _first = false;
 
         _timer.stop();
     }
 
+    auto damping() const { return _damping; }
+    // Number of owned particles excluded from the residual (collective).
+    std::size_t numConstrained( MPI_Comm comm = MPI_COMM_WORLD ) const
+    {
+        auto constrained = _constrained;
+        std::size_t local = 0;
+        Kokkos::RangePolicy<exec_space> policy( 0, constrained.size() );
+        Kokkos::parallel_reduce(
+            "CabanaPD::DynamicRelaxation::numConstrained", policy,
+            KOKKOS_LAMBDA( const int i, std::size_t& sum ) {
+                sum += constrained( i );
+            },
+            local );
+        unsigned long long global = 0;
+        unsigned long long local_ull = local;
+        MPI_Allreduce( &local_ull, &global, 1, MPI_UNSIGNED_LONG_LONG,
+                       MPI_SUM, comm );
+        return global;
+    }
 
- double timeInit() { return 0.0; };
+    double timeInit() { return 0.0; };
     auto time() { return _timer.time(); };
-};
 
+    void profile( TimerRegistry& timers ) const
+    {
+        timers.add( "Integrate", _timer );
+    }
+};
 
 } // namespace CabanaPD
 
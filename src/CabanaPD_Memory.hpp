@@ -0,0 +1,172 @@
+/****************************************************************************
+ * Copyright (c) 2022 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of CabanaPD. CabanaPD is distributed under a           *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include "mpi.h"
+
+#include <iomanip>
+#include <string>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include <Kokkos_Core.hpp>
+
+#include <CabanaPD_Output.hpp>
+
+namespace CabanaPD
+{
+//---------------------------------------------------------------------------//
+// Allocated bytes, including padding.
+//---------------------------------------------------------------------------//
+template <class ViewType>
+double viewBytes( const ViewType& view )
+{
+    return static_cast<double>( view.span() ) *
+           sizeof( typename ViewType::value_type );
+}
+
+// AoSoA capacity (whole SoA blocks) rather than size.
+template <class AoSoAType>
+double aosoaBytes( const AoSoAType& aosoa )
+{
+    return static_cast<double>( aosoa.capacity() /
+                                AoSoAType::vector_length ) *
+           sizeof( typename AoSoAType::soa_type );
+}
+
+// Verlet list storage: rows are padded to the maximum number of neighbors
+// for the 2D layout, with row offsets instead for the 1D (CSR) layout.
+template <class NeighborListType>
+double neighborListBytes( const NeighborListType& list )
+{
+    using neighbors_type = decltype( list._data.neighbors );
+    double bytes =
+        viewBytes( list._data.counts ) + viewBytes( list._data.neighbors );
+    if constexpr ( neighbors_type::rank == 1 )
+        bytes += viewBytes( list._data.offsets );
+    return bytes;
+}
+
+// Memory available to a single device of the given memory space (system
+// memory for host spaces), or zero if unknown.
+template <class MemorySpace>
+double deviceMemoryBytes()
+{
+#if defined( KOKKOS_ENABLE_CUDA )
+    if constexpr ( std::is_same<MemorySpace, Kokkos::CudaSpace>::value ||
+                   std::is_same<MemorySpace, Kokkos::CudaUVMSpace>::value )
+    {
+        std::size_t free_bytes = 0;
+        std::size_t total_bytes = 0;
+        cudaMemGetInfo( &free_bytes, &total_bytes );
+        return static_cast<double>( total_bytes );
+    }
+#endif
+#if defined( KOKKOS_ENABLE_HIP )
+    if constexpr ( std::is_same<MemorySpace, Kokkos::HIPSpace>::value )
+    {
+        std::size_t free_bytes = 0;
+        std::size_t total_bytes = 0;
+        if ( hipMemGetInfo( &free_bytes, &total_bytes ) != hipSuccess )
+            return 0.0;
+        return static_cast<double>( total_bytes );
+    }
+#endif
+    if constexpr ( Kokkos::SpaceAccessibility<Kokkos::HostSpace,
+                                              MemorySpace>::accessible )
+    {
+        const long pages = sysconf( _SC_PHYS_PAGES );
+        const long page_size = sysconf( _SC_PAGE_SIZE );
+        if ( pages > 0 && page_size > 0 )
+            return static_cast<double>( pages ) * page_size;
+    }
+    return 0.0;
+}
+
+/******************************************************************************
+  Memory report.
+
+  Components add the bytes of their major allocations by name (mirroring the
+  timer registry). The report lists the minimum and maximum across ranks for
+  each and projects the maximum number of particles per device from the
+  largest per-particle footprint.
+******************************************************************************/
+class MemoryRegistry
+{
+    std::vector<std::pair<std::string, double>> _entries;
+
+  public:
+    void add( const std::string& name, const double bytes )
+    {
+        _entries.push_back( { name, bytes } );
+    }
+
+    auto size() const { return _entries.size(); }
+
+    double total() const
+    {
+        double sum = 0.0;
+        for ( auto& entry : _entries )
+            sum += entry.second;
+        return sum;
+    }
+
+    // Collective: all ranks must add the same entries in the same order.
+    // Written from rank 0.
+    template <class StreamType>
+    void write( StreamType& out, const std::size_t num_local,
+                const double device_bytes,
+                MPI_Comm comm = MPI_COMM_WORLD ) const
+    {
+        constexpr double mb = 1024.0 * 1024.0;
+        const std::size_t num = _entries.size() + 1;
+        std::vector<double> local( num );
+        for ( std::size_t e = 0; e < _entries.size(); e++ )
+            local[e] = _entries[e].second;
+        local[num - 1] = total();
+        std::vector<double> min_bytes( num );
+        std::vector<double> max_bytes( num );
+        MPI_Reduce( local.data(), min_bytes.data(), num, MPI_DOUBLE, MPI_MIN,
+                    0, comm );
+        MPI_Reduce( local.data(), max_bytes.data(), num, MPI_DOUBLE, MPI_MAX,
+                    0, comm );
+
+        double per_particle =
+            num_local > 0 ? local[num - 1] / num_local : 0.0;
+        double max_per_particle = 0.0;
+        MPI_Reduce( &per_particle, &max_per_particle, 1, MPI_DOUBLE, MPI_MAX,
+                    0, comm );
+
+        log( out, "#Memory per rank (MB): name min max" );
+        for ( std::size_t e = 0; e < _entries.size(); e++ )
+            log( out, "Memory-", _entries[e].first, " ", std::fixed,
+                 std::setprecision( 3 ), min_bytes[e] / mb, " ",
+                 max_bytes[e] / mb );
+        log( out, "Memory-Total ", std::fixed, std::setprecision( 3 ),
+             min_bytes[num - 1] / mb, " ", max_bytes[num - 1] / mb );
+        log( out, "Memory-Bytes-Per-Particle ", std::fixed,
+             std::setprecision( 1 ), max_per_particle );
+        if ( device_bytes > 0.0 && max_per_particle > 0.0 )
+            log( out, "Memory-Projected-Max-Particles-Per-Device ",
+                 std::scientific, std::setprecision( 3 ),
+                 device_bytes / max_per_particle, "\n" );
+        else
+            log( out, "Memory-Projected-Max-Particles-Per-Device unknown\n" );
+    }
+};
+
+} // namespace CabanaPD
+
+#endif
@@ -26,6 +26,7 @@
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 
 #include <mpi.h>
@@ -34,16 +35,27 @@ namespace CabanaPD
 {
 inline bool print_rank()
 {
-    int proc_rank;
-    MPI_Comm_rank( MPI_COMM_WORLD, &proc_rank );
-    return proc_rank == 0;
+    // The rank is fixed for the run: only query it once.
+    static const bool is_print_rank = []()
+    {
+        int proc_rank;
+        MPI_Comm_rank( MPI_COMM_WORLD, &proc_rank );
+        return proc_rank == 0;
+    }();
+    return is_print_rank;
 }
 
+// Files are left buffered; other streams (console) are flushed every line.
 template <class t_stream, class t_last>
 void log( t_stream& stream, t_last&& last )
 {
     if ( print_rank() )
-        stream << last << std::endl;
+    {
+        if constexpr ( std::is_base_of<std::ofstream, t_stream>::value )
+            stream << last << "\n";
+        else
+            stream << last << std::endl;
+    }
 }
 
 template <class t_stream, class t_head, class... t_tail>
@@ -0,0 +1,411 @@
+/****************************************************************************
+ * Copyright (c) 2022 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of CabanaPD. CabanaPD is distributed under a           *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#ifndef PARTICLEOUTPUT_H
+#define PARTICLEOUTPUT_H
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mpi.h"
+
+#include <Kokkos_Core.hpp>
+
+#include <Cabana_Core.hpp>
+#include <Cabana_Grid.hpp>
+
+#include <CabanaPD_Output.hpp>
+
+namespace CabanaPD
+{
+/******************************************************************************
+  Particle output pipeline.
+
+  The requested fields of a subset of the local particles (every stride-th
+  particle within a region) are copied into host staging buffers, optionally
+  converted to single precision, and written from the staged copy. With
+  asynchronous output the HDF5 write runs on a background thread while the
+  simulation continues; only one frame is in flight and the next output
+  waits for it. This requires MPI initialized with MPI_THREAD_MULTIPLE,
+  otherwise the staged frame is written immediately. SILO output is always
+  written immediately.
+******************************************************************************/
+template <class MemorySpace, int Dimension = 3>
+class ParticleOutput
+{
+  public:
+    using memory_space = MemorySpace;
+    using execution_space = typename memory_space::execution_space;
+    static constexpr int dim = Dimension;
+    static constexpr int vector_length =
+        Cabana::Impl::PerformanceTraits<execution_space>::vector_length;
+
+    // Staged fields are written directly from device kernels when pinned
+    // host memory is available.
+#ifdef KOKKOS_HAS_SHARED_HOST_PINNED_SPACE
+    using host_space = Kokkos::SharedHostPinnedSpace;
+#else
+    using host_space = Kokkos::HostSpace;
+#endif
+    static constexpr bool direct_staging =
+        Kokkos::SpaceAccessibility<execution_space,
+                                   host_space>::accessible;
+
+    ParticleOutput()
+    {
+        for ( int d = 0; d < dim; d++ )
+        {
+            _low[d] = std::numeric_limits<double>::lowest();
+            _high[d] = std::numeric_limits<double>::max();
+        }
+    }
+
+    ~ParticleOutput()
+    {
+        finish();
+        int finalized;
+        MPI_Finalized( &finalized );
+        if ( _comm != MPI_COMM_NULL && !finalized )
+            MPI_Comm_free( &_comm );
+    }
+
+    ParticleOutput( const ParticleOutput& ) = delete;
+    ParticleOutput& operator=( const ParticleOutput& ) = delete;
+
+    // Output all fields (if empty) or only those with matching labels.
+    // Positions are always written.
+    void setOptions( const std::vector<std::string>& fields, const int stride,
+                     const std::array<double, dim> low,
+                     const std::array<double, dim> high,
+                     const bool single_precision, const bool async )
+    {
+        if ( stride < 1 )
+            throw std::runtime_error( "Output stride must be positive." );
+
+        finish();
+        _fields = fields;
+        _stride = stride;
+        _low = low;
+        _high = high;
+        _single_precision = single_precision;
+
+        int thread_level;
+        MPI_Query_thread( &thread_level );
+        _async = async && thread_level == MPI_THREAD_MULTIPLE;
+        // Background writes use their own communicator such that their
+        // collectives cannot interleave with those of the simulation.
+        if ( _async && _comm == MPI_COMM_NULL )
+            MPI_Comm_dup( MPI_COMM_WORLD, &_comm );
+    }
+
+    // Select the particles in [begin, num_local) to output and return the
+    // number selected.
+    template <class PositionType>
+    std::size_t select( const PositionType& x, const std::size_t num_local,
+                        const std::size_t begin = 0 )
+    {
+        if ( _ids.size() < num_local )
+            Kokkos::realloc( _ids, num_local );
+
+        auto ids = _ids;
+        auto stride = _stride;
+        Kokkos::Array<double, dim> low;
+        Kokkos::Array<double, dim> high;
+        for ( int d = 0; d < dim; d++ )
+        {
+            low[d] = _low[d];
+            high[d] = _high[d];
+        }
+        std::size_t count = 0;
+        Kokkos::RangePolicy<execution_space> policy( begin, num_local );
+        Kokkos::parallel_scan(
+            "CabanaPD::ParticleOutput::select", policy,
+            KOKKOS_LAMBDA( const int i, std::size_t& offset,
+                           const bool final ) {
+                bool keep = i % stride == 0;
+                for ( int d = 0; d < dim; d++ )
+                    keep = keep && x( i, d ) >= low[d] && x( i, d ) <= high[d];
+                if ( keep )
+                {
+                    if ( final )
+                        ids( offset ) = i;
+                    offset++;
+                }
+            },
+            count );
+        _num_selected = count;
+        return count;
+    }
+
+    // Stage and write one frame of particles [begin, num_local). Always
+    // called by all ranks.
+    template <class GlobalGridType, class PositionType, class... FieldTypes>
+    void write( [[maybe_unused]] const GlobalGridType& global_grid,
+                const int step, const double time, const std::size_t begin,
+                const std::size_t num_local, const PositionType& x,
+                const FieldTypes&... fields )
+    {
+        // The staging buffers of the previous frame are reused.
+        finish();
+        select( x, num_local, begin );
+        if ( _single_precision )
+            writeFrame( _single_frame, global_grid, step, time, x,
+                        fields... );
+        else
+            writeFrame( _double_frame, global_grid, step, time, x,
+                        fields... );
+    }
+
+    // Wait for a background write to complete.
+    void finish()
+    {
+        if ( _writer.joinable() )
+            _writer.join();
+    }
+
+    auto numSelected() const { return _num_selected; }
+    // Asynchronous output falls back to synchronous writes without
+    // MPI_THREAD_MULTIPLE.
+    bool async() const { return _async; }
+
+  protected:
+    template <class ValueType>
+    struct Frame
+    {
+        using vector_aosoa_type =
+            Cabana::AoSoA<Cabana::MemberTypes<ValueType[dim]>, host_space,
+                          vector_length>;
+        using scalar_aosoa_type =
+            Cabana::AoSoA<Cabana::MemberTypes<ValueType>, host_space,
+                          vector_length>;
+
+        int step = 0;
+        double time = 0.0;
+        std::size_t size = 0;
+        vector_aosoa_type position;
+        std::string position_label;
+        // Only the first num_vectors and num_scalars are written.
+        std::vector<vector_aosoa_type> vectors;
+        std::vector<std::string> vector_labels;
+        std::size_t num_vectors = 0;
+        std::vector<scalar_aosoa_type> scalars;
+        std::vector<std::string> scalar_labels;
+        std::size_t num_scalars = 0;
+    };
+
+    template <class SliceType>
+    bool selected( const SliceType& slice ) const
+    {
+        return _fields.empty() || std::find( _fields.begin(), _fields.end(),
+                                             slice.label() ) != _fields.end();
+    }
+
+    // Gather the selected particles of one field into a host staging buffer.
+    template <class AoSoAType, class SliceType>
+    void stage( AoSoAType& staged, const SliceType& field )
+    {
+        staged.resize( _num_selected );
+        if constexpr ( direct_staging )
+        {
+            gather( staged, field );
+        }
+        else
+        {
+            Cabana::AoSoA<typename AoSoAType::member_types, memory_space,
+                          vector_length>
+                device_staged( "output_staging", _num_selected );
+            gather( device_staged, field );
+            Cabana::deep_copy( staged, device_staged );
+        }
+    }
+
+    template <class AoSoAType, class SliceType>
+    void gather( AoSoAType& staged, const SliceType& field )
+    {
+        using value_type =
+            typename AoSoAType::template member_value_type<0>;
+        auto out = Cabana::slice<0>( staged );
+        auto ids = _ids;
+        Kokkos::RangePolicy<execution_space> policy( 0, _num_selected );
+        Kokkos::parallel_for(
+            "CabanaPD::ParticleOutput::gather", policy,
+            KOKKOS_LAMBDA( const int i ) {
+                const int pid = ids( i );
+                if constexpr ( SliceType::viewRank() == 3 )
+                    for ( int d = 0; d < dim; d++ )
+                        out( i, d ) =
+                            static_cast<value_type>( field( pid, d ) );
+                else
+                    out( i ) = static_cast<value_type>( field( pid ) );
+            } );
+        Kokkos::fence();
+    }
+
+    template <class FrameType, class SliceType>
+    void stageField( FrameType& frame, const SliceType& field )
+    {
+        if ( !selected( field ) )
+            return;
+
+        if constexpr ( SliceType::viewRank() == 3 )
+        {
+            if ( frame.vectors.size() <= frame.num_vectors )
+            {
+                frame.vectors.resize( frame.num_vectors + 1 );
+                frame.vector_labels.resize( frame.num_vectors + 1 );
+            }
+            stage( frame.vectors[frame.num_vectors], field );
+            frame.vector_labels[frame.num_vectors] = field.label();
+            frame.num_vectors++;
+        }
+        else
+        {
+            if ( frame.scalars.size() <= frame.num_scalars )
+            {
+                frame.scalars.resize( frame.num_scalars + 1 );
+                frame.scalar_labels.resize( frame.num_scalars + 1 );
+            }
+            stage( frame.scalars[frame.num_scalars], field );
+            frame.scalar_labels[frame.num_scalars] = field.label();
+            frame.num_scalars++;
+        }
+    }
+
+    template <class FrameType, class GlobalGridType, class PositionType,
+              class... FieldTypes>
+    void writeFrame( FrameType& frame,
+                     [[maybe_unused]] const GlobalGridType& global_grid,
+                     const int step, const double time, const PositionType& x,
+                     const FieldTypes&... fields )
+    {
+        frame.step = step;
+        frame.time = time;
+        frame.size = _num_selected;
+        frame.num_vectors = 0;
+        frame.num_scalars = 0;
+        stage( frame.position, x );
+        frame.position_label = x.label();
+        ( stageField( frame, fields ), ... );
+
+        // The number of written fields of each rank is only known at runtime.
+        constexpr std::size_t max_vectors =
+            ( std::size_t{ 0 } + ... +
+              ( std::decay_t<FieldTypes>::viewRank() == 3 ? 1 : 0 ) );
+        constexpr std::size_t max_scalars =
+            sizeof...( FieldTypes ) - max_vectors;
+
+#ifdef Cabana_ENABLE_HDF5
+        if ( _async )
+        {
+            _writer = std::thread(
+                [this, &frame]()
+                {
+                    dispatchVectors<0, max_vectors, max_scalars>(
+                        frame, _comm, frame.num_vectors, frame.num_scalars );
+                } );
+        }
+        else
+        {
+            dispatchVectors<0, max_vectors, max_scalars>(
+                frame, MPI_COMM_WORLD, frame.num_vectors, frame.num_scalars );
+        }
+#else
+#ifdef Cabana_ENABLE_SILO
+        dispatchVectors<0, max_vectors, max_scalars>(
+            frame, global_grid, frame.num_vectors, frame.num_scalars );
+#else
+        log( std::cout, "No particle output enabled." );
+#endif
+#endif
+    }
+
+    template <std::size_t NumVectors, std::size_t MaxVectors,
+              std::size_t MaxScalars, class FrameType, class Target>
+    void dispatchVectors( FrameType& frame, const Target& target,
+                          const std::size_t num_vectors,
+                          const std::size_t num_scalars )
+    {
+        if ( num_vectors == NumVectors )
+            dispatchScalars<NumVectors, 0, MaxScalars>( frame, target,
+                                                        num_scalars );
+        else if constexpr ( NumVectors < MaxVectors )
+            dispatchVectors<NumVectors + 1, MaxVectors, MaxScalars>(
+                frame, target, num_vectors, num_scalars );
+    }
+
+    template <std::size_t NumVectors, std::size_t NumScalars,
+              std::size_t MaxScalars, class FrameType, class Target>
+    void dispatchScalars( FrameType& frame, const Target& target,
+                          const std::size_t num_scalars )
+    {
+        if ( num_scalars == NumScalars )
+            writeStaged( frame, target,
+                         std::make_index_sequence<NumVectors>{},
+                         std::make_index_sequence<NumScalars>{} );
+        else if constexpr ( NumScalars < MaxScalars )
+            dispatchScalars<NumVectors, NumScalars + 1, MaxScalars>(
+                frame, target, num_scalars );
+    }
+
+    template <class FrameType, class Target, std::size_t... V,
+              std::size_t... S>
+    void writeStaged( FrameType& frame, [[maybe_unused]] const Target& target,
+                      std::index_sequence<V...>, std::index_sequence<S...> )
+    {
+#ifdef Cabana_ENABLE_HDF5
+        Cabana::Experimental::HDF5ParticleOutput::writeTimeStep(
+            h5_config, "particles", target, frame.step, frame.time, frame.size,
+            Cabana::slice<0>( frame.position, frame.position_label ),
+            Cabana::slice<0>( frame.vectors[V], frame.vector_labels[V] )...,
+            Cabana::slice<0>( frame.scalars[S], frame.scalar_labels[S] )... );
+#else
+#ifdef Cabana_ENABLE_SILO
+        Cabana::Grid::Experimental::SiloParticleOutput::
+            writePartialRangeTimeStep(
+                "particles", target, frame.step, frame.time, 0, frame.size,
+                Cabana::slice<0>( frame.position, frame.position_label ),
+                Cabana::slice<0>( frame.vectors[V], frame.vector_labels[V] )...,
+                Cabana::slice<0>( frame.scalars[S],
+                                  frame.scalar_labels[S] )... );
+#endif
+#endif
+    }
+
+    std::vector<std::string> _fields;
+    int _stride = 1;
+    std::array<double, dim> _low;
+    std::array<double, dim> _high;
+    bool _single_precision = false;
+    bool _async = false;
+
+    Kokkos::View<int*, memory_space> _ids;
+    std::size_t _num_selected = 0;
+    Frame<float> _single_frame;
+    Frame<double> _double_frame;
+
+    std::thread _writer;
+    MPI_Comm _comm = MPI_COMM_NULL;
+
+#ifdef Cabana_ENABLE_HDF5
+    Cabana::Experimental::HDF5ParticleOutput::HDF5Config h5_config;
+#endif
+};
+
+} // namespace CabanaPD
+
+#endif
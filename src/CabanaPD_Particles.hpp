@@ -60,7 +60,14 @@
 #ifndef PARTICLES_H
 #define PARTICLES_H
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "mpi.h"
 
@@ -71,28 +78,108 @@
 
 #include <CabanaPD_Comm.hpp>
 #include <CabanaPD_Fields.hpp>
+#include <CabanaPD_Geometry.hpp>
 #include <CabanaPD_Input.hpp>
+#include <CabanaPD_Memory.hpp>
 #include <CabanaPD_Output.hpp>
+#include <CabanaPD_ParticleOutput.hpp>
+#include <CabanaPD_SpatialIndex.hpp>
 #include <CabanaPD_Timer.hpp>
 #include <CabanaPD_Types.hpp>
 
 namespace CabanaPD
 {
+// Default AoSoA vector length for each backend (matching the Cabana default).
+template <class MemorySpace>
+struct DefaultVectorLength
+{
+    static constexpr int value = Cabana::Impl::PerformanceTraits<
+        typename MemorySpace::execution_space>::vector_length;
+};
+
+/******************************************************************************
+  Regions of refined particle resolution.
+
+  Each grid cell with a center inside a box is split into factor particles
+  along each dimension (the largest factor applies within overlapping boxes).
+******************************************************************************/
+struct RefinementBox
+{
+    std::array<double, 3> low;
+    std::array<double, 3> high;
+    int factor;
+};
+
+template <class MemorySpace>
+struct RefinementRegions
+{
+    Kokkos::View<double* [6], MemorySpace> bounds;
+    Kokkos::View<int*, MemorySpace> factors;
+
+    RefinementRegions( const std::vector<RefinementBox>& boxes )
+        : bounds( "refinement_bounds", boxes.size() )
+        , factors( "refinement_factors", boxes.size() )
+    {
+        auto bounds_host = Kokkos::create_mirror_view( bounds );
+        auto factors_host = Kokkos::create_mirror_view( factors );
+        for ( std::size_t b = 0; b < boxes.size(); b++ )
+        {
+            if ( boxes[b].factor < 1 )
+                throw std::runtime_error(
+                    "Refinement factors must be at least 1." );
+            for ( int d = 0; d < 3; d++ )
+            {
+                bounds_host( b, d ) = boxes[b].low[d];
+                bounds_host( b, d + 3 ) = boxes[b].high[d];
+            }
+            factors_host( b ) = boxes[b].factor;
+        }
+        Kokkos::deep_copy( bounds, bounds_host );
+        Kokkos::deep_copy( factors, factors_host );
+    }
+
+    // Refinement factor at a position.
+    KOKKOS_INLINE_FUNCTION
+    int operator()( const double px[3] ) const
+    {
+        int factor = 1;
+        for ( std::size_t b = 0; b < factors.extent( 0 ); b++ )
+        {
+            bool inside = true;
+            for ( int d = 0; d < 3; d++ )
+                if ( px[d] < bounds( b, d ) || px[d] > bounds( b, d + 3 ) )
+                    inside = false;
+            if ( inside )
+                factor = Kokkos::max( factor, factors( b ) );
+        }
+        return factor;
+    }
+};
+
 template <class MemorySpace, class ModelType, class ThermalType,
-          class OutputType = BaseOutput, int Dimension = 3>
+          class OutputType = BaseOutput, int Dimension = 3,
+          int VectorLength = DefaultVectorLength<MemorySpace>::value,
+          class PrecisionType = DoublePrecision>
 class Particles;
 
-template <class MemorySpace, int Dimension>
-class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
+template <class MemorySpace, int Dimension, int VectorLength,
+          class PrecisionType>
+class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension,
+                VectorLength, PrecisionType>
 {
   public:
-    using self_type = Particles<MemorySpace, PMB, TemperatureIndependent,
-                                BaseOutput, Dimension>;
+    using self_type =
+        Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput,
+                  Dimension, VectorLength, PrecisionType>;
     using thermal_type = TemperatureIndependent;
     using output_type = BaseOutput;
+    using precision_type = PrecisionType;
+    // Storage type of the evolving fields (u, v, f, and energy output).
+    using state_type = typename precision_type::state_type;
     using memory_space = MemorySpace;
     using execution_space = typename memory_space::execution_space;
     static constexpr int dim = Dimension;
+    static constexpr int vector_length = VectorLength;
 
     // Per particle.
     unsigned long long int num_global = 0;
@@ -100,29 +187,38 @@ class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
     std::size_t local_offset = 0;
     std::size_t num_ghost = 0;
     std::size_t size = 0;
+    // Non-frozen local particles with no possible ghost neighbors.
+    std::size_t num_interior = 0;
 
-    // x, u, f (vector matching system dimension).
+    // y (vector matching system dimension).
     using vector_type = Cabana::MemberTypes<double[dim]>;
+    // u (vector matching system dimension).
+    using state_vector_type = Cabana::MemberTypes<state_type[dim]>;
     // volume, dilatation, weighted_volume.
     using scalar_type = Cabana::MemberTypes<double>;
     // no-fail.
     using int_type = Cabana::MemberTypes<int>;
     // v, rho, type.
-    using other_types = Cabana::MemberTypes<double[dim], double, int>;
+    using other_types = Cabana::MemberTypes<state_type[dim], double, int>;
 
-    // FIXME: add vector length.
     // FIXME: enable variable aosoa.
-    using aosoa_u_type = Cabana::AoSoA<vector_type, memory_space, 1>;
-    using aosoa_y_type = Cabana::AoSoA<vector_type, memory_space, 1>;
-    using aosoa_vol_type = Cabana::AoSoA<scalar_type, memory_space, 1>;
-    using aosoa_nofail_type = Cabana::AoSoA<int_type, memory_space, 1>;
-    using aosoa_other_type = Cabana::AoSoA<other_types, memory_space>;
+    using aosoa_u_type =
+        Cabana::AoSoA<state_vector_type, memory_space, vector_length>;
+    using aosoa_y_type =
+        Cabana::AoSoA<vector_type, memory_space, vector_length>;
+    using aosoa_vol_type =
+        Cabana::AoSoA<scalar_type, memory_space, vector_length>;
+    using aosoa_nofail_type =
+        Cabana::AoSoA<int_type, memory_space, vector_length>;
+    using aosoa_other_type =
+        Cabana::AoSoA<other_types, memory_space, vector_length>;
     // Using grid here for the particle init.
     using plist_x_type =
-        Cabana::Grid::ParticleList<memory_space, 1,
-                                   CabanaPD::Field::ReferencePosition>;
+        Cabana::Grid::ParticleList<memory_space, vector_length,
+                                   CabanaPD::Field::ReferencePosition<dim>>;
     using plist_f_type =
-        Cabana::ParticleList<memory_space, 1, CabanaPD::Field::Force>;
+        Cabana::ParticleList<memory_space, vector_length,
+                             CabanaPD::Field::Force<state_type, dim>>;
 
     // Per type.
     int n_types = 1;
@@ -141,6 +237,8 @@ class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
         Cabana::Grid::LocalGrid<Cabana::Grid::UniformMesh<double, dim>>>
         local_grid;
     Kokkos::Array<double, dim> dx;
+    // Block boundaries along each dimension after the most recent rebalance.
+    std::array<std::vector<double>, dim> block_bounds;
 
     int halo_width;
 
@@ -215,14 +313,14 @@ class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
                        std::array<double, dim> high_corner,
                        const std::array<int, dim> num_cells )
     {
-        _init_timer.start();
+        _domain_timer.start();
         // Create the MPI partitions.
         Cabana::Grid::DimBlockPartitioner<dim> partitioner;
 
         // Create global mesh of MPI partitions.
         auto global_mesh = Cabana::Grid::createUniformGlobalMesh(
             low_corner, high_corner, num_cells );
-        for ( int d = 0; d < 3; d++ )
+        for ( int d = 0; d < dim; d++ )
             dx[d] = global_mesh->cellSize( d );
 
         std::array<bool, dim> is_periodic;
@@ -232,11 +330,17 @@ class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
             is_periodic[d] = false;
         }
         // Create the global grid.
-        auto global_grid = Cabana::Grid::createGlobalGrid(
+        _global_grid = Cabana::Grid::createGlobalGrid(
             MPI_COMM_WORLD, global_mesh, is_periodic, partitioner );
 
-        // Create a local mesh.
-        local_grid = Cabana::Grid::createLocalGrid( global_grid, halo_width );
+        updateLocalDomain();
+        _domain_timer.stop();
+    }
+
+    // Create the local grid and sub domain bounds from the global grid.
+    void updateLocalDomain()
+    {
+        local_grid = Cabana::Grid::createLocalGrid( _global_grid, halo_width );
         auto local_mesh =
             Cabana::Grid::createLocalMesh<memory_space>( *local_grid );
 
@@ -249,7 +353,87 @@ class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
                 local_mesh.highCorner( Cabana::Grid::Ghost(), d );
             local_mesh_ext[d] = local_mesh.extent( Cabana::Grid::Own(), d );
         }
-        _init_timer.stop();
+    }
+
+    // Repartition the global grid such that each slab of ranks along each
+    // dimension holds an equal share of the per-particle weights (e.g. bond
+    // counts), by current position. The rank blocks stay rectilinear (so the
+    // rank topology is unchanged) with at least halo_width cells each.
+    // Particles must afterwards be migrated to their new owning rank.
+    template <class WeightType>
+    void rebalance( const WeightType& weights )
+    {
+        _timer.start();
+        using exec_space = typename memory_space::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( 0, localOffset() );
+        auto y = sliceCurrentPosition();
+        const auto& global_mesh = _global_grid->globalMesh();
+
+        std::array<int, dim> num_cell;
+        std::array<int, dim> offset;
+        for ( int d = 0; d < dim; d++ )
+        {
+            // Global weight per cell slice along this dimension.
+            const int num_global =
+                _global_grid->globalNumEntity( Cabana::Grid::Cell(), d );
+            const double low = global_mesh.lowCorner( d );
+            const double cell_size = dx[d];
+            Kokkos::View<double*, memory_space> histogram( "rebalance_weights",
+                                                           num_global );
+            Kokkos::parallel_for(
+                "CabanaPD::Particles::rebalanceWeights", policy,
+                KOKKOS_LAMBDA( const int p ) {
+                    int c = static_cast<int>(
+                        Kokkos::floor( ( y( p, d ) - low ) / cell_size ) );
+                    c = Kokkos::min( Kokkos::max( c, 0 ), num_global - 1 );
+                    Kokkos::atomic_add( &histogram( c ), weights( p ) );
+                } );
+            auto histogram_host = Kokkos::create_mirror_view_and_copy(
+                Kokkos::HostSpace(), histogram );
+            MPI_Allreduce( MPI_IN_PLACE, histogram_host.data(), num_global,
+                           MPI_DOUBLE, MPI_SUM, _global_grid->comm() );
+
+            double total = 0.0;
+            for ( int c = 0; c < num_global; c++ )
+                total += histogram_host( c );
+            // Without any weight, fall back to equal cells per rank.
+            if ( total <= 0.0 )
+            {
+                for ( int c = 0; c < num_global; c++ )
+                    histogram_host( c ) = 1.0;
+                total = num_global;
+            }
+
+            // Cut where the cumulative weight first exceeds each equal share.
+            const int num_blocks = _global_grid->dimNumBlock( d );
+            const int min_cells =
+                std::min( std::max( halo_width, 1 ), num_global / num_blocks );
+            std::vector<int> cuts( num_blocks + 1, 0 );
+            cuts[num_blocks] = num_global;
+            double sum = 0.0;
+            int c = 0;
+            for ( int b = 1; b < num_blocks; b++ )
+            {
+                const double target = total * b / num_blocks;
+                while ( c < num_global && sum + histogram_host( c ) <= target )
+                    sum += histogram_host( c++ );
+                cuts[b] =
+                    std::clamp( c, cuts[b - 1] + min_cells,
+                                num_global - ( num_blocks - b ) * min_cells );
+                while ( c < cuts[b] )
+                    sum += histogram_host( c++ );
+            }
+
+            const int block = _global_grid->dimBlockId( d );
+            num_cell[d] = cuts[block + 1] - cuts[block];
+            offset[d] = cuts[block];
+            block_bounds[d].resize( num_blocks + 1 );
+            for ( int b = 0; b <= num_blocks; b++ )
+                block_bounds[d][b] = low + cuts[b] * cell_size;
+        }
+        _global_grid->setNumCellAndOffset( num_cell, offset );
+        updateLocalDomain();
+        _timer.stop();
     }
 
     template <class ExecSpace>
@@ -302,10 +486,11 @@ class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
             bool create = user_create( pid, px );
 
             // Set the particle position.
-            for ( int d = 0; d < 3; d++ )
+            for ( int d = 0; d < dim; d++ )
             {
-                Cabana::get( particle, CabanaPD::Field::ReferencePosition(),
-                             d ) = px[d];
+                Cabana::get( particle,
+                             CabanaPD::Field::ReferencePosition<dim>(), d ) =
+                    px[d];
                 u( pid, d ) = 0.0;
                 v( pid, d ) = 0.0;
                 f( pid, d ) = 0.0;
@@ -334,6 +519,118 @@ class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
         _init_timer.stop();
     }
 
+    // Create particles on the regular grid, splitting the cells within each
+    // refinement region into factor^3 particles of equal volume. The volume
+    // of unrefined cells is kept as the reference for bond horizons (see
+    // BondHorizon). As for uniform creation, user_create selects particles by
+    // position only.
+    template <class ExecSpace, class UserFunctor>
+    void createParticles( const ExecSpace& exec_space, UserFunctor user_create,
+                          const RefinementRegions<memory_space>& refinement,
+                          const std::size_t num_previous = 0,
+                          const bool create_frozen = false )
+    {
+        static_assert( dim == 3, "Refinement regions require 3d." );
+        _init_timer.start();
+        auto owned_cells = local_grid->indexSpace(
+            Cabana::Grid::Own(), Cabana::Grid::Cell(), Cabana::Grid::Local() );
+        auto local_mesh =
+            Cabana::Grid::createLocalMesh<memory_space>( *local_grid );
+        const int low_i = owned_cells.min( 0 );
+        const int low_j = owned_cells.min( 1 );
+        const int low_k = owned_cells.min( 2 );
+        const int num_j = owned_cells.extent( 1 );
+        const int num_k = owned_cells.extent( 2 );
+        const auto cell_dx = dx;
+        const double cell_vol = dx[0] * dx[1] * dx[2];
+        _reference_volume = cell_vol;
+
+        // Position of sub-particle (a, b, c) of a cell split r times.
+        auto sub_position = KOKKOS_LAMBDA( const int cell, const int r,
+                                           const int sub, double px[3] )
+        {
+            int index[3] = { low_i + cell / ( num_j * num_k ),
+                             low_j + ( cell / num_k ) % num_j,
+                             low_k + cell % num_k };
+            double center[3];
+            local_mesh.coordinates( Cabana::Grid::Cell(), index, center );
+            const int sub_index[3] = { sub / ( r * r ), ( sub / r ) % r,
+                                       sub % r };
+            for ( int d = 0; d < 3; d++ )
+                px[d] = center[d] - 0.5 * cell_dx[d] +
+                        ( sub_index[d] + 0.5 ) * cell_dx[d] / r;
+        };
+        auto cell_factor = KOKKOS_LAMBDA( const int cell )
+        {
+            double center[3];
+            sub_position( cell, 1, 0, center );
+            return refinement( center );
+        };
+
+        // Count the created particles.
+        assert( num_previous <= referenceOffset() );
+        const int num_cells = owned_cells.size();
+        Kokkos::RangePolicy<ExecSpace> cell_policy( exec_space, 0, num_cells );
+        int num_particles = 0;
+        Kokkos::parallel_reduce(
+            "CabanaPD::Particles::countRefined", cell_policy,
+            KOKKOS_LAMBDA( const int cell, int& count ) {
+                const int r = cell_factor( cell );
+                for ( int sub = 0; sub < r * r * r; sub++ )
+                {
+                    double px[3];
+                    sub_position( cell, r, sub, px );
+                    if ( user_create( num_previous + count, px ) )
+                        count++;
+                }
+            },
+            num_particles );
+        resize( num_previous + num_particles, 0 );
+
+        auto x = sliceReferencePosition();
+        auto v = sliceVelocity();
+        auto f = sliceForce();
+        auto type = sliceType();
+        auto rho = sliceDensity();
+        auto u = sliceDisplacement();
+        auto vol = sliceVolume();
+        auto nofail = sliceNoFail();
+        Kokkos::parallel_scan(
+            "CabanaPD::Particles::createRefined", cell_policy,
+            KOKKOS_LAMBDA( const int cell, int& offset, const bool final ) {
+                const int r = cell_factor( cell );
+                for ( int sub = 0; sub < r * r * r; sub++ )
+                {
+                    double px[3];
+                    sub_position( cell, r, sub, px );
+                    const int pid = num_previous + offset;
+                    if ( !user_create( pid, px ) )
+                        continue;
+                    if ( final )
+                    {
+                        for ( int d = 0; d < 3; d++ )
+                        {
+                            x( pid, d ) = px[d];
+                            u( pid, d ) = 0.0;
+                            v( pid, d ) = 0.0;
+                            f( pid, d ) = 0.0;
+                        }
+                        vol( pid ) = cell_vol / ( r * r * r );
+                        type( pid ) = 0;
+                        nofail( pid ) = 0;
+                        rho( pid ) = 1.0;
+                    }
+                    offset++;
+                }
+            } );
+
+        if ( create_frozen )
+            frozen_offset = size;
+
+        updateGlobal();
+        _init_timer.stop();
+    }
+
     // Store custom created particle positions and volumes.
     template <class ExecSpace, class PositionType, class VolumeType>
     void createParticles( const ExecSpace, const PositionType& x,
@@ -370,7 +667,7 @@ class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
                 // Set the particle position and volume.
                 // Set everything else to zero.
                 p_vol( pid ) = vol( pid_offset );
-                for ( int d = 0; d < 3; d++ )
+                for ( int d = 0; d < dim; d++ )
                 {
                     p_x( pid, d ) = x( pid_offset, d );
                     u( pid, d ) = 0.0;
@@ -385,6 +682,180 @@ class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
         updateGlobal();
     }
 
+    // Create particles from a geometry file, streaming only the chunks
+    // overlapping the owned domain (see GeometryReader). Particles outside
+    // the global domain are not created.
+    template <class ExecSpace>
+    void createParticles( const ExecSpace& exec_space,
+                          const GeometryReader& reader,
+                          const std::size_t num_previous = 0,
+                          const bool create_frozen = false )
+    {
+        _init_timer.start();
+        assert( num_previous <= referenceOffset() );
+        auto chunks = reader.overlapping( local_mesh_lo, local_mesh_hi );
+        resize( num_previous + reader.count( chunks ), 0 );
+
+        Kokkos::Array<double, dim> low;
+        Kokkos::Array<double, dim> high;
+        Kokkos::Array<bool, dim> include_high;
+        ownedBox( low, high, include_high );
+
+        std::size_t num_created = 0;
+        reader.read<memory_space>(
+            chunks,
+            [&]( const Kokkos::View<GeometryRecord*, memory_space>& records,
+                 const std::size_t num_records )
+            {
+                num_created += appendRecords(
+                    exec_space, records, num_records,
+                    num_previous + num_created, low, high, include_high );
+            } );
+        resize( num_previous + num_created, 0 );
+
+        if ( create_frozen )
+            frozen_offset = size;
+
+        updateGlobal();
+        _init_timer.stop();
+    }
+
+    // Append the geometry records within the given box at offset and return
+    // the number appended.
+    template <class ExecSpace>
+    std::size_t
+    appendRecords( const ExecSpace& exec_space,
+                   const Kokkos::View<GeometryRecord*, memory_space>& records,
+                   const std::size_t num_records, const std::size_t offset,
+                   const Kokkos::Array<double, dim> low,
+                   const Kokkos::Array<double, dim> high,
+                   const Kokkos::Array<bool, dim> include_high )
+    {
+        auto x = sliceReferencePosition();
+        auto v = sliceVelocity();
+        auto f = sliceForce();
+        auto type = sliceType();
+        auto rho = sliceDensity();
+        auto u = sliceDisplacement();
+        auto vol = sliceVolume();
+        auto nofail = sliceNoFail();
+        int num_added = 0;
+        Kokkos::parallel_scan(
+            "CabanaPD::Particles::createFromGeometry",
+            Kokkos::RangePolicy<ExecSpace>( exec_space, 0, num_records ),
+            KOKKOS_LAMBDA( const int r, int& count, const bool final ) {
+                const auto& record = records( r );
+                for ( int d = 0; d < dim; d++ )
+                    if ( record.x[d] < low[d] || record.x[d] > high[d] ||
+                         ( record.x[d] == high[d] && !include_high[d] ) )
+                        return;
+                if ( final )
+                {
+                    const std::size_t pid = offset + count;
+                    for ( int d = 0; d < dim; d++ )
+                    {
+                        x( pid, d ) = record.x[d];
+                        u( pid, d ) = 0.0;
+                        v( pid, d ) = 0.0;
+                        f( pid, d ) = 0.0;
+                    }
+                    vol( pid ) = record.vol;
+                    type( pid ) = record.type;
+                    nofail( pid ) = record.nofail;
+                    rho( pid ) = 1.0;
+                }
+                count++;
+            },
+            num_added );
+        return num_added;
+    }
+
+    // Create particles at the centers of the non-empty voxels within the
+    // owned domain, reading only the owned block of the voxel file (see
+    // VoxelReader).
+    template <class ExecSpace>
+    void createParticles( const ExecSpace& exec_space,
+                          const VoxelReader& reader,
+                          const std::size_t num_previous = 0,
+                          const bool create_frozen = false )
+    {
+        static_assert( dim == 3, "Voxel geometry requires 3d." );
+        _init_timer.start();
+        assert( num_previous <= referenceOffset() );
+        Kokkos::Array<double, dim> low;
+        Kokkos::Array<double, dim> high;
+        Kokkos::Array<bool, dim> include_high;
+        ownedBox( low, high, include_high );
+        std::array<int, 3> begin;
+        std::array<int, 3> extent;
+        auto voxels = reader.read<memory_space>(
+            { low[0], low[1], low[2] }, { high[0], high[1], high[2] },
+            { include_high[0], include_high[1], include_high[2] }, begin,
+            extent );
+
+        Kokkos::RangePolicy<ExecSpace> voxel_policy( exec_space, 0,
+                                                     voxels.size() );
+        int num_particles = 0;
+        Kokkos::parallel_reduce(
+            "CabanaPD::Particles::countVoxels", voxel_policy,
+            KOKKOS_LAMBDA( const int n, int& count ) {
+                if ( voxels( n ) > 0 )
+                    count++;
+            },
+            num_particles );
+        resize( num_previous + num_particles, 0 );
+
+        auto x = sliceReferencePosition();
+        auto v = sliceVelocity();
+        auto f = sliceForce();
+        auto type = sliceType();
+        auto rho = sliceDensity();
+        auto u = sliceDisplacement();
+        auto vol = sliceVolume();
+        auto nofail = sliceNoFail();
+        const auto voxel_low = reader.lowCorner();
+        const auto spacing = reader.spacing();
+        const Kokkos::Array<double, 3> corner = {
+            voxel_low[0] + begin[0] * spacing[0],
+            voxel_low[1] + begin[1] * spacing[1],
+            voxel_low[2] + begin[2] * spacing[2] };
+        const Kokkos::Array<double, 3> h = { spacing[0], spacing[1],
+                                             spacing[2] };
+        const int num_i = extent[0];
+        const int num_j = extent[1];
+        const double voxel_vol = reader.voxelVolume();
+        Kokkos::parallel_scan(
+            "CabanaPD::Particles::createFromVoxels", voxel_policy,
+            KOKKOS_LAMBDA( const int n, int& offset, const bool final ) {
+                if ( voxels( n ) == 0 )
+                    return;
+                if ( final )
+                {
+                    const int pid = num_previous + offset;
+                    const int index[3] = { n % num_i, ( n / num_i ) % num_j,
+                                           n / ( num_i * num_j ) };
+                    for ( int d = 0; d < 3; d++ )
+                    {
+                        x( pid, d ) = corner[d] + ( index[d] + 0.5 ) * h[d];
+                        u( pid, d ) = 0.0;
+                        v( pid, d ) = 0.0;
+                        f( pid, d ) = 0.0;
+                    }
+                    vol( pid ) = voxel_vol;
+                    type( pid ) = voxels( n ) - 1;
+                    nofail( pid ) = 0;
+                    rho( pid ) = 1.0;
+                }
+                offset++;
+            } );
+
+        if ( create_frozen )
+            frozen_offset = size;
+
+        updateGlobal();
+        _init_timer.stop();
+    }
+
     void updateGlobal()
     {
         // Not using Allreduce because global count is only used for printing.
@@ -394,6 +865,21 @@ class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
                     MPI_SUM, 0, MPI_COMM_WORLD );
     }
 
+    // Owned domain of this rank, including the global upper boundary such
+    // that imported particles on it are owned exactly once.
+    void ownedBox( Kokkos::Array<double, dim>& low,
+                   Kokkos::Array<double, dim>& high,
+                   Kokkos::Array<bool, dim>& include_high ) const
+    {
+        const auto& global_mesh = local_grid->globalGrid().globalMesh();
+        for ( int d = 0; d < dim; d++ )
+        {
+            low[d] = local_mesh_lo[d];
+            high[d] = local_mesh_hi[d];
+            include_high[d] = local_mesh_hi[d] >= global_mesh.highCorner( d );
+        }
+    }
+
     template <class ExecSpace, class FunctorType>
     void updateParticles( const ExecSpace, const FunctorType init_functor,
                           const bool update_frozen = false )
@@ -406,37 +892,201 @@ class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
         Kokkos::parallel_for(
             "CabanaPD::Particles::update_particles", policy,
             KOKKOS_LAMBDA( const int pid ) { init_functor( pid ); } );
+        markModified();
         _timer.stop();
     }
 
+    // Record that a ghosted field was written such that it is communicated
+    // again (shared by all copies of these particles).
+    template <class FieldTag>
+    void markModified( FieldTag tag ) const
+    {
+        _field_versions->bump( tag );
+    }
+    // Any ghosted field may have been written.
+    void markModified() const { _field_versions->bumpAll(); }
+    auto fieldVersions() const { return _field_versions; }
+
+    // Sort frozen and local particles (separately) along a Morton curve over
+    // the local grid cells to improve locality of neighbor accesses. This must
+    // be done before ghosts are communicated or neighbor lists are built.
+    // With a non-zero boundary width, local particles within that distance of
+    // a face shared with another rank are additionally placed last, such that
+    // [frozenOffset, interiorOffset) have no ghost neighbors.
+    template <class ExecSpace>
+    auto reorder( const ExecSpace& exec_space,
+                  const double boundary_width = 0.0 )
+    {
+        if ( num_ghost > 0 )
+            throw std::runtime_error(
+                "Particles must be reordered before ghost communication." );
+
+        _timer.start();
+        // Number of bits per dimension needed to index the owned cells.
+        int bits = 1;
+        for ( int d = 0; d < dim; d++ )
+        {
+            auto num_cells = static_cast<std::uint64_t>(
+                std::ceil( local_mesh_ext[d] / dx[d] ) );
+            while ( ( std::uint64_t( 1 ) << bits ) < num_cells )
+                bits++;
+        }
+        const std::uint64_t max_cell = ( std::uint64_t( 1 ) << bits ) - 1;
+        // Extra bits above the Morton code keep frozen particles first and
+        // boundary particles last.
+        const std::uint64_t boundary_bit = std::uint64_t( 1 ) << ( dim * bits );
+        const std::uint64_t local_bit = std::uint64_t( 1 )
+                                        << ( dim * bits + 1 );
+
+        // Only faces shared with another rank can have ghosts.
+        Kokkos::Array<double, dim> low;
+        Kokkos::Array<double, dim> high;
+        Kokkos::Array<bool, dim> low_shared;
+        Kokkos::Array<bool, dim> high_shared;
+        for ( int d = 0; d < dim; d++ )
+        {
+            low[d] = local_mesh_lo[d];
+            high[d] = local_mesh_hi[d];
+            int offset[3] = { 0, 0, 0 };
+            offset[d] = -1;
+            low_shared[d] = boundary_width > 0.0 &&
+                            gridNeighborRank( *local_grid, offset ) != -1;
+            offset[d] = 1;
+            high_shared[d] = boundary_width > 0.0 &&
+                             gridNeighborRank( *local_grid, offset ) != -1;
+        }
+        auto cell_size = dx;
+        auto num_frozen = frozen_offset;
+        auto x = sliceReferencePosition();
+
+        Kokkos::View<std::uint64_t*, memory_space> keys(
+            Kokkos::ViewAllocateWithoutInitializing( "morton_keys" ),
+            localOffset() );
+        auto morton_key = KOKKOS_LAMBDA( const int pid )
+        {
+            std::uint64_t key = 0;
+            for ( int d = 0; d < dim; d++ )
+            {
+                double c = ( x( pid, d ) - low[d] ) / cell_size[d];
+                std::uint64_t cell = 0;
+                if ( c > 0.0 )
+                    cell = static_cast<std::uint64_t>( c );
+                if ( cell > max_cell )
+                    cell = max_cell;
+                // Interleave the cell index bits.
+                for ( int b = 0; b < bits; b++ )
+                    key |= ( ( cell >> b ) & 1 ) << ( dim * b + d );
+            }
+            if ( static_cast<std::size_t>( pid ) >= num_frozen )
+            {
+                key |= local_bit;
+                for ( int d = 0; d < dim; d++ )
+                {
+                    if ( ( low_shared[d] &&
+                           x( pid, d ) - low[d] <= boundary_width ) ||
+                         ( high_shared[d] &&
+                           high[d] - x( pid, d ) <= boundary_width ) )
+                        key |= boundary_bit;
+                }
+            }
+            keys( pid ) = key;
+        };
+        Kokkos::RangePolicy<ExecSpace> policy( exec_space, 0, localOffset() );
+        Kokkos::parallel_for( "CabanaPD::Particles::morton_keys", policy,
+                              morton_key );
+
+        std::size_t interior = 0;
+        Kokkos::parallel_reduce(
+            "CabanaPD::Particles::count_interior", policy,
+            KOKKOS_LAMBDA( const int pid, std::size_t& count ) {
+                if ( ( keys( pid ) & local_bit ) &&
+                     !( keys( pid ) & boundary_bit ) )
+                    count++;
+            },
+            interior );
+        num_interior = interior;
+
+        auto bin_data = Cabana::sortByKey( keys );
+        Cabana::permute( bin_data, _plist_x.aosoa() );
+        Cabana::permute( bin_data, _aosoa_u );
+        Cabana::permute( bin_data, _aosoa_y );
+        Cabana::permute( bin_data, _aosoa_vol );
+        Cabana::permute( bin_data, _plist_f.aosoa() );
+        Cabana::permute( bin_data, _aosoa_other );
+        Cabana::permute( bin_data, _aosoa_nofail );
+
+        // Compose with any previous reordering to map back to creation order.
+        Kokkos::View<std::size_t*, memory_space> ids( "original_ids",
+                                                      localOffset() );
+        auto previous = _original_ids;
+        const bool has_previous = previous.size() == localOffset();
+        auto update_ids = KOKKOS_LAMBDA( const int pid )
+        {
+            std::size_t p = bin_data.permutation( pid );
+            ids( pid ) = has_previous ? previous( p ) : p;
+        };
+        Kokkos::parallel_for( "CabanaPD::Particles::original_ids", policy,
+                              update_ids );
+        _original_ids = ids;
+        _timer.stop();
+
+        return bin_data;
+    }
+
+    // Creation index of each frozen and local particle (empty if the particles
+    // were never reordered).
+    auto getOriginalIds() const { return _original_ids; }
+
     // Particles are always in order frozen, local, ghost.
     // Values for offsets are distinguished from separate (num) values.
     auto numFrozen() const { return frozen_offset; }
     auto frozenOffset() const { return frozen_offset; }
     auto numLocal() const { return local_offset - frozen_offset; }
     auto localOffset() const { return local_offset; }
+    // Local particles are further split into interior (first) and boundary
+    // only after reordering with a boundary width (otherwise all boundary).
+    auto interiorOffset() const { return frozen_offset + num_interior; }
     auto numGhost() const { return num_ghost; }
     auto referenceOffset() const { return size; }
     auto numGlobal() const { return num_global; }
+    // Forces and output fields only include ghosts with half neighbor lists.
+    // This must be set before the ghosts are created.
+    void useHalfNeighbors( const bool half_neigh ) { _half_neigh = half_neigh; }
+    bool halfNeighbors() const { return _half_neigh; }
+    auto forceOffset() const
+    {
+        return _half_neigh ? referenceOffset() : localOffset();
+    }
+
+    // Volume of unrefined particles, or zero for uniform resolution.
+    double referenceVolume() const { return _reference_volume; }
+    bool variableResolution() const { return _reference_volume > 0.0; }
 
     auto sliceReferencePosition()
     {
-        return _plist_x.slice( CabanaPD::Field::ReferencePosition() );
+        return _plist_x.slice( CabanaPD::Field::ReferencePosition<dim>() );
     }
     auto sliceReferencePosition() const
     {
-        return _plist_x.slice( CabanaPD::Field::ReferencePosition() );
+        return _plist_x.slice( CabanaPD::Field::ReferencePosition<dim>() );
     }
     auto sliceCurrentPosition()
     {
-        // Update before returning data.
-        updateCurrentPosition();
+        // Update before returning data (unless already current).
+        if ( !currentPositionsUpdated() )
+            updateCurrentPosition();
         return Cabana::slice<0>( _aosoa_y, "current_positions" );
     }
     auto sliceCurrentPosition() const
     {
-        // Update before returning data.
-        updateCurrentPosition();
+        // Update before returning data (unless already current).
+        if ( !currentPositionsUpdated() )
+            updateCurrentPosition();
+        return Cabana::slice<0>( _aosoa_y, "current_positions" );
+    }
+    // Current positions without updating, for kernels which write them.
+    auto sliceCurrentPositionNoUpdate()
+    {
         return Cabana::slice<0>( _aosoa_y, "current_positions" );
     }
     auto sliceDisplacement()
@@ -447,7 +1097,10 @@ class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
     {
         return Cabana::slice<0>( _aosoa_u, "displacements" );
     }
-    auto sliceForce() { return _plist_f.slice( CabanaPD::Field::Force() ); }
+    auto sliceForce()
+    {
+        return _plist_f.slice( CabanaPD::Field::Force<state_type, dim>() );
+    }
     auto sliceForceAtomic()
     {
         auto f = sliceForce();
@@ -501,33 +1154,108 @@ class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
         Kokkos::RangePolicy<execution_space> policy( 0, referenceOffset() );
         auto sum_x_u = KOKKOS_LAMBDA( const std::size_t pid )
         {
-            for ( int d = 0; d < 3; d++ )
+            for ( int d = 0; d < dim; d++ )
                 y( pid, d ) = x( pid, d ) + u( pid, d );
         };
         Kokkos::parallel_for( "CabanaPD::CalculateCurrentPositions", policy,
                               sum_x_u );
-        Kokkos::fence();
         //_timer.stop();
     }
 
+    // Record that owned current positions were updated with the current
+    // displacements (e.g. fused with the integrator).
+    void markLocalCurrentPositions() const
+    {
+        _field_versions->local_positions =
+            ( *_field_versions )( DisplacementField{} );
+    }
+
+    // Complete current positions with only the ghosts (after they are
+    // gathered) if owned positions are current, such that they are not
+    // recomputed on access until displacements are next modified. Frozen
+    // particles are only included the first time.
+    void updateGhostCurrentPositions() const
+    {
+        const auto version = ( *_field_versions )( DisplacementField{} );
+        if ( _field_versions->local_positions != version )
+            return;
+        if ( _field_versions->positions == 0 )
+        {
+            updateCurrentPosition();
+            _field_versions->positions = version;
+            return;
+        }
+
+        auto y = Cabana::slice<0>( _aosoa_y, "current_positions" );
+        auto x = sliceReferencePosition();
+        auto u = sliceDisplacement();
+        Kokkos::RangePolicy<execution_space> policy( localOffset(),
+                                                     referenceOffset() );
+        auto sum_x_u = KOKKOS_LAMBDA( const std::size_t pid )
+        {
+            for ( int d = 0; d < dim; d++ )
+                y( pid, d ) = x( pid, d ) + u( pid, d );
+        };
+        Kokkos::parallel_for( "CabanaPD::CalculateGhostCurrentPositions",
+                              policy, sum_x_u );
+        _field_versions->positions = version;
+    }
+
+    bool currentPositionsUpdated() const
+    {
+        return _field_versions->positions ==
+               ( *_field_versions )( DisplacementField{} );
+    }
+
     void resize( int new_local, int new_ghost )
     {
         _timer.start();
         local_offset = new_local;
         num_ghost = new_ghost;
         size = new_local + new_ghost;
+        _field_versions->local_positions = 0;
+        _field_versions->positions = 0;
 
         _plist_x.aosoa().resize( referenceOffset() );
         _aosoa_u.resize( referenceOffset() );
         _aosoa_y.resize( referenceOffset() );
         _aosoa_vol.resize( referenceOffset() );
-        _plist_f.aosoa().resize( localOffset() );
+        _plist_f.aosoa().resize( forceOffset() );
         _aosoa_other.resize( localOffset() );
         _aosoa_nofail.resize( referenceOffset() );
         size = _plist_x.size();
         _timer.stop();
     };
 
+    // Move local particles to their new owning ranks. Ghosts are discarded
+    // and must be communicated again afterwards.
+    template <class DistributorType>
+    void migrate( const DistributorType& distributor )
+    {
+        if ( frozen_offset > 0 )
+            throw std::runtime_error(
+                "Particle migration with frozen particles is not supported." );
+
+        resize( local_offset, 0 );
+        _timer.start();
+        Cabana::migrate( distributor, _plist_x.aosoa() );
+        Cabana::migrate( distributor, _aosoa_u );
+        Cabana::migrate( distributor, _aosoa_y );
+        Cabana::migrate( distributor, _aosoa_vol );
+        Cabana::migrate( distributor, _plist_f.aosoa() );
+        Cabana::migrate( distributor, _aosoa_other );
+        Cabana::migrate( distributor, _aosoa_nofail );
+        _timer.stop();
+
+        local_offset = distributor.totalNumImport();
+        num_ghost = 0;
+        size = _plist_x.size();
+        // Particles are no longer sorted by distance to the rank boundary or
+        // traceable to their creation order.
+        num_interior = 0;
+        _original_ids = Kokkos::View<std::size_t*, memory_space>();
+    }
+
     auto getPosition( const bool use_reference )
     {
         if ( use_reference )
@@ -536,42 +1264,78 @@ class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
             return sliceCurrentPosition();
     }
 
-    // TODO: enable ignoring frozen particles.
+    // Output only the fields with the given labels (all if empty) for every
+    // stride-th particle within [low, high], optionally in single precision
+    // and written in the background. Frozen particles can be excluded.
+    void setOutputOptions( const std::vector<std::string>& fields,
+                           const int stride, const std::array<double, dim> low,
+                           const std::array<double, dim> high,
+                           const bool single_precision, const bool async,
+                           const bool include_frozen = true )
+    {
+        _particle_output->setOptions( fields, stride, low, high,
+                                      single_precision, async );
+        _output_frozen = include_frozen;
+    }
+
     template <typename... OtherFields>
-    void output( [[maybe_unused]] const int output_step,
-                 [[maybe_unused]] const double output_time,
-                 [[maybe_unused]] const bool use_reference,
-                 [[maybe_unused]] OtherFields&&... other )
+    void output( const int output_step, const double output_time,
+                 const bool use_reference, OtherFields&&... other )
     {
         _output_timer.start();
+        const std::size_t begin = _output_frozen ? 0 : frozenOffset();
+        _particle_output->write( local_grid->globalGrid(), output_step,
+                                 output_time, begin, localOffset(),
+                                 getPosition( use_reference ), sliceForce(),
+                                 sliceDisplacement(), sliceVelocity(),
+                                 std::forward<OtherFields>( other )... );
+        _output_timer.stop();
+    }
 
-#ifdef Cabana_ENABLE_HDF5
-        Cabana::Experimental::HDF5ParticleOutput::writeTimeStep(
-            h5_config, "particles", MPI_COMM_WORLD, output_step, output_time,
-            localOffset(), getPosition( use_reference ), sliceForce(),
-            sliceDisplacement(), sliceVelocity(),
-            std::forward<OtherFields>( other )... );
-#else
-#ifdef Cabana_ENABLE_SILO
-        Cabana::Grid::Experimental::SiloParticleOutput::
-            writePartialRangeTimeStep(
-                "particles", local_grid->globalGrid(), output_step, output_time,
-                0, localOffset(), getPosition( use_reference ), sliceForce(),
-                sliceDisplacement(), sliceVelocity(),
-                std::forward<OtherFields>( other )... );
-
-#else
-        log( std::cout, "No particle output enabled." );
-#endif
-#endif
+    bool asyncOutput() const { return _particle_output->async(); }
 
+    // Wait for any output still being written in the background.
+    void finishOutput()
+    {
+        _output_timer.start();
+        _particle_output->finish();
         _output_timer.stop();
     }
 
-    auto timeInit() { return _init_timer.time(); };
+    // Domain decomposition and particle creation times.
+    auto timeInit() { return _domain_timer.time() + _init_timer.time(); };
+    auto timeDomain() { return _domain_timer.time(); };
+    auto timeCreate() { return _init_timer.time(); };
     auto timeOutput() { return _output_timer.time(); };
     auto time() { return _timer.time(); };
 
+    // Cell list shared by the full neighbor lists (see SpatialIndex).
+    auto spatialIndex() const { return _spatial_index; }
+
+    void profile( TimerRegistry& timers ) const
+    {
+        timers.add( "Particles::Domain", _domain_timer );
+        timers.add( "Particles::Init", _init_timer );
+        timers.add( "Particles::Output", _output_timer );
+        timers.add( "Particles::SpatialIndex", _spatial_index->getTimer() );
+        timers.add( "Particles", _timer );
+    }
+
+    // Allocated particle storage, including ghosts and AoSoA padding.
+    void memory( MemoryRegistry& registry ) const
+    {
+        registry.add( "Particles::Reference",
+                      aosoaBytes( _plist_x.aosoa() ) +
+                          viewBytes( _original_ids ) );
+        registry.add( "Particles::Displacement", aosoaBytes( _aosoa_u ) );
+        registry.add( "Particles::Current", aosoaBytes( _aosoa_y ) );
+        registry.add( "Particles::Force", aosoaBytes( _plist_f.aosoa() ) );
+        registry.add( "Particles::Volume", aosoaBytes( _aosoa_vol ) +
+                                               aosoaBytes( _aosoa_nofail ) );
+        registry.add( "Particles::Other", aosoaBytes( _aosoa_other ) );
+        registry.add( "Particles::SpatialIndex", _spatial_index->bytes() );
+    }
+
     friend class Comm<self_type, PMB, TemperatureIndependent>;
     friend class Comm<self_type, PMB, TemperatureDependent>;
 
@@ -584,26 +1348,42 @@ class Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput, Dimension>
 
     plist_x_type _plist_x;
     plist_f_type _plist_f;
+    Kokkos::View<std::size_t*, memory_space> _original_ids;
+
+    std::shared_ptr<ParticleOutput<memory_space, dim>> _particle_output =
+        std::make_shared<ParticleOutput<memory_space, dim>>();
+    bool _output_frozen = true;
+    std::shared_ptr<FieldVersions> _field_versions =
+        std::make_shared<FieldVersions>();
+    std::shared_ptr<SpatialIndex<memory_space>> _spatial_index =
+        std::make_shared<SpatialIndex<memory_space>>();
+    double _reference_volume = 0.0;
+    bool _half_neigh = false;
 
-#ifdef Cabana_ENABLE_HDF5
-    Cabana::Experimental::HDF5ParticleOutput::HDF5Config h5_config;
-#endif
+    std::shared_ptr<
+        Cabana::Grid::GlobalGrid<Cabana::Grid::UniformMesh<double, dim>>>
+        _global_grid;
 
-    Timer _init_timer;
-    Timer _output_timer;
-    Timer _timer;
+    Timer _domain_timer = Timer( "Particles::Domain" );
+    Timer _init_timer = Timer( "Particles::Init" );
+    Timer _output_timer = Timer( "Particles::Output" );
+    Timer _timer = Timer( "Particles" );
 };
 
-template <class MemorySpace, int Dimension>
-class Particles<MemorySpace, LPS, TemperatureIndependent, BaseOutput, Dimension>
+template <class MemorySpace, int Dimension, int VectorLength,
+          class PrecisionType>
+class Particles<MemorySpace, LPS, TemperatureIndependent, BaseOutput, Dimension,
+                VectorLength, PrecisionType>
     : public Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput,
-                       Dimension>
+                       Dimension, VectorLength, PrecisionType>
 {
   public:
-    using self_type = Particles<MemorySpace, LPS, TemperatureIndependent,
-                                BaseOutput, Dimension>;
-    using base_type = Particles<MemorySpace, PMB, TemperatureIndependent,
-                                BaseOutput, Dimension>;
+    using self_type =
+        Particles<MemorySpace, LPS, TemperatureIndependent, BaseOutput,
+                  Dimension, VectorLength, PrecisionType>;
+    using base_type =
+        Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput,
+                  Dimension, VectorLength, PrecisionType>;
     using output_type = typename base_type::output_type;
     using thermal_type = TemperatureIndependent;
     using memory_space = typename base_type::memory_space;
@@ -612,8 +1392,11 @@ class Particles<MemorySpace, LPS, TemperatureIndependent, BaseOutput, Dimension>
     // These are split since weighted volume only needs to be communicated once
     // and dilatation only needs to be communicated for LPS.
     using scalar_type = typename base_type::scalar_type;
-    using aosoa_theta_type = Cabana::AoSoA<scalar_type, memory_space, 1>;
-    using aosoa_m_type = Cabana::AoSoA<scalar_type, memory_space, 1>;
+    using base_type::vector_length;
+    using aosoa_theta_type =
+        Cabana::AoSoA<scalar_type, memory_space, vector_length>;
+    using aosoa_m_type =
+        Cabana::AoSoA<scalar_type, memory_space, vector_length>;
 
     // Per type.
     using base_type::n_types;
@@ -688,6 +1471,18 @@ class Particles<MemorySpace, LPS, TemperatureIndependent, BaseOutput, Dimension>
         return Cabana::slice<0>( _aosoa_m, "weighted_volume" );
     }
 
+    template <class ExecSpace>
+    auto reorder( const ExecSpace& exec_space,
+                  const double boundary_width = 0.0 )
+    {
+        auto bin_data = base_type::reorder( exec_space, boundary_width );
+        _timer.start();
+        Cabana::permute( bin_data, _aosoa_theta );
+        Cabana::permute( bin_data, _aosoa_m );
+        _timer.stop();
+        return bin_data;
+    }
+
     void resize( int new_local, int new_ghost )
     {
         base_type::resize( new_local, new_ghost );
@@ -697,6 +1492,18 @@ class Particles<MemorySpace, LPS, TemperatureIndependent, BaseOutput, Dimension>
         _timer.stop();
     }
 
+    template <class DistributorType>
+    void migrate( const DistributorType& distributor )
+    {
+        _timer.start();
+        _aosoa_theta.resize( base_type::localOffset() );
+        _aosoa_m.resize( base_type::localOffset() );
+        Cabana::migrate( distributor, _aosoa_theta );
+        Cabana::migrate( distributor, _aosoa_m );
+        _timer.stop();
+        base_type::migrate( distributor );
+    }
+
     template <typename... OtherFields>
     void output( const int output_step, const double output_time,
                  const bool use_reference, OtherFields&&... other )
@@ -706,6 +1513,13 @@ class Particles<MemorySpace, LPS, TemperatureIndependent, BaseOutput, Dimension>
                            std::forward<OtherFields>( other )... );
     }
 
+    void memory( MemoryRegistry& registry ) const
+    {
+        base_type::memory( registry );
+        registry.add( "Particles::LPS",
+                      aosoaBytes( _aosoa_theta ) + aosoaBytes( _aosoa_m ) );
+    }
+
     friend class Comm<self_type, PMB, TemperatureIndependent>;
     friend class Comm<self_type, LPS, TemperatureIndependent>;
 
@@ -725,16 +1539,20 @@ class Particles<MemorySpace, LPS, TemperatureIndependent, BaseOutput, Dimension>
     using base_type::_timer;
 };
 
-template <class MemorySpace, int Dimension>
-class Particles<MemorySpace, PMB, TemperatureDependent, BaseOutput, Dimension>
+template <class MemorySpace, int Dimension, int VectorLength,
+          class PrecisionType>
+class Particles<MemorySpace, PMB, TemperatureDependent, BaseOutput, Dimension,
+                VectorLength, PrecisionType>
     : public Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput,
-                       Dimension>
+                       Dimension, VectorLength, PrecisionType>
 {
   public:
-    using self_type = Particles<MemorySpace, PMB, TemperatureDependent,
-                                BaseOutput, Dimension>;
-    using base_type = Particles<MemorySpace, PMB, TemperatureIndependent,
-                                BaseOutput, Dimension>;
+    using self_type =
+        Particles<MemorySpace, PMB, TemperatureDependent, BaseOutput,
+                  Dimension, VectorLength, PrecisionType>;
+    using base_type =
+        Particles<MemorySpace, PMB, TemperatureIndependent, BaseOutput,
+                  Dimension, VectorLength, PrecisionType>;
     using thermal_type = TemperatureDependent;
     using output_type = typename base_type::output_type;
     using memory_space = typename base_type::memory_space;
@@ -743,7 +1561,9 @@ class Particles<MemorySpace, PMB, TemperatureDependent, BaseOutput, Dimension>
     // These are split since weighted volume only needs to be communicated once
     // and dilatation only needs to be communicated for LPS.
     using temp_types = Cabana::MemberTypes<double, double>;
-    using aosoa_temp_type = Cabana::AoSoA<temp_types, memory_space, 1>;
+    using base_type::vector_length;
+    using aosoa_temp_type =
+        Cabana::AoSoA<temp_types, memory_space, vector_length>;
 
     // Per type.
     using base_type::n_types;
@@ -809,19 +1629,36 @@ class Particles<MemorySpace, PMB, TemperatureDependent, BaseOutput, Dimension>
     }
     auto sliceTemperatureConductionAtomic()
     {
-        auto temp = sliceTemperature();
+        auto temp = sliceTemperatureConduction();
         using slice_type = decltype( temp );
         using atomic_type = typename slice_type::atomic_access_slice;
         atomic_type temp_a = temp;
         return temp_a;
     }
 
+    template <class ExecSpace>
+    auto reorder( const ExecSpace& exec_space,
+                  const double boundary_width = 0.0 )
+    {
+        auto bin_data = base_type::reorder( exec_space, boundary_width );
+        Cabana::permute( bin_data, _aosoa_temp );
+        return bin_data;
+    }
+
     void resize( int new_local, int new_ghost )
     {
         base_type::resize( new_local, new_ghost );
         _aosoa_temp.resize( base_type::referenceOffset() );
     }
 
+    template <class DistributorType>
+    void migrate( const DistributorType& distributor )
+    {
+        _aosoa_temp.resize( base_type::localOffset() );
+        Cabana::migrate( distributor, _aosoa_temp );
+        base_type::migrate( distributor );
+    }
+
     template <typename... OtherFields>
     void output( const int output_step, const double output_time,
                  const bool use_reference, OtherFields&&... other )
@@ -831,6 +1668,12 @@ class Particles<MemorySpace, PMB, TemperatureDependent, BaseOutput, Dimension>
                            std::forward<OtherFields>( other )... );
     }
 
+    void memory( MemoryRegistry& registry ) const
+    {
+        base_type::memory( registry );
+        registry.add( "Particles::Temperature", aosoaBytes( _aosoa_temp ) );
+    }
+
     friend class Comm<self_type, PMB, TemperatureIndependent>;
     friend class Comm<self_type, LPS, TemperatureIndependent>;
     friend class Comm<self_type, PMB, TemperatureDependent>;
@@ -846,24 +1689,31 @@ class Particles<MemorySpace, PMB, TemperatureDependent, BaseOutput, Dimension>
     aosoa_temp_type _aosoa_temp;
 };
 
-template <class MemorySpace, class ModelType, class ThermalType, int Dimension>
-class Particles<MemorySpace, ModelType, ThermalType, EnergyOutput, Dimension>
+template <class MemorySpace, class ModelType, class ThermalType, int Dimension,
+          int VectorLength, class PrecisionType>
+class Particles<MemorySpace, ModelType, ThermalType, EnergyOutput, Dimension,
+                VectorLength, PrecisionType>
     : public Particles<MemorySpace, ModelType, ThermalType, BaseOutput,
-                       Dimension>
+                       Dimension, VectorLength, PrecisionType>
 {
   public:
     using self_type =
-        Particles<MemorySpace, ModelType, ThermalType, EnergyOutput, Dimension>;
+        Particles<MemorySpace, ModelType, ThermalType, EnergyOutput, Dimension,
+                  VectorLength, PrecisionType>;
     using base_type =
-        Particles<MemorySpace, ModelType, ThermalType, BaseOutput, Dimension>;
+        Particles<MemorySpace, ModelType, ThermalType, BaseOutput, Dimension,
+                  VectorLength, PrecisionType>;
     using thermal_type = typename base_type::thermal_type;
     using output_type = EnergyOutput;
     using memory_space = typename base_type::memory_space;
+    using state_type = typename base_type::state_type;
     using base_type::dim;
 
-    // energy, damage
-    using output_types = Cabana::MemberTypes<double, double>;
-    using aosoa_output_type = Cabana::AoSoA<output_types, memory_space, 1>;
+    // energy, damage, neighbor volume (damage normalization for half lists)
+    using output_types = Cabana::MemberTypes<state_type, state_type, double>;
+    using base_type::vector_length;
+    using aosoa_output_type =
+        Cabana::AoSoA<output_types, memory_space, vector_length>;
 
     // Per type.
     using base_type::n_types;
@@ -916,16 +1766,65 @@ class Particles<MemorySpace, ModelType, ThermalType, EnergyOutput, Dimension>
     {
         return Cabana::slice<0>( _aosoa_output, "strain_energy" );
     }
+    auto sliceStrainEnergyAtomic()
+    {
+        auto W = sliceStrainEnergy();
+        using slice_type = decltype( W );
+        using atomic_type = typename slice_type::atomic_access_slice;
+        atomic_type W_a = W;
+        return W_a;
+    }
     auto sliceDamage() { return Cabana::slice<1>( _aosoa_output, "damage" ); }
     auto sliceDamage() const
     {
         return Cabana::slice<1>( _aosoa_output, "damage" );
     }
+    auto sliceDamageAtomic()
+    {
+        auto phi = sliceDamage();
+        using slice_type = decltype( phi );
+        using atomic_type = typename slice_type::atomic_access_slice;
+        atomic_type phi_a = phi;
+        return phi_a;
+    }
+    auto sliceNeighborVolume()
+    {
+        return Cabana::slice<2>( _aosoa_output, "neighbor_volume" );
+    }
+    auto sliceNeighborVolume() const
+    {
+        return Cabana::slice<2>( _aosoa_output, "neighbor_volume" );
+    }
+    auto sliceNeighborVolumeAtomic()
+    {
+        auto vol_H = sliceNeighborVolume();
+        using slice_type = decltype( vol_H );
+        using atomic_type = typename slice_type::atomic_access_slice;
+        atomic_type vol_H_a = vol_H;
+        return vol_H_a;
+    }
+
+    template <class ExecSpace>
+    auto reorder( const ExecSpace& exec_space,
+                  const double boundary_width = 0.0 )
+    {
+        auto bin_data = base_type::reorder( exec_space, boundary_width );
+        Cabana::permute( bin_data, _aosoa_output );
+        return bin_data;
+    }
 
     void resize( int new_local, int new_ghost )
     {
         base_type::resize( new_local, new_ghost );
+        _aosoa_output.resize( base_type::forceOffset() );
+    }
+
+    template <class DistributorType>
+    void migrate( const DistributorType& distributor )
+    {
         _aosoa_output.resize( base_type::localOffset() );
+        Cabana::migrate( distributor, _aosoa_output );
+        base_type::migrate( distributor );
     }
 
     template <typename... OtherFields>
@@ -937,6 +1836,12 @@ class Particles<MemorySpace, ModelType, ThermalType, EnergyOutput, Dimension>
                            std::forward<OtherFields>( other )... );
     }
 
+    void memory( MemoryRegistry& registry ) const
+    {
+        base_type::memory( registry );
+        registry.add( "Particles::Output", aosoaBytes( _aosoa_output ) );
+    }
+
     friend class Comm<self_type, PMB, TemperatureIndependent>;
     friend class Comm<self_type, LPS, TemperatureIndependent>;
     friend class Comm<self_type, PMB, TemperatureDependent>;
@@ -949,6 +1854,8 @@ class Particles<MemorySpace, ModelType, ThermalType, EnergyOutput, Dimension>
         Cabana::deep_copy( energy, 0.0 );
         auto phi = sliceDamage();
         Cabana::deep_copy( phi, 0.0 );
+        auto vol_H = sliceNeighborVolume();
+        Cabana::deep_copy( vol_H, 0.0 );
     }
 
     aosoa_output_type _aosoa_output;
@@ -984,7 +1891,7 @@ auto createParticles(
 {
     return std::make_shared<
         CabanaPD::Particles<MemorySpace, typename ModelType::base_model,
-                            typename ModelType::thermal_type, OutputType>>(
+                            typename ModelType::thermal_type, OutputType, Dim>>(
         exec_space, low_corner, high_corner, num_cells, max_halo_width );
 }
 
@@ -998,8 +1905,9 @@ auto createParticles(
                               is_output<OutputType>::value ),
                             int>::type* = 0 )
 {
-    return std::make_shared<CabanaPD::Particles<
-        MemorySpace, ModelType, typename ThermalType::base_type, OutputType>>(
+    return std::make_shared<
+        CabanaPD::Particles<MemorySpace, ModelType,
+                            typename ThermalType::base_type, OutputType, Dim>>(
         exec_space, low_corner, high_corner, num_cells, max_halo_width );
 }
 
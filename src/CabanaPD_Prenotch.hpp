@@ -12,11 +12,20 @@
 #ifndef PRENOTCH_H
 #define PRENOTCH_H
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include <Kokkos_Core.hpp>
 
 #include <Cabana_Core.hpp>
 
-#include <cassert>
+#include <CabanaPD_Timer.hpp>
 
 namespace CabanaPD
 {
@@ -212,16 +221,16 @@ struct Prenotch
         fixed_orientation = false;
     }
 
-    template <class ExecSpace, class NeighborView, class Particles,
-              class Neighbors>
-    void create( ExecSpace, NeighborView& mu, Particles& particles,
+    template <class ExecSpace, class BondType, class Particles, class Neighbors>
+    void create( ExecSpace, BondType& mu, Particles& particles,
                  Neighbors& neighbors )
     {
         _timer.start();
 
         auto x = particles.sliceReferencePosition();
-        // TODO: decide whether to disallow prenotches in frozen particles.
-        Kokkos::RangePolicy<ExecSpace> policy( 0, particles.localOffset() );
+        // Frozen particles own no bonds (and have no broken bond storage).
+        Kokkos::RangePolicy<ExecSpace> policy( particles.frozenOffset(),
+                                               particles.localOffset() );
 
         for ( std::size_t p = 0; p < _p0.size(); p++ )
         {
@@ -251,7 +260,7 @@ struct Prenotch
                     int keep_bond =
                         bondPrenotchIntersection( v1, v2, p0, xi, xj );
                     if ( !keep_bond )
-                        mu( i, n ) = 0;
+                        mu.breakBond( i, n );
                 }
             };
             Kokkos::parallel_for( "CabanaPD::Prenotch", policy, notch_functor );
@@ -277,6 +286,300 @@ struct Prenotch
     }
 };
 
+/******************************************************************************
+  Runtime-sized pre-notches.
+
+  The notches are stored on the device and binned into a uniform cell grid
+  covering their bounding boxes, expanded by the longest bond. Only particles
+  in a cell which overlaps a notch are candidates, and their bonds are only
+  tested against the notches of that cell.
+******************************************************************************/
+template <class MemorySpace>
+struct PrenotchList
+{
+    using memory_space = MemorySpace;
+    using vector_view_type = Kokkos::View<double* [3], memory_space>;
+    using index_view_type = Kokkos::View<int*, memory_space>;
+    using host_vector_type = std::vector<Kokkos::Array<double, 3>>;
+
+    // Maximum number of index cells along each dimension.
+    static constexpr int max_cells = 128;
+
+    host_vector_type _v1_host;
+    host_vector_type _v2_host;
+    host_vector_type _p0_host;
+    vector_view_type _v1;
+    vector_view_type _v2;
+    vector_view_type _p0;
+    bool fixed_orientation;
+
+    // Notches of each index cell (compressed by cell).
+    Kokkos::Array<double, 3> _low;
+    Kokkos::Array<double, 3> _cell_size;
+    Kokkos::Array<int, 3> _num_cells;
+    index_view_type _cell_offsets;
+    index_view_type _cell_notches;
+
+    Timer _timer;
+
+    // Either a single orientation for all pre-notches or one per pre-notch.
+    PrenotchList( const host_vector_type& v1, const host_vector_type& v2,
+                  const host_vector_type& p0 )
+        : _v1_host( v1 )
+        , _v2_host( v2 )
+        , _p0_host( p0 )
+    {
+        if ( v1.size() != v2.size() ||
+             ( v1.size() != 1 && v1.size() != p0.size() ) )
+            throw std::runtime_error( "Number of orientation vectors must be "
+                                      "one or match number of pre-notches." );
+        fixed_orientation = v1.size() == 1;
+
+        _v1 = copyToDevice( "prenotch_v1", v1 );
+        _v2 = copyToDevice( "prenotch_v2", v2 );
+        _p0 = copyToDevice( "prenotch_p0", p0 );
+    }
+
+    std::size_t numNotch() const { return _p0_host.size(); }
+
+    template <class ExecSpace, class BondType, class Particles, class Neighbors>
+    void create( ExecSpace, BondType& mu, Particles& particles,
+                 Neighbors& neighbors )
+    {
+        _timer.start();
+
+        auto x = particles.sliceReferencePosition();
+        // Frozen particles own no bonds (and have no broken bond storage).
+        const std::size_t num_local = particles.localOffset();
+        Kokkos::RangePolicy<ExecSpace> policy( particles.frozenOffset(),
+                                               num_local );
+
+        // Any bond crossing a notch has both particles within this distance.
+        double max_bond = 0.0;
+        Kokkos::parallel_reduce(
+            "CabanaPD::Prenotch::maxBond", policy,
+            KOKKOS_LAMBDA( const int i, double& longest ) {
+                std::size_t num_neighbors =
+                    Cabana::NeighborList<Neighbors>::numNeighbor( neighbors,
+                                                                  i );
+                for ( std::size_t n = 0; n < num_neighbors; n++ )
+                {
+                    std::size_t j =
+                        Cabana::NeighborList<Neighbors>::getNeighbor(
+                            neighbors, i, n );
+                    double r2 = 0.0;
+                    for ( std::size_t d = 0; d < 3; d++ )
+                        r2 += ( x( j, d ) - x( i, d ) ) *
+                              ( x( j, d ) - x( i, d ) );
+                    longest = Kokkos::fmax( longest, Kokkos::sqrt( r2 ) );
+                }
+            },
+            Kokkos::Max<double>( max_bond ) );
+        if ( numNotch() == 0 || max_bond <= 0.0 )
+        {
+            _timer.stop();
+            return;
+        }
+        buildIndex( max_bond * ( 1.0 + 1e-8 ) );
+
+        // Only keep particles in cells with at least one notch.
+        index_view_type candidates( "prenotch_candidates", num_local );
+        auto low = _low;
+        auto cell_size = _cell_size;
+        auto num_cells = _num_cells;
+        auto cell_offsets = _cell_offsets;
+        auto cell_of = KOKKOS_LAMBDA( const int i )
+        {
+            int cell = 0;
+            for ( std::size_t d = 0; d < 3; d++ )
+            {
+                int c = static_cast<int>(
+                    Kokkos::floor( ( x( i, d ) - low[d] ) / cell_size[d] ) );
+                if ( c < 0 || c >= num_cells[d] )
+                    return -1;
+                cell = cell * num_cells[d] + c;
+            }
+            return cell;
+        };
+        int num_candidates = 0;
+        Kokkos::parallel_scan(
+            "CabanaPD::Prenotch::candidates", policy,
+            KOKKOS_LAMBDA( const int i, int& offset, const bool final ) {
+                int cell = cell_of( i );
+                if ( cell >= 0 &&
+                     cell_offsets( cell + 1 ) > cell_offsets( cell ) )
+                {
+                    if ( final )
+                        candidates( offset ) = i;
+                    offset++;
+                }
+            },
+            num_candidates );
+
+        auto cell_notches = _cell_notches;
+        auto v1 = _v1;
+        auto v2 = _v2;
+        auto p0 = _p0;
+        auto fixed = fixed_orientation;
+        auto notch_functor = KOKKOS_LAMBDA( const int c )
+        {
+            const int i = candidates( c );
+            const int cell = cell_of( i );
+            std::size_t num_neighbors =
+                Cabana::NeighborList<Neighbors>::numNeighbor( neighbors, i );
+            Kokkos::Array<double, 3> xi;
+            Kokkos::Array<double, 3> xj;
+            for ( std::size_t d = 0; d < 3; d++ )
+                xi[d] = x( i, d );
+            for ( std::size_t n = 0; n < num_neighbors; n++ )
+            {
+                std::size_t j = Cabana::NeighborList<Neighbors>::getNeighbor(
+                    neighbors, i, n );
+                for ( std::size_t d = 0; d < 3; d++ )
+                    xj[d] = x( j, d );
+                for ( int k = cell_offsets( cell );
+                      k < cell_offsets( cell + 1 ); k++ )
+                {
+                    const int notch = cell_notches( k );
+                    const int o = fixed ? 0 : notch;
+                    Kokkos::Array<double, 3> v1_k;
+                    Kokkos::Array<double, 3> v2_k;
+                    Kokkos::Array<double, 3> p0_k;
+                    for ( std::size_t d = 0; d < 3; d++ )
+                    {
+                        v1_k[d] = v1( o, d );
+                        v2_k[d] = v2( o, d );
+                        p0_k[d] = p0( notch, d );
+                    }
+                    if ( !bondPrenotchIntersection( v1_k, v2_k, p0_k, xi,
+                                                    xj ) )
+                    {
+                        mu.breakBond( i, n );
+                        break;
+                    }
+                }
+            }
+        };
+        Kokkos::RangePolicy<ExecSpace> candidate_policy( 0, num_candidates );
+        Kokkos::parallel_for( "CabanaPD::Prenotch", candidate_policy,
+                              notch_functor );
+        _timer.stop();
+    }
+    auto time() { return _timer.time(); };
+
+  protected:
+    static vector_view_type copyToDevice( const std::string& label,
+                                          const host_vector_type& vectors )
+    {
+        vector_view_type view( label, vectors.size() );
+        auto view_host = Kokkos::create_mirror_view( view );
+        for ( std::size_t p = 0; p < vectors.size(); p++ )
+            for ( std::size_t d = 0; d < 3; d++ )
+                view_host( p, d ) = vectors[p][d];
+        Kokkos::deep_copy( view, view_host );
+        return view;
+    }
+
+    // Bin the expanded notch bounding boxes on the host (the number of
+    // notches is small compared to the number of bonds).
+    void buildIndex( const double expand )
+    {
+        const std::size_t num_notch = numNotch();
+        std::vector<Kokkos::Array<double, 3>> box_low( num_notch );
+        std::vector<Kokkos::Array<double, 3>> box_high( num_notch );
+        Kokkos::Array<double, 3> high;
+        for ( std::size_t d = 0; d < 3; d++ )
+        {
+            _low[d] = std::numeric_limits<double>::max();
+            high[d] = std::numeric_limits<double>::lowest();
+        }
+        for ( std::size_t p = 0; p < num_notch; p++ )
+        {
+            const std::size_t o = fixed_orientation ? 0 : p;
+            for ( std::size_t d = 0; d < 3; d++ )
+            {
+                // Corners of the notch parallelogram.
+                const double c0 = _p0_host[p][d];
+                const double c1 = c0 + _v1_host[o][d];
+                const double c2 = c0 + _v2_host[o][d];
+                const double c3 = c1 + _v2_host[o][d];
+                box_low[p][d] = std::min( { c0, c1, c2, c3 } ) - expand;
+                box_high[p][d] = std::max( { c0, c1, c2, c3 } ) + expand;
+                _low[d] = std::min( _low[d], box_low[p][d] );
+                high[d] = std::max( high[d], box_high[p][d] );
+            }
+        }
+        for ( std::size_t d = 0; d < 3; d++ )
+        {
+            const double extent = high[d] - _low[d];
+            _num_cells[d] = std::clamp(
+                static_cast<int>( std::ceil( extent / expand ) ), 1,
+                max_cells );
+            _cell_size[d] = extent / _num_cells[d];
+        }
+
+        // Range of cells overlapped by each notch.
+        auto cell_range = [&]( const std::size_t p, const std::size_t d )
+        {
+            auto cell = [&]( const double y )
+            {
+                return std::clamp(
+                    static_cast<int>(
+                        std::floor( ( y - _low[d] ) / _cell_size[d] ) ),
+                    0, _num_cells[d] - 1 );
+            };
+            return std::make_pair( cell( box_low[p][d] ),
+                                   cell( box_high[p][d] ) );
+        };
+        const int total_cells = _num_cells[0] * _num_cells[1] * _num_cells[2];
+        std::vector<int> offsets( total_cells + 1, 0 );
+        for ( int pass = 0; pass < 2; pass++ )
+        {
+            std::vector<int> fill( offsets.begin(), offsets.end() - 1 );
+            std::vector<int> notches( pass == 0 ? 0 : offsets.back() );
+            for ( std::size_t p = 0; p < num_notch; p++ )
+            {
+                auto [i0, i1] = cell_range( p, 0 );
+                auto [j0, j1] = cell_range( p, 1 );
+                auto [k0, k1] = cell_range( p, 2 );
+                for ( int i = i0; i <= i1; i++ )
+                    for ( int j = j0; j <= j1; j++ )
+                        for ( int k = k0; k <= k1; k++ )
+                        {
+                            const int cell =
+                                ( i * _num_cells[1] + j ) * _num_cells[2] + k;
+                            if ( pass == 0 )
+                                offsets[cell + 1]++;
+                            else
+                                notches[fill[cell]++] = p;
+                        }
+            }
+            if ( pass == 0 )
+            {
+                for ( int c = 0; c < total_cells; c++ )
+                    offsets[c + 1] += offsets[c];
+            }
+            else
+            {
+                _cell_notches =
+                    index_view_type( "prenotch_cell_notches", notches.size() );
+                Kokkos::deep_copy(
+                    _cell_notches,
+                    Kokkos::View<int*, Kokkos::HostSpace,
+                                 Kokkos::MemoryTraits<Kokkos::Unmanaged>>(
+                        notches.data(), notches.size() ) );
+            }
+        }
+        _cell_offsets =
+            index_view_type( "prenotch_cell_offsets", offsets.size() );
+        Kokkos::deep_copy(
+            _cell_offsets,
+            Kokkos::View<int*, Kokkos::HostSpace,
+                         Kokkos::MemoryTraits<Kokkos::Unmanaged>>(
+                offsets.data(), offsets.size() ) );
+    }
+};
+
 } // namespace CabanaPD
 
 #endif
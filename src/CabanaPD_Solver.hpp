@@ -57,9 +57,14 @@
 //
 //************************************************************************
 
+// Velocity Verlet solver. This header is not included by CabanaPD.hpp and is
+// not compiled: it shares the SOLVER_H include guard and createSolver with
+// CabanaPD_Solver_Yoshida.hpp, which is the solver in use.
+
 #ifndef SOLVER_H
 #define SOLVER_H
 
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <fstream>
@@ -72,20 +77,27 @@
 #include <Kokkos_Core.hpp>
 
 #include <CabanaPD_Boundary.hpp>
+#include <CabanaPD_Checkpoint.hpp>
 #include <CabanaPD_Comm.hpp>
+#include <CabanaPD_Diagnostics.hpp>
 #include <CabanaPD_Force.hpp>
 #include <CabanaPD_HeatTransfer.hpp>
 #include <CabanaPD_Input.hpp>
 #include <CabanaPD_Integrate.hpp>
+#include <CabanaPD_Memory.hpp>
 #include <CabanaPD_Output.hpp>
 #include <CabanaPD_Particles.hpp>
 #include <CabanaPD_Prenotch.hpp>
+#include <CabanaPD_TimeStep.hpp>
 #include <CabanaPD_Timer.hpp>
 
 namespace CabanaPD
 {
+// The neighbor iteration tag selects one thread per particle (SerialOpTag) or
+// team threading over each particle's neighbors (TeamOpTag).
 template <class MemorySpace, class InputType, class ParticleType,
-          class ForceModelType, class ContactModelType = NoContact>
+          class ForceModelType, class ContactModelType = NoContact,
+          class NeighIterTag = Cabana::SerialOpTag>
 class Solver
 {
   public:
@@ -99,13 +111,16 @@ class Solver
     using force_type = Force<memory_space, force_model_type>;
     using comm_type = Comm<particle_type, typename force_model_type::base_model,
                            typename particle_type::thermal_type>;
-    using neigh_iter_tag = Cabana::SerialOpTag;
+    using neigh_iter_tag = NeighIterTag;
     using input_type = InputType;
 
     // Optional module types.
     using heat_transfer_type = HeatTransfer<memory_space, force_model_type>;
     using contact_type = Force<memory_space, ContactModelType>;
     using contact_model_type = ContactModelType;
+    using subcycle_type = ContactSubcycle<exec_space>;
+    using monitors_type = GlobalMonitors<memory_space>;
+    using diagnostics_type = GlobalDiagnostics<memory_space>;
 
     Solver( input_type _inputs, std::shared_ptr<particle_type> _particles,
             force_model_type force_model )
@@ -122,45 +137,297 @@ class Solver
         , particles( _particles )
         , _init_time( 0.0 )
     {
-        setup( force_model );
+        // Contact neighbors are only rebuilt after moving half the skin.
+        const double contact_skin = inputs["contact_skin"];
+        setup( force_model, contact_model.Rc + contact_skin );
 
+        static_assert( particle_type::dim == 3, "Contact requires 3d." );
         _neighbor_timer.start();
-        contact = std::make_shared<contact_type>( inputs["half_neigh"],
-                                                  *particles, contact_model );
+        contact = std::make_shared<contact_type>(
+            inputs["half_neigh"], *particles, contact_model, contact_skin );
+        // Optionally only compute contact between particles which are not
+        // bonded (or whose bonds are broken).
+        _contact_exclude_bonds = inputs["contact_exclude_bonds"];
+        if ( _contact_exclude_bonds )
+            excludeContactBonds();
         _neighbor_timer.stop();
+
+        // Contact is optionally subcycled at a smaller timestep than the
+        // bonds (particle order must then be fixed). Untested, since this
+        // header is not compiled.
+        const int contact_substeps = inputs["contact_substeps"];
+        if ( contact_substeps > 1 )
+        {
+            if ( _fused_integration )
+                throw std::runtime_error( "Contact subcycling is not "
+                                          "supported with fused "
+                                          "integration." );
+            if ( _migration_distance > 0.0 )
+                throw std::runtime_error( "Contact subcycling is not "
+                                          "supported with particle "
+                                          "migration." );
+            subcycle = std::make_shared<subcycle_type>( contact_substeps );
+        }
     }
 
-    void setup( force_model_type force_model )
+    void setup( force_model_type force_model,
+                const double contact_cutoff = 0.0 )
     {
+        static_assert( particle_type::dim == 3 ||
+                           !is_heat_transfer<
+                               typename force_model_type::thermal_type>::value,
+                       "Heat transfer requires 3d." );
+        // Model parameters are derived for the particle dimension.
+        if ( force_model.dim != particle_type::dim )
+            throw std::runtime_error( "Force model dimension does not match "
+                                      "the particle dimension." );
         inputs.computeCriticalTimeStep( force_model );
 
         num_steps = inputs["num_steps"];
         output_frequency = inputs["output_frequency"];
         output_reference = inputs["output_reference"];
+        _profile_output = inputs["profile_output"];
+
+        // Optionally reduce the particle output to selected fields and a
+        // decimated region, and write it in the background.
+        std::vector<std::string> output_fields = inputs["output_fields"];
+        int output_stride = inputs["output_stride"];
+        std::array<double, particle_type::dim> output_low =
+            inputs["output_region_low"];
+        std::array<double, particle_type::dim> output_high =
+            inputs["output_region_high"];
+        bool output_single = inputs["output_single_precision"];
+        bool output_async = inputs["output_async"];
+        bool output_frozen = inputs["output_frozen"];
+        particles->setOutputOptions( output_fields, output_stride, output_low,
+                                     output_high, output_single, output_async,
+                                     output_frozen );
+
+        // Optionally monitor global values during the run.
+        _monitor_frequency = inputs["monitor_frequency"];
+        std::string monitor_file = inputs["monitor_file"];
+        int crack_axis = inputs["monitor_crack_axis"];
+        double crack_damage = inputs["monitor_crack_damage"];
+        monitors = std::make_shared<monitors_type>( monitor_file, crack_axis,
+                                                    crack_damage );
+        // Globally reduced energy and damage (always used for the log).
+        bool diagnostics_output = inputs["diagnostics_output"];
+        std::string diagnostics_file = inputs["diagnostics_file"];
+        double diagnostics_damage = inputs["diagnostics_damage"];
+        diagnostics = std::make_shared<diagnostics_type>(
+            diagnostics_file, diagnostics_damage, diagnostics_output );
+
+        // Optionally checkpoint the full state and restart from a checkpoint.
+        _checkpoint_frequency = inputs["checkpoint_frequency"];
+        std::string checkpoint_file = inputs["checkpoint_file"];
+        int ranks_per_file = inputs["checkpoint_ranks_per_file"];
+        checkpoint =
+            std::make_shared<Checkpoint>( checkpoint_file, ranks_per_file );
+        std::string restart_file = inputs["restart_file"];
+        _restart_file = restart_file;
 
         // Create integrator.
         dt = inputs["timestep"];
         integrator = std::make_shared<integrator_type>( dt );
 
-        // Add ghosts from other MPI ranks.
-        comm = std::make_shared<comm_type>( *particles );
+        // Optionally adapt the timestep to a runtime stability estimate,
+        // stepping to the final time instead of a fixed number of steps.
+        _adaptive_timestep = inputs["adaptive_timestep"];
+        if ( _adaptive_timestep )
+        {
+            if constexpr ( is_heat_transfer<
+                               typename force_model_type::thermal_type>::value )
+                throw std::runtime_error( "Adaptive timesteps are not "
+                                          "supported with heat transfer." );
+            if constexpr ( is_variable_horizon<force_model_type>::value )
+                throw std::runtime_error( "Adaptive timesteps are not "
+                                          "supported with variable "
+                                          "horizons." );
+            bool half_neigh = inputs["half_neigh"];
+            if ( half_neigh )
+                throw std::runtime_error( "Adaptive timesteps are not "
+                                          "supported with half neighbor "
+                                          "lists." );
+            _adaptive_frequency = inputs["adaptive_timestep_frequency"];
+            _dt_min = inputs["timestep_min"];
+            _dt_max = inputs["timestep_max"];
+            if ( _dt_min > _dt_max || _adaptive_frequency < 1 )
+                throw std::runtime_error( "Invalid adaptive timestep inputs." );
+            _dt_growth = inputs["adaptive_timestep_growth"];
+            double max_distance = inputs["adaptive_timestep_distance"];
+            double dx = inputs["dx"][0];
+            _max_distance = max_distance * dx;
+            _micromodulus = inputs.micromodulus();
+            _safety_factor = inputs["timestep_safety_factor"];
+            _final_time = inputs["final_time"];
+            _output_interval = inputs["output_time_interval"];
+        }
 
+        // Overlapping ghost communication requires full neighbor lists and
+        // no ghost temperature updates within a step.
+        _overlap_comm = inputs["overlap_communication"];
+        if ( _overlap_comm )
+        {
+            bool half_neigh = inputs["half_neigh"];
+            if ( half_neigh )
+                throw std::runtime_error( "Overlapping communication is not "
+                                          "supported with half neighbor "
+                                          "lists." );
+            if constexpr ( is_temperature_dependent<
+                               typename force_model_type::thermal_type>::value )
+                throw std::runtime_error( "Overlapping communication is not "
+                                          "supported with temperature "
+                                          "dependence." );
+        }
+
+        // Optionally fuse per-particle work into the integrator drift.
+        _fused_integration = inputs["fused_integration"];
+
+        // Migrating particles between ranks requires full neighbor lists that
+        // can be rebuilt independently and no per-particle model state.
+        _migration_distance = inputs["migration_distance"];
+        if ( _migration_distance > 0.0 )
+        {
+            bool half_neigh = inputs["half_neigh"];
+            if ( half_neigh )
+                throw std::runtime_error( "Particle migration is not "
+                                          "supported with half neighbor "
+                                          "lists." );
+            if constexpr ( is_temperature_dependent<
+                               typename force_model_type::thermal_type>::value )
+                throw std::runtime_error( "Particle migration is not "
+                                          "supported with temperature "
+                                          "dependence." );
+            if constexpr ( is_ensemble<force_model_type>::value )
+                throw std::runtime_error( "Particle migration is not "
+                                          "supported with ensembles." );
+            if ( particles->variableResolution() )
+                throw std::runtime_error( "Particle migration is not "
+                                          "supported with variable "
+                                          "resolution." );
+            if ( particles->numFrozen() > 0 )
+                throw std::runtime_error( "Particle migration is not "
+                                          "supported with frozen particles." );
+            // Restart relies on the particle order at creation.
+            if ( !_restart_file.empty() )
+                throw std::runtime_error( "Restart is not supported with "
+                                          "particle migration." );
+        }
+
+        // Rebalancing the domain by bonds per rank moves particles with the
+        // migration machinery.
+        _rebalance_frequency = inputs["rebalance_frequency"];
+        if ( _rebalance_frequency > 0 && _migration_distance <= 0.0 )
+            throw std::runtime_error( "Domain rebalancing requires particle "
+                                      "migration (migration_distance)." );
+
+        // Only particles with bonds that can cross a rank boundary are
+        // ghosted.
+        _ghost_cutoff = force_model.delta * ( 1.0 + 1e-8 );
+        const double ghost_cutoff = _ghost_cutoff;
+
+        // Optionally sort particles for memory locality before any ghosts or
+        // neighbor lists are created. Overlapping communication also places
+        // particles which may have ghost neighbors last.
+        bool reorder_particles = inputs["reorder_particles"];
+        if ( _overlap_comm )
+            particles->reorder( exec_space(), ghost_cutoff );
+        else if ( reorder_particles )
+            particles->reorder( exec_space() );
+
+        // Add ghosts from other MPI ranks.
+        HaloOptions halo_options;
+        halo_options.gpu_aware_mpi = inputs["halo_gpu_aware_mpi"];
+        halo_options.persistent_requests = inputs["halo_persistent_requests"];
+        halo_options.node_shared = inputs["halo_node_shared"];
+        comm = std::make_shared<comm_type>( *particles, ghost_cutoff,
+                                            halo_options );
+
+        // Contact across ranks needs ghosts by current position, which are
+        // only maintained with particle migration.
         if constexpr ( is_contact<contact_model_type>::value )
         {
-            if ( comm->size() > 1 )
+            if ( comm->size() > 1 && _migration_distance <= 0.0 )
+                throw std::runtime_error( "Contact with MPI requires particle "
+                                          "migration (migration_distance)." );
+        }
+        if ( _migration_distance > 0.0 )
+        {
+            if ( contact_cutoff > 0.0 )
+            {
+                _contact_ghost_cutoff = contact_cutoff + _migration_distance;
+                comm->rebuildHalo( *particles, _ghost_cutoff,
+                                   _contact_ghost_cutoff );
+            }
+            comm->resetMigrationReference( *particles );
+        }
+
+        // Half neighbor lists are only supported for PD mechanics.
+        bool half_neigh = inputs["half_neigh"];
+        if ( half_neigh )
+        {
+            if constexpr ( is_contact<contact_model_type>::value )
+                throw std::runtime_error(
+                    "Half neighbor lists are not supported with contact." );
+            if constexpr ( is_heat_transfer<
+                               typename force_model_type::thermal_type>::value )
+                throw std::runtime_error( "Half neighbor lists are not "
+                                          "supported with heat transfer." );
+        }
+
+        // Broken bonds are optionally removed from the neighbor list, which
+        // then no longer matches neighbors rebuilt from positions.
+        _compaction_threshold = inputs["bond_compaction_threshold"];
+        if ( _compaction_threshold > 0.0 )
+        {
+            using fracture_type = typename force_model_type::fracture_type;
+            using thermal_type = typename force_model_type::thermal_type;
+            if constexpr ( !is_fracture<fracture_type>::value )
                 throw std::runtime_error(
-                    "Contact with MPI is currently disabled." );
+                    "Broken bond compaction requires fracture." );
+            if constexpr ( is_heat_transfer<thermal_type>::value )
+                throw std::runtime_error( "Broken bond compaction is not "
+                                          "supported with heat transfer." );
+            if ( _migration_distance > 0.0 )
+                throw std::runtime_error( "Broken bond compaction is not "
+                                          "supported with particle "
+                                          "migration." );
+            if ( _checkpoint_frequency > 0 || !_restart_file.empty() )
+                throw std::runtime_error( "Broken bond compaction is not "
+                                          "supported with checkpoints." );
+        }
+
+        // Bonds are optionally only checked for breaking near damage fronts.
+        _active_bond_frequency = inputs["active_bond_frequency"];
+        _active_bond_threshold = inputs["active_bond_threshold"];
+        if ( _active_bond_frequency > 0 )
+        {
+            if constexpr ( !force_type::has_active_bond_breaking )
+                throw std::runtime_error(
+                    "Active bond breaking requires PMB fracture." );
+            bool half_neigh = inputs["half_neigh"];
+            if ( half_neigh )
+                throw std::runtime_error( "Active bond breaking is not "
+                                          "supported with half neighbor "
+                                          "lists." );
         }
 
         // Update temperature ghost size if needed.
         if constexpr ( is_temperature_dependent<
                            typename force_model_type::thermal_type>::value )
             force_model.update( particles->sliceTemperature() );
+        // Update volume ghost size for variable horizons.
+        if constexpr ( is_variable_horizon<force_model_type>::value )
+            force_model.update( particles->sliceVolume() );
 
         _neighbor_timer.start();
         // This will either be PD or DEM forces.
         force = std::make_shared<force_type>( inputs["half_neigh"], *particles,
                                               force_model );
+        // Bond order must not depend on particle storage order to migrate
+        // broken bonds.
+        if ( _migration_distance > 0.0 )
+            rebuildNeighbors();
         _neighbor_timer.stop();
 
         _init_timer.start();
@@ -174,8 +441,21 @@ class Solver
                            typename force_model_type::thermal_type>::value )
         {
             thermal_subcycle_steps = inputs["thermal_subcycle_steps"];
+            std::string thermal_integrator = inputs["thermal_integrator"];
+            if ( thermal_integrator == "rkl2" )
+                thermal_stages = inputs["thermal_stages"];
             heat_transfer = std::make_shared<heat_transfer_type>(
                 inputs["half_neigh"], *force, force_model );
+            // Only forward Euler conduction can be computed with the forces.
+            bool fused_conduction = inputs["fused_conduction"];
+            _fused_conduction = fused_conduction &&
+                                force_type::has_fused_conduction &&
+                                !force->halfNeighbor();
+            _concurrent_heat_transfer = inputs["concurrent_heat_transfer"];
+            if ( _concurrent_heat_transfer )
+                heat_transfer->setExecutionSpace(
+                    Kokkos::Experimental::partition_space( exec_space(),
+                                                           1 )[0] );
         }
 
         print = print_rank();
@@ -185,8 +465,10 @@ class Solver
                  ", Maximum neighbors: ", max_neighbors );
             log( std::cout, "#Timestep/Total-steps Simulation-time" );
 
+            // The output file stays open (and buffered) for the run.
             output_file = inputs["output_file"];
-            std::ofstream out( output_file, std::ofstream::app );
+            _out.open( output_file, std::ofstream::app );
+            auto& out = _out;
             error_file = inputs["error_file"];
             std::ofstream err( error_file, std::ofstream::app );
 
@@ -200,13 +482,18 @@ class Solver
                  particles->numGlobal() );
             log( out, "Maximum neighbors: ", max_neighbors,
                  ", Total neighbors: ", total_neighbors, "\n" );
-            out.close();
         }
         _init_timer.stop();
     }
 
     void init( const bool initial_output = true )
     {
+        // Fields may have been set directly since the ghosts were created.
+        particles->markModified();
+
+        if ( !_restart_file.empty() )
+            restart();
+
         // Compute and communicate weighted volume for LPS (does nothing for
         // PMB). Only computed once without fracture (and inside updateForce for
         // fracture).
@@ -215,13 +502,19 @@ class Solver
         {
             force->computeWeightedVolume( *particles, neigh_iter_tag{} );
             comm->gatherWeightedVolume();
+
+            // Optionally assemble the stiffness of linearized models once
+            // (after the weighted volume for LPS).
+            if constexpr ( force_type::has_stiffness_operator )
+                if ( inputs["assembled_stiffness"] )
+                    force->assembleStiffness( *particles );
         }
         // Compute initial internal forces and energy.
-        updateForce();
-        computeEnergy( *force, *particles, neigh_iter_tag() );
+        updateForce( true );
 
         if ( initial_output )
-            particles->output( 0, 0.0, output_reference );
+            particles->output( outputIndex( _restart_step ), _time,
+                               output_reference );
     }
 
     template <typename BoundaryType>
@@ -229,8 +522,8 @@ class Solver
                const bool initial_output = true )
     {
         // Add non-force boundary condition.
-        if ( !boundary_condition.forceUpdate() )
-            boundary_condition.apply( exec_space(), *particles, 0.0 );
+        applyBoundaryCondition( boundary_condition, exec_space(), *particles,
+                                _time, false );
 
         // Communicate temperature.
         if constexpr ( is_temperature_dependent<
@@ -241,11 +534,12 @@ class Solver
         init( false );
 
         // Add force boundary condition.
-        if ( boundary_condition.forceUpdate() )
-            boundary_condition.apply( exec_space(), *particles, 0.0 );
+        applyBoundaryCondition( boundary_condition, exec_space(), *particles,
+                                _time, true );
 
         if ( initial_output )
-            particles->output( 0, 0.0, output_reference );
+            particles->output( outputIndex( _restart_step ), _time,
+                               output_reference );
     }
 
     // Initialize with prenotch, but no BC.
@@ -266,57 +560,117 @@ class Solver
         init( boundary_condition, initial_output );
     }
 
+    // Initialize with a runtime-sized prenotch list, but no BC.
+    void init( PrenotchList<memory_space> prenotch,
+               const bool initial_output = true )
+    {
+        init_prenotch( prenotch );
+        init( initial_output );
+    }
+
+    // Initialize with a runtime-sized prenotch list and BC.
+    template <typename BoundaryType>
+    void init( BoundaryType boundary_condition,
+               PrenotchList<memory_space> prenotch,
+               const bool initial_output = true )
+    {
+        init_prenotch( prenotch );
+        init( boundary_condition, initial_output );
+    }
+
     template <typename BoundaryType>
     void run( BoundaryType boundary_condition )
     {
-        init_output( boundary_condition.timeInit() );
+        if ( _migration_distance > 0.0 )
+            throw std::runtime_error(
+                "Particle migration is not supported with boundary "
+                "conditions (which store particle indices)." );
 
+        MemoryRegistry memory;
+        boundary_condition.memory( memory );
+        init_output( boundary_condition.timeInit(), memory );
 
         // Main timestep loop.
-        for ( int step = 1; step <= num_steps; step++ )
+        for ( int step = _restart_step + 1; continueStepping( step ); step++ )
         {
             _step_timer.start();
+            beginStep( step );
+
+            // Heat transfer is optionally advanced concurrently with the
+            // first half step and ghost update (which it does not depend on).
+            bool thermal_step = false;
+            if constexpr ( is_heat_transfer<
+                               typename force_model_type::thermal_type>::value )
+            {
+                thermal_step = step % thermal_subcycle_steps == 0;
+                if ( thermal_step && _concurrent_heat_transfer )
+                    startTemperature();
+            }
 
             // Integrate - velocity Verlet first half.
-            integrator->initialHalfStep( *particles );
+            initialHalfStep( boundary_condition, _time );
 
-            // Update ghost particles.
-            comm->gatherDisplacement();
+            // Update ghost particles (only posted if overlapping with the
+            // force computation).
+            const bool output_step = outputStep( step );
+            const bool overlap = _overlap_comm && !output_step;
+            if ( overlap )
+                comm->startGatherDisplacement();
+            else
+                comm->gatherDisplacement();
 
             if constexpr ( is_heat_transfer<
                                typename force_model_type::thermal_type>::value )
             {
-                if ( step % thermal_subcycle_steps == 0 )
-                    computeHeatTransfer( *heat_transfer, *particles,
-                                         neigh_iter_tag{},
-                                         thermal_subcycle_steps * dt );
+                if ( thermal_step && _concurrent_heat_transfer )
+                    finishTemperature();
+                else if ( thermal_step )
+                    updateTemperature();
             }
 
-            // Add non-force boundary condition.
-            if ( !boundary_condition.forceUpdate() )
-                boundary_condition.apply( exec_space(), *particles, step * dt );
+            // Add non-force boundary condition (unless fused with the
+            // integrator).
+            if ( !fuseBoundaryCondition<BoundaryType>() )
+                applyBoundaryCondition( boundary_condition, exec_space(),
+                                        *particles, _time, false );
 
             if constexpr ( is_temperature_dependent<
                                typename force_model_type::thermal_type>::value )
                 comm->gatherTemperature();
 
-            // Compute internal forces.
-            updateForce();
+            // Compute internal forces (with the conduction for the next step
+            // if requested, from the same temperatures).
+            if ( overlap )
+                updateForceOverlap();
+            else
+                updateForce( output_step, fuseConduction( step ) );
 
+            // Subcycled contact is only added within the drift.
             if constexpr ( is_contact<contact_model_type>::value )
-                computeForce( *contact, *particles, neigh_iter_tag{}, false );
+            {
+                if ( !subcycle )
+                {
+                    particles->updateGhostCurrentPositions();
+                    computeForce( *contact, *particles, neigh_iter_tag{},
+                                  false );
+                }
+            }
 
             // Add force boundary condition.
-            if ( boundary_condition.forceUpdate() )
-                boundary_condition.apply( exec_space(), *particles, step * dt );
+            applyBoundaryCondition( boundary_condition, exec_space(),
+                                    *particles, _time, true );
 
             // Integrate - velocity Verlet second half.
             integrator->finalHalfStep( *particles );
 
+            monitorStep( step );
             output( step );
+            checkpointStep( step );
+            compactBonds( step );
         }
 
         // Final output and timings.
+        boundary_condition.profile( _profile );
         final_output();
     }
 
@@ -325,21 +679,45 @@ class Solver
         init_output();
 
         // Main timestep loop.
-        for ( int step = 1; step <= num_steps; step++ )
+        for ( int step = _restart_step + 1; continueStepping( step ); step++ )
         {
             _step_timer.start();
+            beginStep( step );
 
             // Integrate - velocity Verlet first half.
-            integrator->initialHalfStep( *particles );
-
-            // Update ghost particles.
-            comm->gatherDisplacement();
-
-            // Compute internal forces.
-            updateForce();
+            NoBoundaryCondition no_bc;
+            initialHalfStep( no_bc, _time );
+
+            if ( _rebalance_frequency > 0 &&
+                 step % _rebalance_frequency == 0 )
+                rebalance();
+            else if ( _migration_distance > 0.0 )
+                migrate();
+
+            // Compute internal forces, updating ghost particles first (or
+            // in parallel with interior particles).
+            const bool output_step = outputStep( step );
+            if ( _overlap_comm && !output_step )
+            {
+                comm->startGatherDisplacement();
+                updateForceOverlap();
+            }
+            else
+            {
+                comm->gatherDisplacement();
+                updateForce( output_step );
+            }
 
+            // Subcycled contact is only added within the drift.
             if constexpr ( is_contact<contact_model_type>::value )
-                computeForce( *contact, *particles, neigh_iter_tag{}, false );
+            {
+                if ( !subcycle )
+                {
+                    particles->updateGhostCurrentPositions();
+                    computeForce( *contact, *particles, neigh_iter_tag{},
+                                  false );
+                }
+            }
 
             if constexpr ( is_temperature_dependent<
                                typename force_model_type::thermal_type>::value )
@@ -348,7 +726,10 @@ class Solver
             // Integrate - velocity Verlet second half.
             integrator->finalHalfStep( *particles );
 
+            monitorStep( step );
             output( step );
+            checkpointStep( step );
+            compactBonds( step );
         }
 
         // Final output and timings.
@@ -356,64 +737,323 @@ class Solver
     }
 
     // Compute and communicate fields needed for force computation and update
-    // forces.
-    void updateForce()
+    // forces. Energy and damage are computed in the same pass if requested
+    // (only needed on output steps); otherwise conduction may be.
+    void updateForce( const bool compute_energy = false,
+                      const bool compute_conduction = false )
     {
-        // Compute and communicate weighted volume for LPS (does nothing for
-        // PMB). Only computed once without fracture.
+        // Compute weighted volume for LPS (does nothing for PMB). Only
+        // computed once without fracture.
+        if constexpr ( is_fracture<
+                           typename force_model_type::fracture_type>::value )
+            force->computeWeightedVolume( *particles, neigh_iter_tag{} );
+        // Compute dilatation for LPS (does nothing for PMB), which only needs
+        // the owned weighted volume.
+        force->computeDilatation( *particles, neigh_iter_tag{} );
+        // Communicate both in one message (only those which changed).
+        comm->gatherFields( WeightedVolumeField{}, DilatationField{} );
+
+        // Compute internal forces.
+        if ( compute_energy )
+            _energy =
+                computeForceAndEnergy( *force, *particles, neigh_iter_tag{} );
+        else if ( compute_conduction )
+            updateForceAndConduction();
+        else
+            computeBreakingForce();
+        _forces_zeroed = false;
+
+        // Return ghost contributions to their owning ranks for half neighbor
+        // lists.
+        if ( force->halfNeighbor() )
+        {
+            comm->scatterForce();
+            if ( compute_energy )
+            {
+                comm->scatterEnergy( *particles );
+                computeDamage( *force, *particles );
+            }
+        }
+    }
+
+    // Forces with bond breaking, optionally only checking the bonds of the
+    // active set (updated every active_bond_frequency evaluations).
+    void computeBreakingForce()
+    {
+        if constexpr ( force_type::has_active_bond_breaking )
+        {
+            if ( _active_bond_frequency > 0 )
+            {
+                if ( _num_active_updates++ % _active_bond_frequency == 0 )
+                    force->updateActiveBonds( *particles,
+                                              _active_bond_threshold );
+                computeForceActiveBreaking( *force, *particles,
+                                            neigh_iter_tag{}, !_forces_zeroed );
+                return;
+            }
+        }
+        computeForce( *force, *particles, neigh_iter_tag{}, !_forces_zeroed );
+    }
+
+    // Whether the non-force boundary conditions are applied within the
+    // integrator drift. Only boundary condition sets have per-particle
+    // operations, and heat transfer must be updated before they apply.
+    template <class BoundaryType>
+    bool fuseBoundaryCondition() const
+    {
+        if constexpr ( is_boundary_condition_set<BoundaryType>::value &&
+                       !is_heat_transfer<
+                           typename force_model_type::thermal_type>::value )
+            return _fused_integration;
+        else
+            return false;
+    }
+
+    // Velocity Verlet first half, optionally fused with the force reset
+    // (full neighbor lists only, since ghost forces are otherwise summed),
+    // the non-force boundary conditions, and the owned current positions
+    // used for contact. With contact subcycling, the half kick only uses the
+    // PD forces and the drift is subcycled.
+    template <class BoundaryType>
+    void initialHalfStep( BoundaryType& boundary_condition, const double time )
+    {
+        if ( subcycle )
+        {
+            integrator->finalHalfStep( *particles );
+            subcycleContact( integrator->timeStep() );
+            return;
+        }
+        if ( !_fused_integration )
+        {
+            integrator->initialHalfStep( *particles );
+            return;
+        }
+
+        const bool reset_force = !force->halfNeighbor();
+        constexpr bool update_position = is_contact<contact_model_type>::value;
+        if constexpr ( is_boundary_condition_set<BoundaryType>::value &&
+                       !is_heat_transfer<
+                           typename force_model_type::thermal_type>::value )
+        {
+            integrator->initialHalfStep(
+                *particles,
+                createFusedDriftOp(
+                    *particles, reset_force,
+                    boundary_condition.getFusedOp( *particles, time ),
+                    update_position ) );
+            if constexpr ( BoundaryType::writes_fields )
+                particles->markModified();
+        }
+        else
+        {
+            integrator->initialHalfStep(
+                *particles,
+                createFusedDriftOp( *particles, reset_force, NoFusedOp{},
+                                    update_position ) );
+        }
+        _forces_zeroed = reset_force;
+        if constexpr ( update_position )
+            particles->markLocalCurrentPositions();
+    }
+
+    // Update forces while ghost communication is in flight: particles without
+    // ghost neighbors are computed first, then the remaining boundary
+    // particles once each gather completes. The displacement gather must
+    // already be started.
+    void updateForceOverlap()
+    {
+        const std::size_t begin = particles->frozenOffset();
+        const std::size_t interior = particles->interiorOffset();
+        const std::size_t end = particles->localOffset();
+
+        // Weighted volume for LPS with fracture only depends on bonds and
+        // reference positions.
         if constexpr ( is_fracture<
                            typename force_model_type::fracture_type>::value )
         {
             force->computeWeightedVolume( *particles, neigh_iter_tag{} );
-            comm->gatherWeightedVolume();
+            comm->startGatherWeightedVolume();
         }
-        // Compute and communicate dilatation for LPS (does nothing for PMB).
+
+        // Dilatation for LPS (does nothing for PMB).
+        force->setParticleRange( begin, interior );
+        force->computeDilatation( *particles, neigh_iter_tag{} );
+        comm->finishGatherDisplacement();
+        force->setParticleRange( interior, end );
         force->computeDilatation( *particles, neigh_iter_tag{} );
-        comm->gatherDilatation();
+        force->resetParticleRange();
+        comm->startGatherDilatation();
 
-        // Compute internal forces.
-        computeForce( *force, *particles, neigh_iter_tag{} );
+        computeForce( *force, *particles, neigh_iter_tag{}, begin, interior,
+                      !_forces_zeroed );
+        _forces_zeroed = false;
+        if constexpr ( is_fracture<
+                           typename force_model_type::fracture_type>::value )
+            comm->finishGatherWeightedVolume();
+        comm->finishGatherDilatation();
+        computeForce( *force, *particles, neigh_iter_tag{}, interior, end,
+                      false );
+    }
+
+    // Whether to take another step: up to the final time with adaptive
+    // timesteps, otherwise the fixed number of steps.
+    bool continueStepping( const int step ) const
+    {
+        if ( _adaptive_timestep )
+            return _time < _final_time * ( 1.0 - 1e-12 );
+        return step <= num_steps;
+    }
+
+    // Set the timestep and simulation time at the end of this step. Adaptive
+    // timesteps are updated periodically from the current state and never
+    // step past the final time.
+    void beginStep( const int step )
+    {
+        _last_step = step;
+        if ( !_adaptive_timestep )
+        {
+            _time = step * dt;
+            return;
+        }
+
+        if ( ( step - _restart_step - 1 ) % _adaptive_frequency == 0 )
+            adaptTimeStep();
+        const double step_dt = std::min( dt, _final_time - _time );
+        integrator->setTimeStep( step_dt );
+        _time += step_dt;
+    }
+
+    // Estimate the stable timestep from the intact bonds, contact pairs, and
+    // velocities, limiting the growth from the current timestep.
+    void adaptTimeStep()
+    {
+        Kokkos::View<double*, memory_space> k( "stiffness",
+                                               particles->localOffset() );
+        addBondStiffness( *force, *particles, _micromodulus, k );
+        if constexpr ( is_contact<contact_model_type>::value )
+            addContactStiffness( k );
+        const double dt_stable =
+            _safety_factor *
+            estimateStableTimeStep( *particles, k, _max_distance );
+        const double dt_limit = std::min( _dt_max, _dt_growth * dt );
+        dt = std::clamp( dt_stable, _dt_min, std::max( _dt_min, dt_limit ) );
+        _num_timestep_updates++;
+    }
+
+    // Contact stiffness for the stable timestep, scaled if subcycled such
+    // that only the substeps are limited by contact.
+    template <class StiffnessType>
+    void addContactStiffness( const StiffnessType& k )
+    {
+        if ( !subcycle )
+        {
+            contact->addStiffness( *particles, k );
+            return;
+        }
+        StiffnessType k_contact( "contact_stiffness", k.extent( 0 ) );
+        contact->addStiffness( *particles, k_contact );
+        const double scale = subcycle->stiffnessScale();
+        Kokkos::RangePolicy<exec_space> policy( 0, k.extent( 0 ) );
+        Kokkos::parallel_for(
+            "CabanaPD::Solver::contactStiffness", policy,
+            KOKKOS_LAMBDA( const int i ) {
+                k( i ) += scale * k_contact( i );
+            } );
+    }
+
+    // Output index of a step: by step with fixed timesteps, otherwise by
+    // simulation time.
+    int outputIndex( const int step ) const
+    {
+        if ( _adaptive_timestep )
+            return static_cast<int>( _time / _output_interval *
+                                     ( 1.0 + 1e-12 ) );
+        return step / output_frequency;
+    }
+
+    bool outputStep( const int step ) const
+    {
+        if ( _adaptive_timestep )
+            return outputIndex( step ) > _num_outputs;
+        return step % output_frequency == 0;
     }
 
     void output( const int step )
     {
         // Print output.
-        if ( step % output_frequency == 0 )
+        _steps_since_output++;
+        if ( outputStep( step ) )
         {
-            auto W = computeEnergy( *force, *particles, neigh_iter_tag() );
-
-            particles->output( step / output_frequency, step * dt,
-                               output_reference );
+            _num_outputs = outputIndex( step );
+            particles->output( _num_outputs, _time, output_reference );
+            // The global energy is that of the previous output, such that
+            // its reduction overlaps with the steps in between.
+            diagnostics->start( exec_space{}, *particles, step, _time );
             _step_timer.stop();
-            step_output( step, W );
+            step_output( step, diagnostics->strainEnergy() );
         }
         else
         {
+            diagnostics->test();
             _step_timer.stop();
         }
     }
 
-    void init_output( double boundary_init_time = 0.0 )
+    void init_output( double boundary_init_time = 0.0,
+                      MemoryRegistry memory = MemoryRegistry() )
     {
+        _num_outputs = outputIndex( _restart_step );
+        _steps_since_output = 0;
+
         // Output after construction and initial forces.
-        std::ofstream out( output_file, std::ofstream::app );
-        _init_time += _init_timer.time() + _neighbor_timer.time() +
-                      particles->timeInit() + comm->timeInit() +
-                      integrator->timeInit() + boundary_init_time;
+        auto& out = _out;
+        _init_time += inputs.timeInit() + _init_timer.time() +
+                      _neighbor_timer.time() + particles->timeInit() +
+                      comm->timeInit() + integrator->timeInit() +
+                      boundary_init_time;
         log( out, "Init-Time(s): ", _init_time );
+        // Startup breakdown.
+        log( out, "Init-Input-Time(s): ", inputs.timeInit() );
+        log( out, "Init-Domain-Time(s): ", particles->timeDomain() );
+        log( out, "Init-Particles-Time(s): ", particles->timeCreate() );
+        log( out, "Init-Halo-Time(s): ", comm->timeInit() );
+        comm->haloReport( out );
+        log( out, "Init-Prenotch-Time(s): ", _prenotch_time );
         log( out, "Init-Neighbor-Time(s): ", _neighbor_timer.time(), "\n" );
-        log( out, "#Timestep/Total-steps Simulation-time Total-strain-energy "
-                  "Step-Time(s) Force-Time(s) Comm-Time(s) Integrate-Time(s) "
-                  "Energy-Time(s) Output-Time(s) Particle*steps/s" );
+        memory_output( memory );
+        log( out, "#Timestep/Total-steps Simulation-time "
+                  "Previous-output-strain-energy Step-Time(s) Force-Time(s) "
+                  "Comm-Time(s) Integrate-Time(s) Energy-Time(s) "
+                  "Output-Time(s) Particle*steps/s" );
+    }
+
+    // Per-rank memory of the major allocations, with the number of particles
+    // which would fit on one device (collective).
+    void memory_output( MemoryRegistry& memory )
+    {
+        particles->memory( memory );
+        comm->memory( memory );
+        force->neighborMemory( memory );
+        if constexpr ( is_fracture<
+                           typename force_model_type::fracture_type>::value )
+            force->bondMemory( memory );
+        if constexpr ( is_contact<contact_model_type>::value )
+            contact->memory( memory );
+
+        double device_bytes = inputs["device_memory"];
+        device_bytes *= 1024.0 * 1024.0 * 1024.0;
+        if ( device_bytes <= 0.0 )
+            device_bytes = deviceMemoryBytes<memory_space>();
+        memory.write( _out, particles->numLocal(), device_bytes );
     }
 
     void step_output( const int step, const double W )
     {
         if ( print )
         {
-            std::ofstream out( output_file, std::ofstream::app );
+            auto& out = _out;
             log( std::cout, step, "/", num_steps, " ", std::scientific,
-                 std::setprecision( 2 ), step * dt );
+                 std::setprecision( 2 ), _time );
 
             double step_time = _step_timer.time();
             double comm_time = comm->time();
@@ -423,22 +1063,136 @@ class Solver
             double output_time = particles->timeOutput();
             _total_time += step_time;
             auto rate = static_cast<double>( particles->numGlobal() *
-                                             output_frequency / ( step_time ) );
+                                             _steps_since_output / step_time );
+            _steps_since_output = 0;
             _step_timer.reset();
             log( out, std::fixed, std::setprecision( 6 ), step, "/", num_steps,
-                 " ", std::scientific, std::setprecision( 2 ), step * dt, " ",
+                 " ", std::scientific, std::setprecision( 2 ), _time, " ",
                  W, " ", std::fixed, _total_time, " ", force_time, " ",
                  comm_time, " ", integrate_time, " ", energy_time, " ",
                  output_time, " ", std::scientific, rate );
-            out.close();
+        }
+    }
+
+    // Write the timing report for all registered regions (collective).
+    void profile_output()
+    {
+        if ( !_profile_output )
+            return;
+
+        _profile.add( "Solver::Init", _init_timer );
+        _profile.add( "Solver::Neighbor", _neighbor_timer );
+        particles->profile( _profile );
+        checkpoint->profile( _profile );
+        comm->profile( _profile );
+        integrator->profile( _profile );
+        force->profile( _profile );
+        if constexpr ( is_heat_transfer<
+                           typename force_model_type::thermal_type>::value )
+            heat_transfer->profile( _profile );
+        if constexpr ( is_contact<contact_model_type>::value )
+            contact->profile( _profile );
+        if ( subcycle )
+            subcycle->profile( _profile );
+        if ( _monitor_frequency > 0 )
+            monitors->profile( _profile );
+        diagnostics->profile( _profile );
+        _profile.write( inputs["profile_file"] );
+    }
+
+    // Reduce and write the global monitors.
+    void monitorStep( const int step )
+    {
+        if ( _monitor_frequency <= 0 || step % _monitor_frequency != 0 )
+            return;
+        monitors->compute( exec_space{}, *particles );
+        monitors->write( step, _time );
+    }
+
+    // Remove broken bonds from the neighbor list on output steps once enough
+    // are broken.
+    void compactBonds( const int step )
+    {
+        if constexpr ( is_fracture<
+                           typename force_model_type::fracture_type>::value )
+        {
+            if ( _compaction_threshold <= 0.0 ||
+                 step % output_frequency != 0 )
+                return;
+            _neighbor_timer.start();
+            if ( force->compactBonds( *particles, _compaction_threshold ) )
+                _num_compactions++;
+            _neighbor_timer.stop();
+        }
+    }
+
+    // Start writing the full state; the write overlaps the following steps.
+    void checkpointStep( const int step )
+    {
+        if ( _checkpoint_frequency <= 0 || step % _checkpoint_frequency != 0 )
+        {
+            checkpoint->progress();
+            return;
+        }
+
+        using model_type = typename force_model_type::base_model;
+        if constexpr ( is_fracture<
+                           typename force_model_type::fracture_type>::value )
+            checkpoint->write( step, _time, model_type{}, *particles,
+                               force->getBrokenBonds() );
+        else
+            checkpoint->write( step, _time, model_type{}, *particles );
+    }
+
+    // Replace the initial state with a checkpoint. Broken bonds are reloaded
+    // such that prenotches are not recreated.
+    void restart()
+    {
+        using model_type = typename force_model_type::base_model;
+        double time;
+        if constexpr ( is_fracture<
+                           typename force_model_type::fracture_type>::value )
+        {
+            auto mu = force->getBrokenBonds();
+            checkpoint->read( _restart_file, _restart_step, time, model_type{},
+                              *particles, mu );
+        }
+        else
+        {
+            checkpoint->read( _restart_file, _restart_step, time, model_type{},
+                              *particles );
+        }
+
+        _time = time;
+        _last_step = _restart_step;
+
+        comm->gatherDisplacement();
+        if constexpr ( is_temperature_dependent<
+                           typename force_model_type::thermal_type>::value )
+            comm->gatherTemperature();
+        if constexpr ( is_contact<contact_model_type>::value )
+        {
+            contact->resetNeighbors();
+            if ( _contact_exclude_bonds )
+                excludeContactBonds();
+        }
+        if ( print )
+        {
+            auto& out = _out;
+            log( out, "Restarted from ", _restart_file, " at step ",
+                 _restart_step, ", time ", time );
         }
     }
 
     void final_output()
     {
+        checkpoint->finish();
+        diagnostics->finish();
+        particles->finishOutput();
+        profile_output();
         if ( print )
         {
-            std::ofstream out( output_file, std::ofstream::app );
+            auto& out = _out;
             double comm_time = comm->time();
             double integrate_time = integrator->time();
             double force_time = force->time();
@@ -448,7 +1202,8 @@ class Solver
             _total_time = _init_time + comm_time + integrate_time + force_time +
                           energy_time + output_time + particles->time();
 
-            double steps_per_sec = 1.0 * num_steps / _total_time;
+            double steps_per_sec =
+                1.0 * ( _last_step - _restart_step ) / _total_time;
             double p_steps_per_sec = particles->numGlobal() * steps_per_sec;
             log( out, std::fixed, std::setprecision( 2 ),
                  "\n#Procs Particles | Total Force Comm Integrate Energy "
@@ -465,27 +1220,286 @@ class Solver
                  "#Steps/s Particle-steps/s Particle-steps/proc/s\n",
                  std::scientific, steps_per_sec, " ", p_steps_per_sec, " ",
                  p_steps_per_sec / comm->mpi_size );
-            out.close();
+            log( out, "Global diagnostics (step ", diagnostics->step(),
+                 "): Strain-energy ", std::scientific,
+                 diagnostics->strainEnergy(), ", Kinetic-energy ",
+                 diagnostics->kineticEnergy(), ", Damaged-volume ",
+                 diagnostics->damagedVolume(), ", Max-damage ",
+                 diagnostics->maxDamage() );
+            if constexpr ( is_contact<contact_model_type>::value )
+                log( out, "Contact-Neighbor-Builds: ",
+                     contact->numNeighborBuilds(),
+                     ", Contact-Neighbor-Time(s): ", std::fixed,
+                     contact->timeNeighbor() );
+            if ( _migration_distance > 0.0 )
+                log( out, "Particle migrations: ", _num_migrations );
+            if ( _rebalance_frequency > 0 )
+                log( out, "Domain rebalances: ", _num_rebalances );
+            if ( _compaction_threshold > 0.0 )
+                log( out, "Broken bond compactions: ", _num_compactions );
+            if ( _adaptive_timestep )
+                log( out, "Steps: ", _last_step - _restart_step,
+                     ", Timestep updates: ", _num_timestep_updates,
+                     ", Final timestep: ", std::scientific, dt );
+            out.flush();
         }
     }
 
+    // Monitor the reaction force within a region (with monitor_frequency).
+    void addReactionRegion( const RegionBoundary<RectangularPrism>& region )
+    {
+        monitors->addReactionRegion( region );
+    }
+
     int num_steps;
     int output_frequency;
     bool output_reference;
     double dt;
     int thermal_subcycle_steps;
+    // RKL2 super-time-stepping stages (forward Euler if zero).
+    int thermal_stages = 0;
 
   protected:
-    template <std::size_t NumPrenotch>
-    void init_prenotch( Prenotch<NumPrenotch> prenotch )
+    // Heat transfer on a separate execution space instance.
+    bool _concurrent_heat_transfer = false;
+
+    // Launch one thermal step on the heat transfer instance once prior work
+    // on the default instance (temperature boundary conditions, ghost
+    // temperatures, and broken bonds) is complete. The mechanics may then
+    // proceed until the temperature is needed (finishTemperature).
+    void startTemperature()
+    {
+        exec_space().fence();
+        updateTemperature();
+    }
+    void finishTemperature() { heat_transfer->executionSpace().fence(); }
+
+    // Advance temperature by one thermal step.
+    void updateTemperature()
+    {
+        const double dt_thermal = thermal_subcycle_steps * dt;
+        if ( thermal_stages > 0 )
+            computeHeatTransferRKL2( *heat_transfer, *particles,
+                                     neigh_iter_tag{}, dt_thermal,
+                                     thermal_stages,
+                                     [&]() { comm->gatherTemperature(); } );
+        else if ( _conduction_ready )
+            heat_transfer->forwardEuler( *particles, dt_thermal );
+        else
+            computeHeatTransfer( *heat_transfer, *particles, neigh_iter_tag{},
+                                 dt_thermal );
+        _conduction_ready = false;
+    }
+
+    // Heat transfer conduction computed within the force kernel which
+    // precedes each thermal step (the temperature is unchanged in between).
+    bool _fused_conduction = false;
+    bool _conduction_ready = false;
+
+    // Whether the forces for this step also compute the conduction for the
+    // next, which must then be a thermal step.
+    bool fuseConduction( const int step ) const
+    {
+        return _fused_conduction && ( step + 1 ) % thermal_subcycle_steps == 0;
+    }
+
+    void updateForceAndConduction()
+    {
+        if constexpr ( is_heat_transfer<
+                           typename force_model_type::thermal_type>::value )
+        {
+            computeForceAndConduction( *force, *heat_transfer, *particles,
+                                       neigh_iter_tag{}, !_forces_zeroed );
+            _conduction_ready = true;
+        }
+    }
+
+    // Strain energy from the most recent output step force computation.
+    double _energy = 0.0;
+    // Overlap ghost communication with interior force computation.
+    bool _overlap_comm = false;
+    // Simulation time at the end of the current step.
+    double _time = 0.0;
+    int _last_step = 0;
+    // Timestep adapted to a runtime stability estimate: bounds, maximum
+    // growth per update, and maximum distance moved per step.
+    bool _adaptive_timestep = false;
+    int _adaptive_frequency = 1;
+    double _dt_min = 0.0;
+    double _dt_max = 0.0;
+    double _dt_growth = 1.0;
+    double _max_distance = 0.0;
+    double _micromodulus = 0.0;
+    double _safety_factor = 1.0;
+    double _final_time = 0.0;
+    int _num_timestep_updates = 0;
+    // Output every output_time_interval with adaptive timesteps.
+    double _output_interval = 0.0;
+    int _num_outputs = 0;
+    int _steps_since_output = 0;
+    // Fuse per-particle work into the integrator drift, where forces may be
+    // zeroed ahead of the next force computation.
+    bool _fused_integration = false;
+    bool _forces_zeroed = false;
+    // Particles migrate once any has moved half this skin distance.
+    double _migration_distance = 0.0;
+    double _ghost_cutoff = 0.0;
+    double _contact_ghost_cutoff = 0.0;
+    int _num_migrations = 0;
+    // Steps between repartitioning the domain by bonds per rank.
+    int _rebalance_frequency = 0;
+    int _num_rebalances = 0;
+
+    // Rebuild (sorted) neighbors for the current broken bonds.
+    void rebuildNeighbors()
+    {
+        if constexpr ( is_fracture<
+                           typename force_model_type::fracture_type>::value )
+            force->rebuildNeighbors( *particles, force->getBrokenBonds() );
+        else
+            force->rebuildNeighbors( *particles );
+    }
+
+    // Move particles to the rank owning their current position and rebuild
+    // ghosts and neighbors if any particle may have moved far enough to
+    // invalidate them.
+    void migrate()
+    {
+        if ( comm->maxDisplacementSinceMigration( *particles ) <=
+             0.5 * _migration_distance )
+            return;
+
+        auto distributor = comm->createDistributor( *particles );
+        redistribute( distributor );
+        _num_migrations++;
+    }
+
+    // Repartition the domain such that each rank holds a similar number of
+    // bonds and move all particles to their new owning rank.
+    void rebalance()
+    {
+        particles->rebalance( force->getLoadWeights( *particles ) );
+        auto distributor = comm->createRebalanceDistributor( *particles );
+        redistribute( distributor );
+        _num_rebalances++;
+    }
+
+    // Move particles (and broken bonds) with the given plan and rebuild
+    // ghosts, neighbors, and derived quantities.
+    template <class DistributorType>
+    void redistribute( const DistributorType& distributor )
+    {
+        _neighbor_timer.start();
+        if constexpr ( is_fracture<
+                           typename force_model_type::fracture_type>::value )
+        {
+            auto mu = force->getBrokenBonds();
+            auto migrated = comm->migrateRows( distributor, mu.view() );
+            particles->migrate( distributor );
+            comm->rebuildHalo( *particles, _ghost_cutoff,
+                               _contact_ghost_cutoff );
+            force->rebuildNeighbors( *particles, decltype( mu )( migrated ) );
+        }
+        else
+        {
+            particles->migrate( distributor );
+            comm->rebuildHalo( *particles, _ghost_cutoff,
+                               _contact_ghost_cutoff );
+            rebuildNeighbors();
+        }
+        _neighbor_timer.stop();
+
+        // Weighted volume for LPS is only otherwise computed once without
+        // fracture.
+        force->computeWeightedVolume( *particles, neigh_iter_tag{} );
+        comm->gatherWeightedVolume();
+        comm->resetMigrationReference( *particles );
+        if constexpr ( is_contact<contact_model_type>::value )
+        {
+            contact->resetNeighbors();
+            // Neighbors and broken bonds have been replaced.
+            if ( _contact_exclude_bonds )
+                excludeContactBonds();
+        }
+    }
+
+    // Skip contact between particles with an intact bond.
+    bool _contact_exclude_bonds = false;
+
+    // Replace a drift of length tau by velocity Verlet substeps with the
+    // (separately stored) contact forces. Ghost displacements are updated
+    // for every contact evaluation.
+    void subcycleContact( const double tau )
+    {
+        if constexpr ( is_contact<contact_model_type>::value )
+        {
+            const double h = tau / subcycle->numSubsteps();
+            for ( int k = 0; k < subcycle->numSubsteps(); k++ )
+            {
+                subcycle->kick( *particles, 0.5 * h );
+                subcycle->drift( *particles, h );
+                comm->gatherDisplacement();
+                updateSubcycleContact();
+                subcycle->kick( *particles, 0.5 * h );
+            }
+        }
+    }
+
+    void updateSubcycleContact()
+    {
+        if constexpr ( is_contact<contact_model_type>::value )
+        {
+            particles->updateGhostCurrentPositions();
+            auto fc = subcycle->resetContactForce( *particles );
+            auto x = particles->sliceReferencePosition();
+            auto u = particles->sliceDisplacement();
+            neigh_iter_tag neigh_op_tag;
+            // Only atomic if using team threading.
+            if constexpr ( is_team_op<neigh_iter_tag>::value )
+            {
+                Kokkos::View<double* [3], memory_space,
+                             Kokkos::MemoryTraits<Kokkos::Atomic>>
+                    fc_a = fc;
+                contact->computeForceFull( fc_a, x, u, *particles,
+                                           neigh_op_tag );
+            }
+            else
+            {
+                contact->computeForceFull( fc, x, u, *particles,
+                                           neigh_op_tag );
+            }
+        }
+    }
+
+    void excludeContactBonds()
+    {
+        if constexpr ( is_contact<contact_model_type>::value )
+        {
+            using fracture_type = typename force_model_type::fracture_type;
+            if constexpr ( is_fracture<fracture_type>::value )
+                contact->excludeBonds( force->getNeighbors(),
+                                       force->getBrokenBonds() );
+            else
+                contact->excludeBonds( force->getNeighbors() );
+        }
+    }
+
+    template <class PrenotchType>
+    void init_prenotch( PrenotchType& prenotch )
     {
         static_assert(
             is_fracture<typename force_model_type::fracture_type>::value,
             "Cannot create prenotch in system without fracture." );
+        static_assert( particle_type::dim == 3, "Prenotch requires 3d." );
+
+        // Prenotched bonds are reloaded with the other broken bonds.
+        if ( !_restart_file.empty() )
+            return;
 
         // Create prenotch.
         force->prenotch( exec_space{}, *particles, prenotch );
-        _init_time += prenotch.time();
+        _prenotch_time = prenotch.time();
+        _init_time += _prenotch_time;
     }
 
     // Core modules.
@@ -497,38 +1511,62 @@ class Solver
     // Optional modules.
     std::shared_ptr<heat_transfer_type> heat_transfer;
     std::shared_ptr<contact_type> contact;
+    // Multirate contact integration (only if subcycled).
+    std::shared_ptr<subcycle_type> subcycle;
+    std::shared_ptr<Checkpoint> checkpoint;
+    int _checkpoint_frequency = 0;
+    std::shared_ptr<monitors_type> monitors;
+    int _monitor_frequency = 0;
+    std::shared_ptr<diagnostics_type> diagnostics;
+    // Fraction of broken bonds which triggers compaction (disabled if zero).
+    double _compaction_threshold = 0.0;
+    int _num_compactions = 0;
+    // Bond breaking force evaluations between active set updates (all bonds
+    // checked if zero) and the fraction of the critical stretch included.
+    int _active_bond_frequency = 0;
+    double _active_bond_threshold = 0.5;
+    int _num_active_updates = 0;
+    // Checkpoint to restart from (if any) and its step.
+    std::string _restart_file;
+    int _restart_step = 0;
 
     // Output files.
     std::string output_file;
     std::string error_file;
+    std::ofstream _out;
 
     // Note: init_time is combined from many class timers.
     double _init_time;
-    Timer _init_timer;
-    Timer _neighbor_timer;
+    double _prenotch_time = 0.0;
+    Timer _init_timer = Timer( "Solver::Init" );
+    Timer _neighbor_timer = Timer( "Solver::Neighbor" );
     Timer _step_timer;
+    bool _profile_output = false;
+    TimerRegistry _profile;
     double _total_time;
     bool print;
 };
 
-template <class MemorySpace, class InputsType, class ParticleType,
-          class ForceModelType>
+template <class MemorySpace, class NeighIterTag = Cabana::SerialOpTag,
+          class InputsType, class ParticleType, class ForceModelType>
 auto createSolver( InputsType inputs, std::shared_ptr<ParticleType> particles,
                    ForceModelType model )
 {
-    return std::make_shared<
-        Solver<MemorySpace, InputsType, ParticleType, ForceModelType>>(
+    return std::make_shared<Solver<MemorySpace, InputsType, ParticleType,
+                                   ForceModelType, NoContact, NeighIterTag>>(
         inputs, particles, model );
 }
 
-template <class MemorySpace, class InputsType, class ParticleType,
-          class ForceModelType, class ContactModelType>
+template <class MemorySpace, class NeighIterTag = Cabana::SerialOpTag,
+          class InputsType, class ParticleType, class ForceModelType,
+          class ContactModelType>
 auto createSolver( InputsType inputs, std::shared_ptr<ParticleType> particles,
                    ForceModelType model, ContactModelType contact_model )
 {
-    return std::make_shared<Solver<MemorySpace, InputsType, ParticleType,
-                                   ForceModelType, ContactModelType>>(
-        inputs, particles, model, contact_model );
+    return std::make_shared<
+        Solver<MemorySpace, InputsType, ParticleType, ForceModelType,
+               ContactModelType, NeighIterTag>>( inputs, particles, model,
+                                                 contact_model );
 }
 
 } // namespace CabanaPD
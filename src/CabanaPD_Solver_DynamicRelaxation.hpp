@@ -0,0 +1,311 @@
+/****************************************************************************
+ * Copyright (c) 2022 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of CabanaPD. CabanaPD is distributed under a           *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#ifndef SOLVER_DYNAMIC_RELAXATION_H
+#define SOLVER_DYNAMIC_RELAXATION_H
+
+#include <algorithm>
+#include <iomanip>
+#include <memory>
+#include <stdexcept>
+
+#include <Kokkos_Core.hpp>
+
+#include <CabanaPD_Boundary.hpp>
+#include <CabanaPD_Integrate.hpp>
+#include <CabanaPD_Memory.hpp>
+#include <CabanaPD_Output.hpp>
+#include <CabanaPD_Solver_Yoshida.hpp>
+#include <CabanaPD_TimeStep.hpp>
+#include <CabanaPD_Timer.hpp>
+
+namespace CabanaPD
+{
+/******************************************************************************
+  Quasi-static solver using adaptive dynamic relaxation.
+
+  The load (boundary conditions and body terms, as functions of time) is
+  applied in relaxation_load_steps increments up to final_time. Each increment
+  is relaxed to equilibrium with the current bonds; bonds are then broken and
+  the increment is relaxed again until equilibrium holds with the new bonds.
+  Particle output is written after each increment. Forces, communication,
+  and boundary conditions are those of the dynamic solver.
+******************************************************************************/
+template <class MemorySpace, class InputType, class ParticleType,
+          class ForceModelType, class ContactModelType = NoContact,
+          class NeighIterTag = Cabana::SerialOpTag>
+class SolverDynamicRelaxation
+    : public Solver<MemorySpace, InputType, ParticleType, ForceModelType,
+                    ContactModelType, NeighIterTag>
+{
+  public:
+    using base_type = Solver<MemorySpace, InputType, ParticleType,
+                             ForceModelType, ContactModelType, NeighIterTag>;
+    using typename base_type::contact_model_type;
+    using typename base_type::exec_space;
+    using typename base_type::force_model_type;
+    using typename base_type::input_type;
+    using typename base_type::memory_space;
+    using typename base_type::neigh_iter_tag;
+    using typename base_type::particle_type;
+    using relaxation_type = DynamicRelaxation<exec_space>;
+
+    SolverDynamicRelaxation( input_type _inputs,
+                             std::shared_ptr<particle_type> _particles,
+                             force_model_type force_model )
+        : base_type( _inputs, _particles, force_model )
+    {
+        setupRelaxation();
+    }
+
+    SolverDynamicRelaxation( input_type _inputs,
+                             std::shared_ptr<particle_type> _particles,
+                             force_model_type force_model,
+                             contact_model_type contact_model )
+        : base_type( _inputs, _particles, force_model, contact_model )
+    {
+        setupRelaxation();
+    }
+
+    void setupRelaxation()
+    {
+        static_assert( !is_heat_transfer<
+                           typename force_model_type::thermal_type>::value,
+                       "Dynamic relaxation does not support heat transfer." );
+        if ( !_restart_file.empty() )
+            throw std::runtime_error( "Dynamic relaxation does not support "
+                                      "restarts." );
+
+        _load_steps = inputs["relaxation_load_steps"];
+        _tolerance = inputs["relaxation_tolerance"];
+        _max_iterations = inputs["relaxation_max_iterations"];
+        _density_scale = inputs["relaxation_density_scale"];
+        _final_time = inputs["final_time"];
+        if ( _load_steps < 1 || _max_iterations < 1 || _tolerance <= 0.0 )
+            throw std::runtime_error( "Invalid dynamic relaxation inputs." );
+    }
+
+    template <typename BoundaryType>
+    void run( BoundaryType boundary_condition )
+    {
+        MemoryRegistry memory;
+        boundary_condition.memory( memory );
+        init_output( boundary_condition.timeInit(), memory );
+        if ( print )
+            log( _out, "#Increment/Total-increments Load-time Iterations "
+                       "Residual Total-strain-energy Time(s)" );
+
+        // The fictitious density is fixed by the initial bonds.
+        setDensity();
+
+        double residual_scale = 0.0;
+        for ( int increment = 1; increment <= _load_steps; increment++ )
+        {
+            _increment_timer.start();
+            const double load_time = _final_time * increment / _load_steps;
+
+            _relaxation.restart( *particles );
+            applyLoad( boundary_condition, load_time );
+            comm->gatherDisplacement();
+
+            int iterations = 0;
+            double residual = 0.0;
+            bool converged = false;
+            while ( true )
+            {
+                updateForceNoBreaking();
+                addContactAndLoad( boundary_condition, load_time );
+                residual = _relaxation.residual( *particles );
+                if ( iterations == 0 )
+                    residual_scale = std::max( residual_scale, residual );
+
+                if ( isConverged( residual, residual_scale ) )
+                {
+                    // Break bonds at equilibrium, continuing to relax if the
+                    // forces changed.
+                    updateForce( true );
+                    addContactAndLoad( boundary_condition, load_time );
+                    residual = _relaxation.residual( *particles );
+                    if ( isConverged( residual, residual_scale ) )
+                    {
+                        converged = true;
+                        break;
+                    }
+                }
+                if ( iterations >= _max_iterations )
+                    break;
+
+                // Prescribed displacements overwrite the step before the
+                // ghosts are updated.
+                _relaxation.step( *particles );
+                applyLoad( boundary_condition, load_time );
+                comm->gatherDisplacement();
+                iterations++;
+            }
+            _total_iterations += iterations;
+            if ( !converged )
+                _num_unconverged++;
+
+            particles->output( increment, load_time, output_reference );
+            // Increments are infrequent, so the global energy is waited for.
+            diagnostics->start( exec_space{}, *particles, increment,
+                                load_time );
+            diagnostics->finish();
+            _increment_timer.stop();
+            incrementOutput( increment, load_time, iterations, residual,
+                             converged );
+        }
+
+        boundary_condition.profile( _profile );
+        finalOutput();
+    }
+
+    void run() { run( NoBoundaryCondition{} ); }
+
+    auto numIterations() const { return _total_iterations; }
+    auto numUnconverged() const { return _num_unconverged; }
+
+  protected:
+    using base_type::_final_time;
+    using base_type::_out;
+    using base_type::_profile;
+    using base_type::_restart_file;
+    using base_type::checkpoint;
+    using base_type::comm;
+    using base_type::contact;
+    using base_type::diagnostics;
+    using base_type::force;
+    using base_type::init_output;
+    using base_type::inputs;
+    using base_type::output_reference;
+    using base_type::particles;
+    using base_type::print;
+    using base_type::profile_output;
+    using base_type::updateForce;
+    using base_type::updateForceNoBreaking;
+
+    bool isConverged( const double residual, const double scale ) const
+    {
+        return residual <= _tolerance * scale;
+    }
+
+    void setDensity()
+    {
+        Kokkos::View<double*, memory_space> k( "stiffness",
+                                               particles->localOffset() );
+        addBondStiffness( *force, *particles, inputs.micromodulus(), k );
+        if constexpr ( is_contact<contact_model_type>::value )
+            contact->addStiffness( *particles, k );
+        _relaxation.setDensity( *particles, k, _density_scale );
+    }
+
+    // Non-force boundary conditions and body terms at the load time.
+    template <typename BoundaryType>
+    void applyLoad( BoundaryType& boundary_condition, const double load_time )
+    {
+        applyBoundaryCondition( boundary_condition, exec_space(), *particles,
+                                load_time, false );
+        if constexpr ( is_temperature_dependent<
+                           typename force_model_type::thermal_type>::value )
+            comm->gatherTemperature();
+    }
+
+    template <typename BoundaryType>
+    void addContactAndLoad( BoundaryType& boundary_condition,
+                            const double load_time )
+    {
+        if constexpr ( is_contact<contact_model_type>::value )
+        {
+            particles->updateGhostCurrentPositions();
+            computeForce( *contact, *particles, neigh_iter_tag{}, false );
+        }
+        applyBoundaryCondition( boundary_condition, exec_space(), *particles,
+                                load_time, true );
+    }
+
+    void incrementOutput( const int increment, const double load_time,
+                          const int iterations, const double residual,
+                          const bool converged )
+    {
+        if ( print )
+        {
+            log( std::cout, increment, "/", _load_steps, " ", std::scientific,
+                 std::setprecision( 2 ), load_time, " ", iterations,
+                 converged ? "" : " (not converged)" );
+            log( _out, increment, "/", _load_steps, " ", std::scientific,
+                 std::setprecision( 2 ), load_time, " ", iterations, " ",
+                 residual, " ", diagnostics->strainEnergy(), " ", std::fixed,
+                 _increment_timer.time() );
+        }
+    }
+
+    void finalOutput()
+    {
+        checkpoint->finish();
+        particles->finishOutput();
+        _profile.add( "Solver::Relaxation", _increment_timer );
+        _relaxation.profile( _profile );
+        profile_output();
+        const auto num_constrained = _relaxation.numConstrained();
+        if ( print )
+        {
+            log( _out, "\nRelaxation-Increments: ", _load_steps,
+                 ", Relaxation-Iterations: ", _total_iterations,
+                 ", Unconverged-Increments: ", _num_unconverged,
+                 ", Constrained-Particles: ", num_constrained );
+            log( _out, "Relaxation-Time(s): ", std::fixed,
+                 _increment_timer.time(), ", Force-Time(s): ", force->time(),
+                 ", Comm-Time(s): ", comm->time(),
+                 ", Integrate-Time(s): ", _relaxation.time() );
+            _out.flush();
+        }
+    }
+
+    relaxation_type _relaxation;
+    int _load_steps;
+    double _tolerance;
+    int _max_iterations;
+    double _density_scale;
+    int _total_iterations = 0;
+    int _num_unconverged = 0;
+    Timer _increment_timer = Timer( "Solver::Relaxation" );
+};
+
+template <class MemorySpace, class NeighIterTag = Cabana::SerialOpTag,
+          class InputsType, class ParticleType, class ForceModelType>
+auto createQuasiStaticSolver( InputsType inputs,
+                              std::shared_ptr<ParticleType> particles,
+                              ForceModelType model )
+{
+    return std::make_shared<
+        SolverDynamicRelaxation<MemorySpace, InputsType, ParticleType,
+                                ForceModelType, NoContact, NeighIterTag>>(
+        inputs, particles, model );
+}
+
+template <class MemorySpace, class NeighIterTag = Cabana::SerialOpTag,
+          class InputsType, class ParticleType, class ForceModelType,
+          class ContactModelType>
+auto createQuasiStaticSolver( InputsType inputs,
+                              std::shared_ptr<ParticleType> particles,
+                              ForceModelType model,
+                              ContactModelType contact_model )
+{
+    return std::make_shared<
+        SolverDynamicRelaxation<MemorySpace, InputsType, ParticleType,
+                                ForceModelType, ContactModelType,
+                                NeighIterTag>>( inputs, particles, model,
+                                                contact_model );
+}
+
+} // namespace CabanaPD
+
+#endif
@@ -60,11 +60,13 @@
 #ifndef SOLVER_H
 #define SOLVER_H
 
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <type_traits>
 
 #include <CabanaPD_config.hpp>
 
@@ -72,20 +74,29 @@
 #include <Kokkos_Core.hpp>
 
 #include <CabanaPD_Boundary.hpp>
+#include <CabanaPD_Checkpoint.hpp>
 #include <CabanaPD_Comm.hpp>
+#include <CabanaPD_Diagnostics.hpp>
 #include <CabanaPD_Force.hpp>
 #include <CabanaPD_HeatTransfer.hpp>
 #include <CabanaPD_Input.hpp>
 #include <CabanaPD_Integrate.hpp>
+#include <CabanaPD_Memory.hpp>
 #include <CabanaPD_Output.hpp>
 #include <CabanaPD_Particles.hpp>
 #include <CabanaPD_Prenotch.hpp>
+#include <CabanaPD_TimeStep.hpp>
 #include <CabanaPD_Timer.hpp>
 
 namespace CabanaPD
 {
+// The neighbor iteration tag selects one thread per particle (SerialOpTag) or
+// team threading over each particle's neighbors (TeamOpTag).
 template <class MemorySpace, class InputType, class ParticleType,
-          class ForceModelType, class ContactModelType = NoContact>
+          class ForceModelType, class ContactModelType = NoContact,
+          class NeighIterTag = Cabana::SerialOpTag,
+          class BondStorageType = BitBondStorage,
+          class BondCacheType = NoBondCache>
 class Solver
 {
   public:
@@ -96,16 +107,33 @@ class Solver
     using particle_type = ParticleType;
     using integrator_type = Yoshida<exec_space>;
     using force_model_type = ForceModelType;
-    using force_type = Force<memory_space, force_model_type>;
+    // Broken bond storage and bond caches only apply to models with fracture.
+    static constexpr bool has_bonds =
+        is_fracture<typename force_model_type::fracture_type>::value;
+    using bond_storage_type = BondStorageType;
+    using bond_cache_type = BondCacheType;
+    using force_type = std::conditional_t<
+        has_bonds,
+        Force<memory_space, force_model_type, BondStorageType, BondCacheType>,
+        Force<memory_space, force_model_type>>;
     using comm_type = Comm<particle_type, typename force_model_type::base_model,
                            typename particle_type::thermal_type>;
-    using neigh_iter_tag = Cabana::SerialOpTag;
+    using neigh_iter_tag = NeighIterTag;
     using input_type = InputType;
 
     // Optional module types.
-    using heat_transfer_type = HeatTransfer<memory_space, force_model_type>;
-    using contact_type = Force<memory_space, ContactModelType>;
+    using heat_transfer_type = std::conditional_t<
+        has_bonds,
+        HeatTransfer<memory_space, force_model_type, BondStorageType,
+                     BondCacheType>,
+        HeatTransfer<memory_space, force_model_type>>;
+    // Contact may exclude pairs using the PD neighbors and broken bonds.
+    using contact_type =
+        Force<memory_space, ContactModelType, BondStorageType>;
     using contact_model_type = ContactModelType;
+    using subcycle_type = ContactSubcycle<exec_space>;
+    using monitors_type = GlobalMonitors<memory_space>;
+    using diagnostics_type = GlobalDiagnostics<memory_space>;
 
     Solver( input_type _inputs, std::shared_ptr<particle_type> _particles,
             force_model_type force_model )
@@ -122,45 +150,305 @@ class Solver
         , particles( _particles )
         , _init_time( 0.0 )
     {
-        setup( force_model );
+        // Contact neighbors are only rebuilt after moving half the skin.
+        const double contact_skin = inputs["contact_skin"];
+        setup( force_model, contact_model.Rc + contact_skin );
 
+        static_assert( particle_type::dim == 3, "Contact requires 3d." );
         _neighbor_timer.start();
-        contact = std::make_shared<contact_type>( inputs["half_neigh"],
-                                                  *particles, contact_model );
+        contact = std::make_shared<contact_type>(
+            inputs["half_neigh"], *particles, contact_model, contact_skin );
+        // Optionally only compute contact between particles which are not
+        // bonded (or whose bonds are broken).
+        _contact_exclude_bonds = inputs["contact_exclude_bonds"];
+        if ( _contact_exclude_bonds )
+            excludeContactBonds();
         _neighbor_timer.stop();
+
+        // Contact is optionally subcycled within each stage drift (particle
+        // order must then be fixed). Only this solver subcycles contact; the
+        // velocity Verlet solver is not compiled.
+        const int contact_substeps = inputs["contact_substeps"];
+        if ( contact_substeps > 1 )
+        {
+            if ( _fused_integration )
+                throw std::runtime_error( "Contact subcycling is not "
+                                          "supported with fused "
+                                          "integration." );
+            if ( _migration_distance > 0.0 )
+                throw std::runtime_error( "Contact subcycling is not "
+                                          "supported with particle "
+                                          "migration." );
+            subcycle = std::make_shared<subcycle_type>( contact_substeps );
+        }
     }
 
-    void setup( force_model_type force_model )
+    void setup( force_model_type force_model,
+                const double contact_cutoff = 0.0 )
     {
+        static_assert( particle_type::dim == 3 ||
+                           !is_heat_transfer<
+                               typename force_model_type::thermal_type>::value,
+                       "Heat transfer requires 3d." );
+        // Model parameters are derived for the particle dimension.
+        if ( force_model.dim != particle_type::dim )
+            throw std::runtime_error( "Force model dimension does not match "
+                                      "the particle dimension." );
         inputs.computeCriticalTimeStep( force_model );
 
         num_steps = inputs["num_steps"];
         output_frequency = inputs["output_frequency"];
         output_reference = inputs["output_reference"];
+        _profile_output = inputs["profile_output"];
+
+        // Optionally fuse per-particle work into the integrator stages.
+        _fused_integration = inputs["fused_integration"];
+
+        // Migrating particles between ranks requires full neighbor lists that
+        // can be rebuilt independently and no per-particle model state.
+        _migration_distance = inputs["migration_distance"];
+        if ( _migration_distance > 0.0 )
+        {
+            bool half_neigh = inputs["half_neigh"];
+            if ( half_neigh )
+                throw std::runtime_error( "Particle migration is not "
+                                          "supported with half neighbor "
+                                          "lists." );
+            if constexpr ( is_temperature_dependent<
+                               typename force_model_type::thermal_type>::value )
+                throw std::runtime_error( "Particle migration is not "
+                                          "supported with temperature "
+                                          "dependence." );
+            if constexpr ( is_ensemble<force_model_type>::value )
+                throw std::runtime_error( "Particle migration is not "
+                                          "supported with ensembles." );
+            if ( particles->variableResolution() )
+                throw std::runtime_error( "Particle migration is not "
+                                          "supported with variable "
+                                          "resolution." );
+            if ( particles->numFrozen() > 0 )
+                throw std::runtime_error( "Particle migration is not "
+                                          "supported with frozen particles." );
+            if constexpr ( is_csr_storage<BondStorageType>::value )
+                throw std::runtime_error( "Particle migration is not "
+                                          "supported with CSR bond storage." );
+        }
+
+        // Optionally reduce the particle output to selected fields and a
+        // decimated region, and write it in the background.
+        std::vector<std::string> output_fields = inputs["output_fields"];
+        int output_stride = inputs["output_stride"];
+        std::array<double, particle_type::dim> output_low =
+            inputs["output_region_low"];
+        std::array<double, particle_type::dim> output_high =
+            inputs["output_region_high"];
+        bool output_single = inputs["output_single_precision"];
+        bool output_async = inputs["output_async"];
+        bool output_frozen = inputs["output_frozen"];
+        particles->setOutputOptions( output_fields, output_stride, output_low,
+                                     output_high, output_single, output_async,
+                                     output_frozen );
+
+        // Optionally monitor global values during the run.
+        _monitor_frequency = inputs["monitor_frequency"];
+        std::string monitor_file = inputs["monitor_file"];
+        int crack_axis = inputs["monitor_crack_axis"];
+        double crack_damage = inputs["monitor_crack_damage"];
+        monitors = std::make_shared<monitors_type>( monitor_file, crack_axis,
+                                                    crack_damage );
+        // Globally reduced energy and damage (always used for the log).
+        bool diagnostics_output = inputs["diagnostics_output"];
+        std::string diagnostics_file = inputs["diagnostics_file"];
+        double diagnostics_damage = inputs["diagnostics_damage"];
+        diagnostics = std::make_shared<diagnostics_type>(
+            diagnostics_file, diagnostics_damage, diagnostics_output );
+
+        // Optionally checkpoint the full state and restart from a checkpoint.
+        _checkpoint_frequency = inputs["checkpoint_frequency"];
+        std::string checkpoint_file = inputs["checkpoint_file"];
+        int ranks_per_file = inputs["checkpoint_ranks_per_file"];
+        checkpoint =
+            std::make_shared<Checkpoint>( checkpoint_file, ranks_per_file );
+        std::string restart_file = inputs["restart_file"];
+        _restart_file = restart_file;
+        // Restart relies on the particle order at creation.
+        if ( _migration_distance > 0.0 && !_restart_file.empty() )
+            throw std::runtime_error( "Restart is not supported with "
+                                      "particle migration." );
 
         // Create integrator.
         dt = inputs["timestep"];
         integrator = std::make_shared<integrator_type>( dt );
 
-        // Add ghosts from other MPI ranks.
-        comm = std::make_shared<comm_type>( *particles );
+        // Optionally adapt the timestep to a runtime stability estimate,
+        // stepping to the final time instead of a fixed number of steps.
+        _adaptive_timestep = inputs["adaptive_timestep"];
+        if ( _adaptive_timestep )
+        {
+            if constexpr ( is_heat_transfer<
+                               typename force_model_type::thermal_type>::value )
+                throw std::runtime_error( "Adaptive timesteps are not "
+                                          "supported with heat transfer." );
+            if constexpr ( is_variable_horizon<force_model_type>::value )
+                throw std::runtime_error( "Adaptive timesteps are not "
+                                          "supported with variable "
+                                          "horizons." );
+            bool half_neigh = inputs["half_neigh"];
+            if ( half_neigh )
+                throw std::runtime_error( "Adaptive timesteps are not "
+                                          "supported with half neighbor "
+                                          "lists." );
+            _adaptive_frequency = inputs["adaptive_timestep_frequency"];
+            _dt_min = inputs["timestep_min"];
+            _dt_max = inputs["timestep_max"];
+            if ( _dt_min > _dt_max || _adaptive_frequency < 1 )
+                throw std::runtime_error( "Invalid adaptive timestep inputs." );
+            _dt_growth = inputs["adaptive_timestep_growth"];
+            double max_distance = inputs["adaptive_timestep_distance"];
+            double dx = inputs["dx"][0];
+            _max_distance = max_distance * dx;
+            _micromodulus = inputs.micromodulus( force_model );
+            _safety_factor = inputs["timestep_safety_factor"];
+            _final_time = inputs["final_time"];
+            _output_interval = inputs["output_time_interval"];
+        }
+
+        // Overlapping ghost communication requires full neighbor lists and
+        // no ghost temperature updates within a stage.
+        _overlap_comm = inputs["overlap_communication"];
+        if ( _overlap_comm )
+        {
+            bool half_neigh = inputs["half_neigh"];
+            if ( half_neigh )
+                throw std::runtime_error( "Overlapping communication is not "
+                                          "supported with half neighbor "
+                                          "lists." );
+            if constexpr ( is_temperature_dependent<
+                               typename force_model_type::thermal_type>::value )
+                throw std::runtime_error( "Overlapping communication is not "
+                                          "supported with temperature "
+                                          "dependence." );
+        }
 
+        // Only particles with bonds that can cross a rank boundary are
+        // ghosted.
+        _ghost_cutoff = force_model.delta * ( 1.0 + 1e-8 );
+
+        // Optionally sort particles for memory locality before any ghosts or
+        // neighbor lists are created. Overlapping communication also places
+        // particles which may have ghost neighbors last.
+        bool reorder_particles = inputs["reorder_particles"];
+        if ( _overlap_comm )
+            particles->reorder( exec_space(), _ghost_cutoff );
+        else if ( reorder_particles )
+            particles->reorder( exec_space() );
+
+        // Rebalancing the domain by bonds per rank moves particles with the
+        // migration machinery.
+        _rebalance_frequency = inputs["rebalance_frequency"];
+        if ( _rebalance_frequency > 0 && _migration_distance <= 0.0 )
+            throw std::runtime_error( "Domain rebalancing requires particle "
+                                      "migration (migration_distance)." );
+
+        // Ghost forces are needed for half neighbor lists.
+        particles->useHalfNeighbors( inputs["half_neigh"] );
+
+        // Add ghosts from other MPI ranks.
+        HaloOptions halo_options;
+        halo_options.gpu_aware_mpi = inputs["halo_gpu_aware_mpi"];
+        halo_options.persistent_requests = inputs["halo_persistent_requests"];
+        halo_options.node_shared = inputs["halo_node_shared"];
+        comm = std::make_shared<comm_type>( *particles, _ghost_cutoff,
+                                            halo_options );
+
+        // Contact across ranks needs ghosts by current position, which are
+        // only maintained with particle migration.
         if constexpr ( is_contact<contact_model_type>::value )
         {
-            if ( comm->size() > 1 )
+            if ( comm->size() > 1 && _migration_distance <= 0.0 )
+                throw std::runtime_error( "Contact with MPI requires particle "
+                                          "migration (migration_distance)." );
+        }
+        if ( _migration_distance > 0.0 )
+        {
+            if ( contact_cutoff > 0.0 )
+            {
+                _contact_ghost_cutoff = contact_cutoff + _migration_distance;
+                comm->rebuildHalo( *particles, _ghost_cutoff,
+                                   _contact_ghost_cutoff );
+            }
+            comm->resetMigrationReference( *particles );
+        }
+
+        // Half neighbor lists are only supported for PD mechanics.
+        bool half_neigh = inputs["half_neigh"];
+        if ( half_neigh )
+        {
+            if constexpr ( is_contact<contact_model_type>::value )
+                throw std::runtime_error(
+                    "Half neighbor lists are not supported with contact." );
+            if constexpr ( is_heat_transfer<
+                               typename force_model_type::thermal_type>::value )
+                throw std::runtime_error( "Half neighbor lists are not "
+                                          "supported with heat transfer." );
+        }
+
+        // Broken bonds are optionally removed from the neighbor list, which
+        // then no longer matches neighbors rebuilt from positions.
+        _compaction_threshold = inputs["bond_compaction_threshold"];
+        if ( _compaction_threshold > 0.0 )
+        {
+            using fracture_type = typename force_model_type::fracture_type;
+            using thermal_type = typename force_model_type::thermal_type;
+            if constexpr ( !is_fracture<fracture_type>::value )
+                throw std::runtime_error(
+                    "Broken bond compaction requires fracture." );
+            if constexpr ( is_heat_transfer<thermal_type>::value )
+                throw std::runtime_error( "Broken bond compaction is not "
+                                          "supported with heat transfer." );
+            if ( _migration_distance > 0.0 )
+                throw std::runtime_error( "Broken bond compaction is not "
+                                          "supported with particle "
+                                          "migration." );
+            if ( _checkpoint_frequency > 0 || !_restart_file.empty() )
+                throw std::runtime_error( "Broken bond compaction is not "
+                                          "supported with checkpoints." );
+        }
+
+        // Bonds are optionally only checked for breaking near damage fronts.
+        _active_bond_frequency = inputs["active_bond_frequency"];
+        _active_bond_threshold = inputs["active_bond_threshold"];
+        if ( _active_bond_frequency > 0 )
+        {
+            if constexpr ( !force_type::has_active_bond_breaking )
                 throw std::runtime_error(
-                    "Contact with MPI is currently disabled." );
+                    "Active bond breaking requires PMB fracture." );
+            bool half_neigh = inputs["half_neigh"];
+            if ( half_neigh )
+                throw std::runtime_error( "Active bond breaking is not "
+                                          "supported with half neighbor "
+                                          "lists." );
         }
 
         // Update temperature ghost size if needed.
         if constexpr ( is_temperature_dependent<
                            typename force_model_type::thermal_type>::value )
             force_model.update( particles->sliceTemperature() );
+        // Update volume ghost size for variable horizons.
+        if constexpr ( is_variable_horizon<force_model_type>::value )
+            force_model.update( particles->sliceVolume() );
+        // Update the member types of the solver particles for ensembles.
+        if constexpr ( is_ensemble<force_model_type>::value )
+            force_model.update( particles->sliceType() );
 
         _neighbor_timer.start();
         // This will either be PD or DEM forces.
         force = std::make_shared<force_type>( inputs["half_neigh"], *particles,
                                               force_model );
+        // Bond order must not depend on particle storage order to migrate
+        // broken bonds.
+        if ( _migration_distance > 0.0 )
+            rebuildNeighbors();
         _neighbor_timer.stop();
 
         _init_timer.start();
@@ -174,8 +462,21 @@ class Solver
                            typename force_model_type::thermal_type>::value )
         {
             thermal_subcycle_steps = inputs["thermal_subcycle_steps"];
+            std::string thermal_integrator = inputs["thermal_integrator"];
+            if ( thermal_integrator == "rkl2" )
+                thermal_stages = inputs["thermal_stages"];
             heat_transfer = std::make_shared<heat_transfer_type>(
                 inputs["half_neigh"], *force, force_model );
+            // Only forward Euler conduction can be computed with the forces.
+            bool fused_conduction = inputs["fused_conduction"];
+            _fused_conduction = fused_conduction &&
+                                force_type::has_fused_conduction &&
+                                !force->halfNeighbor();
+            _concurrent_heat_transfer = inputs["concurrent_heat_transfer"];
+            if ( _concurrent_heat_transfer )
+                heat_transfer->setExecutionSpace(
+                    Kokkos::Experimental::partition_space( exec_space(),
+                                                           1 )[0] );
         }
 
         print = print_rank();
@@ -183,10 +484,15 @@ class Solver
         {
             log( std::cout, "Local particles: ", particles->numLocal(),
                  ", Maximum neighbors: ", max_neighbors );
+            if ( output_async && !particles->asyncOutput() )
+                log( std::cout, "Asynchronous output requires "
+                                "MPI_THREAD_MULTIPLE; writing synchronously." );
             log( std::cout, "#Timestep/Total-steps Simulation-time" );
 
+            // The output file stays open (and buffered) for the run.
             output_file = inputs["output_file"];
-            std::ofstream out( output_file, std::ofstream::app );
+            _out.open( output_file, std::ofstream::app );
+            auto& out = _out;
             error_file = inputs["error_file"];
             std::ofstream err( error_file, std::ofstream::app );
 
@@ -200,13 +506,18 @@ class Solver
                  particles->numGlobal() );
             log( out, "Maximum neighbors: ", max_neighbors,
                  ", Total neighbors: ", total_neighbors, "\n" );
-            out.close();
         }
         _init_timer.stop();
     }
 
     void init( const bool initial_output = true )
     {
+        // Fields may have been set directly since the ghosts were created.
+        particles->markModified();
+
+        if ( !_restart_file.empty() )
+            restart();
+
         // Compute and communicate weighted volume for LPS (does nothing for
         // PMB). Only computed once without fracture (and inside updateForce for
         // fracture).
@@ -215,13 +526,26 @@ class Solver
         {
             force->computeWeightedVolume( *particles, neigh_iter_tag{} );
             comm->gatherWeightedVolume();
+
+            // Optionally assemble the stiffness of linearized models once
+            // (after the weighted volume for LPS).
+            if constexpr ( force_type::has_stiffness_operator )
+                if ( inputs["assembled_stiffness"] )
+                    force->assembleStiffness( *particles );
         }
-        // Compute initial internal forces and energy.
-        updateForce();
-        computeEnergy( *force, *particles, neigh_iter_tag() );
+        // Compute initial internal forces and energy. Restarted forces are
+        // restored with the checkpointed bonds, without breaking any.
+        if ( _restart_file.empty() )
+            updateForce( true );
+        else
+            updateForceAndEnergyNoBreaking();
+        // Separately stored contact forces for the first subcycled half-kick.
+        if ( subcycle )
+            updateSubcycleContact();
 
         if ( initial_output )
-            particles->output( 0, 0.0, output_reference );
+            particles->output( outputIndex( _restart_step ), _time,
+                               output_reference );
     }
 
     template <typename BoundaryType>
@@ -229,8 +553,8 @@ class Solver
                const bool initial_output = true )
     {
         // Add non-force boundary condition.
-        if ( !boundary_condition.forceUpdate() )
-            boundary_condition.apply( exec_space(), *particles, 0.0 );
+        applyBoundaryCondition( boundary_condition, exec_space(), *particles,
+                                _time, false );
 
         // Communicate temperature.
         if constexpr ( is_temperature_dependent<
@@ -241,11 +565,12 @@ class Solver
         init( false );
 
         // Add force boundary condition.
-        if ( boundary_condition.forceUpdate() )
-            boundary_condition.apply( exec_space(), *particles, 0.0 );
+        applyBoundaryCondition( boundary_condition, exec_space(), *particles,
+                                _time, true );
 
         if ( initial_output )
-            particles->output( 0, 0.0, output_reference );
+            particles->output( outputIndex( _restart_step ), _time,
+                               output_reference );
     }
 
     // Initialize with prenotch, but no BC.
@@ -266,375 +591,548 @@ class Solver
         init( boundary_condition, initial_output );
     }
 
+    // Initialize with a runtime-sized prenotch list, but no BC.
+    void init( PrenotchList<memory_space> prenotch,
+               const bool initial_output = true )
+    {
+        init_prenotch( prenotch );
+        init( initial_output );
+    }
+
+    // Initialize with a runtime-sized prenotch list and BC.
+    template <typename BoundaryType>
+    void init( BoundaryType boundary_condition,
+               PrenotchList<memory_space> prenotch,
+               const bool initial_output = true )
+    {
+        init_prenotch( prenotch );
+        init( boundary_condition, initial_output );
+    }
+
     template <typename BoundaryType>
     void run( BoundaryType boundary_condition )
     {
-        init_output( boundary_condition.timeInit() );
+        if constexpr ( !std::is_same<BoundaryType, NoBoundaryCondition>::value )
+            if ( _migration_distance > 0.0 )
+                throw std::runtime_error(
+                    "Particle migration is not supported with boundary "
+                    "conditions (which store particle indices)." );
 
+        MemoryRegistry memory;
+        boundary_condition.memory( memory );
+        init_output( boundary_condition.timeInit(), memory );
 
         // Main timestep loop.
-        for ( int step = 1; step <= num_steps; step++ )
+        for ( int step = _restart_step + 1; continueStepping( step ); step++ )
         {
             _step_timer.start();
+            beginStep( step );
 
-	 	/******* Stage 1 *******/
+            for ( int stage = 0; stage < integrator_type::num_stages; stage++ )
+                runStage( step, stage, boundary_condition );
 
-            // Integrate - Yoshhida stage 1 update for displacement
-            integrator->stageOneDisplacement( *particles );
-
-            // Update ghost particles.
-            comm->gatherDisplacement();
-
-            if constexpr ( is_heat_transfer<
-                               typename force_model_type::thermal_type>::value )
+            // The last drift has no matching kick, so forces at the final
+            // positions are only needed for output.
+            const bool output_step = outputStep( step );
+            if ( output_step )
             {
-                if ( step % thermal_subcycle_steps == 0 )
-                    computeHeatTransfer( *heat_transfer, *particles,
-                                         neigh_iter_tag{},
-                                         thermal_subcycle_steps * dt );
+                updateForceAndEnergyNoBreaking();
+                if constexpr ( is_contact<contact_model_type>::value )
+                {
+                    particles->updateGhostCurrentPositions();
+                    computeForce( *contact, *particles, neigh_iter_tag{},
+                                  false );
+                }
+                applyBoundaryCondition( boundary_condition, exec_space(),
+                                        *particles, _time, true );
             }
 
-            // Add non-force boundary condition.
-            if ( !boundary_condition.forceUpdate() )
-                boundary_condition.apply( exec_space(), *particles, step * dt );
-
-            if constexpr ( is_temperature_dependent<
-                               typename force_model_type::thermal_type>::value )
-                comm->gatherTemperature();
-
-            // Compute internal forces.
-            updateForceNoBreaking();
-
-	    
-
-            if constexpr ( is_contact<contact_model_type>::value )
-                computeForce( *contact, *particles, neigh_iter_tag{}, false );
+            monitorStep( step );
+            output( step );
+            checkpointStep( step );
+            compactBonds( output_step );
+        }
 
-            // Add force boundary condition.
-            if ( boundary_condition.forceUpdate() )
-                boundary_condition.apply( exec_space(), *particles, step * dt );
+        // Final output and timings.
+        boundary_condition.profile( _profile );
+        final_output();
+    }
 
-            // Integrate - Yoshhida stage 1 update for velcoity
-            integrator->stageOneVel( *particles );
+    void run() { run( NoBoundaryCondition{} ); }
 
+    // Single drift-kick stage of the Yoshida step.
+    template <typename BoundaryType>
+    void runStage( const int step, const int stage,
+                   BoundaryType& boundary_condition )
+    {
+        // Heat transfer is advanced once per step, optionally concurrently
+        // with the drift and ghost update (which it does not depend on).
+        bool thermal_step = false;
+        if constexpr ( is_heat_transfer<
+                           typename force_model_type::thermal_type>::value )
+        {
+            thermal_step = stage == 0 && step % thermal_subcycle_steps == 0;
+            if ( thermal_step && _concurrent_heat_transfer )
+                startTemperature();
+        }
 
-		/******* Stage 2 *******/
+        // Integrate - Yoshida stage update for displacement.
+        stageDisplacement( boundary_condition, stage, _time );
 
-            // Integrate - Yoshhida stage 2 update for displacement
-            integrator->stageTwoDisplacement( *particles );
+        // Particles only change ranks once per step, after the first drift.
+        if ( stage == 0 )
+        {
+            if ( _rebalance_frequency > 0 && step % _rebalance_frequency == 0 )
+                rebalance();
+            else if ( _migration_distance > 0.0 )
+                migrate();
+        }
 
-            // Update ghost particles.
+        // Update ghost particles (only posted if overlapping with the force
+        // computation).
+        const bool overlap =
+            _overlap_comm && integrator->stageNeedsForce( stage );
+        if ( overlap )
+            comm->startGatherDisplacement();
+        else
             comm->gatherDisplacement();
 
-            if constexpr ( is_heat_transfer<
-                               typename force_model_type::thermal_type>::value )
-            {
-                if ( step % thermal_subcycle_steps == 0 )
-                    computeHeatTransfer( *heat_transfer, *particles,
-                                         neigh_iter_tag{},
-                                         thermal_subcycle_steps * dt );
-            }
+        if constexpr ( is_heat_transfer<
+                           typename force_model_type::thermal_type>::value )
+        {
+            if ( thermal_step && _concurrent_heat_transfer )
+                finishTemperature();
+            else if ( thermal_step )
+                updateTemperature();
+        }
 
-            // Add non-force boundary condition.
-            if ( !boundary_condition.forceUpdate() )
-                boundary_condition.apply( exec_space(), *particles, step * dt );
+        // Add non-force boundary condition (unless fused with the
+        // integrator).
+        if ( !fuseBoundaryCondition<BoundaryType>() )
+            applyBoundaryCondition( boundary_condition, exec_space(),
+                                    *particles, _time, false );
 
-            if constexpr ( is_temperature_dependent<
-                               typename force_model_type::thermal_type>::value )
-                comm->gatherTemperature();
+        if constexpr ( is_temperature_dependent<
+                           typename force_model_type::thermal_type>::value )
+            comm->gatherTemperature();
 
-            // Compute internal forces.
+        // No kick for this stage: skip the force evaluation.
+        if ( !integrator->stageNeedsForce( stage ) )
+            return;
+
+        // Compute internal forces. Bonds are only broken once per step, in
+        // the last stage which uses the force (with the conduction for the
+        // next step if requested, from the same temperatures).
+        const bool break_bonds = stage == integrator->lastForceStage();
+        if ( overlap )
+            updateForceOverlap( break_bonds );
+        else if ( break_bonds )
+            updateForce( false, fuseConduction( step ) );
+        else
             updateForceNoBreaking();
 
-	    
-            if constexpr ( is_contact<contact_model_type>::value )
+        // Subcycled contact is only added within the drifts.
+        if constexpr ( is_contact<contact_model_type>::value )
+        {
+            if ( !subcycle )
+            {
+                particles->updateGhostCurrentPositions();
                 computeForce( *contact, *particles, neigh_iter_tag{}, false );
+            }
+        }
 
-            // Add force boundary condition.
-            if ( boundary_condition.forceUpdate() )
-                boundary_condition.apply( exec_space(), *particles, step * dt );
-
-            // Integrate - Yoshhida stage 2 update for velcoity
-            integrator->stageTwoVel( *particles );	
-
-
-	
-		/******* Stage 3 *******/
-
-            // Integrate - Yoshhida stage 3 update for displacement
-            integrator->stageThreeDisplacement( *particles );
-
-            // Update ghost particles.
-            comm->gatherDisplacement();
+        // Add force boundary condition.
+        applyBoundaryCondition( boundary_condition, exec_space(), *particles,
+                                _time, true );
+
+        // Integrate - Yoshida stage update for velocity, optionally zeroing
+        // forces for the next stage (full neighbor lists only, since ghost
+        // forces are otherwise summed). Forces are kept after the last kick
+        // of monitored steps for the reaction forces.
+        const bool reset_force =
+            _fused_integration && !force->halfNeighbor() &&
+            !( break_bonds && monitoredStep( step ) );
+        integrator->stageVelocity( *particles, stage, reset_force );
+        _forces_zeroed = reset_force;
+    }
 
-            if constexpr ( is_heat_transfer<
-                               typename force_model_type::thermal_type>::value )
+    // Forces with bond breaking, optionally only checking the bonds of the
+    // active set (updated every active_bond_frequency evaluations).
+    void computeBreakingForce()
+    {
+        if constexpr ( force_type::has_active_bond_breaking )
+        {
+            if ( _active_bond_frequency > 0 )
             {
-                if ( step % thermal_subcycle_steps == 0 )
-                    computeHeatTransfer( *heat_transfer, *particles,
-                                         neigh_iter_tag{},
-                                         thermal_subcycle_steps * dt );
+                if ( _num_active_updates++ % _active_bond_frequency == 0 )
+                    force->updateActiveBonds( *particles,
+                                              _active_bond_threshold );
+                computeForceActiveBreaking( *force, *particles,
+                                            neigh_iter_tag{}, !_forces_zeroed );
+                return;
             }
+        }
+        computeForce( *force, *particles, neigh_iter_tag{}, !_forces_zeroed );
+    }
 
-            // Add non-force boundary condition.
-            if ( !boundary_condition.forceUpdate() )
-                boundary_condition.apply( exec_space(), *particles, step * dt );
-
-            if constexpr ( is_temperature_dependent<
-                               typename force_model_type::thermal_type>::value )
-                comm->gatherTemperature();
-
-            // Compute internal forces.
-            updateForceNoBreaking();
-
-	    
-
-            if constexpr ( is_contact<contact_model_type>::value )
-                computeForce( *contact, *particles, neigh_iter_tag{}, false );
-
-            // Add force boundary condition.
-            if ( boundary_condition.forceUpdate() )
-                boundary_condition.apply( exec_space(), *particles, step * dt );
-
-            // Integrate - Yoshhida stage 3 update for velcoity
-            integrator->stageThreeVel( *particles );
-
+    // Whether the non-force boundary conditions are applied within the
+    // integrator drift. Only boundary condition sets have per-particle
+    // operations, and heat transfer must be updated before they apply.
+    template <class BoundaryType>
+    bool fuseBoundaryCondition() const
+    {
+        if constexpr ( is_boundary_condition_set<BoundaryType>::value &&
+                       !is_heat_transfer<
+                           typename force_model_type::thermal_type>::value )
+            return _fused_integration;
+        else
+            return false;
+    }
 
+    // Yoshida drift, optionally fused with the non-force boundary conditions
+    // and the owned current positions used for contact.
+    template <class BoundaryType>
+    void stageDisplacement( BoundaryType& boundary_condition, const int stage,
+                            const double time )
+    {
+        // Subcycled with contact (the kicks then only use the PD forces).
+        if ( subcycle )
+        {
+            subcycleContact( integrator->driftCoefficient( stage ) *
+                             integrator->timeStep() );
+            return;
+        }
+        if ( !_fused_integration )
+        {
+            integrator->stageDisplacement( *particles, stage );
+            return;
+        }
 
-		/******* Stage 4 *******/
+        constexpr bool update_position = is_contact<contact_model_type>::value;
+        if constexpr ( is_boundary_condition_set<BoundaryType>::value &&
+                       !is_heat_transfer<
+                           typename force_model_type::thermal_type>::value )
+        {
+            integrator->stageDisplacement(
+                *particles, stage,
+                createFusedDriftOp(
+                    *particles, false,
+                    boundary_condition.getFusedOp( *particles, time ),
+                    update_position ) );
+            if constexpr ( BoundaryType::writes_fields )
+                particles->markModified();
+        }
+        else
+        {
+            integrator->stageDisplacement(
+                *particles, stage,
+                createFusedDriftOp( *particles, false, NoFusedOp{},
+                                    update_position ) );
+        }
+        if constexpr ( update_position )
+            particles->markLocalCurrentPositions();
+    }
 
-            // Integrate - Yoshhida stage 4 update for displacement
-            integrator->stageFourDisplacement( *particles );
+    // Compute and communicate fields needed for force computation and update
+    // forces. Energy and damage are computed in the same pass if requested
+    // (only needed on output steps); otherwise conduction may be.
+    void updateForce( const bool compute_energy = false,
+                      const bool compute_conduction = false )
+    {
+        // Compute weighted volume for LPS (does nothing for PMB). Only
+        // computed once without fracture.
+        if constexpr ( is_fracture<
+                           typename force_model_type::fracture_type>::value )
+            force->computeWeightedVolume( *particles, neigh_iter_tag{} );
+        // Compute dilatation for LPS (does nothing for PMB), which only needs
+        // the owned weighted volume.
+        force->computeDilatation( *particles, neigh_iter_tag{} );
+        // Communicate both in one message (only those which changed).
+        comm->gatherFields( WeightedVolumeField{}, DilatationField{} );
 
-            // Update ghost particles.
-            comm->gatherDisplacement();
+        // Compute internal forces.
+        if ( compute_energy )
+            _energy =
+                computeForceAndEnergy( *force, *particles, neigh_iter_tag{} );
+        else if ( compute_conduction )
+            updateForceAndConduction();
+        else
+            computeBreakingForce();
+        _forces_zeroed = false;
 
-            if constexpr ( is_heat_transfer<
-                               typename force_model_type::thermal_type>::value )
+        // Return ghost contributions to their owning ranks for half neighbor
+        // lists.
+        if ( force->halfNeighbor() )
+        {
+            comm->scatterForce();
+            if ( compute_energy )
             {
-                if ( step % thermal_subcycle_steps == 0 )
-                    computeHeatTransfer( *heat_transfer, *particles,
-                                         neigh_iter_tag{},
-                                         thermal_subcycle_steps * dt );
+                comm->scatterEnergy( *particles );
+                computeDamage( *force, *particles );
             }
+        }
+    }
 
-            // Add non-force boundary condition.
-            if ( !boundary_condition.forceUpdate() )
-                boundary_condition.apply( exec_space(), *particles, step * dt );
-
-            if constexpr ( is_temperature_dependent<
-                               typename force_model_type::thermal_type>::value )
-                comm->gatherTemperature();
-
-            // Compute internal forces. -- Break Bonds
-            updateForce();
-
-	    
-
-            if constexpr ( is_contact<contact_model_type>::value )
-                computeForce( *contact, *particles, neigh_iter_tag{}, false );
-
-            // Add force boundary condition.
-            if ( boundary_condition.forceUpdate() )
-                boundary_condition.apply( exec_space(), *particles, step * dt );
+    // Update forces for intermediate stages without breaking bonds. The
+    // weighted volume is unchanged since bonds are not broken.
+    void updateForceNoBreaking()
+    {
+        // Compute and communicate dilatation for LPS (does nothing for PMB).
+        force->computeDilatation( *particles, neigh_iter_tag{} );
+        comm->gatherDilatation();
 
-            // Integrate - Yoshhida stage 4 update for velcoity
-            integrator->stageFourVel( *particles );		
+        // Compute internal forces.
+        computeForceNoBreaking( *force, *particles, neigh_iter_tag{},
+                                !_forces_zeroed );
+        _forces_zeroed = false;
 
+        // Return ghost forces to their owning ranks for half neighbor lists.
+        if ( force->halfNeighbor() )
+            comm->scatterForce();
+    }
 
+    // Update forces, energy, and damage for output with the current bonds
+    // (bonds are only broken once per step, within the stages).
+    void updateForceAndEnergyNoBreaking()
+    {
+        // The weighted volume for LPS with fracture reflects bonds broken
+        // since the last update.
+        if constexpr ( is_fracture<
+                           typename force_model_type::fracture_type>::value )
+            force->computeWeightedVolume( *particles, neigh_iter_tag{} );
+        force->computeDilatation( *particles, neigh_iter_tag{} );
+        comm->gatherFields( WeightedVolumeField{}, DilatationField{} );
 
+        _energy = computeForceAndEnergyNoBreaking( *force, *particles,
+                                                   neigh_iter_tag{} );
+        _forces_zeroed = false;
 
-            output( step );
+        if ( force->halfNeighbor() )
+        {
+            comm->scatterForce();
+            comm->scatterEnergy( *particles );
+            computeDamage( *force, *particles );
         }
-
-        // Final output and timings.
-        final_output();
     }
 
-    void run()
+    // Update forces while ghost communication is in flight: particles without
+    // ghost neighbors are computed first, then the remaining boundary
+    // particles once each gather completes. The displacement gather must
+    // already be started.
+    void updateForceOverlap( const bool break_bonds )
     {
-        init_output();
-
-        // Main timestep loop.
-        for ( int step = 1; step <= num_steps; step++ )
+        const std::size_t begin = particles->frozenOffset();
+        const std::size_t interior = particles->interiorOffset();
+        const std::size_t end = particles->localOffset();
+
+        // Weighted volume for LPS with fracture only depends on bonds and
+        // reference positions (and is unchanged without breaking).
+        constexpr bool has_fracture =
+            is_fracture<typename force_model_type::fracture_type>::value;
+        if constexpr ( has_fracture )
         {
-            _step_timer.start();
-
-           /******* Stage 1 *******/
-
-            // Integrate - Yoshhida stage 1 update for displacement
-            integrator->stageOneDisplacement( *particles );
-
-            // Update ghost particles.
-            comm->gatherDisplacement();
-
-            // Compute internal forces.
-            updateForceNoBreaking();
-
-            if constexpr ( is_contact<contact_model_type>::value )
-                computeForce( *contact, *particles, neigh_iter_tag{}, false );
-
-            if constexpr ( is_temperature_dependent<
-                               typename force_model_type::thermal_type>::value )
-                comm->gatherTemperature();
-
-            // Integrate - Yoshhida stage 1 update for velcoity
-            integrator->stageOneVel( *particles );
-
-
-		/******* Stage 2 *******/
-
-            // Integrate - Yoshhida stage 2 update for displacement
-            integrator->stageTwoDisplacement( *particles );
-
-            // Update ghost particles.
-            comm->gatherDisplacement();
-
-            // Compute internal forces.
-            updateForceNoBreaking();
-
-            if constexpr ( is_contact<contact_model_type>::value )
-                computeForce( *contact, *particles, neigh_iter_tag{}, false );
-
-            if constexpr ( is_temperature_dependent<
-                               typename force_model_type::thermal_type>::value )
-                comm->gatherTemperature();
-
-            // Integrate - Yoshhida stage 2 update for velcoity
-            integrator->stageTwoVel( *particles );
-
-
-
-		/******* Stage 3 *******/
-
-            // Integrate - Yoshhida stage 3 update for displacement
-            integrator->stageThreeDisplacement( *particles );
-
-            // Update ghost particles.
-            comm->gatherDisplacement();
-
-            // Compute internal forces.
-            updateForceNoBreaking();
-
-            if constexpr ( is_contact<contact_model_type>::value )
-                computeForce( *contact, *particles, neigh_iter_tag{}, false );
-
-            if constexpr ( is_temperature_dependent<
-                               typename force_model_type::thermal_type>::value )
-                comm->gatherTemperature();
-
-            // Integrate - Yoshhida stage 3 update for velcoity
-            integrator->stageThreeVel( *particles );
-
-
-		/******* Stage 4 *******/
-
-            // Integrate - Yoshhida stage 4 update for displacement
-            integrator->stageFourDisplacement( *particles );
-
-            // Update ghost particles.
-            comm->gatherDisplacement();
-
-            // Compute internal forces. -- Break Bonds
-            updateForce();
-
-            if constexpr ( is_contact<contact_model_type>::value )
-                computeForce( *contact, *particles, neigh_iter_tag{}, false );
+            if ( break_bonds )
+            {
+                force->computeWeightedVolume( *particles, neigh_iter_tag{} );
+                comm->startGatherWeightedVolume();
+            }
+        }
 
-            if constexpr ( is_temperature_dependent<
-                               typename force_model_type::thermal_type>::value )
-                comm->gatherTemperature();
+        // Dilatation for LPS (does nothing for PMB).
+        force->setParticleRange( begin, interior );
+        force->computeDilatation( *particles, neigh_iter_tag{} );
+        comm->finishGatherDisplacement();
+        force->setParticleRange( interior, end );
+        force->computeDilatation( *particles, neigh_iter_tag{} );
+        comm->startGatherDilatation();
+
+        force->setParticleRange( begin, interior );
+        computeStageForce( break_bonds, !_forces_zeroed );
+        _forces_zeroed = false;
+        if constexpr ( has_fracture )
+            if ( break_bonds )
+                comm->finishGatherWeightedVolume();
+        comm->finishGatherDilatation();
+        force->setParticleRange( interior, end );
+        computeStageForce( break_bonds, false );
+        force->resetParticleRange();
+    }
 
-            // Integrate - Yoshhida stage 4 update for velcoity
-            integrator->stageFourVel( *particles );
+    // Forces for the current particle range, with or without checking bonds
+    // for breaking (all bonds are checked, without an active set).
+    void computeStageForce( const bool break_bonds, const bool reset )
+    {
+        if ( break_bonds )
+            computeForce( *force, *particles, neigh_iter_tag{}, reset );
+        else
+            computeForceNoBreaking( *force, *particles, neigh_iter_tag{},
+                                    reset );
+    }
 
+    // Whether to take another step: up to the final time with adaptive
+    // timesteps, otherwise the fixed number of steps.
+    bool continueStepping( const int step ) const
+    {
+        if ( _adaptive_timestep )
+            return _time < _final_time * ( 1.0 - 1e-12 );
+        return step <= num_steps;
+    }
 
-            output( step );
+    // Set the timestep and simulation time at the end of this step. Adaptive
+    // timesteps are updated periodically from the current state and never
+    // step past the final time.
+    void beginStep( const int step )
+    {
+        _last_step = step;
+        if ( !_adaptive_timestep )
+        {
+            _time = step * dt;
+            return;
         }
 
-        // Final output and timings.
-        final_output();
+        if ( ( step - _restart_step - 1 ) % _adaptive_frequency == 0 )
+            adaptTimeStep();
+        const double step_dt = std::min( dt, _final_time - _time );
+        integrator->setTimeStep( step_dt );
+        _time += step_dt;
     }
 
-    // Compute and communicate fields needed for force computation and update
-    // forces.
-    void updateForce()
+    // Estimate the stable timestep from the intact bonds, contact pairs, and
+    // velocities, limiting the growth from the current timestep.
+    void adaptTimeStep()
     {
-        // Compute and communicate weighted volume for LPS (does nothing for
-        // PMB). Only computed once without fracture.
-        if constexpr ( is_fracture<
-                           typename force_model_type::fracture_type>::value )
+        Kokkos::View<double*, memory_space> k( "stiffness",
+                                               particles->localOffset() );
+        addBondStiffness( *force, *particles, _micromodulus, k );
+        if constexpr ( is_contact<contact_model_type>::value )
+            addContactStiffness( k );
+        const double dt_stable =
+            _safety_factor *
+            estimateStableTimeStep( *particles, k, _max_distance );
+        const double dt_limit = std::min( _dt_max, _dt_growth * dt );
+        dt = std::clamp( dt_stable, _dt_min, std::max( _dt_min, dt_limit ) );
+        _num_timestep_updates++;
+    }
+
+    // Contact stiffness for the stable timestep, scaled if subcycled such
+    // that only the substeps are limited by contact.
+    template <class StiffnessType>
+    void addContactStiffness( const StiffnessType& k )
+    {
+        if ( !subcycle )
         {
-            force->computeWeightedVolume( *particles, neigh_iter_tag{} );
-            comm->gatherWeightedVolume();
+            contact->addStiffness( *particles, k );
+            return;
         }
-        // Compute and communicate dilatation for LPS (does nothing for PMB).
-        force->computeDilatation( *particles, neigh_iter_tag{} );
-        comm->gatherDilatation();
-
-        // Compute internal forces.
-        computeForce( *force, *particles, neigh_iter_tag{} );
+        StiffnessType k_contact( "contact_stiffness", k.extent( 0 ) );
+        contact->addStiffness( *particles, k_contact );
+        const double scale = subcycle->stiffnessScale();
+        Kokkos::RangePolicy<exec_space> policy( 0, k.extent( 0 ) );
+        Kokkos::parallel_for(
+            "CabanaPD::Solver::contactStiffness", policy,
+            KOKKOS_LAMBDA( const int i ) {
+                k( i ) += scale * k_contact( i );
+            } );
     }
 
+    // Output index of a step: by step with fixed timesteps, otherwise by
+    // simulation time.
+    int outputIndex( const int step ) const
+    {
+        if ( _adaptive_timestep )
+            return static_cast<int>( _time / _output_interval *
+                                     ( 1.0 + 1e-12 ) );
+        return step / output_frequency;
+    }
 
-	void updateForceNoBreaking()
-	    {
-		// Compute and communicate weighted volume for LPS (does nothing for
-		// PMB). Only computed once without fracture.
-		/*if constexpr ( is_fracture<
-		                   typename force_model_type::fracture_type>::value )
-		{
-		    force->computeWeightedVolume( *particles, neigh_iter_tag{} );
-		    comm->gatherWeightedVolume();
-		}
-		*/
-		// Compute and communicate dilatation for LPS (does nothing for PMB).
-		force->computeDilatation( *particles, neigh_iter_tag{} );
-		comm->gatherDilatation();
-
-		// Compute internal forces.
-		computeForce( *force, *particles, neigh_iter_tag{} );
-	    }
+    bool outputStep( const int step ) const
+    {
+        if ( _adaptive_timestep )
+            return outputIndex( step ) > _num_outputs;
+        return step % output_frequency == 0;
+    }
 
     void output( const int step )
     {
         // Print output.
-        if ( step % output_frequency == 0 )
+        _steps_since_output++;
+        if ( outputStep( step ) )
         {
-            auto W = computeEnergy( *force, *particles, neigh_iter_tag() );
-
-            particles->output( step / output_frequency, step * dt,
-                               output_reference );
+            _num_outputs = outputIndex( step );
+            particles->output( _num_outputs, _time, output_reference );
+            // The global energy is that of the previous output, such that
+            // its reduction overlaps with the steps in between. Only the
+            // first reduction is waited for, so the logged energy is always
+            // defined (and logged with the step it belongs to).
+            diagnostics->start( exec_space{}, *particles, step, _time );
+            if ( diagnostics->step() < 0 )
+                diagnostics->finish();
             _step_timer.stop();
-            step_output( step, W );
+            step_output( step, diagnostics->step(),
+                         diagnostics->strainEnergy() );
         }
         else
         {
+            diagnostics->test();
             _step_timer.stop();
         }
     }
 
-    void init_output( double boundary_init_time = 0.0 )
+    void init_output( double boundary_init_time = 0.0,
+                      MemoryRegistry memory = MemoryRegistry() )
     {
+        _num_outputs = outputIndex( _restart_step );
+        _steps_since_output = 0;
+
         // Output after construction and initial forces.
-        std::ofstream out( output_file, std::ofstream::app );
-        _init_time += _init_timer.time() + _neighbor_timer.time() +
-                      particles->timeInit() + comm->timeInit() +
-                      integrator->timeInit() + boundary_init_time;
+        auto& out = _out;
+        _init_time += inputs.timeInit() + _init_timer.time() +
+                      _neighbor_timer.time() + particles->timeInit() +
+                      comm->timeInit() + integrator->timeInit() +
+                      boundary_init_time;
         log( out, "Init-Time(s): ", _init_time );
+        // Startup breakdown.
+        log( out, "Init-Input-Time(s): ", inputs.timeInit() );
+        log( out, "Init-Domain-Time(s): ", particles->timeDomain() );
+        log( out, "Init-Particles-Time(s): ", particles->timeCreate() );
+        log( out, "Init-Halo-Time(s): ", comm->timeInit() );
+        comm->haloReport( out );
+        log( out, "Init-Prenotch-Time(s): ", _prenotch_time );
         log( out, "Init-Neighbor-Time(s): ", _neighbor_timer.time(), "\n" );
-        log( out, "#Timestep/Total-steps Simulation-time Total-strain-energy "
-                  "Step-Time(s) Force-Time(s) Comm-Time(s) Integrate-Time(s) "
+        memory_output( memory );
+        log( out, "#Timestep/Total-steps Simulation-time "
+                  "Strain-energy-step Strain-energy Step-Time(s) "
+                  "Force-Time(s) Comm-Time(s) Integrate-Time(s) "
                   "Energy-Time(s) Output-Time(s) Particle*steps/s" );
     }
 
-    void step_output( const int step, const double W )
+    // Per-rank memory of the major allocations, with the number of particles
+    // which would fit on one device (collective).
+    void memory_output( MemoryRegistry& memory )
+    {
+        particles->memory( memory );
+        comm->memory( memory );
+        force->neighborMemory( memory );
+        if constexpr ( is_fracture<
+                           typename force_model_type::fracture_type>::value )
+            force->bondMemory( memory );
+        if constexpr ( is_contact<contact_model_type>::value )
+            contact->memory( memory );
+
+        double device_bytes = inputs["device_memory"];
+        device_bytes *= 1024.0 * 1024.0 * 1024.0;
+        if ( device_bytes <= 0.0 )
+            device_bytes = deviceMemoryBytes<memory_space>();
+        memory.write( _out, particles->numLocal(), device_bytes );
+    }
+
+    void step_output( const int step, const int energy_step, const double W )
     {
         if ( print )
         {
-            std::ofstream out( output_file, std::ofstream::app );
+            auto& out = _out;
             log( std::cout, step, "/", num_steps, " ", std::scientific,
-                 std::setprecision( 2 ), step * dt );
+                 std::setprecision( 2 ), _time );
 
             double step_time = _step_timer.time();
             double comm_time = comm->time();
@@ -644,22 +1142,151 @@ class Solver
             double output_time = particles->timeOutput();
             _total_time += step_time;
             auto rate = static_cast<double>( particles->numGlobal() *
-                                             output_frequency / ( step_time ) );
+                                             _steps_since_output / step_time );
+            _steps_since_output = 0;
             _step_timer.reset();
             log( out, std::fixed, std::setprecision( 6 ), step, "/", num_steps,
-                 " ", std::scientific, std::setprecision( 2 ), step * dt, " ",
-                 W, " ", std::fixed, _total_time, " ", force_time, " ",
-                 comm_time, " ", integrate_time, " ", energy_time, " ",
-                 output_time, " ", std::scientific, rate );
-            out.close();
+                 " ", std::scientific, std::setprecision( 2 ), _time, " ",
+                 energy_step, " ", W, " ", std::fixed, _total_time, " ",
+                 force_time, " ", comm_time, " ", integrate_time, " ",
+                 energy_time, " ", output_time, " ", std::scientific, rate );
+        }
+    }
+
+    // Write the timing report for all registered regions (collective).
+    void profile_output()
+    {
+        if ( !_profile_output )
+            return;
+
+        _profile.add( "Solver::Init", _init_timer );
+        _profile.add( "Solver::Neighbor", _neighbor_timer );
+        particles->profile( _profile );
+        checkpoint->profile( _profile );
+        comm->profile( _profile );
+        integrator->profile( _profile );
+        force->profile( _profile );
+        if constexpr ( is_heat_transfer<
+                           typename force_model_type::thermal_type>::value )
+            heat_transfer->profile( _profile );
+        if constexpr ( is_contact<contact_model_type>::value )
+            contact->profile( _profile );
+        if ( subcycle )
+            subcycle->profile( _profile );
+        if ( _monitor_frequency > 0 )
+            monitors->profile( _profile );
+        diagnostics->profile( _profile );
+        _profile.write( inputs["profile_file"] );
+    }
+
+    bool monitoredStep( const int step ) const
+    {
+        return _monitor_frequency > 0 && step % _monitor_frequency == 0;
+    }
+
+    // Reduce and write the global monitors.
+    void monitorStep( const int step )
+    {
+        if ( !monitoredStep( step ) )
+            return;
+        monitors->compute( exec_space{}, *particles );
+        monitors->write( step, _time );
+    }
+
+    // Remove broken bonds from the neighbor list on output steps once enough
+    // are broken.
+    void compactBonds( const bool output_step )
+    {
+        if constexpr ( is_fracture<
+                           typename force_model_type::fracture_type>::value )
+        {
+            if ( _compaction_threshold <= 0.0 || !output_step )
+                return;
+            _neighbor_timer.start();
+            if ( force->compactBonds( *particles, _compaction_threshold ) )
+            {
+                _num_compactions++;
+                // The contact skin stores the bonds it excludes: rebuild it
+                // from the compacted neighbor list.
+                if constexpr ( is_contact<contact_model_type>::value )
+                {
+                    contact->resetNeighbors();
+                    if ( _contact_exclude_bonds )
+                        excludeContactBonds();
+                }
+            }
+            _neighbor_timer.stop();
+        }
+    }
+
+    // Start writing the full state; the write overlaps the following steps.
+    void checkpointStep( const int step )
+    {
+        if ( _checkpoint_frequency <= 0 || step % _checkpoint_frequency != 0 )
+        {
+            checkpoint->progress();
+            return;
+        }
+
+        using model_type = typename force_model_type::base_model;
+        if constexpr ( is_fracture<
+                           typename force_model_type::fracture_type>::value )
+            checkpoint->write( step, _time, model_type{}, *particles,
+                               force->getBrokenBonds() );
+        else
+            checkpoint->write( step, _time, model_type{}, *particles );
+    }
+
+    // Replace the initial state with a checkpoint. Broken bonds are reloaded
+    // such that prenotches are not recreated.
+    void restart()
+    {
+        using model_type = typename force_model_type::base_model;
+        double time;
+        if constexpr ( is_fracture<
+                           typename force_model_type::fracture_type>::value )
+        {
+            auto mu = force->getBrokenBonds();
+            checkpoint->read( _restart_file, _restart_step, time, model_type{},
+                              *particles, mu );
+        }
+        else
+        {
+            checkpoint->read( _restart_file, _restart_step, time, model_type{},
+                              *particles );
+        }
+
+        _time = time;
+        _last_step = _restart_step;
+        _num_outputs = outputIndex( _restart_step );
+
+        comm->gatherDisplacement();
+        if constexpr ( is_temperature_dependent<
+                           typename force_model_type::thermal_type>::value )
+            comm->gatherTemperature();
+        if constexpr ( is_contact<contact_model_type>::value )
+        {
+            contact->resetNeighbors();
+            if ( _contact_exclude_bonds )
+                excludeContactBonds();
+        }
+        if ( print )
+        {
+            auto& out = _out;
+            log( out, "Restarted from ", _restart_file, " at step ",
+                 _restart_step, ", time ", time );
         }
     }
 
     void final_output()
     {
+        checkpoint->finish();
+        diagnostics->finish();
+        particles->finishOutput();
+        profile_output();
         if ( print )
         {
-            std::ofstream out( output_file, std::ofstream::app );
+            auto& out = _out;
             double comm_time = comm->time();
             double integrate_time = integrator->time();
             double force_time = force->time();
@@ -669,7 +1296,8 @@ class Solver
             _total_time = _init_time + comm_time + integrate_time + force_time +
                           energy_time + output_time + particles->time();
 
-            double steps_per_sec = 1.0 * num_steps / _total_time;
+            double steps_per_sec =
+                1.0 * ( _last_step - _restart_step ) / _total_time;
             double p_steps_per_sec = particles->numGlobal() * steps_per_sec;
             log( out, std::fixed, std::setprecision( 2 ),
                  "\n#Procs Particles | Total Force Comm Integrate Energy "
@@ -686,27 +1314,294 @@ class Solver
                  "#Steps/s Particle-steps/s Particle-steps/proc/s\n",
                  std::scientific, steps_per_sec, " ", p_steps_per_sec, " ",
                  p_steps_per_sec / comm->mpi_size );
-            out.close();
+            log( out, "Global diagnostics (step ", diagnostics->step(),
+                 "): Strain-energy ", std::scientific,
+                 diagnostics->strainEnergy(), ", Kinetic-energy ",
+                 diagnostics->kineticEnergy(), ", Damaged-volume ",
+                 diagnostics->damagedVolume(), ", Max-damage ",
+                 diagnostics->maxDamage() );
+            if constexpr ( is_contact<contact_model_type>::value )
+                log( out, "Contact-Neighbor-Builds: ",
+                     contact->numNeighborBuilds(),
+                     ", Contact-Neighbor-Time(s): ", std::fixed,
+                     contact->timeNeighbor() );
+            if ( _migration_distance > 0.0 )
+                log( out, "Particle migrations: ", _num_migrations );
+            if ( _rebalance_frequency > 0 )
+                log( out, "Domain rebalances: ", _num_rebalances );
+            if ( _compaction_threshold > 0.0 )
+                log( out, "Broken bond compactions: ", _num_compactions );
+            if ( _adaptive_timestep )
+                log( out, "Steps: ", _last_step - _restart_step,
+                     ", Timestep updates: ", _num_timestep_updates,
+                     ", Final timestep: ", std::scientific, dt );
+            out.flush();
         }
     }
 
+    // Monitor the reaction force within a region (with monitor_frequency).
+    void addReactionRegion( const RegionBoundary<RectangularPrism>& region )
+    {
+        monitors->addReactionRegion( region );
+    }
+
     int num_steps;
     int output_frequency;
     bool output_reference;
     double dt;
     int thermal_subcycle_steps;
+    // RKL2 super-time-stepping stages (forward Euler if zero).
+    int thermal_stages = 0;
 
   protected:
-    template <std::size_t NumPrenotch>
-    void init_prenotch( Prenotch<NumPrenotch> prenotch )
+    // Heat transfer on a separate execution space instance.
+    bool _concurrent_heat_transfer = false;
+
+    // Launch one thermal step on the heat transfer instance once prior work
+    // on the default instance (temperature boundary conditions, ghost
+    // temperatures, and broken bonds) is complete. The mechanics may then
+    // proceed until the temperature is needed (finishTemperature).
+    void startTemperature()
+    {
+        exec_space().fence();
+        updateTemperature();
+    }
+    void finishTemperature() { heat_transfer->executionSpace().fence(); }
+
+    // Advance temperature by one thermal step.
+    void updateTemperature()
+    {
+        const double dt_thermal = thermal_subcycle_steps * dt;
+        if ( thermal_stages > 0 )
+            computeHeatTransferRKL2( *heat_transfer, *particles,
+                                     neigh_iter_tag{}, dt_thermal,
+                                     thermal_stages,
+                                     [&]() { comm->gatherTemperature(); } );
+        else if ( _conduction_ready )
+            heat_transfer->forwardEuler( *particles, dt_thermal );
+        else
+            computeHeatTransfer( *heat_transfer, *particles, neigh_iter_tag{},
+                                 dt_thermal );
+        _conduction_ready = false;
+    }
+
+    // Heat transfer conduction computed within the force kernel which
+    // precedes each thermal step (the temperature is unchanged in between).
+    bool _fused_conduction = false;
+    bool _conduction_ready = false;
+
+    // Whether the forces for this step also compute the conduction for the
+    // next, which must then be a thermal step.
+    bool fuseConduction( const int step ) const
+    {
+        return _fused_conduction && ( step + 1 ) % thermal_subcycle_steps == 0;
+    }
+
+    void updateForceAndConduction()
+    {
+        if constexpr ( is_heat_transfer<
+                           typename force_model_type::thermal_type>::value )
+        {
+            computeForceAndConduction( *force, *heat_transfer, *particles,
+                                       neigh_iter_tag{}, !_forces_zeroed );
+            _conduction_ready = true;
+        }
+    }
+
+    // Strain energy from the most recent output step force computation.
+    double _energy = 0.0;
+    // Overlap ghost communication with interior force computation.
+    bool _overlap_comm = false;
+    // Simulation time at the end of the current step.
+    double _time = 0.0;
+    int _last_step = 0;
+    // Timestep adapted to a runtime stability estimate: bounds, maximum
+    // growth per update, and maximum distance moved per step.
+    bool _adaptive_timestep = false;
+    int _adaptive_frequency = 1;
+    double _dt_min = 0.0;
+    double _dt_max = 0.0;
+    double _dt_growth = 1.0;
+    double _max_distance = 0.0;
+    double _micromodulus = 0.0;
+    double _safety_factor = 1.0;
+    double _final_time = 0.0;
+    int _num_timestep_updates = 0;
+    // Output every output_time_interval with adaptive timesteps.
+    double _output_interval = 0.0;
+    int _num_outputs = 0;
+    int _steps_since_output = 0;
+
+    // Skip contact between particles with an intact bond.
+    bool _contact_exclude_bonds = false;
+
+    // Particles migrate once any has moved half this skin distance.
+    double _migration_distance = 0.0;
+    double _ghost_cutoff = 0.0;
+    double _contact_ghost_cutoff = 0.0;
+    int _num_migrations = 0;
+    // Steps between repartitioning the domain by bonds per rank.
+    int _rebalance_frequency = 0;
+    int _num_rebalances = 0;
+
+    // Rebuild (sorted) neighbors for the current broken bonds.
+    void rebuildNeighbors()
+    {
+        if constexpr ( is_fracture<
+                           typename force_model_type::fracture_type>::value )
+            force->rebuildNeighbors( *particles, force->getBrokenBonds() );
+        else
+            force->rebuildNeighbors( *particles );
+    }
+
+    // Move particles to the rank owning their current position and rebuild
+    // ghosts and neighbors if any particle may have moved far enough to
+    // invalidate them.
+    void migrate()
+    {
+        if ( comm->maxDisplacementSinceMigration( *particles ) <=
+             0.5 * _migration_distance )
+            return;
+
+        auto distributor = comm->createDistributor( *particles );
+        redistribute( distributor );
+        _num_migrations++;
+    }
+
+    // Repartition the domain such that each rank holds a similar number of
+    // bonds and move all particles to their new owning rank.
+    void rebalance()
+    {
+        particles->rebalance( force->getLoadWeights( *particles ) );
+        auto distributor = comm->createRebalanceDistributor( *particles );
+        redistribute( distributor );
+        _num_rebalances++;
+    }
+
+    // Move particles (and broken bonds) with the given plan and rebuild
+    // ghosts, neighbors, and derived quantities.
+    template <class DistributorType>
+    void redistribute( const DistributorType& distributor )
+    {
+        _neighbor_timer.start();
+        // CSR broken bonds have no fixed rows to migrate (rejected in setup).
+        if constexpr ( is_csr_storage<BondStorageType>::value )
+        {
+            throw std::runtime_error( "Particle migration is not supported "
+                                      "with CSR bond storage." );
+        }
+        else if constexpr ( is_fracture<typename force_model_type::
+                                            fracture_type>::value )
+        {
+            auto mu = force->getBrokenBonds();
+            auto migrated = comm->migrateRows( distributor, mu.view() );
+            particles->migrate( distributor );
+            comm->rebuildHalo( *particles, _ghost_cutoff,
+                               _contact_ghost_cutoff );
+            force->rebuildNeighbors( *particles, decltype( mu )( migrated ) );
+        }
+        else
+        {
+            particles->migrate( distributor );
+            comm->rebuildHalo( *particles, _ghost_cutoff,
+                               _contact_ghost_cutoff );
+            rebuildNeighbors();
+        }
+        _neighbor_timer.stop();
+
+        // Weighted volume for LPS is only otherwise computed once without
+        // fracture.
+        force->computeWeightedVolume( *particles, neigh_iter_tag{} );
+        comm->gatherWeightedVolume();
+        comm->resetMigrationReference( *particles );
+        if constexpr ( is_contact<contact_model_type>::value )
+        {
+            contact->resetNeighbors();
+            // Neighbors and broken bonds have been replaced.
+            if ( _contact_exclude_bonds )
+                excludeContactBonds();
+        }
+    }
+
+    // Fuse per-particle work into the integrator stages, where forces may be
+    // zeroed ahead of the next force computation.
+    bool _fused_integration = false;
+    bool _forces_zeroed = false;
+
+    // Replace a drift of length tau by velocity Verlet substeps with the
+    // (separately stored) contact forces. Ghost displacements are updated
+    // for every contact evaluation.
+    void subcycleContact( const double tau )
+    {
+        if constexpr ( is_contact<contact_model_type>::value )
+        {
+            const double h = tau / subcycle->numSubsteps();
+            for ( int k = 0; k < subcycle->numSubsteps(); k++ )
+            {
+                subcycle->kick( *particles, 0.5 * h );
+                subcycle->drift( *particles, h );
+                comm->gatherDisplacement();
+                updateSubcycleContact();
+                subcycle->kick( *particles, 0.5 * h );
+            }
+        }
+    }
+
+    void updateSubcycleContact()
+    {
+        if constexpr ( is_contact<contact_model_type>::value )
+        {
+            particles->updateGhostCurrentPositions();
+            auto fc = subcycle->resetContactForce( *particles );
+            auto x = particles->sliceReferencePosition();
+            auto u = particles->sliceDisplacement();
+            neigh_iter_tag neigh_op_tag;
+            // Only atomic if using team threading.
+            if constexpr ( is_team_op<neigh_iter_tag>::value )
+            {
+                Kokkos::View<double* [3], memory_space,
+                             Kokkos::MemoryTraits<Kokkos::Atomic>>
+                    fc_a = fc;
+                contact->computeForceFull( fc_a, x, u, *particles,
+                                           neigh_op_tag );
+            }
+            else
+            {
+                contact->computeForceFull( fc, x, u, *particles,
+                                           neigh_op_tag );
+            }
+        }
+    }
+
+    void excludeContactBonds()
+    {
+        if constexpr ( is_contact<contact_model_type>::value )
+        {
+            using fracture_type = typename force_model_type::fracture_type;
+            if constexpr ( is_fracture<fracture_type>::value )
+                contact->excludeBonds( force->getNeighbors(),
+                                       force->getBrokenBonds() );
+            else
+                contact->excludeBonds( force->getNeighbors() );
+        }
+    }
+
+    template <class PrenotchType>
+    void init_prenotch( PrenotchType& prenotch )
     {
         static_assert(
             is_fracture<typename force_model_type::fracture_type>::value,
             "Cannot create prenotch in system without fracture." );
+        static_assert( particle_type::dim == 3, "Prenotch requires 3d." );
+
+        // Prenotched bonds are reloaded with the other broken bonds.
+        if ( !_restart_file.empty() )
+            return;
 
         // Create prenotch.
         force->prenotch( exec_space{}, *particles, prenotch );
-        _init_time += prenotch.time();
+        _prenotch_time = prenotch.time();
+        _init_time += _prenotch_time;
     }
 
     // Core modules.
@@ -718,38 +1613,68 @@ class Solver
     // Optional modules.
     std::shared_ptr<heat_transfer_type> heat_transfer;
     std::shared_ptr<contact_type> contact;
+    // Multirate contact integration (only if subcycled).
+    std::shared_ptr<subcycle_type> subcycle;
+    std::shared_ptr<Checkpoint> checkpoint;
+    int _checkpoint_frequency = 0;
+    std::shared_ptr<monitors_type> monitors;
+    int _monitor_frequency = 0;
+    std::shared_ptr<diagnostics_type> diagnostics;
+    // Fraction of broken bonds which triggers compaction (disabled if zero).
+    double _compaction_threshold = 0.0;
+    int _num_compactions = 0;
+    // Bond breaking force evaluations between active set updates (all bonds
+    // checked if zero) and the fraction of the critical stretch included.
+    int _active_bond_frequency = 0;
+    double _active_bond_threshold = 0.5;
+    int _num_active_updates = 0;
+    // Checkpoint to restart from (if any) and its step.
+    std::string _restart_file;
+    int _restart_step = 0;
 
     // Output files.
     std::string output_file;
     std::string error_file;
+    std::ofstream _out;
 
     // Note: init_time is combined from many class timers.
     double _init_time;
-    Timer _init_timer;
-    Timer _neighbor_timer;
+    double _prenotch_time = 0.0;
+    Timer _init_timer = Timer( "Solver::Init" );
+    Timer _neighbor_timer = Timer( "Solver::Neighbor" );
     Timer _step_timer;
+    bool _profile_output = false;
+    TimerRegistry _profile;
     double _total_time;
     bool print;
 };
 
-template <class MemorySpace, class InputsType, class ParticleType,
-          class ForceModelType>
+// Broken bond storage and bond caches are selected at compile time, e.g.
+// createSolver<memory_space, Cabana::SerialOpTag, CSRBondStorage>( ... ).
+template <class MemorySpace, class NeighIterTag = Cabana::SerialOpTag,
+          class BondStorageType = BitBondStorage,
+          class BondCacheType = NoBondCache, class InputsType,
+          class ParticleType, class ForceModelType>
 auto createSolver( InputsType inputs, std::shared_ptr<ParticleType> particles,
                    ForceModelType model )
 {
     return std::make_shared<
-        Solver<MemorySpace, InputsType, ParticleType, ForceModelType>>(
+        Solver<MemorySpace, InputsType, ParticleType, ForceModelType,
+               NoContact, NeighIterTag, BondStorageType, BondCacheType>>(
         inputs, particles, model );
 }
 
-template <class MemorySpace, class InputsType, class ParticleType,
-          class ForceModelType, class ContactModelType>
+template <class MemorySpace, class NeighIterTag = Cabana::SerialOpTag,
+          class BondStorageType = BitBondStorage,
+          class BondCacheType = NoBondCache, class InputsType,
+          class ParticleType, class ForceModelType, class ContactModelType>
 auto createSolver( InputsType inputs, std::shared_ptr<ParticleType> particles,
                    ForceModelType model, ContactModelType contact_model )
 {
-    return std::make_shared<Solver<MemorySpace, InputsType, ParticleType,
-                                   ForceModelType, ContactModelType>>(
-        inputs, particles, model, contact_model );
+    return std::make_shared<
+        Solver<MemorySpace, InputsType, ParticleType, ForceModelType,
+               ContactModelType, NeighIterTag, BondStorageType,
+               BondCacheType>>( inputs, particles, model, contact_model );
 }
 
 } // namespace CabanaPD
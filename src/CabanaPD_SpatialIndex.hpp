@@ -0,0 +1,365 @@
+/****************************************************************************
+ * Copyright (c) 2022 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of CabanaPD. CabanaPD is distributed under a           *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include <Kokkos_Core.hpp>
+
+#include <Cabana_Core.hpp>
+
+#include <CabanaPD_Memory.hpp>
+#include <CabanaPD_Timer.hpp>
+
+namespace CabanaPD
+{
+/******************************************************************************
+  Shared spatial index.
+
+  A single Cabana::LinkedCellList over all particles (owned and ghosted),
+  owned by the particles and queried by each full neighbor list (PD bonds on
+  reference positions, contact on current positions). The cell size is the
+  largest cutoff requested so far, such that every query only needs the
+  surrounding cells.
+
+  Before each query the binned cell of every particle is checked against the
+  given positions. Particles which left their cell are kept in a short moved
+  list (searched by every row) instead of re-sorting all particles; the
+  particles are only re-binned once the moved list exceeds the typical
+  number of particles in the surrounding cells, or the particle count, bounds
+  or cell size change.
+******************************************************************************/
+template <class MemorySpace>
+class SpatialIndex
+{
+  public:
+    using memory_space = MemorySpace;
+    using exec_space = typename memory_space::execution_space;
+    using cell_list_type = Cabana::LinkedCellList<memory_space>;
+
+  protected:
+    cell_list_type _cell_list;
+    bool _built = false;
+    std::size_t _num_particles = 0;
+    double _cell_size = 0.0;
+    Kokkos::Array<double, 3> _low;
+    Kokkos::Array<double, 3> _high;
+    Kokkos::Array<double, 3> _dx;
+    Kokkos::Array<int, 3> _num_bins;
+
+    // Binned cell of each particle and the current cell of moved particles
+    // (-1 otherwise).
+    Kokkos::View<int*, memory_space> _bins;
+    Kokkos::View<int*, memory_space> _moved_cell;
+    Kokkos::View<int*, memory_space> _moved;
+    int _num_moved = 0;
+
+    int _num_builds = 0;
+    int _num_updates = 0;
+    Timer _timer = Timer( "SpatialIndex" );
+
+  public:
+    SpatialIndex() = default;
+
+    // Full (Verlet layout 2D) neighbor list of the particles in [begin, end)
+    // within cutoff, binning all particles in positions as needed.
+    template <class NeighborListType, class PositionType>
+    void neighbors( NeighborListType& neigh_list, const PositionType& x,
+                    const std::size_t begin, const std::size_t end,
+                    const double cutoff, const double mesh_min[3],
+                    const double mesh_max[3] )
+    {
+        _timer.start();
+        update( x, cutoff, mesh_min, mesh_max );
+        query( neigh_list, x, begin, end, cutoff );
+        _timer.stop();
+    }
+
+    auto numBuilds() const { return _num_builds; }
+    auto numUpdates() const { return _num_updates; }
+    auto numMoved() const { return _num_moved; }
+    auto cellSize() const { return _cell_size; }
+    auto time() { return _timer.time(); };
+    const Timer& getTimer() const { return _timer; }
+
+    // Allocated bytes: the cell list permutation and per-bin counts and
+    // offsets (internal to Cabana, from their sizes) and the moved lists.
+    double bytes() const
+    {
+        double cell_list_bytes = 0.0;
+        if ( _built )
+            cell_list_bytes =
+                static_cast<double>( _num_particles +
+                                     2 * _cell_list.totalBins() ) *
+                sizeof( int );
+        return cell_list_bytes + viewBytes( _bins ) + viewBytes( _moved_cell ) +
+               viewBytes( _moved );
+    }
+
+  protected:
+    template <class PositionType>
+    void update( const PositionType& x, const double cutoff,
+                 const double mesh_min[3], const double mesh_max[3] )
+    {
+        bool rebuild = !_built || x.size() != _num_particles ||
+                       cutoff > _cell_size;
+        for ( int d = 0; d < 3; d++ )
+            rebuild = rebuild || mesh_min[d] != _low[d] ||
+                      mesh_max[d] != _high[d];
+        if ( !rebuild )
+            rebuild = !findMoved( x );
+        if ( rebuild )
+            build( x, std::max( cutoff, _cell_size ), mesh_min, mesh_max );
+        else
+            _num_updates++;
+    }
+
+    template <class PositionType>
+    void build( const PositionType& x, const double cell_size,
+                const double mesh_min[3], const double mesh_max[3] )
+    {
+        _num_particles = x.size();
+        _cell_size = cell_size;
+        double delta[3] = { cell_size, cell_size, cell_size };
+        for ( int d = 0; d < 3; d++ )
+        {
+            _low[d] = mesh_min[d];
+            _high[d] = mesh_max[d];
+        }
+        double low[3] = { _low[0], _low[1], _low[2] };
+        double high[3] = { _high[0], _high[1], _high[2] };
+        _cell_list = cell_list_type( x, 0, _num_particles, delta, low, high );
+        for ( int d = 0; d < 3; d++ )
+        {
+            _num_bins[d] = _cell_list.numBin( d );
+            _dx[d] = ( _high[d] - _low[d] ) / _num_bins[d];
+        }
+
+        // Store the cell of each particle.
+        Kokkos::realloc( Kokkos::WithoutInitializing, _bins, _num_particles );
+        Kokkos::realloc( _moved_cell, _num_particles );
+        Kokkos::deep_copy( _moved_cell, -1 );
+        _num_moved = 0;
+        auto bins = _bins;
+        auto cell_list = _cell_list;
+        Kokkos::RangePolicy<exec_space> policy( 0, _cell_list.totalBins() );
+        Kokkos::parallel_for(
+            "CabanaPD::SpatialIndex::storeBins", policy,
+            KOKKOS_LAMBDA( const int c ) {
+                int i, j, k;
+                cell_list.ijkBinIndex( c, i, j, k );
+                const auto offset = cell_list.binOffset( i, j, k );
+                const auto size = cell_list.binSize( i, j, k );
+                for ( std::size_t b = offset; b < offset + size; b++ )
+                    bins( cell_list.permutation( b ) ) = c;
+            } );
+        Kokkos::fence();
+        _built = true;
+        _num_builds++;
+    }
+
+    // Cell of a position (clamped to the edge cells).
+    template <class PositionType>
+    static KOKKOS_INLINE_FUNCTION int
+    locate( const cell_list_type& cell_list, const PositionType& x,
+            const int p, const Kokkos::Array<double, 3>& low,
+            const Kokkos::Array<double, 3>& dx,
+            const Kokkos::Array<int, 3>& num_bins )
+    {
+        int c[3];
+        for ( int d = 0; d < 3; d++ )
+        {
+            c[d] = static_cast<int>(
+                Kokkos::floor( ( x( p, d ) - low[d] ) / dx[d] ) );
+            c[d] = Kokkos::min( Kokkos::max( c[d], 0 ), num_bins[d] - 1 );
+        }
+        return cell_list.cardinalBinIndex( c[0], c[1], c[2] );
+    }
+
+    // Collect the particles no longer in their binned cell. Returns false if
+    // there are too many to search for every row.
+    template <class PositionType>
+    bool findMoved( const PositionType& x )
+    {
+        auto cell_list = _cell_list;
+        auto bins = _bins;
+        auto moved_cell = _moved_cell;
+        auto low = _low;
+        auto dx = _dx;
+        auto num_bins = _num_bins;
+        Kokkos::RangePolicy<exec_space> policy( 0, _num_particles );
+        int num_moved = 0;
+        Kokkos::parallel_reduce(
+            "CabanaPD::SpatialIndex::findMoved", policy,
+            KOKKOS_LAMBDA( const int p, int& count ) {
+                const int cell = locate( cell_list, x, p, low, dx, num_bins );
+                moved_cell( p ) = cell == bins( p ) ? -1 : cell;
+                if ( cell != bins( p ) )
+                    count++;
+            },
+            num_moved );
+
+        const std::size_t total_bins = _cell_list.totalBins();
+        const std::size_t max_moved =
+            27 * ( _num_particles + total_bins - 1 ) / total_bins;
+        if ( static_cast<std::size_t>( num_moved ) > max_moved )
+            return false;
+
+        Kokkos::realloc( Kokkos::WithoutInitializing, _moved, num_moved );
+        auto moved = _moved;
+        Kokkos::parallel_scan(
+            "CabanaPD::SpatialIndex::movedList", policy,
+            KOKKOS_LAMBDA( const int p, int& offset, const bool final ) {
+                if ( moved_cell( p ) < 0 )
+                    return;
+                if ( final )
+                    moved( offset ) = p;
+                offset++;
+            } );
+        Kokkos::fence();
+        _num_moved = num_moved;
+        return true;
+    }
+
+    // Visit the neighbors of row i within the cutoff, returning the count.
+    template <class PositionType>
+    struct NeighborVisitor
+    {
+        cell_list_type cell_list;
+        Kokkos::View<int*, memory_space> bins;
+        Kokkos::View<int*, memory_space> moved_cell;
+        Kokkos::View<int*, memory_space> moved;
+        int num_moved;
+        Kokkos::Array<int, 3> num_bins;
+        Kokkos::Array<int, 3> reach;
+        PositionType x;
+        double cutoff2;
+
+        KOKKOS_INLINE_FUNCTION bool within( const int i, const int j ) const
+        {
+            double r2 = 0.0;
+            for ( int d = 0; d < 3; d++ )
+                r2 += ( x( j, d ) - x( i, d ) ) * ( x( j, d ) - x( i, d ) );
+            return r2 <= cutoff2;
+        }
+
+        template <class StoreType>
+        KOKKOS_INLINE_FUNCTION int operator()( const int i,
+                                               const StoreType& store ) const
+        {
+            const int cell = moved_cell( i ) < 0 ? bins( i ) : moved_cell( i );
+            int ci[3];
+            cell_list.ijkBinIndex( cell, ci[0], ci[1], ci[2] );
+            int lo[3];
+            int hi[3];
+            for ( int d = 0; d < 3; d++ )
+            {
+                lo[d] = Kokkos::max( ci[d] - reach[d], 0 );
+                hi[d] = Kokkos::min( ci[d] + reach[d], num_bins[d] - 1 );
+            }
+
+            int count = 0;
+            for ( int a = lo[0]; a <= hi[0]; a++ )
+                for ( int b = lo[1]; b <= hi[1]; b++ )
+                    for ( int c = lo[2]; c <= hi[2]; c++ )
+                    {
+                        const std::size_t offset =
+                            cell_list.binOffset( a, b, c );
+                        const std::size_t size = cell_list.binSize( a, b, c );
+                        for ( std::size_t n = offset; n < offset + size; n++ )
+                        {
+                            const int j = cell_list.permutation( n );
+                            if ( j != i && moved_cell( j ) < 0 &&
+                                 within( i, j ) )
+                                store( count++, j );
+                        }
+                    }
+            for ( int m = 0; m < num_moved; m++ )
+            {
+                const int j = moved( m );
+                int cj[3];
+                cell_list.ijkBinIndex( moved_cell( j ), cj[0], cj[1], cj[2] );
+                bool near = j != i;
+                for ( int d = 0; d < 3; d++ )
+                    near = near && cj[d] >= lo[d] && cj[d] <= hi[d];
+                if ( near && within( i, j ) )
+                    store( count++, j );
+            }
+            return count;
+        }
+    };
+
+    struct CountOnly
+    {
+        KOKKOS_INLINE_FUNCTION void operator()( const int, const int ) const {}
+    };
+
+    template <class NeighborView>
+    struct StoreNeighbor
+    {
+        NeighborView neighbors;
+        int i;
+
+        KOKKOS_INLINE_FUNCTION void operator()( const int n,
+                                                const int j ) const
+        {
+            neighbors( i, n ) = j;
+        }
+    };
+
+    template <class NeighborListType, class PositionType>
+    void query( NeighborListType& neigh_list, const PositionType& x,
+                const std::size_t begin, const std::size_t end,
+                const double cutoff )
+    {
+        Kokkos::Array<int, 3> reach;
+        for ( int d = 0; d < 3; d++ )
+            reach[d] = std::max(
+                1, static_cast<int>( std::ceil( cutoff / _dx[d] ) ) );
+        NeighborVisitor<PositionType> visit{
+            _cell_list, _bins, _moved_cell, _moved,         _num_moved,
+            _num_bins,  reach, x,           cutoff * cutoff };
+
+        using count_view = decltype( neigh_list._data.counts );
+        using neighbor_view = decltype( neigh_list._data.neighbors );
+        count_view counts( "neighbor_counts", _num_particles );
+        Kokkos::RangePolicy<exec_space> policy( begin, end );
+        int max_neighbors = 0;
+        Kokkos::parallel_reduce(
+            "CabanaPD::SpatialIndex::countNeighbors", policy,
+            KOKKOS_LAMBDA( const int i, int& max_n ) {
+                counts( i ) = visit( i, CountOnly{} );
+                if ( static_cast<int>( counts( i ) ) > max_n )
+                    max_n = counts( i );
+            },
+            Kokkos::Max<int>( max_neighbors ) );
+
+        neighbor_view neighbors(
+            Kokkos::ViewAllocateWithoutInitializing( "neighbors" ),
+            _num_particles, max_neighbors );
+        Kokkos::parallel_for(
+            "CabanaPD::SpatialIndex::fillNeighbors", policy,
+            KOKKOS_LAMBDA( const int i ) {
+                visit( i, StoreNeighbor<neighbor_view>{ neighbors, i } );
+            } );
+        Kokkos::fence();
+        neigh_list._data.counts = counts;
+        neigh_list._data.neighbors = neighbors;
+    }
+};
+
+} // namespace CabanaPD
+
+#endif
@@ -0,0 +1,136 @@
+/****************************************************************************
+ * Copyright (c) 2022 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of CabanaPD. CabanaPD is distributed under a           *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#ifndef TIMESTEP_H
+#define TIMESTEP_H
+
+#include <limits>
+#include <stdexcept>
+
+#include <mpi.h>
+
+#include <Cabana_Core.hpp>
+#include <Kokkos_Core.hpp>
+
+#include <CabanaPD_Force.hpp>
+
+namespace CabanaPD
+{
+/******************************************************************************
+  Runtime stable timestep estimate.
+
+  The stable timestep of each particle is estimated as in
+  Inputs::computeCriticalTimeStep, sqrt( 2 rho / k ), but with the stiffness
+  k summed over the current intact bonds and contact pairs of the particle
+  rather than a full bulk neighborhood. The timestep is further limited such
+  that no particle moves more than a given distance per step.
+******************************************************************************/
+
+// Add the stiffness of the intact bonds of each owned particle, for a bond
+// micromodulus c.
+template <class ForceType, class ParticleType, class StiffnessType>
+void addBondStiffness( const ForceType& force, const ParticleType& particles,
+                       const double c, const StiffnessType& k )
+{
+    if ( force.halfNeighbor() )
+        throw std::runtime_error( "Stable timestep estimates are not "
+                                  "supported with half neighbor lists." );
+
+    using neighbor_list_type = typename ForceType::neighbor_list_type;
+    using memory_space = typename ParticleType::memory_space;
+    using exec_space = typename memory_space::execution_space;
+
+    auto neigh_list = force.getNeighbors();
+    auto x = particles.sliceReferencePosition();
+    auto u = particles.sliceDisplacement();
+    auto vol = particles.sliceVolume();
+    Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
+                                            particles.localOffset() );
+
+    if constexpr ( ForceType::has_bond_breaking )
+    {
+        auto mu = force.getBrokenBonds();
+        Kokkos::parallel_for(
+            "CabanaPD::TimeStep::bondStiffness", policy,
+            KOKKOS_LAMBDA( const int i ) {
+                std::size_t num_neighbors =
+                    Cabana::NeighborList<neighbor_list_type>::numNeighbor(
+                        neigh_list, i );
+                for ( std::size_t n = 0; n < num_neighbors; n++ )
+                {
+                    const int j =
+                        Cabana::NeighborList<neighbor_list_type>::getNeighbor(
+                            neigh_list, i, n );
+                    double xi, r, s;
+                    getDistance( x, u, i, j, xi, r, s );
+                    k( i ) += mu( i, n ) * c * vol( j ) / xi;
+                }
+            } );
+    }
+    else
+    {
+        Kokkos::parallel_for(
+            "CabanaPD::TimeStep::bondStiffness", policy,
+            KOKKOS_LAMBDA( const int i ) {
+                std::size_t num_neighbors =
+                    Cabana::NeighborList<neighbor_list_type>::numNeighbor(
+                        neigh_list, i );
+                for ( std::size_t n = 0; n < num_neighbors; n++ )
+                {
+                    const int j =
+                        Cabana::NeighborList<neighbor_list_type>::getNeighbor(
+                            neigh_list, i, n );
+                    double xi, r, s;
+                    getDistance( x, u, i, j, xi, r, s );
+                    k( i ) += c * vol( j ) / xi;
+                }
+            } );
+    }
+}
+
+// Global minimum stable timestep of the owned particles given their
+// stiffness, such that no particle moves further than max_distance per step.
+template <class ParticleType, class StiffnessType>
+double estimateStableTimeStep( const ParticleType& particles,
+                               const StiffnessType& k,
+                               const double max_distance )
+{
+    using memory_space = typename ParticleType::memory_space;
+    using exec_space = typename memory_space::execution_space;
+
+    auto rho = particles.sliceDensity();
+    auto v = particles.sliceVelocity();
+    Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
+                                            particles.localOffset() );
+    double dt_local = std::numeric_limits<double>::max();
+    Kokkos::parallel_reduce(
+        "CabanaPD::TimeStep::estimate", policy,
+        KOKKOS_LAMBDA( const int i, double& dt_min ) {
+            if ( k( i ) > 0.0 )
+                dt_min = Kokkos::min( dt_min,
+                                      Kokkos::sqrt( 2.0 * rho( i ) / k( i ) ) );
+            const double speed = Kokkos::sqrt(
+                v( i, 0 ) * v( i, 0 ) + v( i, 1 ) * v( i, 1 ) +
+                component<2>( v, i ) * component<2>( v, i ) );
+            if ( speed > 0.0 )
+                dt_min = Kokkos::min( dt_min, max_distance / speed );
+        },
+        Kokkos::Min<double>( dt_local ) );
+
+    double dt_global;
+    MPI_Allreduce( &dt_local, &dt_global, 1, MPI_DOUBLE, MPI_MIN,
+                   MPI_COMM_WORLD );
+    return dt_global;
+}
+
+} // namespace CabanaPD
+
+#endif
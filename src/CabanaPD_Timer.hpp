@@ -13,8 +13,18 @@
 #define TIMER_H
 
 #include "mpi.h"
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Kokkos_Core.hpp>
+
+#include <nlohmann/json.hpp>
 
 namespace CabanaPD
 {
@@ -25,15 +35,28 @@ class Timer
     double _last_time = 0.0;
     double _max_time = 0.0;
     double _min_time = 0.0;
+    double _avg_time = 0.0;
+    double _bytes = 0.0;
     int _num_calls = 0;
     bool _running = false;
+    // Named timers also mark Kokkos profiling regions so that external tools
+    // line up with the timing report.
+    std::string _region;
 
   public:
+    Timer() = default;
+    Timer( const std::string& name )
+        : _region( "CabanaPD::" + name )
+    {
+    }
+
     void start()
     {
         if ( _running )
             throw std::runtime_error( "Timer already running" );
 
+        if ( !_region.empty() )
+            Kokkos::Profiling::pushRegion( _region );
         _start_time = MPI_Wtime();
         _running = true;
     }
@@ -46,21 +69,95 @@ class Timer
         _time += _last_time;
         _num_calls++;
         _running = false;
+        if ( !_region.empty() )
+            Kokkos::Profiling::popRegion();
     }
     void reset() { _time = 0.0; }
     bool running() { return _running; }
-    auto time() { return _time; }
-    auto minTime() { return _min_time; }
-    auto maxTime() { return _max_time; }
-    auto numCalls() { return _num_calls; }
-    auto lastTime() { return _last_time; }
+    auto time() const { return _time; }
+    auto minTime() const { return _min_time; }
+    auto maxTime() const { return _max_time; }
+    auto avgTime() const { return _avg_time; }
+    auto numCalls() const { return _num_calls; }
+    auto lastTime() const { return _last_time; }
+
+    // Bytes communicated within this region (sent from this rank).
+    void addBytes( const double bytes ) { _bytes += bytes; }
+    auto bytes() const { return _bytes; }
 
-    void reduceMPI()
+    void reduceMPI( MPI_Comm comm = MPI_COMM_WORLD )
     {
-        MPI_Allreduce( &_time, &_max_time, 1, MPI_DOUBLE, MPI_MAX,
-                       MPI_COMM_WORLD );
-        MPI_Allreduce( &_time, &_min_time, 1, MPI_DOUBLE, MPI_MIN,
-                       MPI_COMM_WORLD );
+        MPI_Allreduce( &_time, &_max_time, 1, MPI_DOUBLE, MPI_MAX, comm );
+        MPI_Allreduce( &_time, &_min_time, 1, MPI_DOUBLE, MPI_MIN, comm );
+        int size;
+        MPI_Comm_size( comm, &size );
+        MPI_Allreduce( &_time, &_avg_time, 1, MPI_DOUBLE, MPI_SUM, comm );
+        _avg_time /= size;
+    }
+};
+
+// Named timing regions collected from all modules for the profiling report:
+// time across ranks (min/avg/max and imbalance), call counts, and bytes
+// communicated.
+class TimerRegistry
+{
+    std::vector<std::pair<std::string, Timer>> _timers;
+
+  public:
+    void add( const std::string& name, const Timer& timer )
+    {
+        _timers.push_back( { name, timer } );
+    }
+
+    auto size() const { return _timers.size(); }
+
+    // Collective: all ranks must register the same regions in the same order.
+    // Writes <prefix>.json and <prefix>.csv from rank 0.
+    void write( const std::string& prefix, MPI_Comm comm = MPI_COMM_WORLD )
+    {
+        int rank, size;
+        MPI_Comm_rank( comm, &rank );
+        MPI_Comm_size( comm, &size );
+
+        nlohmann::json report;
+        report["num_ranks"] = size;
+        std::stringstream csv;
+        csv << "region,calls,min_time,avg_time,max_time,imbalance,bytes\n";
+        for ( auto& [name, timer] : _timers )
+        {
+            timer.reduceMPI( comm );
+            int max_calls = 0;
+            int calls = timer.numCalls();
+            MPI_Reduce( &calls, &max_calls, 1, MPI_INT, MPI_MAX, 0, comm );
+            double bytes = 0.0;
+            double local_bytes = timer.bytes();
+            MPI_Reduce( &local_bytes, &bytes, 1, MPI_DOUBLE, MPI_SUM, 0, comm );
+
+            const double imbalance =
+                timer.avgTime() > 0.0 ? timer.maxTime() / timer.avgTime() : 1.0;
+            nlohmann::json region;
+            region["name"] = name;
+            region["calls"] = max_calls;
+            region["min_time"] = timer.minTime();
+            region["avg_time"] = timer.avgTime();
+            region["max_time"] = timer.maxTime();
+            region["imbalance"] = imbalance;
+            region["bytes"] = bytes;
+            report["regions"].push_back( region );
+
+            csv << name << "," << max_calls << "," << std::scientific
+                << std::setprecision( 6 ) << timer.minTime() << ","
+                << timer.avgTime() << "," << timer.maxTime() << ","
+                << imbalance << "," << bytes << "\n";
+        }
+
+        if ( rank == 0 )
+        {
+            std::ofstream json_file( prefix + ".json" );
+            json_file << std::setw( 2 ) << report << std::endl;
+            std::ofstream csv_file( prefix + ".csv" );
+            csv_file << csv.str();
+        }
     }
 };
 } // namespace CabanaPD
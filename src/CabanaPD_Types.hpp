@@ -32,6 +32,87 @@ struct is_fracture<Fracture> : public std::true_type
 {
 };
 
+// Bond breaking tags: intermediate integrator stages may evaluate forces
+// with the current bonds only, and bonds may be checked for breaking only
+// for the particles in an active set (near a damage front).
+struct BondBreaking
+{
+};
+struct NoBondBreaking
+{
+};
+struct ActiveBondBreaking
+{
+};
+
+// Broken bond storage tags.
+struct BitBondStorage
+{
+};
+struct ByteBondStorage
+{
+};
+// One byte per bond with a CSR (VerletLayout1D) neighbor list, such that
+// neighbors and bond data are sized by the total number of bonds rather than
+// padded to the maximum number of neighbors.
+struct CSRBondStorage
+{
+};
+template <class>
+struct is_csr_storage : public std::false_type
+{
+};
+template <>
+struct is_csr_storage<CSRBondStorage> : public std::true_type
+{
+};
+
+// Bond reference geometry cache tags.
+struct NoBondCache
+{
+};
+struct BondLengthCache
+{
+};
+struct BondGeometryCache
+{
+};
+struct BondInfluenceCache
+{
+};
+
+// Precision tags: the evolving particle fields (displacement, velocity,
+// force, energy, damage) can be stored and communicated in single precision.
+// Reference positions, volumes, and bond geometry are always double and
+// bond stretch is always computed in double.
+struct DoublePrecision
+{
+    using state_type = double;
+};
+struct MixedPrecision
+{
+    using state_type = float;
+};
+
+// Ghosted field tags, used to track which fields have changed since they
+// were last communicated.
+struct DisplacementField
+{
+    static constexpr int index = 0;
+};
+struct DilatationField
+{
+    static constexpr int index = 1;
+};
+struct WeightedVolumeField
+{
+    static constexpr int index = 2;
+};
+struct TemperatureField
+{
+    static constexpr int index = 3;
+};
+
 // Mechanics tags.
 struct Elastic
 {
@@ -46,6 +127,18 @@ struct is_contact : public std::false_type
 {
 };
 
+// Ensemble (independent members with separate model parameters) tags.
+template <class>
+struct is_ensemble : public std::false_type
+{
+};
+
+// Variable horizon (bond parameters from per-particle resolution) tags.
+template <class>
+struct is_variable_horizon : public std::false_type
+{
+};
+
 // Thermal tags.
 struct TemperatureIndependent
 {
@@ -19,54 +19,94 @@
 
 namespace CabanaPD
 {
-template <>
-struct ForceModel<LPS, Elastic, NoFracture> : public BaseForceModel
+// LPS with the influence function fixed at compile time.
+template <class InfluenceType>
+struct ForceModel<LPS, Elastic, NoFracture, TemperatureIndependent,
+                  InfluenceType> : public BaseForceModel
 {
     using base_type = BaseForceModel;
     using base_model = LPS;
     using fracture_type = NoFracture;
     using thermal_type = TemperatureIndependent;
+    using influence_function_type = InfluenceType;
 
     using base_type::delta;
+    using base_type::dim;
 
-    int influence_type;
+    InfluenceType influence;
 
     double K;
     double G;
     double theta_coeff;
     double s_coeff;
 
+    ForceModel( const double _delta, const double _K, const double _G )
+        : ForceModel( _delta, _K, _G, InfluenceType( _delta ) )
+    {
+    }
+
+    // In 2d the model is plane strain (per unit thickness) with the 3d bulk
+    // and shear moduli, using the in-plane bulk modulus K + G / 3.
     ForceModel( const double _delta, const double _K, const double _G,
-                const int _influence = 0 )
-        : base_type( _delta )
-        , influence_type( _influence )
+                const InfluenceType _influence, const int _dim = 3 )
+        : base_type( _delta, _dim )
+        , influence( _influence )
         , K( _K )
         , G( _G )
     {
-        theta_coeff = 3.0 * K - 5.0 * G;
-        s_coeff = 15.0 * G;
+        if ( dim == 2 )
+        {
+            theta_coeff = 2.0 * planeBulkModulus() - 4.0 * G;
+            s_coeff = 8.0 * G;
+        }
+        else
+        {
+            theta_coeff = 3.0 * K - 5.0 * G;
+            s_coeff = 15.0 * G;
+        }
+    }
+
+    // Bulk modulus governing the dilatation in the model dimension.
+    double planeBulkModulus() const
+    {
+        if ( dim == 2 )
+            return K + G / 3.0;
+        return K;
     }
 
     KOKKOS_INLINE_FUNCTION double influenceFunction( double xi ) const
     {
-        if ( influence_type == 1 )
-            return 1.0 / xi;
-        else
-            return 1.0;
+        return influence( xi );
     }
 
+    // Each bond function optionally takes a precomputed (tabulated)
+    // influence function value.
     KOKKOS_INLINE_FUNCTION auto weightedVolume( const double xi,
                                                 const double vol ) const
     {
-        return influenceFunction( xi ) * xi * xi * vol;
+        return weightedVolume( xi, vol, influenceFunction( xi ) );
+    }
+
+    KOKKOS_INLINE_FUNCTION auto weightedVolume( const double xi,
+                                                const double vol,
+                                                const double omega ) const
+    {
+        return omega * xi * xi * vol;
     }
 
     KOKKOS_INLINE_FUNCTION auto dilatation( const double s, const double xi,
                                             const double vol,
                                             const double m_i ) const
     {
-        double theta_i = influenceFunction( xi ) * s * xi * xi * vol;
-        return 3.0 * theta_i / m_i;
+        return dilatation( s, xi, vol, m_i, influenceFunction( xi ) );
+    }
+
+    KOKKOS_INLINE_FUNCTION auto dilatation( const double s, const double xi,
+                                            const double vol, const double m_i,
+                                            const double omega ) const
+    {
+        double theta_i = omega * s * xi * xi * vol;
+        return dim * theta_i / m_i;
     }
 
     KOKKOS_INLINE_FUNCTION auto forceCoeff( const double s, const double xi,
@@ -74,10 +114,19 @@ struct ForceModel<LPS, Elastic, NoFracture> : public BaseForceModel
                                             const double m_j,
                                             const double theta_i,
                                             const double theta_j ) const
+    {
+        return forceCoeff( s, xi, vol, m_i, m_j, theta_i, theta_j,
+                           influenceFunction( xi ) );
+    }
+
+    KOKKOS_INLINE_FUNCTION auto
+    forceCoeff( const double s, const double xi, const double vol,
+                const double m_i, const double m_j, const double theta_i,
+                const double theta_j, const double omega ) const
     {
         return ( theta_coeff * ( theta_i / m_i + theta_j / m_j ) +
                  s_coeff * s * ( 1.0 / m_i + 1.0 / m_j ) ) *
-               influenceFunction( xi ) * xi * vol;
+               omega * xi * vol;
     }
 
     KOKKOS_INLINE_FUNCTION
@@ -85,10 +134,116 @@ struct ForceModel<LPS, Elastic, NoFracture> : public BaseForceModel
                  const double m_i, const double theta_i,
                  const double num_bonds ) const
     {
-        return 1.0 / num_bonds * 0.5 * theta_coeff / 3.0 *
+        return energy( s, xi, vol, m_i, theta_i, num_bonds,
+                       influenceFunction( xi ) );
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    auto energy( const double s, const double xi, const double vol,
+                 const double m_i, const double theta_i,
+                 const double num_bonds, const double omega ) const
+    {
+        return 1.0 / num_bonds * 0.5 * theta_coeff / dim *
                    ( theta_i * theta_i ) +
-               0.5 * ( s_coeff / m_i ) * influenceFunction( xi ) * s * s * xi *
-                   xi * vol;
+               0.5 * ( s_coeff / m_i ) * omega * s * s * xi * xi * vol;
+    }
+};
+
+// LPS with the influence function chosen at runtime.
+template <>
+struct ForceModel<LPS, Elastic, NoFracture>
+    : public ForceModel<LPS, Elastic, NoFracture, TemperatureIndependent,
+                        RuntimeInfluence>
+{
+    using base_type = ForceModel<LPS, Elastic, NoFracture,
+                                 TemperatureIndependent, RuntimeInfluence>;
+    using base_model = typename base_type::base_model;
+    using fracture_type = typename base_type::fracture_type;
+    using thermal_type = typename base_type::thermal_type;
+
+    using base_type::delta;
+    using base_type::dim;
+    using base_type::G;
+    using base_type::K;
+    using base_type::s_coeff;
+    using base_type::theta_coeff;
+
+    int influence_type;
+
+    ForceModel( const double _delta, const double _K, const double _G,
+                const int _influence = 0, const int _dim = 3 )
+        : base_type( _delta, _K, _G, RuntimeInfluence( _influence ), _dim )
+        , influence_type( _influence )
+    {
+    }
+};
+
+// LPS fracture with the influence function fixed at compile time.
+template <class InfluenceType>
+struct ForceModel<LPS, Elastic, Fracture, TemperatureIndependent,
+                  InfluenceType>
+    : public ForceModel<LPS, Elastic, NoFracture, TemperatureIndependent,
+                        InfluenceType>
+{
+    using base_type = ForceModel<LPS, Elastic, NoFracture,
+                                 TemperatureIndependent, InfluenceType>;
+    using base_model = typename base_type::base_model;
+    using fracture_type = Fracture;
+    using thermal_type = typename base_type::thermal_type;
+
+    using base_type::delta;
+    using base_type::dim;
+    using base_type::G;
+    using base_type::influence;
+    using base_type::K;
+    using base_type::s_coeff;
+    using base_type::theta_coeff;
+    double G0;
+    double s0;
+    double bond_break_coeff;
+
+    ForceModel( const double _delta, const double _K, const double _G,
+                const double _G0 )
+        : ForceModel( _delta, _K, _G, _G0, InfluenceType( _delta ) )
+    {
+    }
+
+    ForceModel( const double _delta, const double _K, const double _G,
+                const double _G0, const InfluenceType _influence,
+                const int _dim = 3 )
+        : base_type( _delta, _K, _G, _influence, _dim )
+        , G0( _G0 )
+    {
+        s0 = criticalStretch();
+        bond_break_coeff = ( 1.0 + s0 ) * ( 1.0 + s0 );
+    }
+
+    // Critical stretch from the fracture energy for a general influence
+    // function: s0^2 = 4 G0 int( w xi^4 ) / ( 9 K int( w xi^5 ) ) over the
+    // horizon in 3d and s0^2 = pi G0 int( w xi^3 ) / ( 4 K' int( w xi^4 ) )
+    // in 2d, integrated on the host with composite Simpson's rule (the
+    // integrands vanish at xi = 0, which is not evaluated).
+    double criticalStretch() const
+    {
+        const int num_intervals = 1000;
+        const double h = delta / num_intervals;
+        double int3 = 0.0;
+        double int4 = 0.0;
+        double int5 = 0.0;
+        for ( int k = 1; k <= num_intervals; k++ )
+        {
+            const double xi = k * h;
+            const double w =
+                ( k == num_intervals ) ? 1.0 : 2.0 + 2.0 * ( k % 2 );
+            const double f = w * influence( xi ) * xi * xi * xi;
+            int3 += f;
+            int4 += f * xi;
+            int5 += f * xi * xi;
+        }
+        if ( dim == 2 )
+            return Kokkos::sqrt( pi * G0 * int3 /
+                                 ( 4.0 * this->planeBulkModulus() * int4 ) );
+        return Kokkos::sqrt( 4.0 * G0 * int4 / ( 9.0 * K * int5 ) );
     }
 };
 
@@ -102,6 +257,7 @@ struct ForceModel<LPS, Elastic, Fracture>
     using thermal_type = base_type::thermal_type;
 
     using base_type::delta;
+    using base_type::dim;
     using base_type::G;
     using base_type::influence_type;
     using base_type::K;
@@ -112,11 +268,20 @@ struct ForceModel<LPS, Elastic, Fracture>
     double bond_break_coeff;
 
     ForceModel( const double _delta, const double _K, const double _G,
-                const double _G0, const int _influence = 0 )
-        : base_type( _delta, _K, _G, _influence )
+                const double _G0, const int _influence = 0,
+                const int _dim = 3 )
+        : base_type( _delta, _K, _G, _influence, _dim )
         , G0( _G0 )
     {
-        if ( influence_type == 1 )
+        if ( dim == 2 )
+        {
+            const double K2 = this->planeBulkModulus();
+            if ( influence_type == 1 )
+                s0 = Kokkos::sqrt( pi * G0 / 3.0 / K2 / delta ); // 1/xi
+            else
+                s0 = Kokkos::sqrt( 5.0 * pi * G0 / 16.0 / K2 / delta ); // 1
+        }
+        else if ( influence_type == 1 )
         {
             s0 = Kokkos::sqrt( 5.0 * G0 / 9.0 / K / delta ); // 1/xi
         }
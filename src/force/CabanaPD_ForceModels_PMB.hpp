@@ -12,6 +12,9 @@
 #ifndef FORCE_MODELS_PMB_H
 #define FORCE_MODELS_PMB_H
 
+#include <stdexcept>
+#include <vector>
+
 #include <Kokkos_Core.hpp>
 
 #include <CabanaPD_Constants.hpp>
@@ -34,11 +37,16 @@ struct ForceModel<PMB, Elastic, NoFracture, TemperatureIndependent>
     double c;
     double K;
 
-    ForceModel( const double delta, const double _K )
-        : base_type( delta )
+    // In 2d, K is the in-plane bulk modulus (e.g. E / ( 2 ( 1 - nu ) ) for
+    // plane stress).
+    ForceModel( const double delta, const double _K, const int dim = 3 )
+        : base_type( delta, dim )
         , K( _K )
     {
-        c = 18.0 * K / ( pi * delta * delta * delta * delta );
+        if ( dim == 2 )
+            c = 12.0 * K / ( pi * delta * delta * delta );
+        else
+            c = 18.0 * K / ( pi * delta * delta * delta * delta );
     }
 
     KOKKOS_INLINE_FUNCTION
@@ -54,6 +62,22 @@ struct ForceModel<PMB, Elastic, NoFracture, TemperatureIndependent>
         // the integrand (pairwise potential).
         return 0.25 * c * s * s * xi * vol;
     }
+
+    // Bond-dependent versions used by the force kernels, to allow parameters
+    // which vary by particle (see the ensemble models below).
+    KOKKOS_INLINE_FUNCTION
+    auto forceCoeff( const int, const int, const double s,
+                     const double vol ) const
+    {
+        return forceCoeff( s, vol );
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    auto energy( const int, const int, const double s, const double xi,
+                 const double vol ) const
+    {
+        return energy( s, xi, vol );
+    }
 };
 
 template <>
@@ -72,11 +96,15 @@ struct ForceModel<PMB, Elastic, Fracture, TemperatureIndependent>
     double s0;
     double bond_break_coeff;
 
-    ForceModel( const double delta, const double K, const double _G0 )
-        : base_type( delta, K )
+    ForceModel( const double delta, const double K, const double _G0,
+                const int dim = 3 )
+        : base_type( delta, K, dim )
         , G0( _G0 )
     {
-        s0 = Kokkos::sqrt( 5.0 * G0 / 9.0 / K / delta );
+        if ( dim == 2 )
+            s0 = Kokkos::sqrt( pi * G0 / 3.0 / K / delta );
+        else
+            s0 = Kokkos::sqrt( 5.0 * G0 / 9.0 / K / delta );
         bond_break_coeff = ( 1.0 + s0 ) * ( 1.0 + s0 );
     }
 
@@ -345,6 +373,340 @@ auto createForceModel( PMB, Fracture, ParticleType particles,
         constant_microconductivity );
 }
 
+/******************************************************************************
+  PMB ensembles: independent members with the same horizon, each with its own
+  bulk modulus (and fracture energy), distinguished by particle type. Members
+  must not share bonds and bond parameters are taken from the first particle,
+  so only local particle types are needed.
+******************************************************************************/
+template <typename TypeSliceType>
+struct BaseEnsembleModel
+{
+    using memory_space = typename TypeSliceType::memory_space;
+    using view_type = Kokkos::View<double*, memory_space>;
+
+    TypeSliceType type;
+    view_type member_c;
+    // Stiffest member, which limits the stable timestep.
+    double max_c = 0.0;
+
+    BaseEnsembleModel( const double delta, const std::vector<double>& K,
+                       const TypeSliceType _type )
+        : type( _type )
+        , member_c( "ensemble_c", K.size() )
+    {
+        auto c_host = Kokkos::create_mirror_view( member_c );
+        for ( std::size_t k = 0; k < K.size(); ++k )
+        {
+            c_host( k ) = 18.0 * K[k] / ( pi * delta * delta * delta * delta );
+            max_c = Kokkos::max( max_c, c_host( k ) );
+        }
+        Kokkos::deep_copy( member_c, c_host );
+    }
+
+    auto numMembers() const { return member_c.size(); }
+    double maxMemberC() const { return max_c; }
+
+    void update( const TypeSliceType _type ) { type = _type; }
+
+    KOKKOS_INLINE_FUNCTION
+    double memberC( const int i ) const { return member_c( type( i ) ); }
+};
+
+template <typename TypeSliceType>
+struct ForceModel<PMB, Elastic, NoFracture, TemperatureIndependent,
+                  TypeSliceType>
+    : public ForceModel<PMB, Elastic, NoFracture, TemperatureIndependent>,
+      BaseEnsembleModel<TypeSliceType>
+{
+    using base_type =
+        ForceModel<PMB, Elastic, NoFracture, TemperatureIndependent>;
+    using base_ensemble_type = BaseEnsembleModel<TypeSliceType>;
+    using base_model = PMB;
+    using fracture_type = NoFracture;
+    using thermal_type = TemperatureIndependent;
+
+    // Parameters of the first member.
+    using base_type::c;
+    using base_type::delta;
+    using base_type::K;
+
+    using base_ensemble_type::memberC;
+    using base_ensemble_type::numMembers;
+    using base_ensemble_type::update;
+
+    ForceModel( const double delta, const std::vector<double>& K,
+                const TypeSliceType type )
+        : base_type( delta, K.at( 0 ) )
+        , base_ensemble_type( delta, K, type )
+    {
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    auto forceCoeff( const int i, const int, const double s,
+                     const double vol ) const
+    {
+        return memberC( i ) * s * vol;
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    auto energy( const int i, const int, const double s, const double xi,
+                 const double vol ) const
+    {
+        return 0.25 * memberC( i ) * s * s * xi * vol;
+    }
+};
+
+template <typename TypeSliceType>
+struct ForceModel<PMB, Elastic, Fracture, TemperatureIndependent,
+                  TypeSliceType>
+    : public ForceModel<PMB, Elastic, Fracture, TemperatureIndependent>,
+      BaseEnsembleModel<TypeSliceType>
+{
+    using base_type =
+        ForceModel<PMB, Elastic, Fracture, TemperatureIndependent>;
+    using base_ensemble_type = BaseEnsembleModel<TypeSliceType>;
+    using base_model = typename base_type::base_model;
+    using fracture_type = typename base_type::fracture_type;
+    using thermal_type = TemperatureIndependent;
+    using view_type = typename base_ensemble_type::view_type;
+
+    // Parameters of the first member.
+    using base_type::bond_break_coeff;
+    using base_type::c;
+    using base_type::delta;
+    using base_type::G0;
+    using base_type::K;
+    using base_type::s0;
+
+    using base_ensemble_type::memberC;
+    using base_ensemble_type::numMembers;
+    using base_ensemble_type::type;
+    using base_ensemble_type::update;
+    view_type member_bond_break_coeff;
+
+    ForceModel( const double delta, const std::vector<double>& K,
+                const std::vector<double>& G0, const TypeSliceType type )
+        : base_type( delta, K.at( 0 ), G0.at( 0 ) )
+        , base_ensemble_type( delta, K, type )
+        , member_bond_break_coeff( "ensemble_bond_break_coeff", K.size() )
+    {
+        if ( G0.size() != K.size() )
+            throw std::runtime_error(
+                "Ensemble requires one fracture energy per member." );
+        auto coeff_host = Kokkos::create_mirror_view( member_bond_break_coeff );
+        for ( std::size_t k = 0; k < K.size(); ++k )
+        {
+            const double s0_k =
+                Kokkos::sqrt( 5.0 * G0[k] / 9.0 / K[k] / delta );
+            coeff_host( k ) = ( 1.0 + s0_k ) * ( 1.0 + s0_k );
+        }
+        Kokkos::deep_copy( member_bond_break_coeff, coeff_host );
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    auto forceCoeff( const int i, const int, const double s,
+                     const double vol ) const
+    {
+        return memberC( i ) * s * vol;
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    auto energy( const int i, const int, const double s, const double xi,
+                 const double vol ) const
+    {
+        return 0.25 * memberC( i ) * s * s * xi * vol;
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    bool criticalStretch( const int i, const int, const double r,
+                          const double xi ) const
+    {
+        return r * r >= member_bond_break_coeff( type( i ) ) * xi * xi;
+    }
+};
+
+template <typename TypeSliceType>
+struct is_ensemble<ForceModel<PMB, Elastic, NoFracture, TemperatureIndependent,
+                              TypeSliceType>> : public std::true_type
+{
+};
+template <typename TypeSliceType>
+struct is_ensemble<ForceModel<PMB, Elastic, Fracture, TemperatureIndependent,
+                              TypeSliceType>> : public std::true_type
+{
+};
+
+// Ensemble models, with members given by the particle type.
+template <typename ParticleType>
+auto createEnsembleForceModel( PMB, NoFracture, ParticleType& particles,
+                               const double delta,
+                               const std::vector<double>& K )
+{
+    auto type = particles.sliceType();
+    using type_slice = decltype( type );
+    return ForceModel<PMB, Elastic, NoFracture, TemperatureIndependent,
+                      type_slice>( delta, K, type );
+}
+
+template <typename ParticleType>
+auto createEnsembleForceModel( PMB, Fracture, ParticleType& particles,
+                               const double delta, const std::vector<double>& K,
+                               const std::vector<double>& G0 )
+{
+    auto type = particles.sliceType();
+    using type_slice = decltype( type );
+    return ForceModel<PMB, Elastic, Fracture, TemperatureIndependent,
+                      type_slice>( delta, K, G0, type );
+}
+
+/******************************************************************************
+  PMB with a variable horizon: bond parameters follow the bond horizon of
+  particles with variable resolution (see BondHorizon), such that the bulk
+  modulus and fracture energy are independent of the local resolution.
+******************************************************************************/
+template <typename VolumeType>
+struct ForceModel<PMB, Elastic, NoFracture, TemperatureIndependent,
+                  BondHorizon<VolumeType>>
+    : public ForceModel<PMB, Elastic, NoFracture, TemperatureIndependent>
+{
+    using base_type =
+        ForceModel<PMB, Elastic, NoFracture, TemperatureIndependent>;
+    using base_model = PMB;
+    using fracture_type = NoFracture;
+    using thermal_type = TemperatureIndependent;
+    using horizon_type = BondHorizon<VolumeType>;
+
+    // Parameters at the reference resolution.
+    using base_type::c;
+    using base_type::delta;
+    using base_type::K;
+
+    horizon_type horizon;
+
+    ForceModel( const double delta, const double K,
+                const horizon_type& _horizon )
+        : base_type( delta, K )
+        , horizon( _horizon )
+    {
+    }
+
+    void update( const VolumeType& vol ) { horizon.update( vol ); }
+
+    // Micromodulus scales with the inverse fourth power of the horizon.
+    KOKKOS_INLINE_FUNCTION
+    double bondC( const int i, const int j ) const
+    {
+        const double ratio = horizon.ratio( i, j );
+        return c / ( ratio * ratio * ratio * ratio );
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    auto forceCoeff( const int i, const int j, const double s,
+                     const double vol ) const
+    {
+        return bondC( i, j ) * s * vol;
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    auto energy( const int i, const int j, const double s, const double xi,
+                 const double vol ) const
+    {
+        return 0.25 * bondC( i, j ) * s * s * xi * vol;
+    }
+};
+
+template <typename VolumeType>
+struct ForceModel<PMB, Elastic, Fracture, TemperatureIndependent,
+                  BondHorizon<VolumeType>>
+    : public ForceModel<PMB, Elastic, NoFracture, TemperatureIndependent,
+                        BondHorizon<VolumeType>>
+{
+    using base_type =
+        ForceModel<PMB, Elastic, NoFracture, TemperatureIndependent,
+                   BondHorizon<VolumeType>>;
+    using base_model = PMB;
+    using fracture_type = Fracture;
+    using thermal_type = TemperatureIndependent;
+    using horizon_type = typename base_type::horizon_type;
+
+    using base_type::c;
+    using base_type::delta;
+    using base_type::horizon;
+    using base_type::K;
+    using base_type::update;
+    double G0;
+    // Critical stretch at the reference resolution.
+    double s0;
+    double bond_break_coeff;
+
+    ForceModel( const double delta, const double K, const double _G0,
+                const horizon_type& horizon )
+        : base_type( delta, K, horizon )
+        , G0( _G0 )
+    {
+        s0 = Kokkos::sqrt( 5.0 * G0 / 9.0 / K / delta );
+        bond_break_coeff = ( 1.0 + s0 ) * ( 1.0 + s0 );
+    }
+
+    // Critical stretch scales with the inverse square root of the horizon.
+    KOKKOS_INLINE_FUNCTION
+    bool criticalStretch( const int i, const int j, const double r,
+                          const double xi ) const
+    {
+        const double s0_ij = s0 / Kokkos::sqrt( horizon.ratio( i, j ) );
+        return r * r >= ( 1.0 + s0_ij ) * ( 1.0 + s0_ij ) * xi * xi;
+    }
+};
+
+template <typename VolumeType>
+struct is_ensemble<ForceModel<PMB, Elastic, NoFracture, TemperatureIndependent,
+                              BondHorizon<VolumeType>>> : public std::false_type
+{
+};
+template <typename VolumeType>
+struct is_ensemble<ForceModel<PMB, Elastic, Fracture, TemperatureIndependent,
+                              BondHorizon<VolumeType>>> : public std::false_type
+{
+};
+template <typename VolumeType>
+struct is_variable_horizon<
+    ForceModel<PMB, Elastic, NoFracture, TemperatureIndependent,
+               BondHorizon<VolumeType>>> : public std::true_type
+{
+};
+template <typename VolumeType>
+struct is_variable_horizon<
+    ForceModel<PMB, Elastic, Fracture, TemperatureIndependent,
+               BondHorizon<VolumeType>>> : public std::true_type
+{
+};
+
+// Variable horizon models, from the particle volumes relative to the
+// reference resolution (see Particles::createParticles with refinement).
+template <typename ParticleType>
+auto createVariableHorizonForceModel( PMB, NoFracture, ParticleType& particles,
+                                      const double delta, const double K )
+{
+    auto vol = particles.sliceVolume();
+    using horizon_type = BondHorizon<decltype( vol )>;
+    horizon_type horizon( delta, particles.referenceVolume(), vol );
+    return ForceModel<PMB, Elastic, NoFracture, TemperatureIndependent,
+                      horizon_type>( delta, K, horizon );
+}
+
+template <typename ParticleType>
+auto createVariableHorizonForceModel( PMB, Fracture, ParticleType& particles,
+                                      const double delta, const double K,
+                                      const double G0 )
+{
+    auto vol = particles.sliceVolume();
+    using horizon_type = BondHorizon<decltype( vol )>;
+    horizon_type horizon( delta, particles.referenceVolume(), vol );
+    return ForceModel<PMB, Elastic, Fracture, TemperatureIndependent,
+                      horizon_type>( delta, K, G0, horizon );
+}
+
 } // namespace CabanaPD
 
 #endif
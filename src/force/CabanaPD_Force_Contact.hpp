@@ -31,17 +31,194 @@ KOKKOS_INLINE_FUNCTION void getRelativeNormalVelocityComponents(
 {
     vx = vel( i, 0 ) - vel( j, 0 );
     vy = vel( i, 1 ) - vel( j, 1 );
-    vz = vel( i, 2 ) - vel( j, 2 );
+    vz = component<2>( vel, i ) - component<2>( vel, j );
 
     vn = vx * rx + vy * ry + vz * rz;
     vn /= r;
 };
 
+/******************************************************************************
+Contact neighbor list with a Verlet skin
+******************************************************************************/
+// Contact neighbors are found within the contact radius plus a skin and only
+// rebuilt once any particle may have moved far enough (half the skin) for a
+// missing pair to come into contact. Optionally, pairs with an intact PD bond
+// are removed, which also requires a rebuild whenever a bond breaks.
+template <class MemorySpace, class BondStorageType = BitBondStorage>
+class ContactNeighborSkin
+{
+  public:
+    using memory_space = MemorySpace;
+    using exec_space = typename memory_space::execution_space;
+    using pd_neighbor_list_type =
+        typename Force<memory_space, BaseForceModel,
+                       BondStorageType>::neighbor_list_type;
+    using broken_bond_type = BrokenBonds<memory_space, BondStorageType>;
+
+    ContactNeighborSkin( const double skin = 0.0 )
+        : _skin( skin )
+    {
+    }
+
+    template <class NeighborListType, class PositionType>
+    void update( NeighborListType& neigh_list, const PositionType& y,
+                 const std::size_t frozen_offset,
+                 const std::size_t local_offset,
+                 const std::size_t reference_offset, const double radius,
+                 const double mesh_min[3], const double mesh_max[3] )
+    {
+        _timer.start();
+        bool rebuild = needsRebuild( y, reference_offset );
+        std::size_t num_intact = 0;
+        if ( _exclude_bonds )
+        {
+            num_intact = _mu.numIntact();
+            rebuild = rebuild || num_intact != _num_intact;
+        }
+        if ( rebuild )
+        {
+            Force<memory_space, BaseForceModel>::buildFull(
+                neigh_list, y, frozen_offset, local_offset, radius + _skin,
+                mesh_min, mesh_max, _spatial_index );
+            if ( _exclude_bonds )
+            {
+                removeBonded( neigh_list, frozen_offset, local_offset );
+                _num_intact = num_intact;
+            }
+            store( y, reference_offset );
+            _num_builds++;
+        }
+        _timer.stop();
+    }
+
+    // Only keep contact pairs without an intact bond. Without broken bond
+    // storage all PD neighbors are excluded.
+    void excludeBonds( const pd_neighbor_list_type& pd_neigh_list,
+                       const broken_bond_type& mu = broken_bond_type() )
+    {
+        _exclude_bonds = true;
+        _pd_neigh_list = pd_neigh_list;
+        _mu = mu;
+        _rebuild = true;
+    }
+
+    // Force a rebuild, e.g. after the ghost particles have changed.
+    void reset() { _rebuild = true; }
+
+    // Build from the particle cell list instead of binning separately.
+    void useSpatialIndex(
+        const std::shared_ptr<SpatialIndex<memory_space>>& spatial_index )
+    {
+        _spatial_index = spatial_index;
+    }
+
+    auto skin() const { return _skin; }
+    auto numBuilds() const { return _num_builds; }
+    auto time() { return _timer.time(); };
+    const Timer& getTimer() const { return _timer; }
+    // Positions stored at the last build.
+    double bytes() const { return viewBytes( _y_build ); }
+
+  protected:
+    template <class NeighborListType>
+    void removeBonded( NeighborListType& neigh_list, const std::size_t begin,
+                       const std::size_t end )
+    {
+        NeighborRows<NeighborListType> neighbors( neigh_list );
+        auto counts = neighbors.counts;
+        NeighborRows<pd_neighbor_list_type> pd_neighbors( _pd_neigh_list );
+        auto pd_counts = pd_neighbors.counts;
+        auto mu = _mu;
+        const bool has_mu = _mu.extent( 0 ) > 0;
+        Kokkos::RangePolicy<exec_space> policy( begin, end );
+        Kokkos::parallel_for(
+            "CabanaPD::Contact::removeBonded", policy,
+            KOKKOS_LAMBDA( const int i ) {
+                int kept = 0;
+                const int num_contact = counts( i );
+                const int num_pd = pd_counts( i );
+                for ( int c = 0; c < num_contact; c++ )
+                {
+                    const int j = neighbors( i, c );
+                    bool bonded = false;
+                    for ( int n = 0; n < num_pd; n++ )
+                        if ( pd_neighbors( i, n ) == j )
+                        {
+                            bonded = !has_mu || mu( i, n );
+                            break;
+                        }
+                    if ( !bonded )
+                        neighbors( i, kept++ ) = j;
+                }
+                counts( i ) = kept;
+            } );
+        Kokkos::fence();
+    }
+
+    template <class PositionType>
+    bool needsRebuild( const PositionType& y,
+                       const std::size_t reference_offset )
+    {
+        if ( _rebuild || _y_build.extent( 0 ) != reference_offset )
+            return true;
+
+        auto y_build = _y_build;
+        double max_dy2 = 0.0;
+        Kokkos::RangePolicy<exec_space> policy( 0, reference_offset );
+        Kokkos::parallel_reduce(
+            "CabanaPD::Contact::skinDisplacement", policy,
+            KOKKOS_LAMBDA( const int p, double& max_val ) {
+                double dy2 = 0.0;
+                for ( int d = 0; d < vector_dim<PositionType>::value; d++ )
+                {
+                    const double dy = y( p, d ) - y_build( p, d );
+                    dy2 += dy * dy;
+                }
+                if ( dy2 > max_val )
+                    max_val = dy2;
+            },
+            Kokkos::Max<double>( max_dy2 ) );
+        return max_dy2 > 0.25 * _skin * _skin;
+    }
+
+    template <class PositionType>
+    void store( const PositionType& y, const std::size_t reference_offset )
+    {
+        if ( _y_build.extent( 0 ) != reference_offset )
+            _y_build = Kokkos::View<double* [3], memory_space>(
+                Kokkos::ViewAllocateWithoutInitializing( "contact_positions" ),
+                reference_offset );
+        auto y_build = _y_build;
+        Kokkos::RangePolicy<exec_space> policy( 0, reference_offset );
+        Kokkos::parallel_for(
+            "CabanaPD::Contact::storePositions", policy,
+            KOKKOS_LAMBDA( const int p ) {
+                for ( int d = 0; d < vector_dim<PositionType>::value; d++ )
+                    y_build( p, d ) = y( p, d );
+            } );
+        Kokkos::fence();
+        _rebuild = false;
+    }
+
+    double _skin;
+    bool _rebuild = true;
+    int _num_builds = 0;
+
+    bool _exclude_bonds = false;
+    pd_neighbor_list_type _pd_neigh_list;
+    broken_bond_type _mu;
+    std::size_t _num_intact = 0;
+
+    Kokkos::View<double* [3], memory_space> _y_build;
+    std::shared_ptr<SpatialIndex<memory_space>> _spatial_index;
+    Timer _timer = Timer( "ContactNeighbor" );
+};
+
 /******************************************************************************
   Normal repulsion forces
 ******************************************************************************/
-template <class MemorySpace>
-class Force<MemorySpace, NormalRepulsionModel>
+template <class MemorySpace, class BondStorageType>
+class Force<MemorySpace, NormalRepulsionModel, BondStorageType>
     : public Force<MemorySpace, BaseForceModel>
 {
   public:
@@ -50,12 +227,17 @@ class Force<MemorySpace, NormalRepulsionModel>
 
     template <class ParticleType>
     Force( const bool half_neigh, const ParticleType& particles,
-           const NormalRepulsionModel model )
-        : base_type( half_neigh, model.Rc, particles.sliceCurrentPosition(),
+           const NormalRepulsionModel model, const double skin = 0.0 )
+        : base_type( half_neigh, model.Rc + skin,
+                     particles.sliceCurrentPosition(),
                      particles.frozenOffset(), particles.localOffset(),
-                     particles.ghost_mesh_lo, particles.ghost_mesh_hi )
+                     particles.ghost_mesh_lo, particles.ghost_mesh_hi, 1e-14,
+                     particles.spatialIndex() )
         , _model( model )
+        , _neigh_skin( skin )
     {
+        _timer = Timer( "Contact" );
+        _neigh_skin.useSpatialIndex( particles.spatialIndex() );
         for ( int d = 0; d < particles.dim; d++ )
         {
             mesh_min[d] = particles.ghost_mesh_lo[d];
@@ -63,9 +245,9 @@ class Force<MemorySpace, NormalRepulsionModel>
         }
     }
 
-    template <class ForceType, class PosType, class ParticleType,
-              class ParallelType>
-    void computeForceFull( ForceType& fc, const PosType& x, const PosType& u,
+    template <class ForceType, class PosType, class DispType,
+              class ParticleType, class ParallelType>
+    void computeForceFull( ForceType& fc, const PosType& x, const DispType& u,
                            const ParticleType& particles,
                            ParallelType& neigh_op_tag )
     {
@@ -75,10 +257,9 @@ class Force<MemorySpace, NormalRepulsionModel>
         const int n_frozen = particles.frozenOffset();
         const int n_local = particles.localOffset();
 
-        _neigh_timer.start();
-        _neigh_list.build( y, n_frozen, n_local, model.Rc, 1.0, mesh_min,
-                           mesh_max );
-        _neigh_timer.stop();
+        _neigh_skin.update( _neigh_list, y, n_frozen, n_local,
+                            particles.referenceOffset(), model.Rc, mesh_min,
+                            mesh_max );
 
         auto contact_full = KOKKOS_LAMBDA( const int i, const int j )
         {
@@ -89,15 +270,16 @@ class Force<MemorySpace, NormalRepulsionModel>
             double xi, r, s;
             double rx, ry, rz;
             getDistanceComponents( x, u, i, j, xi, r, s, rx, ry, rz );
+            // Pairs within the skin are not in contact.
+            if ( r > model.Rc )
+                return;
 
             const double coeff = model.forceCoeff( r, vol( j ) );
             fcx_i = coeff * rx / r;
             fcy_i = coeff * ry / r;
             fcz_i = coeff * rz / r;
 
-            fc( i, 0 ) += fcx_i;
-            fc( i, 1 ) += fcy_i;
-            fc( i, 2 ) += fcz_i;
+            addVector( fc, i, fcx_i, fcy_i, fcz_i );
         };
 
         _timer.start();
@@ -113,20 +295,76 @@ class Force<MemorySpace, NormalRepulsionModel>
     }
 
     // FIXME: implement energy
-    template <class PosType, class WType, class ParticleType,
+    template <class PosType, class DispType, class WType, class ParticleType,
               class ParallelType>
-    double computeEnergyFull( WType&, const PosType&, const PosType&,
+    double computeEnergyFull( WType&, const PosType&, const DispType&,
                               ParticleType&, const int, ParallelType& )
     {
         return 0.0;
     }
 
+    // Add the stiffness of the pairs currently in contact to each owned
+    // particle, for a stable timestep estimate. The contact neighbors from
+    // the last force computation are used.
+    template <class ParticleType, class StiffnessType>
+    void addStiffness( const ParticleType& particles,
+                       const StiffnessType& k ) const
+    {
+        auto model = _model;
+        const auto x = particles.sliceReferencePosition();
+        const auto u = particles.sliceDisplacement();
+        const auto vol = particles.sliceVolume();
+
+        auto contact_stiffness = KOKKOS_LAMBDA( const int i, const int j )
+        {
+            double xi, r, s;
+            getDistance( x, u, i, j, xi, r, s );
+            // Pairs within the skin are not in contact.
+            if ( r > model.Rc )
+                return;
+            // Derivative of the repulsion force with distance.
+            k( i ) += 15.0 * model.c * vol( j ) / model.delta;
+        };
+
+        using exec_space = typename MemorySpace::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
+                                                particles.localOffset() );
+        Cabana::neighbor_parallel_for(
+            policy, contact_stiffness, _neigh_list,
+            Cabana::FirstNeighborsTag(), Cabana::SerialOpTag(),
+            "CabanaPD::Contact::stiffness" );
+    }
+
+    template <class PDNeighborListType, class... BrokenBondType>
+    void excludeBonds( const PDNeighborListType& pd_neigh_list,
+                       const BrokenBondType&... mu )
+    {
+        _neigh_skin.excludeBonds( pd_neigh_list, mu... );
+    }
+    void resetNeighbors() { _neigh_skin.reset(); }
+    auto numNeighborBuilds() const { return _neigh_skin.numBuilds(); }
+    auto timeNeighbor() { return _neigh_skin.time(); };
+
+    void profile( TimerRegistry& timers,
+                  const std::string& name = "Contact" ) const
+    {
+        timers.add( name, _timer );
+        timers.add( name + "::Neighbor", _neigh_skin.getTimer() );
+    }
+
+    void memory( MemoryRegistry& registry,
+                 const std::string& name = "Contact" ) const
+    {
+        registry.add( name + "::Neighbors",
+                      neighborListBytes( _neigh_list ) + _neigh_skin.bytes() );
+    }
+
   protected:
     NormalRepulsionModel _model;
     using base_type::_half_neigh;
     using base_type::_neigh_list;
     using base_type::_timer;
-    Timer _neigh_timer;
+    ContactNeighborSkin<MemorySpace, BondStorageType> _neigh_skin;
 
     double mesh_max[3];
     double mesh_min[3];
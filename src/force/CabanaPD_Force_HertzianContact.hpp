@@ -25,8 +25,8 @@ namespace CabanaPD
 /******************************************************************************
   Normal repulsion forces
 ******************************************************************************/
-template <class MemorySpace>
-class Force<MemorySpace, HertzianModel>
+template <class MemorySpace, class BondStorageType>
+class Force<MemorySpace, HertzianModel, BondStorageType>
     : public Force<MemorySpace, BaseForceModel>
 {
   public:
@@ -35,12 +35,17 @@ class Force<MemorySpace, HertzianModel>
 
     template <class ParticleType>
     Force( const bool half_neigh, const ParticleType& particles,
-           const HertzianModel model )
-        : base_type( half_neigh, model.Rc, particles.sliceCurrentPosition(),
+           const HertzianModel model, const double skin = 0.0 )
+        : base_type( half_neigh, model.Rc + skin,
+                     particles.sliceCurrentPosition(),
                      particles.frozenOffset(), particles.localOffset(),
-                     particles.ghost_mesh_lo, particles.ghost_mesh_hi )
+                     particles.ghost_mesh_lo, particles.ghost_mesh_hi, 1e-14,
+                     particles.spatialIndex() )
         , _model( model )
+        , _neigh_skin( skin )
     {
+        _timer = Timer( "Contact" );
+        _neigh_skin.useSpatialIndex( particles.spatialIndex() );
         for ( int d = 0; d < particles.dim; d++ )
         {
             mesh_min[d] = particles.ghost_mesh_lo[d];
@@ -48,9 +53,9 @@ class Force<MemorySpace, HertzianModel>
         }
     }
 
-    template <class ForceType, class PosType, class ParticleType,
-              class ParallelType>
-    void computeForceFull( ForceType& fc, const PosType& x, const PosType& u,
+    template <class ForceType, class PosType, class DispType,
+              class ParticleType, class ParallelType>
+    void computeForceFull( ForceType& fc, const PosType& x, const DispType& u,
                            const ParticleType& particles,
                            ParallelType& neigh_op_tag )
     {
@@ -63,16 +68,18 @@ class Force<MemorySpace, HertzianModel>
         const auto y = particles.sliceCurrentPosition();
         const auto vel = particles.sliceVelocity();
 
-        _neigh_timer.start();
-        _neigh_list.build( y, n_frozen, n_local, model.Rc, 1.0, mesh_min,
-                           mesh_max );
-        _neigh_timer.stop();
+        _neigh_skin.update( _neigh_list, y, n_frozen, n_local,
+                            particles.referenceOffset(), model.Rc, mesh_min,
+                            mesh_max );
 
         auto contact_full = KOKKOS_LAMBDA( const int i, const int j )
         {
             double xi, r, s;
             double rx, ry, rz;
             getDistanceComponents( x, u, i, j, xi, r, s, rx, ry, rz );
+            // Pairs within the skin are not in contact.
+            if ( r > model.Rc )
+                return;
 
             // Hertz normal force damping component
             double vx, vy, vz, vn;
@@ -80,9 +87,7 @@ class Force<MemorySpace, HertzianModel>
                                                  vy, vz, vn );
 
             const double coeff = model.forceCoeff( r, vn, vol( i ), rho( i ) );
-            fc( i, 0 ) += coeff * rx / r;
-            fc( i, 1 ) += coeff * ry / r;
-            fc( i, 2 ) += coeff * rz / r;
+            addVector( fc, i, coeff * rx / r, coeff * ry / r, coeff * rz / r );
         };
 
         _timer.start();
@@ -98,20 +103,79 @@ class Force<MemorySpace, HertzianModel>
     }
 
     // FIXME: implement energy
-    template <class PosType, class WType, class ParticleType,
+    template <class PosType, class DispType, class WType, class ParticleType,
               class ParallelType>
-    double computeEnergyFull( WType&, const PosType&, const PosType&,
+    double computeEnergyFull( WType&, const PosType&, const DispType&,
                               ParticleType&, ParallelType& )
     {
         return 0.0;
     }
 
+    // Add the stiffness of the pairs currently in contact to each owned
+    // particle, for a stable timestep estimate. The contact neighbors from
+    // the last force computation are used.
+    template <class ParticleType, class StiffnessType>
+    void addStiffness( const ParticleType& particles,
+                       const StiffnessType& k ) const
+    {
+        auto model = _model;
+        const auto x = particles.sliceReferencePosition();
+        const auto u = particles.sliceDisplacement();
+        const auto vol = particles.sliceVolume();
+
+        auto contact_stiffness = KOKKOS_LAMBDA( const int i, const int j )
+        {
+            double xi, r, s;
+            getDistance( x, u, i, j, xi, r, s );
+            // Only overlapping pairs are in contact.
+            const double delta_n = r - 2.0 * model.radius;
+            if ( r > model.Rc || delta_n >= 0.0 )
+                return;
+            // Hertz normal stiffness per volume.
+            k( i ) += 2.0 * model.Es *
+                      Kokkos::sqrt( model.Rs * Kokkos::abs( delta_n ) ) /
+                      vol( i );
+        };
+
+        using exec_space = typename MemorySpace::execution_space;
+        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
+                                                particles.localOffset() );
+        Cabana::neighbor_parallel_for(
+            policy, contact_stiffness, _neigh_list,
+            Cabana::FirstNeighborsTag(), Cabana::SerialOpTag(),
+            "CabanaPD::Contact::stiffness" );
+    }
+
+    template <class PDNeighborListType, class... BrokenBondType>
+    void excludeBonds( const PDNeighborListType& pd_neigh_list,
+                       const BrokenBondType&... mu )
+    {
+        _neigh_skin.excludeBonds( pd_neigh_list, mu... );
+    }
+    void resetNeighbors() { _neigh_skin.reset(); }
+    auto numNeighborBuilds() const { return _neigh_skin.numBuilds(); }
+    auto timeNeighbor() { return _neigh_skin.time(); };
+
+    void profile( TimerRegistry& timers,
+                  const std::string& name = "Contact" ) const
+    {
+        timers.add( name, _timer );
+        timers.add( name + "::Neighbor", _neigh_skin.getTimer() );
+    }
+
+    void memory( MemoryRegistry& registry,
+                 const std::string& name = "Contact" ) const
+    {
+        registry.add( name + "::Neighbors",
+                      neighborListBytes( _neigh_list ) + _neigh_skin.bytes() );
+    }
+
   protected:
     HertzianModel _model;
     using base_type::_half_neigh;
     using base_type::_neigh_list;
     using base_type::_timer;
-    Timer _neigh_timer;
+    ContactNeighborSkin<MemorySpace, BondStorageType> _neigh_skin;
 
     double mesh_max[3];
     double mesh_min[3];
@@ -66,21 +66,26 @@
 #include <CabanaPD_Particles.hpp>
 #include <CabanaPD_Types.hpp>
 #include <force/CabanaPD_ForceModels_LPS.hpp>
+#include <force/CabanaPD_Force_Stiffness.hpp>
 
 namespace CabanaPD
 {
-template <class MemorySpace>
-class Force<MemorySpace, ForceModel<LPS, Elastic, NoFracture>>
+template <class MemorySpace, class... ModelParams>
+class Force<MemorySpace, ForceModel<LPS, Elastic, NoFracture,
+                                    TemperatureIndependent, ModelParams...>>
     : public Force<MemorySpace, BaseForceModel>
 {
   protected:
     using base_type = Force<MemorySpace, BaseForceModel>;
     using base_type::_half_neigh;
-    using model_type = ForceModel<LPS, Elastic, NoFracture>;
+    using model_type = ForceModel<LPS, Elastic, NoFracture,
+                                  TemperatureIndependent, ModelParams...>;
     model_type _model;
 
+    using base_type::_dilatation_timer;
     using base_type::_energy_timer;
     using base_type::_timer;
+    using base_type::_weighted_volume_timer;
 
   public:
     // Using the default exec_space.
@@ -88,25 +93,32 @@ class Force<MemorySpace, ForceModel<LPS, Elastic, NoFracture>>
     using neighbor_list_type = typename base_type::neighbor_list_type;
     using base_type::_neigh_list;
 
+    static constexpr bool has_fused_energy = true;
+
     template <class ParticleType>
     Force( const bool half_neigh, ParticleType& particles,
            const model_type model )
         : base_type( half_neigh, model.delta, particles )
         , _model( model )
     {
+        if ( half_neigh )
+            throw std::runtime_error(
+                "Half neighbor lists are not yet supported for LPS models." );
     }
 
     template <class ParticleType, class ParallelType>
     void computeWeightedVolume( ParticleType& particles,
                                 const ParallelType neigh_op_tag )
     {
-        _timer.start();
+        _weighted_volume_timer.start();
 
         auto x = particles.sliceReferencePosition();
         auto u = particles.sliceDisplacement();
         const auto vol = particles.sliceVolume();
         auto m = particles.sliceWeightedVolume();
         Cabana::deep_copy( m, 0.0 );
+        // Only atomic if using team threading.
+        auto m_a = neighborSlice<ParallelType>( m );
         auto model = _model;
 
         auto weighted_volume = KOKKOS_LAMBDA( const int i, const int j )
@@ -114,7 +126,7 @@ class Force<MemorySpace, ForceModel<LPS, Elastic, NoFracture>>
             // Get the reference positions and displacements.
             double xi, r, s;
             getDistance( x, u, i, j, xi, r, s );
-            m( i ) += model.weightedVolume( xi, vol( j ) );
+            m_a( i ) += model.weightedVolume( xi, vol( j ) );
         };
 
         Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
@@ -122,15 +134,16 @@ class Force<MemorySpace, ForceModel<LPS, Elastic, NoFracture>>
         Cabana::neighbor_parallel_for(
             policy, weighted_volume, _neigh_list, Cabana::FirstNeighborsTag(),
             neigh_op_tag, "CabanaPD::ForceLPS::computeWeightedVolume" );
+        particles.markModified( WeightedVolumeField{} );
 
-        _timer.stop();
+        _weighted_volume_timer.stop();
     }
 
     template <class ParticleType, class ParallelType>
     void computeDilatation( ParticleType& particles,
                             const ParallelType neigh_op_tag )
     {
-        _timer.start();
+        _dilatation_timer.start();
 
         const auto x = particles.sliceReferencePosition();
         auto u = particles.sliceDisplacement();
@@ -139,27 +152,31 @@ class Force<MemorySpace, ForceModel<LPS, Elastic, NoFracture>>
         auto theta = particles.sliceDilatation();
         auto model = _model;
         Cabana::deep_copy( theta, 0.0 );
+        // Only atomic if using team threading.
+        auto theta_a = neighborSlice<ParallelType>( theta );
 
         auto dilatation = KOKKOS_LAMBDA( const int i, const int j )
         {
             // Get the bond distance, displacement, and stretch.
             double xi, r, s;
             getDistance( x, u, i, j, xi, r, s );
-            theta( i ) += model.dilatation( s, xi, vol( j ), m( i ) );
+            theta_a( i ) += model.dilatation( s, xi, vol( j ), m( i ) );
         };
 
-        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
-                                                particles.localOffset() );
+        Kokkos::RangePolicy<exec_space> policy(
+            base_type::particleBegin( particles ),
+            base_type::particleEnd( particles ) );
         Cabana::neighbor_parallel_for(
             policy, dilatation, _neigh_list, Cabana::FirstNeighborsTag(),
             neigh_op_tag, "CabanaPD::ForceLPS::computeDilatation" );
+        particles.markModified( DilatationField{} );
 
-        _timer.stop();
+        _dilatation_timer.stop();
     }
 
-    template <class ForceType, class PosType, class ParticleType,
-              class ParallelType>
-    void computeForceFull( ForceType& f, const PosType& x, const PosType& u,
+    template <class ForceType, class PosType, class DispType,
+              class ParticleType, class ParallelType>
+    void computeForceFull( ForceType& f, const PosType& x, const DispType& u,
                            const ParticleType& particles,
                            ParallelType& neigh_op_tag )
     {
@@ -185,13 +202,12 @@ class Force<MemorySpace, ForceModel<LPS, Elastic, NoFracture>>
             fy_i = coeff * ry / r;
             fz_i = coeff * rz / r;
 
-            f( i, 0 ) += fx_i;
-            f( i, 1 ) += fy_i;
-            f( i, 2 ) += fz_i;
+            addVector( f, i, fx_i, fy_i, fz_i );
         };
 
-        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
-                                                particles.localOffset() );
+        Kokkos::RangePolicy<exec_space> policy(
+            base_type::particleBegin( particles ),
+            base_type::particleEnd( particles ) );
         Cabana::neighbor_parallel_for(
             policy, force_full, _neigh_list, Cabana::FirstNeighborsTag(),
             neigh_op_tag, "CabanaPD::ForceLPS::computeFull" );
@@ -199,9 +215,9 @@ class Force<MemorySpace, ForceModel<LPS, Elastic, NoFracture>>
         _timer.stop();
     }
 
-    template <class PosType, class WType, class ParticleType,
+    template <class PosType, class DispType, class WType, class ParticleType,
               class ParallelType>
-    double computeEnergyFull( WType& W, const PosType& x, const PosType& u,
+    double computeEnergyFull( WType& W, const PosType& x, const DispType& u,
                               const ParticleType& particles,
                               ParallelType& neigh_op_tag )
     {
@@ -243,26 +259,87 @@ class Force<MemorySpace, ForceModel<LPS, Elastic, NoFracture>>
         return strain_energy;
     }
 
-    auto time() { return _timer.time(); };
-    auto timeEnergy() { return _energy_timer.time(); };
+    // Single neighbor pass for force and energy.
+    template <class ForceType, class WType, class PosType, class DispType,
+              class ParticleType, class ParallelType>
+    double computeForceEnergyFull( ForceType& f, WType& W, const PosType& x,
+                                   const DispType& u,
+                                   const ParticleType& particles,
+                                   ParallelType& neigh_op_tag )
+    {
+        _timer.start();
+
+        auto model = _model;
+        auto neigh_list = _neigh_list;
+
+        const auto vol = particles.sliceVolume();
+        const auto theta = particles.sliceDilatation();
+        auto m = particles.sliceWeightedVolume();
+
+        auto force_energy_full =
+            KOKKOS_LAMBDA( const int i, const int j, double& Phi )
+        {
+            double xi, r, s;
+            double rx, ry, rz;
+            getDistanceComponents( x, u, i, j, xi, r, s, rx, ry, rz );
+
+            const double coeff = model.forceCoeff(
+                s, xi, vol( j ), m( i ), m( j ), theta( i ), theta( j ) );
+            addVector( f, i, coeff * rx / r, coeff * ry / r, coeff * rz / r );
+
+            double num_neighbors = static_cast<double>(
+                Cabana::NeighborList<neighbor_list_type>::numNeighbor(
+                    neigh_list, i ) );
+
+            double w = model.energy( s, xi, vol( j ), m( i ), theta( i ),
+                                     num_neighbors );
+            W( i ) += w;
+            Phi += w * vol( i );
+        };
+
+        double strain_energy = 0.0;
+        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
+                                                particles.localOffset() );
+        Cabana::neighbor_parallel_reduce(
+            policy, force_energy_full, _neigh_list,
+            Cabana::FirstNeighborsTag(), neigh_op_tag, strain_energy,
+            "CabanaPD::ForceLPS::computeForceEnergyFull" );
+
+        _timer.stop();
+        return strain_energy;
+    }
 };
 
-template <class MemorySpace>
-class Force<MemorySpace, ForceModel<LPS, Elastic, Fracture>>
-    : public Force<MemorySpace, ForceModel<LPS, Elastic, NoFracture>>,
-      public BaseFracture<MemorySpace>
+template <class MemorySpace, class BondStorageType, class BondCacheType,
+          class... ModelParams>
+class Force<MemorySpace,
+            ForceModel<LPS, Elastic, Fracture, TemperatureIndependent,
+                       ModelParams...>,
+            BondStorageType, BondCacheType>
+    : public Force<MemorySpace, ForceModel<LPS, Elastic, NoFracture,
+                                           TemperatureIndependent,
+                                           ModelParams...>>,
+      public BaseFracture<MemorySpace, BondStorageType, BondCacheType>
 {
   protected:
-    using fracture_type = BaseFracture<MemorySpace>;
+    using fracture_type =
+        BaseFracture<MemorySpace, BondStorageType, BondCacheType>;
+    using fracture_type::_bond_cache;
     using fracture_type::_mu;
+    using fracture_type::_removed_volume;
 
-    using base_type = Force<MemorySpace, ForceModel<LPS, Elastic, NoFracture>>;
+    using base_type =
+        Force<MemorySpace, ForceModel<LPS, Elastic, NoFracture,
+                                      TemperatureIndependent, ModelParams...>>;
     using base_type::_half_neigh;
-    using model_type = ForceModel<LPS, Elastic, Fracture>;
+    using model_type = ForceModel<LPS, Elastic, Fracture,
+                                  TemperatureIndependent, ModelParams...>;
     model_type _model;
 
+    using base_type::_dilatation_timer;
     using base_type::_energy_timer;
     using base_type::_timer;
+    using base_type::_weighted_volume_timer;
 
   public:
     // Using the default exec_space.
@@ -270,14 +347,63 @@ class Force<MemorySpace, ForceModel<LPS, Elastic, Fracture>>
     using neighbor_list_type = typename base_type::neighbor_list_type;
     using base_type::_neigh_list;
 
+    static constexpr bool has_bond_breaking = true;
+    static_assert( !is_csr_storage<BondStorageType>::value,
+                   "CSR bond storage is only supported by PMB models." );
+
     template <class ParticleType>
     Force( const bool half_neigh, const ParticleType& particles,
            const model_type model )
         : base_type( half_neigh, particles, model )
-        , fracture_type( particles.localOffset(),
-                         base_type::getMaxLocalNeighbors() )
+        , fracture_type( _neigh_list, particles.localOffset(),
+                         base_type::getMaxLocalNeighbors(),
+                         particles.frozenOffset() )
         , _model( model )
     {
+        fracture_type::buildBondCache(
+            _neigh_list, particles.sliceReferencePosition(),
+            particles.sliceVolume(), particles.frozenOffset(),
+            particles.localOffset(), base_type::getMaxLocalNeighbors() );
+        fracture_type::buildBondInfluence( _model.influence,
+                                           particles.frozenOffset(),
+                                           particles.localOffset() );
+    }
+
+    // Rebuild neighbors after particle migration, given the broken bonds
+    // migrated with the particles (stored in sorted neighbor order).
+    template <class ParticleType, class NeighborView>
+    void rebuildNeighbors( const ParticleType& particles,
+                           const NeighborView& mu )
+    {
+        base_type::rebuildNeighbors( particles );
+        fracture_type::rebuildFracture(
+            mu, _neigh_list, particles.sliceReferencePosition(),
+            particles.sliceVolume(), particles.frozenOffset(),
+            particles.localOffset(), base_type::getMaxLocalNeighbors() );
+        fracture_type::buildBondInfluence( _model.influence,
+                                           particles.frozenOffset(),
+                                           particles.localOffset() );
+    }
+
+    // Remove broken bonds from the neighbor list once at least the given
+    // fraction is broken. Returns whether the bonds were compacted.
+    template <class ParticleType>
+    bool compactBonds( const ParticleType& particles, const double threshold )
+    {
+        const auto begin = particles.frozenOffset();
+        const auto end = particles.localOffset();
+        if ( fracture_type::brokenBondFraction( _neigh_list, begin, end ) <
+             threshold )
+            return false;
+
+        fracture_type::compactBonds(
+            _neigh_list, particles.sliceReferencePosition(),
+            particles.sliceVolume(), begin, end,
+            base_type::getMaxLocalNeighbors() );
+        fracture_type::buildBondInfluence( _model.influence,
+                                           particles.frozenOffset(),
+                                           particles.localOffset() );
+        return true;
     }
 
     template <class ExecSpace, class ParticleType, class PrenotchType>
@@ -288,9 +414,10 @@ class Force<MemorySpace, ForceModel<LPS, Elastic, Fracture>>
     }
 
     template <class ParticleType, class ParallelType>
-    void computeWeightedVolume( ParticleType& particles, ParallelType )
+    void computeWeightedVolume( ParticleType& particles,
+                                const ParallelType neigh_op_tag )
     {
-        _timer.start();
+        _weighted_volume_timer.start();
 
         auto x = particles.sliceReferencePosition();
         auto u = particles.sliceDisplacement();
@@ -298,40 +425,42 @@ class Force<MemorySpace, ForceModel<LPS, Elastic, Fracture>>
         auto m = particles.sliceWeightedVolume();
         Cabana::deep_copy( m, 0.0 );
         auto model = _model;
-        auto neigh_list = _neigh_list;
         auto mu = _mu;
+        auto bond_cache = _bond_cache;
 
-        auto weighted_volume = KOKKOS_LAMBDA( const int i )
+        auto weighted_volume_bond = KOKKOS_LAMBDA(
+            const int i, const std::size_t j, const std::size_t n,
+            BondSum<1>& m_i )
         {
-            std::size_t num_neighbors =
-                Cabana::NeighborList<neighbor_list_type>::numNeighbor(
-                    neigh_list, i );
-            for ( std::size_t n = 0; n < num_neighbors; n++ )
-            {
-                std::size_t j =
-                    Cabana::NeighborList<neighbor_list_type>::getNeighbor(
-                        neigh_list, i, n );
-
-                // Get the reference positions and displacements.
-                double xi, r, s;
-                getDistance( x, u, i, j, xi, r, s );
-                // mu is included to account for bond breaking.
-                m( i ) += mu( i, n ) * model.weightedVolume( xi, vol( j ) );
-            }
+            // Get the reference positions and displacements.
+            double xi, r, s;
+            bond_cache.getDistance( x, u, i, j, n, xi, r, s );
+            const double vol_j = bond_cache.volume( vol, i, j, n );
+            const double omega =
+                bond_cache.influence( model.influence, xi, i, n );
+            // mu is included to account for bond breaking.
+            m_i[0] += mu( i, n ) * model.weightedVolume( xi, vol_j, omega );
+        };
+        auto weighted_volume_particle =
+            KOKKOS_LAMBDA( const int i, const BondSum<1>& m_i )
+        {
+            m( i ) += m_i[0];
         };
 
-        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
-                                                particles.localOffset() );
-        Kokkos::parallel_for( "CabanaPD::ForceLPSDamage::computeWeightedVolume",
-                              policy, weighted_volume );
+        bondParallelFor<BondSum<1>>(
+            "CabanaPD::ForceLPSDamage::computeWeightedVolume", exec_space{},
+            particles.frozenOffset(), particles.localOffset(), _neigh_list,
+            weighted_volume_bond, weighted_volume_particle, neigh_op_tag );
+        particles.markModified( WeightedVolumeField{} );
 
-        _timer.stop();
+        _weighted_volume_timer.stop();
     }
 
     template <class ParticleType, class ParallelType>
-    void computeDilatation( ParticleType& particles, ParallelType )
+    void computeDilatation( ParticleType& particles,
+                            const ParallelType neigh_op_tag )
     {
-        _timer.start();
+        _dilatation_timer.start();
 
         const auto x = particles.sliceReferencePosition();
         auto u = particles.sliceDisplacement();
@@ -339,169 +468,275 @@ class Force<MemorySpace, ForceModel<LPS, Elastic, Fracture>>
         auto m = particles.sliceWeightedVolume();
         auto theta = particles.sliceDilatation();
         auto model = _model;
-        auto neigh_list = _neigh_list;
         auto mu = _mu;
+        auto bond_cache = _bond_cache;
         Cabana::deep_copy( theta, 0.0 );
 
-        auto dilatation = KOKKOS_LAMBDA( const int i )
+        auto dilatation_bond = KOKKOS_LAMBDA(
+            const int i, const std::size_t j, const std::size_t n,
+            BondSum<1>& theta_i )
         {
-            std::size_t num_neighbors =
-                Cabana::NeighborList<neighbor_list_type>::numNeighbor(
-                    neigh_list, i );
-            for ( std::size_t n = 0; n < num_neighbors; n++ )
-            {
-                std::size_t j =
-                    Cabana::NeighborList<neighbor_list_type>::getNeighbor(
-                        neigh_list, i, n );
-
-                // Get the bond distance, displacement, and stretch.
-                double xi, r, s;
-                getDistance( x, u, i, j, xi, r, s );
-
-                // Check if all bonds are broken (m=0) to avoid dividing by
-                // zero. Alternatively, one could check if this bond mu(i,n) is
-                // broken, because m=0 only occurs when all bonds are broken.
-                // mu is still included to account for individual bond breaking.
-                if ( m( i ) > 0 )
-                    theta( i ) += mu( i, n ) *
-                                  model.dilatation( s, xi, vol( j ), m( i ) );
-            }
+            // Get the bond distance, displacement, and stretch.
+            double xi, r, s;
+            bond_cache.getDistance( x, u, i, j, n, xi, r, s );
+            const double vol_j = bond_cache.volume( vol, i, j, n );
+            const double omega =
+                bond_cache.influence( model.influence, xi, i, n );
+
+            // Check if all bonds are broken (m=0) to avoid dividing by
+            // zero. Alternatively, one could check if this bond mu(i,n) is
+            // broken, because m=0 only occurs when all bonds are broken.
+            // mu is still included to account for individual bond breaking.
+            if ( m( i ) > 0 )
+                theta_i[0] += mu( i, n ) * model.dilatation( s, xi, vol_j,
+                                                             m( i ), omega );
+        };
+        auto dilatation_particle =
+            KOKKOS_LAMBDA( const int i, const BondSum<1>& theta_i )
+        {
+            theta( i ) += theta_i[0];
         };
 
-        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
-                                                particles.localOffset() );
-        Kokkos::parallel_for( "CabanaPD::ForceLPSDamage::computeDilatation",
-                              policy, dilatation );
+        bondParallelFor<BondSum<1>>(
+            "CabanaPD::ForceLPSDamage::computeDilatation", exec_space{},
+            base_type::particleBegin( particles ),
+            base_type::particleEnd( particles ), _neigh_list, dilatation_bond,
+            dilatation_particle, neigh_op_tag );
+        particles.markModified( DilatationField{} );
 
-        _timer.stop();
+        _dilatation_timer.stop();
     }
 
-    template <class ForceType, class PosType, class ParticleType,
-              class ParallelType>
-    void computeForceFull( ForceType& f, const PosType& x, const PosType& u,
-                           const ParticleType& particles, ParallelType )
+    template <class ForceType, class PosType, class DispType,
+              class ParticleType, class ParallelType,
+              class BreakType = BondBreaking>
+    void computeForceFull( ForceType& f, const PosType& x, const DispType& u,
+                           const ParticleType& particles,
+                           ParallelType neigh_op_tag, BreakType = {} )
     {
         _timer.start();
 
+        // Bond breaking is compiled out for intermediate integrator stages.
+        constexpr bool break_bonds =
+            std::is_same<BreakType, BondBreaking>::value;
+
         auto break_coeff = _model.bond_break_coeff;
         auto model = _model;
-        auto neigh_list = _neigh_list;
         auto mu = _mu;
+        auto bond_cache = _bond_cache;
 
         const auto vol = particles.sliceVolume();
         auto theta = particles.sliceDilatation();
         auto m = particles.sliceWeightedVolume();
         const auto nofail = particles.sliceNoFail();
-        auto force_full = KOKKOS_LAMBDA( const int i )
+
+        auto force_bond = KOKKOS_LAMBDA( const int i, const std::size_t j,
+                                         const std::size_t n, BondSum<3>& f_i )
         {
-            std::size_t num_neighbors =
-                Cabana::NeighborList<neighbor_list_type>::numNeighbor(
-                    neigh_list, i );
-            for ( std::size_t n = 0; n < num_neighbors; n++ )
+            // Get the reference positions and displacements.
+            double xi, r, s;
+            double rx, ry, rz;
+            bond_cache.getDistanceComponents( x, u, i, j, n, xi, r, s, rx, ry,
+                                              rz );
+            const double vol_j = bond_cache.volume( vol, i, j, n );
+            const double omega =
+                bond_cache.influence( model.influence, xi, i, n );
+
+            // Break if beyond critical stretch unless in no-fail zone.
+            if ( break_bonds && r * r >= break_coeff * xi * xi &&
+                 !nofail( i ) && !nofail( i ) )
+            {
+                mu.breakBond( i, n );
+            }
+            // Check if this bond is broken (mu=0) to ensure m(i) and m(j)
+            // are both >0 (m=0 only occurs when all bonds are broken) to
+            // avoid dividing by zero.
+            else if ( mu( i, n ) > 0 )
             {
-                double fx_i = 0.0;
-                double fy_i = 0.0;
-                double fz_i = 0.0;
-
-                std::size_t j =
-                    Cabana::NeighborList<neighbor_list_type>::getNeighbor(
-                        neigh_list, i, n );
-
-                // Get the reference positions and displacements.
-                double xi, r, s;
-                double rx, ry, rz;
-                getDistanceComponents( x, u, i, j, xi, r, s, rx, ry, rz );
-
-                // Break if beyond critical stretch unless in no-fail zone.
-                if ( r * r >= break_coeff * xi * xi && !nofail( i ) &&
-                     !nofail( i ) )
-                {
-                    mu( i, n ) = 0;
-                }
-                // Check if this bond is broken (mu=0) to ensure m(i) and m(j)
-                // are both >0 (m=0 only occurs when all bonds are broken) to
-                // avoid dividing by zero.
-                else if ( mu( i, n ) > 0 )
-                {
-                    const double coeff =
-                        model.forceCoeff( s, xi, vol( j ), m( i ), m( j ),
-                                          theta( i ), theta( j ) );
-                    double muij = mu( i, n );
-                    fx_i = muij * coeff * rx / r;
-                    fy_i = muij * coeff * ry / r;
-                    fz_i = muij * coeff * rz / r;
-
-                    f( i, 0 ) += fx_i;
-                    f( i, 1 ) += fy_i;
-                    f( i, 2 ) += fz_i;
-                }
+                const double coeff =
+                    model.forceCoeff( s, xi, vol_j, m( i ), m( j ), theta( i ),
+                                      theta( j ), omega );
+                double muij = mu( i, n );
+                f_i[0] += muij * coeff * rx / r;
+                f_i[1] += muij * coeff * ry / r;
+                f_i[2] += muij * coeff * rz / r;
             }
         };
+        auto force_particle =
+            KOKKOS_LAMBDA( const int i, const BondSum<3>& f_i )
+        {
+            addVector( f, i, f_i[0], f_i[1], f_i[2] );
+        };
 
-        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
-                                                particles.localOffset() );
-        Kokkos::parallel_for( "CabanaPD::ForceLPSDamage::computeFull", policy,
-                              force_full );
+        bondParallelFor<BondSum<3>>(
+            "CabanaPD::ForceLPSDamage::computeFull", exec_space{},
+            base_type::particleBegin( particles ),
+            base_type::particleEnd( particles ), _neigh_list, force_bond,
+            force_particle, neigh_op_tag );
 
         _timer.stop();
     }
 
-    template <class PosType, class WType, class ParticleType,
+    template <class PosType, class DispType, class WType, class ParticleType,
               class ParallelType>
-    double computeEnergyFull( WType& W, const PosType& x, const PosType& u,
-                              ParticleType& particles, ParallelType& )
+    double computeEnergyFull( WType& W, const PosType& x, const DispType& u,
+                              ParticleType& particles,
+                              ParallelType& neigh_op_tag )
     {
         _energy_timer.start();
 
         auto model = _model;
-        auto neigh_list = _neigh_list;
         auto mu = _mu;
+        auto bond_cache = _bond_cache;
 
         const auto vol = particles.sliceVolume();
         const auto theta = particles.sliceDilatation();
         auto m = particles.sliceWeightedVolume();
         auto phi = particles.sliceDamage();
+        const auto removed_volume = _removed_volume;
 
-        auto energy_full = KOKKOS_LAMBDA( const int i, double& Phi )
+        auto count_bond = KOKKOS_LAMBDA( const int i, const std::size_t,
+                                         const std::size_t n,
+                                         BondSum<1>& num_bonds )
         {
-            std::size_t num_neighbors =
-                Cabana::NeighborList<neighbor_list_type>::numNeighbor(
-                    neigh_list, i );
-            double num_bonds = 0.0;
-            for ( std::size_t n = 0; n < num_neighbors; n++ )
-                num_bonds += static_cast<double>( mu( i, n ) );
-
-            double phi_i = 0.0;
-            double vol_H_i = 0.0;
-            for ( std::size_t n = 0; n < num_neighbors; n++ )
-            {
-                std::size_t j =
-                    Cabana::NeighborList<neighbor_list_type>::getNeighbor(
-                        neigh_list, i, n );
-                // Get the bond distance, displacement, and stretch.
-                double xi, r, s;
-                getDistance( x, u, i, j, xi, r, s );
-
-                double w = mu( i, n ) * model.energy( s, xi, vol( j ), m( i ),
-                                                      theta( i ), num_bonds );
-                W( i ) += w;
-
-                phi_i += mu( i, n ) * vol( j );
-                vol_H_i += vol( j );
-            }
+            num_bonds[0] += static_cast<double>( mu( i, n ) );
+        };
+        // Sums of energy, intact bond volume, and total bond volume.
+        auto energy_bond = KOKKOS_LAMBDA(
+            const int i, const std::size_t j, const std::size_t n,
+            const BondSum<1>& num_bonds, BondSum<3>& sum )
+        {
+            // Get the bond distance, displacement, and stretch.
+            double xi, r, s;
+            bond_cache.getDistance( x, u, i, j, n, xi, r, s );
+            const double vol_j = bond_cache.volume( vol, i, j, n );
+            const double omega =
+                bond_cache.influence( model.influence, xi, i, n );
+
+            sum[0] += mu( i, n ) * model.energy( s, xi, vol_j, m( i ),
+                                                 theta( i ), num_bonds[0],
+                                                 omega );
+            sum[1] += mu( i, n ) * vol_j;
+            sum[2] += vol_j;
+        };
+        auto energy_particle =
+            KOKKOS_LAMBDA( const int i, const BondSum<1>&,
+                           const BondSum<3>& sum, double& Phi )
+        {
+            W( i ) += sum[0];
             Phi += W( i ) * vol( i );
-            phi( i ) = 1 - phi_i / vol_H_i;
+            phi( i ) = 1 - sum[1] / ( sum[2] + removed_volume( i ) );
         };
 
         double strain_energy = 0.0;
-        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
-                                                particles.localOffset() );
-        Kokkos::parallel_reduce( "CabanaPD::ForceLPSDamage::computeEnergyFull",
-                                 policy, energy_full, strain_energy );
+        twoPassBondParallelReduce<BondSum<1>, BondSum<3>>(
+            "CabanaPD::ForceLPSDamage::computeEnergyFull", exec_space{},
+            particles.frozenOffset(), particles.localOffset(), _neigh_list,
+            count_bond, energy_bond, energy_particle, strain_energy,
+            neigh_op_tag );
 
         _energy_timer.stop();
         return strain_energy;
     }
+
+    // Single kernel for force, energy, and damage (optionally without checking
+    // for new broken bonds). The bond count used for the energy depends on
+    // bonds broken in this step, so the neighbors are traversed twice for
+    // each particle.
+    template <class ForceType, class WType, class PosType, class DispType,
+              class ParticleType, class ParallelType,
+              class BreakType = BondBreaking>
+    double computeForceEnergyFull( ForceType& f, WType& W, const PosType& x,
+                                   const DispType& u, ParticleType& particles,
+                                   ParallelType& neigh_op_tag, BreakType = {} )
+    {
+        _timer.start();
+
+        constexpr bool break_bonds =
+            std::is_same<BreakType, BondBreaking>::value;
+
+        auto break_coeff = _model.bond_break_coeff;
+        auto model = _model;
+        auto mu = _mu;
+        auto bond_cache = _bond_cache;
+
+        const auto vol = particles.sliceVolume();
+        const auto theta = particles.sliceDilatation();
+        auto m = particles.sliceWeightedVolume();
+        const auto nofail = particles.sliceNoFail();
+        auto phi = particles.sliceDamage();
+        const auto removed_volume = _removed_volume;
+
+        // Sums of force and intact bond count.
+        auto force_bond = KOKKOS_LAMBDA( const int i, const std::size_t j,
+                                         const std::size_t n, BondSum<4>& f_i )
+        {
+            // Get the reference positions and displacements.
+            double xi, r, s;
+            double rx, ry, rz;
+            bond_cache.getDistanceComponents( x, u, i, j, n, xi, r, s, rx, ry,
+                                              rz );
+            const double vol_j = bond_cache.volume( vol, i, j, n );
+            const double omega =
+                bond_cache.influence( model.influence, xi, i, n );
+
+            // Break if beyond critical stretch unless in no-fail zone.
+            if ( break_bonds && r * r >= break_coeff * xi * xi &&
+                 !nofail( i ) && !nofail( i ) )
+            {
+                mu.breakBond( i, n );
+            }
+            // Check if this bond is broken (mu=0) to ensure m(i) and m(j)
+            // are both >0 (m=0 only occurs when all bonds are broken) to
+            // avoid dividing by zero.
+            else if ( mu( i, n ) > 0 )
+            {
+                const double coeff =
+                    model.forceCoeff( s, xi, vol_j, m( i ), m( j ), theta( i ),
+                                      theta( j ), omega );
+                f_i[0] += coeff * rx / r;
+                f_i[1] += coeff * ry / r;
+                f_i[2] += coeff * rz / r;
+                f_i[3] += 1.0;
+            }
+        };
+        // Sums of energy, intact bond volume, and total bond volume.
+        auto energy_bond = KOKKOS_LAMBDA(
+            const int i, const std::size_t j, const std::size_t n,
+            const BondSum<4>& f_i, BondSum<3>& sum )
+        {
+            // Get the bond distance, displacement, and stretch.
+            double xi, r, s;
+            bond_cache.getDistance( x, u, i, j, n, xi, r, s );
+            const double vol_j = bond_cache.volume( vol, i, j, n );
+            const double omega =
+                bond_cache.influence( model.influence, xi, i, n );
+
+            sum[0] += mu( i, n ) * model.energy( s, xi, vol_j, m( i ),
+                                                 theta( i ), f_i[3], omega );
+            sum[1] += mu( i, n ) * vol_j;
+            sum[2] += vol_j;
+        };
+        auto force_energy_particle =
+            KOKKOS_LAMBDA( const int i, const BondSum<4>& f_i,
+                           const BondSum<3>& sum, double& Phi )
+        {
+            addVector( f, i, f_i[0], f_i[1], f_i[2] );
+            W( i ) += sum[0];
+            Phi += sum[0] * vol( i );
+            phi( i ) = 1 - sum[1] / ( sum[2] + removed_volume( i ) );
+        };
+
+        double strain_energy = 0.0;
+        twoPassBondParallelReduce<BondSum<4>, BondSum<3>>(
+            "CabanaPD::ForceLPSDamage::computeForceEnergyFull", exec_space{},
+            particles.frozenOffset(), particles.localOffset(), _neigh_list,
+            force_bond, energy_bond, force_energy_particle, strain_energy,
+            neigh_op_tag );
+
+        _timer.stop();
+        return strain_energy;
+    }
 };
 
 template <class MemorySpace>
@@ -513,6 +748,10 @@ class Force<MemorySpace, ForceModel<LinearLPS, Elastic, NoFracture>>
     using model_type = ForceModel<LinearLPS, Elastic, NoFracture>;
     model_type _model;
 
+    StiffnessOperator<MemorySpace> _stiffness;
+    bool _use_stiffness = false;
+
+    using base_type::_dilatation_timer;
     using base_type::_energy_timer;
     using base_type::_timer;
 
@@ -522,6 +761,10 @@ class Force<MemorySpace, ForceModel<LinearLPS, Elastic, NoFracture>>
     using neighbor_list_type = typename base_type::neighbor_list_type;
     using base_type::_neigh_list;
 
+    // The LPS fused kernel does not apply to the linearized model.
+    static constexpr bool has_fused_energy = false;
+    static constexpr bool has_stiffness_operator = true;
+
     template <class ParticleType>
     Force( const bool half_neigh, ParticleType& particles,
            const model_type model )
@@ -530,17 +773,64 @@ class Force<MemorySpace, ForceModel<LinearLPS, Elastic, NoFracture>>
     {
     }
 
-    template <class ForceType, class PosType, class ParticleType,
-              class ParallelType>
-    void computeForceFull( ForceType& f, const PosType& x, const PosType& u,
+    // Assemble the bond stiffness and the (linearized) dilatation coupling
+    // once from the current neighbor list. The weighted volume must be
+    // computed and gathered first.
+    template <class ParticleType>
+    void assembleStiffness( const ParticleType& particles )
+    {
+        const auto x = particles.sliceReferencePosition();
+        const auto vol = particles.sliceVolume();
+        const auto m = particles.sliceWeightedVolume();
+        LPSStiffness<model_type, decltype( vol ), decltype( m )> bond{
+            _model, vol, m };
+        _stiffness.assemble( _neigh_list, particles.frozenOffset(),
+                             particles.localOffset(), x, bond );
+        _use_stiffness = true;
+    }
+
+    auto& getStiffness() const { return _stiffness; }
+
+    // The assembled dilatation uses the linearized stretch.
+    template <class ParticleType, class ParallelType>
+    void computeDilatation( ParticleType& particles,
+                            const ParallelType neigh_op_tag )
+    {
+        if ( !_use_stiffness )
+        {
+            base_type::computeDilatation( particles, neigh_op_tag );
+            return;
+        }
+
+        _dilatation_timer.start();
+        auto u = particles.sliceDisplacement();
+        auto theta = particles.sliceDilatation();
+        _stiffness.dilatation( theta, u, base_type::particleBegin( particles ),
+                               base_type::particleEnd( particles ) );
+        particles.markModified( DilatationField{} );
+        _dilatation_timer.stop();
+    }
+
+    template <class ForceType, class PosType, class DispType,
+              class ParticleType, class ParallelType>
+    void computeForceFull( ForceType& f, const PosType& x, const DispType& u,
                            const ParticleType& particles,
                            ParallelType& neigh_op_tag )
     {
         _timer.start();
 
+        auto theta = particles.sliceDilatation();
+        if ( _use_stiffness )
+        {
+            _stiffness.apply( f, u, theta,
+                              base_type::particleBegin( particles ),
+                              base_type::particleEnd( particles ) );
+            _timer.stop();
+            return;
+        }
+
         auto model = _model;
         const auto vol = particles.sliceVolume();
-        auto theta = particles.sliceDilatation();
         // Using weighted volume from base LPS class.
         auto m = particles.sliceWeightedVolume();
 
@@ -563,13 +853,12 @@ class Force<MemorySpace, ForceModel<LinearLPS, Elastic, NoFracture>>
             fy_i = coeff * xi_y / xi;
             fz_i = coeff * xi_z / xi;
 
-            f( i, 0 ) += fx_i;
-            f( i, 1 ) += fy_i;
-            f( i, 2 ) += fz_i;
+            addVector( f, i, fx_i, fy_i, fz_i );
         };
 
-        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
-                                                particles.localOffset() );
+        Kokkos::RangePolicy<exec_space> policy(
+            base_type::particleBegin( particles ),
+            base_type::particleEnd( particles ) );
         Cabana::neighbor_parallel_for(
             policy, force_full, _neigh_list, Cabana::FirstNeighborsTag(),
             neigh_op_tag, "CabanaPD::ForceLPS::computeFull" );
@@ -577,9 +866,9 @@ class Force<MemorySpace, ForceModel<LinearLPS, Elastic, NoFracture>>
         _timer.stop();
     }
 
-    template <class PosType, class WType, class ParticleType,
+    template <class PosType, class DispType, class WType, class ParticleType,
               class ParallelType>
-    double computeEnergyFull( WType& W, const PosType& x, const PosType& u,
+    double computeEnergyFull( WType& W, const PosType& x, const DispType& u,
                               const ParticleType& particles,
                               ParallelType& neigh_op_tag )
     {
@@ -621,6 +910,13 @@ class Force<MemorySpace, ForceModel<LinearLPS, Elastic, NoFracture>>
         _energy_timer.stop();
         return strain_energy;
     }
+
+    void neighborMemory( MemoryRegistry& registry ) const
+    {
+        base_type::neighborMemory( registry );
+        if ( _use_stiffness )
+            registry.add( "Force::Stiffness", _stiffness.bytes() );
+    }
 };
 
 } // namespace CabanaPD
@@ -67,6 +67,8 @@
 #include <CabanaPD_Particles.hpp>
 #include <CabanaPD_Types.hpp>
 #include <force/CabanaPD_ForceModels_PMB.hpp>
+#include <force/CabanaPD_Force_SIMD.hpp>
+#include <force/CabanaPD_Force_Stiffness.hpp>
 
 namespace CabanaPD
 {
@@ -80,8 +82,20 @@ class Force<MemorySpace, ForceModel<PMB, Elastic, NoFracture, ModelParams...>>
     using model_type = ForceModel<PMB, Elastic, NoFracture, ModelParams...>;
     using base_type = Force<MemorySpace, BaseForceModel>;
     using neighbor_list_type = typename base_type::neighbor_list_type;
+    using half_neighbor_list_type =
+        typename base_type::half_neighbor_list_type;
+    using base_type::_half_neigh_list;
     using base_type::_neigh_list;
 
+    static constexpr bool has_fused_energy = true;
+    static constexpr bool has_fused_conduction =
+        is_heat_transfer<typename model_type::thermal_type>::value;
+    // Explicit SIMD force kernel for host execution (see simdForcePMB).
+    static constexpr bool use_simd =
+        is_simd_space<exec_space>::value &&
+        std::is_same<model_type, ForceModel<PMB, Elastic, NoFracture,
+                                            TemperatureIndependent>>::value;
+
   protected:
     using base_type::_half_neigh;
     model_type _model;
@@ -98,9 +112,9 @@ class Force<MemorySpace, ForceModel<PMB, Elastic, NoFracture, ModelParams...>>
     {
     }
 
-    template <class ForceType, class PosType, class ParticleType,
-              class ParallelType>
-    void computeForceFull( ForceType& f, const PosType& x, const PosType& u,
+    template <class ForceType, class PosType, class DispType,
+              class ParticleType, class ParallelType>
+    void computeForceFull( ForceType& f, const PosType& x, const DispType& u,
                            const ParticleType& particles,
                            ParallelType& neigh_op_tag )
     {
@@ -109,6 +123,19 @@ class Force<MemorySpace, ForceModel<PMB, Elastic, NoFracture, ModelParams...>>
         auto model = _model;
         const auto vol = particles.sliceVolume();
 
+        if constexpr ( use_simd && ParticleType::dim == 3 )
+        {
+            simdForcePMB<false>( "CabanaPD::ForcePMB::computeFullSIMD",
+                                 exec_space{},
+                                 base_type::particleBegin( particles ),
+                                 base_type::particleEnd( particles ),
+                                 _neigh_list, f, x, u, vol,
+                                 particles.sliceNoFail(), IntactBonds{},
+                                 model.c, 0.0 );
+            _timer.stop();
+            return;
+        }
+
         auto force_full = KOKKOS_LAMBDA( const int i, const int j )
         {
             double fx_i = 0.0;
@@ -121,18 +148,17 @@ class Force<MemorySpace, ForceModel<PMB, Elastic, NoFracture, ModelParams...>>
 
             model.thermalStretch( s, i, j );
 
-            const double coeff = model.forceCoeff( s, vol( j ) );
+            const double coeff = model.forceCoeff( i, j, s, vol( j ) );
             fx_i = coeff * rx / r;
             fy_i = coeff * ry / r;
             fz_i = coeff * rz / r;
 
-            f( i, 0 ) += fx_i;
-            f( i, 1 ) += fy_i;
-            f( i, 2 ) += fz_i;
+            addVector( f, i, fx_i, fy_i, fz_i );
         };
 
-        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
-                                                particles.localOffset() );
+        Kokkos::RangePolicy<exec_space> policy(
+            base_type::particleBegin( particles ),
+            base_type::particleEnd( particles ) );
         Cabana::neighbor_parallel_for(
             policy, force_full, _neigh_list, Cabana::FirstNeighborsTag(),
             neigh_op_tag, "CabanaPD::ForcePMB::computeFull" );
@@ -140,9 +166,57 @@ class Force<MemorySpace, ForceModel<PMB, Elastic, NoFracture, ModelParams...>>
         _timer.stop();
     }
 
-    template <class PosType, class WType, class ParticleType,
+    // Force and heat conduction in a single traversal of the bonds, sharing
+    // the bond geometry. Conduction is overwritten (not summed).
+    template <class ForceType, class ConductionType, class PosType,
+              class DispType, class ParticleType, class ParallelType>
+    void computeForceConductionFull( ForceType& f, ConductionType& conduction,
+                                     const PosType& x, const DispType& u,
+                                     const ParticleType& particles,
+                                     ParallelType& neigh_op_tag )
+    {
+        _timer.start();
+
+        auto model = _model;
+        const auto vol = particles.sliceVolume();
+        const auto temp = particles.sliceTemperature();
+
+        auto force_bond = KOKKOS_LAMBDA( const int i, const std::size_t j,
+                                         const std::size_t, BondSum<4>& sum )
+        {
+            double xi, r, s;
+            double rx, ry, rz;
+            getDistanceComponents( x, u, i, j, xi, r, s, rx, ry, rz );
+
+            const double coeff_T = model.microconductivity_function( xi );
+            sum[3] += coeff_T * ( temp( j ) - temp( i ) ) / xi / xi * vol( j );
+
+            model.thermalStretch( s, i, j );
+
+            const double coeff = model.forceCoeff( i, j, s, vol( j ) );
+            sum[0] += coeff * rx / r;
+            sum[1] += coeff * ry / r;
+            sum[2] += coeff * rz / r;
+        };
+        auto force_particle =
+            KOKKOS_LAMBDA( const int i, const BondSum<4>& sum )
+        {
+            addVector( f, i, sum[0], sum[1], sum[2] );
+            conduction( i ) = sum[3];
+        };
+
+        bondParallelFor<BondSum<4>>(
+            "CabanaPD::ForcePMB::computeForceConductionFull", exec_space{},
+            base_type::particleBegin( particles ),
+            base_type::particleEnd( particles ), _neigh_list, force_bond,
+            force_particle, neigh_op_tag );
+
+        _timer.stop();
+    }
+
+    template <class PosType, class DispType, class WType, class ParticleType,
               class ParallelType>
-    double computeEnergyFull( WType& W, const PosType& x, const PosType& u,
+    double computeEnergyFull( WType& W, const PosType& x, const DispType& u,
                               const ParticleType& particles,
                               ParallelType& neigh_op_tag )
     {
@@ -160,7 +234,7 @@ class Force<MemorySpace, ForceModel<PMB, Elastic, NoFracture, ModelParams...>>
 
             model.thermalStretch( s, i, j );
 
-            double w = model.energy( s, xi, vol( j ) );
+            double w = model.energy( i, j, s, xi, vol( j ) );
             W( i ) += w;
             Phi += w * vol( i );
         };
@@ -176,82 +250,621 @@ class Force<MemorySpace, ForceModel<PMB, Elastic, NoFracture, ModelParams...>>
         _energy_timer.stop();
         return strain_energy;
     }
+
+    // Single neighbor pass for force and energy.
+    template <class ForceType, class WType, class PosType, class DispType,
+              class ParticleType, class ParallelType>
+    double computeForceEnergyFull( ForceType& f, WType& W, const PosType& x,
+                                   const DispType& u,
+                                   const ParticleType& particles,
+                                   ParallelType& neigh_op_tag )
+    {
+        _timer.start();
+
+        auto model = _model;
+        const auto vol = particles.sliceVolume();
+
+        auto force_energy_full =
+            KOKKOS_LAMBDA( const int i, const int j, double& Phi )
+        {
+            double xi, r, s;
+            double rx, ry, rz;
+            getDistanceComponents( x, u, i, j, xi, r, s, rx, ry, rz );
+
+            model.thermalStretch( s, i, j );
+
+            const double coeff = model.forceCoeff( i, j, s, vol( j ) );
+            addVector( f, i, coeff * rx / r, coeff * ry / r, coeff * rz / r );
+
+            double w = model.energy( i, j, s, xi, vol( j ) );
+            W( i ) += w;
+            Phi += w * vol( i );
+        };
+
+        double strain_energy = 0.0;
+        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
+                                                particles.localOffset() );
+        Cabana::neighbor_parallel_reduce(
+            policy, force_energy_full, _neigh_list, Cabana::FirstNeighborsTag(),
+            neigh_op_tag, strain_energy,
+            "CabanaPD::ForcePMB::computeForceEnergyFull" );
+
+        _timer.stop();
+        return strain_energy;
+    }
+
+    // Each bond is computed once and applied to both particles. The force
+    // slice must be atomic and ghost forces scattered afterwards.
+    template <class ForceType, class PosType, class DispType,
+              class ParticleType, class ParallelType>
+    void computeForceHalf( ForceType& f, const PosType& x, const DispType& u,
+                           const ParticleType& particles,
+                           ParallelType& neigh_op_tag )
+    {
+        _timer.start();
+
+        auto model = _model;
+        const auto vol = particles.sliceVolume();
+
+        auto force_half = KOKKOS_LAMBDA( const int i, const int j )
+        {
+            double xi, r, s;
+            double rx, ry, rz;
+            getDistanceComponents( x, u, i, j, xi, r, s, rx, ry, rz );
+
+            model.thermalStretch( s, i, j );
+
+            const double coeff_i = model.forceCoeff( i, j, s, vol( j ) ) / r;
+            const double coeff_j = model.forceCoeff( i, j, s, vol( i ) ) / r;
+
+            addVector( f, i, coeff_i * rx, coeff_i * ry, coeff_i * rz );
+            addVector( f, j, -coeff_j * rx, -coeff_j * ry, -coeff_j * rz );
+        };
+
+        Kokkos::RangePolicy<exec_space> policy( 0, particles.localOffset() );
+        Cabana::neighbor_parallel_for(
+            policy, force_half, _half_neigh_list, Cabana::FirstNeighborsTag(),
+            neigh_op_tag, "CabanaPD::ForcePMB::computeHalf" );
+
+        _timer.stop();
+    }
+
+    // Ghost energy contributions are included in the returned energy so that
+    // the sum over all ranks matches the full list.
+    template <class PosType, class DispType, class WType, class ParticleType,
+              class ParallelType>
+    double computeEnergyHalf( WType& W, const PosType& x, const DispType& u,
+                              const ParticleType& particles,
+                              ParallelType& neigh_op_tag )
+    {
+        _energy_timer.start();
+
+        auto model = _model;
+        const auto vol = particles.sliceVolume();
+
+        auto energy_half =
+            KOKKOS_LAMBDA( const int i, const int j, double& Phi )
+        {
+            // Get the bond distance, displacement, and stretch.
+            double xi, r, s;
+            getDistance( x, u, i, j, xi, r, s );
+
+            model.thermalStretch( s, i, j );
+
+            double w_i = model.energy( i, j, s, xi, vol( j ) );
+            double w_j = model.energy( i, j, s, xi, vol( i ) );
+            W( i ) += w_i;
+            W( j ) += w_j;
+            Phi += w_i * vol( i ) + w_j * vol( j );
+        };
+
+        double strain_energy = 0.0;
+        Kokkos::RangePolicy<exec_space> policy( 0, particles.localOffset() );
+        Cabana::neighbor_parallel_reduce(
+            policy, energy_half, _half_neigh_list, Cabana::FirstNeighborsTag(),
+            neigh_op_tag, strain_energy,
+            "CabanaPD::ForcePMB::computeEnergyHalf" );
+
+        _energy_timer.stop();
+        return strain_energy;
+    }
 };
 
-template <class MemorySpace, class... ModelParams>
-class Force<MemorySpace, ForceModel<PMB, Elastic, Fracture, ModelParams...>>
-    : public Force<MemorySpace, BaseForceModel>,
-      public BaseFracture<MemorySpace>
+template <class MemorySpace, class BondStorageType, class BondCacheType,
+          class... ModelParams>
+class Force<MemorySpace, ForceModel<PMB, Elastic, Fracture, ModelParams...>,
+            BondStorageType, BondCacheType>
+    : public Force<MemorySpace, BaseForceModel, BondStorageType>,
+      public BaseFracture<MemorySpace, BondStorageType, BondCacheType>
 {
   public:
     // Using the default exec_space.
     using exec_space = typename MemorySpace::execution_space;
     using model_type = ForceModel<PMB, Elastic, Fracture, ModelParams...>;
-    using base_type = Force<MemorySpace, BaseForceModel>;
+    // The neighbor layout follows the bond storage (CSR or padded rows).
+    using base_type = Force<MemorySpace, BaseForceModel, BondStorageType>;
     using neighbor_list_type = typename base_type::neighbor_list_type;
+    using half_neighbor_list_type =
+        typename base_type::half_neighbor_list_type;
+    using base_type::_half_neigh_list;
     using base_type::_neigh_list;
 
+    static constexpr bool has_fused_energy = true;
+    static constexpr bool has_bond_breaking = true;
+    static constexpr bool has_active_bond_breaking = true;
+    static constexpr bool has_fused_conduction =
+        is_heat_transfer<typename model_type::thermal_type>::value;
+    // Explicit SIMD force kernel for host execution (see simdForcePMB).
+    static constexpr bool use_simd =
+        is_simd_space<exec_space>::value &&
+        std::is_same<model_type, ForceModel<PMB, Elastic, Fracture,
+                                            TemperatureIndependent>>::value &&
+        std::is_same<BondCacheType, NoBondCache>::value;
+
   protected:
-    using fracture_type = BaseFracture<MemorySpace>;
+    using fracture_type =
+        BaseFracture<MemorySpace, BondStorageType, BondCacheType>;
+    using fracture_type::_bond_cache;
     using fracture_type::_mu;
+    using fracture_type::_removed_volume;
 
     using base_model_type = typename model_type::base_type;
     using base_type::_half_neigh;
     model_type _model;
 
+    // Particles whose bonds are checked for breaking with
+    // ActiveBondBreaking (empty until updateActiveBonds).
+    Kokkos::View<int*, MemorySpace> _break_active;
+
     using base_type::_energy_timer;
     using base_type::_timer;
 
+    // Broken bond storage for the active neighbor list (the base class
+    // neighbors are already built).
+    template <class ParticleType>
+    typename fracture_type::NeighborView
+    createBrokenBonds( const ParticleType& particles )
+    {
+        const int max_neighbors = base_type::getMaxLocalNeighbors();
+        if ( _half_neigh )
+            return typename fracture_type::NeighborView(
+                _half_neigh_list, particles.localOffset(), max_neighbors, 0 );
+        return typename fracture_type::NeighborView(
+            _neigh_list, particles.localOffset(), max_neighbors,
+            particles.frozenOffset() );
+    }
+
   public:
     template <class ParticleType>
     Force( const bool half_neigh, const ParticleType& particles,
            const model_type model )
         : base_type( half_neigh, model.delta, particles )
-        , fracture_type( particles.localOffset(),
-                         base_type::getMaxLocalNeighbors() )
+        , fracture_type( createBrokenBonds( particles ) )
         , _model( model )
     {
+        auto x = particles.sliceReferencePosition();
+        auto vol = particles.sliceVolume();
+        if ( _half_neigh )
+            fracture_type::buildBondCache(
+                _half_neigh_list, x, vol, 0, particles.localOffset(),
+                base_type::getMaxLocalNeighbors() );
+        else
+            fracture_type::buildBondCache(
+                _neigh_list, x, vol, particles.frozenOffset(),
+                particles.localOffset(), base_type::getMaxLocalNeighbors() );
+    }
+
+    // Rebuild neighbors after particle migration, given the broken bonds
+    // migrated with the particles (stored in sorted neighbor order).
+    template <class ParticleType, class NeighborView>
+    void rebuildNeighbors( const ParticleType& particles,
+                           const NeighborView& mu )
+    {
+        base_type::rebuildNeighbors( particles );
+        fracture_type::rebuildFracture(
+            mu, _neigh_list, particles.sliceReferencePosition(),
+            particles.sliceVolume(), particles.frozenOffset(),
+            particles.localOffset(), base_type::getMaxLocalNeighbors() );
+        // The active set no longer matches the particle order.
+        _break_active = Kokkos::View<int*, MemorySpace>();
+    }
+
+    // Full sweep to flag particles with an intact (breakable) bond stretched
+    // beyond the given fraction of its critical stretch. Until the next
+    // update, ActiveBondBreaking only checks the bonds of these particles:
+    // the threshold must leave a margin for the stretch increase in between.
+    // Returns the number of active particles.
+    template <class ParticleType>
+    int updateActiveBonds( const ParticleType& particles,
+                           const double threshold )
+    {
+        if ( _half_neigh )
+            throw std::runtime_error( "Active bond breaking is not supported "
+                                      "with half neighbor lists." );
+        if ( threshold <= 0.0 || threshold > 1.0 )
+            throw std::runtime_error(
+                "Active bond breaking threshold must be in (0, 1]." );
+
+        _timer.start();
+        if ( _break_active.size() < particles.localOffset() )
+            Kokkos::realloc( Kokkos::WithoutInitializing, _break_active,
+                             particles.localOffset() );
+
+        auto model = _model;
+        auto mu = _mu;
+        auto bond_cache = _bond_cache;
+        auto active = _break_active;
+        const auto x = particles.sliceReferencePosition();
+        const auto u = particles.sliceDisplacement();
+        const auto nofail = particles.sliceNoFail();
+        const double scale = 1.0 / threshold;
+
+        auto check_bond = KOKKOS_LAMBDA( const int i, const std::size_t j,
+                                         const std::size_t n, BondSum<1>& near )
+        {
+            if ( mu( i, n ) == 0 || nofail( i ) || nofail( j ) )
+                return;
+            double xi, r, s;
+            double rx, ry, rz;
+            bond_cache.getDistanceComponents( x, u, i, j, n, xi, r, s, rx, ry,
+                                              rz );
+            // Critical stretch check with the stretch scaled by 1/threshold.
+            if ( model.criticalStretch( i, j, xi + ( r - xi ) * scale, xi ) )
+                near[0] += 1.0;
+        };
+        auto check_particle =
+            KOKKOS_LAMBDA( const int i, const BondSum<1>& near, double& sum )
+        {
+            active( i ) = near[0] > 0.0;
+            sum += active( i );
+        };
+        double num_active = 0.0;
+        bondParallelReduce<BondSum<1>>(
+            "CabanaPD::ForcePMBDamage::updateActiveBonds", exec_space{},
+            particles.frozenOffset(), particles.localOffset(), _neigh_list,
+            check_bond, check_particle, num_active, Cabana::SerialOpTag{} );
+        _timer.stop();
+        return static_cast<int>( num_active );
+    }
+
+    // Whether an active set is available for ActiveBondBreaking.
+    bool activeBondBreaking() const { return _break_active.size() > 0; }
+
+    // Remove broken bonds from the neighbor list once at least the given
+    // fraction is broken. Returns whether the bonds were compacted.
+    template <class ParticleType>
+    bool compactBonds( const ParticleType& particles, const double threshold )
+    {
+        if ( _half_neigh )
+            throw std::runtime_error( "Broken bond compaction is not "
+                                      "supported with half neighbor lists." );
+        const auto begin = particles.frozenOffset();
+        const auto end = particles.localOffset();
+        if ( fracture_type::brokenBondFraction( _neigh_list, begin, end ) <
+             threshold )
+            return false;
+
+        fracture_type::compactBonds(
+            _neigh_list, particles.sliceReferencePosition(),
+            particles.sliceVolume(), begin, end,
+            base_type::getMaxLocalNeighbors() );
+        return true;
     }
 
     template <class ExecSpace, class ParticleType, class PrenotchType>
     void prenotch( ExecSpace exec_space, const ParticleType& particles,
                    PrenotchType& prenotch )
     {
-        fracture_type::prenotch( exec_space, particles, prenotch, _neigh_list );
+        if ( _half_neigh )
+            fracture_type::prenotch( exec_space, particles, prenotch,
+                                     _half_neigh_list );
+        else
+            fracture_type::prenotch( exec_space, particles, prenotch,
+                                     _neigh_list );
     }
 
-    template <class ForceType, class PosType, class ParticleType,
+    template <class ForceType, class PosType, class DispType,
+              class ParticleType, class ParallelType,
+              class BreakType = BondBreaking>
+    void computeForceFull( ForceType& f, const PosType& x, const DispType& u,
+                           const ParticleType& particles,
+                           ParallelType& neigh_op_tag, BreakType = {} )
+    {
+        _timer.start();
+
+        // Bond breaking is compiled out for intermediate integrator stages
+        // and skipped for particles outside the active set.
+        constexpr bool break_bonds =
+            std::is_same<BreakType, BondBreaking>::value;
+        constexpr bool active_breaking =
+            std::is_same<BreakType, ActiveBondBreaking>::value;
+
+        auto model = _model;
+        auto mu = _mu;
+        auto bond_cache = _bond_cache;
+        auto active = _break_active;
+        const auto vol = particles.sliceVolume();
+        const auto nofail = particles.sliceNoFail();
+
+        // The SIMD kernel checks all bonds with an active set.
+        if constexpr ( use_simd && ParticleType::dim == 3 )
+        {
+            simdForcePMB<break_bonds || active_breaking>(
+                "CabanaPD::ForcePMBDamage::computeFullSIMD", exec_space{},
+                base_type::particleBegin( particles ),
+                base_type::particleEnd( particles ), _neigh_list, f, x, u,
+                vol, nofail, mu, model.c, model.bond_break_coeff );
+            _timer.stop();
+            return;
+        }
+
+        auto force_bond = KOKKOS_LAMBDA( const int i, const std::size_t j,
+                                         const std::size_t n, BondSum<3>& f_i )
+        {
+            // Get the reference positions and displacements.
+            double xi, r, s;
+            double rx, ry, rz;
+            bond_cache.getDistanceComponents( x, u, i, j, n, xi, r, s, rx, ry,
+                                              rz );
+            const double vol_j = bond_cache.volume( vol, i, j, n );
+
+            model.thermalStretch( s, i, j );
+
+            // Break if beyond critical stretch unless in no-fail zone.
+            const bool check_break =
+                break_bonds || ( active_breaking && active( i ) );
+            if ( check_break && model.criticalStretch( i, j, r, xi ) &&
+                 !nofail( i ) && !nofail( j ) )
+            {
+                mu.breakBond( i, n );
+            }
+            // Else if statement is only for performance.
+            else if ( mu( i, n ) > 0 )
+            {
+                const double coeff = model.forceCoeff( i, j, s, vol_j );
+
+                double muij = mu( i, n );
+                f_i[0] += muij * coeff * rx / r;
+                f_i[1] += muij * coeff * ry / r;
+                f_i[2] += muij * coeff * rz / r;
+            }
+        };
+        auto force_particle =
+            KOKKOS_LAMBDA( const int i, const BondSum<3>& f_i )
+        {
+            addVector( f, i, f_i[0], f_i[1], f_i[2] );
+        };
+
+        bondParallelFor<BondSum<3>>(
+            "CabanaPD::ForcePMBDamage::computeFull", exec_space{},
+            base_type::particleBegin( particles ),
+            base_type::particleEnd( particles ), _neigh_list, force_bond,
+            force_particle, neigh_op_tag );
+
+        _timer.stop();
+    }
+
+    // Force (with bond breaking) and heat conduction in a single traversal of
+    // the bonds, sharing the bond geometry and broken bond loads. Conduction
+    // is overwritten (not summed) and excludes bonds broken in this pass.
+    template <class ForceType, class ConductionType, class PosType,
+              class DispType, class ParticleType, class ParallelType>
+    void computeForceConductionFull( ForceType& f, ConductionType& conduction,
+                                     const PosType& x, const DispType& u,
+                                     const ParticleType& particles,
+                                     ParallelType& neigh_op_tag )
+    {
+        _timer.start();
+
+        auto model = _model;
+        auto mu = _mu;
+        auto bond_cache = _bond_cache;
+        const auto vol = particles.sliceVolume();
+        const auto nofail = particles.sliceNoFail();
+        const auto temp = particles.sliceTemperature();
+
+        auto force_bond = KOKKOS_LAMBDA( const int i, const std::size_t j,
+                                         const std::size_t n, BondSum<4>& sum )
+        {
+            double xi, r, s;
+            double rx, ry, rz;
+            bond_cache.getDistanceComponents( x, u, i, j, n, xi, r, s, rx, ry,
+                                              rz );
+            const double vol_j = bond_cache.volume( vol, i, j, n );
+
+            model.thermalStretch( s, i, j );
+
+            if ( model.criticalStretch( i, j, r, xi ) && !nofail( i ) &&
+                 !nofail( j ) )
+            {
+                mu.breakBond( i, n );
+            }
+            else if ( mu( i, n ) > 0 )
+            {
+                const double coeff = model.forceCoeff( i, j, s, vol_j );
+
+                double muij = mu( i, n );
+                sum[0] += muij * coeff * rx / r;
+                sum[1] += muij * coeff * ry / r;
+                sum[2] += muij * coeff * rz / r;
+
+                const double coeff_T = model.microconductivity_function( xi );
+                sum[3] += coeff_T * ( temp( j ) - temp( i ) ) / xi / xi * vol_j;
+            }
+        };
+        auto force_particle =
+            KOKKOS_LAMBDA( const int i, const BondSum<4>& sum )
+        {
+            addVector( f, i, sum[0], sum[1], sum[2] );
+            conduction( i ) = sum[3];
+        };
+
+        bondParallelFor<BondSum<4>>(
+            "CabanaPD::ForcePMBDamage::computeForceConductionFull",
+            exec_space{}, base_type::particleBegin( particles ),
+            base_type::particleEnd( particles ), _neigh_list, force_bond,
+            force_particle, neigh_op_tag );
+
+        _timer.stop();
+    }
+
+    template <class PosType, class DispType, class WType, class ParticleType,
               class ParallelType>
-    void computeForceFull( ForceType& f, const PosType& x, const PosType& u,
+    double computeEnergyFull( WType& W, const PosType& x, const DispType& u,
+                              ParticleType& particles,
+                              ParallelType& neigh_op_tag )
+    {
+        _energy_timer.start();
+
+        auto model = _model;
+        auto mu = _mu;
+        auto bond_cache = _bond_cache;
+        const auto vol = particles.sliceVolume();
+        auto phi = particles.sliceDamage();
+        const auto removed_volume = _removed_volume;
+
+        // Sums of energy, intact bond volume, and total bond volume.
+        auto energy_bond = KOKKOS_LAMBDA( const int i, const std::size_t j,
+                                          const std::size_t n,
+                                          BondSum<3>& sum )
+        {
+            // Get the bond distance, displacement, and stretch.
+            double xi, r, s;
+            bond_cache.getDistance( x, u, i, j, n, xi, r, s );
+            const double vol_j = bond_cache.volume( vol, i, j, n );
+
+            model.thermalStretch( s, i, j );
+
+            sum[0] += mu( i, n ) * model.energy( i, j, s, xi, vol_j );
+            sum[1] += mu( i, n ) * vol_j;
+            sum[2] += vol_j;
+        };
+        auto energy_particle = KOKKOS_LAMBDA(
+            const int i, const BondSum<3>& sum, double& Phi )
+        {
+            W( i ) += sum[0];
+            Phi += W( i ) * vol( i );
+            phi( i ) = 1 - sum[1] / ( sum[2] + removed_volume( i ) );
+        };
+
+        double strain_energy = 0.0;
+        bondParallelReduce<BondSum<3>>(
+            "CabanaPD::ForcePMBDamage::computeEnergyFull", exec_space{},
+            particles.frozenOffset(), particles.localOffset(), _neigh_list,
+            energy_bond, energy_particle, strain_energy, neigh_op_tag );
+
+        _energy_timer.stop();
+        return strain_energy;
+    }
+
+    // Single neighbor pass for force, energy, and damage (optionally without
+    // checking for new broken bonds).
+    template <class ForceType, class WType, class PosType, class DispType,
+              class ParticleType, class ParallelType,
+              class BreakType = BondBreaking>
+    double computeForceEnergyFull( ForceType& f, WType& W, const PosType& x,
+                                   const DispType& u, ParticleType& particles,
+                                   ParallelType& neigh_op_tag, BreakType = {} )
+    {
+        _timer.start();
+
+        constexpr bool break_bonds =
+            std::is_same<BreakType, BondBreaking>::value;
+
+        auto model = _model;
+        auto mu = _mu;
+        auto bond_cache = _bond_cache;
+        const auto vol = particles.sliceVolume();
+        const auto nofail = particles.sliceNoFail();
+        auto phi = particles.sliceDamage();
+        const auto removed_volume = _removed_volume;
+
+        // Sums of force, energy, intact bond volume, and total bond volume.
+        auto force_energy_bond = KOKKOS_LAMBDA(
+            const int i, const std::size_t j, const std::size_t n,
+            BondSum<6>& sum )
+        {
+            // Get the reference positions and displacements.
+            double xi, r, s;
+            double rx, ry, rz;
+            bond_cache.getDistanceComponents( x, u, i, j, n, xi, r, s, rx, ry,
+                                              rz );
+            const double vol_j = bond_cache.volume( vol, i, j, n );
+
+            model.thermalStretch( s, i, j );
+
+            // Break if beyond critical stretch unless in no-fail zone.
+            if ( break_bonds && model.criticalStretch( i, j, r, xi ) &&
+                 !nofail( i ) && !nofail( j ) )
+            {
+                mu.breakBond( i, n );
+            }
+            // Else if statement is only for performance.
+            else if ( mu( i, n ) > 0 )
+            {
+                const double coeff = model.forceCoeff( i, j, s, vol_j );
+                sum[0] += coeff * rx / r;
+                sum[1] += coeff * ry / r;
+                sum[2] += coeff * rz / r;
+
+                sum[3] += model.energy( i, j, s, xi, vol_j );
+                sum[4] += vol_j;
+            }
+            sum[5] += vol_j;
+        };
+        auto force_energy_particle = KOKKOS_LAMBDA(
+            const int i, const BondSum<6>& sum, double& Phi )
+        {
+            addVector( f, i, sum[0], sum[1], sum[2] );
+            W( i ) += sum[3];
+            Phi += sum[3] * vol( i );
+            phi( i ) = 1 - sum[4] / ( sum[5] + removed_volume( i ) );
+        };
+
+        double strain_energy = 0.0;
+        bondParallelReduce<BondSum<6>>(
+            "CabanaPD::ForcePMBDamage::computeForceEnergyFull", exec_space{},
+            particles.frozenOffset(), particles.localOffset(), _neigh_list,
+            force_energy_bond, force_energy_particle, strain_energy,
+            neigh_op_tag );
+
+        _timer.stop();
+        return strain_energy;
+    }
+
+    // Each bond is computed once and applied to both particles. The force
+    // slice must be atomic and ghost forces scattered afterwards.
+    template <class ForceType, class PosType, class DispType,
+              class ParticleType, class ParallelType>
+    void computeForceHalf( ForceType& f, const PosType& x, const DispType& u,
                            const ParticleType& particles, ParallelType& )
     {
         _timer.start();
 
         auto model = _model;
-        auto neigh_list = _neigh_list;
+        auto neigh_list = _half_neigh_list;
         auto mu = _mu;
+        auto bond_cache = _bond_cache;
         const auto vol = particles.sliceVolume();
         const auto nofail = particles.sliceNoFail();
 
-        auto force_full = KOKKOS_LAMBDA( const int i )
+        auto force_half = KOKKOS_LAMBDA( const int i )
         {
             std::size_t num_neighbors =
-                Cabana::NeighborList<neighbor_list_type>::numNeighbor(
+                Cabana::NeighborList<half_neighbor_list_type>::numNeighbor(
                     neigh_list, i );
             for ( std::size_t n = 0; n < num_neighbors; n++ )
             {
-                double fx_i = 0.0;
-                double fy_i = 0.0;
-                double fz_i = 0.0;
-
                 std::size_t j =
-                    Cabana::NeighborList<neighbor_list_type>::getNeighbor(
+                    Cabana::NeighborList<half_neighbor_list_type>::getNeighbor(
                         neigh_list, i, n );
 
                 // Get the reference positions and displacements.
                 double xi, r, s;
                 double rx, ry, rz;
-                getDistanceComponents( x, u, i, j, xi, r, s, rx, ry, rz );
+                bond_cache.getDistanceComponents( x, u, i, j, n, xi, r, s, rx,
+                                                  ry, rz );
+                const double vol_j = bond_cache.volume( vol, i, j, n );
 
                 model.thermalStretch( s, i, j );
 
@@ -259,82 +872,109 @@ class Force<MemorySpace, ForceModel<PMB, Elastic, Fracture, ModelParams...>>
                 if ( model.criticalStretch( i, j, r, xi ) && !nofail( i ) &&
                      !nofail( j ) )
                 {
-                    mu( i, n ) = 0;
+                    mu.breakBond( i, n );
                 }
                 // Else if statement is only for performance.
                 else if ( mu( i, n ) > 0 )
                 {
-                    const double coeff = model.forceCoeff( s, vol( j ) );
-
-                    double muij = mu( i, n );
-                    fx_i = muij * coeff * rx / r;
-                    fy_i = muij * coeff * ry / r;
-                    fz_i = muij * coeff * rz / r;
-
-                    f( i, 0 ) += fx_i;
-                    f( i, 1 ) += fy_i;
-                    f( i, 2 ) += fz_i;
+                    const double coeff_i =
+                        model.forceCoeff( i, j, s, vol_j ) / r;
+                    const double coeff_j =
+                        model.forceCoeff( i, j, s, vol( i ) ) / r;
+
+                    addVector( f, i, coeff_i * rx, coeff_i * ry, coeff_i * rz );
+                    addVector( f, j, -coeff_j * rx, -coeff_j * ry,
+                               -coeff_j * rz );
                 }
             }
         };
 
-        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
-                                                particles.localOffset() );
-        Kokkos::parallel_for( "CabanaPD::ForcePMBDamage::computeFull", policy,
-                              force_full );
+        Kokkos::RangePolicy<exec_space> policy( 0, particles.localOffset() );
+        Kokkos::parallel_for( "CabanaPD::ForcePMBDamage::computeHalf", policy,
+                              force_half );
 
         _timer.stop();
     }
 
-    template <class PosType, class WType, class ParticleType,
+    // Damage is accumulated here, but only normalized in computeDamageHalf
+    // after ghost contributions have been scattered.
+    template <class PosType, class DispType, class WType, class ParticleType,
               class ParallelType>
-    double computeEnergyFull( WType& W, const PosType& x, const PosType& u,
+    double computeEnergyHalf( WType& W, const PosType& x, const DispType& u,
                               ParticleType& particles, ParallelType& )
     {
         _energy_timer.start();
 
         auto model = _model;
-        auto neigh_list = _neigh_list;
+        auto neigh_list = _half_neigh_list;
         auto mu = _mu;
+        auto bond_cache = _bond_cache;
         const auto vol = particles.sliceVolume();
-        auto phi = particles.sliceDamage();
-
-        auto energy_full = KOKKOS_LAMBDA( const int i, double& Phi )
+        auto phi_reset = particles.sliceDamage();
+        auto vol_H_reset = particles.sliceNeighborVolume();
+        Cabana::deep_copy( phi_reset, 0.0 );
+        Cabana::deep_copy( vol_H_reset, 0.0 );
+        auto phi = particles.sliceDamageAtomic();
+        auto vol_H = particles.sliceNeighborVolumeAtomic();
+
+        auto energy_half = KOKKOS_LAMBDA( const int i, double& Phi )
         {
             std::size_t num_neighbors =
-                Cabana::NeighborList<neighbor_list_type>::numNeighbor(
+                Cabana::NeighborList<half_neighbor_list_type>::numNeighbor(
                     neigh_list, i );
-            double phi_i = 0.0;
-            double vol_H_i = 0.0;
             for ( std::size_t n = 0; n < num_neighbors; n++ )
             {
                 std::size_t j =
-                    Cabana::NeighborList<neighbor_list_type>::getNeighbor(
+                    Cabana::NeighborList<half_neighbor_list_type>::getNeighbor(
                         neigh_list, i, n );
                 // Get the bond distance, displacement, and stretch.
                 double xi, r, s;
-                getDistance( x, u, i, j, xi, r, s );
+                bond_cache.getDistance( x, u, i, j, n, xi, r, s );
+                const double vol_j = bond_cache.volume( vol, i, j, n );
 
                 model.thermalStretch( s, i, j );
 
-                double w = mu( i, n ) * model.energy( s, xi, vol( j ) );
-                W( i ) += w;
+                double w_i = mu( i, n ) * model.energy( i, j, s, xi, vol_j );
+                double w_j = mu( i, n ) * model.energy( i, j, s, xi, vol( i ) );
+                W( i ) += w_i;
+                W( j ) += w_j;
+                Phi += w_i * vol( i ) + w_j * vol_j;
 
-                phi_i += mu( i, n ) * vol( j );
-                vol_H_i += vol( j );
+                phi( i ) += mu( i, n ) * vol_j;
+                phi( j ) += mu( i, n ) * vol( i );
+                vol_H( i ) += vol_j;
+                vol_H( j ) += vol( i );
             }
-            Phi += W( i ) * vol( i );
-            phi( i ) = 1 - phi_i / vol_H_i;
         };
 
         double strain_energy = 0.0;
+        Kokkos::RangePolicy<exec_space> policy( 0, particles.localOffset() );
+        Kokkos::parallel_reduce( "CabanaPD::ForcePMBDamage::computeEnergyHalf",
+                                 policy, energy_half, strain_energy );
+
+        _energy_timer.stop();
+        return strain_energy;
+    }
+
+    template <class ParticleType>
+    void computeDamageHalf( ParticleType& particles )
+    {
+        _energy_timer.start();
+
+        auto phi = particles.sliceDamage();
+        const auto vol_H = particles.sliceNeighborVolume();
+        auto damage = KOKKOS_LAMBDA( const int i )
+        {
+            if ( vol_H( i ) > 0.0 )
+                phi( i ) = 1 - phi( i ) / vol_H( i );
+        };
+
         Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
                                                 particles.localOffset() );
-        Kokkos::parallel_reduce( "CabanaPD::ForcePMBDamage::computeEnergyFull",
-                                 policy, energy_full, strain_energy );
+        Kokkos::parallel_for( "CabanaPD::ForcePMBDamage::computeDamageHalf",
+                              policy, damage );
 
         _energy_timer.stop();
-        return strain_energy;
     }
 };
 
@@ -356,25 +996,56 @@ class Force<MemorySpace,
     using base_type::_half_neigh;
     model_type _model;
 
+    StiffnessOperator<MemorySpace> _stiffness;
+    bool _use_stiffness = false;
+
     using base_type::_energy_timer;
     using base_type::_timer;
 
   public:
+    static constexpr bool has_stiffness_operator = true;
+
     template <class ParticleType>
     Force( const bool half_neigh, const ParticleType& particles,
            const model_type model )
         : base_type( half_neigh, model.delta, particles )
         , _model( model )
     {
+        if ( half_neigh )
+            throw std::runtime_error( "Half neighbor lists are not yet "
+                                      "supported for LinearPMB models." );
     }
 
-    template <class ForceType, class PosType, class ParticleType,
-              class ParallelType>
-    void computeForceFull( ForceType& f, const PosType& x, const PosType& u,
+    // Assemble the bond stiffness once from the current neighbor list such
+    // that forces are a sparse matrix-vector product.
+    template <class ParticleType>
+    void assembleStiffness( const ParticleType& particles )
+    {
+        const auto x = particles.sliceReferencePosition();
+        const auto vol = particles.sliceVolume();
+        PMBStiffness<model_type, decltype( vol )> bond{ _model, vol };
+        _stiffness.assemble( _neigh_list, particles.frozenOffset(),
+                             particles.localOffset(), x, bond );
+        _use_stiffness = true;
+    }
+
+    auto& getStiffness() const { return _stiffness; }
+
+    template <class ForceType, class PosType, class DispType,
+              class ParticleType, class ParallelType>
+    void computeForceFull( ForceType& f, const PosType& x, const DispType& u,
                            ParticleType& particles, ParallelType& neigh_op_tag )
     {
         _timer.start();
 
+        if ( _use_stiffness )
+        {
+            _stiffness.apply( f, u, base_type::particleBegin( particles ),
+                              base_type::particleEnd( particles ) );
+            _timer.stop();
+            return;
+        }
+
         auto model = _model;
         const auto vol = particles.sliceVolume();
 
@@ -397,13 +1068,12 @@ class Force<MemorySpace,
             fy_i = coeff * xi_y / xi;
             fz_i = coeff * xi_z / xi;
 
-            f( i, 0 ) += fx_i;
-            f( i, 1 ) += fy_i;
-            f( i, 2 ) += fz_i;
+            addVector( f, i, fx_i, fy_i, fz_i );
         };
 
-        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
-                                                particles.localOffset() );
+        Kokkos::RangePolicy<exec_space> policy(
+            base_type::particleBegin( particles ),
+            base_type::particleEnd( particles ) );
         Cabana::neighbor_parallel_for(
             policy, force_full, _neigh_list, Cabana::FirstNeighborsTag(),
             neigh_op_tag, "CabanaPD::ForceLinearPMB::computeFull" );
@@ -411,9 +1081,9 @@ class Force<MemorySpace,
         _timer.stop();
     }
 
-    template <class PosType, class WType, class ParticleType,
+    template <class PosType, class DispType, class WType, class ParticleType,
               class ParallelType>
-    double computeEnergyFull( WType& W, const PosType& x, const PosType& u,
+    double computeEnergyFull( WType& W, const PosType& x, const DispType& u,
                               ParticleType& particles,
                               ParallelType& neigh_op_tag )
     {
@@ -447,6 +1117,13 @@ class Force<MemorySpace,
         _energy_timer.stop();
         return strain_energy;
     }
+
+    void neighborMemory( MemoryRegistry& registry ) const
+    {
+        base_type::neighborMemory( registry );
+        if ( _use_stiffness )
+            registry.add( "Force::Stiffness", _stiffness.bytes() );
+    }
 };
 
 } // namespace CabanaPD
@@ -0,0 +1,176 @@
+/****************************************************************************
+ * Copyright (c) 2022 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of CabanaPD. CabanaPD is distributed under a           *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#ifndef FORCE_SIMD_H
+#define FORCE_SIMD_H
+
+#include <string>
+#include <type_traits>
+
+#include <Kokkos_Core.hpp>
+#include <Kokkos_SIMD.hpp>
+
+#include <Cabana_Core.hpp>
+
+#include <CabanaPD_Fields.hpp>
+
+namespace CabanaPD
+{
+/******************************************************************************
+  Explicit SIMD bond loops for host execution spaces.
+
+  The neighbors of each particle are processed in blocks of the native SIMD
+  width: neighbor data is gathered into lanes, all bonds of the block are
+  computed together (with bond breaking as a masked update), and the lanes
+  are summed into the particle once at the end. Device execution spaces keep
+  the scalar kernels.
+******************************************************************************/
+template <class ExecSpace>
+struct is_simd_space
+    : public std::integral_constant<
+          bool, Kokkos::SpaceAccessibility<ExecSpace,
+                                           Kokkos::HostSpace>::accessible>
+{
+};
+
+// All bonds intact (no fracture).
+struct IntactBonds
+{
+    int operator()( const int, const int ) const { return 1; }
+    void breakBond( const int, const int ) const {}
+};
+
+// PMB bond forces for particles in [begin, end) with a full neighbor list:
+// f_i += mu_ij c s vol_j r_ij / r. With BreakBonds, bonds stretched beyond
+// bond_break_coeff (squared length ratio) are broken unless either particle
+// is in a no-fail zone.
+template <bool BreakBonds, class ExecSpace, class NeighborListType,
+          class ForceType, class PosType, class DispType, class VolType,
+          class NoFailType, class BondType>
+void simdForcePMB( const std::string& label, ExecSpace,
+                   const std::size_t begin, const std::size_t end,
+                   const NeighborListType& neigh_list, ForceType& f,
+                   const PosType& x, const DispType& u, const VolType& vol,
+                   const NoFailType& nofail, const BondType& mu,
+                   const double c, const double bond_break_coeff )
+{
+    static_assert( is_simd_space<ExecSpace>::value,
+                   "SIMD bond loops require a host execution space." );
+    using simd_type = Kokkos::Experimental::native_simd<double>;
+    using tag_type = Kokkos::Experimental::element_aligned_tag;
+    constexpr int width = simd_type::size();
+    using list_type = Cabana::NeighborList<NeighborListType>;
+
+    auto kernel = [=]( const int i )
+    {
+        using Kokkos::sqrt;
+        const std::size_t num_neighbors =
+            list_type::numNeighbor( neigh_list, i );
+        const double x_i[3] = { x( i, 0 ), x( i, 1 ), x( i, 2 ) };
+        const double u_i[3] = { u( i, 0 ), u( i, 1 ), u( i, 2 ) };
+        const bool nofail_i = nofail( i );
+
+        alignas( 64 ) double xi_lane[3][width];
+        alignas( 64 ) double eta_lane[3][width];
+        alignas( 64 ) double vol_lane[width];
+        alignas( 64 ) double mu_lane[width];
+        alignas( 64 ) double nofail_lane[width];
+        simd_type f_i[3] = { simd_type( 0.0 ), simd_type( 0.0 ),
+                             simd_type( 0.0 ) };
+        for ( std::size_t n0 = 0; n0 < num_neighbors; n0 += width )
+        {
+            // Gather the block, padding with unit length, zero volume bonds.
+            for ( int l = 0; l < width; l++ )
+            {
+                const std::size_t n = n0 + l;
+                if ( n < num_neighbors )
+                {
+                    const std::size_t j =
+                        list_type::getNeighbor( neigh_list, i, n );
+                    for ( int d = 0; d < 3; d++ )
+                    {
+                        xi_lane[d][l] = x( j, d ) - x_i[d];
+                        eta_lane[d][l] = u( j, d ) - u_i[d];
+                    }
+                    vol_lane[l] = vol( j );
+                    mu_lane[l] = mu( i, n );
+                    nofail_lane[l] = ( nofail_i || nofail( j ) ) ? 1.0 : 0.0;
+                }
+                else
+                {
+                    for ( int d = 0; d < 3; d++ )
+                    {
+                        xi_lane[d][l] = d == 0 ? 1.0 : 0.0;
+                        eta_lane[d][l] = 0.0;
+                    }
+                    vol_lane[l] = 0.0;
+                    mu_lane[l] = 0.0;
+                    nofail_lane[l] = 1.0;
+                }
+            }
+
+            simd_type xi_d[3];
+            simd_type r_d[3];
+            for ( int d = 0; d < 3; d++ )
+            {
+                simd_type eta_d;
+                xi_d[d].copy_from( xi_lane[d], tag_type() );
+                eta_d.copy_from( eta_lane[d], tag_type() );
+                r_d[d] = xi_d[d] + eta_d;
+            }
+            const simd_type xi2 =
+                xi_d[0] * xi_d[0] + xi_d[1] * xi_d[1] + xi_d[2] * xi_d[2];
+            const simd_type r2 =
+                r_d[0] * r_d[0] + r_d[1] * r_d[1] + r_d[2] * r_d[2];
+            const simd_type xi = sqrt( xi2 );
+            const simd_type r = sqrt( r2 );
+
+            simd_type mu_v;
+            simd_type vol_v;
+            mu_v.copy_from( mu_lane, tag_type() );
+            vol_v.copy_from( vol_lane, tag_type() );
+            if constexpr ( BreakBonds )
+            {
+                simd_type nofail_v;
+                nofail_v.copy_from( nofail_lane, tag_type() );
+                const auto broken = r2 >= simd_type( bond_break_coeff ) * xi2 &&
+                                    mu_v > simd_type( 0.0 ) &&
+                                    nofail_v == simd_type( 0.0 );
+                Kokkos::Experimental::where( broken, mu_v ) = simd_type( 0.0 );
+                for ( int l = 0; l < width; l++ )
+                    if ( broken[l] )
+                        mu.breakBond( i, n0 + l );
+            }
+
+            const simd_type coeff =
+                mu_v * simd_type( c ) * ( r - xi ) / xi * vol_v / r;
+            for ( int d = 0; d < 3; d++ )
+                f_i[d] += coeff * r_d[d];
+        }
+
+        // Horizontal sum of the lanes.
+        double f_sum[3] = { 0.0, 0.0, 0.0 };
+        alignas( 64 ) double lanes[width];
+        for ( int d = 0; d < 3; d++ )
+        {
+            f_i[d].copy_to( lanes, tag_type() );
+            for ( int l = 0; l < width; l++ )
+                f_sum[d] += lanes[l];
+        }
+        addVector( f, i, f_sum[0], f_sum[1], f_sum[2] );
+    };
+    Kokkos::RangePolicy<ExecSpace> policy( begin, end );
+    Kokkos::parallel_for( label, policy, kernel );
+}
+
+} // namespace CabanaPD
+
+#endif
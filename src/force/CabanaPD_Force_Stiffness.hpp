@@ -0,0 +1,365 @@
+/****************************************************************************
+ * Copyright (c) 2022 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of CabanaPD. CabanaPD is distributed under a           *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#ifndef FORCE_STIFFNESS_H
+#define FORCE_STIFFNESS_H
+
+#include <stdexcept>
+#include <string>
+
+#include <Kokkos_Core.hpp>
+
+#include <Cabana_Core.hpp>
+
+#include <CabanaPD_Fields.hpp>
+#include <CabanaPD_Memory.hpp>
+#include <CabanaPD_Timer.hpp>
+
+namespace CabanaPD
+{
+/******************************************************************************
+  Bond stiffness for assembly.
+
+  Linearized bonds contribute K_ij = k (xi x xi) to the force on i from the
+  displacement difference u_j - u_i. State-based models additionally couple
+  through the dilatation: theta_i = sum_j g xi . (u_j - u_i) and
+  f_i += sum_j ( d_i theta_i + d_j theta_j ) xi.
+******************************************************************************/
+template <class ModelType, class VolType>
+struct PMBStiffness
+{
+    static constexpr bool has_dilatation = false;
+
+    ModelType model;
+    VolType vol;
+
+    KOKKOS_INLINE_FUNCTION
+    double stiffness( const int, const int j, const double xi ) const
+    {
+        return model.forceCoeff( 1.0, vol( j ) ) / ( xi * xi * xi );
+    }
+};
+
+template <class ModelType, class VolType, class WeightType>
+struct LPSStiffness
+{
+    static constexpr bool has_dilatation = true;
+
+    ModelType model;
+    VolType vol;
+    WeightType m;
+
+    KOKKOS_INLINE_FUNCTION
+    double stiffness( const int i, const int j, const double xi ) const
+    {
+        const double omega = model.influenceFunction( xi );
+        return model.s_coeff * ( 1.0 / m( i ) + 1.0 / m( j ) ) * omega *
+               vol( j ) / ( xi * xi );
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    double dilatationGradient( const int i, const int j, const double xi ) const
+    {
+        const double omega = model.influenceFunction( xi );
+        return model.dilatation( 1.0 / ( xi * xi ), xi, vol( j ), m( i ),
+                                 omega );
+    }
+
+    // Coefficients of theta_i and theta_j, respectively.
+    KOKKOS_INLINE_FUNCTION
+    void dilatationForce( const int i, const int j, const double xi,
+                          double& d_i, double& d_j ) const
+    {
+        const double omega = model.influenceFunction( xi );
+        d_i = model.theta_coeff * omega * vol( j ) / m( i );
+        d_j = model.theta_coeff * omega * vol( j ) / m( j );
+    }
+};
+
+/******************************************************************************
+  Assembled stiffness operator.
+
+  Block CSR (3x3) matrix with one row per owned particle: the diagonal block
+  first, then one block per neighbor in neighbor list order (columns are
+  local or ghost particle indices). Forces are then a sparse matrix-vector
+  product with the (gathered) displacements. For state-based models the
+  dilatation is a second, vector-valued product on the same pattern and its
+  contribution to the force is added in the same pass as the stiffness.
+
+  The operator must be re-assembled if the neighbor list or the reference
+  positions change.
+******************************************************************************/
+template <class MemorySpace>
+class StiffnessOperator
+{
+  public:
+    using memory_space = MemorySpace;
+    using exec_space = typename memory_space::execution_space;
+
+  protected:
+    std::size_t _begin = 0;
+    std::size_t _num_rows = 0;
+    std::size_t _nnz = 0;
+    bool _has_dilatation = false;
+
+    Kokkos::View<std::size_t*, memory_space> _offsets;
+    Kokkos::View<int*, memory_space> _columns;
+    Kokkos::View<double* [3][3], memory_space> _blocks;
+    Kokkos::View<double* [3], memory_space> _dilatation_gradient;
+    Kokkos::View<double* [3], memory_space> _dilatation_force;
+
+    Timer _timer = Timer( "Stiffness" );
+
+  public:
+    StiffnessOperator() = default;
+
+    // Assemble rows for owned particles [begin, end).
+    template <class NeighborListType, class PosType, class BondType>
+    void assemble( const NeighborListType& neigh_list, const std::size_t begin,
+                   const std::size_t end, const PosType& x,
+                   const BondType& bond )
+    {
+        _timer.start();
+        using list_type = Cabana::NeighborList<NeighborListType>;
+
+        _begin = begin;
+        _num_rows = end - begin;
+        _has_dilatation = BondType::has_dilatation;
+
+        // Row offsets, including the diagonal.
+        Kokkos::realloc( _offsets, _num_rows + 1 );
+        auto offsets = _offsets;
+        const std::size_t num_rows = _num_rows;
+        auto count = KOKKOS_LAMBDA( const std::size_t r, std::size_t& sum,
+                                    const bool final )
+        {
+            if ( final )
+                offsets( r ) = sum;
+            if ( r < num_rows )
+                sum += list_type::numNeighbor( neigh_list, r + begin ) + 1;
+        };
+        Kokkos::RangePolicy<exec_space> scan_policy( 0, num_rows + 1 );
+        Kokkos::parallel_scan( "CabanaPD::StiffnessOperator::offsets",
+                               scan_policy, count, _nnz );
+
+        Kokkos::realloc( _columns, _nnz );
+        Kokkos::realloc( _blocks, _nnz );
+        const std::size_t num_dilatation =
+            BondType::has_dilatation ? _nnz : 0;
+        Kokkos::realloc( _dilatation_gradient, num_dilatation );
+        Kokkos::realloc( _dilatation_force, num_dilatation );
+
+        auto columns = _columns;
+        auto blocks = _blocks;
+        auto gradient = _dilatation_gradient;
+        auto dilatation_force = _dilatation_force;
+        auto assemble_row = KOKKOS_LAMBDA( const std::size_t r )
+        {
+            const int i = r + begin;
+            const std::size_t diag = offsets( r );
+            const double x_i[3] = { x( i, 0 ), x( i, 1 ),
+                                    component<2>( x, i ) };
+
+            double k_ii[3][3] = { { 0.0, 0.0, 0.0 },
+                                  { 0.0, 0.0, 0.0 },
+                                  { 0.0, 0.0, 0.0 } };
+            double g_ii[3] = { 0.0, 0.0, 0.0 };
+            double d_ii[3] = { 0.0, 0.0, 0.0 };
+
+            const std::size_t num_neighbors =
+                list_type::numNeighbor( neigh_list, i );
+            for ( std::size_t n = 0; n < num_neighbors; n++ )
+            {
+                const int j = list_type::getNeighbor( neigh_list, i, n );
+                const double xi_v[3] = { x( j, 0 ) - x_i[0],
+                                         x( j, 1 ) - x_i[1],
+                                         component<2>( x, j ) - x_i[2] };
+                const double xi = Kokkos::sqrt( xi_v[0] * xi_v[0] +
+                                                xi_v[1] * xi_v[1] +
+                                                xi_v[2] * xi_v[2] );
+
+                const std::size_t b = diag + 1 + n;
+                columns( b ) = j;
+                const double k = bond.stiffness( i, j, xi );
+                for ( int a = 0; a < 3; a++ )
+                    for ( int c = 0; c < 3; c++ )
+                    {
+                        const double k_ac = k * xi_v[a] * xi_v[c];
+                        blocks( b, a, c ) = k_ac;
+                        k_ii[a][c] -= k_ac;
+                    }
+
+                if constexpr ( BondType::has_dilatation )
+                {
+                    const double g = bond.dilatationGradient( i, j, xi );
+                    double d_i, d_j;
+                    bond.dilatationForce( i, j, xi, d_i, d_j );
+                    for ( int a = 0; a < 3; a++ )
+                    {
+                        gradient( b, a ) = g * xi_v[a];
+                        g_ii[a] -= g * xi_v[a];
+                        dilatation_force( b, a ) = d_j * xi_v[a];
+                        d_ii[a] += d_i * xi_v[a];
+                    }
+                }
+            }
+
+            columns( diag ) = i;
+            for ( int a = 0; a < 3; a++ )
+                for ( int c = 0; c < 3; c++ )
+                    blocks( diag, a, c ) = k_ii[a][c];
+            if constexpr ( BondType::has_dilatation )
+            {
+                for ( int a = 0; a < 3; a++ )
+                {
+                    gradient( diag, a ) = g_ii[a];
+                    dilatation_force( diag, a ) = d_ii[a];
+                }
+            }
+        };
+        Kokkos::RangePolicy<exec_space> policy( 0, num_rows );
+        Kokkos::parallel_for( "CabanaPD::StiffnessOperator::assemble", policy,
+                              assemble_row );
+        Kokkos::fence();
+        _timer.stop();
+    }
+
+    // f_i += sum K u for owned particles [begin, end) within the assembled
+    // rows.
+    template <class ForceType, class PosType>
+    void apply( ForceType& f, const PosType& u, const std::size_t begin,
+                const std::size_t end ) const
+    {
+        checkRange( begin, end );
+        if ( _has_dilatation )
+            throw std::runtime_error( "StiffnessOperator: the dilatation is "
+                                      "required for state-based models." );
+
+        auto offsets = _offsets;
+        auto columns = _columns;
+        auto blocks = _blocks;
+        const std::size_t first = _begin;
+        auto multiply = KOKKOS_LAMBDA( const std::size_t i )
+        {
+            double f_i[3] = { 0.0, 0.0, 0.0 };
+            const std::size_t r = i - first;
+            for ( std::size_t b = offsets( r ); b < offsets( r + 1 ); b++ )
+            {
+                const int col = columns( b );
+                const double u_c[3] = { u( col, 0 ), u( col, 1 ),
+                                        component<2>( u, col ) };
+                for ( int a = 0; a < 3; a++ )
+                    for ( int c = 0; c < 3; c++ )
+                        f_i[a] += blocks( b, a, c ) * u_c[c];
+            }
+            addVector( f, i, f_i[0], f_i[1], f_i[2] );
+        };
+        Kokkos::RangePolicy<exec_space> policy( begin, end );
+        Kokkos::parallel_for( "CabanaPD::StiffnessOperator::apply", policy,
+                              multiply );
+    }
+
+    // f_i += sum K u + D theta (state-based models). The dilatation must be
+    // up to date on ghost particles.
+    template <class ForceType, class PosType, class DilatationType>
+    void apply( ForceType& f, const PosType& u, const DilatationType& theta,
+                const std::size_t begin, const std::size_t end ) const
+    {
+        checkRange( begin, end );
+        if ( !_has_dilatation )
+            throw std::runtime_error( "StiffnessOperator: no dilatation "
+                                      "coupling was assembled." );
+
+        auto offsets = _offsets;
+        auto columns = _columns;
+        auto blocks = _blocks;
+        auto dilatation_force = _dilatation_force;
+        const std::size_t first = _begin;
+        auto multiply = KOKKOS_LAMBDA( const std::size_t i )
+        {
+            double f_i[3] = { 0.0, 0.0, 0.0 };
+            const std::size_t r = i - first;
+            for ( std::size_t b = offsets( r ); b < offsets( r + 1 ); b++ )
+            {
+                const int col = columns( b );
+                const double u_c[3] = { u( col, 0 ), u( col, 1 ),
+                                        component<2>( u, col ) };
+                const double theta_c = theta( col );
+                for ( int a = 0; a < 3; a++ )
+                {
+                    for ( int c = 0; c < 3; c++ )
+                        f_i[a] += blocks( b, a, c ) * u_c[c];
+                    f_i[a] += dilatation_force( b, a ) * theta_c;
+                }
+            }
+            addVector( f, i, f_i[0], f_i[1], f_i[2] );
+        };
+        Kokkos::RangePolicy<exec_space> policy( begin, end );
+        Kokkos::parallel_for( "CabanaPD::StiffnessOperator::applyDilatation",
+                              policy, multiply );
+    }
+
+    // theta_i = sum G u for owned particles [begin, end).
+    template <class DilatationType, class PosType>
+    void dilatation( DilatationType& theta, const PosType& u,
+                     const std::size_t begin, const std::size_t end ) const
+    {
+        checkRange( begin, end );
+        if ( !_has_dilatation )
+            throw std::runtime_error( "StiffnessOperator: no dilatation "
+                                      "coupling was assembled." );
+
+        auto offsets = _offsets;
+        auto columns = _columns;
+        auto gradient = _dilatation_gradient;
+        const std::size_t first = _begin;
+        auto multiply = KOKKOS_LAMBDA( const std::size_t i )
+        {
+            double theta_i = 0.0;
+            const std::size_t r = i - first;
+            for ( std::size_t b = offsets( r ); b < offsets( r + 1 ); b++ )
+            {
+                const int col = columns( b );
+                theta_i += gradient( b, 0 ) * u( col, 0 ) +
+                           gradient( b, 1 ) * u( col, 1 ) +
+                           gradient( b, 2 ) * component<2>( u, col );
+            }
+            theta( i ) = theta_i;
+        };
+        Kokkos::RangePolicy<exec_space> policy( begin, end );
+        Kokkos::parallel_for( "CabanaPD::StiffnessOperator::dilatation", policy,
+                              multiply );
+    }
+
+    bool assembled() const { return _offsets.size() > 0; }
+    auto numRows() const { return _num_rows; }
+    auto numBlocks() const { return _nnz; }
+    auto timeAssembly() const { return _timer.time(); }
+
+    double bytes() const
+    {
+        return viewBytes( _offsets ) + viewBytes( _columns ) +
+               viewBytes( _blocks ) + viewBytes( _dilatation_gradient ) +
+               viewBytes( _dilatation_force );
+    }
+
+  protected:
+    void checkRange( const std::size_t begin, const std::size_t end ) const
+    {
+        if ( begin < _begin || end > _begin + _num_rows )
+            throw std::runtime_error( "StiffnessOperator: particle range is "
+                                      "outside the assembled rows." );
+    }
+};
+
+} // namespace CabanaPD
+
+#endif
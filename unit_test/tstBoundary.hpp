@@ -0,0 +1,163 @@
+/****************************************************************************
+ * Copyright (c) 2022 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of CabanaPD. CabanaPD is distributed under a           *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#include <array>
+
+#include <gtest/gtest.h>
+
+#include <Cabana_Core.hpp>
+#include <Kokkos_Core.hpp>
+
+#include <CabanaPD_Boundary.hpp>
+#include <CabanaPD_Particles.hpp>
+#include <CabanaPD_config.hpp>
+
+namespace Test
+{
+//---------------------------------------------------------------------------//
+// A boundary condition set must match applying its members one at a time, in
+// order, for each phase (before and after the force update), including where
+// members overlap. The fused operation must match the first phase.
+void testBoundaryConditionSet()
+{
+    using exec_space = TEST_EXECSPACE;
+    using memory_space = TEST_MEMSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+    using particles_type =
+        CabanaPD::Particles<memory_space, CabanaPD::PMB,
+                            CabanaPD::TemperatureIndependent>;
+    particles_type particles( exec_space(), box_min, box_max, num_cells, 0 );
+
+    auto x = particles.sliceReferencePosition();
+    auto u = particles.sliceDisplacement();
+    auto f = particles.sliceForce();
+    auto reset_functor = KOKKOS_LAMBDA( const int pid )
+    {
+        for ( int d = 0; d < 3; d++ )
+        {
+            u( pid, d ) = 0.1 * x( pid, d );
+            f( pid, d ) = x( pid, d ) + d;
+        }
+    };
+
+    // Overlapping regions in x.
+    using region_type = CabanaPD::RegionBoundary<CabanaPD::RectangularPrism>;
+    region_type low( -1.0, 0.2, -1.0, 1.0, -1.0, 1.0 );
+    region_type high( -0.2, 1.0, -1.0, 1.0, -1.0, 1.0 );
+    region_type middle( -0.5, 0.5, -1.0, 1.0, -1.0, 1.0 );
+
+    auto value_bc = CabanaPD::createBoundaryCondition(
+        CabanaPD::ForceValueBCTag{}, 1.0, exec_space{}, particles, low );
+    auto update_bc = CabanaPD::createBoundaryCondition(
+        CabanaPD::ForceUpdateBCTag{}, 2.0, exec_space{}, particles, high );
+    auto scale_op = KOKKOS_LAMBDA( const int pid, const double time )
+    {
+        for ( int d = 0; d < 3; d++ )
+            f( pid, d ) *= 3.0 + time;
+    };
+    auto scale_bc = CabanaPD::createBoundaryCondition(
+        scale_op, exec_space{}, particles, middle, true );
+    auto shift_op = KOKKOS_LAMBDA( const int pid, const double time )
+    {
+        u( pid, 0 ) += time;
+    };
+    auto shift_bc = CabanaPD::createBoundaryCondition(
+        shift_op, exec_space{}, particles, middle, false );
+    auto clamp_op = KOKKOS_LAMBDA( const int pid, const double )
+    {
+        u( pid, 0 ) *= -2.0;
+    };
+    auto clamp_bc = CabanaPD::createBoundaryCondition(
+        clamp_op, exec_space{}, particles, low, false );
+
+    using HostAoSoA = Cabana::AoSoA<Cabana::MemberTypes<double[3], double[3]>,
+                                    Kokkos::HostSpace>;
+    auto copy = [&]( HostAoSoA& aosoa_host )
+    {
+        aosoa_host.resize( particles.localOffset() );
+        auto u_host = Cabana::slice<0>( aosoa_host );
+        auto f_host = Cabana::slice<1>( aosoa_host );
+        Cabana::deep_copy( u_host, particles.sliceDisplacement() );
+        Cabana::deep_copy( f_host, particles.sliceForce() );
+    };
+    auto compare = [&]( HostAoSoA& a, HostAoSoA& b )
+    {
+        ASSERT_EQ( a.size(), b.size() );
+        auto u_a = Cabana::slice<0>( a );
+        auto f_a = Cabana::slice<1>( a );
+        auto u_b = Cabana::slice<0>( b );
+        auto f_b = Cabana::slice<1>( b );
+        for ( std::size_t p = 0; p < a.size(); p++ )
+            for ( int d = 0; d < 3; d++ )
+            {
+                EXPECT_DOUBLE_EQ( u_a( p, d ), u_b( p, d ) );
+                EXPECT_DOUBLE_EQ( f_a( p, d ), f_b( p, d ) );
+            }
+    };
+
+    const double time = 0.5;
+    particles.updateParticles( exec_space{}, reset_functor );
+    for ( const bool force_update : { false, true } )
+    {
+        CabanaPD::applyBoundaryCondition( value_bc, exec_space{}, particles,
+                                          time, force_update );
+        CabanaPD::applyBoundaryCondition( update_bc, exec_space{}, particles,
+                                          time, force_update );
+        CabanaPD::applyBoundaryCondition( scale_bc, exec_space{}, particles,
+                                          time, force_update );
+        CabanaPD::applyBoundaryCondition( shift_bc, exec_space{}, particles,
+                                          time, force_update );
+        CabanaPD::applyBoundaryCondition( clamp_bc, exec_space{}, particles,
+                                          time, force_update );
+    }
+    HostAoSoA reference( "reference", 0 );
+    copy( reference );
+
+    auto bc_set = CabanaPD::createBoundaryConditionSet(
+        exec_space{}, particles, value_bc, update_bc, scale_bc, shift_bc,
+        clamp_bc );
+    EXPECT_TRUE( bc_set.forceUpdate() );
+    particles.updateParticles( exec_space{}, reset_functor );
+    for ( const bool force_update : { false, true } )
+        CabanaPD::applyBoundaryCondition( bc_set, exec_space{}, particles,
+                                          time, force_update );
+    HostAoSoA combined( "combined", 0 );
+    copy( combined );
+    compare( combined, reference );
+
+    // The fused operation over all owned particles replaces the first phase.
+    particles.updateParticles( exec_space{}, reset_functor );
+    auto fused_op = bc_set.getFusedOp( particles, time );
+    Kokkos::RangePolicy<exec_space> policy( 0, particles.localOffset() );
+    Kokkos::parallel_for(
+        "fused_bc", policy,
+        KOKKOS_LAMBDA( const int pid ) { fused_op( pid ); } );
+    CabanaPD::applyBoundaryCondition( bc_set, exec_space{}, particles, time,
+                                      true );
+    HostAoSoA fused( "fused", 0 );
+    copy( fused );
+    compare( fused, reference );
+}
+
+//---------------------------------------------------------------------------//
+// TESTS
+//---------------------------------------------------------------------------//
+TEST( TEST_CATEGORY, test_boundary_condition_set )
+{
+    testBoundaryConditionSet();
+}
+
+//---------------------------------------------------------------------------//
+
+} // end namespace Test
@@ -0,0 +1,175 @@
+/****************************************************************************
+ * Copyright (c) 2022 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of CabanaPD. CabanaPD is distributed under a           *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#include <cstdio>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <Cabana_Core.hpp>
+#include <Kokkos_Core.hpp>
+
+#include <CabanaPD_Checkpoint.hpp>
+#include <CabanaPD_Force.hpp>
+#include <CabanaPD_Particles.hpp>
+
+#define CHECKPOINT_STRING( x ) #x
+#define CHECKPOINT_CATEGORY( x ) CHECKPOINT_STRING( x )
+
+namespace Test
+{
+//---------------------------------------------------------------------------//
+template <class BondStorageType = CabanaPD::BitBondStorage>
+void testCheckpointRestart( const int ranks_per_file )
+{
+    using exec_space = TEST_EXECSPACE;
+    using memory_space = TEST_MEMSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+
+    using particles_type =
+        CabanaPD::Particles<memory_space, CabanaPD::LPS,
+                            CabanaPD::TemperatureIndependent>;
+    particles_type particles( exec_space(), box_min, box_max, num_cells, 0 );
+    const int num_local = particles.localOffset();
+
+    // State which depends on the reference position.
+    auto x = particles.sliceReferencePosition();
+    auto u = particles.sliceDisplacement();
+    auto v = particles.sliceVelocity();
+    auto f = particles.sliceForce();
+    auto theta = particles.sliceDilatation();
+    auto m = particles.sliceWeightedVolume();
+    auto set_state = KOKKOS_LAMBDA( const int pid )
+    {
+        for ( int d = 0; d < 3; d++ )
+        {
+            u( pid, d ) = 0.1 * x( pid, d );
+            v( pid, d ) = 0.2 * x( pid, d ) + d;
+            f( pid, d ) = 0.3 * x( pid, d ) - d;
+        }
+        theta( pid ) = x( pid, 0 );
+        m( pid ) = x( pid, 1 );
+    };
+    particles.updateParticles( exec_space{}, set_state );
+
+    // Break every third bond of a neighbor list in the layout matching the
+    // bond storage.
+    using list_type = Cabana::VerletList<
+        memory_space, Cabana::FullNeighborTag,
+        typename CabanaPD::NeighborLayout<BondStorageType>::type,
+        Cabana::TeamOpTag>;
+    list_type neigh_list( x, 0, num_local, 0.41, 1.0, particles.ghost_mesh_lo,
+                          particles.ghost_mesh_hi );
+    using neighbor = Cabana::NeighborList<list_type>;
+    const int max_neighbors = neighbor::maxNeighbor( neigh_list );
+    using bond_type = CabanaPD::BrokenBonds<memory_space, BondStorageType>;
+    bond_type mu( neigh_list, num_local, max_neighbors, 0 );
+    Kokkos::RangePolicy<exec_space> policy( 0, num_local );
+    Kokkos::parallel_for(
+        "break_bonds", policy, KOKKOS_LAMBDA( const int i ) {
+            const int num_neighbors = neighbor::numNeighbor( neigh_list, i );
+            for ( int n = i % 3; n < num_neighbors; n += 3 )
+                mu.breakBond( i, n );
+        } );
+    const auto num_intact = mu.numIntact();
+
+    // Unique per test configuration since tests may run concurrently.
+    int num_ranks;
+    MPI_Comm_size( MPI_COMM_WORLD, &num_ranks );
+    const std::string prefix =
+        std::string( "test_checkpoint_" ) +
+        CHECKPOINT_CATEGORY( TEST_CATEGORY ) + "_" +
+        std::to_string( num_ranks ) + "_" + std::to_string( ranks_per_file ) +
+        ( CabanaPD::is_csr_storage<BondStorageType>::value ? "_csr" : "" );
+    CabanaPD::Checkpoint checkpoint( prefix, ranks_per_file );
+    checkpoint.write( 7, 0.25, CabanaPD::LPS{}, particles, mu );
+    checkpoint.finish();
+
+    // Restart into a clean state.
+    auto reset_state = KOKKOS_LAMBDA( const int pid )
+    {
+        for ( int d = 0; d < 3; d++ )
+        {
+            u( pid, d ) = 0.0;
+            v( pid, d ) = 0.0;
+            f( pid, d ) = 0.0;
+        }
+        theta( pid ) = 0.0;
+        m( pid ) = 0.0;
+    };
+    particles.updateParticles( exec_space{}, reset_state );
+    bond_type mu_restart( neigh_list, num_local, max_neighbors, 0 );
+
+    int step;
+    double time;
+    checkpoint.read( checkpoint.name( 7 ), step, time, CabanaPD::LPS{},
+                     particles, mu_restart );
+    EXPECT_EQ( step, 7 );
+    EXPECT_DOUBLE_EQ( time, 0.25 );
+    EXPECT_EQ( mu_restart.numIntact(), num_intact );
+
+    double error = 0.0;
+    Kokkos::parallel_reduce(
+        "check_state", policy,
+        KOKKOS_LAMBDA( const int pid, double& e ) {
+            for ( int d = 0; d < 3; d++ )
+            {
+                e += Kokkos::abs( u( pid, d ) - 0.1 * x( pid, d ) );
+                e += Kokkos::abs( v( pid, d ) - 0.2 * x( pid, d ) - d );
+                e += Kokkos::abs( f( pid, d ) - 0.3 * x( pid, d ) + d );
+            }
+            e += Kokkos::abs( theta( pid ) - x( pid, 0 ) );
+            e += Kokkos::abs( m( pid ) - x( pid, 1 ) );
+            const int num_neighbors =
+                neighbor::numNeighbor( neigh_list, pid );
+            for ( int n = 0; n < num_neighbors; n++ )
+                e += Kokkos::abs( mu_restart( pid, n ) - mu( pid, n ) );
+        },
+        error );
+    EXPECT_DOUBLE_EQ( error, 0.0 );
+
+    // Remove the checkpoint files once every rank has read them (one file
+    // per group of ranks, removed by the first rank of each).
+    int rank;
+    MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+    MPI_Barrier( MPI_COMM_WORLD );
+    const int per_file = ranks_per_file > 0 ? ranks_per_file : num_ranks;
+    if ( rank % per_file == 0 )
+    {
+        const std::string file_name = checkpoint.name( 7 ) + "_" +
+                                      std::to_string( rank / per_file ) +
+                                      ".bin";
+        EXPECT_EQ( std::remove( file_name.c_str() ), 0 );
+    }
+}
+
+//---------------------------------------------------------------------------//
+// TESTS
+//---------------------------------------------------------------------------//
+TEST( TEST_CATEGORY, test_checkpoint_single_file )
+{
+    testCheckpointRestart( 0 );
+}
+TEST( TEST_CATEGORY, test_checkpoint_file_per_rank )
+{
+    testCheckpointRestart( 1 );
+}
+TEST( TEST_CATEGORY, test_checkpoint_csr_bonds )
+{
+    testCheckpointRestart<CabanaPD::CSRBondStorage>( 1 );
+}
+
+//---------------------------------------------------------------------------//
+
+} // end namespace Test
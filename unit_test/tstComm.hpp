@@ -21,6 +21,8 @@
  ****************************************************************************/
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -29,8 +31,12 @@
 #include <Kokkos_Core.hpp>
 
 #include <CabanaPD_Comm.hpp>
+#include <CabanaPD_Force.hpp>
+#include <CabanaPD_ForceModels.hpp>
 #include <CabanaPD_Particles.hpp>
 #include <CabanaPD_config.hpp>
+#include <force/CabanaPD_ForceModels_PMB.hpp>
+#include <force/CabanaPD_Force_PMB.hpp>
 
 namespace Test
 {
@@ -163,10 +169,498 @@ void testHalo()
     }
 }
 
+//---------------------------------------------------------------------------//
+void testHalo2d()
+{
+    using exec_space = TEST_EXECSPACE;
+    using memory_space = TEST_MEMSPACE;
+
+    std::array<double, 2> box_min = { -1.0, -1.0 };
+    std::array<double, 2> box_max = { 1.0, 1.0 };
+    std::array<int, 2> num_cells = { 10, 10 };
+
+    int halo_width = 2;
+    using particles_type =
+        CabanaPD::Particles<memory_space, CabanaPD::PMB,
+                            CabanaPD::TemperatureIndependent,
+                            CabanaPD::BaseOutput, 2>;
+    particles_type particles( exec_space(), box_min, box_max, num_cells,
+                              halo_width );
+    const std::size_t init_num_particles = particles.localOffset();
+
+    int current_rank = -1;
+    MPI_Comm_rank( MPI_COMM_WORLD, &current_rank );
+    auto rank = particles.sliceVolume();
+    auto init_functor = KOKKOS_LAMBDA( const int pid )
+    {
+        rank( pid ) = static_cast<double>( current_rank );
+    };
+    particles.updateParticles( exec_space{}, init_functor );
+
+    // A gather is performed on construction.
+    CabanaPD::Comm<particles_type, CabanaPD::PMB,
+                   CabanaPD::TemperatureIndependent>
+        comm( particles );
+    EXPECT_EQ( particles.localOffset(), init_num_particles );
+
+    int current_size = -1;
+    MPI_Comm_size( MPI_COMM_WORLD, &current_size );
+    if ( current_size > 1 )
+    {
+        EXPECT_GT( particles.numGhost(), 0 );
+    }
+
+    // Set displacements to the owning rank and update the ghosts.
+    auto u = particles.sliceDisplacement();
+    Kokkos::RangePolicy<exec_space> local_policy( 0, particles.localOffset() );
+    Kokkos::parallel_for(
+        "set_u", local_policy, KOKKOS_LAMBDA( const int p ) {
+            for ( int d = 0; d < 2; ++d )
+                u( p, d ) = static_cast<double>( current_rank ) + d;
+        } );
+    particles.markModified( CabanaPD::DisplacementField{} );
+    comm.gatherDisplacement();
+
+    rank = particles.sliceVolume();
+    auto x = particles.sliceReferencePosition();
+    using HostAoSoA =
+        Cabana::AoSoA<Cabana::MemberTypes<double[2], double[2], double>,
+                      Kokkos::HostSpace>;
+    HostAoSoA aosoa_host( "host_aosoa", particles.referenceOffset() );
+    auto x_host = Cabana::slice<0>( aosoa_host );
+    auto u_host = Cabana::slice<1>( aosoa_host );
+    auto rank_host = Cabana::slice<2>( aosoa_host );
+    Cabana::deep_copy( x_host, x );
+    Cabana::deep_copy( u_host, u );
+    Cabana::deep_copy( rank_host, rank );
+    for ( std::size_t p = 0; p < particles.referenceOffset(); ++p )
+        for ( int d = 0; d < 2; ++d )
+            EXPECT_DOUBLE_EQ( u_host( p, d ), rank_host( p ) + d );
+
+    // All ghosts are owned by other ranks and lie in the halo region.
+    for ( std::size_t p = particles.localOffset();
+          p < particles.referenceOffset(); ++p )
+    {
+        for ( int d = 0; d < 2; ++d )
+        {
+            EXPECT_GE( x_host( p, d ), particles.ghost_mesh_lo[d] );
+            EXPECT_LE( x_host( p, d ), particles.ghost_mesh_hi[d] );
+        }
+        EXPECT_NE( rank_host( p ), current_rank );
+    }
+}
+
+//---------------------------------------------------------------------------//
+void testSplitGather()
+{
+    using exec_space = TEST_EXECSPACE;
+    using memory_space = TEST_MEMSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+
+    double delta = 0.20000001;
+    int halo_width = 2;
+    using particles_type =
+        CabanaPD::Particles<memory_space, CabanaPD::PMB,
+                            CabanaPD::TemperatureIndependent>;
+    particles_type particles( exec_space(), box_min, box_max, num_cells,
+                              halo_width );
+
+    // Place particles which could have ghost neighbors last.
+    particles.reorder( exec_space{}, delta );
+    EXPECT_LE( particles.interiorOffset(), particles.localOffset() );
+
+    int current_rank = -1;
+    MPI_Comm_rank( MPI_COMM_WORLD, &current_rank );
+    auto rank = particles.sliceVolume();
+    auto init_functor = KOKKOS_LAMBDA( const int pid )
+    {
+        rank( pid ) = static_cast<double>( current_rank );
+    };
+    particles.updateParticles( exec_space{}, init_functor );
+
+    // Only ghost particles within the horizon of the local domain.
+    CabanaPD::Comm<particles_type, CabanaPD::PMB,
+                   CabanaPD::TemperatureIndependent>
+        comm( particles, delta );
+
+    // Set displacements to the owning rank and update ghosts in two phases.
+    auto u = particles.sliceDisplacement();
+    Kokkos::RangePolicy<exec_space> local_policy( 0, particles.localOffset() );
+    Kokkos::parallel_for(
+        "set_u", local_policy, KOKKOS_LAMBDA( const int p ) {
+            for ( int d = 0; d < 3; ++d )
+                u( p, d ) = static_cast<double>( current_rank );
+        } );
+    particles.markModified( CabanaPD::DisplacementField{} );
+    comm.startGatherDisplacement();
+    comm.finishGatherDisplacement();
+
+    // Gathering again without any change is skipped.
+    EXPECT_EQ( comm.numSkippedGathers(), 0 );
+    comm.gatherFields( CabanaPD::DisplacementField{} );
+    EXPECT_EQ( comm.numSkippedGathers(), 1 );
+
+    rank = particles.sliceVolume();
+    using HostAoSoA = Cabana::AoSoA<Cabana::MemberTypes<double[3], double>,
+                                    Kokkos::HostSpace>;
+    HostAoSoA aosoa_host( "host_aosoa", particles.referenceOffset() );
+    auto u_host = Cabana::slice<0>( aosoa_host );
+    auto rank_host = Cabana::slice<1>( aosoa_host );
+    Cabana::deep_copy( u_host, u );
+    Cabana::deep_copy( rank_host, rank );
+    for ( std::size_t p = 0; p < particles.referenceOffset(); ++p )
+        for ( int d = 0; d < 3; ++d )
+            EXPECT_DOUBLE_EQ( u_host( p, d ), rank_host( p ) );
+
+    // Check that all ghosts could have bonds with local particles.
+    auto x = particles.sliceReferencePosition();
+    using HostPositionAoSoA =
+        Cabana::AoSoA<Cabana::MemberTypes<double[3]>, Kokkos::HostSpace>;
+    HostPositionAoSoA x_aosoa_host( "host_x", particles.referenceOffset() );
+    auto x_host = Cabana::slice<0>( x_aosoa_host );
+    Cabana::deep_copy( x_host, x );
+    for ( std::size_t p = particles.localOffset();
+          p < particles.referenceOffset(); ++p )
+    {
+        double dist_sq = 0.0;
+        for ( int d = 0; d < 3; ++d )
+        {
+            double dist =
+                std::max( particles.local_mesh_lo[d] - x_host( p, d ),
+                          x_host( p, d ) - particles.local_mesh_hi[d] );
+            if ( dist > 0.0 )
+                dist_sq += dist * dist;
+        }
+        EXPECT_LE( dist_sq, delta * delta );
+    }
+
+    // Interior particles must not have any ghost neighbors.
+    double mesh_min[3] = { particles.ghost_mesh_lo[0],
+                           particles.ghost_mesh_lo[1],
+                           particles.ghost_mesh_lo[2] };
+    double mesh_max[3] = { particles.ghost_mesh_hi[0],
+                           particles.ghost_mesh_hi[1],
+                           particles.ghost_mesh_hi[2] };
+    using NeighListType =
+        Cabana::VerletList<TEST_MEMSPACE, Cabana::FullNeighborTag,
+                           Cabana::VerletLayout2D, Cabana::TeamOpTag>;
+    NeighListType nlist( x, 0, particles.localOffset(), delta, 1.0, mesh_min,
+                         mesh_max );
+    const std::size_t local_offset = particles.localOffset();
+    int ghost_neighbors = 0;
+    Kokkos::RangePolicy<exec_space> interior_policy(
+        particles.frozenOffset(), particles.interiorOffset() );
+    Kokkos::parallel_reduce(
+        "interior_ghosts", interior_policy,
+        KOKKOS_LAMBDA( const int p, int& count ) {
+            auto num_n =
+                Cabana::NeighborList<NeighListType>::numNeighbor( nlist, p );
+            for ( std::size_t n = 0; n < num_n; ++n )
+            {
+                std::size_t j =
+                    Cabana::NeighborList<NeighListType>::getNeighbor( nlist,
+                                                                      p, n );
+                if ( j >= local_offset )
+                    count++;
+            }
+        },
+        ghost_neighbors );
+    EXPECT_EQ( ghost_neighbors, 0 );
+}
+
+//---------------------------------------------------------------------------//
+void testHaloOptions( const CabanaPD::HaloOptions options )
+{
+    using exec_space = TEST_EXECSPACE;
+    using memory_space = TEST_MEMSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+
+    double delta = 0.20000001;
+    int halo_width = 2;
+    using particles_type =
+        CabanaPD::Particles<memory_space, CabanaPD::PMB,
+                            CabanaPD::TemperatureIndependent>;
+    particles_type particles( exec_space(), box_min, box_max, num_cells,
+                              halo_width );
+
+    int current_rank = -1;
+    MPI_Comm_rank( MPI_COMM_WORLD, &current_rank );
+    auto rank = particles.sliceVolume();
+    auto init_functor = KOKKOS_LAMBDA( const int pid )
+    {
+        rank( pid ) = static_cast<double>( current_rank );
+    };
+    particles.updateParticles( exec_space{}, init_functor );
+
+    CabanaPD::Comm<particles_type, CabanaPD::PMB,
+                   CabanaPD::TemperatureIndependent>
+        comm( particles, delta, options );
+
+    // Repeated exchanges reuse the buffers (and persistent requests or shared
+    // window): ghosts must hold the latest owned values.
+    auto u = particles.sliceDisplacement();
+    Kokkos::RangePolicy<exec_space> local_policy( 0, particles.localOffset() );
+    for ( int round = 0; round < 3; ++round )
+    {
+        Kokkos::parallel_for(
+            "set_u", local_policy, KOKKOS_LAMBDA( const int p ) {
+                for ( int d = 0; d < 3; ++d )
+                    u( p, d ) = static_cast<double>( current_rank + round );
+            } );
+        particles.markModified( CabanaPD::DisplacementField{} );
+        if ( round == 0 )
+        {
+            comm.gatherDisplacement();
+        }
+        else if ( round == 1 )
+        {
+            comm.startGatherDisplacement();
+            comm.finishGatherDisplacement();
+        }
+        else
+        {
+            comm.gatherFields( CabanaPD::DisplacementField{} );
+        }
+
+        rank = particles.sliceVolume();
+        using HostAoSoA = Cabana::AoSoA<Cabana::MemberTypes<double[3], double>,
+                                        Kokkos::HostSpace>;
+        HostAoSoA aosoa_host( "host_aosoa", particles.referenceOffset() );
+        auto u_host = Cabana::slice<0>( aosoa_host );
+        auto rank_host = Cabana::slice<1>( aosoa_host );
+        Cabana::deep_copy( u_host, u );
+        Cabana::deep_copy( rank_host, rank );
+        for ( std::size_t p = 0; p < particles.referenceOffset(); ++p )
+            for ( int d = 0; d < 3; ++d )
+                EXPECT_DOUBLE_EQ( u_host( p, d ), rank_host( p ) + round );
+    }
+}
+
+void testHaloExchange()
+{
+    CabanaPD::HaloOptions options;
+    testHaloOptions( options );
+
+    options.persistent_requests = true;
+    testHaloOptions( options );
+
+    // Host staging (no effect for host memory).
+    options.gpu_aware_mpi = false;
+    testHaloOptions( options );
+
+    // Shared window between ranks on the same node.
+    options.node_shared = true;
+    testHaloOptions( options );
+    options.persistent_requests = false;
+    testHaloOptions( options );
+
+    // Without staging, the window is only accessible from host kernels.
+    options.gpu_aware_mpi = true;
+    if ( Kokkos::SpaceAccessibility<TEST_EXECSPACE,
+                                    Kokkos::HostSpace>::accessible )
+        testHaloOptions( options );
+    else
+        EXPECT_THROW( testHaloOptions( options ), std::runtime_error );
+}
+
+void testMigrate()
+{
+    using exec_space = TEST_EXECSPACE;
+    using memory_space = TEST_MEMSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+
+    double delta = 0.20000001;
+    int halo_width = 2;
+    using particles_type =
+        CabanaPD::Particles<memory_space, CabanaPD::PMB,
+                            CabanaPD::TemperatureIndependent>;
+    particles_type particles( exec_space(), box_min, box_max, num_cells,
+                              halo_width );
+    CabanaPD::Comm<particles_type, CabanaPD::PMB,
+                   CabanaPD::TemperatureIndependent>
+        comm( particles, delta );
+
+    unsigned long long num_before = particles.localOffset();
+    MPI_Allreduce( MPI_IN_PLACE, &num_before, 1, MPI_UNSIGNED_LONG_LONG,
+                   MPI_SUM, MPI_COMM_WORLD );
+
+    // Move every particle by less than one cell.
+    const double shift = 0.15;
+    comm.resetMigrationReference( particles );
+    auto u = particles.sliceDisplacement();
+    Kokkos::RangePolicy<exec_space> local_policy( 0, particles.localOffset() );
+    Kokkos::parallel_for(
+        "set_u", local_policy, KOKKOS_LAMBDA( const int p ) {
+            u( p, 0 ) = shift;
+            u( p, 1 ) = 0.0;
+            u( p, 2 ) = 0.0;
+        } );
+    EXPECT_DOUBLE_EQ( comm.maxDisplacementSinceMigration( particles ), shift );
+
+    auto distributor = comm.createDistributor( particles );
+    particles.migrate( distributor );
+    EXPECT_EQ( particles.numGhost(), 0 );
+
+    // No particles are lost.
+    unsigned long long num_after = particles.localOffset();
+    MPI_Allreduce( MPI_IN_PLACE, &num_after, 1, MPI_UNSIGNED_LONG_LONG,
+                   MPI_SUM, MPI_COMM_WORLD );
+    EXPECT_EQ( num_after, num_before );
+
+    // Ghosts for the new ownership carry the current displacements.
+    comm.rebuildHalo( particles, delta );
+    comm.gatherDisplacement();
+    u = particles.sliceDisplacement();
+    auto y = particles.sliceCurrentPosition();
+    using HostAoSoA = Cabana::AoSoA<Cabana::MemberTypes<double[3], double[3]>,
+                                    Kokkos::HostSpace>;
+    HostAoSoA aosoa_host( "host_aosoa", particles.referenceOffset() );
+    auto u_host = Cabana::slice<0>( aosoa_host );
+    auto y_host = Cabana::slice<1>( aosoa_host );
+    Cabana::deep_copy( u_host, u );
+    Cabana::deep_copy( y_host, y );
+    for ( std::size_t p = 0; p < particles.referenceOffset(); ++p )
+        EXPECT_DOUBLE_EQ( u_host( p, 0 ), shift );
+
+    // Local particles are owned by the rank containing them (or stay at the
+    // edge of the global domain).
+    for ( std::size_t p = 0; p < particles.localOffset(); ++p )
+        for ( int d = 0; d < 3; ++d )
+        {
+            if ( y_host( p, d ) < box_max[d] )
+            {
+                EXPECT_GE( y_host( p, d ), particles.local_mesh_lo[d] );
+                EXPECT_LT( y_host( p, d ), particles.local_mesh_hi[d] );
+            }
+        }
+}
+
+// Half neighbor lists must give the same forces, energy, and damage as full
+// lists, including for bonds with ghosts owned by another rank.
+void testHalfNeighbors()
+{
+    using exec_space = TEST_EXECSPACE;
+    using memory_space = TEST_MEMSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+
+    double delta = 0.41;
+    int halo_width = 3;
+    using model_type = CabanaPD::ForceModel<CabanaPD::PMB>;
+    model_type model( delta, 1.0, 1e-3 );
+    using particles_type =
+        CabanaPD::Particles<memory_space, CabanaPD::PMB,
+                            CabanaPD::TemperatureIndependent,
+                            CabanaPD::EnergyOutput>;
+    using comm_type = CabanaPD::Comm<particles_type, CabanaPD::PMB,
+                                     CabanaPD::TemperatureIndependent>;
+    using force_type = CabanaPD::Force<memory_space, model_type>;
+
+    using HostAoSoA =
+        Cabana::AoSoA<Cabana::MemberTypes<double[3], double, double>,
+                      Kokkos::HostSpace>;
+    auto compute = [&]( const bool half_neigh, HostAoSoA& aosoa_host )
+    {
+        particles_type particles( exec_space(), box_min, box_max, num_cells,
+                                  halo_width );
+        particles.useHalfNeighbors( half_neigh );
+        // Stretch increases away from the center, such that only some bonds
+        // break.
+        auto x = particles.sliceReferencePosition();
+        auto u = particles.sliceDisplacement();
+        auto init_functor = KOKKOS_LAMBDA( const int pid )
+        {
+            for ( int d = 0; d < 3; d++ )
+                u( pid, d ) = 0.05 * x( pid, d ) * x( pid, d ) * x( pid, d );
+        };
+        particles.updateParticles( exec_space{}, init_functor );
+
+        // Displacements are gathered on construction.
+        comm_type comm( particles, delta );
+        force_type force( half_neigh, particles, model );
+
+        computeForce( force, particles, Cabana::SerialOpTag{} );
+        double energy =
+            computeEnergy( force, particles, Cabana::SerialOpTag{} );
+        if ( half_neigh )
+        {
+            comm.scatterForce();
+            comm.scatterEnergy( particles );
+            computeDamage( force, particles );
+        }
+        MPI_Allreduce( MPI_IN_PLACE, &energy, 1, MPI_DOUBLE, MPI_SUM,
+                       MPI_COMM_WORLD );
+
+        // Only owned values are compared.
+        aosoa_host.resize( particles.localOffset() );
+        auto f_host = Cabana::slice<0>( aosoa_host );
+        auto W_host = Cabana::slice<1>( aosoa_host );
+        auto phi_host = Cabana::slice<2>( aosoa_host );
+        Cabana::deep_copy( f_host, particles.sliceForce() );
+        Cabana::deep_copy( W_host, particles.sliceStrainEnergy() );
+        Cabana::deep_copy( phi_host, particles.sliceDamage() );
+        return energy;
+    };
+
+    HostAoSoA full( "full", 0 );
+    const double energy_full = compute( false, full );
+    HostAoSoA half( "half", 0 );
+    const double energy_half = compute( true, half );
+
+    EXPECT_GT( energy_full, 0.0 );
+    EXPECT_NEAR( energy_half, energy_full, 1e-10 * energy_full );
+
+    ASSERT_EQ( half.size(), full.size() );
+    auto f_full = Cabana::slice<0>( full );
+    auto W_full = Cabana::slice<1>( full );
+    auto phi_full = Cabana::slice<2>( full );
+    auto f_half = Cabana::slice<0>( half );
+    auto W_half = Cabana::slice<1>( half );
+    auto phi_half = Cabana::slice<2>( half );
+    double max_f = 0.0;
+    double max_W = 0.0;
+    double max_phi = 0.0;
+    for ( std::size_t p = 0; p < full.size(); p++ )
+    {
+        for ( int d = 0; d < 3; d++ )
+            max_f = std::max( max_f, std::abs( f_full( p, d ) ) );
+        max_W = std::max( max_W, std::abs( W_full( p ) ) );
+        max_phi = std::max( max_phi, phi_full( p ) );
+    }
+    MPI_Allreduce( MPI_IN_PLACE, &max_phi, 1, MPI_DOUBLE, MPI_MAX,
+                   MPI_COMM_WORLD );
+    // Some, but not all, bonds are broken.
+    EXPECT_GT( max_phi, 0.0 );
+    EXPECT_LT( max_phi, 1.0 );
+    for ( std::size_t p = 0; p < full.size(); p++ )
+    {
+        for ( int d = 0; d < 3; d++ )
+            EXPECT_NEAR( f_half( p, d ), f_full( p, d ), 1e-10 * max_f );
+        EXPECT_NEAR( W_half( p ), W_full( p ), 1e-10 * max_W );
+        EXPECT_NEAR( phi_half( p ), phi_full( p ), 1e-10 );
+    }
+}
+
 //---------------------------------------------------------------------------//
 // TESTS
 //---------------------------------------------------------------------------//
 TEST( TEST_CATEGORY, test_particle_halo ) { testHalo(); }
+TEST( TEST_CATEGORY, test_particle_halo_2d ) { testHalo2d(); }
+TEST( TEST_CATEGORY, test_split_gather ) { testSplitGather(); }
+TEST( TEST_CATEGORY, test_halo_exchange ) { testHaloExchange(); }
+TEST( TEST_CATEGORY, test_migrate ) { testMigrate(); }
+TEST( TEST_CATEGORY, test_half_neighbors ) { testHalfNeighbors(); }
 
 //---------------------------------------------------------------------------//
 
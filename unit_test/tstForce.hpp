@@ -29,14 +29,20 @@
 
 #include <CabanaPD_Force.hpp>
 #include <CabanaPD_ForceModels.hpp>
+#include <CabanaPD_HeatTransfer.hpp>
 #include <CabanaPD_Input.hpp>
 #include <CabanaPD_Particles.hpp>
+#include <CabanaPD_Prenotch.hpp>
 #include <force/CabanaPD_ForceModels_LPS.hpp>
 #include <force/CabanaPD_ForceModels_PMB.hpp>
 #include <force/CabanaPD_Force_LPS.hpp>
 #include <force/CabanaPD_Force_PMB.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <type_traits>
+#include <vector>
 
 namespace Test
 {
@@ -653,20 +659,30 @@ void checkAnalyticalDilatation( ModelType, QuadraticTag, const double,
 {
 }
 
-template <class ForceType, class ParticleType>
+template <class ParallelType, class ForceType, class ParticleType>
 double computeEnergyAndForce( ForceType force, ParticleType& particles,
-                              const int )
+                              const int, const bool fused )
 {
-    computeForce( force, particles, Cabana::SerialOpTag() );
-    double Phi = computeEnergy( force, particles, Cabana::SerialOpTag() );
+    double Phi;
+    if ( fused )
+    {
+        Phi = computeForceAndEnergy( force, particles, ParallelType() );
+    }
+    else
+    {
+        computeForce( force, particles, ParallelType() );
+        Phi = computeEnergy( force, particles, ParallelType() );
+    }
+    // No ghost communication needed for a single rank.
+    computeDamage( force, particles );
     return Phi;
 }
 
-template <class ForceType, class ParticleType>
+template <class ParallelType, class ForceType, class ParticleType>
 void initializeForce( ForceType& force, ParticleType& particles )
 {
-    force.computeWeightedVolume( particles, Cabana::SerialOpTag{} );
-    force.computeDilatation( particles, Cabana::SerialOpTag{} );
+    force.computeWeightedVolume( particles, ParallelType{} );
+    force.computeDilatation( particles, ParallelType{} );
 }
 
 template <class ParticleType, class AoSoAType>
@@ -687,16 +703,22 @@ void copyTheta( CabanaPD::LPS, ParticleType particles, AoSoAType aosoa_host )
 //---------------------------------------------------------------------------//
 // Main test function.
 //---------------------------------------------------------------------------//
-template <class ModelType, class TestType>
+template <class BondCacheType = CabanaPD::NoBondCache,
+          class ParallelType = Cabana::SerialOpTag,
+          class BondStorageType = CabanaPD::BitBondStorage, class ModelType,
+          class TestType>
 void testForce( ModelType model, const double dx, const double m,
                 const double boundary_width, const TestType test_tag,
-                const double s0 )
+                const double s0, const bool half_neigh = false,
+                const bool fused = false )
 {
     auto particles = createParticles( model, test_tag, dx, s0 );
+    particles.useHalfNeighbors( half_neigh );
 
     // This needs to exactly match the mesh spacing to compare with the single
     // particle calculation.
-    CabanaPD::Force<TEST_MEMSPACE, ModelType> force( true, particles, model );
+    CabanaPD::Force<TEST_MEMSPACE, ModelType, BondStorageType, BondCacheType>
+        force( half_neigh, particles, model );
 
     auto x = particles.sliceReferencePosition();
     auto f = particles.sliceForce();
@@ -704,12 +726,14 @@ void testForce( ModelType model, const double dx, const double m,
     auto vol = particles.sliceVolume();
     //  No communication needed (as in the main solver) since this test is only
     //  intended for one rank.
-    initializeForce( force, particles );
+    initializeForce<ParallelType>( force, particles );
 
     unsigned int max_neighbors;
     unsigned long long total_neighbors;
     force.getNeighborStatistics( max_neighbors, total_neighbors );
-    double Phi = computeEnergyAndForce( force, particles, max_neighbors );
+    double Phi =
+        computeEnergyAndForce<ParallelType>( force, particles, max_neighbors,
+                                             fused );
 
     // Make a copy of final results on the host
     std::size_t num_particle = x.size();
@@ -738,9 +762,1016 @@ void testForce( ModelType model, const double dx, const double m,
                   boundary_width, Phi );
 }
 
+//---------------------------------------------------------------------------//
+// 2d checks (per unit thickness, in the k = 0 plane).
+//---------------------------------------------------------------------------//
+// Get the PMB strain energy density and x force (at one point) from the
+// planar neighborhood sum. Assumes zero y displacement for quadratic.
+template <class TestType, class ModelType>
+void computeReference2d( TestType, ModelType model, const int m,
+                         const double s0, const double x, double& W,
+                         double& fx )
+{
+    W = 0.0;
+    fx = 0.0;
+    double dx = model.delta / m;
+    double vol = dx * dx;
+    for ( int i = -m; i < m + 1; ++i )
+        for ( int j = -m; j < m + 1; ++j )
+        {
+            double xi_x = dx * i;
+            double xi_y = dx * j;
+            double xi = sqrt( xi_x * xi_x + xi_y * xi_y );
+            double rx = xi_x;
+            double ry = xi_y;
+            if constexpr ( std::is_same<TestType, LinearTag>::value )
+            {
+                rx += s0 * xi_x;
+                ry += s0 * xi_y;
+            }
+            else
+            {
+                rx += s0 * ( 2 * x * xi_x + xi_x * xi_x );
+            }
+            double r = sqrt( rx * rx + ry * ry );
+            double s = ( r - xi ) / xi;
+
+            if ( xi > 0.0 && xi < model.delta + 1e-14 )
+            {
+                W += 0.25 * model.c * s * s * xi * vol;
+                fx += model.c * s * vol * rx / r;
+            }
+        }
+}
+
+// Analytical 2d values: W = 2 K s0^2 for linear (exact for LPS), and for
+// quadratic PMB W = 3 K u11^2 ( x^2 + delta^2 / 8 ) and f_x = 3 K u11.
+template <class ModelType>
+void checkAnalytical2d( LinearTag, ModelType model, const double s0,
+                        const double W, const double, const double )
+{
+    if constexpr ( std::is_same<typename ModelType::base_model,
+                                CabanaPD::LPS>::value )
+    {
+        double analytical_W = 2.0 * model.planeBulkModulus() * s0 * s0;
+        EXPECT_FLOAT_EQ( W, analytical_W );
+    }
+    else
+    {
+        // Relatively large error for small m.
+        double analytical_W = 2.0 * model.K * s0 * s0;
+        EXPECT_NEAR( W, analytical_W, W * 0.15 );
+    }
+}
+
+template <class ModelType>
+void checkAnalytical2d( QuadraticTag, ModelType model, const double u11,
+                        const double W, const double fx, const double x )
+{
+    double analytical_W =
+        3.0 * model.K * u11 * u11 *
+        ( x * x + model.delta * model.delta / 8.0 );
+    EXPECT_NEAR( W, analytical_W, W * 0.05 );
+    double analytical_f = 3.0 * model.K * u11;
+    EXPECT_NEAR( fx, analytical_f, fx * 0.10 );
+}
+
+template <class ParallelType = Cabana::SerialOpTag, class ModelType,
+          class TestType>
+void testForce2d( ModelType model, const double dx,
+                  const double boundary_width, const TestType test_tag,
+                  const double s0, const bool fused = false )
+{
+    constexpr bool is_lps =
+        std::is_same<typename ModelType::base_model, CabanaPD::LPS>::value;
+    const int m = std::floor( model.delta / dx + 1e-10 );
+    std::array<double, 2> box_min = { -1.0, -1.0 };
+    std::array<double, 2> box_max = { 1.0, 1.0 };
+    int nc = ( box_max[0] - box_min[0] ) / dx;
+    std::array<int, 2> num_cells = { nc, nc };
+    CabanaPD::Particles<TEST_MEMSPACE, typename ModelType::base_model,
+                        typename ModelType::thermal_type,
+                        CabanaPD::EnergyOutput, 2>
+        particles( TEST_EXECSPACE{}, box_min, box_max, num_cells, 0 );
+
+    auto x = particles.sliceReferencePosition();
+    auto u = particles.sliceDisplacement();
+    auto init_functor = KOKKOS_LAMBDA( const int pid )
+    {
+        for ( int d = 0; d < 2; d++ )
+        {
+            if constexpr ( std::is_same<TestType, LinearTag>::value )
+                u( pid, d ) = s0 * x( pid, d );
+            else
+                u( pid, d ) = d == 0 ? s0 * x( pid, 0 ) * x( pid, 0 ) : 0.0;
+        }
+    };
+    particles.updateParticles( TEST_EXECSPACE{}, init_functor );
+
+    CabanaPD::Force<TEST_MEMSPACE, ModelType> force( false, particles, model );
+    initializeForce<ParallelType>( force, particles );
+    double Phi =
+        computeEnergyAndForce<ParallelType>( force, particles, 0, fused );
+
+    using HostAoSoA = Cabana::AoSoA<
+        Cabana::MemberTypes<double[2], double[2], double, double, double>,
+        Kokkos::HostSpace>;
+    HostAoSoA aosoa_host( "host_aosoa", particles.localOffset() );
+    auto f_host = Cabana::slice<0>( aosoa_host );
+    auto x_host = Cabana::slice<1>( aosoa_host );
+    auto W_host = Cabana::slice<2>( aosoa_host );
+    auto vol_host = Cabana::slice<3>( aosoa_host );
+    auto theta_host = Cabana::slice<4>( aosoa_host );
+    Cabana::deep_copy( f_host, particles.sliceForce() );
+    Cabana::deep_copy( x_host, x );
+    Cabana::deep_copy( W_host, particles.sliceStrainEnergy() );
+    Cabana::deep_copy( vol_host, particles.sliceVolume() );
+    if constexpr ( is_lps )
+        Cabana::deep_copy( theta_host, particles.sliceDilatation() );
+
+    // Avoid the system boundary for per particle values.
+    const double width = model.delta * boundary_width;
+    double ref_Phi = 0.0;
+    int particles_checked = 0;
+    for ( std::size_t p = 0; p < aosoa_host.size(); ++p )
+    {
+        double xp = x_host( p, 0 );
+        double yp = x_host( p, 1 );
+        if ( xp > particles.local_mesh_lo[0] + width &&
+             xp < particles.local_mesh_hi[0] - width &&
+             yp > particles.local_mesh_lo[1] + width &&
+             yp < particles.local_mesh_hi[1] - width )
+        {
+            double W = W_host( p );
+            double fx = f_host( p, 0 );
+            if constexpr ( std::is_same<TestType, LinearTag>::value )
+            {
+                EXPECT_LE( Kokkos::abs( fx ), 1e-13 );
+            }
+            if constexpr ( !is_lps )
+            {
+                double ref_W, ref_f;
+                computeReference2d( test_tag, model, m, s0, xp, ref_W,
+                                    ref_f );
+                EXPECT_NEAR( W, ref_W, 1e-6 );
+                if constexpr ( std::is_same<TestType, QuadraticTag>::value )
+                    EXPECT_FLOAT_EQ( fx, ref_f );
+            }
+            EXPECT_LE( Kokkos::abs( f_host( p, 1 ) ), 1e-13 );
+            checkAnalytical2d( test_tag, model, s0, W, fx, xp );
+            particles_checked++;
+        }
+        // The discrete weighted volume makes the LPS dilatation exact.
+        if constexpr ( is_lps && std::is_same<TestType, LinearTag>::value )
+            EXPECT_FLOAT_EQ( theta_host( p ), 2.0 * s0 );
+
+        ref_Phi += W_host( p ) * vol_host( p );
+    }
+    EXPECT_GT( particles_checked, 0 );
+    EXPECT_NEAR( Phi, ref_Phi, 1e-5 );
+}
+
+template <class StorageType>
+void testBrokenBonds( const int first_row )
+{
+    // Non-multiple of the word size to check row padding.
+    const int num_particles = 10;
+    const int max_neighbors = 45;
+    CabanaPD::BrokenBonds<TEST_MEMSPACE, StorageType> mu(
+        num_particles, max_neighbors, first_row );
+    EXPECT_GE( mu.extent( 1 ), static_cast<std::size_t>( max_neighbors ) );
+    EXPECT_EQ( mu.extent( 0 ), static_cast<std::size_t>( num_particles ) );
+    EXPECT_EQ( mu.view().extent( 0 ),
+               static_cast<std::size_t>( num_particles - first_row ) );
+
+    // Break every third bond (rows before the first are not stored).
+    Kokkos::RangePolicy<TEST_EXECSPACE> policy( first_row, num_particles );
+    Kokkos::parallel_for(
+        "break_bonds", policy, KOKKOS_LAMBDA( const int i ) {
+            for ( int n = 0; n < max_neighbors; n += 3 )
+                mu.breakBond( i, n );
+        } );
+
+    int num_intact = 0;
+    int num_wrong = 0;
+    Kokkos::parallel_reduce(
+        "count_bonds", policy,
+        KOKKOS_LAMBDA( const int i, int& intact, int& wrong ) {
+            for ( int n = 0; n < max_neighbors; n++ )
+            {
+                intact += mu( i, n );
+                if ( mu( i, n ) != ( n % 3 != 0 ) )
+                    wrong++;
+            }
+        },
+        num_intact, num_wrong );
+    EXPECT_EQ( num_intact,
+               ( num_particles - first_row ) * max_neighbors * 2 / 3 );
+    EXPECT_EQ( num_wrong, 0 );
+}
+
+// Neighbors from the shared cell list must match a separately built list,
+// including after a few particles moved to other cells.
+void testSpatialIndex()
+{
+    using exec_space = TEST_EXECSPACE;
+    using neighbor_list_type =
+        CabanaPD::Force<TEST_MEMSPACE,
+                        CabanaPD::BaseForceModel>::neighbor_list_type;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+    CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
+                        CabanaPD::TemperatureIndependent>
+        particles( exec_space(), box_min, box_max, num_cells, 0 );
+    auto x = particles.sliceReferencePosition();
+    const std::size_t num_local = particles.localOffset();
+    const double cutoff = 0.3;
+
+    auto index = particles.spatialIndex();
+    auto compare = [&]()
+    {
+        neighbor_list_type list;
+        index->neighbors( list, x, 0, num_local, cutoff,
+                          particles.ghost_mesh_lo, particles.ghost_mesh_hi );
+        neighbor_list_type expected;
+        expected.build( x, 0, num_local, cutoff, 1.0, particles.ghost_mesh_lo,
+                        particles.ghost_mesh_hi );
+
+        using list_type = Cabana::NeighborList<neighbor_list_type>;
+        Kokkos::RangePolicy<exec_space> policy( 0, num_local );
+        int num_wrong = 0;
+        Kokkos::parallel_reduce(
+            "compare_neighbors", policy,
+            KOKKOS_LAMBDA( const int i, int& wrong ) {
+                const int num = list_type::numNeighbor( list, i );
+                const int num_expected =
+                    list_type::numNeighbor( expected, i );
+                if ( num != num_expected )
+                    wrong++;
+                for ( int n = 0; n < num; n++ )
+                {
+                    bool found = false;
+                    for ( int m = 0; m < num_expected; m++ )
+                        found = found || list_type::getNeighbor( list, i, n ) ==
+                                             list_type::getNeighbor( expected,
+                                                                     i, m );
+                    if ( !found )
+                        wrong++;
+                }
+            },
+            num_wrong );
+        EXPECT_EQ( num_wrong, 0 );
+    };
+    compare();
+    EXPECT_EQ( index->numBuilds(), 1 );
+
+    // Move a few particles by more than a cell.
+    Kokkos::RangePolicy<exec_space> policy( 0, num_local );
+    Kokkos::parallel_for(
+        "move_particles", policy, KOKKOS_LAMBDA( const int p ) {
+            if ( p % 97 == 0 && x( p, 0 ) < 0.0 )
+                x( p, 0 ) += 0.45;
+        } );
+    compare();
+    EXPECT_EQ( index->numBuilds(), 1 );
+    EXPECT_EQ( index->numUpdates(), 1 );
+}
+
+// Removing broken bonds from the neighbor list must not change the results.
+template <class BondCacheType, class BondStorageType = CabanaPD::BitBondStorage,
+          class ModelType>
+void testCompactBonds( ModelType model, const double dx )
+{
+    auto particles = createParticles( model, LinearTag{}, dx, 1e-4 );
+    CabanaPD::Force<TEST_MEMSPACE, ModelType, BondStorageType, BondCacheType>
+        force( false, particles, model );
+
+    // CSR storage is not padded to the maximum number of neighbors
+    // (boundary particles have fewer).
+    if constexpr ( CabanaPD::is_csr_storage<BondStorageType>::value )
+        EXPECT_LT( force.getBrokenBonds().bytes(),
+                   static_cast<double>( particles.numLocal() ) *
+                       force.getMaxLocalNeighbors() );
+
+    // Break every third bond.
+    auto mu = force.getBrokenBonds();
+    auto neigh = force.getNeighbors();
+    using neighbor_type = decltype( neigh );
+    Kokkos::RangePolicy<TEST_EXECSPACE> policy( particles.frozenOffset(),
+                                                particles.localOffset() );
+    Kokkos::parallel_for(
+        "break_bonds", policy, KOKKOS_LAMBDA( const int i ) {
+            const int num_neighbors =
+                Cabana::NeighborList<neighbor_type>::numNeighbor( neigh, i );
+            for ( int n = i % 3; n < num_neighbors; n += 3 )
+                mu.breakBond( i, n );
+        } );
+
+    using HostAoSoA =
+        Cabana::AoSoA<Cabana::MemberTypes<double[3], double, double>,
+                      Kokkos::HostSpace>;
+    auto compute = [&]( HostAoSoA& aosoa_host )
+    {
+        initializeForce<Cabana::SerialOpTag>( force, particles );
+        double Phi = computeEnergyAndForce<Cabana::SerialOpTag>(
+            force, particles, 0, false );
+        aosoa_host.resize( particles.localOffset() );
+        auto f_host = Cabana::slice<0>( aosoa_host );
+        auto W_host = Cabana::slice<1>( aosoa_host );
+        auto phi_host = Cabana::slice<2>( aosoa_host );
+        Cabana::deep_copy( f_host, particles.sliceForce() );
+        Cabana::deep_copy( W_host, particles.sliceStrainEnergy() );
+        Cabana::deep_copy( phi_host, particles.sliceDamage() );
+        return Phi;
+    };
+    HostAoSoA reference( "reference", 0 );
+    double Phi_reference = compute( reference );
+
+    unsigned max_neighbors;
+    unsigned long long total_before;
+    force.getNeighborStatistics( max_neighbors, total_before );
+    EXPECT_TRUE( force.compactBonds( particles, 0.2 ) );
+    unsigned long long total_after;
+    force.getNeighborStatistics( max_neighbors, total_after );
+    EXPECT_LT( total_after, total_before );
+    // No broken bonds remain.
+    EXPECT_FALSE( force.compactBonds( particles, 1e-8 ) );
+
+    HostAoSoA compacted( "compacted", 0 );
+    double Phi_compacted = compute( compacted );
+    EXPECT_NEAR( Phi_compacted, Phi_reference,
+                 1e-10 * Kokkos::abs( Phi_reference ) );
+
+    auto f_ref = Cabana::slice<0>( reference );
+    auto W_ref = Cabana::slice<1>( reference );
+    auto phi_ref = Cabana::slice<2>( reference );
+    auto f = Cabana::slice<0>( compacted );
+    auto W = Cabana::slice<1>( compacted );
+    auto phi = Cabana::slice<2>( compacted );
+    for ( std::size_t p = particles.frozenOffset(); p < particles.localOffset();
+          p++ )
+    {
+        for ( int d = 0; d < 3; d++ )
+            EXPECT_NEAR( f( p, d ), f_ref( p, d ),
+                         1e-10 * ( 1.0 + Kokkos::abs( f_ref( p, d ) ) ) );
+        EXPECT_NEAR( W( p ), W_ref( p ), 1e-10 * ( 1.0 + W_ref( p ) ) );
+        EXPECT_NEAR( phi( p ), phi_ref( p ), 1e-12 );
+    }
+}
+
+// Runtime-sized pre-notches must break the same bonds as the fixed-size
+// pre-notches, for a single orientation and for one per notch.
+template <class ModelType>
+void testPrenotchList( ModelType model, const double dx )
+{
+    using exec_space = TEST_EXECSPACE;
+    using vector_type = Kokkos::Array<double, 3>;
+    using list_type = CabanaPD::PrenotchList<TEST_MEMSPACE>;
+    using host_vector_type = typename list_type::host_vector_type;
+
+    auto compare = [&]( auto& prenotch, list_type& prenotch_list )
+    {
+        auto particles = createParticles( model, LinearTag{}, dx, 0.0 );
+        CabanaPD::Force<TEST_MEMSPACE, ModelType> force( false, particles,
+                                                         model );
+        CabanaPD::Force<TEST_MEMSPACE, ModelType> force_list(
+            false, particles, model );
+        const auto num_bonds = force.getBrokenBonds().numIntact();
+        force.prenotch( exec_space{}, particles, prenotch );
+        force_list.prenotch( exec_space{}, particles, prenotch_list );
+        const auto num_intact = force.getBrokenBonds().numIntact();
+        EXPECT_LT( num_intact, num_bonds );
+        EXPECT_EQ( force_list.getBrokenBonds().numIntact(), num_intact );
+
+        // Neighbor order may differ between the lists: match bonds by the
+        // neighbor index.
+        auto mu = force.getBrokenBonds();
+        auto mu_list = force_list.getBrokenBonds();
+        auto neigh = force.getNeighbors();
+        auto neigh_list = force_list.getNeighbors();
+        using neighbor_type = Cabana::NeighborList<decltype( neigh )>;
+        Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
+                                                particles.localOffset() );
+        int num_wrong = 0;
+        Kokkos::parallel_reduce(
+            "compare_prenotch", policy,
+            KOKKOS_LAMBDA( const int i, int& wrong ) {
+                const int num_n = neighbor_type::numNeighbor( neigh, i );
+                const int num_m = neighbor_type::numNeighbor( neigh_list, i );
+                if ( num_n != num_m )
+                    wrong++;
+                for ( int n = 0; n < num_n; n++ )
+                {
+                    const int j = neighbor_type::getNeighbor( neigh, i, n );
+                    for ( int m = 0; m < num_m; m++ )
+                        if ( neighbor_type::getNeighbor( neigh_list, i, m ) ==
+                                 j &&
+                             mu_list( i, m ) != mu( i, n ) )
+                            wrong++;
+                }
+            },
+            num_wrong );
+        EXPECT_EQ( num_wrong, 0 );
+    };
+
+    // Two notches with the same orientation.
+    vector_type v1 = { 1.0, 0.0, 0.0 };
+    vector_type v2 = { 0.0, 0.0, 2.0 };
+    vector_type p01 = { -1.0, -0.45, -1.0 };
+    vector_type p02 = { 0.0, 0.35, -1.0 };
+    Kokkos::Array<vector_type, 2> p0 = { p01, p02 };
+    CabanaPD::Prenotch<2> fixed( v1, v2, p0 );
+    list_type fixed_list( host_vector_type{ v1 }, host_vector_type{ v2 },
+                          host_vector_type{ p01, p02 } );
+    compare( fixed, fixed_list );
+
+    // Different orientations, including an inclined notch.
+    vector_type v12 = { 0.5, 0.5, 0.0 };
+    vector_type v22 = { 0.0, 0.0, 1.5 };
+    Kokkos::Array<vector_type, 2> v1_all = { v1, v12 };
+    Kokkos::Array<vector_type, 2> v2_all = { v2, v22 };
+    CabanaPD::Prenotch<2> general( v1_all, v2_all, p0 );
+    list_type general_list( host_vector_type{ v1, v12 },
+                            host_vector_type{ v2, v22 },
+                            host_vector_type{ p01, p02 } );
+    compare( general, general_list );
+}
+
+// Checking bonds for breaking only within the active set must match the full
+// check (the quadratic displacement only stretches bonds beyond critical on
+// one side of the domain).
+template <class ParallelType, class ModelType>
+void testActiveBreaking( ModelType model, const double dx, const double s0 )
+{
+    using HostAoSoA = Cabana::AoSoA<Cabana::MemberTypes<double[3], double>,
+                                    Kokkos::HostSpace>;
+    auto compute = [&]( HostAoSoA& aosoa_host, const bool active )
+    {
+        auto particles = createParticles( model, QuadraticTag{}, dx, s0 );
+        CabanaPD::Force<TEST_MEMSPACE, ModelType> force( false, particles,
+                                                         model );
+        if ( active )
+        {
+            EXPECT_FALSE( force.activeBondBreaking() );
+            int num_active = force.updateActiveBonds( particles, 0.5 );
+            EXPECT_TRUE( force.activeBondBreaking() );
+            EXPECT_GT( num_active, 0 );
+            EXPECT_LT( num_active, static_cast<int>( particles.numLocal() ) );
+            computeForceActiveBreaking( force, particles, ParallelType{} );
+        }
+        else
+        {
+            computeForce( force, particles, ParallelType{} );
+        }
+        computeEnergy( force, particles, ParallelType{} );
+        computeDamage( force, particles );
+
+        aosoa_host.resize( particles.localOffset() );
+        auto f_host = Cabana::slice<0>( aosoa_host );
+        auto phi_host = Cabana::slice<1>( aosoa_host );
+        Cabana::deep_copy( f_host, particles.sliceForce() );
+        Cabana::deep_copy( phi_host, particles.sliceDamage() );
+    };
+    HostAoSoA reference( "reference", 0 );
+    compute( reference, false );
+    HostAoSoA active( "active", 0 );
+    compute( active, true );
+
+    auto f_ref = Cabana::slice<0>( reference );
+    auto phi_ref = Cabana::slice<1>( reference );
+    auto f = Cabana::slice<0>( active );
+    auto phi = Cabana::slice<1>( active );
+    double max_damage = 0.0;
+    for ( std::size_t p = 0; p < reference.size(); p++ )
+    {
+        for ( int d = 0; d < 3; d++ )
+            EXPECT_NEAR( f( p, d ), f_ref( p, d ),
+                         1e-10 * ( 1.0 + Kokkos::abs( f_ref( p, d ) ) ) );
+        EXPECT_DOUBLE_EQ( phi( p ), phi_ref( p ) );
+        max_damage = std::max( max_damage, phi_ref( p ) );
+    }
+    // Some bonds must have been broken.
+    EXPECT_GT( max_damage, 0.0 );
+}
+
+// Output evaluations without bond breaking leave the bonds intact and match
+// the separate non-breaking force and energy passes.
+template <class ParallelType, class ModelType>
+void testNoBreakingEnergy( ModelType model, const double dx, const double s0 )
+{
+    using HostAoSoA =
+        Cabana::AoSoA<Cabana::MemberTypes<double[3], double, double>,
+                      Kokkos::HostSpace>;
+    auto compute = [&]( HostAoSoA& aosoa_host, const bool fused )
+    {
+        auto particles = createParticles( model, QuadraticTag{}, dx, s0 );
+        CabanaPD::Force<TEST_MEMSPACE, ModelType> force( false, particles,
+                                                         model );
+        initializeForce<ParallelType>( force, particles );
+        double Phi;
+        if ( fused )
+        {
+            Phi = computeForceAndEnergyNoBreaking( force, particles,
+                                                   ParallelType{} );
+        }
+        else
+        {
+            computeForceNoBreaking( force, particles, ParallelType{} );
+            Phi = computeEnergy( force, particles, ParallelType{} );
+        }
+        computeDamage( force, particles );
+
+        aosoa_host.resize( particles.localOffset() );
+        auto f_host = Cabana::slice<0>( aosoa_host );
+        auto W_host = Cabana::slice<1>( aosoa_host );
+        auto phi_host = Cabana::slice<2>( aosoa_host );
+        Cabana::deep_copy( f_host, particles.sliceForce() );
+        Cabana::deep_copy( W_host, particles.sliceStrainEnergy() );
+        Cabana::deep_copy( phi_host, particles.sliceDamage() );
+
+        // The bonds are still intact: a breaking pass now damages them.
+        computeForceAndEnergy( force, particles, ParallelType{} );
+        computeDamage( force, particles );
+        double max_damage = 0.0;
+        auto phi = particles.sliceDamage();
+        Kokkos::RangePolicy<TEST_EXECSPACE> policy( 0,
+                                                    particles.localOffset() );
+        Kokkos::parallel_reduce(
+            "max_damage", policy,
+            KOKKOS_LAMBDA( const int p, double& max ) {
+                if ( phi( p ) > max )
+                    max = phi( p );
+            },
+            Kokkos::Max<double>( max_damage ) );
+        EXPECT_GT( max_damage, 0.0 );
+        return Phi;
+    };
+    HostAoSoA reference( "reference", 0 );
+    double Phi_ref = compute( reference, false );
+    HostAoSoA fused( "fused", 0 );
+    double Phi = compute( fused, true );
+
+    auto f_ref = Cabana::slice<0>( reference );
+    auto W_ref = Cabana::slice<1>( reference );
+    auto f = Cabana::slice<0>( fused );
+    auto W = Cabana::slice<1>( fused );
+    auto phi = Cabana::slice<2>( fused );
+    for ( std::size_t p = 0; p < reference.size(); p++ )
+    {
+        for ( int d = 0; d < 3; d++ )
+            EXPECT_NEAR( f( p, d ), f_ref( p, d ),
+                         1e-10 * ( 1.0 + Kokkos::abs( f_ref( p, d ) ) ) );
+        EXPECT_NEAR( W( p ), W_ref( p ), 1e-10 * ( 1.0 + W_ref( p ) ) );
+        EXPECT_DOUBLE_EQ( phi( p ), 0.0 );
+    }
+    EXPECT_NEAR( Phi, Phi_ref, 1e-10 * Kokkos::abs( Phi_ref ) );
+}
+
+// Forces from the assembled stiffness must match the bond kernels.
+template <class ModelType, class TestType>
+void testStiffness( ModelType model, const double dx, const TestType test_tag )
+{
+    auto particles = createParticles( model, test_tag, dx, 0.1 );
+    CabanaPD::Force<TEST_MEMSPACE, ModelType> force( false, particles, model );
+    constexpr bool is_lps =
+        std::is_same<typename ModelType::base_model, CabanaPD::LPS>::value;
+
+    using HostAoSoA = Cabana::AoSoA<Cabana::MemberTypes<double[3], double>,
+                                    Kokkos::HostSpace>;
+    auto compute = [&]( HostAoSoA& aosoa_host )
+    {
+        initializeForce<Cabana::SerialOpTag>( force, particles );
+        computeForce( force, particles, Cabana::SerialOpTag() );
+        aosoa_host.resize( particles.localOffset() );
+        auto f_host = Cabana::slice<0>( aosoa_host );
+        auto theta_host = Cabana::slice<1>( aosoa_host );
+        Cabana::deep_copy( f_host, particles.sliceForce() );
+        if constexpr ( is_lps )
+            Cabana::deep_copy( theta_host, particles.sliceDilatation() );
+        else
+            Cabana::deep_copy( theta_host, 0.0 );
+    };
+    HostAoSoA reference( "reference", 0 );
+    compute( reference );
+
+    force.assembleStiffness( particles );
+    // One diagonal block per row in addition to the bonds.
+    auto& stiffness = force.getStiffness();
+    EXPECT_EQ( stiffness.numRows(),
+               particles.localOffset() - particles.frozenOffset() );
+    EXPECT_GT( stiffness.numBlocks(), stiffness.numRows() );
+
+    HostAoSoA assembled( "assembled", 0 );
+    compute( assembled );
+
+    auto f_ref = Cabana::slice<0>( reference );
+    auto theta_ref = Cabana::slice<1>( reference );
+    auto f = Cabana::slice<0>( assembled );
+    auto theta = Cabana::slice<1>( assembled );
+    for ( std::size_t p = particles.frozenOffset(); p < particles.localOffset();
+          p++ )
+    {
+        for ( int d = 0; d < 3; d++ )
+            EXPECT_NEAR( f( p, d ), f_ref( p, d ),
+                         1e-8 * ( 1.0 + Kokkos::abs( f_ref( p, d ) ) ) );
+        EXPECT_NEAR( theta( p ), theta_ref( p ),
+                     1e-10 * ( 1.0 + Kokkos::abs( theta_ref( p ) ) ) );
+    }
+}
+
+template <class ModelType>
+void testEnsemble( ModelType model, const double dx,
+                   const std::vector<double>& scale )
+{
+    auto particles = createParticles( model, QuadraticTag{}, dx, 0.01 );
+
+    using HostAoSoA =
+        Cabana::AoSoA<Cabana::MemberTypes<double[3], double, double, int>,
+                      Kokkos::HostSpace>;
+    auto compute = [&]( auto force, HostAoSoA& aosoa_host )
+    {
+        initializeForce<Cabana::SerialOpTag>( force, particles );
+        double Phi = computeEnergyAndForce<Cabana::SerialOpTag>(
+            force, particles, 0, false );
+        aosoa_host.resize( particles.localOffset() );
+        auto f_host = Cabana::slice<0>( aosoa_host );
+        auto W_host = Cabana::slice<1>( aosoa_host );
+        auto vol_host = Cabana::slice<2>( aosoa_host );
+        auto type_host = Cabana::slice<3>( aosoa_host );
+        Cabana::deep_copy( f_host, particles.sliceForce() );
+        Cabana::deep_copy( W_host, particles.sliceStrainEnergy() );
+        Cabana::deep_copy( vol_host, particles.sliceVolume() );
+        Cabana::deep_copy( type_host, particles.sliceType() );
+        return Phi;
+    };
+    HostAoSoA reference( "reference", 0 );
+    compute( CabanaPD::Force<TEST_MEMSPACE, ModelType>( false, particles,
+                                                        model ),
+             reference );
+
+    // Split into members along x, each with a scaled bulk modulus (and
+    // fracture energy, keeping the critical stretch).
+    const int num_members = scale.size();
+    auto x = particles.sliceReferencePosition();
+    auto type = particles.sliceType();
+    Kokkos::RangePolicy<TEST_EXECSPACE> policy( 0, particles.localOffset() );
+    Kokkos::parallel_for(
+        "set_members", policy, KOKKOS_LAMBDA( const int p ) {
+            int k = ( x( p, 0 ) + 1.0 ) / 2.0 * num_members;
+            type( p ) = Kokkos::min( k, num_members - 1 );
+        } );
+    std::vector<double> K;
+    std::vector<double> G0;
+    for ( auto s : scale )
+    {
+        K.push_back( s * model.K );
+        if constexpr ( CabanaPD::is_fracture<
+                           typename ModelType::fracture_type>::value )
+            G0.push_back( s * model.G0 );
+    }
+    auto ensemble_model = [&]()
+    {
+        if constexpr ( CabanaPD::is_fracture<
+                           typename ModelType::fracture_type>::value )
+            return CabanaPD::createEnsembleForceModel(
+                CabanaPD::PMB{}, CabanaPD::Fracture{}, particles, model.delta,
+                K, G0 );
+        else
+            return CabanaPD::createEnsembleForceModel(
+                CabanaPD::PMB{}, CabanaPD::NoFracture{}, particles,
+                model.delta, K );
+    }();
+    using ensemble_type = decltype( ensemble_model );
+    EXPECT_TRUE( CabanaPD::is_ensemble<ensemble_type>::value );
+    EXPECT_EQ( ensemble_model.numMembers(), scale.size() );
+    // The stable timestep follows the stiffest member.
+    const double max_c =
+        *std::max_element( scale.begin(), scale.end() ) * model.c;
+    EXPECT_NEAR( ensemble_model.maxMemberC(), max_c, 1e-12 * max_c );
+
+    HostAoSoA ensemble( "ensemble", 0 );
+    double Phi = compute( CabanaPD::Force<TEST_MEMSPACE, ensemble_type>(
+                              false, particles, ensemble_model ),
+                          ensemble );
+
+    // Forces and energies scale with the member modulus.
+    auto f_ref = Cabana::slice<0>( reference );
+    auto W_ref = Cabana::slice<1>( reference );
+    auto f = Cabana::slice<0>( ensemble );
+    auto W = Cabana::slice<1>( ensemble );
+    auto vol = Cabana::slice<2>( ensemble );
+    auto member = Cabana::slice<3>( ensemble );
+    double Phi_expected = 0.0;
+    for ( std::size_t p = 0; p < particles.localOffset(); p++ )
+    {
+        const double c = scale[member( p )];
+        for ( int d = 0; d < 3; d++ )
+            EXPECT_NEAR( f( p, d ), c * f_ref( p, d ),
+                         1e-10 * ( 1.0 + Kokkos::abs( f_ref( p, d ) ) ) );
+        EXPECT_NEAR( W( p ), c * W_ref( p ), 1e-10 * ( 1.0 + W_ref( p ) ) );
+        Phi_expected += c * W_ref( p ) * vol( p );
+    }
+    EXPECT_NEAR( Phi, Phi_expected, 1e-10 * Kokkos::abs( Phi_expected ) );
+}
+
+// Single precision displacements and forces with double reference positions
+// (exercising the host SIMD kernel) must match the double precision result
+// to single precision.
+template <class ModelType>
+void testMixedPrecision( ModelType model, const double dx, const double s0 )
+{
+    auto particles = createParticles( model, QuadraticTag{}, dx, s0 );
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    int nc = ( box_max[0] - box_min[0] ) / dx;
+    std::array<int, 3> num_cells = { nc, nc, nc };
+    CabanaPD::Particles<
+        TEST_MEMSPACE, typename ModelType::base_model,
+        typename ModelType::thermal_type, CabanaPD::EnergyOutput, 3,
+        CabanaPD::DefaultVectorLength<TEST_MEMSPACE>::value,
+        CabanaPD::MixedPrecision>
+        mixed( TEST_EXECSPACE{}, box_min, box_max, num_cells, 0 );
+    ASSERT_EQ( mixed.localOffset(), particles.localOffset() );
+    static_assert(
+        std::is_same<typename decltype( mixed.sliceDisplacement() )::value_type,
+                     float>::value );
+
+    // Particles are created in the same order: copy (and round) the
+    // displacements.
+    auto u = particles.sliceDisplacement();
+    auto u_mixed = mixed.sliceDisplacement();
+    Kokkos::RangePolicy<TEST_EXECSPACE> policy( 0, particles.localOffset() );
+    Kokkos::parallel_for(
+        "copy_displacement", policy, KOKKOS_LAMBDA( const int p ) {
+            for ( int d = 0; d < 3; d++ )
+                u_mixed( p, d ) = static_cast<float>( u( p, d ) );
+        } );
+
+    // Forces and strain energy density, converted to double.
+    using result_type = Kokkos::View<double* [4], TEST_MEMSPACE>;
+    auto compute = [&]( auto& p, result_type& result )
+    {
+        CabanaPD::Force<TEST_MEMSPACE, ModelType> force( false, p, model );
+        initializeForce<Cabana::SerialOpTag>( force, p );
+        double Phi = computeEnergyAndForce<Cabana::SerialOpTag>( force, p, 0,
+                                                                 false );
+        auto f = p.sliceForce();
+        auto W = p.sliceStrainEnergy();
+        Kokkos::parallel_for(
+            "copy_results", policy, KOKKOS_LAMBDA( const int i ) {
+                for ( int d = 0; d < 3; d++ )
+                    result( i, d ) = f( i, d );
+                result( i, 3 ) = W( i );
+            } );
+        return Phi;
+    };
+    result_type reference( "reference", particles.localOffset() );
+    result_type single( "single", particles.localOffset() );
+    double Phi_ref = compute( particles, reference );
+    double Phi = compute( mixed, single );
+
+    auto ref_host =
+        Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace(), reference );
+    auto single_host =
+        Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace(), single );
+    double f_max = 0.0;
+    for ( std::size_t p = 0; p < ref_host.extent( 0 ); p++ )
+        for ( int d = 0; d < 3; d++ )
+            f_max = Kokkos::max( f_max, Kokkos::abs( ref_host( p, d ) ) );
+    for ( std::size_t p = 0; p < ref_host.extent( 0 ); p++ )
+    {
+        for ( int d = 0; d < 3; d++ )
+            EXPECT_NEAR( single_host( p, d ), ref_host( p, d ), 1e-4 * f_max );
+        EXPECT_NEAR( single_host( p, 3 ), ref_host( p, 3 ),
+                     1e-4 * ( 1.0 + ref_host( p, 3 ) ) );
+    }
+    EXPECT_NEAR( Phi, Phi_ref, 1e-4 * Kokkos::abs( Phi_ref ) );
+}
+
+// Particles for heat transfer with a Gaussian temperature profile in x.
+auto createThermalParticles( const double dx )
+{
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    int nc = ( box_max[0] - box_min[0] ) / dx;
+    std::array<int, 3> num_cells = { nc, nc, nc };
+    auto particles =
+        CabanaPD::createParticles<TEST_MEMSPACE, CabanaPD::PMB,
+                                  CabanaPD::DynamicTemperature>(
+            TEST_EXECSPACE{}, box_min, box_max, num_cells, 0 );
+
+    auto x = particles->sliceReferencePosition();
+    auto rho = particles->sliceDensity();
+    auto temp = particles->sliceTemperature();
+    auto init_functor = KOKKOS_LAMBDA( const int pid )
+    {
+        rho( pid ) = 1.0;
+        temp( pid ) = Kokkos::exp( -x( pid, 0 ) * x( pid, 0 ) / 0.5 );
+    };
+    particles->updateParticles( TEST_EXECSPACE{}, init_functor );
+    return particles;
+}
+
+template <class ParticleType>
+std::vector<double> copyTemperature( ParticleType& particles )
+{
+    using HostAoSoA =
+        Cabana::AoSoA<Cabana::MemberTypes<double>, Kokkos::HostSpace>;
+    HostAoSoA aosoa_host( "host_temperature", particles.localOffset() );
+    auto temp_host = Cabana::slice<0>( aosoa_host );
+    Cabana::deep_copy( temp_host, particles.sliceTemperature() );
+    std::vector<double> temp( aosoa_host.size() );
+    for ( std::size_t p = 0; p < aosoa_host.size(); p++ )
+        temp[p] = temp_host( p );
+    return temp;
+}
+
+// RKL2 super-time-stepping must match well resolved forward Euler diffusion
+// both within the explicit stability limit and beyond it, where forward
+// Euler is unstable.
+void testHeatTransferRKL2()
+{
+    double m = 3;
+    double dx = 2.0 / 10.0;
+    double delta = dx * m;
+    double K = 1.0;
+    double kappa = 1.0;
+    double cp = 1.0;
+
+    // Explicit limit from the lattice sum of the bond conductances (as in
+    // the input timestep estimate), with unit density.
+    CabanaPD::BaseDynamicTemperatureModel thermal( delta, kappa, cp );
+    double sum = 0.0;
+    for ( int i = -m; i <= m; i++ )
+        for ( int j = -m; j <= m; j++ )
+            for ( int k = -m; k <= m; k++ )
+            {
+                const double r2 = ( i * i + j * j + k * k ) * dx * dx;
+                if ( r2 > 0.0 && r2 < delta * delta + 1e-10 )
+                    sum += dx * dx * dx *
+                           thermal.microconductivity_function(
+                               std::sqrt( r2 ) ) /
+                           r2;
+            }
+    const double dt_crit = cp / sum;
+
+    // Forward Euler (num_stages of 0) or RKL2 steps.
+    auto integrate = [&]( const double dt, const int num_stages,
+                          const int num_steps )
+    {
+        auto particles = createThermalParticles( dx );
+        auto model = CabanaPD::createForceModel(
+            CabanaPD::PMB{}, CabanaPD::NoFracture{}, *particles, delta, K,
+            kappa, cp, 0.0, 0.0 );
+        using model_type = decltype( model );
+        CabanaPD::Force<TEST_MEMSPACE, model_type> force( false, *particles,
+                                                          model );
+        CabanaPD::HeatTransfer<TEST_MEMSPACE, model_type> heat_transfer(
+            false, force, model );
+
+        for ( int n = 0; n < num_steps; n++ )
+        {
+            if ( num_stages > 0 )
+                CabanaPD::computeHeatTransferRKL2(
+                    heat_transfer, *particles, Cabana::SerialOpTag{}, dt,
+                    num_stages, []() {} );
+            else
+                CabanaPD::computeHeatTransfer(
+                    heat_transfer, *particles, Cabana::SerialOpTag{}, dt );
+        }
+        heat_transfer.executionSpace().fence();
+        return copyTemperature( *particles );
+    };
+    auto max_error = []( const std::vector<double>& a,
+                         const std::vector<double>& b )
+    {
+        double error = 0.0;
+        for ( std::size_t p = 0; p < a.size(); p++ )
+            error = std::max( error, std::abs( a[p] - b[p] ) );
+        return error;
+    };
+
+    const auto reference = integrate( 0.05 * dt_crit, 0, 400 );
+    // The profile must have diffused (the initial maximum is one).
+    EXPECT_LT( *std::max_element( reference.begin(), reference.end() ), 0.9 );
+
+    // Within the explicit limit: both methods are accurate (RKL2 with 2
+    // stages is stable up to the explicit step).
+    const double dt_stable = 0.5 * dt_crit;
+    EXPECT_LT( max_error( integrate( dt_stable, 0, 40 ), reference ), 1e-2 );
+    EXPECT_LT( max_error( integrate( dt_stable, 2, 40 ), reference ), 1e-2 );
+
+    // Beyond the explicit limit: RKL2 with 5 stages is stable up to 7
+    // explicit steps.
+    const double dt_large = 5.0 * dt_crit;
+    EXPECT_LT( max_error( integrate( dt_large, 5, 4 ), reference ), 2e-2 );
+
+    // Forward Euler amplifies roundoff without bound at the same step, while
+    // the RKL2 temperature stays bounded by the initial maximum.
+    auto euler = integrate( dt_large, 0, 40 );
+    auto rkl2 = integrate( dt_large, 5, 40 );
+    double euler_max = 0.0;
+    double rkl2_max = 0.0;
+    for ( std::size_t p = 0; p < euler.size(); p++ )
+    {
+        euler_max = std::max( euler_max, std::abs( euler[p] ) );
+        rkl2_max = std::max( rkl2_max, std::abs( rkl2[p] ) );
+    }
+    EXPECT_GT( euler_max, 10.0 );
+    EXPECT_LE( rkl2_max, 1.0 );
+}
+
+// Forces and conduction from a single traversal of the bonds must match the
+// separate kernels. With fracture, the quadratic displacement breaks bonds
+// on both sides of the domain in the same pass, which must then no longer
+// conduct.
+template <class BondCacheType, class CreateModelType>
+std::size_t testFusedConduction( CreateModelType create_model, const double dx,
+                                 const double s0 )
+{
+    using HostAoSoA = Cabana::AoSoA<Cabana::MemberTypes<double[3], double>,
+                                    Kokkos::HostSpace>;
+    std::size_t num_intact = 0;
+    auto compute = [&]( HostAoSoA& aosoa_host, const bool fused )
+    {
+        auto particles = createThermalParticles( dx );
+        auto x = particles->sliceReferencePosition();
+        auto u = particles->sliceDisplacement();
+        auto init_functor = KOKKOS_LAMBDA( const int pid )
+        {
+            for ( int d = 0; d < 3; d++ )
+                u( pid, d ) = 0.0;
+            u( pid, 0 ) = s0 * x( pid, 0 ) * x( pid, 0 );
+        };
+        particles->updateParticles( TEST_EXECSPACE{}, init_functor );
+
+        auto model = create_model( *particles );
+        using model_type = decltype( model );
+        CabanaPD::Force<TEST_MEMSPACE, model_type, CabanaPD::BitBondStorage,
+                        BondCacheType>
+            force( false, *particles, model );
+        CabanaPD::HeatTransfer<TEST_MEMSPACE, model_type,
+                               CabanaPD::BitBondStorage, BondCacheType>
+            heat_transfer( false, force, model );
+        if ( fused )
+        {
+            computeForceAndConduction( force, heat_transfer, *particles,
+                                       Cabana::SerialOpTag{} );
+        }
+        else
+        {
+            computeForce( force, *particles, Cabana::SerialOpTag{} );
+            computeConduction( heat_transfer, *particles,
+                               Cabana::SerialOpTag{} );
+        }
+        using force_type = decltype( force );
+        heat_transfer.executionSpace().fence();
+        if constexpr ( force_type::has_bond_breaking )
+            num_intact = force.getBrokenBonds().numIntact();
+
+        aosoa_host.resize( particles->localOffset() );
+        auto f_host = Cabana::slice<0>( aosoa_host );
+        auto conduction_host = Cabana::slice<1>( aosoa_host );
+        Cabana::deep_copy( f_host, particles->sliceForce() );
+        Cabana::deep_copy( conduction_host,
+                           particles->sliceTemperatureConduction() );
+    };
+    HostAoSoA reference( "reference", 0 );
+    compute( reference, false );
+    const std::size_t num_intact_ref = num_intact;
+    HostAoSoA fused( "fused", 0 );
+    compute( fused, true );
+    EXPECT_EQ( num_intact, num_intact_ref );
+
+    auto f_ref = Cabana::slice<0>( reference );
+    auto conduction_ref = Cabana::slice<1>( reference );
+    auto f = Cabana::slice<0>( fused );
+    auto conduction = Cabana::slice<1>( fused );
+    for ( std::size_t p = 0; p < reference.size(); p++ )
+    {
+        for ( int d = 0; d < 3; d++ )
+            EXPECT_NEAR( f( p, d ), f_ref( p, d ),
+                         1e-10 * ( 1.0 + Kokkos::abs( f_ref( p, d ) ) ) );
+        EXPECT_NEAR( conduction( p ), conduction_ref( p ),
+                     1e-10 * ( 1.0 + Kokkos::abs( conduction_ref( p ) ) ) );
+    }
+    return num_intact;
+}
+
 //---------------------------------------------------------------------------//
 // GTest tests.
 //---------------------------------------------------------------------------//
+TEST( TEST_CATEGORY, test_broken_bonds )
+{
+    testBrokenBonds<CabanaPD::BitBondStorage>( 0 );
+    testBrokenBonds<CabanaPD::ByteBondStorage>( 0 );
+    testBrokenBonds<CabanaPD::BitBondStorage>( 4 );
+    testBrokenBonds<CabanaPD::ByteBondStorage>( 4 );
+}
+TEST( TEST_CATEGORY, test_spatial_index ) { testSpatialIndex(); }
 TEST( TEST_CATEGORY, test_force_pmb )
 {
     // dx needs to be decreased for increased m: boundary particles are ignored.
@@ -753,6 +1784,19 @@ TEST( TEST_CATEGORY, test_force_pmb )
     testForce( model, dx, m, 1.1, LinearTag{}, 0.1 );
     testForce( model, dx, m, 1.1, QuadraticTag{}, 0.01 );
 }
+TEST( TEST_CATEGORY, test_force_pmb_2d )
+{
+    double m = 3;
+    double dx = 2.0 / 11.0;
+    double delta = dx * m;
+    double K = 1.0;
+    CabanaPD::ForceModel<CabanaPD::PMB, CabanaPD::Elastic, CabanaPD::NoFracture>
+        model( delta, K, 2 );
+    testForce2d( model, dx, 1.1, LinearTag{}, 0.1 );
+    testForce2d( model, dx, 1.1, QuadraticTag{}, 0.01 );
+    testForce2d( model, dx, 1.1, QuadraticTag{}, 0.01, true );
+    testForce2d<Cabana::TeamOpTag>( model, dx, 1.1, QuadraticTag{}, 0.01 );
+}
 TEST( TEST_CATEGORY, test_force_linear_pmb )
 {
     double m = 3;
@@ -777,6 +1821,18 @@ TEST( TEST_CATEGORY, test_force_lps )
     testForce( model, dx, m, 2.1, LinearTag{}, 0.1 );
     testForce( model, dx, m, 2.1, QuadraticTag{}, 0.01 );
 }
+TEST( TEST_CATEGORY, test_force_lps_2d )
+{
+    double m = 3;
+    double dx = 2.0 / 15.0;
+    double delta = dx * m;
+    double K = 1.0;
+    double G = 0.5;
+    CabanaPD::ForceModel<CabanaPD::LPS, CabanaPD::Elastic, CabanaPD::NoFracture>
+        model( delta, K, G, 1, 2 );
+    testForce2d( model, dx, 2.1, LinearTag{}, 0.1 );
+    testForce2d( model, dx, 2.1, LinearTag{}, 0.1, true );
+}
 TEST( TEST_CATEGORY, test_force_linear_lps )
 {
     double m = 3;
@@ -789,6 +1845,25 @@ TEST( TEST_CATEGORY, test_force_linear_lps )
         model( delta, K, G, 1 );
     testForce( model, dx, m, 2.1, LinearTag{}, 0.1 );
 }
+TEST( TEST_CATEGORY, test_force_stiffness )
+{
+    double m = 3;
+    double dx = 2.0 / 11.0;
+    double delta = dx * m;
+    double K = 1.0;
+    CabanaPD::ForceModel<CabanaPD::LinearPMB, CabanaPD::Elastic,
+                         CabanaPD::NoFracture>
+        pmb_model( delta, K );
+    testStiffness( pmb_model, dx, QuadraticTag{} );
+
+    // The assembled dilatation is linearized, which is exact for a uniform
+    // stretch.
+    double G = 0.5;
+    CabanaPD::ForceModel<CabanaPD::LinearLPS, CabanaPD::Elastic,
+                         CabanaPD::NoFracture>
+        lps_model( delta, K, G, 1 );
+    testStiffness( lps_model, dx, LinearTag{} );
+}
 
 // Tests without damage, but using damage models.
 TEST( TEST_CATEGORY, test_force_pmb_damage )
@@ -803,6 +1878,28 @@ TEST( TEST_CATEGORY, test_force_pmb_damage )
     testForce( model, dx, m, 1.1, LinearTag{}, 0.1 );
     testForce( model, dx, m, 1.1, QuadraticTag{}, 0.01 );
 }
+TEST( TEST_CATEGORY, test_force_pmb_half )
+{
+    double m = 3;
+    double dx = 2.0 / 11.0;
+    double delta = dx * m;
+    double K = 1.0;
+    CabanaPD::ForceModel<CabanaPD::PMB, CabanaPD::Elastic, CabanaPD::NoFracture>
+        model( delta, K );
+    testForce( model, dx, m, 1.1, LinearTag{}, 0.1, true );
+    testForce( model, dx, m, 1.1, QuadraticTag{}, 0.01, true );
+}
+TEST( TEST_CATEGORY, test_force_pmb_damage_half )
+{
+    double m = 3;
+    double dx = 2.0 / 11.0;
+    double delta = dx * m;
+    double K = 1.0;
+    double G0 = 1000.0;
+    CabanaPD::ForceModel<CabanaPD::PMB> model( delta, K, G0 );
+    testForce( model, dx, m, 1.1, LinearTag{}, 0.1, true );
+    testForce( model, dx, m, 1.1, QuadraticTag{}, 0.01, true );
+}
 TEST( TEST_CATEGORY, test_force_lps_damage )
 {
     double m = 3;
@@ -815,4 +1912,302 @@ TEST( TEST_CATEGORY, test_force_lps_damage )
     testForce( model, dx, m, 2.1, LinearTag{}, 0.1 );
     testForce( model, dx, m, 2.1, QuadraticTag{}, 0.01 );
 }
+
+// Tests with force, energy, and damage computed in a single pass.
+TEST( TEST_CATEGORY, test_force_pmb_fused )
+{
+    double m = 3;
+    double dx = 2.0 / 11.0;
+    double delta = dx * m;
+    double K = 1.0;
+    CabanaPD::ForceModel<CabanaPD::PMB, CabanaPD::Elastic, CabanaPD::NoFracture>
+        pmb( delta, K );
+    testForce( pmb, dx, m, 1.1, LinearTag{}, 0.1, false, true );
+    testForce( pmb, dx, m, 1.1, QuadraticTag{}, 0.01, false, true );
+
+    double G0 = 1000.0;
+    CabanaPD::ForceModel<CabanaPD::PMB> pmb_damage( delta, K, G0 );
+    testForce( pmb_damage, dx, m, 1.1, LinearTag{}, 0.1, false, true );
+    testForce( pmb_damage, dx, m, 1.1, QuadraticTag{}, 0.01, false, true );
+}
+TEST( TEST_CATEGORY, test_force_lps_fused )
+{
+    double m = 3;
+    double dx = 2.0 / 15.0;
+    double delta = dx * m;
+    double K = 1.0;
+    double G = 0.5;
+    CabanaPD::ForceModel<CabanaPD::LPS, CabanaPD::Elastic, CabanaPD::NoFracture>
+        lps( delta, K, G, 1 );
+    testForce( lps, dx, m, 2.1, LinearTag{}, 0.1, false, true );
+    testForce( lps, dx, m, 2.1, QuadraticTag{}, 0.01, false, true );
+
+    double G0 = 1000.0;
+    CabanaPD::ForceModel<CabanaPD::LPS> lps_damage( delta, K, G, G0, 1 );
+    testForce( lps_damage, dx, m, 2.1, LinearTag{}, 0.1, false, true );
+    testForce( lps_damage, dx, m, 2.1, QuadraticTag{}, 0.01, false, true );
+}
+
+// Tests with team threading over neighbors.
+TEST( TEST_CATEGORY, test_force_pmb_team )
+{
+    double m = 3;
+    double dx = 2.0 / 11.0;
+    double delta = dx * m;
+    double K = 1.0;
+    CabanaPD::ForceModel<CabanaPD::PMB, CabanaPD::Elastic, CabanaPD::NoFracture>
+        pmb( delta, K );
+    testForce<CabanaPD::NoBondCache, Cabana::TeamOpTag>( pmb, dx, m, 1.1,
+                                                         LinearTag{}, 0.1 );
+
+    double G0 = 1000.0;
+    CabanaPD::ForceModel<CabanaPD::PMB> pmb_damage( delta, K, G0 );
+    testForce<CabanaPD::NoBondCache, Cabana::TeamOpTag>(
+        pmb_damage, dx, m, 1.1, LinearTag{}, 0.1 );
+    testForce<CabanaPD::NoBondCache, Cabana::TeamOpTag>(
+        pmb_damage, dx, m, 1.1, QuadraticTag{}, 0.01, false, true );
+}
+TEST( TEST_CATEGORY, test_force_lps_team )
+{
+    double m = 3;
+    double dx = 2.0 / 15.0;
+    double delta = dx * m;
+    double K = 1.0;
+    double G = 0.5;
+    CabanaPD::ForceModel<CabanaPD::LPS, CabanaPD::Elastic, CabanaPD::NoFracture>
+        lps( delta, K, G, 1 );
+    testForce<CabanaPD::NoBondCache, Cabana::TeamOpTag>( lps, dx, m, 2.1,
+                                                         LinearTag{}, 0.1 );
+
+    double G0 = 1000.0;
+    CabanaPD::ForceModel<CabanaPD::LPS> lps_damage( delta, K, G, G0, 1 );
+    testForce<CabanaPD::NoBondCache, Cabana::TeamOpTag>(
+        lps_damage, dx, m, 2.1, LinearTag{}, 0.1 );
+    testForce<CabanaPD::NoBondCache, Cabana::TeamOpTag>(
+        lps_damage, dx, m, 2.1, QuadraticTag{}, 0.01, false, true );
+}
+
+// Tests with cached bond reference geometry.
+TEST( TEST_CATEGORY, test_force_pmb_damage_cache )
+{
+    double m = 3;
+    double dx = 2.0 / 11.0;
+    double delta = dx * m;
+    double K = 1.0;
+    double G0 = 1000.0;
+    CabanaPD::ForceModel<CabanaPD::PMB> model( delta, K, G0 );
+    testForce<CabanaPD::BondLengthCache>( model, dx, m, 1.1, LinearTag{},
+                                          0.1 );
+    testForce<CabanaPD::BondGeometryCache>( model, dx, m, 1.1,
+                                            QuadraticTag{}, 0.01 );
+}
+TEST( TEST_CATEGORY, test_force_lps_damage_cache )
+{
+    double m = 3;
+    double dx = 2.0 / 15.0;
+    double delta = dx * m;
+    double K = 1.0;
+    double G = 0.5;
+    double G0 = 1000.0;
+    CabanaPD::ForceModel<CabanaPD::LPS> model( delta, K, G, G0, 1 );
+    testForce<CabanaPD::BondLengthCache>( model, dx, m, 2.1, LinearTag{},
+                                          0.1 );
+    testForce<CabanaPD::BondGeometryCache>( model, dx, m, 2.1,
+                                            QuadraticTag{}, 0.01 );
+    testForce<CabanaPD::BondInfluenceCache>( model, dx, m, 2.1,
+                                             QuadraticTag{}, 0.01 );
+    // The influence cache with per-bond (CSR) and byte broken bond storage.
+    testForce<CabanaPD::BondInfluenceCache, Cabana::SerialOpTag,
+              CabanaPD::CSRBondStorage>( model, dx, m, 2.1, QuadraticTag{},
+                                         0.01 );
+    testForce<CabanaPD::BondInfluenceCache, Cabana::SerialOpTag,
+              CabanaPD::ByteBondStorage>( model, dx, m, 2.1, QuadraticTag{},
+                                          0.01 );
+}
+
+// Tests with the influence function fixed at compile time.
+TEST( TEST_CATEGORY, test_force_lps_influence )
+{
+    double m = 3;
+    double dx = 2.0 / 15.0;
+    double delta = dx * m;
+    double K = 1.0;
+    double G = 0.5;
+    double G0 = 1000.0;
+
+    // The general critical stretch must match the closed form expressions.
+    CabanaPD::ForceModel<CabanaPD::LPS, CabanaPD::Elastic, CabanaPD::Fracture,
+                         CabanaPD::TemperatureIndependent,
+                         CabanaPD::ConstantInfluence>
+        lps_constant( delta, K, G, G0 );
+    CabanaPD::ForceModel<CabanaPD::LPS> lps_runtime_constant( delta, K, G, G0,
+                                                              0 );
+    EXPECT_NEAR( lps_constant.s0, lps_runtime_constant.s0,
+                 1e-8 * lps_runtime_constant.s0 );
+
+    CabanaPD::ForceModel<CabanaPD::LPS, CabanaPD::Elastic, CabanaPD::Fracture,
+                         CabanaPD::TemperatureIndependent,
+                         CabanaPD::InverseInfluence>
+        lps_inverse( delta, K, G, G0 );
+    CabanaPD::ForceModel<CabanaPD::LPS> lps_runtime_inverse( delta, K, G, G0,
+                                                             1 );
+    EXPECT_NEAR( lps_inverse.s0, lps_runtime_inverse.s0,
+                 1e-8 * lps_runtime_inverse.s0 );
+
+    CabanaPD::ForceModel<CabanaPD::LPS, CabanaPD::Elastic, CabanaPD::NoFracture,
+                         CabanaPD::TemperatureIndependent,
+                         CabanaPD::InverseInfluence>
+        lps( delta, K, G );
+    testForce( lps, dx, m, 2.1, LinearTag{}, 0.1 );
+    testForce( lps_inverse, dx, m, 2.1, QuadraticTag{}, 0.01 );
+    testForce<CabanaPD::BondInfluenceCache>( lps_inverse, dx, m, 2.1,
+                                             QuadraticTag{}, 0.01 );
+
+    CabanaPD::ForceModel<CabanaPD::LPS, CabanaPD::Elastic, CabanaPD::Fracture,
+                         CabanaPD::TemperatureIndependent,
+                         CabanaPD::GaussianInfluence>
+        lps_gaussian( delta, K, G, G0 );
+    testForce<CabanaPD::BondInfluenceCache>( lps_gaussian, dx, m, 2.1,
+                                             QuadraticTag{}, 0.01 );
+}
+TEST( TEST_CATEGORY, test_prenotch_list )
+{
+    double m = 3;
+    double dx = 2.0 / 11.0;
+    double delta = dx * m;
+    double K = 1.0;
+    double G0 = 1000.0;
+    CabanaPD::ForceModel<CabanaPD::PMB> pmb( delta, K, G0 );
+    testPrenotchList( pmb, dx );
+}
+TEST( TEST_CATEGORY, test_compact_bonds )
+{
+    double m = 3;
+    double dx = 2.0 / 11.0;
+    double delta = dx * m;
+    double K = 1.0;
+    double G = 0.5;
+    double G0 = 1000.0;
+    CabanaPD::ForceModel<CabanaPD::PMB> pmb( delta, K, G0 );
+    testCompactBonds<CabanaPD::NoBondCache>( pmb, dx );
+    testCompactBonds<CabanaPD::BondGeometryCache>( pmb, dx );
+    testCompactBonds<CabanaPD::NoBondCache, CabanaPD::CSRBondStorage>( pmb,
+                                                                     dx );
+    testCompactBonds<CabanaPD::BondGeometryCache, CabanaPD::CSRBondStorage>(
+        pmb, dx );
+
+    CabanaPD::ForceModel<CabanaPD::LPS> lps( delta, K, G, G0, 1 );
+    testCompactBonds<CabanaPD::BondInfluenceCache>( lps, dx );
+    testCompactBonds<CabanaPD::BondInfluenceCache, CabanaPD::CSRBondStorage>(
+        lps, dx );
+}
+TEST( TEST_CATEGORY, test_active_bond_breaking )
+{
+    double m = 3;
+    double dx = 2.0 / 11.0;
+    double delta = dx * m;
+    double K = 1.0;
+    // Critical stretch of 0.05, exceeded near x = 1 by the displacement
+    // 0.05 x^2 (bond stretch up to about 0.1).
+    double s0 = 0.05;
+    double G0 = 9.0 * K * delta * s0 * s0 / 5.0;
+    CabanaPD::ForceModel<CabanaPD::PMB> pmb( delta, K, G0 );
+    testActiveBreaking<Cabana::SerialOpTag>( pmb, dx, 0.05 );
+    testActiveBreaking<Cabana::TeamOpTag>( pmb, dx, 0.05 );
+}
+TEST( TEST_CATEGORY, test_force_energy_no_breaking )
+{
+    double m = 3;
+    double dx = 2.0 / 11.0;
+    double delta = dx * m;
+    double K = 1.0;
+    // Critical stretch of 0.05, exceeded near x = 1 as above.
+    double s0 = 0.05;
+    double G0 = 9.0 * K * delta * s0 * s0 / 5.0;
+    CabanaPD::ForceModel<CabanaPD::PMB> pmb( delta, K, G0 );
+    testNoBreakingEnergy<Cabana::SerialOpTag>( pmb, dx, 0.05 );
+    testNoBreakingEnergy<Cabana::TeamOpTag>( pmb, dx, 0.05 );
+
+    double G = 0.5;
+    CabanaPD::ForceModel<CabanaPD::LPS> lps( delta, K, G, G0, 1 );
+    testNoBreakingEnergy<Cabana::SerialOpTag>( lps, dx, 0.05 );
+}
+TEST( TEST_CATEGORY, test_heat_transfer_rkl2 ) { testHeatTransferRKL2(); }
+TEST( TEST_CATEGORY, test_force_conduction_fused )
+{
+    double m = 3;
+    double dx = 2.0 / 10.0;
+    double delta = dx * m;
+    double K = 1.0;
+    double kappa = 1.0;
+    double cp = 1.0;
+    double s0 = 0.05;
+    double G0 = 9.0 * K * delta * s0 * s0 / 5.0;
+
+    auto elastic = [&]( auto& particles )
+    {
+        return CabanaPD::createForceModel( CabanaPD::PMB{},
+                                           CabanaPD::NoFracture{}, particles,
+                                           delta, K, kappa, cp, 0.0, 0.0 );
+    };
+    testFusedConduction<CabanaPD::NoBondCache>( elastic, dx, s0 );
+
+    auto fracture = [&]( auto& particles )
+    {
+        return CabanaPD::createForceModel( CabanaPD::PMB{},
+                                           CabanaPD::Fracture{}, particles,
+                                           delta, K, G0, kappa, cp, 0.0, 0.0 );
+    };
+    // Without displacement no bonds break.
+    const auto num_bonds =
+        testFusedConduction<CabanaPD::NoBondCache>( fracture, dx, 0.0 );
+    const auto num_intact =
+        testFusedConduction<CabanaPD::NoBondCache>( fracture, dx, s0 );
+    EXPECT_GT( num_intact, 0u );
+    EXPECT_LT( num_intact, num_bonds );
+    EXPECT_EQ( testFusedConduction<CabanaPD::BondGeometryCache>( fracture, dx,
+                                                                 s0 ),
+               num_intact );
+}
+TEST( TEST_CATEGORY, test_force_pmb_mixed_precision )
+{
+    double m = 3;
+    double dx = 2.0 / 11.0;
+    double delta = dx * m;
+    double K = 1.0;
+    CabanaPD::ForceModel<CabanaPD::PMB, CabanaPD::Elastic, CabanaPD::NoFracture>
+        model( delta, K );
+    testMixedPrecision( model, dx, 0.01 );
+
+    // Large value to make sure no bonds break.
+    double G0 = 1000.0;
+    CabanaPD::ForceModel<CabanaPD::PMB> fracture_model( delta, K, G0 );
+    testMixedPrecision( fracture_model, dx, 0.01 );
+}
+TEST( TEST_CATEGORY, test_force_lps_mixed_precision )
+{
+    double m = 3;
+    double dx = 2.0 / 11.0;
+    double delta = dx * m;
+    double K = 1.0;
+    double G = 0.5;
+    CabanaPD::ForceModel<CabanaPD::LPS, CabanaPD::Elastic, CabanaPD::NoFracture>
+        model( delta, K, G, 1 );
+    testMixedPrecision( model, dx, 0.01 );
+}
+TEST( TEST_CATEGORY, test_force_pmb_ensemble )
+{
+    double m = 3;
+    double dx = 2.0 / 11.0;
+    double delta = dx * m;
+    double K = 1.0;
+    double G0 = 1000.0;
+    std::vector<double> scale = { 1.0, 2.0, 0.5 };
+
+    CabanaPD::ForceModel<CabanaPD::PMB, CabanaPD::Elastic, CabanaPD::NoFracture>
+        elastic( delta, K );
+    testEnsemble( elastic, dx, scale );
+    CabanaPD::ForceModel<CabanaPD::PMB> fracture( delta, K, G0 );
+    testEnsemble( fracture, dx, scale );
+}
 } // end namespace Test
@@ -9,6 +9,12 @@
  * SPDX-License-Identifier: BSD-3-Clause                                    *
  ****************************************************************************/
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+
 #include <CabanaPD.hpp>
 
 #include <Kokkos_Core.hpp>
@@ -132,10 +138,245 @@ void testHertzianContact( const std::string filename )
     EXPECT_NEAR( std::sqrt( ke_f / ke_i ), e, 1e-3 );
 }
 
+// Final velocities of two (initially overlapping) particles with Hertzian
+// contact and a PD model without bonds, integrated by the solver.
+std::vector<double> runSubcycledContact( const std::string filename )
+{
+    using exec_space = TEST_EXECSPACE;
+    using memory_space = TEST_MEMSPACE;
+
+    CabanaPD::Inputs inputs( filename );
+    double rho0 = inputs["density"];
+    double vol = inputs["volume"];
+    double delta = inputs["horizon"];
+    delta += 1e-10;
+    double radius = inputs["radius"];
+    double nu = inputs["poisson_ratio"];
+    double E = inputs["elastic_modulus"];
+    double e = inputs["restitution"];
+    std::array<double, 3> low_corner = inputs["low_corner"];
+    std::array<double, 3> high_corner = inputs["high_corner"];
+    std::array<int, 3> num_cells = inputs["num_cells"];
+
+    // Contact force at the start, such that the first substep kick matters.
+    const int num_particles = 2;
+    Kokkos::View<double* [3], memory_space> position( "custom_position", 2 );
+    Kokkos::View<double*, memory_space> volume( "custom_volume", 2 );
+    Kokkos::parallel_for(
+        "create_particles", Kokkos::RangePolicy<exec_space>( 0, num_particles ),
+        KOKKOS_LAMBDA( const int p ) {
+            position( p, 0 ) = p == 0 ? 0.499e-4 : -0.499e-4;
+            volume( p ) = vol;
+        } );
+
+    // The PD horizon is below the particle spacing: only contact acts.
+    double K = E / ( 3.0 * ( 1.0 - 2.0 * nu ) );
+    CabanaPD::ForceModel<CabanaPD::PMB, CabanaPD::Elastic, CabanaPD::NoFracture>
+        force_model( 0.5 * radius, K );
+    CabanaPD::HertzianModel contact_model( delta, radius, nu, E, e );
+
+    int halo_width = 1;
+    auto particles =
+        CabanaPD::createParticles<memory_space, decltype( force_model )>(
+            exec_space{}, position, volume, low_corner, high_corner, num_cells,
+            halo_width );
+    auto rho = particles->sliceDensity();
+    auto v = particles->sliceVelocity();
+    particles->updateParticles(
+        exec_space{}, KOKKOS_LAMBDA( const int p ) {
+            rho( p ) = rho0;
+            v( p, 0 ) = p == 0 ? -1.0 : 1.0;
+        } );
+
+    auto cabana_pd = CabanaPD::createSolver<memory_space>(
+        inputs, particles, force_model, contact_model );
+    cabana_pd->init();
+    cabana_pd->run();
+
+    Kokkos::View<double*, memory_space> v_final( "final_velocity", 2 );
+    Kokkos::parallel_for(
+        "copy_velocity", Kokkos::RangePolicy<exec_space>( 0, num_particles ),
+        KOKKOS_LAMBDA( const int p ) { v_final( p ) = v( p, 0 ); } );
+    auto v_host =
+        Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace{}, v_final );
+    return { v_host( 0 ), v_host( 1 ) };
+}
+
+// Subcycled contact (within each drift) must follow the trajectory of contact
+// evaluated with the PD forces at every stage.
+void testSubcycledContact()
+{
+    auto reference = runSubcycledContact( "hertzian_contact.json" );
+    auto subcycled = runSubcycledContact( "hertzian_contact_subcycle.json" );
+    for ( int p = 0; p < 2; p++ )
+    {
+        // The particles separated.
+        EXPECT_GT( reference[p] * ( p == 0 ? 1.0 : -1.0 ), 0.0 );
+        EXPECT_NEAR( subcycled[p], reference[p],
+                     1e-3 * std::abs( reference[p] ) );
+    }
+}
+
+// Contact neighbors with a skin are only rebuilt once a particle moved more
+// than half the skin since the last build, and the forces must match
+// rebuilding the neighbors every step.
+void testContactSkin()
+{
+    using exec_space = TEST_EXECSPACE;
+    using memory_space = TEST_MEMSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+    CabanaPD::Particles<memory_space, CabanaPD::PMB,
+                        CabanaPD::TemperatureIndependent>
+        particles( exec_space{}, box_min, box_max, num_cells, 0 );
+    const double dx = 0.2;
+
+    // Nearest neighbors are in contact.
+    CabanaPD::NormalRepulsionModel model( 3.0 * dx, 1.05 * dx, 1.0 );
+    const double skin = 0.2 * dx;
+    using contact_type =
+        CabanaPD::Force<memory_space, CabanaPD::NormalRepulsionModel>;
+    contact_type contact( false, particles, model, skin );
+    contact_type contact_ref( false, particles, model );
+
+    using HostAoSoA =
+        Cabana::AoSoA<Cabana::MemberTypes<double[3]>, Kokkos::HostSpace>;
+    HostAoSoA f_aosoa( "f", particles.localOffset() );
+    HostAoSoA f_ref_aosoa( "f_ref", particles.localOffset() );
+    auto f_host = Cabana::slice<0>( f_aosoa );
+    auto f_ref_host = Cabana::slice<0>( f_ref_aosoa );
+
+    // Neighboring particles move in opposite directions by 0.15 skin per
+    // step: a rebuild is needed every 4 steps.
+    auto u = particles.sliceDisplacement();
+    const int num_steps = 12;
+    double max_f = 0.0;
+    for ( int step = 0; step < num_steps; step++ )
+    {
+        const double du = 0.15 * skin * step;
+        particles.updateParticles(
+            exec_space{}, KOKKOS_LAMBDA( const int p ) {
+                u( p, 0 ) = du * ( p % 3 - 1 );
+                u( p, 1 ) = 0.0;
+                u( p, 2 ) = 0.0;
+            } );
+
+        computeForce( contact, particles, Cabana::SerialOpTag{} );
+        Cabana::deep_copy( f_host, particles.sliceForce() );
+        contact_ref.resetNeighbors();
+        computeForce( contact_ref, particles, Cabana::SerialOpTag{} );
+        Cabana::deep_copy( f_ref_host, particles.sliceForce() );
+
+        for ( std::size_t p = 0; p < f_aosoa.size(); p++ )
+            for ( int d = 0; d < 3; d++ )
+            {
+                EXPECT_NEAR( f_host( p, d ), f_ref_host( p, d ),
+                             1e-12 * ( 1.0 + std::abs( f_ref_host( p, d ) ) ) );
+                max_f = std::max( max_f, std::abs( f_ref_host( p, d ) ) );
+            }
+        EXPECT_EQ( contact.numNeighborBuilds(), step / 4 + 1 );
+    }
+    EXPECT_GT( max_f, 0.0 );
+    EXPECT_EQ( contact_ref.numNeighborBuilds(), num_steps );
+}
+
+// Pairs with an intact PD bond are excluded from contact, and come back into
+// contact once the bond breaks.
+void testContactExcludeBonds()
+{
+    using exec_space = TEST_EXECSPACE;
+    using memory_space = TEST_MEMSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+    CabanaPD::Particles<memory_space, CabanaPD::PMB,
+                        CabanaPD::TemperatureIndependent>
+        particles( exec_space{}, box_min, box_max, num_cells, 0 );
+    const double dx = 0.2;
+
+    // Nearest neighbors are bonded and in contact.
+    using model_type = CabanaPD::ForceModel<CabanaPD::PMB>;
+    model_type pd_model( 1.1 * dx, 1.0, 1.0 );
+    CabanaPD::Force<memory_space, model_type> force( false, particles,
+                                                     pd_model );
+    CabanaPD::NormalRepulsionModel contact_model( 3.0 * dx, 1.05 * dx, 1.0 );
+    using contact_type =
+        CabanaPD::Force<memory_space, CabanaPD::NormalRepulsionModel>;
+    contact_type contact( false, particles, contact_model );
+    contact.excludeBonds( force.getNeighbors(), force.getBrokenBonds() );
+    contact_type contact_all( false, particles, contact_model );
+
+    using HostAoSoA =
+        Cabana::AoSoA<Cabana::MemberTypes<double[3]>, Kokkos::HostSpace>;
+    HostAoSoA f_aosoa( "f", particles.localOffset() );
+    HostAoSoA f_all_aosoa( "f_all", particles.localOffset() );
+    auto f_host = Cabana::slice<0>( f_aosoa );
+    auto f_all_host = Cabana::slice<0>( f_all_aosoa );
+    auto compute = [&]()
+    {
+        computeForce( contact, particles, Cabana::SerialOpTag{} );
+        Cabana::deep_copy( f_host, particles.sliceForce() );
+        computeForce( contact_all, particles, Cabana::SerialOpTag{} );
+        Cabana::deep_copy( f_all_host, particles.sliceForce() );
+    };
+
+    // All contact pairs are bonded.
+    compute();
+    EXPECT_EQ( contact.numNeighborBuilds(), 1 );
+    double max_f = 0.0;
+    for ( std::size_t p = 0; p < f_aosoa.size(); p++ )
+        for ( int d = 0; d < 3; d++ )
+        {
+            EXPECT_DOUBLE_EQ( f_host( p, d ), 0.0 );
+            max_f = std::max( max_f, std::abs( f_all_host( p, d ) ) );
+        }
+    EXPECT_GT( max_f, 0.0 );
+
+    // Break all bonds of some particles: these are then in contact with all
+    // neighbors, while the others remain fully bonded.
+    auto mu = force.getBrokenBonds();
+    auto neigh = force.getNeighbors();
+    using neighbor_type = Cabana::NeighborList<decltype( neigh )>;
+    Kokkos::RangePolicy<exec_space> policy( 0, particles.localOffset() );
+    Kokkos::parallel_for(
+        "break_bonds", policy, KOKKOS_LAMBDA( const int i ) {
+            if ( i % 7 != 0 )
+                return;
+            const int num_neighbors = neighbor_type::numNeighbor( neigh, i );
+            for ( int n = 0; n < num_neighbors; n++ )
+                mu.breakBond( i, n );
+        } );
+    compute();
+    EXPECT_EQ( contact.numNeighborBuilds(), 2 );
+    for ( std::size_t p = 0; p < f_aosoa.size(); p++ )
+        for ( int d = 0; d < 3; d++ )
+        {
+            const double expected = p % 7 == 0 ? f_all_host( p, d ) : 0.0;
+            EXPECT_NEAR( f_host( p, d ), expected,
+                         1e-12 * ( 1.0 + std::abs( expected ) ) );
+        }
+
+    // No rebuild without new broken bonds or motion.
+    compute();
+    EXPECT_EQ( contact.numNeighborBuilds(), 2 );
+}
+
 TEST( TEST_CATEGORY, test_hertzian_contact )
 {
     std::string input = "hertzian_contact.json";
     testHertzianContact( input );
 }
 
+TEST( TEST_CATEGORY, test_subcycled_contact ) { testSubcycledContact(); }
+
+TEST( TEST_CATEGORY, test_contact_skin ) { testContactSkin(); }
+
+TEST( TEST_CATEGORY, test_contact_exclude_bonds )
+{
+    testContactExcludeBonds();
+}
+
 } // end namespace Test
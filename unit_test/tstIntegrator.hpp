@@ -21,6 +21,7 @@
  ****************************************************************************/
 
 #include <algorithm>
+#include <cmath>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -30,6 +31,7 @@
 
 #include <CabanaPD_Integrate.hpp>
 #include <CabanaPD_Particles.hpp>
+#include <CabanaPD_TimeStep.hpp>
 #include <CabanaPD_config.hpp>
 
 namespace Test
@@ -93,6 +95,221 @@ void testIntegratorReversibility( int steps )
             EXPECT_DOUBLE_EQ( x_final( p, d ), x_init( p, d ) );
 }
 
+//---------------------------------------------------------------------------//
+void testYoshidaCoefficients()
+{
+    using exec_space = TEST_EXECSPACE;
+    using integrator_type = CabanaPD::Yoshida<exec_space>;
+    integrator_type integrator( 0.001 );
+
+    // Both drift and kick coefficients must sum to one full step.
+    double c_sum = 0.0;
+    double d_sum = 0.0;
+    for ( int s = 0; s < integrator_type::num_stages; ++s )
+    {
+        c_sum += integrator.driftCoefficient( s );
+        d_sum += integrator.kickCoefficient( s );
+    }
+    EXPECT_NEAR( c_sum, 1.0, 1e-14 );
+    EXPECT_NEAR( d_sum, 1.0, 1e-14 );
+
+    // The final stage has no kick, so it needs no force evaluation.
+    EXPECT_FALSE(
+        integrator.stageNeedsForce( integrator_type::num_stages - 1 ) );
+    EXPECT_EQ( integrator.lastForceStage(), integrator_type::num_stages - 2 );
+}
+
+//---------------------------------------------------------------------------//
+void testStableTimeStep()
+{
+    using exec_space = TEST_EXECSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+
+    CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
+                        CabanaPD::TemperatureIndependent>
+        particles( exec_space(), box_min, box_max, num_cells, 0 );
+    const std::size_t num_local = particles.localOffset();
+
+    // Uniform stiffness with one stiffer particle.
+    const double rho_0 = 2.0;
+    const double k_0 = 4.0;
+    Kokkos::View<double*, TEST_MEMSPACE> k( "stiffness", num_local );
+    Kokkos::deep_copy( k, k_0 );
+    auto rho = particles.sliceDensity();
+    auto v = particles.sliceVelocity();
+    particles.updateParticles(
+        exec_space{}, KOKKOS_LAMBDA( const int pid ) {
+            rho( pid ) = rho_0;
+            for ( int d = 0; d < 3; d++ )
+                v( pid, d ) = 0.0;
+            if ( pid == 0 )
+                k( pid ) = 4.0 * k_0;
+        } );
+
+    // Stiffness only.
+    const double dt_k = std::sqrt( 2.0 * rho_0 / ( 4.0 * k_0 ) );
+    double dt = CabanaPD::estimateStableTimeStep( particles, k, 0.1 );
+    EXPECT_DOUBLE_EQ( dt, dt_k );
+
+    // Limited by the distance moved in one step.
+    const double speed = 1.0;
+    particles.updateParticles(
+        exec_space{},
+        KOKKOS_LAMBDA( const int pid ) { v( pid, 1 ) = -speed; } );
+    dt = CabanaPD::estimateStableTimeStep( particles, k, 0.1 );
+    EXPECT_DOUBLE_EQ( dt, std::min( dt_k, 0.1 / speed ) );
+}
+
+//---------------------------------------------------------------------------//
+// A stiff (contact-like) linear spring subcycled within outer steps beyond its
+// stable timestep must follow the harmonic solution.
+void testContactSubcycle()
+{
+    using exec_space = TEST_EXECSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 4, 4, 4 };
+
+    CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
+                        CabanaPD::TemperatureIndependent>
+        particles( exec_space(), box_min, box_max, num_cells, 0 );
+
+    // Unit frequency with unit initial velocity: u = sin( t ).
+    const double rho_0 = 2.0;
+    const double k_spring = rho_0;
+    auto rho = particles.sliceDensity();
+    auto u = particles.sliceDisplacement();
+    auto v = particles.sliceVelocity();
+    particles.updateParticles(
+        exec_space{}, KOKKOS_LAMBDA( const int pid ) {
+            rho( pid ) = rho_0;
+            for ( int d = 0; d < 3; d++ )
+            {
+                u( pid, d ) = 0.0;
+                v( pid, d ) = 0.0;
+            }
+            v( pid, 0 ) = 1.0;
+        } );
+
+    // The outer step is beyond the Verlet limit (2 / frequency).
+    const int num_substeps = 50;
+    const double tau = 2.5;
+    const int num_steps = 10;
+    CabanaPD::ContactSubcycle<exec_space> subcycle( num_substeps );
+    EXPECT_DOUBLE_EQ( subcycle.stiffnessScale(),
+                      1.0 / ( num_substeps * num_substeps ) );
+
+    const double h = tau / num_substeps;
+    for ( int s = 0; s < num_steps; s++ )
+        for ( int k = 0; k < num_substeps; k++ )
+        {
+            subcycle.kick( particles, 0.5 * h );
+            subcycle.drift( particles, h );
+            auto fc = subcycle.resetContactForce( particles );
+            Kokkos::RangePolicy<exec_space> policy( particles.frozenOffset(),
+                                                    particles.localOffset() );
+            Kokkos::parallel_for(
+                policy, KOKKOS_LAMBDA( const int pid ) {
+                    for ( int d = 0; d < 3; d++ )
+                        fc( pid, d ) = -k_spring * u( pid, d );
+                } );
+            subcycle.kick( particles, 0.5 * h );
+        }
+
+    using HostAoSoA = Cabana::AoSoA<Cabana::MemberTypes<double[3], double[3]>,
+                                    Kokkos::HostSpace>;
+    HostAoSoA aosoa_host( "host", particles.localOffset() );
+    auto u_host = Cabana::slice<0>( aosoa_host );
+    auto v_host = Cabana::slice<1>( aosoa_host );
+    Cabana::deep_copy( u_host, u );
+    Cabana::deep_copy( v_host, v );
+    const double time = tau * num_steps;
+    for ( std::size_t p = 0; p < aosoa_host.size(); p++ )
+    {
+        EXPECT_NEAR( u_host( p, 0 ), std::sin( time ), 1e-2 );
+        EXPECT_NEAR( v_host( p, 0 ), std::cos( time ), 1e-2 );
+        for ( int d = 1; d < 3; d++ )
+            EXPECT_DOUBLE_EQ( u_host( p, d ), 0.0 );
+    }
+}
+
+//---------------------------------------------------------------------------//
+// Independent linear springs (with varying stiffness) must relax to their
+// equilibrium displacement, except for one prescribed particle.
+void testDynamicRelaxation()
+{
+    using exec_space = TEST_EXECSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+
+    CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
+                        CabanaPD::TemperatureIndependent>
+        particles( exec_space(), box_min, box_max, num_cells, 0 );
+    const std::size_t num_local = particles.localOffset();
+
+    Kokkos::View<double*, TEST_MEMSPACE> k( "stiffness", num_local );
+    auto x = particles.sliceReferencePosition();
+    auto u = particles.sliceDisplacement();
+    auto f = particles.sliceForce();
+    particles.updateParticles(
+        exec_space{}, KOKKOS_LAMBDA( const int pid ) {
+            k( pid ) = 1.0 + 0.5 * ( pid % 4 );
+            for ( int d = 0; d < 3; d++ )
+                u( pid, d ) = 0.0;
+        } );
+
+    CabanaPD::DynamicRelaxation<exec_space> relaxation;
+    relaxation.setDensity( particles, k );
+
+    // Equilibrium u = 0.01 x, while particle 0 is held at zero.
+    auto update = [&]()
+    {
+        Kokkos::RangePolicy<exec_space> policy( 0, num_local );
+        Kokkos::parallel_for(
+            "spring_force", policy, KOKKOS_LAMBDA( const int pid ) {
+                if ( pid == 0 )
+                    for ( int d = 0; d < 3; d++ )
+                        u( pid, d ) = 0.0;
+                for ( int d = 0; d < 3; d++ )
+                    f( pid, d ) =
+                        -k( pid ) * ( u( pid, d ) - 0.01 * x( pid, d ) );
+            } );
+    };
+
+    update();
+    const double residual_0 = relaxation.residual( particles );
+    EXPECT_GT( residual_0, 0.0 );
+    double residual = residual_0;
+    int iterations = 0;
+    while ( residual > 1e-10 * residual_0 && iterations < 2000 )
+    {
+        relaxation.step( particles );
+        update();
+        residual = relaxation.residual( particles );
+        iterations++;
+    }
+    EXPECT_LT( iterations, 2000 );
+    EXPECT_EQ( relaxation.numConstrained(), 1 );
+
+    using HostAoSoA =
+        Cabana::AoSoA<Cabana::MemberTypes<double[3], double[3]>,
+                      Kokkos::HostSpace>;
+    HostAoSoA aosoa_host( "host", num_local );
+    auto x_host = Cabana::slice<0>( aosoa_host );
+    auto u_host = Cabana::slice<1>( aosoa_host );
+    Cabana::deep_copy( x_host, x );
+    Cabana::deep_copy( u_host, u );
+    for ( std::size_t p = 1; p < num_local; ++p )
+        for ( int d = 0; d < 3; ++d )
+            EXPECT_NEAR( u_host( p, d ), 0.01 * x_host( p, d ), 1e-8 );
+}
+
 //---------------------------------------------------------------------------//
 // TESTS
 //---------------------------------------------------------------------------//
@@ -101,6 +318,14 @@ TEST( TEST_CATEGORY, test_integrate_reversibility )
     testIntegratorReversibility( 100 );
 }
 
+TEST( TEST_CATEGORY, test_yoshida_coefficients ) { testYoshidaCoefficients(); }
+
+TEST( TEST_CATEGORY, test_stable_timestep ) { testStableTimeStep(); }
+
+TEST( TEST_CATEGORY, test_contact_subcycle ) { testContactSubcycle(); }
+
+TEST( TEST_CATEGORY, test_dynamic_relaxation ) { testDynamicRelaxation(); }
+
 //---------------------------------------------------------------------------//
 
 } // end namespace Test
@@ -9,11 +9,18 @@
  * SPDX-License-Identifier: BSD-3-Clause                                    *
  ****************************************************************************/
 
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <Cabana_Core.hpp>
 #include <Kokkos_Core.hpp>
 
+#include <CabanaPD_Diagnostics.hpp>
 #include <CabanaPD_Particles.hpp>
 
 namespace Test
@@ -62,6 +69,7 @@ void checkParticlePositions( const ParticlesType& particles,
 }
 
 //---------------------------------------------------------------------------//
+template <int VectorLength>
 void testCreateParticles()
 {
     using exec_space = TEST_EXECSPACE;
@@ -72,7 +80,8 @@ void testCreateParticles()
 
     // Frozen or all particles first.
     CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
-                        CabanaPD::TemperatureIndependent>
+                        CabanaPD::TemperatureIndependent, CabanaPD::BaseOutput,
+                        3, VectorLength>
         particles( exec_space(), box_min, box_max, num_cells, 0 );
 
     // Check expected values for each block of particles.
@@ -84,6 +93,7 @@ void testCreateParticles()
                             particles.frozenOffset(), particles.localOffset() );
 }
 
+template <int VectorLength>
 void testCreateFrozenParticles()
 {
     using exec_space = TEST_EXECSPACE;
@@ -100,7 +110,8 @@ void testCreateFrozenParticles()
         return false;
     };
     CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
-                        CabanaPD::TemperatureIndependent>
+                        CabanaPD::TemperatureIndependent, CabanaPD::BaseOutput,
+                        3, VectorLength>
         particles( exec_space(), box_min, box_max, num_cells, 0, init_bottom, 0,
                    true );
 
@@ -130,6 +141,7 @@ void testCreateFrozenParticles()
                             particles.frozenOffset(), particles.localOffset() );
 }
 
+template <int VectorLength>
 void testCreateCustomParticles()
 {
     using exec_space = TEST_EXECSPACE;
@@ -155,7 +167,8 @@ void testCreateCustomParticles()
         } );
 
     CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
-                        CabanaPD::TemperatureIndependent>
+                        CabanaPD::TemperatureIndependent, CabanaPD::BaseOutput,
+                        3, VectorLength>
         particles( exec_space{}, position, volume, box_min, box_max, num_cells,
                    0, 0, true );
 
@@ -184,12 +197,593 @@ void testCreateCustomParticles()
                             particles.frozenOffset(), particles.localOffset() );
 }
 
+template <int VectorLength>
+void testCreateRefinedParticles()
+{
+    using exec_space = TEST_EXECSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+
+    CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
+                        CabanaPD::TemperatureIndependent, CabanaPD::BaseOutput,
+                        3, VectorLength>
+        particles( exec_space(), box_min, box_max, num_cells, 0 );
+    EXPECT_FALSE( particles.variableResolution() );
+
+    // Split the cells in the lower half in x twice along each dimension.
+    std::vector<CabanaPD::RefinementBox> boxes = {
+        { { -1.0, -1.0, -1.0 }, { 0.0, 1.0, 1.0 }, 2 } };
+    CabanaPD::RefinementRegions<TEST_MEMSPACE> refinement( boxes );
+    auto create_all = KOKKOS_LAMBDA( const int, const double[3] )
+    {
+        return true;
+    };
+    particles.createParticles( exec_space(), create_all, refinement );
+    EXPECT_TRUE( particles.variableResolution() );
+    EXPECT_DOUBLE_EQ( particles.referenceVolume(), 0.2 * 0.2 * 0.2 );
+
+    std::size_t num_total = num_cells[0] * num_cells[1] * num_cells[2];
+    std::size_t expected_local = num_total / 2 * 8 + num_total / 2;
+    checkNumParticles( particles, 0, expected_local );
+    checkParticlePositions( particles, box_min, box_max, 0,
+                            particles.localOffset() );
+
+    // The refined particles fill the same total volume.
+    auto vol = particles.sliceVolume();
+    double total_volume = 0.0;
+    Kokkos::parallel_reduce(
+        Kokkos::RangePolicy<exec_space>( 0, particles.localOffset() ),
+        KOKKOS_LAMBDA( const int p, double& sum ) { sum += vol( p ); },
+        total_volume );
+    EXPECT_NEAR( total_volume, 8.0, 1e-10 );
+}
+
+template <int VectorLength>
+void testReorderParticles()
+{
+    using exec_space = TEST_EXECSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+
+    // Frozen in bottom half.
+    auto init_bottom = KOKKOS_LAMBDA( const int, const double x[3] )
+    {
+        if ( x[2] < 0.0 )
+            return true;
+        return false;
+    };
+    CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
+                        CabanaPD::TemperatureIndependent,
+                        CabanaPD::EnergyOutput, 3, VectorLength>
+        particles( exec_space(), box_min, box_max, num_cells, 0, init_bottom, 0,
+                   true );
+    auto init_top = KOKKOS_LAMBDA( const int, const double x[3] )
+    {
+        if ( x[2] > 0.0 )
+            return true;
+        return false;
+    };
+    particles.createParticles( exec_space{}, init_top,
+                               particles.frozenOffset() );
+
+    // Tag each particle with its creation index.
+    auto x = particles.sliceReferencePosition();
+    auto vol = particles.sliceVolume();
+    auto W = particles.sliceStrainEnergy();
+    Kokkos::RangePolicy<exec_space> policy( 0, particles.localOffset() );
+    Kokkos::parallel_for(
+        policy, KOKKOS_LAMBDA( const int p ) {
+            vol( p ) = static_cast<double>( p );
+            W( p ) = 2.0 * p;
+        } );
+    using HostAoSoA = Cabana::AoSoA<Cabana::MemberTypes<double[3], double>,
+                                    Kokkos::HostSpace>;
+    HostAoSoA x_init( "x_init", particles.localOffset() );
+    auto x_init_host = Cabana::slice<0>( x_init );
+    Cabana::deep_copy( x_init_host, x );
+
+    std::size_t expected_local = num_cells[0] * num_cells[1] * num_cells[2] / 2;
+    particles.reorder( exec_space{} );
+    checkNumParticles( particles, expected_local, expected_local );
+
+    // Frozen particles must stay first.
+    box_max[2] = 0.0;
+    checkParticlePositions( particles, box_min, box_max, 0,
+                            particles.frozenOffset() );
+    box_min[2] = 0.0;
+    box_max[2] = 1.0;
+    checkParticlePositions( particles, box_min, box_max,
+                            particles.frozenOffset(), particles.localOffset() );
+
+    // All fields must be permuted consistently with the stored mapping.
+    auto ids = particles.getOriginalIds();
+    auto ids_host =
+        Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace(), ids );
+    HostAoSoA aosoa_host( "host_aosoa", particles.localOffset() );
+    auto x_host = Cabana::slice<0>( aosoa_host );
+    auto vol_host = Cabana::slice<1>( aosoa_host );
+    Cabana::deep_copy( x_host, particles.sliceReferencePosition() );
+    Cabana::deep_copy( vol_host, particles.sliceVolume() );
+    HostAoSoA W_aosoa_host( "host_W", particles.localOffset() );
+    auto W_host = Cabana::slice<1>( W_aosoa_host );
+    Cabana::deep_copy( W_host, particles.sliceStrainEnergy() );
+
+    std::vector<int> found( particles.localOffset(), 0 );
+    for ( std::size_t p = 0; p < particles.localOffset(); ++p )
+    {
+        auto id = ids_host( p );
+        found[id]++;
+        EXPECT_DOUBLE_EQ( vol_host( p ), static_cast<double>( id ) );
+        EXPECT_DOUBLE_EQ( W_host( p ), 2.0 * id );
+        for ( int d = 0; d < 3; ++d )
+            EXPECT_DOUBLE_EQ( x_host( p, d ), x_init_host( id, d ) );
+    }
+    for ( std::size_t p = 0; p < particles.localOffset(); ++p )
+        EXPECT_EQ( found[p], 1 );
+}
+
+template <int VectorLength>
+void testMixedPrecisionParticles()
+{
+    using exec_space = TEST_EXECSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+
+    CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
+                        CabanaPD::TemperatureIndependent,
+                        CabanaPD::EnergyOutput, 3, VectorLength,
+                        CabanaPD::MixedPrecision>
+        particles( exec_space(), box_min, box_max, num_cells, 0 );
+
+    // Evolving fields are single precision, reference data double.
+    using u_type =
+        typename decltype( particles.sliceDisplacement() )::value_type;
+    using f_type = typename decltype( particles.sliceForce() )::value_type;
+    using v_type = typename decltype( particles.sliceVelocity() )::value_type;
+    using W_type =
+        typename decltype( particles.sliceStrainEnergy() )::value_type;
+    using x_type =
+        typename decltype( particles.sliceReferencePosition() )::value_type;
+    using y_type =
+        typename decltype( particles.sliceCurrentPosition() )::value_type;
+    static_assert( std::is_same<u_type, float>::value );
+    static_assert( std::is_same<f_type, float>::value );
+    static_assert( std::is_same<v_type, float>::value );
+    static_assert( std::is_same<W_type, float>::value );
+    static_assert( std::is_same<x_type, double>::value );
+    static_assert( std::is_same<y_type, double>::value );
+
+    std::size_t expected_local = num_cells[0] * num_cells[1] * num_cells[2];
+    checkNumParticles( particles, 0, expected_local );
+    checkParticlePositions( particles, box_min, box_max,
+                            particles.frozenOffset(), particles.localOffset() );
+
+    // Current positions are computed in double from the float displacement.
+    auto u = particles.sliceDisplacement();
+    Kokkos::RangePolicy<exec_space> policy( 0, particles.localOffset() );
+    Kokkos::parallel_for(
+        "set_displacement", policy, KOKKOS_LAMBDA( const int p ) {
+            for ( int d = 0; d < 3; d++ )
+                u( p, d ) = 0.25f;
+        } );
+    auto y = particles.sliceCurrentPosition();
+    auto x = particles.sliceReferencePosition();
+    double max_error = 0.0;
+    Kokkos::parallel_reduce(
+        "check_current", policy,
+        KOKKOS_LAMBDA( const int p, double& error ) {
+            for ( int d = 0; d < 3; d++ )
+            {
+                double e = Kokkos::abs( y( p, d ) - x( p, d ) - 0.25 );
+                if ( e > error )
+                    error = e;
+            }
+        },
+        Kokkos::Max<double>( max_error ) );
+    EXPECT_LE( max_error, 1e-14 );
+}
+
+template <int VectorLength>
+void testRebalanceParticles()
+{
+    using exec_space = TEST_EXECSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 20, 20, 20 };
+    const int halo_width = 2;
+
+    CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
+                        CabanaPD::TemperatureIndependent, CabanaPD::BaseOutput,
+                        3, VectorLength>
+        particles( exec_space(), box_min, box_max, num_cells, halo_width );
+
+    // Particles with negative x are ten times as expensive.
+    auto x = particles.sliceReferencePosition();
+    Kokkos::View<double*, TEST_MEMSPACE> weights( "weights",
+                                                  particles.localOffset() );
+    Kokkos::RangePolicy<exec_space> policy( 0, particles.localOffset() );
+    Kokkos::parallel_for(
+        "set_weights", policy, KOKKOS_LAMBDA( const int p ) {
+            weights( p ) = x( p, 0 ) < 0.0 ? 10.0 : 1.0;
+        } );
+    particles.rebalance( weights );
+
+    const auto& global_grid = particles.local_grid->globalGrid();
+    for ( int d = 0; d < 3; d++ )
+    {
+        const int num_blocks = global_grid.dimNumBlock( d );
+        const auto& bounds = particles.block_bounds[d];
+        ASSERT_EQ( static_cast<int>( bounds.size() ), num_blocks + 1 );
+        EXPECT_DOUBLE_EQ( bounds.front(), box_min[d] );
+        EXPECT_DOUBLE_EQ( bounds.back(), box_max[d] );
+        for ( int b = 0; b < num_blocks; b++ )
+            EXPECT_GE( bounds[b + 1] - bounds[b],
+                       halo_width * particles.dx[d] - 1e-12 );
+
+        // The owned box matches this rank's block.
+        const int block = global_grid.dimBlockId( d );
+        EXPECT_NEAR( particles.local_mesh_lo[d], bounds[block], 1e-12 );
+        EXPECT_NEAR( particles.local_mesh_hi[d], bounds[block + 1], 1e-12 );
+    }
+    // More ranks cover the expensive half.
+    const int num_x_blocks = global_grid.dimNumBlock( 0 );
+    if ( num_x_blocks > 1 )
+        EXPECT_LT( particles.block_bounds[0][num_x_blocks / 2], 0.0 );
+}
+
+template <int VectorLength>
+void testOutputSelection()
+{
+    using exec_space = TEST_EXECSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+
+    CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
+                        CabanaPD::TemperatureIndependent, CabanaPD::BaseOutput,
+                        3, VectorLength>
+        particles( exec_space(), box_min, box_max, num_cells, 0 );
+    const std::size_t num_local = particles.localOffset();
+    auto x = particles.sliceReferencePosition();
+
+    // Every third particle with positive x.
+    std::array<double, 3> low = { 0.0, -1.0, -1.0 };
+    std::array<double, 3> high = { 1.0, 1.0, 1.0 };
+    CabanaPD::ParticleOutput<TEST_MEMSPACE> output;
+    output.setOptions( {}, 3, low, high, true, false );
+    auto num_selected = output.select( x, num_local );
+
+    using HostAoSoA =
+        Cabana::AoSoA<Cabana::MemberTypes<double[3]>, Kokkos::HostSpace>;
+    HostAoSoA aosoa_host( "host_aosoa", num_local );
+    auto x_host = Cabana::slice<0>( aosoa_host );
+    Cabana::deep_copy( x_host, x );
+    std::size_t expected = 0;
+    for ( std::size_t p = 0; p < num_local; p += 3 )
+        if ( x_host( p, 0 ) >= 0.0 )
+            expected++;
+    EXPECT_EQ( num_selected, expected );
+    EXPECT_EQ( output.numSelected(), expected );
+}
+
+template <int VectorLength>
+void testCreate2dParticles()
+{
+    using exec_space = TEST_EXECSPACE;
+
+    std::array<double, 2> box_min = { -1.0, -1.0 };
+    std::array<double, 2> box_max = { 1.0, 1.0 };
+    std::array<int, 2> num_cells = { 10, 20 };
+
+    CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
+                        CabanaPD::TemperatureIndependent, CabanaPD::BaseOutput,
+                        2, VectorLength>
+        particles( exec_space(), box_min, box_max, num_cells, 0 );
+
+    std::size_t expected_local = num_cells[0] * num_cells[1];
+    checkNumParticles( particles, 0, expected_local );
+
+    // Particles are in the box and fill its area (per unit thickness).
+    using HostAoSoA = Cabana::AoSoA<Cabana::MemberTypes<double[2], double>,
+                                    Kokkos::HostSpace>;
+    HostAoSoA aosoa_host( "host_aosoa", particles.referenceOffset() );
+    auto x_host = Cabana::slice<0>( aosoa_host );
+    auto vol_host = Cabana::slice<1>( aosoa_host );
+    Cabana::deep_copy( x_host, particles.sliceReferencePosition() );
+    Cabana::deep_copy( vol_host, particles.sliceVolume() );
+    double total_volume = 0.0;
+    for ( std::size_t p = 0; p < particles.localOffset(); ++p )
+    {
+        for ( int d = 0; d < 2; ++d )
+        {
+            EXPECT_GE( x_host( p, d ), box_min[d] );
+            EXPECT_LE( x_host( p, d ), box_max[d] );
+        }
+        total_volume += vol_host( p );
+    }
+    EXPECT_NEAR( total_volume, 4.0, 1e-10 );
+}
+
+template <int VectorLength>
+void testBinProfile()
+{
+    using exec_space = TEST_EXECSPACE;
+
+    // Odd number of cells such that a line of particles passes the origin.
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 11, 11, 11 };
+
+    CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
+                        CabanaPD::TemperatureIndependent, CabanaPD::BaseOutput,
+                        3, VectorLength>
+        particles( exec_space(), box_min, box_max, num_cells, 0 );
+
+    // Profile of the x position along x, with the line spread over ranks.
+    auto x = particles.sliceReferencePosition();
+    auto value = KOKKOS_LAMBDA( const int pid ) { return x( pid, 0 ); };
+    auto profile =
+        CabanaPD::binProfile( MPI_COMM_WORLD, num_cells[0], 0, particles,
+                              value );
+
+    int mpi_rank;
+    MPI_Comm_rank( MPI_COMM_WORLD, &mpi_rank );
+    if ( mpi_rank > 0 )
+    {
+        EXPECT_TRUE( profile.empty() );
+        return;
+    }
+    EXPECT_EQ( profile.size(), static_cast<std::size_t>( num_cells[0] ) );
+    for ( const auto& bin : profile )
+    {
+        EXPECT_EQ( bin.count, 1 );
+        EXPECT_NEAR( bin.value, bin.center, 1e-12 );
+    }
+}
+
+template <int VectorLength>
+void testGlobalDiagnostics()
+{
+    using exec_space = TEST_EXECSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+
+    CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
+                        CabanaPD::TemperatureIndependent,
+                        CabanaPD::EnergyOutput, 3, VectorLength>
+        particles( exec_space(), box_min, box_max, num_cells, 0 );
+
+    // Uniform energy density and velocity, with half of the volume damaged.
+    auto x = particles.sliceReferencePosition();
+    auto v = particles.sliceVelocity();
+    auto rho = particles.sliceDensity();
+    auto W = particles.sliceStrainEnergy();
+    auto phi = particles.sliceDamage();
+    auto init = KOKKOS_LAMBDA( const int pid )
+    {
+        for ( int d = 0; d < 3; d++ )
+            v( pid, d ) = 0.0;
+        v( pid, 0 ) = 2.0;
+        rho( pid ) = 3.0;
+        W( pid ) = 4.0;
+        phi( pid ) = x( pid, 0 ) < 0.0 ? 0.75 : 0.25;
+    };
+    Kokkos::RangePolicy<exec_space> policy( 0, particles.localOffset() );
+    Kokkos::parallel_for( "init_diagnostics", policy, init );
+
+    CabanaPD::GlobalDiagnostics<TEST_MEMSPACE> diagnostics( "", 0.5 );
+    diagnostics.start( exec_space{}, particles, 10, 1.0 );
+
+    // Values are only available once the reduction completes.
+    EXPECT_TRUE( std::isnan( diagnostics.strainEnergy() ) );
+    EXPECT_LT( diagnostics.step(), 0 );
+    diagnostics.finish();
+    EXPECT_TRUE( diagnostics.test() );
+
+    // Valid on all ranks.
+    const double volume = 8.0;
+    EXPECT_EQ( diagnostics.step(), 10 );
+    EXPECT_DOUBLE_EQ( diagnostics.stepTime(), 1.0 );
+    EXPECT_NEAR( diagnostics.strainEnergy(), 4.0 * volume, 1e-10 );
+    EXPECT_NEAR( diagnostics.kineticEnergy(), 0.5 * 3.0 * 4.0 * volume,
+                 1e-10 );
+    EXPECT_NEAR( diagnostics.damagedVolume(), 0.5 * volume, 1e-10 );
+    EXPECT_DOUBLE_EQ( diagnostics.maxDamage(), 0.75 );
+}
+
+template <int VectorLength>
+void testParticleMemory()
+{
+    using exec_space = TEST_EXECSPACE;
+
+    // AoSoA storage is counted in whole SoA blocks.
+    using aosoa_type =
+        Cabana::AoSoA<Cabana::MemberTypes<double[3]>, TEST_MEMSPACE,
+                      VectorLength>;
+    aosoa_type aosoa( "memory", 2 * VectorLength + 1 );
+    EXPECT_DOUBLE_EQ( CabanaPD::aosoaBytes( aosoa ),
+                      3.0 * sizeof( typename aosoa_type::soa_type ) );
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+    CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::LPS,
+                        CabanaPD::TemperatureIndependent,
+                        CabanaPD::EnergyOutput, 3, VectorLength>
+        particles( exec_space(), box_min, box_max, num_cells, 0 );
+
+    CabanaPD::MemoryRegistry registry;
+    particles.memory( registry );
+    // Base entries plus LPS and output.
+    EXPECT_EQ( registry.size(), 9u );
+    // At least position, displacement, current position, force, volume,
+    // dilatation, and weighted volume for every particle.
+    EXPECT_GE( registry.total(),
+               static_cast<double>( particles.numLocal() ) *
+                   ( 13 * sizeof( double ) + 2 * sizeof( double ) ) );
+}
+
+template <int VectorLength>
+void testCreateGeometryParticles()
+{
+    using exec_space = TEST_EXECSPACE;
+
+    std::array<double, 3> box_min = { -1.0, -1.0, -1.0 };
+    std::array<double, 3> box_max = { 1.0, 1.0, 1.0 };
+    std::array<int, 3> num_cells = { 10, 10, 10 };
+
+    // Domain only, with particles created from the files below.
+    auto none = KOKKOS_LAMBDA( const int, const double[3] ) { return false; };
+    CabanaPD::Particles<TEST_MEMSPACE, CabanaPD::PMB,
+                        CabanaPD::TemperatureIndependent, CabanaPD::BaseOutput,
+                        3, VectorLength>
+        particles( exec_space(), box_min, box_max, num_cells, 0, none );
+
+    int mpi_rank;
+    MPI_Comm_rank( MPI_COMM_WORLD, &mpi_rank );
+    const std::string geometry_file = "test_geometry.bin";
+    const std::string voxel_file = "test_voxels.bin";
+    if ( mpi_rank == 0 )
+    {
+        // Cell centers, one particle on the upper corner, and one outside.
+        std::vector<CabanaPD::GeometryRecord> records;
+        for ( int i = 0; i < 10; i++ )
+            for ( int j = 0; j < 10; j++ )
+                for ( int k = 0; k < 10; k++ )
+                    records.push_back( { { -0.9 + 0.2 * i, -0.9 + 0.2 * j,
+                                           -0.9 + 0.2 * k },
+                                         0.008,
+                                         ( i + j + k ) % 2,
+                                         0 } );
+        records.push_back( { { 1.0, 1.0, 1.0 }, 1.0, 0, 1 } );
+        records.push_back( { { 2.0, 0.0, 0.0 }, 1.0, 0, 1 } );
+        CabanaPD::writeGeometry( geometry_file, records, { 2, 2, 2 } );
+
+        // Every other voxel empty, with alternating types.
+        std::vector<std::uint8_t> voxels( 4 * 4 * 4 );
+        for ( std::size_t n = 0; n < voxels.size(); n++ )
+            voxels[n] = ( n % 2 ) ? 0 : 1 + ( n / 2 ) % 2;
+        CabanaPD::writeVoxels( voxel_file, { 4, 4, 4 }, box_min,
+                               { 0.5, 0.5, 0.5 }, voxels );
+    }
+    MPI_Barrier( MPI_COMM_WORLD );
+
+    // Small batches to stream each chunk in parts.
+    CabanaPD::GeometryReader reader( geometry_file, 64 );
+    EXPECT_EQ( reader.numParticles(), 1002u );
+    EXPECT_EQ( reader.numChunks(), 8u );
+    particles.createParticles( exec_space(), reader );
+
+    auto checkGlobal =
+        [&]( const std::size_t expected_num, const double expected_volume )
+    {
+        using HostAoSoA = Cabana::AoSoA<Cabana::MemberTypes<double>,
+                                        Kokkos::HostSpace>;
+        HostAoSoA aosoa_host( "host_aosoa", particles.referenceOffset() );
+        auto vol_host = Cabana::slice<0>( aosoa_host );
+        Cabana::deep_copy( vol_host, particles.sliceVolume() );
+        double volume = 0.0;
+        for ( std::size_t p = 0; p < particles.localOffset(); ++p )
+            volume += vol_host( p );
+        unsigned long long num = particles.numLocal();
+        MPI_Allreduce( MPI_IN_PLACE, &num, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+                       MPI_COMM_WORLD );
+        MPI_Allreduce( MPI_IN_PLACE, &volume, 1, MPI_DOUBLE, MPI_SUM,
+                       MPI_COMM_WORLD );
+        EXPECT_EQ( num, expected_num );
+        EXPECT_NEAR( volume, expected_volume, 1e-10 );
+        checkParticlePositions( particles, box_min, box_max, 0,
+                                particles.localOffset() );
+    };
+    checkGlobal( 1001, 9.0 );
+
+    CabanaPD::VoxelReader voxel_reader( voxel_file );
+    particles.createParticles( exec_space(), voxel_reader );
+    checkGlobal( 32, 4.0 );
+}
+
 //---------------------------------------------------------------------------//
 // TESTS
 //---------------------------------------------------------------------------//
-TEST( TEST_CATEGORY, test_create_local ) { testCreateParticles(); }
-TEST( TEST_CATEGORY, test_create_frozen ) { testCreateFrozenParticles(); }
-TEST( TEST_CATEGORY, test_create_custom ) { testCreateCustomParticles(); }
+TEST( TEST_CATEGORY, test_create_local )
+{
+    testCreateParticles<1>();
+    testCreateParticles<8>();
+    testCreateParticles<32>();
+}
+TEST( TEST_CATEGORY, test_create_frozen )
+{
+    testCreateFrozenParticles<1>();
+    testCreateFrozenParticles<8>();
+    testCreateFrozenParticles<32>();
+}
+TEST( TEST_CATEGORY, test_create_custom )
+{
+    testCreateCustomParticles<1>();
+    testCreateCustomParticles<8>();
+    testCreateCustomParticles<32>();
+}
+TEST( TEST_CATEGORY, test_create_refined )
+{
+    testCreateRefinedParticles<1>();
+    testCreateRefinedParticles<32>();
+}
+TEST( TEST_CATEGORY, test_create_2d )
+{
+    testCreate2dParticles<1>();
+    testCreate2dParticles<32>();
+}
+TEST( TEST_CATEGORY, test_particle_memory )
+{
+    testParticleMemory<1>();
+    testParticleMemory<32>();
+}
+TEST( TEST_CATEGORY, test_create_geometry )
+{
+    testCreateGeometryParticles<1>();
+    testCreateGeometryParticles<32>();
+}
+TEST( TEST_CATEGORY, test_bin_profile )
+{
+    testBinProfile<1>();
+    testBinProfile<32>();
+}
+TEST( TEST_CATEGORY, test_global_diagnostics )
+{
+    testGlobalDiagnostics<1>();
+    testGlobalDiagnostics<32>();
+}
+TEST( TEST_CATEGORY, test_reorder )
+{
+    testReorderParticles<1>();
+    testReorderParticles<8>();
+    testReorderParticles<32>();
+}
+TEST( TEST_CATEGORY, test_mixed_precision )
+{
+    testMixedPrecisionParticles<1>();
+    testMixedPrecisionParticles<32>();
+}
+TEST( TEST_CATEGORY, test_rebalance )
+{
+    testRebalanceParticles<1>();
+    testRebalanceParticles<32>();
+}
+TEST( TEST_CATEGORY, test_output_selection )
+{
+    testOutputSelection<1>();
+    testOutputSelection<32>();
+}
 
 //---------------------------------------------------------------------------//
 
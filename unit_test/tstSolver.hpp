@@ -0,0 +1,321 @@
+/****************************************************************************
+ * Copyright (c) 2022 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of CabanaPD. CabanaPD is distributed under a           *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <CabanaPD.hpp>
+
+#include <Kokkos_Core.hpp>
+#include <gtest/gtest.h>
+
+namespace Test
+{
+// Last reaction force written to a monitor file (the final three columns).
+std::array<double, 3> readReaction( const std::string filename )
+{
+    std::ifstream in( filename );
+    std::string line;
+    std::string last;
+    while ( std::getline( in, line ) )
+        if ( !line.empty() && line[0] != '#' )
+            last = line;
+    std::istringstream tokens( last );
+    std::vector<std::string> values;
+    for ( std::string value; tokens >> value; )
+        values.push_back( value );
+    const std::size_t n = values.size();
+    if ( n < 3 )
+    {
+        ADD_FAILURE() << "No monitor values in " << filename;
+        return { 0.0, 0.0, 0.0 };
+    }
+    return { std::stod( values[n - 3] ), std::stod( values[n - 2] ),
+             std::stod( values[n - 1] ) };
+}
+
+// Final displacements and velocities of an elastic block clamped at the low z
+// face and pulled at the high z face, with the reaction force monitored on the
+// clamp.
+template <class PrecisionType = CabanaPD::DoublePrecision>
+std::vector<double> runClampedBlock( const std::string filename,
+                                     std::array<double, 3>& reaction )
+{
+    using exec_space = TEST_EXECSPACE;
+    using memory_space = TEST_MEMSPACE;
+
+    CabanaPD::Inputs inputs( filename );
+    double rho0 = inputs["density"];
+    double K = inputs["bulk_modulus"];
+    double delta = inputs["horizon"];
+    delta += 1e-10;
+    std::array<double, 3> low_corner = inputs["low_corner"];
+    std::array<double, 3> high_corner = inputs["high_corner"];
+    std::array<int, 3> num_cells = inputs["num_cells"];
+    std::string monitor_file = inputs["monitor_file"];
+    std::remove( monitor_file.c_str() );
+
+    using model_type = CabanaPD::ForceModel<CabanaPD::PMB, CabanaPD::Elastic,
+                                            CabanaPD::NoFracture>;
+    model_type force_model( delta, K );
+    using particles_type = CabanaPD::Particles<
+        memory_space, CabanaPD::PMB, CabanaPD::TemperatureIndependent,
+        CabanaPD::EnergyOutput, 3,
+        CabanaPD::DefaultVectorLength<memory_space>::value, PrecisionType>;
+    int halo_width =
+        std::floor( delta / ( ( high_corner[0] - low_corner[0] ) /
+                              num_cells[0] ) ) +
+        1;
+    auto particles = std::make_shared<particles_type>(
+        exec_space{}, low_corner, high_corner, num_cells, halo_width );
+
+    auto x = particles->sliceReferencePosition();
+    auto rho = particles->sliceDensity();
+    auto u = particles->sliceDisplacement();
+    auto v = particles->sliceVelocity();
+    auto init_functor = KOKKOS_LAMBDA( const int pid )
+    {
+        rho( pid ) = rho0;
+        for ( int d = 0; d < 3; d++ )
+        {
+            u( pid, d ) = 0.0;
+            v( pid, d ) = 0.01 * x( pid, d );
+        }
+    };
+    particles->updateParticles( exec_space{}, init_functor );
+
+    auto cabana_pd =
+        CabanaPD::createSolver<memory_space>( inputs, particles, force_model );
+
+    // Create the boundary conditions last to include any ghost particles.
+    double dz = particles->dx[2];
+    CabanaPD::RegionBoundary<CabanaPD::RectangularPrism> clamp(
+        low_corner[0], high_corner[0], low_corner[1], high_corner[1],
+        low_corner[2] - dz, low_corner[2] + dz );
+    CabanaPD::RegionBoundary<CabanaPD::RectangularPrism> pull(
+        low_corner[0], high_corner[0], low_corner[1], high_corner[1],
+        high_corner[2] - dz, high_corner[2] + dz );
+    u = particles->sliceDisplacement();
+    v = particles->sliceVelocity();
+    auto clamp_op = KOKKOS_LAMBDA( const int pid, const double )
+    {
+        for ( int d = 0; d < 3; d++ )
+        {
+            u( pid, d ) = 0.0;
+            v( pid, d ) = 0.0;
+        }
+    };
+    auto clamp_bc = CabanaPD::createBoundaryCondition(
+        clamp_op, exec_space{}, *particles, clamp, false );
+    auto pull_bc = CabanaPD::createBoundaryCondition(
+        CabanaPD::ForceUpdateBCTag{}, 1e-3, exec_space{}, *particles, pull );
+    auto bc = CabanaPD::createBoundaryConditionSet( exec_space{}, *particles,
+                                                    clamp_bc, pull_bc );
+    cabana_pd->addReactionRegion( clamp );
+
+    cabana_pd->init( bc );
+    cabana_pd->run( bc );
+
+    // Converted to double for either precision.
+    Kokkos::View<double* [6], memory_space> state_view(
+        "state", particles->localOffset() );
+    u = particles->sliceDisplacement();
+    v = particles->sliceVelocity();
+    Kokkos::RangePolicy<exec_space> policy( 0, particles->localOffset() );
+    Kokkos::parallel_for(
+        "copy_state", policy, KOKKOS_LAMBDA( const int p ) {
+            for ( int d = 0; d < 3; d++ )
+            {
+                state_view( p, 2 * d ) = u( p, d );
+                state_view( p, 2 * d + 1 ) = v( p, d );
+            }
+        } );
+    auto state_host =
+        Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace{}, state_view );
+    std::vector<double> state;
+    for ( std::size_t p = 0; p < state_host.extent( 0 ); p++ )
+        for ( int d = 0; d < 6; d++ )
+            state.push_back( state_host( p, d ) );
+
+    reaction = readReaction( monitor_file );
+    return state;
+}
+
+// Fusing the force reset and boundary conditions into the integrator must
+// follow the same trajectory, including the monitored reaction forces on steps
+// without output.
+void testFusedIntegration()
+{
+    std::array<double, 3> reaction_ref;
+    auto reference = runClampedBlock( "elastic_block.json", reaction_ref );
+    std::array<double, 3> reaction;
+    auto fused = runClampedBlock( "elastic_block_fused.json", reaction );
+
+    ASSERT_EQ( fused.size(), reference.size() );
+    double max_state = 0.0;
+    for ( std::size_t i = 0; i < reference.size(); i++ )
+        max_state = std::max( max_state, std::abs( reference[i] ) );
+    EXPECT_GT( max_state, 0.0 );
+    for ( std::size_t i = 0; i < reference.size(); i++ )
+        EXPECT_NEAR( fused[i], reference[i], 1e-10 * max_state );
+
+    // The monitor output is written with six significant digits.
+    double max_reaction = 0.0;
+    for ( int d = 0; d < 3; d++ )
+        max_reaction = std::max( max_reaction, std::abs( reaction_ref[d] ) );
+    EXPECT_GT( max_reaction, 0.0 );
+    for ( int d = 0; d < 3; d++ )
+        EXPECT_NEAR( reaction[d], reaction_ref[d], 1e-5 * max_reaction );
+}
+
+// Single precision displacements, velocities, and forces (with double
+// reference positions) must follow the double precision trajectory to single
+// precision through the full solver.
+void testMixedPrecision()
+{
+    std::array<double, 3> reaction_ref;
+    auto reference = runClampedBlock( "elastic_block.json", reaction_ref );
+    std::array<double, 3> reaction;
+    auto mixed = runClampedBlock<CabanaPD::MixedPrecision>(
+        "elastic_block.json", reaction );
+
+    ASSERT_EQ( mixed.size(), reference.size() );
+    double max_state = 0.0;
+    for ( std::size_t i = 0; i < reference.size(); i++ )
+        max_state = std::max( max_state, std::abs( reference[i] ) );
+    EXPECT_GT( max_state, 0.0 );
+    for ( std::size_t i = 0; i < reference.size(); i++ )
+        EXPECT_NEAR( mixed[i], reference[i], 1e-4 * max_state );
+
+    double max_reaction = 0.0;
+    for ( int d = 0; d < 3; d++ )
+        max_reaction = std::max( max_reaction, std::abs( reaction_ref[d] ) );
+    for ( int d = 0; d < 3; d++ )
+        EXPECT_NEAR( reaction[d], reaction_ref[d], 1e-4 * max_reaction );
+}
+
+// Final temperatures and displacements of a free block with thermal expansion,
+// heated from an initially non-uniform temperature.
+std::vector<double> runHeatedBlock( const std::string filename )
+{
+    using exec_space = TEST_EXECSPACE;
+    using memory_space = TEST_MEMSPACE;
+
+    CabanaPD::Inputs inputs( filename );
+    double rho0 = inputs["density"];
+    double K = inputs["bulk_modulus"];
+    double delta = inputs["horizon"];
+    delta += 1e-10;
+    double alpha = inputs["thermal_expansion_coeff"];
+    double kappa = inputs["thermal_conductivity"];
+    double cp = inputs["specific_heat_capacity"];
+    double temp0 = inputs["reference_temperature"];
+    std::array<double, 3> low_corner = inputs["low_corner"];
+    std::array<double, 3> high_corner = inputs["high_corner"];
+    std::array<int, 3> num_cells = inputs["num_cells"];
+
+    using particles_type =
+        CabanaPD::Particles<memory_space, CabanaPD::PMB,
+                            CabanaPD::DynamicTemperature>;
+    int halo_width =
+        std::floor( delta / ( ( high_corner[0] - low_corner[0] ) /
+                              num_cells[0] ) ) +
+        1;
+    auto particles = std::make_shared<particles_type>(
+        exec_space{}, low_corner, high_corner, num_cells, halo_width );
+
+    auto x = particles->sliceReferencePosition();
+    auto rho = particles->sliceDensity();
+    auto temp = particles->sliceTemperature();
+    auto init_functor = KOKKOS_LAMBDA( const int pid )
+    {
+        rho( pid ) = rho0;
+        temp( pid ) = temp0 + 10.0 * x( pid, 0 ) * x( pid, 0 ) +
+                      5.0 * x( pid, 1 ) * x( pid, 2 );
+    };
+    particles->updateParticles( exec_space{}, init_functor );
+
+    auto force_model =
+        CabanaPD::createForceModel( CabanaPD::PMB{}, CabanaPD::NoFracture{},
+                                    *particles, delta, K, kappa, cp, alpha,
+                                    temp0 );
+    auto cabana_pd =
+        CabanaPD::createSolver<memory_space>( inputs, particles, force_model );
+    cabana_pd->init();
+    cabana_pd->run();
+
+    Kokkos::View<double* [4], memory_space> state_view(
+        "state", particles->localOffset() );
+    temp = particles->sliceTemperature();
+    auto u = particles->sliceDisplacement();
+    Kokkos::RangePolicy<exec_space> policy( 0, particles->localOffset() );
+    Kokkos::parallel_for(
+        "copy_state", policy, KOKKOS_LAMBDA( const int p ) {
+            state_view( p, 0 ) = temp( p );
+            for ( int d = 0; d < 3; d++ )
+                state_view( p, d + 1 ) = u( p, d );
+        } );
+    auto state_host =
+        Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace{}, state_view );
+    std::vector<double> state;
+    for ( std::size_t p = 0; p < state_host.extent( 0 ); p++ )
+        for ( int d = 0; d < 4; d++ )
+            state.push_back( state_host( p, d ) );
+    return state;
+}
+
+// Heat transfer on a separate execution space instance must follow the same
+// trajectory as heat transfer on the default instance.
+void testConcurrentHeatTransfer( const std::string sequential_file,
+                                 const std::string concurrent_file )
+{
+    auto reference = runHeatedBlock( sequential_file );
+    auto concurrent = runHeatedBlock( concurrent_file );
+
+    // Temperatures and displacements are compared at their own scales.
+    ASSERT_EQ( concurrent.size(), reference.size() );
+    double max_temp = 0.0;
+    double max_u = 0.0;
+    for ( std::size_t i = 0; i < reference.size(); i++ )
+    {
+        double& max_value = i % 4 == 0 ? max_temp : max_u;
+        max_value = std::max( max_value, std::abs( reference[i] ) );
+    }
+    EXPECT_GT( max_temp, 0.0 );
+    EXPECT_GT( max_u, 0.0 );
+    for ( std::size_t i = 0; i < reference.size(); i++ )
+    {
+        const double max_value = i % 4 == 0 ? max_temp : max_u;
+        EXPECT_NEAR( concurrent[i], reference[i], 1e-12 * max_value );
+    }
+}
+
+TEST( TEST_CATEGORY, test_fused_integration ) { testFusedIntegration(); }
+TEST( TEST_CATEGORY, test_mixed_precision ) { testMixedPrecision(); }
+TEST( TEST_CATEGORY, test_concurrent_heat_transfer_euler )
+{
+    testConcurrentHeatTransfer( "heated_block.json",
+                                "heated_block_concurrent.json" );
+}
+TEST( TEST_CATEGORY, test_concurrent_heat_transfer_rkl2 )
+{
+    testConcurrentHeatTransfer( "heated_block_rkl2.json",
+                                "heated_block_rkl2_concurrent.json" );
+}
+
+} // end namespace Test